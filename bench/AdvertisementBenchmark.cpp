@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cctype>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/FileStream.h>
+#include <Poco/NumberParser.h>
+#include <Poco/Timestamp.h>
+#include <Poco/JSON/PrintHandler.h>
+
+#include "AdvertisementBenchmark.h"
+#include "bluetooth/LEAdvertisement.h"
+#include "bluetooth/LEAdvertisementFilter.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+static const Timespan ADVERTISING_PERIOD = 100 * Timespan::MILLISECONDS;
+
+AdvertisementBenchmark::AdvertisementBenchmark():
+	m_records(100000),
+	m_devices(100),
+	m_changeEvery(10),
+	m_reportInterval(30 * Timespan::SECONDS),
+	m_reports(0),
+	m_accepted(0),
+	m_bytes(0)
+{
+}
+
+void AdvertisementBenchmark::setRecords(UInt64 records)
+{
+	m_records = records;
+}
+
+void AdvertisementBenchmark::setDevices(unsigned int devices)
+{
+	if (devices == 0)
+		throw InvalidArgumentException("count of devices must be positive");
+
+	m_devices = devices;
+}
+
+void AdvertisementBenchmark::setChangeEvery(unsigned int count)
+{
+	if (count == 0)
+		throw InvalidArgumentException("change period must be positive");
+
+	m_changeEvery = count;
+}
+
+void AdvertisementBenchmark::setReportInterval(const Timespan &interval)
+{
+	m_reportInterval = interval;
+}
+
+void AdvertisementBenchmark::setCapture(const string &path)
+{
+	m_capture = path;
+}
+
+void AdvertisementBenchmark::loadCapture()
+{
+	FileInputStream input(m_capture);
+	string line;
+	bool skipping = false;
+
+	while (getline(input, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		size_t offset = 0;
+
+		if (line[0] == '<') {
+			skipping = true;
+			continue;
+		}
+		else if (line[0] == '>') {
+			skipping = false;
+			m_events.emplace_back();
+			offset = 1;
+		}
+		else if (isspace(line[0])) {
+			if (skipping || m_events.empty())
+				continue;
+		}
+		else {
+			skipping = false;
+			m_events.emplace_back();
+		}
+
+		while (offset < line.size()) {
+			if (isspace(line[offset])) {
+				++offset;
+				continue;
+			}
+
+			const string byte = line.substr(offset, 2);
+			m_events.back().push_back(NumberParser::parseHex(byte));
+			offset += 2;
+		}
+	}
+
+	m_events.erase(remove_if(m_events.begin(), m_events.end(),
+		[](const vector<UInt8> &event) {
+			return event.empty();
+		}),
+		m_events.end());
+
+	if (m_events.empty())
+		throw DataFormatException("no HCI packets in " + m_capture);
+}
+
+/**
+ * Generate two rounds of advertisements of all devices. Each round
+ * consists of m_changeEvery advertisements with the same data of each
+ * device, the second round carries different data. Replaying them in
+ * a loop changes data of each device every m_changeEvery advertisements.
+ */
+void AdvertisementBenchmark::generate()
+{
+	for (unsigned int version = 0; version < 2; ++version) {
+		for (unsigned int repeat = 0; repeat < m_changeEvery; ++repeat) {
+			for (unsigned int device = 0; device < m_devices; ++device) {
+				const string name = "BeeWi " + to_string(device);
+				vector<UInt8> data = {0x02, 0x01, 0x06};
+
+				data.push_back(name.size() + 1);
+				data.push_back(0x09);
+				data.insert(data.end(), name.begin(), name.end());
+
+				// 11 B of manufacturer data like BeeWi SmartClim
+				data.insert(data.end(), {
+					14, 0xff, 0x0d, 0x00,
+					0x05, 0x00, static_cast<UInt8>(200 + version), 0x00,
+					0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x50,
+				});
+
+				vector<UInt8> event = {
+					0x04, 0x3e, 0, 0x02, 1,
+					0x00, 0x01,
+					static_cast<UInt8>(device), static_cast<UInt8>(device >> 8),
+					static_cast<UInt8>(device >> 16), 0x00, 0x11, 0xc0,
+					static_cast<UInt8>(data.size()),
+				};
+
+				event.insert(event.end(), data.begin(), data.end());
+				event.push_back(static_cast<UInt8>(-60 - (device % 30)));
+				event[2] = event.size() - 3;
+
+				m_events.emplace_back(event);
+			}
+		}
+	}
+}
+
+void AdvertisementBenchmark::run()
+{
+	m_events.clear();
+
+	if (m_capture.empty())
+		generate();
+	else
+		loadCapture();
+
+	LEAdvertisementFilter filter(m_reportInterval);
+	const Timespan::TimeDiff spacing = max<Timespan::TimeDiff>(
+		1, ADVERTISING_PERIOD.totalMicroseconds() / m_devices);
+
+	Timestamp now;
+
+	m_reports = 0;
+	m_accepted = 0;
+	m_bytes = 0;
+
+	const Clock started;
+
+	for (UInt64 i = 0; i < m_records; ++i) {
+		const vector<UInt8> &event = m_events[i % m_events.size()];
+		now += spacing;
+
+		m_reports += LEAdvertisementParser::parse(event.data(), event.size(),
+			[&](const LEAdvertisement &advertisement) {
+				if (!filter.accept(advertisement, now))
+					return;
+
+				++m_accepted;
+
+				// copies made for consumers of the advertisement
+				const string &name = advertisement.name();
+				const vector<unsigned char> &data = advertisement.manufacturerData();
+				m_bytes += name.size() + data.size();
+			});
+	}
+
+	m_time = started.elapsed();
+}
+
+void AdvertisementBenchmark::report(ostream &out) const
+{
+	PrintHandler json(out);
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("advertisement"));
+	json.key("source");
+	json.value(m_capture.empty() ? string("generated") : m_capture);
+	json.key("events");
+	json.value(m_records);
+	json.key("distinct_events");
+	json.value(static_cast<UInt64>(m_events.size()));
+	json.key("devices");
+	json.value(m_devices);
+	json.key("change_every");
+	json.value(m_changeEvery);
+	json.key("report_interval_ms");
+	json.value(m_reportInterval.totalMilliseconds());
+	json.key("reports");
+	json.value(m_reports);
+	json.key("accepted");
+	json.value(m_accepted);
+	json.key("copied_bytes");
+	json.value(m_bytes);
+	json.key("time_ms");
+	json.value(m_time.totalMilliseconds());
+	json.key("events_per_sec");
+	json.value(m_time.totalMicroseconds() == 0 ? 0.0
+		: m_records / (m_time.totalMicroseconds() / 1000000.0));
+
+	json.endObject();
+	out << endl;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Throughput of decoding LE advertising reports and suppressing
+ * the repeated ones. The HCI events are either loaded from a capture
+ * or generated for the given number of devices. The events are replayed
+ * in a loop until the requested number of events is decoded. Each device
+ * is assumed to advertise every 100 ms, only every N-th advertisement of
+ * a device carries changed data.
+ *
+ * The capture is a text file with one HCI packet per line in hex as
+ * printed by "hcidump -R". Lines starting by '<' (commands) are skipped,
+ * lines starting by a whitespace continue the previous packet.
+ */
+class AdvertisementBenchmark {
+public:
+	AdvertisementBenchmark();
+
+	void setRecords(Poco::UInt64 records);
+	void setDevices(unsigned int devices);
+	void setChangeEvery(unsigned int count);
+	void setReportInterval(const Poco::Timespan &interval);
+	void setCapture(const std::string &path);
+
+	void run();
+	void report(std::ostream &out) const;
+
+private:
+	void loadCapture();
+	void generate();
+
+private:
+	Poco::UInt64 m_records;
+	unsigned int m_devices;
+	unsigned int m_changeEvery;
+	Poco::Timespan m_reportInterval;
+	std::string m_capture;
+
+	std::vector<std::vector<Poco::UInt8>> m_events;
+	Poco::UInt64 m_reports;
+	Poco::UInt64 m_accepted;
+	Poco::UInt64 m_bytes;
+	Poco::Timespan m_time;
+};
+
+}
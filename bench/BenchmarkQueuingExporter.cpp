@@ -0,0 +1,60 @@
+#include <vector>
+
+#include <Poco/Exception.h>
+
+#include "BenchmarkQueuingExporter.h"
+#include "model/SensorData.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+BenchmarkQueuingExporter::BenchmarkQueuingExporter(
+		SharedPtr<Exporter> target,
+		size_t batchSize,
+		const Timespan &acquireTimeout):
+	m_target(target),
+	m_batchSize(batchSize),
+	m_acquireTimeout(acquireTimeout)
+{
+	if (batchSize == 0)
+		throw InvalidArgumentException("batch size must be positive");
+}
+
+void BenchmarkQueuingExporter::run()
+{
+	vector<SensorData> batch;
+	batch.reserve(m_batchSize);
+
+	while (!m_stop) {
+		batch.clear();
+
+		try {
+			acquire(batch, m_batchSize, m_acquireTimeout);
+		}
+		BEEEON_CATCH_CHAIN_ACTION(logger(),
+			continue);
+
+		if (batch.empty())
+			continue;
+
+		bool success = true;
+
+		for (const auto &data : batch) {
+			if (!m_target->ship(data)) {
+				success = false;
+				break;
+			}
+		}
+
+		if (success)
+			ack();
+		else
+			reset();
+	}
+}
+
+void BenchmarkQueuingExporter::stop()
+{
+	m_stop = 1;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Runnable.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+
+#include "core/QueuingExporter.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief QueuingExporter with a consumer thread that acquires batches
+ * of data and passes them to the target exporter. It models exporters
+ * like GWServerConnector that build on top of the QueuingExporter.
+ * A batch is acknowledged only when the target accepted all its data,
+ * otherwise the batch is reset and acquired again later.
+ */
+class BenchmarkQueuingExporter : public QueuingExporter, public Poco::Runnable {
+public:
+	typedef Poco::SharedPtr<BenchmarkQueuingExporter> Ptr;
+
+	BenchmarkQueuingExporter(
+		Poco::SharedPtr<Exporter> target,
+		size_t batchSize,
+		const Poco::Timespan &acquireTimeout = 100 * Poco::Timespan::MILLISECONDS);
+
+	void run() override;
+	void stop();
+
+private:
+	Poco::SharedPtr<Exporter> m_target;
+	size_t m_batchSize;
+	Poco::Timespan m_acquireTimeout;
+	Poco::AtomicCounter m_stop;
+};
+
+}
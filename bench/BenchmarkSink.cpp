@@ -0,0 +1,46 @@
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+
+#include "BenchmarkSink.h"
+#include "model/SensorData.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+BenchmarkSink::BenchmarkSink(
+		SensorDataFormatter::Ptr formatter,
+		LatencySamples &samples):
+	m_formatter(formatter),
+	m_samples(samples),
+	m_bytes(0)
+{
+}
+
+bool BenchmarkSink::ship(const SensorData &data)
+{
+	const string &output = m_formatter->format(data);
+	delivered(data, output.size() + 1);
+	return true;
+}
+
+void BenchmarkSink::delivered(const SensorData &data, size_t bytes)
+{
+	const Timestamp now;
+	m_samples.add(Timespan(now - data.timestamp().value()));
+
+	FastMutex::ScopedLock guard(m_lock);
+	m_bytes += bytes;
+	++m_count;
+}
+
+size_t BenchmarkSink::deliveredCount() const
+{
+	return m_count.value();
+}
+
+UInt64 BenchmarkSink::deliveredBytes() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_bytes;
+}
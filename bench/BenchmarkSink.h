@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Types.h>
+
+#include "LatencySamples.h"
+#include "core/Exporter.h"
+#include "util/SensorDataFormatter.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Terminal exporter of the benchmarked pipeline. Every shipped
+ * SensorData is serialized by the configured formatter (to account
+ * the serialization cost and output size) and its latency is measured
+ * as the difference between now and SensorData::timestamp().
+ */
+class BenchmarkSink : public Exporter {
+public:
+	typedef Poco::SharedPtr<BenchmarkSink> Ptr;
+
+	BenchmarkSink(
+		SensorDataFormatter::Ptr formatter,
+		LatencySamples &samples);
+
+	bool ship(const SensorData &data) override;
+
+	/**
+	 * Account data delivered to the sink by other means than
+	 * by calling ship() (e.g. read from a pipe).
+	 */
+	void delivered(const SensorData &data, size_t bytes);
+
+	size_t deliveredCount() const;
+	Poco::UInt64 deliveredBytes() const;
+
+private:
+	SensorDataFormatter::Ptr m_formatter;
+	LatencySamples &m_samples;
+	Poco::AtomicCounter m_count;
+	mutable Poco::FastMutex m_lock;
+	Poco::UInt64 m_bytes;
+};
+
+}
@@ -0,0 +1,238 @@
+#include <Poco/Exception.h>
+#include <Poco/Random.h>
+#include <Poco/Thread.h>
+#include <Poco/JSON/PrintHandler.h>
+
+#include "ConnectorBenchmark.h"
+#include "GWServerStandIn.h"
+#include "ProcessStats.h"
+#include "core/GatewayInfo.h"
+#include "model/DevicePrefix.h"
+#include "model/SensorData.h"
+#include "server/GWServerConnector.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+static const string BENCH_GATEWAY_ID = "1254321374233360";
+static const Timespan REGISTER_TIMEOUT = 10 * Timespan::SECONDS;
+static const Timespan REJECTED_SLEEP = 1 * Timespan::MILLISECONDS;
+static const unsigned int BENCH_DEVICES = 100;
+
+ConnectorBenchmark::ConnectorBenchmark():
+	m_records(10000),
+	m_rate(0),
+	m_resendTimeout(1 * Timespan::SECONDS),
+	m_retryConnectTimeout(100 * Timespan::MILLISECONDS),
+	m_confirmDelay(0),
+	m_confirmJitter(0),
+	m_lossRate(0),
+	m_disconnectEvery(0),
+	m_drainTimeout(30 * Timespan::SECONDS),
+	m_confirmed(0),
+	m_received(0),
+	m_distinct(0),
+	m_rejected(0),
+	m_confirmsLost(0),
+	m_registrations(0),
+	m_disconnects(0),
+	m_residentKB(-1)
+{
+}
+
+void ConnectorBenchmark::setRecords(size_t records)
+{
+	if (records == 0)
+		throw InvalidArgumentException("there must be at least 1 record");
+
+	m_records = records;
+}
+
+void ConnectorBenchmark::setRate(unsigned int rate)
+{
+	m_rate = rate;
+}
+
+void ConnectorBenchmark::setResendTimeout(const Timespan &timeout)
+{
+	m_resendTimeout = timeout;
+}
+
+void ConnectorBenchmark::setRetryConnectTimeout(const Timespan &timeout)
+{
+	m_retryConnectTimeout = timeout;
+}
+
+void ConnectorBenchmark::setConfirmDelay(const Timespan &delay)
+{
+	m_confirmDelay = delay;
+}
+
+void ConnectorBenchmark::setConfirmJitter(const Timespan &jitter)
+{
+	m_confirmJitter = jitter;
+}
+
+void ConnectorBenchmark::setLossRate(unsigned int percent)
+{
+	m_lossRate = percent;
+}
+
+void ConnectorBenchmark::setDisconnectEvery(unsigned int exports)
+{
+	m_disconnectEvery = exports;
+}
+
+void ConnectorBenchmark::setDrainTimeout(const Timespan &timeout)
+{
+	if (timeout <= 0)
+		throw InvalidArgumentException("drain timeout must be positive");
+
+	m_drainTimeout = timeout;
+}
+
+void ConnectorBenchmark::run()
+{
+	GWServerStandIn server;
+	server.setConfirmDelay(m_confirmDelay);
+	server.setConfirmJitter(m_confirmJitter);
+	server.setLossRate(m_lossRate);
+	server.setDisconnectEvery(m_disconnectEvery);
+	server.start();
+
+	SharedPtr<GatewayInfo> info = new GatewayInfo;
+	info->setGatewayID(BENCH_GATEWAY_ID);
+
+	GWServerConnector connector;
+	connector.setHost("127.0.0.1");
+	connector.setPort(server.port());
+	connector.setResendTimeout(m_resendTimeout);
+	connector.setRetryConnectTimeout(m_retryConnectTimeout);
+	connector.setGatewayInfo(info);
+	connector.start();
+
+	const Timestamp connecting;
+	while (server.registrations() == 0) {
+		if (connecting.isElapsed(REGISTER_TIMEOUT.totalMicroseconds())) {
+			connector.stop();
+			throw TimeoutException("connector has not registered in time");
+		}
+
+		Thread::sleep(10);
+	}
+
+	logger().information(
+		"shipping " + to_string(m_records) + " records",
+		__FILE__, __LINE__);
+
+	Random random;
+	const Timespan period = m_rate == 0 ? Timespan(0) :
+		Timespan(Timespan::SECONDS / m_rate);
+
+	m_rejected = 0;
+	m_started.update();
+	Timestamp next = m_started;
+
+	for (size_t n = 0; n < m_records; ++n) {
+		SensorData data;
+		data.setDeviceID(DeviceID(
+			DevicePrefix::PREFIX_VIRTUAL_DEVICE, n % BENCH_DEVICES));
+		data.insertValue(SensorValue(ModuleID(0), random.nextDouble() * 40));
+
+		if (period > 0) {
+			next += period;
+
+			const Timestamp now;
+			if (next > now)
+				Thread::sleep((next - now) / 1000);
+		}
+
+		data.setTimestamp(Timestamp());
+
+		while (!connector.ship(data)) {
+			++m_rejected;
+			Thread::sleep(REJECTED_SLEEP.totalMilliseconds());
+		}
+	}
+
+	if (!server.waitConfirmed(m_records, m_drainTimeout)) {
+		logger().warning(
+			"only " + to_string(server.confirmedExports())
+			+ "/" + to_string(m_records) + " records confirmed",
+			__FILE__, __LINE__);
+	}
+
+	m_finished.update();
+	m_residentKB = ProcessStats::residentKB();
+
+	connector.stop();
+	server.stop();
+
+	m_confirmed = server.confirmedExports();
+	m_received = server.receivedExports();
+	m_distinct = server.distinctExports();
+	m_confirmsLost = server.confirmsLost();
+	m_registrations = server.registrations();
+	m_disconnects = server.disconnects();
+	m_confirmLatency = server.confirmLatency();
+	m_reconnectLatency = server.reconnectLatency();
+}
+
+void ConnectorBenchmark::report(ostream &out) const
+{
+	const double elapsed = (m_finished - m_started) / 1000000.0;
+
+	PrintHandler json(out);
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("connector"));
+	json.key("records");
+	json.value(static_cast<UInt64>(m_records));
+	json.key("rate");
+	json.value(m_rate);
+	json.key("loss_percent");
+	json.value(m_lossRate);
+	json.key("confirm_delay_us");
+	json.value(m_confirmDelay.totalMicroseconds());
+	json.key("confirm_jitter_us");
+	json.value(m_confirmJitter.totalMicroseconds());
+	json.key("disconnect_every");
+	json.value(m_disconnectEvery);
+	json.key("resend_timeout_us");
+	json.value(m_resendTimeout.totalMicroseconds());
+
+	json.key("confirmed");
+	json.value(static_cast<UInt64>(m_confirmed));
+	json.key("elapsed_us");
+	json.value(static_cast<Int64>(m_finished - m_started));
+	json.key("records_per_sec");
+	json.value(elapsed > 0 ? m_confirmed / elapsed : 0.0);
+	json.key("confirm_latency_us");
+	m_confirmLatency.print(json);
+
+	json.key("received_exports");
+	json.value(static_cast<UInt64>(m_received));
+	json.key("resend_amplification");
+	json.value(m_distinct == 0 ? 0.0 : m_received / double(m_distinct));
+	json.key("confirms_lost");
+	json.value(static_cast<UInt64>(m_confirmsLost));
+	json.key("rejected_ships");
+	json.value(static_cast<UInt64>(m_rejected));
+
+	json.key("registrations");
+	json.value(static_cast<UInt64>(m_registrations));
+	json.key("disconnects");
+	json.value(static_cast<UInt64>(m_disconnects));
+	json.key("reconnect_us");
+	m_reconnectLatency.print(json);
+
+	json.key("rss_kb");
+	json.value(m_residentKB);
+
+	json.endObject();
+	out << endl;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <ostream>
+
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Types.h>
+
+#include "LatencySamples.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Load test of the GWServerConnector against the local
+ * GWServerStandIn. Data are shipped directly into the connector
+ * (a rejected ship is retried after a short sleep as the connector
+ * rejects data while disconnected) and the benchmark waits until
+ * the server confirms all of them.
+ *
+ * The result contains export throughput, latency between shipping
+ * and confirmation, resend amplification (received exports per
+ * distinct export, caused by lost or late confirmations and the
+ * resend timeout of the connector) and duration of reconnects
+ * after the server closed the connection.
+ */
+class ConnectorBenchmark : protected Loggable {
+public:
+	ConnectorBenchmark();
+
+	void setRecords(size_t records);
+	void setRate(unsigned int rate);
+	void setResendTimeout(const Poco::Timespan &timeout);
+	void setRetryConnectTimeout(const Poco::Timespan &timeout);
+	void setConfirmDelay(const Poco::Timespan &delay);
+	void setConfirmJitter(const Poco::Timespan &jitter);
+	void setLossRate(unsigned int percent);
+	void setDisconnectEvery(unsigned int exports);
+	void setDrainTimeout(const Poco::Timespan &timeout);
+
+	void run();
+	void report(std::ostream &out) const;
+
+private:
+	size_t m_records;
+	unsigned int m_rate;
+	Poco::Timespan m_resendTimeout;
+	Poco::Timespan m_retryConnectTimeout;
+	Poco::Timespan m_confirmDelay;
+	Poco::Timespan m_confirmJitter;
+	unsigned int m_lossRate;
+	unsigned int m_disconnectEvery;
+	Poco::Timespan m_drainTimeout;
+
+	Poco::Timestamp m_started;
+	Poco::Timestamp m_finished;
+	size_t m_confirmed;
+	size_t m_received;
+	size_t m_distinct;
+	size_t m_rejected;
+	size_t m_confirmsLost;
+	size_t m_registrations;
+	size_t m_disconnects;
+	LatencySamples m_confirmLatency;
+	LatencySamples m_reconnectLatency;
+	Poco::Int64 m_residentKB;
+};
+
+}
@@ -0,0 +1,178 @@
+#include <algorithm>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/Path.h>
+#include <Poco/Process.h>
+#include <Poco/JSON/PrintHandler.h>
+
+#include "DataFileBenchmark.h"
+#include "util/DataIterator.h"
+#include "util/DataReader.h"
+#include "util/DataWriter.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+/**
+ * @brief Generates records of the given size that differ
+ * by their sequence number.
+ */
+class GeneratingDataIterator : public DataIterator {
+public:
+	GeneratingDataIterator(UInt64 first, UInt64 count, unsigned int size):
+		m_next(first),
+		m_end(first + count),
+		m_size(size)
+	{
+	}
+
+	bool hasNext() override
+	{
+		return m_next < m_end;
+	}
+
+	string next() override
+	{
+		return record(m_next++, m_size);
+	}
+
+	static string record(UInt64 sequence, unsigned int size)
+	{
+		string data = to_string(sequence) + ";";
+		data.resize(max<size_t>(size, data.size()), 'x');
+		return data;
+	}
+
+private:
+	UInt64 m_next;
+	UInt64 m_end;
+	unsigned int m_size;
+};
+
+static double megabytesPerSecond(UInt64 bytes, const Timespan &time)
+{
+	if (time.totalMicroseconds() == 0)
+		return 0;
+
+	return bytes / 1048576.0 / (time.totalMicroseconds() / 1000000.0);
+}
+
+DataFileBenchmark::DataFileBenchmark():
+	m_records(100000),
+	m_recordSize(100),
+	m_batchSize(100),
+	m_workDir(Path::temp()),
+	m_fileSize(0)
+{
+}
+
+void DataFileBenchmark::setRecords(UInt64 records)
+{
+	m_records = records;
+}
+
+void DataFileBenchmark::setRecordSize(unsigned int size)
+{
+	m_recordSize = size;
+}
+
+void DataFileBenchmark::setBatchSize(unsigned int size)
+{
+	if (size == 0)
+		throw InvalidArgumentException("batch size must be positive");
+
+	m_batchSize = size;
+}
+
+void DataFileBenchmark::setWorkDir(const string &dir)
+{
+	m_workDir = dir;
+}
+
+void DataFileBenchmark::run()
+{
+	Path file(m_workDir);
+	file.makeDirectory();
+	file.setFileName("gateway-bench-" + to_string(Process::id()) + "-datafile");
+
+	const string path = file.toString();
+
+	try {
+		FileOutputStream output(path);
+		DataWriter writer(output);
+
+		const Clock started;
+
+		for (UInt64 written = 0; written < m_records; written += m_batchSize) {
+			GeneratingDataIterator batch(written,
+				min<UInt64>(m_batchSize, m_records - written), m_recordSize);
+			writer.write(batch);
+		}
+
+		output.close();
+		m_writeTime = started.elapsed();
+		m_fileSize = File(path).getSize();
+
+		FileInputStream input(path);
+		DataReader reader(input);
+
+		const Clock readStarted;
+		UInt64 read = 0;
+
+		while (reader.hasNext()) {
+			const string &data = reader.next();
+
+			if (data != GeneratingDataIterator::record(read, m_recordSize))
+				throw IllegalStateException("record " + to_string(read) + " is corrupted");
+
+			++read;
+		}
+
+		m_readTime = readStarted.elapsed();
+
+		if (read != m_records) {
+			throw IllegalStateException("read " + to_string(read)
+				+ " records out of " + to_string(m_records));
+		}
+	}
+	catch (...) {
+		File(path).remove();
+		throw;
+	}
+
+	File(path).remove();
+}
+
+void DataFileBenchmark::report(ostream &out) const
+{
+	PrintHandler json(out);
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("datafile"));
+	json.key("records");
+	json.value(m_records);
+	json.key("record_size");
+	json.value(m_recordSize);
+	json.key("batch");
+	json.value(m_batchSize);
+	json.key("file_bytes");
+	json.value(m_fileSize);
+	json.key("write_ms");
+	json.value(m_writeTime.totalMilliseconds());
+	json.key("read_ms");
+	json.value(m_readTime.totalMilliseconds());
+	json.key("write_mb_per_sec");
+	json.value(megabytesPerSecond(m_fileSize, m_writeTime));
+	json.key("read_mb_per_sec");
+	json.value(megabytesPerSecond(m_fileSize, m_readTime));
+
+	json.endObject();
+	out << endl;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Throughput of the checksummed data file format. The given
+ * number of records is written by the DataWriter into a file in the
+ * working directory in batches and the file is read back by the
+ * DataReader. All records read back are verified.
+ */
+class DataFileBenchmark {
+public:
+	DataFileBenchmark();
+
+	void setRecords(Poco::UInt64 records);
+	void setRecordSize(unsigned int size);
+	void setBatchSize(unsigned int size);
+	void setWorkDir(const std::string &dir);
+
+	void run();
+	void report(std::ostream &out) const;
+
+private:
+	Poco::UInt64 m_records;
+	unsigned int m_recordSize;
+	unsigned int m_batchSize;
+	std::string m_workDir;
+
+	Poco::UInt64 m_fileSize;
+	Poco::Timespan m_writeTime;
+	Poco::Timespan m_readTime;
+};
+
+}
@@ -0,0 +1,242 @@
+#include <cmath>
+#include <iterator>
+#include <list>
+#include <vector>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/Random.h>
+#include <Poco/JSON/PrintHandler.h>
+
+#include "DeadbandBenchmark.h"
+#include "commands/NewDeviceCommand.h"
+#include "core/DeadbandFilter.h"
+#include "model/DevicePrefix.h"
+#include "model/ModuleType.h"
+#include "model/SensorData.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+/**
+ * Simulation starts at 2018-01-01 00:00:00 UTC.
+ */
+static const Timestamp SIMULATION_START = Timestamp::fromEpochTime(1514764800);
+
+static const list<string> RULES = {
+	"default:change",
+	"temperature:0.2",
+	"power:1/2%",
+	"voltage:2",
+};
+
+enum DeviceKind {
+	KIND_METER = 0,
+	KIND_REGULATOR,
+	KIND_BULB,
+	KIND_COUNT,
+};
+
+/**
+ * @brief Simulated state of a device, meaning of the values depends
+ * on the kind of the device.
+ */
+struct SimulatedDevice {
+	double first = 0;
+	double second = 0;
+};
+
+static double quantize(double value, double resolution)
+{
+	return round(value / resolution) * resolution;
+}
+
+static list<ModuleType> typesOf(DeviceKind kind)
+{
+	switch (kind) {
+	case KIND_METER:
+		return {
+			ModuleType(ModuleType::Type::TYPE_POWER),
+			ModuleType(ModuleType::Type::TYPE_VOLTAGE),
+		};
+	case KIND_REGULATOR:
+		return {
+			ModuleType(ModuleType::Type::TYPE_TEMPERATURE),
+			ModuleType(ModuleType::Type::TYPE_TEMPERATURE),
+		};
+	default:
+		return {
+			ModuleType(ModuleType::Type::TYPE_ON_OFF),
+			ModuleType(ModuleType::Type::TYPE_BRIGHTNESS),
+		};
+	}
+}
+
+/**
+ * @brief Advance the device by a single poll and return values
+ * it reports.
+ */
+static pair<double, double> poll(
+		DeviceKind kind,
+		SimulatedDevice &device,
+		Random &random)
+{
+	static const double LOADS[] = {0, 5, 60, 120, 1500};
+
+	switch (kind) {
+	case KIND_METER:
+		// power of the load, voltage
+		if (random.next(20) == 0)
+			device.first = LOADS[random.next(5)];
+
+		return {
+			quantize(device.first * (1 + (random.nextDouble() - 0.5) / 100), 0.1),
+			quantize(230 + 2 * (random.nextDouble() - 0.5), 1),
+		};
+
+	case KIND_REGULATOR:
+		// current temperature, target temperature
+		if (random.next(500) == 0)
+			device.second = 18 + random.next(6);
+
+		device.first += device.first < device.second ? 0.05 : -0.05;
+
+		return {
+			quantize(device.first + 0.2 * (random.nextDouble() - 0.5), 0.5),
+			device.second,
+		};
+
+	default:
+		// on/off, brightness
+		if (random.next(200) == 0) {
+			device.first = device.first > 0 ? 0 : 1;
+			device.second = device.first > 0 ? 10 * (1 + random.next(10)) : 0;
+		}
+
+		return {device.first, device.second};
+	}
+}
+
+DeadbandBenchmark::DeadbandBenchmark():
+	m_devices(100),
+	m_records(100000),
+	m_refresh(30 * Timespan::SECONDS),
+	m_heartbeat(15 * Timespan::MINUTES),
+	m_valuesIn(0),
+	m_valuesOut(0),
+	m_recordsOut(0)
+{
+}
+
+void DeadbandBenchmark::setDevices(unsigned int devices)
+{
+	if (devices == 0)
+		throw InvalidArgumentException("devices must be positive");
+
+	m_devices = devices;
+}
+
+void DeadbandBenchmark::setRecords(UInt64 records)
+{
+	m_records = records;
+}
+
+void DeadbandBenchmark::setRefresh(const Timespan &refresh)
+{
+	if (refresh < 1 * Timespan::SECONDS)
+		throw InvalidArgumentException("refresh must be at least 1 s");
+
+	m_refresh = refresh;
+}
+
+void DeadbandBenchmark::setHeartbeat(const Timespan &heartbeat)
+{
+	m_heartbeat = heartbeat;
+}
+
+void DeadbandBenchmark::run()
+{
+	DeadbandFilter filter;
+	filter.setRules(RULES);
+	filter.setHeartbeat(m_heartbeat);
+
+	for (unsigned int i = 0; i < m_devices; ++i) {
+		const DeviceID device(DevicePrefix::PREFIX_VIRTUAL_DEVICE, i);
+		const DeviceKind kind = static_cast<DeviceKind>(i % KIND_COUNT);
+
+		filter.onDispatch(new NewDeviceCommand(
+			device, "BeeeOn", "Deadband Benchmark", typesOf(kind)));
+	}
+
+	vector<SimulatedDevice> devices(m_devices);
+	vector<SensorData> records;
+	records.reserve(m_records);
+
+	Random random;
+	random.seed(42);
+
+	for (UInt64 n = 0; n < m_records; ++n) {
+		const unsigned int i = n % m_devices;
+		const DeviceKind kind = static_cast<DeviceKind>(i % KIND_COUNT);
+		const pair<double, double> values = poll(kind, devices[i], random);
+
+		SensorData data;
+		data.setDeviceID(DeviceID(DevicePrefix::PREFIX_VIRTUAL_DEVICE, i));
+		data.setTimestamp(SIMULATION_START
+			+ (n / m_devices) * m_refresh.totalMicroseconds());
+		data.insertValue(SensorValue(ModuleID(0), values.first));
+		data.insertValue(SensorValue(ModuleID(1), values.second));
+
+		records.emplace_back(data);
+	}
+
+	m_valuesIn = 0;
+	m_valuesOut = 0;
+	m_recordsOut = 0;
+
+	const Clock started;
+
+	for (auto &data : records) {
+		if (!filter.filter(data))
+			continue;
+
+		m_recordsOut += 1;
+		m_valuesOut += distance(data.begin(), data.end());
+	}
+
+	m_elapsed = started.elapsed();
+	m_valuesIn = m_records * 2;
+}
+
+void DeadbandBenchmark::report(ostream &out) const
+{
+	PrintHandler json(out);
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("deadband"));
+	json.key("devices");
+	json.value(m_devices);
+	json.key("records");
+	json.value(m_records);
+	json.key("refresh_sec");
+	json.value(m_refresh.totalSeconds());
+	json.key("heartbeat_sec");
+	json.value(m_heartbeat.totalSeconds());
+	json.key("values_in");
+	json.value(m_valuesIn);
+	json.key("values_out");
+	json.value(m_valuesOut);
+	json.key("records_out");
+	json.value(m_recordsOut);
+	json.key("reduction_ratio");
+	json.value(m_valuesOut > 0 ? double(m_valuesIn) / m_valuesOut : 0.0);
+	json.key("filter_ns_per_record");
+	json.value(m_records > 0 ? m_elapsed.totalMicroseconds() * 1000.0 / m_records : 0.0);
+
+	json.endObject();
+	out << endl;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <ostream>
+
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Reduction ratio and overhead of the DeadbandFilter on traces
+ * of devices that re-report identical values every poll. The devices
+ * are simulated in a round robin of three kinds:
+ *
+ * - meter (power and voltage) with the load changing in steps
+ * - regulator (current and target temperature) with the temperature
+ *   quantized to 0.5 degrees drifting slowly to the target
+ * - bulb (on/off and brightness) switched a few times a day
+ *
+ * Module types are announced to the filter by NewDeviceCommands as
+ * in the gateway. Records are generated in advance so that only the
+ * filtering itself is measured.
+ */
+class DeadbandBenchmark {
+public:
+	DeadbandBenchmark();
+
+	void setDevices(unsigned int devices);
+	void setRecords(Poco::UInt64 records);
+	void setRefresh(const Poco::Timespan &refresh);
+	void setHeartbeat(const Poco::Timespan &heartbeat);
+
+	void run();
+	void report(std::ostream &out) const;
+
+private:
+	unsigned int m_devices;
+	Poco::UInt64 m_records;
+	Poco::Timespan m_refresh;
+	Poco::Timespan m_heartbeat;
+
+	Poco::UInt64 m_valuesIn;
+	Poco::UInt64 m_valuesOut;
+	Poco::UInt64 m_recordsOut;
+	Poco::Timespan m_elapsed;
+};
+
+}
@@ -0,0 +1,16 @@
+#include "GWMessageSensorDataFormatter.h"
+#include "gwmessage/GWSensorDataExport.h"
+#include "model/GlobalID.h"
+#include "model/SensorData.h"
+
+using namespace BeeeOn;
+using namespace std;
+
+string GWMessageSensorDataFormatter::format(const SensorData &data)
+{
+	GWSensorDataExport::Ptr message = new GWSensorDataExport;
+	message->setID(GlobalID::random());
+	message->setData({data});
+
+	return message->toString();
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "util/SensorDataFormatter.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Serializes SensorData the same way as the GWServerConnector
+ * does before sending it to the server, i.e. as a GWSensorDataExport
+ * message with a random GlobalID.
+ */
+class GWMessageSensorDataFormatter : public SensorDataFormatter {
+public:
+	std::string format(const SensorData &data) override;
+};
+
+}
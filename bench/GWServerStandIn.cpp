@@ -0,0 +1,420 @@
+#include <Poco/Buffer.h>
+#include <Poco/Exception.h>
+#include <Poco/Thread.h>
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/NetException.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketAddress.h>
+
+#include "GWServerStandIn.h"
+#include "gwmessage/GWGatewayAccepted.h"
+#include "gwmessage/GWGatewayRegister.h"
+#include "gwmessage/GWSensorDataConfirm.h"
+#include "gwmessage/GWSensorDataExport.h"
+#include "util/LambdaTimerTask.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::Net;
+using namespace std;
+
+static const Timespan POLL_TIMEOUT = 100 * Timespan::MILLISECONDS;
+static const Timespan REGISTER_TIMEOUT = 5 * Timespan::SECONDS;
+static const Timespan STOP_TIMEOUT = 5 * Timespan::SECONDS;
+static const int MAX_MESSAGE_SIZE = 64 * 1024;
+
+class GWServerStandIn::Connection {
+public:
+	Connection(WebSocket &socket):
+		m_socket(socket),
+		m_closed(false)
+	{
+	}
+
+	bool send(const string &message)
+	{
+		return sendFrame(message.data(), message.size(),
+			WebSocket::FRAME_TEXT);
+	}
+
+	bool sendFrame(const void *data, size_t length, int flags)
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		if (m_closed)
+			return false;
+
+		m_socket.sendFrame(data, length, flags);
+		return true;
+	}
+
+	void close()
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		m_closed = true;
+		m_socket.close();
+	}
+
+	size_t &exports()
+	{
+		return m_exports;
+	}
+
+private:
+	WebSocket m_socket;
+	FastMutex m_lock;
+	bool m_closed;
+	size_t m_exports = 0;
+};
+
+class GWServerStandIn::Handler : public HTTPRequestHandler {
+public:
+	Handler(GWServerStandIn &server):
+		m_server(server)
+	{
+	}
+
+	void handleRequest(
+		HTTPServerRequest &request,
+		HTTPServerResponse &response) override
+	{
+		try {
+			WebSocket socket(request, response);
+			m_server.serve(socket);
+		}
+		catch (const WebSocketException &e) {
+			m_server.logger().log(e, __FILE__, __LINE__);
+
+			response.setStatusAndReason(HTTPResponse::HTTP_BAD_REQUEST);
+			response.setContentLength(0);
+			response.send();
+		}
+		BEEEON_CATCH_CHAIN(m_server.logger())
+	}
+
+private:
+	GWServerStandIn &m_server;
+};
+
+class GWServerStandIn::HandlerFactory : public HTTPRequestHandlerFactory {
+public:
+	HandlerFactory(GWServerStandIn &server):
+		m_server(server)
+	{
+	}
+
+	HTTPRequestHandler *createRequestHandler(const HTTPServerRequest &) override
+	{
+		return new Handler(m_server);
+	}
+
+private:
+	GWServerStandIn &m_server;
+};
+
+GWServerStandIn::GWServerStandIn():
+	m_confirmDelay(0),
+	m_confirmJitter(0),
+	m_lossRate(0),
+	m_disconnectEvery(0),
+	m_port(0),
+	m_disconnected(false)
+{
+}
+
+GWServerStandIn::~GWServerStandIn()
+{
+	stop();
+}
+
+void GWServerStandIn::setConfirmDelay(const Timespan &delay)
+{
+	if (delay < 0)
+		throw InvalidArgumentException("confirm delay must be non-negative");
+
+	m_confirmDelay = delay;
+}
+
+void GWServerStandIn::setConfirmJitter(const Timespan &jitter)
+{
+	if (jitter < 0)
+		throw InvalidArgumentException("confirm jitter must be non-negative");
+
+	m_confirmJitter = jitter;
+}
+
+void GWServerStandIn::setLossRate(unsigned int percent)
+{
+	if (percent > 100)
+		throw InvalidArgumentException("loss rate must be in range 0..100");
+
+	m_lossRate = percent;
+}
+
+void GWServerStandIn::setDisconnectEvery(unsigned int exports)
+{
+	m_disconnectEvery = exports;
+}
+
+void GWServerStandIn::start()
+{
+	ServerSocket socket(SocketAddress("127.0.0.1", 0));
+	m_port = socket.address().port();
+
+	HTTPServerParams::Ptr params = new HTTPServerParams;
+	params->setKeepAlive(true);
+
+	m_stop = 0;
+	m_server = new HTTPServer(new HandlerFactory(*this), socket, params);
+	m_server->start();
+
+	logger().information(
+		"listening on 127.0.0.1:" + to_string(m_port),
+		__FILE__, __LINE__);
+}
+
+void GWServerStandIn::stop()
+{
+	if (m_server.isNull())
+		return;
+
+	m_stop = 1;
+	m_server->stop();
+
+	const Timestamp started;
+	while (m_server->currentConnections() > 0 && !started.isElapsed(STOP_TIMEOUT.totalMicroseconds()))
+		Thread::sleep(POLL_TIMEOUT.totalMilliseconds());
+
+	m_timer.cancel(true);
+	m_server = nullptr;
+}
+
+UInt16 GWServerStandIn::port() const
+{
+	return m_port;
+}
+
+void GWServerStandIn::serve(WebSocket &socket)
+{
+	SharedPtr<Connection> connection = new Connection(socket);
+	Buffer<char> buffer(MAX_MESSAGE_SIZE);
+
+	socket.setReceiveTimeout(REGISTER_TIMEOUT);
+
+	if (!registerGateway(socket, *connection)) {
+		connection->close();
+		return;
+	}
+
+	while (!m_stop) {
+		if (!socket.poll(POLL_TIMEOUT, Socket::SELECT_READ))
+			continue;
+
+		int flags;
+		const int ret = socket.receiveFrame(buffer.begin(), buffer.size(), flags);
+		const int opcode = flags & WebSocket::FRAME_OP_BITMASK;
+
+		if (opcode == WebSocket::FRAME_OP_PING) {
+			connection->sendFrame(buffer.begin(), ret,
+				WebSocket::FRAME_FLAG_FIN | WebSocket::FRAME_OP_PONG);
+			continue;
+		}
+
+		if (ret <= 0 || opcode == WebSocket::FRAME_OP_CLOSE)
+			break;
+
+		GWMessage::Ptr message = GWMessage::fromJSON(string(buffer.begin(), ret));
+
+		if (message.cast<GWSensorDataExport>().isNull()) {
+			logger().warning(
+				"unexpected message " + message->type().toString(),
+				__FILE__, __LINE__);
+			continue;
+		}
+
+		handleExport(connection, message);
+
+		if (m_disconnectEvery > 0
+				&& ++connection->exports() % m_disconnectEvery == 0) {
+			FastMutex::ScopedLock guard(m_lock);
+
+			m_lastDisconnect.update();
+			m_disconnected = true;
+			++m_disconnects;
+			break;
+		}
+	}
+
+	connection->close();
+}
+
+bool GWServerStandIn::registerGateway(
+		WebSocket &socket,
+		Connection &connection)
+{
+	Buffer<char> buffer(MAX_MESSAGE_SIZE);
+	int flags;
+
+	const int ret = socket.receiveFrame(buffer.begin(), buffer.size(), flags);
+	if (ret <= 0)
+		return false;
+
+	GWMessage::Ptr message = GWMessage::fromJSON(string(buffer.begin(), ret));
+	GWGatewayRegister::Ptr request = message.cast<GWGatewayRegister>();
+
+	if (request.isNull()) {
+		logger().warning(
+			"expected registration but got " + message->type().toString(),
+			__FILE__, __LINE__);
+		return false;
+	}
+
+	GWGatewayAccepted::Ptr accepted = new GWGatewayAccepted;
+	if (!connection.send(accepted->toString()))
+		return false;
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_disconnected) {
+		m_reconnectLatency.add(Timespan(Timestamp() - m_lastDisconnect));
+		m_disconnected = false;
+	}
+
+	++m_registrations;
+
+	logger().information(
+		"registered gateway " + request->gatewayID().toString(),
+		__FILE__, __LINE__);
+
+	return true;
+}
+
+void GWServerStandIn::handleExport(
+		SharedPtr<Connection> connection,
+		GWMessage::Ptr message)
+{
+	Timespan delay = m_confirmDelay;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		++m_receivedExports;
+		m_received.emplace(message->id().toString());
+
+		if (m_lossRate > 0 && m_random.next(100) < m_lossRate) {
+			++m_confirmsLost;
+			return;
+		}
+
+		if (m_confirmJitter > 0) {
+			delay += Timespan(m_random.next(
+				static_cast<UInt32>(m_confirmJitter.totalMicroseconds())));
+		}
+	}
+
+	if (delay == 0) {
+		confirm(connection, message);
+		return;
+	}
+
+	LambdaTimerTask::Ptr task = new LambdaTimerTask(
+		[this, connection, message]() {
+			try {
+				confirm(connection, message);
+			}
+			BEEEON_CATCH_CHAIN(logger())
+		}
+	);
+
+	m_timer.schedule(task, Timestamp() + delay);
+}
+
+void GWServerStandIn::confirm(
+		SharedPtr<Connection> connection,
+		GWMessage::Ptr message)
+{
+	GWSensorDataConfirm::Ptr confirm = new GWSensorDataConfirm;
+	confirm->setID(message->id());
+
+	if (!connection->send(confirm->toString()))
+		return;
+
+	++m_confirmsSent;
+
+	const auto &data = message.cast<GWSensorDataExport>()->data();
+	const Timestamp now;
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (!m_confirmed.emplace(message->id().toString()).second)
+		return;
+
+	if (!data.empty())
+		m_confirmLatency.add(Timespan(now - data.front().timestamp().value()));
+}
+
+size_t GWServerStandIn::registrations() const
+{
+	return m_registrations.value();
+}
+
+size_t GWServerStandIn::disconnects() const
+{
+	return m_disconnects.value();
+}
+
+size_t GWServerStandIn::receivedExports() const
+{
+	return m_receivedExports.value();
+}
+
+size_t GWServerStandIn::distinctExports() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_received.size();
+}
+
+size_t GWServerStandIn::confirmedExports() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_confirmed.size();
+}
+
+size_t GWServerStandIn::confirmsSent() const
+{
+	return m_confirmsSent.value();
+}
+
+size_t GWServerStandIn::confirmsLost() const
+{
+	return m_confirmsLost.value();
+}
+
+const LatencySamples &GWServerStandIn::confirmLatency() const
+{
+	return m_confirmLatency;
+}
+
+const LatencySamples &GWServerStandIn::reconnectLatency() const
+{
+	return m_reconnectLatency;
+}
+
+bool GWServerStandIn::waitConfirmed(size_t count, const Timespan &timeout) const
+{
+	const Timestamp started;
+
+	while (confirmedExports() < count) {
+		if (started.isElapsed(timeout.totalMicroseconds()))
+			return false;
+
+		Thread::sleep(10);
+	}
+
+	return true;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Mutex.h>
+#include <Poco/Random.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/WebSocket.h>
+#include <Poco/Util/Timer.h>
+
+#include "LatencySamples.h"
+#include "gwmessage/GWMessage.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Local stand-in of the BeeeOn Server for the GWServerConnector.
+ * It listens for WebSocket connections on the loopback and speaks
+ * the subset of the GWMessage protocol needed to export data:
+ *
+ * - GWGatewayRegister is answered by GWGatewayAccepted
+ * - GWSensorDataExport is answered by GWSensorDataConfirm
+ * - ping frames are answered by pong frames
+ *
+ * The behaviour of the server can be degraded to emulate a real
+ * deployment: confirmations can be delayed (with jitter), randomly
+ * lost and the connection can be closed after every N exports.
+ *
+ * The server collects statistics usable to evaluate the connector:
+ * number of received exports (including resends), number of distinct
+ * exports, latency between shipping of data (SensorData::timestamp())
+ * and sending of the confirmation and duration of reconnects.
+ */
+class GWServerStandIn : protected Loggable {
+public:
+	GWServerStandIn();
+	~GWServerStandIn();
+
+	void setConfirmDelay(const Poco::Timespan &delay);
+	void setConfirmJitter(const Poco::Timespan &jitter);
+
+	/**
+	 * Percentage (0..100) of confirmations that are never sent.
+	 */
+	void setLossRate(unsigned int percent);
+
+	/**
+	 * Close the connection after every N received exports,
+	 * 0 disables disconnecting.
+	 */
+	void setDisconnectEvery(unsigned int exports);
+
+	void start();
+	void stop();
+
+	/**
+	 * @returns port the server listens on (on 127.0.0.1).
+	 */
+	Poco::UInt16 port() const;
+
+	size_t registrations() const;
+	size_t disconnects() const;
+	size_t receivedExports() const;
+	size_t distinctExports() const;
+	size_t confirmedExports() const;
+	size_t confirmsSent() const;
+	size_t confirmsLost() const;
+
+	const LatencySamples &confirmLatency() const;
+	const LatencySamples &reconnectLatency() const;
+
+	/**
+	 * Wait until at least the given number of distinct exports
+	 * has been confirmed.
+	 */
+	bool waitConfirmed(size_t count, const Poco::Timespan &timeout) const;
+
+protected:
+	class Connection;
+	class Handler;
+	class HandlerFactory;
+	friend class Handler;
+
+	void serve(Poco::Net::WebSocket &socket);
+	bool registerGateway(
+		Poco::Net::WebSocket &socket,
+		Connection &connection);
+	void handleExport(
+		Poco::SharedPtr<Connection> connection,
+		GWMessage::Ptr message);
+	void confirm(
+		Poco::SharedPtr<Connection> connection,
+		GWMessage::Ptr message);
+
+private:
+	Poco::Timespan m_confirmDelay;
+	Poco::Timespan m_confirmJitter;
+	unsigned int m_lossRate;
+	unsigned int m_disconnectEvery;
+
+	Poco::SharedPtr<Poco::Net::HTTPServer> m_server;
+	Poco::UInt16 m_port;
+	Poco::AtomicCounter m_stop;
+	Poco::Util::Timer m_timer;
+
+	mutable Poco::FastMutex m_lock;
+	Poco::Random m_random;
+	std::set<std::string> m_received;
+	std::set<std::string> m_confirmed;
+	Poco::Timestamp m_lastDisconnect;
+	bool m_disconnected;
+
+	Poco::AtomicCounter m_registrations;
+	Poco::AtomicCounter m_disconnects;
+	Poco::AtomicCounter m_receivedExports;
+	Poco::AtomicCounter m_confirmsSent;
+	Poco::AtomicCounter m_confirmsLost;
+
+	LatencySamples m_confirmLatency;
+	LatencySamples m_reconnectLatency;
+};
+
+}
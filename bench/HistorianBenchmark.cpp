@@ -0,0 +1,199 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/Process.h>
+#include <Poco/Random.h>
+#include <Poco/JSON/PrintHandler.h>
+
+#include "HistorianBenchmark.h"
+#include "exporters/HistorianStore.h"
+#include "model/DevicePrefix.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+/**
+ * Simulation starts at 2018-01-01 00:00:00 UTC.
+ */
+static const Timestamp SIMULATION_START = Timestamp::fromEpochTime(1514764800);
+static const Timespan FLUSH_INTERVAL = 1 * Timespan::HOURS;
+static const Timespan QUERY_RANGE = 1 * Timespan::DAYS;
+
+static double quantize(double value, double resolution)
+{
+	return round(value / resolution) * resolution;
+}
+
+HistorianBenchmark::HistorianBenchmark():
+	m_devices(10),
+	m_days(365),
+	m_refresh(5 * Timespan::MINUTES),
+	m_queries(1000),
+	m_workDir(Path::temp()),
+	m_points(0),
+	m_diskUsage(0),
+	m_partitions(0)
+{
+}
+
+void HistorianBenchmark::setDevices(unsigned int devices)
+{
+	if (devices == 0)
+		throw InvalidArgumentException("devices must be positive");
+
+	m_devices = devices;
+}
+
+void HistorianBenchmark::setDays(unsigned int days)
+{
+	if (days == 0)
+		throw InvalidArgumentException("days must be positive");
+
+	m_days = days;
+}
+
+void HistorianBenchmark::setRefresh(const Timespan &refresh)
+{
+	if (refresh < 1 * Timespan::SECONDS)
+		throw InvalidArgumentException("refresh must be at least 1 s");
+
+	m_refresh = refresh;
+}
+
+void HistorianBenchmark::setQueries(unsigned int queries)
+{
+	m_queries = queries;
+}
+
+void HistorianBenchmark::setWorkDir(const string &dir)
+{
+	m_workDir = dir;
+}
+
+void HistorianBenchmark::run()
+{
+	Path root(m_workDir);
+	root.makeDirectory();
+	root.pushDirectory("gateway-bench-" + to_string(Process::id()) + "-historian");
+
+	const string path = root.toString();
+	const UInt64 ticks = m_days * QUERY_RANGE.totalMicroseconds()
+		/ m_refresh.totalMicroseconds();
+	const UInt64 ticksPerQuery = min<UInt64>(ticks,
+		QUERY_RANGE.totalMicroseconds() / m_refresh.totalMicroseconds());
+
+	try {
+		HistorianStore store;
+		store.setRootDir(path);
+		store.setRetention((m_days + 1) * Timespan::DAYS);
+		store.setSizeLimit(numeric_limits<UInt64>::max());
+		store.open();
+
+		Random random;
+		random.seed(42);
+
+		const Clock started;
+		Timestamp lastFlush = SIMULATION_START;
+
+		for (UInt64 tick = 0; tick < ticks; ++tick) {
+			const Timestamp at = SIMULATION_START + tick * m_refresh.totalMicroseconds();
+			const double phase = 2 * M_PI * (at - SIMULATION_START)
+				/ QUERY_RANGE.totalMicroseconds();
+
+			for (unsigned int i = 0; i < m_devices; ++i) {
+				const DeviceID device(DevicePrefix::PREFIX_VIRTUAL_DEVICE, i);
+				const double noise = random.nextDouble() - 0.5;
+
+				store.append(device, ModuleID(0), at,
+					quantize(20 + 5 * sin(phase + i) + noise, 0.1));
+				store.append(device, ModuleID(1), at,
+					quantize(50 + 10 * sin(phase + i) + 4 * noise, 1));
+			}
+
+			if (at - lastFlush >= FLUSH_INTERVAL.totalMicroseconds()) {
+				store.flush();
+				lastFlush = at;
+			}
+		}
+
+		store.flush();
+		m_ingestTime = started.elapsed();
+
+		m_points = ticks * m_devices * 2;
+		m_diskUsage = store.diskUsage();
+		m_partitions = store.partitionCount();
+
+		m_queryLatency = LatencySamples(m_queries);
+		vector<HistorianStore::Point> points;
+
+		for (unsigned int n = 0; n < m_queries; ++n) {
+			const DeviceID device(DevicePrefix::PREFIX_VIRTUAL_DEVICE,
+				random.next(m_devices));
+			const ModuleID module(random.next(2));
+			const UInt64 first = random.next(ticks - ticksPerQuery + 1);
+			const Timestamp from = SIMULATION_START + first * m_refresh.totalMicroseconds();
+			const Timestamp to = from + ticksPerQuery * m_refresh.totalMicroseconds();
+
+			points.clear();
+
+			const Clock queryStarted;
+			store.query(device, module, from, to, points);
+			m_queryLatency.add(queryStarted.elapsed());
+
+			if (points.size() != ticksPerQuery) {
+				throw IllegalStateException("query returned "
+					+ to_string(points.size()) + " points instead of "
+					+ to_string(ticksPerQuery));
+			}
+		}
+	}
+	catch (...) {
+		File(path).remove(true);
+		throw;
+	}
+
+	File(path).remove(true);
+}
+
+void HistorianBenchmark::report(ostream &out) const
+{
+	PrintHandler json(out);
+	const double elapsed = m_ingestTime.totalMicroseconds() / 1000000.0;
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("historian"));
+	json.key("devices");
+	json.value(m_devices);
+	json.key("days");
+	json.value(m_days);
+	json.key("refresh_sec");
+	json.value(m_refresh.totalSeconds());
+	json.key("points");
+	json.value(m_points);
+	json.key("partitions");
+	json.value(static_cast<UInt64>(m_partitions));
+	json.key("disk_bytes");
+	json.value(m_diskUsage);
+	json.key("bytes_per_point");
+	json.value(m_points > 0 ? double(m_diskUsage) / m_points : 0.0);
+	json.key("ingest_ms");
+	json.value(m_ingestTime.totalMilliseconds());
+	json.key("ingest_points_per_sec");
+	json.value(elapsed > 0 ? m_points / elapsed : 0.0);
+	json.key("queries");
+	json.value(m_queries);
+	json.key("query_latency_us");
+	m_queryLatency.print(json);
+
+	json.endObject();
+	out << endl;
+}
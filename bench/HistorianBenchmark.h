@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "LatencySamples.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Ingest rate, disk footprint and query latency of the
+ * HistorianStore. The given number of devices with 2 modules each
+ * (temperature and humidity) report their values every refresh
+ * period for the given number of days in simulated time. Values
+ * follow a daily sine with noise quantized to the resolution of
+ * real sensors. The store is flushed every simulated hour as the
+ * HistorianExporter does by default.
+ *
+ * After the ingest, random 1-day ranges of random series are
+ * queried and the count of returned points is verified.
+ */
+class HistorianBenchmark {
+public:
+	HistorianBenchmark();
+
+	void setDevices(unsigned int devices);
+	void setDays(unsigned int days);
+	void setRefresh(const Poco::Timespan &refresh);
+	void setQueries(unsigned int queries);
+	void setWorkDir(const std::string &dir);
+
+	void run();
+	void report(std::ostream &out) const;
+
+private:
+	unsigned int m_devices;
+	unsigned int m_days;
+	Poco::Timespan m_refresh;
+	unsigned int m_queries;
+	std::string m_workDir;
+
+	Poco::UInt64 m_points;
+	Poco::UInt64 m_diskUsage;
+	size_t m_partitions;
+	Poco::Timespan m_ingestTime;
+	LatencySamples m_queryLatency;
+};
+
+}
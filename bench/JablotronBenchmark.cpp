@@ -0,0 +1,182 @@
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/JSON/PrintHandler.h>
+
+#include "JablotronBenchmark.h"
+#include "jablotron/JablotronGadget.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+/**
+ * Typical reports of all supported gadget types.
+ */
+static const vector<JablotronReport> &reports()
+{
+	static const string C = {static_cast<char>(0xb0), 'C'};
+	static const vector<JablotronReport> REPORTS = {
+		{0xcf0000, "AC-88", "RELAY:1"},
+		{0x580000, "JA-80L", "BUTTON BLACKOUT:0"},
+		{0x580000, "JA-80L", "BEACON BLACKOUT:1"},
+		{0x180000, "JA-81M", "SENSOR LB:0 ACT:1"},
+		{0x180000, "JA-81M", "BEACON LB:0"},
+		{0x7f0000, "JA-82SH", "SENSOR LB:0"},
+		{0x1c0000, "JA-83M", "TAMPER LB:0 ACT:0"},
+		{0x640000, "JA-83P", "SENSOR LB:1"},
+		{0x760000, "JA-85ST", "TAMPER LB:0 ACT:1"},
+		{0x800000, "RC-86K", "ARM:1 LB:0"},
+		{0x900000, "RC-86K", "ARM:0 LB:0"},
+		{0x800000, "RC-86K", "PANIC LB:1"},
+		{0x240000, "TP-82N", "INT:21.5" + C + " LB:0"},
+		{0x240000, "TP-82N", "SET:-05.0" + C + " LB:1"},
+	};
+
+	return REPORTS;
+}
+
+JablotronBenchmark::JablotronBenchmark():
+	m_decoder("table"),
+	m_records(100000),
+	m_values(0)
+{
+}
+
+void JablotronBenchmark::setDecoder(const string &decoder)
+{
+	if (decoder != "table" && decoder != "strings")
+		throw InvalidArgumentException("unsupported decoder: " + decoder);
+
+	m_decoder = decoder;
+}
+
+void JablotronBenchmark::setRecords(UInt64 records)
+{
+	m_records = records;
+}
+
+vector<string> JablotronBenchmark::decoders()
+{
+	return {"strings", "table"};
+}
+
+/**
+ * Interpretation of reports equivalent to Info::parse() that searches
+ * the payload by the string based accessors for each keyword. The
+ * gadget type is resolved the same way for both decoders.
+ */
+size_t JablotronBenchmark::decodeStrings(const JablotronReport &report) const
+{
+	vector<SensorValue> values;
+
+	switch (JablotronGadget::Info::resolve(report.address).type) {
+	case JablotronGadget::AC88:
+		values.push_back({0, static_cast<double>(report.get("RELAY"))});
+		break;
+	case JablotronGadget::JA80L:
+		if (report.has("BUTTON"))
+			values.push_back({0, 1.0});
+		if (report.has("TAMPER"))
+			values.push_back({1, 1.0});
+
+		values.push_back({2, static_cast<double>(report.get("BLACKOUT"))});
+		break;
+	case JablotronGadget::JA81M:
+	case JablotronGadget::JA83M:
+		if (report.has("SENSOR"))
+			values.push_back({0, static_cast<double>(report.get("ACT"))});
+		if (report.has("TAMPER"))
+			values.push_back({1, static_cast<double>(report.get("ACT"))});
+
+		values.push_back({2, static_cast<double>(report.battery())});
+		break;
+	case JablotronGadget::JA82SH:
+	case JablotronGadget::JA83P:
+	case JablotronGadget::JA85ST:
+		if (report.has("SENSOR"))
+			values.push_back({0, 1.0});
+		if (report.has("TAMPER"))
+			values.push_back({1, static_cast<double>(report.get("ACT"))});
+
+		values.push_back({2, static_cast<double>(report.battery())});
+		break;
+	case JablotronGadget::RC86K:
+		if (!report.has("PANIC")) {
+			const bool primary = report.address
+				== JablotronGadget::Info::primaryAddress(report.address);
+			const ModuleID module = primary? 0 : 1;
+			values.push_back({module, static_cast<double>(report.get("ARM"))});
+		}
+		else {
+			values.push_back({2, 1.0});
+		}
+
+		values.push_back({3, static_cast<double>(report.battery())});
+		break;
+	case JablotronGadget::TP82N:
+		if (report.has("INT", true))
+			values.push_back({0, report.temperature("INT")});
+		if (report.has("SET", true))
+			values.push_back({1, report.temperature("SET")});
+
+		values.push_back({2, static_cast<double>(report.battery())});
+		break;
+	case JablotronGadget::NONE:
+		break;
+	}
+
+	return values.size();
+}
+
+size_t JablotronBenchmark::decodeTable(const JablotronReport &report) const
+{
+	const auto &info = JablotronGadget::Info::resolve(report.address);
+	return info.parse(report).size();
+}
+
+void JablotronBenchmark::run()
+{
+	const auto &all = reports();
+	const bool table = m_decoder == "table";
+	m_values = 0;
+
+	const Clock started;
+
+	for (UInt64 i = 0; i < m_records; ++i) {
+		const JablotronReport &report = all[i % all.size()];
+
+		if (table)
+			m_values += decodeTable(report);
+		else
+			m_values += decodeStrings(report);
+	}
+
+	m_time = started.elapsed();
+}
+
+void JablotronBenchmark::report(ostream &out) const
+{
+	PrintHandler json(out);
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("jablotron"));
+	json.key("decoder");
+	json.value(m_decoder);
+	json.key("reports");
+	json.value(m_records);
+	json.key("distinct_reports");
+	json.value(static_cast<UInt64>(reports().size()));
+	json.key("values");
+	json.value(m_values);
+	json.key("time_ms");
+	json.value(m_time.totalMilliseconds());
+	json.key("reports_per_sec");
+	json.value(m_time.totalMicroseconds() == 0 ? 0.0
+		: m_records / (m_time.totalMicroseconds() / 1000000.0));
+
+	json.endObject();
+	out << endl;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "jablotron/JablotronReport.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Throughput of resolving and decoding Jablotron reports as
+ * performed by JablotronDeviceManager::shipReport(). A set of reports
+ * of all supported gadget types is replayed in a loop. The decoder
+ * "table" uses JablotronGadget::Info::resolve() and Info::parse(),
+ * the decoder "strings" interprets each report by the string based
+ * accessors of JablotronReport to provide a baseline.
+ */
+class JablotronBenchmark {
+public:
+	JablotronBenchmark();
+
+	void setDecoder(const std::string &decoder);
+	void setRecords(Poco::UInt64 records);
+
+	void run();
+	void report(std::ostream &out) const;
+
+	static std::vector<std::string> decoders();
+
+private:
+	size_t decodeStrings(const JablotronReport &report) const;
+	size_t decodeTable(const JablotronReport &report) const;
+
+private:
+	std::string m_decoder;
+	Poco::UInt64 m_records;
+
+	Poco::UInt64 m_values;
+	Poco::Timespan m_time;
+};
+
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+
+#include <Poco/Exception.h>
+
+#include "LatencySamples.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+LatencySamples::LatencySamples(size_t expected):
+	m_sorted(true)
+{
+	m_samples.reserve(expected);
+}
+
+LatencySamples::LatencySamples(const LatencySamples &other)
+{
+	FastMutex::ScopedLock guard(other.m_lock);
+
+	m_samples = other.m_samples;
+	m_sorted = other.m_sorted;
+}
+
+LatencySamples &LatencySamples::operator =(const LatencySamples &other)
+{
+	if (this == &other)
+		return *this;
+
+	vector<Int64> samples;
+	bool sorted;
+
+	{
+		FastMutex::ScopedLock guard(other.m_lock);
+		samples = other.m_samples;
+		sorted = other.m_sorted;
+	}
+
+	FastMutex::ScopedLock guard(m_lock);
+	m_samples.swap(samples);
+	m_sorted = sorted;
+
+	return *this;
+}
+
+void LatencySamples::add(const Timespan &latency)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	m_samples.emplace_back(latency.totalMicroseconds());
+	m_sorted = false;
+}
+
+size_t LatencySamples::count() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_samples.size();
+}
+
+Int64 LatencySamples::percentile(double fraction) const
+{
+	if (fraction < 0 || fraction > 1)
+		throw InvalidArgumentException("percentile must be in range 0..1");
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_samples.empty())
+		return -1;
+
+	if (!m_sorted) {
+		sort(m_samples.begin(), m_samples.end());
+		m_sorted = true;
+	}
+
+	const size_t rank = static_cast<size_t>(
+		ceil(fraction * m_samples.size()));
+
+	return m_samples[rank == 0 ? 0 : rank - 1];
+}
+
+Int64 LatencySamples::max() const
+{
+	return percentile(1);
+}
+
+void LatencySamples::clear()
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	m_samples.clear();
+	m_sorted = true;
+}
+
+void LatencySamples::print(JSON::PrintHandler &json) const
+{
+	json.startObject();
+	json.key("count");
+	json.value(static_cast<UInt64>(count()));
+	json.key("p50");
+	json.value(percentile(0.5));
+	json.key("p99");
+	json.value(percentile(0.99));
+	json.key("p999");
+	json.value(percentile(0.999));
+	json.key("max");
+	json.value(max());
+	json.endObject();
+}
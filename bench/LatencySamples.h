@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include <Poco/Mutex.h>
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+#include <Poco/JSON/PrintHandler.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Thread-safe collection of latency samples. All samples
+ * are kept in memory so the percentiles are exact. It is intended
+ * for benchmarks only where the number of samples is bounded.
+ */
+class LatencySamples {
+public:
+	LatencySamples(size_t expected = 0);
+	LatencySamples(const LatencySamples &other);
+
+	LatencySamples &operator =(const LatencySamples &other);
+
+	void add(const Poco::Timespan &latency);
+
+	size_t count() const;
+
+	/**
+	 * @returns latency (in microseconds) below which the given
+	 * fraction (0..1) of samples falls. If there are no samples,
+	 * returns -1.
+	 */
+	Poco::Int64 percentile(double fraction) const;
+
+	Poco::Int64 max() const;
+
+	void clear();
+
+	/**
+	 * Print count, p50, p99, p999 and max as a JSON object.
+	 */
+	void print(Poco::JSON::PrintHandler &json) const;
+
+private:
+	mutable Poco::FastMutex m_lock;
+	mutable std::vector<Poco::Int64> m_samples;
+	mutable bool m_sorted;
+};
+
+}
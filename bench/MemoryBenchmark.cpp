@@ -0,0 +1,336 @@
+#include <algorithm>
+#include <deque>
+#include <set>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/Process.h>
+#include <Poco/JSON/PrintHandler.h>
+
+#include "MemoryBenchmark.h"
+#include "ProcessStats.h"
+#include "core/AnswerQueue.h"
+#include "exporters/JournalQueuingStrategy.h"
+#include "gwmessage/GWSensorDataExport.h"
+#include "model/DevicePrefix.h"
+#include "model/GlobalID.h"
+#include "model/ModuleType.h"
+#include "server/GWContextPoll.h"
+#include "server/GWMessageContext.h"
+#include "util/LambdaTimerTask.h"
+#include "vdev/VirtualDevice.h"
+#include "vdev/VirtualModule.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+static const size_t BATCH_SIZE = 100;
+static const size_t IN_FLIGHT = 10;
+static const unsigned int COMMAND_PERIOD_SECS = 600;
+static const unsigned int HOUR_SECS = 3600;
+
+/**
+ * Bookkeeping of the benchmark itself is excluded from the check.
+ */
+static const AllocationTag BENCH_TAG("bench");
+static const AllocationTag VDEV_TAG("vdev");
+
+MemoryBenchmark::MemoryBenchmark():
+	m_devices(100),
+	m_hours(24),
+	m_refresh(30 * Timespan::SECONDS),
+	m_outageEvery(6),
+	m_outageDuration(30 * Timespan::MINUTES),
+	m_growthLimit(64 * 1024),
+	m_workDir(Path::temp()),
+	m_records(0),
+	m_commands(0),
+	m_residentKB(-1)
+{
+}
+
+void MemoryBenchmark::setDevices(unsigned int devices)
+{
+	if (devices == 0)
+		throw InvalidArgumentException("devices must be positive");
+
+	m_devices = devices;
+}
+
+void MemoryBenchmark::setHours(unsigned int hours)
+{
+	if (hours < 2)
+		throw InvalidArgumentException("at least 2 hours must be simulated");
+
+	m_hours = hours;
+}
+
+void MemoryBenchmark::setRefresh(const Timespan &refresh)
+{
+	if (refresh.totalSeconds() <= 0)
+		throw InvalidArgumentException("refresh must be at least 1 second");
+
+	m_refresh = refresh;
+}
+
+void MemoryBenchmark::setOutageEvery(unsigned int hours)
+{
+	m_outageEvery = hours;
+}
+
+void MemoryBenchmark::setOutageDuration(const Timespan &duration)
+{
+	m_outageDuration = duration;
+}
+
+void MemoryBenchmark::setGrowthLimit(Int64 bytes)
+{
+	m_growthLimit = bytes;
+}
+
+void MemoryBenchmark::setWorkDir(const string &dir)
+{
+	m_workDir = dir;
+}
+
+static VirtualDevice::Ptr createDevice(unsigned int i, const Timespan &refresh)
+{
+	VirtualDevice::Ptr device = new VirtualDevice;
+	device->setDeviceId(DeviceID(DevicePrefix::PREFIX_VIRTUAL_DEVICE, i));
+	device->setRefresh(refresh);
+	device->setVendorName("BeeeOn");
+	device->setProductName("Memory Benchmark");
+
+	VirtualModule::Ptr temperature = new VirtualModule(ModuleType::parse("temperature"));
+	temperature->setModuleID(ModuleID(0));
+	temperature->setMin(-20);
+	temperature->setMax(40);
+	temperature->setGenerator("sin");
+	device->addModule(temperature);
+
+	VirtualModule::Ptr humidity = new VirtualModule(ModuleType::parse("humidity"));
+	humidity->setModuleID(ModuleID(1));
+	humidity->setGenerator("random");
+	device->addModule(humidity);
+
+	return device;
+}
+
+static void exportData(
+		GWContextPoll &contexts,
+		deque<GlobalID> &unconfirmed,
+		const vector<SensorData> &data)
+{
+	for (const auto &one : data) {
+		GWSensorDataExport::Ptr message = new GWSensorDataExport;
+		GWSensorDataExportContext::Ptr context = new GWSensorDataExportContext;
+
+		message->setID(GlobalID::random());
+		message->setData({one});
+
+		context->setMessage(message);
+		context->setMissingResponseTask(new LambdaTimerTask([]() {}));
+
+		contexts.insert(context);
+		unconfirmed.emplace_back(context->id());
+	}
+
+	// the server confirms exports with a short lag
+	while (unconfirmed.size() > IN_FLIGHT) {
+		contexts.remove(unconfirmed.front());
+		unconfirmed.pop_front();
+	}
+}
+
+void MemoryBenchmark::run()
+{
+	if (!AllocationTracker::enabled()) {
+		throw IllegalStateException(
+			"allocation tracking is not built in, configure with ENABLE_ALLOC_TRACKING");
+	}
+
+	m_records = 0;
+	m_commands = 0;
+	m_hourly.clear();
+	m_unbounded.clear();
+
+	Path path(m_workDir);
+	path.makeDirectory();
+	path.pushDirectory("gateway-bench-" + to_string(Process::id()) + "-memory");
+
+	File dir(path);
+	dir.createDirectories();
+
+	{
+		vector<VirtualDevice::Ptr> devices;
+		for (unsigned int i = 0; i < m_devices; ++i)
+			devices.emplace_back(createDevice(i, m_refresh));
+
+		JournalQueuingStrategy journal;
+		journal.setRootDir(Path(path, "journal").toString());
+		journal.setup();
+
+		GWContextPoll contexts;
+		AnswerQueue answers;
+		deque<GlobalID> unconfirmed;
+		vector<SensorData> pending;
+		vector<SensorData> batch;
+
+		const unsigned int refresh = m_refresh.totalSeconds();
+		const unsigned int outagePeriod = m_outageEvery * HOUR_SECS;
+		const unsigned int outageSecs = m_outageDuration.totalSeconds();
+		bool wasOnline = true;
+
+		{
+			AllocationScope scope(BENCH_TAG);
+			m_hourly.reserve(m_hours + 1);
+			m_hourly.emplace_back(AllocationTracker::snapshot());
+		}
+
+		logger().information(
+			"simulating " + to_string(m_hours) + " hours of "
+			+ to_string(m_devices) + " devices",
+			__FILE__, __LINE__);
+
+		for (unsigned int t = 0; t < m_hours * HOUR_SECS; ++t) {
+			const bool online = outagePeriod == 0
+				|| t % outagePeriod < outagePeriod - min(outageSecs, outagePeriod);
+
+			if (wasOnline && !online) {
+				// the connector forgets its contexts on disconnect
+				contexts.clear();
+				unconfirmed.clear();
+			}
+
+			wasOnline = online;
+
+			for (unsigned int i = 0; i < m_devices; ++i) {
+				if ((t + i) % refresh != 0)
+					continue;
+
+				AllocationScope scope(VDEV_TAG);
+				pending.emplace_back(devices[i]->generate());
+				m_records += 1;
+			}
+
+			if (pending.size() >= BATCH_SIZE) {
+				journal.push(pending);
+				pending.clear();
+			}
+
+			while (online && !journal.empty()) {
+				batch.clear();
+				const size_t count = journal.peek(batch, BATCH_SIZE);
+
+				exportData(contexts, unconfirmed, batch);
+				journal.pop(count);
+			}
+
+			if (t % COMMAND_PERIOD_SECS == 0) {
+				Answer::Ptr answer = answers.newAnswer();
+				answers.remove(answer);
+				m_commands += 1;
+			}
+
+			if ((t + 1) % HOUR_SECS == 0) {
+				AllocationScope scope(BENCH_TAG);
+				m_hourly.emplace_back(AllocationTracker::snapshot());
+			}
+		}
+
+		m_residentKB = ProcessStats::residentKB();
+	}
+
+	dir.remove(true);
+
+	set<string> tags;
+	for (const auto &snapshot : m_hourly) {
+		for (const auto &pair : snapshot.tags())
+			tags.emplace(pair.first);
+	}
+
+	const size_t half = m_hourly.size() / 2;
+
+	for (const auto &tag : tags) {
+		if (tag == BENCH_TAG.name())
+			continue;
+
+		const Int64 first = maxLiveBytes(tag, 0, half);
+		const Int64 second = maxLiveBytes(tag, half, m_hourly.size());
+
+		if (second > first + m_growthLimit) {
+			logger().warning(
+				"live bytes of " + tag + " grew from " + to_string(first)
+				+ " to " + to_string(second),
+				__FILE__, __LINE__);
+
+			m_unbounded.emplace_back(tag);
+		}
+	}
+}
+
+Int64 MemoryBenchmark::maxLiveBytes(const string &tag, size_t from, size_t to) const
+{
+	Int64 result = 0;
+
+	for (size_t i = from; i < to; ++i)
+		result = max(result, m_hourly[i].stats(tag).liveBytes());
+
+	return result;
+}
+
+bool MemoryBenchmark::bounded() const
+{
+	return m_unbounded.empty();
+}
+
+void MemoryBenchmark::report(ostream &out) const
+{
+	PrintHandler json(out);
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("memory"));
+	json.key("devices");
+	json.value(m_devices);
+	json.key("hours");
+	json.value(m_hours);
+	json.key("records");
+	json.value(m_records);
+	json.key("commands");
+	json.value(m_commands);
+	json.key("rss_kb");
+	json.value(m_residentKB);
+	json.key("bounded");
+	json.value(bounded());
+
+	json.key("unbounded_tags");
+	json.startArray();
+	for (const auto &tag : m_unbounded)
+		json.value(tag);
+	json.endArray();
+
+	json.key("live_bytes_hourly");
+	json.startObject();
+
+	if (!m_hourly.empty()) {
+		for (const auto &pair : m_hourly.back().tags()) {
+			json.key(pair.first);
+			json.startArray();
+
+			for (const auto &snapshot : m_hourly)
+				json.value(snapshot.stats(pair.first).liveBytes());
+
+			json.endArray();
+		}
+	}
+
+	json.endObject();
+
+	json.endObject();
+	out << endl;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "util/AllocationTracker.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Stress test of memory usage of long-running gateways.
+ * A population of VirtualDevice instances generates data over
+ * a simulated period (24 hours by default) without waiting for
+ * the real time to pass. The data flow through the structures
+ * suspected of slow heap growth:
+ *
+ * - JournalQueuingStrategy (push, peek, pop),
+ * - GWContextPoll holding contexts of unconfirmed exports,
+ * - AnswerQueue of commands dispatched periodically.
+ *
+ * The server is periodically unreachable for a while so the journal
+ * accumulates data and drains them afterwards, like in the field.
+ *
+ * After each simulated hour, a snapshot of the AllocationTracker
+ * is taken. The memory is considered bounded when the maximal live
+ * bytes of each tag during the second half of the run do not exceed
+ * the maximum of the first half by more than the configured limit.
+ *
+ * Allocation tracking must be built in by ENABLE_ALLOC_TRACKING.
+ */
+class MemoryBenchmark : protected Loggable {
+public:
+	MemoryBenchmark();
+
+	void setDevices(unsigned int devices);
+	void setHours(unsigned int hours);
+	void setRefresh(const Poco::Timespan &refresh);
+
+	/**
+	 * Every given number of hours, the server becomes unreachable
+	 * for the outage duration. Zero disables outages.
+	 */
+	void setOutageEvery(unsigned int hours);
+	void setOutageDuration(const Poco::Timespan &duration);
+
+	/**
+	 * Allowed growth of live bytes of a tag between the first
+	 * and the second half of the run.
+	 */
+	void setGrowthLimit(Poco::Int64 bytes);
+
+	void setWorkDir(const std::string &dir);
+
+	void run();
+
+	/**
+	 * @returns true when the memory usage of all tags was bounded
+	 * during the last run
+	 */
+	bool bounded() const;
+
+	void report(std::ostream &out) const;
+
+private:
+	Poco::Int64 maxLiveBytes(
+		const std::string &tag, size_t from, size_t to) const;
+
+private:
+	unsigned int m_devices;
+	unsigned int m_hours;
+	Poco::Timespan m_refresh;
+	unsigned int m_outageEvery;
+	Poco::Timespan m_outageDuration;
+	Poco::Int64 m_growthLimit;
+	std::string m_workDir;
+
+	Poco::UInt64 m_records;
+	Poco::UInt64 m_commands;
+	std::vector<AllocationSnapshot> m_hourly;
+	std::vector<std::string> m_unbounded;
+	Poco::Int64 m_residentKB;
+};
+
+}
@@ -0,0 +1,92 @@
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <Poco/Exception.h>
+
+#include "PipeReader.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const int POLL_TIMEOUT_MS = 100;
+static const size_t READ_BUFFER_SIZE = 64 * 1024;
+
+PipeReader::PipeReader(const string &path, BenchmarkSink::Ptr sink):
+	m_path(path),
+	m_sink(sink),
+	m_fd(-1)
+{
+}
+
+PipeReader::~PipeReader()
+{
+	if (m_fd >= 0)
+		::close(m_fd);
+
+	::unlink(m_path.c_str());
+}
+
+void PipeReader::open()
+{
+	if (::mkfifo(m_path.c_str(), S_IRUSR | S_IWUSR) < 0 && errno != EEXIST)
+		throw IOException("failed to create fifo " + m_path + ": " + strerror(errno));
+
+	m_fd = ::open(m_path.c_str(), O_RDWR | O_NONBLOCK);
+	if (m_fd < 0)
+		throw IOException("failed to open fifo " + m_path + ": " + strerror(errno));
+}
+
+void PipeReader::run()
+{
+	char buffer[READ_BUFFER_SIZE];
+	string pending;
+
+	while (!m_stop) {
+		struct pollfd pfd = {m_fd, POLLIN, 0};
+
+		const int ret = ::poll(&pfd, 1, POLL_TIMEOUT_MS);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			throw IOException("failed to poll fifo: " + string(strerror(errno)));
+		if (ret == 0)
+			continue;
+
+		const ssize_t len = ::read(m_fd, buffer, sizeof(buffer));
+		if (len < 0 && (errno == EAGAIN || errno == EINTR))
+			continue;
+		if (len < 0)
+			throw IOException("failed to read fifo: " + string(strerror(errno)));
+
+		pending.append(buffer, len);
+
+		size_t begin = 0;
+		size_t end;
+
+		while ((end = pending.find('\n', begin)) != string::npos) {
+			processLine(pending.substr(begin, end - begin));
+			begin = end + 1;
+		}
+
+		pending.erase(0, begin);
+	}
+}
+
+void PipeReader::processLine(const string &line)
+{
+	if (line.empty())
+		return;
+
+	m_sink->delivered(m_parser.parse(line), line.size() + 1);
+}
+
+void PipeReader::stop()
+{
+	m_stop = 1;
+}
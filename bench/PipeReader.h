@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Runnable.h>
+
+#include "BenchmarkSink.h"
+#include "util/JSONSensorDataParser.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Local consumer of a named pipe fed by the NamedPipeExporter.
+ * The pipe is created and kept open for reading and writing so that
+ * the exporter always finds a reader and never sees an EOF. Each line
+ * is parsed as JSON SensorData and reported to the BenchmarkSink.
+ */
+class PipeReader : public Poco::Runnable {
+public:
+	PipeReader(const std::string &path, BenchmarkSink::Ptr sink);
+	~PipeReader();
+
+	void open();
+	void run() override;
+	void stop();
+
+private:
+	void processLine(const std::string &line);
+
+private:
+	std::string m_path;
+	BenchmarkSink::Ptr m_sink;
+	JSONSensorDataParser m_parser;
+	int m_fd;
+	Poco::AtomicCounter m_stop;
+};
+
+}
@@ -0,0 +1,419 @@
+#include <algorithm>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/Process.h>
+#include <Poco/Random.h>
+#include <Poco/Thread.h>
+#include <Poco/JSON/PrintHandler.h>
+
+#include "BenchmarkQueuingExporter.h"
+#include "BenchmarkSink.h"
+#include "GWMessageSensorDataFormatter.h"
+#include "PipeReader.h"
+#include "PipelineBenchmark.h"
+#include "ProcessStats.h"
+#include "core/BasicDistributor.h"
+#include "core/QueuingDistributor.h"
+#include "exporters/InMemoryQueuingStrategy.h"
+#include "exporters/JournalQueuingStrategy.h"
+#include "exporters/NamedPipeExporter.h"
+#include "exporters/RecoverableJournalQueuingStrategy.h"
+#include "model/DevicePrefix.h"
+#include "model/SensorData.h"
+#include "util/CSVSensorDataFormatter.h"
+#include "util/JSONSensorDataFormatter.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+static const Timespan DRAIN_POLL = 10 * Timespan::MILLISECONDS;
+
+struct PipelineBenchmark::Pipeline {
+	SensorDataFormatter::Ptr formatter;
+	BenchmarkSink::Ptr sink;
+	SharedPtr<Exporter> exporter;
+	SharedPtr<PipeReader> reader;
+	BenchmarkQueuingExporter::Ptr queuing;
+	SharedPtr<Distributor> distributor;
+	SharedPtr<QueuingDistributor> queuingDistributor;
+
+	Thread readerThread;
+	Thread queuingThread;
+	Thread distributorThread;
+};
+
+PipelineBenchmark::PipelineBenchmark():
+	m_distributor("basic"),
+	m_exporter("csv"),
+	m_producers(1),
+	m_devices(100),
+	m_records(100000),
+	m_rate(0),
+	m_batchSize(100),
+	m_saveThreshold(1000),
+	m_workDir(Path::temp()),
+	m_drainTimeout(5 * Timespan::SECONDS),
+	m_delivered(0),
+	m_sinkBytes(0),
+	m_writtenBytes(-1),
+	m_residentKB(-1),
+	m_peakResidentKB(-1)
+{
+}
+
+vector<string> PipelineBenchmark::distributors()
+{
+	return {"basic", "queuing"};
+}
+
+vector<string> PipelineBenchmark::exporters()
+{
+	return {
+		"csv",
+		"mqtt",
+		"gwmessage",
+		"namedpipe",
+		"queuing-inmemory",
+		"queuing-journal",
+		"queuing-recoverable-journal",
+	};
+}
+
+void PipelineBenchmark::setDistributor(const string &name)
+{
+	const auto &all = distributors();
+
+	if (find(all.begin(), all.end(), name) == all.end())
+		throw InvalidArgumentException("unsupported distributor: " + name);
+
+	m_distributor = name;
+}
+
+void PipelineBenchmark::setExporter(const string &name)
+{
+	const auto &all = exporters();
+
+	if (find(all.begin(), all.end(), name) == all.end())
+		throw InvalidArgumentException("unsupported exporter: " + name);
+
+	m_exporter = name;
+}
+
+void PipelineBenchmark::setProducers(unsigned int producers)
+{
+	if (producers == 0)
+		throw InvalidArgumentException("there must be at least 1 producer");
+
+	m_producers = producers;
+}
+
+void PipelineBenchmark::setDevices(unsigned int devices)
+{
+	if (devices == 0)
+		throw InvalidArgumentException("there must be at least 1 device");
+
+	m_devices = devices;
+}
+
+void PipelineBenchmark::setRecords(size_t records)
+{
+	if (records == 0)
+		throw InvalidArgumentException("there must be at least 1 record");
+
+	m_records = records;
+}
+
+void PipelineBenchmark::setRate(unsigned int rate)
+{
+	m_rate = rate;
+}
+
+void PipelineBenchmark::setBatchSize(size_t batchSize)
+{
+	if (batchSize == 0)
+		throw InvalidArgumentException("batch size must be positive");
+
+	m_batchSize = batchSize;
+}
+
+void PipelineBenchmark::setSaveThreshold(size_t threshold)
+{
+	m_saveThreshold = threshold;
+}
+
+void PipelineBenchmark::setWorkDir(const string &dir)
+{
+	m_workDir = dir;
+}
+
+void PipelineBenchmark::setDrainTimeout(const Timespan &timeout)
+{
+	if (timeout <= 0)
+		throw InvalidArgumentException("drain timeout must be positive");
+
+	m_drainTimeout = timeout;
+}
+
+string PipelineBenchmark::scenarioDir() const
+{
+	Path path(m_workDir);
+	path.makeDirectory();
+	path.pushDirectory(
+		"gateway-bench-" + to_string(Process::id())
+		+ "-" + m_distributor + "-" + m_exporter);
+
+	return path.toString();
+}
+
+void PipelineBenchmark::createExporter(Pipeline &pipeline)
+{
+	if (m_exporter == "csv")
+		pipeline.formatter = new CSVSensorDataFormatter;
+	else if (m_exporter == "mqtt" || m_exporter == "namedpipe")
+		pipeline.formatter = new JSONSensorDataFormatter;
+	else
+		pipeline.formatter = new GWMessageSensorDataFormatter;
+
+	pipeline.sink = new BenchmarkSink(pipeline.formatter, m_latency);
+	pipeline.exporter = pipeline.sink;
+
+	if (m_exporter == "namedpipe") {
+		const string &path = Path(scenarioDir(), "pipe").toString();
+
+		pipeline.reader = new PipeReader(path, pipeline.sink);
+		pipeline.reader->open();
+
+		SharedPtr<NamedPipeExporter> exporter = new NamedPipeExporter;
+		exporter->setFilePath(path);
+		exporter->setFormatter(pipeline.formatter.get());
+
+		pipeline.exporter = exporter;
+		pipeline.readerThread.start(*pipeline.reader);
+		return;
+	}
+
+	QueuingStrategy::Ptr strategy;
+
+	if (m_exporter == "queuing-inmemory") {
+		strategy = new InMemoryQueuingStrategy;
+	}
+	else if (m_exporter == "queuing-journal") {
+		SharedPtr<JournalQueuingStrategy> journal = new JournalQueuingStrategy;
+		journal->setRootDir(Path(scenarioDir(), "journal").toString());
+		journal->setup();
+		strategy = journal;
+	}
+	else if (m_exporter == "queuing-recoverable-journal") {
+		SharedPtr<RecoverableJournalQueuingStrategy> journal =
+			new RecoverableJournalQueuingStrategy;
+		journal->setRootDir(Path(scenarioDir(), "journal").toString());
+		journal->setup();
+		strategy = journal;
+	}
+	else {
+		return;
+	}
+
+	pipeline.queuing = new BenchmarkQueuingExporter(pipeline.sink, m_batchSize);
+	pipeline.queuing->setStrategy(strategy);
+	pipeline.queuing->setSaveThreshold(m_saveThreshold);
+
+	pipeline.exporter = pipeline.queuing;
+	pipeline.queuingThread.start(*pipeline.queuing);
+}
+
+void PipelineBenchmark::createDistributor(Pipeline &pipeline)
+{
+	if (m_distributor == "queuing") {
+		pipeline.queuingDistributor = new QueuingDistributor;
+		pipeline.queuingDistributor->setQueueBatchSize(m_batchSize);
+		pipeline.queuingDistributor->registerExporter(pipeline.exporter);
+
+		pipeline.distributor = pipeline.queuingDistributor;
+		pipeline.distributorThread.start(*pipeline.queuingDistributor);
+	}
+	else {
+		SharedPtr<BasicDistributor> distributor = new BasicDistributor;
+		distributor->registerExporter(pipeline.exporter);
+
+		pipeline.distributor = distributor;
+	}
+}
+
+void PipelineBenchmark::produce(Distributor &distributor)
+{
+	vector<SharedPtr<Thread>> threads;
+
+	for (unsigned int i = 0; i < m_producers; ++i) {
+		SharedPtr<Thread> thread = new Thread("bench-producer-" + to_string(i));
+
+		const size_t records = m_records / m_producers
+			+ (i < m_records % m_producers ? 1 : 0);
+		const Timespan period = m_rate == 0 ? Timespan(0) :
+			Timespan(Timespan::SECONDS * m_producers / m_rate);
+
+		thread->startFunc([this, i, records, period, &distributor]() {
+			Random random;
+			random.seed(i);
+
+			Timestamp next;
+
+			for (size_t n = 0; n < records; ++n) {
+				const unsigned int device = (i + n * m_producers) % m_devices;
+
+				SensorData data;
+				data.setDeviceID(DeviceID(
+					DevicePrefix::PREFIX_VIRTUAL_DEVICE, device));
+				data.insertValue(SensorValue(ModuleID(0), random.nextDouble() * 40));
+				data.insertValue(SensorValue(ModuleID(1), random.nextDouble() * 100));
+				data.insertValue(SensorValue(ModuleID(2), random.next(101)));
+
+				if (period > 0) {
+					next += period;
+
+					const Timestamp now;
+					if (next > now)
+						Thread::sleep((next - now) / 1000);
+				}
+
+				data.setTimestamp(Timestamp());
+				distributor.exportData(data);
+			}
+		});
+
+		threads.emplace_back(thread);
+	}
+
+	for (auto thread : threads)
+		thread->join();
+}
+
+void PipelineBenchmark::drain(const BenchmarkSink &sink)
+{
+	size_t delivered = sink.deliveredCount();
+	Timestamp lastProgress;
+
+	while (delivered < m_records) {
+		if (lastProgress.isElapsed(m_drainTimeout.totalMicroseconds())) {
+			logger().warning(
+				"delivery stalled, "
+				+ to_string(m_records - delivered) + " records lost",
+				__FILE__, __LINE__);
+			break;
+		}
+
+		Thread::sleep(DRAIN_POLL.totalMilliseconds());
+
+		const size_t current = sink.deliveredCount();
+		if (current != delivered) {
+			delivered = current;
+			lastProgress.update();
+		}
+	}
+
+	m_finished = lastProgress;
+	m_delivered = delivered;
+}
+
+void PipelineBenchmark::run()
+{
+	m_latency.clear();
+	m_writtenBytes = -1;
+
+	File dir(scenarioDir());
+	dir.createDirectories();
+
+	{
+		Pipeline pipeline;
+		createExporter(pipeline);
+		createDistributor(pipeline);
+
+		const Int64 writtenBefore = ProcessStats::writtenBytes();
+
+		logger().information(
+			"running " + m_distributor + "/" + m_exporter
+			+ " with " + to_string(m_records) + " records",
+			__FILE__, __LINE__);
+
+		m_started.update();
+		produce(*pipeline.distributor);
+		drain(*pipeline.sink);
+
+		const Int64 writtenAfter = ProcessStats::writtenBytes();
+		if (writtenBefore >= 0 && writtenAfter >= 0)
+			m_writtenBytes = writtenAfter - writtenBefore;
+
+		m_sinkBytes = pipeline.sink->deliveredBytes();
+		m_residentKB = ProcessStats::residentKB();
+		m_peakResidentKB = ProcessStats::peakResidentKB();
+
+		if (!pipeline.queuingDistributor.isNull()) {
+			pipeline.queuingDistributor->stop();
+			pipeline.distributorThread.join();
+		}
+
+		if (!pipeline.queuing.isNull()) {
+			pipeline.queuing->stop();
+			pipeline.queuingThread.join();
+		}
+
+		if (!pipeline.reader.isNull()) {
+			pipeline.reader->stop();
+			pipeline.readerThread.join();
+		}
+	}
+
+	dir.remove(true);
+}
+
+void PipelineBenchmark::report(ostream &out) const
+{
+	const double elapsed = (m_finished - m_started) / 1000000.0;
+	const size_t delivered = max<size_t>(m_delivered, 1);
+
+	PrintHandler json(out);
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("pipeline"));
+	json.key("distributor");
+	json.value(m_distributor);
+	json.key("exporter");
+	json.value(m_exporter);
+	json.key("producers");
+	json.value(m_producers);
+	json.key("devices");
+	json.value(m_devices);
+	json.key("rate");
+	json.value(m_rate);
+	json.key("records");
+	json.value(static_cast<UInt64>(m_records));
+	json.key("delivered");
+	json.value(static_cast<UInt64>(m_delivered));
+	json.key("elapsed_us");
+	json.value(static_cast<Int64>(m_finished - m_started));
+	json.key("records_per_sec");
+	json.value(elapsed > 0 ? m_delivered / elapsed : 0.0);
+
+	json.key("latency_us");
+	m_latency.print(json);
+
+	json.key("rss_kb");
+	json.value(m_residentKB);
+	json.key("peak_rss_kb");
+	json.value(m_peakResidentKB);
+	json.key("bytes_written");
+	json.value(m_writtenBytes);
+	json.key("bytes_written_per_record");
+	json.value(m_writtenBytes < 0 ? -1.0 : m_writtenBytes / double(delivered));
+	json.key("sink_bytes_per_record");
+	json.value(m_sinkBytes / double(delivered));
+
+	json.endObject();
+	out << endl;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Types.h>
+
+#include "LatencySamples.h"
+#include "core/Distributor.h"
+#include "core/Exporter.h"
+#include "util/Loggable.h"
+#include "util/SensorDataFormatter.h"
+
+namespace BeeeOn {
+
+class BenchmarkSink;
+
+/**
+ * @brief Benchmark of the data path of the gateway:
+ *
+ *   producers -> Distributor -> Exporter(s) -> (strategy/journal) -> sink
+ *
+ * Producers behave like the VirtualDeviceManager, they generate
+ * SensorData of a configured set of devices and hand them over
+ * to the distributor. The timestamp of each SensorData is set
+ * just before it is shipped and the sink measures the latency
+ * of the whole path against it.
+ *
+ * Supported distributors:
+ *
+ * - basic - BasicDistributor
+ * - queuing - QueuingDistributor
+ *
+ * Supported exporters (all against local stand-ins):
+ *
+ * - csv - CSV formatting only
+ * - mqtt - JSON formatting as done by the MosquittoExporter
+ * - gwmessage - GWSensorDataExport serialization as done by
+ *   the GWServerConnector
+ * - namedpipe - NamedPipeExporter with a local reader
+ * - queuing-inmemory, queuing-journal, queuing-recoverable-journal -
+ *   QueuingExporter with the appropriate QueuingStrategy that
+ *   passes batches to the gwmessage sink
+ *
+ * The result is printed as a single-line JSON object.
+ */
+class PipelineBenchmark : protected Loggable {
+public:
+	PipelineBenchmark();
+
+	static std::vector<std::string> distributors();
+	static std::vector<std::string> exporters();
+
+	void setDistributor(const std::string &name);
+	void setExporter(const std::string &name);
+	void setProducers(unsigned int producers);
+	void setDevices(unsigned int devices);
+	void setRecords(size_t records);
+
+	/**
+	 * Total rate of generated records per second (all producers).
+	 * Zero means to generate data as fast as possible.
+	 */
+	void setRate(unsigned int rate);
+
+	void setBatchSize(size_t batchSize);
+	void setSaveThreshold(size_t threshold);
+
+	/**
+	 * Directory where the fifos and journals are created.
+	 */
+	void setWorkDir(const std::string &dir);
+
+	/**
+	 * Maximal time to wait for any progress of delivery after
+	 * the producers finished. Data not delivered until then are
+	 * considered lost.
+	 */
+	void setDrainTimeout(const Poco::Timespan &timeout);
+
+	void run();
+
+	/**
+	 * Write results of the last run as a single line JSON object.
+	 */
+	void report(std::ostream &out) const;
+
+private:
+	struct Pipeline;
+
+	void createExporter(Pipeline &pipeline);
+	void createDistributor(Pipeline &pipeline);
+	void produce(Distributor &distributor);
+	void drain(const BenchmarkSink &sink);
+	std::string scenarioDir() const;
+
+private:
+	std::string m_distributor;
+	std::string m_exporter;
+	unsigned int m_producers;
+	unsigned int m_devices;
+	size_t m_records;
+	unsigned int m_rate;
+	size_t m_batchSize;
+	size_t m_saveThreshold;
+	std::string m_workDir;
+	Poco::Timespan m_drainTimeout;
+
+	LatencySamples m_latency;
+	Poco::Timestamp m_started;
+	Poco::Timestamp m_finished;
+	size_t m_delivered;
+	Poco::UInt64 m_sinkBytes;
+	Poco::Int64 m_writtenBytes;
+	Poco::Int64 m_residentKB;
+	Poco::Int64 m_peakResidentKB;
+};
+
+}
@@ -0,0 +1,48 @@
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include "ProcessStats.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static Int64 readKeyValue(const string &path, const string &key)
+{
+	ifstream in(path);
+	string name;
+	Int64 value;
+
+	while (in >> name) {
+		if (name == key && in >> value)
+			return value;
+
+		in.ignore(1024, '\n');
+	}
+
+	return -1;
+}
+
+Int64 ProcessStats::residentKB()
+{
+	ifstream in("/proc/self/statm");
+	Int64 size;
+	Int64 resident;
+
+	if (!(in >> size >> resident))
+		return -1;
+
+	return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+}
+
+Int64 ProcessStats::peakResidentKB()
+{
+	return readKeyValue("/proc/self/status", "VmHWM:");
+}
+
+Int64 ProcessStats::writtenBytes()
+{
+	return readKeyValue("/proc/self/io", "wchar:");
+}
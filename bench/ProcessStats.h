@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Resource usage of the current process as reported
+ * by the Linux procfs. Values that cannot be determined are
+ * reported as -1.
+ */
+class ProcessStats {
+public:
+	/**
+	 * @returns current resident set size in kB.
+	 */
+	static Poco::Int64 residentKB();
+
+	/**
+	 * @returns peak resident set size (VmHWM) in kB.
+	 */
+	static Poco::Int64 peakResidentKB();
+
+	/**
+	 * @returns number of bytes passed to write(2) and similar
+	 * syscalls by this process so far (wchar of /proc/self/io).
+	 * It covers writes into files, pipes and sockets alike.
+	 */
+	static Poco::Int64 writtenBytes();
+};
+
+}
@@ -0,0 +1,324 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <Poco/Exception.h>
+#include <Poco/JSON/PrintHandler.h>
+#include <Poco/Runnable.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Thread.h>
+
+#include "SerialBenchmark.h"
+#include "io/SerialFraming.h"
+#include "io/SerialReactor.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace Poco::JSON;
+using namespace std;
+
+static const SerialChannel::Settings SETTINGS(57600);
+static const Timespan POLL_TIMEOUT = 100 * Timespan::MILLISECONDS;
+
+namespace BeeeOn {
+
+/**
+ * Reader of a single serial port as performed by a dedicated I/O
+ * thread, it serves as a baseline for the SerialReactor.
+ */
+class SerialPortReader : public Runnable {
+public:
+	SerialPortReader(SerialChannel::Ptr channel, const atomic<bool> &stop):
+		m_channel(channel),
+		m_stop(stop),
+		m_buffer(1024)
+	{
+	}
+
+	void run() override
+	{
+		while (!m_stop) {
+			struct pollfd pfd = {m_channel->fd(), POLLIN, 0};
+
+			const int ret = ::poll(&pfd, 1, POLL_TIMEOUT.totalMilliseconds());
+			if (ret < 0 && errno != EINTR)
+				throw IOException("poll failed: " + string(::strerror(errno)));
+
+			if (ret > 0 && (pfd.revents & POLLIN))
+				m_channel->receive(m_buffer.data(), m_buffer.size());
+		}
+	}
+
+private:
+	SerialChannel::Ptr m_channel;
+	const atomic<bool> &m_stop;
+	vector<char> m_buffer;
+};
+
+}
+
+SerialBenchmark::SerialBenchmark():
+	m_io("reactor"),
+	m_portCount(1),
+	m_records(100000),
+	m_recordSize(100),
+	m_rate(0),
+	m_drainTimeout(5 * Timespan::SECONDS),
+	m_received(0),
+	m_bytes(0)
+{
+}
+
+SerialBenchmark::~SerialBenchmark()
+{
+	closePorts();
+}
+
+void SerialBenchmark::setIO(const string &io)
+{
+	if (io != "reactor" && io != "threads")
+		throw InvalidArgumentException("unsupported io: " + io);
+
+	m_io = io;
+}
+
+void SerialBenchmark::setPorts(unsigned int ports)
+{
+	if (ports == 0)
+		throw InvalidArgumentException("at least 1 port is required");
+
+	m_portCount = ports;
+}
+
+void SerialBenchmark::setRecords(size_t records)
+{
+	m_records = records;
+}
+
+void SerialBenchmark::setRecordSize(unsigned int size)
+{
+	if (size < 32)
+		throw InvalidArgumentException("record size must be at least 32 B");
+
+	m_recordSize = size;
+}
+
+void SerialBenchmark::setRate(unsigned int rate)
+{
+	m_rate = rate;
+}
+
+void SerialBenchmark::setDrainTimeout(const Timespan &timeout)
+{
+	m_drainTimeout = timeout;
+}
+
+vector<string> SerialBenchmark::ios()
+{
+	return {"reactor", "threads"};
+}
+
+void SerialBenchmark::openPorts()
+{
+	for (unsigned int i = 0; i < m_portCount; ++i) {
+		const int master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+		if (master < 0)
+			throw IOException("posix_openpt: " + string(::strerror(errno)));
+
+		if (::grantpt(master) < 0 || ::unlockpt(master) < 0) {
+			const int e = errno;
+			::close(master);
+
+			throw IOException("failed to unlock pty: " + string(::strerror(e)));
+		}
+
+		m_ports.push_back({master, ::ptsname(master)});
+	}
+}
+
+void SerialBenchmark::closePorts()
+{
+	for (const auto &port : m_ports)
+		::close(port.master);
+
+	m_ports.clear();
+}
+
+/**
+ * Write all records into the master sides of the pseudo terminals.
+ * Each record has format "\n<sequence> <send time> <padding>\n".
+ */
+void SerialBenchmark::produce()
+{
+	const Timestamp started;
+	string record;
+
+	for (size_t i = 0; i < m_records; ++i) {
+		if (m_rate > 0) {
+			const Timestamp::TimeDiff due = i * Timestamp::TimeDiff(1000000) / m_rate;
+			const Timestamp::TimeDiff ahead = due - started.elapsed();
+
+			if (ahead > 0)
+				Thread::sleep(ahead / 1000);
+		}
+
+		record = "\n" + to_string(i) + " "
+			+ to_string(Timestamp().epochMicroseconds()) + " ";
+		record.append(m_recordSize - record.size() - 1, 'x');
+		record += "\n";
+
+		const int fd = m_ports[i % m_ports.size()].master;
+		size_t written = 0;
+
+		while (written < record.size()) {
+			const ssize_t ret = ::write(fd, record.data() + written, record.size() - written);
+
+			if (ret < 0 && errno == EINTR)
+				continue;
+			if (ret < 0)
+				throw IOException("write to pty failed: " + string(::strerror(errno)));
+
+			written += ret;
+		}
+	}
+}
+
+void SerialBenchmark::received(const string &frame)
+{
+	const char *sent = ::strchr(frame.c_str(), ' ');
+	if (sent == nullptr)
+		return;
+
+	const Int64 latency = Timestamp().epochMicroseconds() - ::strtoll(sent + 1, nullptr, 10);
+	m_latency.add(Timespan(latency));
+	m_bytes += frame.size() + 2;
+
+	if (++m_received == m_records)
+		m_done.set();
+}
+
+void SerialBenchmark::runReactor()
+{
+	SerialReactor reactor;
+	vector<SerialChannel::Ptr> channels;
+
+	for (const auto &port : m_ports) {
+		channels.push_back(reactor.open(
+			port.slave,
+			SETTINGS,
+			new DelimitedSerialFraming('\n'),
+			[&](const string &frame) {
+				received(frame);
+			}));
+	}
+
+	Thread thread;
+	thread.start(reactor);
+
+	m_started.update();
+	produce();
+	m_done.tryWait(m_drainTimeout.totalMilliseconds());
+	m_finished.update();
+
+	reactor.stop();
+	thread.join();
+
+	for (auto channel : channels)
+		reactor.close(channel);
+}
+
+void SerialBenchmark::runThreads()
+{
+	atomic<bool> stop(false);
+	vector<SharedPtr<SerialPortReader>> readers;
+	vector<SharedPtr<Thread>> threads;
+
+	for (const auto &port : m_ports) {
+		SerialChannel::Ptr channel = new SerialChannel(
+			SerialChannel::openPort(port.slave, SETTINGS),
+			port.slave,
+			new DelimitedSerialFraming('\n'),
+			[&](const string &frame) {
+				received(frame);
+			},
+			{});
+
+		readers.push_back(new SerialPortReader(channel, stop));
+		threads.push_back(new Thread);
+		threads.back()->start(*readers.back());
+	}
+
+	m_started.update();
+	produce();
+	m_done.tryWait(m_drainTimeout.totalMilliseconds());
+	m_finished.update();
+
+	stop = true;
+
+	for (auto thread : threads)
+		thread->join();
+}
+
+void SerialBenchmark::run()
+{
+	m_received = 0;
+	m_bytes = 0;
+	m_latency.clear();
+	m_done.reset();
+
+	openPorts();
+
+	if (m_io == "reactor")
+		runReactor();
+	else
+		runThreads();
+
+	closePorts();
+
+	if (m_received < m_records) {
+		logger().warning("received only " + to_string(m_received)
+			+ " of " + to_string(m_records) + " records",
+			__FILE__, __LINE__);
+	}
+}
+
+void SerialBenchmark::report(ostream &out) const
+{
+	PrintHandler json(out);
+	const double elapsed = (m_finished - m_started) / 1000000.0;
+
+	json.startObject();
+
+	json.key("benchmark");
+	json.value(string("serial"));
+	json.key("io");
+	json.value(m_io);
+	json.key("ports");
+	json.value(m_portCount);
+	json.key("io_threads");
+	json.value(m_io == "reactor" ? 1U : m_portCount);
+	json.key("records");
+	json.value(static_cast<UInt64>(m_records));
+	json.key("record_size");
+	json.value(m_recordSize);
+	json.key("rate");
+	json.value(m_rate);
+
+	json.key("received");
+	json.value(static_cast<UInt64>(m_received));
+	json.key("elapsed_us");
+	json.value(static_cast<Int64>(m_finished - m_started));
+	json.key("records_per_sec");
+	json.value(elapsed > 0 ? m_received / elapsed : 0.0);
+	json.key("bytes_per_sec");
+	json.value(elapsed > 0 ? m_bytes / elapsed : 0.0);
+	json.key("latency_us");
+	m_latency.print(json);
+
+	json.endObject();
+	out << endl;
+}
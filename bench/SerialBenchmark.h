@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Poco/Event.h>
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Types.h>
+
+#include "LatencySamples.h"
+#include "io/SerialChannel.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Throughput and latency of reading line-framed messages
+ * (as produced by the Turris Dongle) from serial ports. Each serial
+ * port is simulated by a pseudo terminal, the benchmark writes into
+ * the master sides in a round-robin manner and the slave sides are
+ * read either by the SerialReactor (io "reactor", a single thread
+ * for all ports) or by a dedicated thread per port polling its
+ * descriptor (io "threads", as JablotronController does).
+ *
+ * Each message carries its send time, the latency is measured from
+ * writing the message until its frame is delivered to the handler.
+ */
+class SerialBenchmark : protected Loggable {
+public:
+	SerialBenchmark();
+	~SerialBenchmark();
+
+	void setIO(const std::string &io);
+	void setPorts(unsigned int ports);
+	void setRecords(size_t records);
+	void setRecordSize(unsigned int size);
+	void setRate(unsigned int rate);
+	void setDrainTimeout(const Poco::Timespan &timeout);
+
+	void run();
+	void report(std::ostream &out) const;
+
+	static std::vector<std::string> ios();
+
+private:
+	struct Port {
+		int master;
+		std::string slave;
+	};
+
+	void openPorts();
+	void closePorts();
+	void produce();
+	void received(const std::string &frame);
+
+	void runReactor();
+	void runThreads();
+
+private:
+	std::string m_io;
+	unsigned int m_portCount;
+	size_t m_records;
+	unsigned int m_recordSize;
+	unsigned int m_rate;
+	Poco::Timespan m_drainTimeout;
+
+	std::vector<Port> m_ports;
+	std::atomic<size_t> m_received;
+	std::atomic<Poco::UInt64> m_bytes;
+	Poco::Event m_done;
+	LatencySamples m_latency;
+
+	Poco::Timestamp m_started;
+	Poco::Timestamp m_finished;
+};
+
+}
@@ -0,0 +1,423 @@
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Poco/AutoPtr.h>
+#include <Poco/ConsoleChannel.h>
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/NumberParser.h>
+#include <Poco/Timespan.h>
+
+#ifdef HAVE_HCI
+#include "AdvertisementBenchmark.h"
+#endif
+#include "ConnectorBenchmark.h"
+#include "DataFileBenchmark.h"
+#include "DeadbandBenchmark.h"
+#include "HistorianBenchmark.h"
+#ifdef HAVE_JABLOTRON
+#include "JablotronBenchmark.h"
+#endif
+#ifdef HAVE_VDEV
+#include "MemoryBenchmark.h"
+#endif
+#include "PipelineBenchmark.h"
+#include "SerialBenchmark.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static void usage(const char *name)
+{
+	cerr << "Usage: " << name << " [options]" << endl
+		<< endl
+		<< "Benchmarks of the gateway data path. Each scenario" << endl
+		<< "prints one line of JSON with its results." << endl
+		<< endl
+		<< "  --benchmark NAME     pipeline, connector, datafile, memory," << endl
+		<< "                       advertisement, jablotron, serial," << endl
+		<< "                       historian or deadband" << endl
+		<< "                       (default: pipeline)" << endl
+		<< endl
+		<< "Pipeline (device -> distributor -> exporter):" << endl
+		<< "  --distributor NAME   basic, queuing or all (default: all)" << endl
+		<< "  --exporter NAME      csv, mqtt, gwmessage, namedpipe," << endl
+		<< "                       queuing-inmemory, queuing-journal," << endl
+		<< "                       queuing-recoverable-journal or all" << endl
+		<< "                       (default: all)" << endl
+		<< "  --records N          records per scenario (default: 100000)" << endl
+		<< "  --producers N        producer threads (default: 1)" << endl
+		<< "  --devices N          simulated devices (default: 100)" << endl
+		<< "  --rate N             records per second, 0 is unlimited" << endl
+		<< "                       (default: 0)" << endl
+		<< "  --batch N            batch size of queues (default: 100)" << endl
+		<< "  --save-threshold N   QueuingExporter save threshold" << endl
+		<< "                       (default: 1000)" << endl
+		<< "  --drain-timeout MS   wait for delivery progress (default: 5000)" << endl
+		<< "  --work-dir DIR       directory for fifos and journals" << endl
+		<< endl
+		<< "Connector (GWServerConnector -> local server stand-in):" << endl
+		<< "  --records N          records to export (default: 100000)" << endl
+		<< "  --rate N             records per second, 0 is unlimited" << endl
+		<< "  --resend-timeout MS  resend timeout of connector (default: 1000)" << endl
+		<< "  --confirm-delay MS   delay of confirmations (default: 0)" << endl
+		<< "  --confirm-jitter MS  random extra delay (default: 0)" << endl
+		<< "  --loss PERCENT       confirmations never sent (default: 0)" << endl
+		<< "  --disconnect-every N close connection after N exports" << endl
+		<< "                       (default: 0, never)" << endl
+		<< "  --drain-timeout MS   wait for confirmations (default: 5000)" << endl
+		<< endl
+		<< "Datafile (DataWriter -> file -> DataReader):" << endl
+		<< "  --records N          records to write (default: 100000)" << endl
+		<< "  --record-size N      bytes of each record (default: 100)" << endl
+		<< "  --batch N            records per DataWriter::write()" << endl
+		<< "                       (default: 100)" << endl
+		<< "  --work-dir DIR       directory for the data file" << endl
+		<< endl
+		<< "Memory (virtual devices -> journal -> contexts, simulated time):" << endl
+		<< "  --devices N          simulated devices (default: 100)" << endl
+		<< "  --hours N            simulated hours (default: 24)" << endl
+		<< "  --refresh-sec N      refresh of devices (default: 30)" << endl
+		<< "  --outage-every N     hours between server outages, 0 disables" << endl
+		<< "                       (default: 6)" << endl
+		<< "  --outage-min N       duration of outages (default: 30)" << endl
+		<< "  --growth-limit KB    allowed growth of live heap per subsystem" << endl
+		<< "                       (default: 64)" << endl
+		<< "  Requires ENABLE_ALLOC_TRACKING, exits with 2 if unbounded." << endl
+		<< endl
+		<< "Advertisement (HCI events -> LE decoder -> duplicate filter):" << endl
+		<< "  --records N          events to decode (default: 100000)" << endl
+		<< "  --devices N          simulated devices (default: 100)" << endl
+		<< "  --change-every N     advertisements until data of a device" << endl
+		<< "                       change (default: 10)" << endl
+		<< "  --report-interval MS report interval of repeated data" << endl
+		<< "                       (default: 30000)" << endl
+		<< "  --capture FILE       replay events captured by hcidump -R" << endl
+		<< "                       instead of the simulated devices" << endl
+		<< endl
+		<< "Jablotron (report -> gadget resolution -> sensor values):" << endl
+		<< "  --records N          reports to decode (default: 100000)" << endl
+		<< "  --decoder NAME       strings, table or all (default: all)" << endl
+		<< endl
+		<< "Serial (pseudo terminals -> line framing -> handler):" << endl
+		<< "  --io NAME            reactor, threads or all (default: all)" << endl
+		<< "  --ports N            simulated serial ports (default: 1)" << endl
+		<< "  --records N          messages to write (default: 100000)" << endl
+		<< "  --record-size N      bytes of each message (default: 100)" << endl
+		<< "  --rate N             messages per second, 0 is unlimited" << endl
+		<< "  --drain-timeout MS   wait for delivery (default: 5000)" << endl
+		<< endl
+		<< "Historian (simulated devices -> HistorianStore -> queries):" << endl
+		<< "  --devices N          simulated devices with 2 modules each" << endl
+		<< "                       (default: 100)" << endl
+		<< "  --days N             simulated days (default: 365)" << endl
+		<< "  --refresh-sec N      refresh of devices (default: 30)" << endl
+		<< "  --queries N          random 1-day range queries (default: 1000)" << endl
+		<< "  --work-dir DIR       directory for partition files" << endl
+		<< endl
+		<< "Deadband (meters, regulators, bulbs -> DeadbandFilter):" << endl
+		<< "  --devices N          simulated devices (default: 100)" << endl
+		<< "  --records N          records to filter (default: 100000)" << endl
+		<< "  --refresh-sec N      refresh of devices (default: 30)" << endl
+		<< "  --heartbeat-sec N    heartbeat of the filter, 0 disables" << endl
+		<< "                       (default: 900)" << endl
+		<< endl
+		<< "Common:" << endl
+		<< "  --output FILE        append results to FILE instead of stdout" << endl
+		<< "  --log-level LEVEL    logging level (default: warning)" << endl
+		<< endl
+		<< "RSS values are of the whole process, run a single scenario" << endl
+		<< "per process to compare memory usage." << endl;
+}
+
+static unsigned int parseUnsigned(map<string, string> &options, const string &key)
+{
+	return NumberParser::parseUnsigned(options[key]);
+}
+
+static Timespan parseMillis(map<string, string> &options, const string &key)
+{
+	return Timespan(NumberParser::parseUnsigned(options[key]) * Timespan::MILLISECONDS);
+}
+
+static vector<string> select(const string &name, const vector<string> &all)
+{
+	if (name == "all")
+		return all;
+
+	return {name};
+}
+
+static void runPipeline(map<string, string> &options, ostream &out)
+{
+	for (const auto &distributor : select(
+			options["distributor"], PipelineBenchmark::distributors())) {
+		for (const auto &exporter : select(
+				options["exporter"], PipelineBenchmark::exporters())) {
+			PipelineBenchmark benchmark;
+
+			benchmark.setDistributor(distributor);
+			benchmark.setExporter(exporter);
+			benchmark.setRecords(NumberParser::parseUnsigned64(options["records"]));
+			benchmark.setProducers(parseUnsigned(options, "producers"));
+			benchmark.setDevices(parseUnsigned(options, "devices"));
+			benchmark.setRate(parseUnsigned(options, "rate"));
+			benchmark.setBatchSize(parseUnsigned(options, "batch"));
+			benchmark.setSaveThreshold(parseUnsigned(options, "save-threshold"));
+			benchmark.setDrainTimeout(parseMillis(options, "drain-timeout"));
+
+			if (!options["work-dir"].empty())
+				benchmark.setWorkDir(options["work-dir"]);
+
+			benchmark.run();
+			benchmark.report(out);
+		}
+	}
+}
+
+static void runConnector(map<string, string> &options, ostream &out)
+{
+	ConnectorBenchmark benchmark;
+
+	benchmark.setRecords(NumberParser::parseUnsigned64(options["records"]));
+	benchmark.setRate(parseUnsigned(options, "rate"));
+	benchmark.setResendTimeout(parseMillis(options, "resend-timeout"));
+	benchmark.setConfirmDelay(parseMillis(options, "confirm-delay"));
+	benchmark.setConfirmJitter(parseMillis(options, "confirm-jitter"));
+	benchmark.setLossRate(parseUnsigned(options, "loss"));
+	benchmark.setDisconnectEvery(parseUnsigned(options, "disconnect-every"));
+	benchmark.setDrainTimeout(parseMillis(options, "drain-timeout"));
+
+	benchmark.run();
+	benchmark.report(out);
+}
+
+static void runDataFile(map<string, string> &options, ostream &out)
+{
+	DataFileBenchmark benchmark;
+
+	benchmark.setRecords(NumberParser::parseUnsigned64(options["records"]));
+	benchmark.setRecordSize(parseUnsigned(options, "record-size"));
+	benchmark.setBatchSize(parseUnsigned(options, "batch"));
+
+	if (!options["work-dir"].empty())
+		benchmark.setWorkDir(options["work-dir"]);
+
+	benchmark.run();
+	benchmark.report(out);
+}
+
+static void runSerial(map<string, string> &options, ostream &out)
+{
+	for (const auto &io : select(options["io"], SerialBenchmark::ios())) {
+		SerialBenchmark benchmark;
+
+		benchmark.setIO(io);
+		benchmark.setPorts(parseUnsigned(options, "ports"));
+		benchmark.setRecords(NumberParser::parseUnsigned64(options["records"]));
+		benchmark.setRecordSize(parseUnsigned(options, "record-size"));
+		benchmark.setRate(parseUnsigned(options, "rate"));
+		benchmark.setDrainTimeout(parseMillis(options, "drain-timeout"));
+
+		benchmark.run();
+		benchmark.report(out);
+	}
+}
+
+static void runHistorian(map<string, string> &options, ostream &out)
+{
+	HistorianBenchmark benchmark;
+
+	benchmark.setDevices(parseUnsigned(options, "devices"));
+	benchmark.setDays(parseUnsigned(options, "days"));
+	benchmark.setRefresh(parseUnsigned(options, "refresh-sec") * Timespan::SECONDS);
+	benchmark.setQueries(parseUnsigned(options, "queries"));
+
+	if (!options["work-dir"].empty())
+		benchmark.setWorkDir(options["work-dir"]);
+
+	benchmark.run();
+	benchmark.report(out);
+}
+
+static void runDeadband(map<string, string> &options, ostream &out)
+{
+	DeadbandBenchmark benchmark;
+	const unsigned int heartbeat = parseUnsigned(options, "heartbeat-sec");
+
+	benchmark.setDevices(parseUnsigned(options, "devices"));
+	benchmark.setRecords(NumberParser::parseUnsigned64(options["records"]));
+	benchmark.setRefresh(parseUnsigned(options, "refresh-sec") * Timespan::SECONDS);
+	benchmark.setHeartbeat(heartbeat > 0 ? heartbeat * Timespan::SECONDS : -1);
+
+	benchmark.run();
+	benchmark.report(out);
+}
+
+#ifdef HAVE_HCI
+static void runAdvertisement(map<string, string> &options, ostream &out)
+{
+	AdvertisementBenchmark benchmark;
+
+	benchmark.setRecords(NumberParser::parseUnsigned64(options["records"]));
+	benchmark.setDevices(parseUnsigned(options, "devices"));
+	benchmark.setChangeEvery(parseUnsigned(options, "change-every"));
+	benchmark.setReportInterval(parseMillis(options, "report-interval"));
+
+	if (!options["capture"].empty())
+		benchmark.setCapture(options["capture"]);
+
+	benchmark.run();
+	benchmark.report(out);
+}
+#endif
+
+#ifdef HAVE_JABLOTRON
+static void runJablotron(map<string, string> &options, ostream &out)
+{
+	for (const auto &decoder : select(
+			options["decoder"], JablotronBenchmark::decoders())) {
+		JablotronBenchmark benchmark;
+
+		benchmark.setDecoder(decoder);
+		benchmark.setRecords(NumberParser::parseUnsigned64(options["records"]));
+
+		benchmark.run();
+		benchmark.report(out);
+	}
+}
+#endif
+
+#ifdef HAVE_VDEV
+static bool runMemory(map<string, string> &options, ostream &out)
+{
+	MemoryBenchmark benchmark;
+
+	benchmark.setDevices(parseUnsigned(options, "devices"));
+	benchmark.setHours(parseUnsigned(options, "hours"));
+	benchmark.setRefresh(parseUnsigned(options, "refresh-sec") * Timespan::SECONDS);
+	benchmark.setOutageEvery(parseUnsigned(options, "outage-every"));
+	benchmark.setOutageDuration(parseUnsigned(options, "outage-min") * Timespan::MINUTES);
+	benchmark.setGrowthLimit(static_cast<Int64>(parseUnsigned(options, "growth-limit")) * 1024);
+
+	if (!options["work-dir"].empty())
+		benchmark.setWorkDir(options["work-dir"]);
+
+	benchmark.run();
+	benchmark.report(out);
+
+	return benchmark.bounded();
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	map<string, string> options = {
+		{"benchmark", "pipeline"},
+		{"distributor", "all"},
+		{"exporter", "all"},
+		{"records", "100000"},
+		{"producers", "1"},
+		{"devices", "100"},
+		{"rate", "0"},
+		{"batch", "100"},
+		{"save-threshold", "1000"},
+		{"drain-timeout", "5000"},
+		{"work-dir", ""},
+		{"resend-timeout", "1000"},
+		{"confirm-delay", "0"},
+		{"confirm-jitter", "0"},
+		{"loss", "0"},
+		{"disconnect-every", "0"},
+		{"record-size", "100"},
+		{"hours", "24"},
+		{"refresh-sec", "30"},
+		{"outage-every", "6"},
+		{"outage-min", "30"},
+		{"growth-limit", "64"},
+		{"change-every", "10"},
+		{"report-interval", "30000"},
+		{"capture", ""},
+		{"decoder", "all"},
+		{"io", "all"},
+		{"ports", "1"},
+		{"days", "365"},
+		{"queries", "1000"},
+		{"heartbeat-sec", "900"},
+		{"output", ""},
+		{"log-level", "warning"},
+	};
+
+	for (int i = 1; i < argc; ++i) {
+		const string arg(argv[i]);
+
+		if (arg == "-h" || arg == "--help") {
+			usage(argv[0]);
+			return 0;
+		}
+
+		if (arg.compare(0, 2, "--") != 0 || i + 1 >= argc
+				|| options.find(arg.substr(2)) == options.end()) {
+			usage(argv[0]);
+			return 1;
+		}
+
+		options[arg.substr(2)] = argv[++i];
+	}
+
+	AutoPtr<ConsoleChannel> channel(new ConsoleChannel(cerr));
+	Logger::root().setChannel(channel);
+
+	try {
+		Logger::root().setLevel(options["log-level"]);
+
+		ofstream file;
+		if (!options["output"].empty())
+			file.open(options["output"], ios::app);
+
+		ostream &out = file.is_open() ? file : cout;
+
+		if (options["benchmark"] == "pipeline")
+			runPipeline(options, out);
+		else if (options["benchmark"] == "connector")
+			runConnector(options, out);
+		else if (options["benchmark"] == "datafile")
+			runDataFile(options, out);
+		else if (options["benchmark"] == "serial")
+			runSerial(options, out);
+		else if (options["benchmark"] == "historian")
+			runHistorian(options, out);
+		else if (options["benchmark"] == "deadband")
+			runDeadband(options, out);
+#ifdef HAVE_HCI
+		else if (options["benchmark"] == "advertisement")
+			runAdvertisement(options, out);
+#endif
+#ifdef HAVE_JABLOTRON
+		else if (options["benchmark"] == "jablotron")
+			runJablotron(options, out);
+#endif
+#ifdef HAVE_VDEV
+		else if (options["benchmark"] == "memory") {
+			if (!runMemory(options, out))
+				return 2;
+		}
+#endif
+		else
+			throw InvalidArgumentException("unsupported benchmark: " + options["benchmark"]);
+	}
+	catch (const Exception &e) {
+		cerr << e.displayText() << endl;
+		return 1;
+	}
+	catch (const exception &e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -22,6 +22,7 @@ BEEEON_OBJECT_CASTABLE(CommandHandler)
 BEEEON_OBJECT_CASTABLE(DeviceStatusHandler)
 BEEEON_OBJECT_PROPERTY("deviceCache", &BelkinWemoDeviceManager::setDeviceCache)
 BEEEON_OBJECT_PROPERTY("distributor", &BelkinWemoDeviceManager::setDistributor)
+BEEEON_OBJECT_PROPERTY("discoveryExecutor", &BelkinWemoDeviceManager::setDiscoveryExecutor)
 BEEEON_OBJECT_PROPERTY("commandDispatcher", &BelkinWemoDeviceManager::setCommandDispatcher)
 BEEEON_OBJECT_PROPERTY("upnpTimeout", &BelkinWemoDeviceManager::setUPnPTimeout)
 BEEEON_OBJECT_PROPERTY("httpTimeout", &BelkinWemoDeviceManager::setHTTPTimeout)
@@ -191,7 +192,7 @@ void BelkinWemoDeviceManager::handleGeneric(const Command::Ptr cmd, Result::Ptr
 AsyncWork<>::Ptr BelkinWemoDeviceManager::startDiscovery(const Timespan &timeout)
 {
 	BelkinWemoSeeker::Ptr seeker = new BelkinWemoSeeker(*this, timeout);
-	seeker->start();
+	startSeeker(seeker);
 	return seeker;
 }
 
@@ -445,7 +446,7 @@ void BelkinWemoDeviceManager::BelkinWemoSeeker::seekLoop(StopControl &control)
 	Timestamp now;
 	StopControl::Run run(control);
 
-	while (remaining() > 0) {
+	while (nextPass()) {
 		for (auto device : m_parent.seekSwitches(control)) {
 			if (!run)
 				break;
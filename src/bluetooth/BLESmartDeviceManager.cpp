@@ -7,6 +7,7 @@
 #include "bluetooth/BeeWiSmartMotion.h"
 #include "bluetooth/BeeWiSmartWatt.h"
 #include "bluetooth/HciUtil.h"
+#include "bluetooth/RecordingHciInterface.h"
 #include "bluetooth/TabuLumenSmartLite.h"
 #include "bluetooth/RevogiDevice.h"
 #include "commands/NewDeviceCommand.h"
@@ -15,6 +16,7 @@
 #include "hotplug/HotplugEvent.h"
 #include "model/DevicePrefix.h"
 #include "util/BlockingAsyncWork.h"
+#include "util/SamplingProfiler.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, BLESmartDeviceManager)
 BEEEON_OBJECT_CASTABLE(CommandHandler)
@@ -23,6 +25,7 @@ BEEEON_OBJECT_CASTABLE(HotplugListener)
 BEEEON_OBJECT_CASTABLE(DeviceStatusHandler)
 BEEEON_OBJECT_PROPERTY("deviceCache", &BLESmartDeviceManager::setDeviceCache)
 BEEEON_OBJECT_PROPERTY("distributor", &BLESmartDeviceManager::setDistributor)
+BEEEON_OBJECT_PROPERTY("discoveryExecutor", &BLESmartDeviceManager::setDiscoveryExecutor)
 BEEEON_OBJECT_PROPERTY("commandDispatcher", &BLESmartDeviceManager::setCommandDispatcher)
 BEEEON_OBJECT_PROPERTY("hciManager", &BLESmartDeviceManager::setHciManager)
 BEEEON_OBJECT_PROPERTY("scanTimeout", &BLESmartDeviceManager::setScanTimeout)
@@ -30,6 +33,7 @@ BEEEON_OBJECT_PROPERTY("deviceTimeout", &BLESmartDeviceManager::setDeviceTimeout
 BEEEON_OBJECT_PROPERTY("refresh", &BLESmartDeviceManager::setRefresh)
 BEEEON_OBJECT_PROPERTY("attemptsCount", &BLESmartDeviceManager::setAttemptsCount)
 BEEEON_OBJECT_PROPERTY("retryTimeout", &BLESmartDeviceManager::setRetryTimeout)
+BEEEON_OBJECT_PROPERTY("advertisementInterval", &BLESmartDeviceManager::setAdvertisementInterval)
 BEEEON_OBJECT_END(BeeeOn, BLESmartDeviceManager)
 
 using namespace BeeeOn;
@@ -79,6 +83,11 @@ void BLESmartDeviceManager::setRefresh(const Timespan &refresh)
 	m_refresh = refresh;
 }
 
+void BLESmartDeviceManager::setAdvertisementInterval(const Timespan &interval)
+{
+	m_advertisementFilter.setReportInterval(interval);
+}
+
 void BLESmartDeviceManager::setHciManager(HciInterfaceManager::Ptr manager)
 {
 	m_hciManager = manager;
@@ -88,7 +97,7 @@ void BLESmartDeviceManager::dongleAvailable()
 {
 	logger().information("starting BLE Smart device manager", __FILE__, __LINE__);
 
-	m_hci = m_hciManager->lookup(dongleName());
+	m_hci = new RecordingHciInterface(m_hciManager->lookup(dongleName()));
 
 	while (!m_stopControl.shouldStop()) {
 		Timestamp now;
@@ -175,7 +184,7 @@ void BLESmartDeviceManager::eraseAllDevices()
 AsyncWork<>::Ptr BLESmartDeviceManager::startDiscovery(const Timespan &timeout)
 {
 	BLESmartSeeker::Ptr seeker = new BLESmartSeeker(*this, timeout);
-	seeker->start();
+	startSeeker(seeker);
 	return seeker;
 }
 
@@ -198,6 +207,7 @@ AsyncWork<set<DeviceID>>::Ptr BLESmartDeviceManager::startUnpair(
 		if (it != m_devices.end())
 			m_devices.erase(id);
 
+		m_advertisementFilter.forget(MACAddress(id.ident()));
 		work->setResult({id});
 	}
 
@@ -246,6 +256,15 @@ void BLESmartDeviceManager::processAsyncData(
 		const MACAddress& address,
 		std::vector<unsigned char> &data)
 {
+	if (!m_advertisementFilter.accept(address, data.data(), data.size())) {
+		if (logger().trace()) {
+			logger().trace("repeated async message from device " + address.toString(':'),
+				__FILE__, __LINE__);
+		}
+
+		return;
+	}
+
 	logger().information("recieved async message from device " + address.toString(':'),
 		__FILE__, __LINE__);
 
@@ -414,9 +433,11 @@ BLESmartDeviceManager::BLESmartSeeker::BLESmartSeeker(
 
 void BLESmartDeviceManager::BLESmartSeeker::seekLoop(StopControl &control)
 {
+	SamplingProfiler::labelThread("ble-seeker");
+
 	StopControl::Run run(control);
 
-	while (remaining() > 0) {
+	while (nextPass()) {
 		vector<BLESmartDevice::Ptr> newDevices;
 
 		m_parent.seekDevices(newDevices, control);
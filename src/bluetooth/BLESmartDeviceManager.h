@@ -10,6 +10,7 @@
 
 #include "bluetooth/BLESmartDevice.h"
 #include "bluetooth/HciInterface.h"
+#include "bluetooth/LEAdvertisementFilter.h"
 #include "commands/DeviceAcceptCommand.h"
 #include "commands/DeviceSetValueCommand.h"
 #include "core/AbstractSeeker.h"
@@ -75,6 +76,13 @@ public:
 	void setRefresh(const Poco::Timespan &refresh);
 	void setHciManager(HciInterfaceManager::Ptr manager);
 
+	/**
+	 * @brief Set how often the same advertising data of a device
+	 * are shipped. Changed data are always shipped immediately.
+	 * The zero interval ships every received advertisement.
+	 */
+	void setAdvertisementInterval(const Poco::Timespan &interval);
+
 protected:
 	/**
 	 * @brief Wakes up the main thread.
@@ -143,6 +151,7 @@ private:
 	Poco::FastMutex m_devicesMutex;
 	std::map<DeviceID, BLESmartDevice::Ptr> m_devices;
 	Poco::SharedPtr<HciInterface::WatchCallback> m_watchCallback;
+	LEAdvertisementFilter m_advertisementFilter;
 
 	Poco::Timespan m_scanTimeout;
 	Poco::Timespan m_deviceTimeout;
@@ -332,19 +332,24 @@ bool BluetoothAvailabilityManager::enoughTimeForScan(const Timestamp &startTime)
 void BluetoothAvailabilityManager::reportFoundDevices(
 	const int mode, const map<MACAddress, string> &devices)
 {
-	for (const auto &scannedDevice : devices) {
-		DeviceID id;
+	for (const auto &scannedDevice : devices)
+		reportFoundDevice(mode, scannedDevice.first, scannedDevice.second);
+}
 
-		if (mode == MODE_CLASSIC)
-			id = createDeviceID(scannedDevice.first);
-		else if (mode == MODE_LE)
-			id = createLEDeviceID(scannedDevice.first);
-		else
-			return;
+void BluetoothAvailabilityManager::reportFoundDevice(
+	const int mode, const MACAddress &address, const string &name)
+{
+	DeviceID id;
 
-		if (!deviceCache()->paired(id))
-			sendNewDevice(id, scannedDevice.second);
-	}
+	if (mode == MODE_CLASSIC)
+		id = createDeviceID(address);
+	else if (mode == MODE_LE)
+		id = createLEDeviceID(address);
+	else
+		return;
+
+	if (!deviceCache()->paired(id))
+		sendNewDevice(id, name);
 }
 
 void BluetoothAvailabilityManager::listen()
@@ -361,8 +366,11 @@ void BluetoothAvailabilityManager::listen()
 		reportFoundDevices(MODE_LE, m_leScanCache);
 
 	while (enoughTimeForScan(startTime)) {
-		if (m_mode & MODE_CLASSIC)
-			reportFoundDevices(MODE_CLASSIC, hci->scan());
+		if (m_mode & MODE_CLASSIC) {
+			hci->streamScan([&](const MACAddress &address, const string &name) {
+				reportFoundDevice(MODE_CLASSIC, address, name);
+			});
+		}
 		if (m_mode & MODE_LE)
 			reportFoundDevices(MODE_LE, hci->lescan(m_leScanTime));
 	};
@@ -92,6 +92,7 @@ private:
 	bool enoughTimeForScan(const Poco::Timestamp &startTime);
 
 	void reportFoundDevices(const int mode, const std::map<MACAddress, std::string> &devices);
+	void reportFoundDevice(const int mode, const MACAddress &address, const std::string &name);
 
 	void listen();
 
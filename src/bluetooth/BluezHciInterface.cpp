@@ -17,14 +17,14 @@
 
 #include "di/Injectable.h"
 #include "bluetooth/BluezHciInterface.h"
+#include "bluetooth/BluezInquiry.h"
+#include "bluetooth/LEAdvertisement.h"
 #include "io/AutoClose.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, BluezHciInterfaceManager)
 BEEEON_OBJECT_CASTABLE(HciInterfaceManager)
 BEEEON_OBJECT_END(BeeeOn, BluezHciInterfaceManager)
 
-#define EIR_NAME_SHORT 0x08    // shortened local name
-#define EIR_NAME_COMPLETE 0x09  // complete local name
 #define LE_DISABLE 0x00
 #define LE_ENABLE 0x01
 #define LE_FILTER 0x00
@@ -39,8 +39,15 @@ using namespace BeeeOn;
 using namespace Poco;
 using namespace std;
 
-static const int INQUIRY_LENGTH = 8; // ~10 seconds
-static const int MAX_RESPONSES = 255;
+static const uint8_t INQUIRY_MODE_EXTENDED = 0x02; // results with RSSI or EIR
+static const int HCI_TIMEOUT = 1000; // ms
+
+/**
+ * Names resolved by inquiries are remembered for future scans,
+ * the count of remembered names is limited.
+ */
+static const size_t MAX_CACHED_NAMES = 256;
+static BluezNameCache nameCache(MAX_CACHED_NAMES);
 
 namespace BeeeOn {
 
@@ -82,17 +89,6 @@ static void throwFromErrno(const int e, const string &prefix = "")
 		throw IOException(prefix + ": " + ::strerror(e));
 }
 
-static evt_le_meta_event* skipHciEventHdr(char *data, const unsigned &size)
-{
-	if (1 + HCI_EVENT_HDR_SIZE >= size) {
-		throw IllegalStateException(
-			"size of buffer is bigger than 1+HCI_EVENT_HDR_SIZE");
-	}
-
-	char *ptr = data + (1 + HCI_EVENT_HDR_SIZE);
-	return (evt_le_meta_event *) ptr;
-}
-
 int BluezHciInterface::hciSocket() const
 {
 	int sock = ::socket(AF_BLUETOOTH, SOCK_RAW, BTPROTO_HCI);
@@ -224,56 +220,36 @@ bool BluezHciInterface::detect(const MACAddress &address) const
 
 map<MACAddress, string> BluezHciInterface::scan() const
 {
-	const int dev = findHci(m_name);
-
-	logger().debug("starting inquiry", __FILE__, __LINE__);
-
-	inquiry_info *info = NULL;
-
-	const int count = ::hci_inquiry(
-		dev, INQUIRY_LENGTH, MAX_RESPONSES, NULL, &info, IREQ_CACHE_FLUSH);
-	if (count < 0)
-		throwFromErrno(errno);
-
-	logger().debug("received " + to_string(count) + " responses",
-			__FILE__, __LINE__);
-
 	map<MACAddress, string> devices;
 
-	if (count == 0)
-		return devices; // empty
-
-	const int sock = ::hci_open_dev(dev);
-	if (sock < 0)
-		throwFromErrno(errno);
-
-	for (int i = 0; i < count; ++i) {
-		MACAddress address(info[i].bdaddr.b);
+	streamScan([&](const MACAddress &address, const string &name) {
+		devices.emplace(address, name);
+	});
 
-		logger().debug("determine name of device " + address.toString(':'),
-				__FILE__, __LINE__);
+	return devices;
+}
 
-		char name[248];
-		::memset(name, 0, sizeof(name));
+void BluezHciInterface::streamScan(const ScanCallback &callback) const
+{
+	const int dev = findHci(m_name);
+	HciAutoClose sock(::hci_open_dev(dev));
 
-		const int ret = ::hci_read_remote_name(
-			sock, &info[i].bdaddr, sizeof(name), name, 0);
-		if (ret < 0)
-			devices.emplace(address, string("unknown"));
-		else
-			devices.emplace(address, string(name));
+	if (*sock < 0)
+		throwFromErrno(errno, "hci_open_dev(" + m_name + ")");
 
-		logger().debug("detected device "
-				+ address.toString(':')
-				+ " with name "
-				+ string(name),
+	if (::hci_write_inquiry_mode(*sock, INQUIRY_MODE_EXTENDED, HCI_TIMEOUT) < 0) {
+		logger().debug("extended inquiry mode is not supported by " + m_name,
 				__FILE__, __LINE__);
 	}
 
-	::bt_free(info);
-	::hci_close_dev(sock);
+	logger().debug("starting inquiry on " + m_name, __FILE__, __LINE__);
 
-	return devices;
+	BluezInquiry inquiry(*sock, callback, nameCache);
+	inquiry.run();
+
+	logger().debug("inquiry on " + m_name + " has finished, found "
+			+ to_string(inquiry.reported()) + " devices",
+			__FILE__, __LINE__);
 }
 
 HciInfo BluezHciInterface::info() const
@@ -303,36 +279,14 @@ void BluezHciInterface::unwatch(const MACAddress&)
 
 string BluezHciInterface::parseLEName(uint8_t *eir, size_t length)
 {
-	size_t offset = 0;
-
-	while (offset < length) {
-		uint8_t fieldLen = eir[0];
-
-		if (fieldLen == 0)
-			break;
-
-		if (offset + fieldLen > length)
-			break;
-
-		switch (eir[1]) {
-		case EIR_NAME_SHORT:
-		case EIR_NAME_COMPLETE:
-			size_t nameLen = fieldLen - 1;
-			return string((char*)&eir[2], nameLen);
-		}
-
-		offset += fieldLen + 1;
-		eir += fieldLen + 1;
-	}
-
-	return "";
+	return BluezInquiry::eirName(eir, length);
 }
 
 bool BluezHciInterface::processNextEvent(const int &fd, map<MACAddress, string> &devices) const
 {
-	vector<char> buf(HCI_MAX_EVENT_SIZE);
+	uint8_t buf[HCI_MAX_EVENT_SIZE];
 
-	ssize_t rlen = read(fd, buf.data(), buf.size());
+	ssize_t rlen = read(fd, buf, sizeof(buf));
 	if (rlen < 0 && errno == EAGAIN)
 		return true;
 
@@ -352,32 +306,30 @@ bool BluezHciInterface::processNextEvent(const int &fd, map<MACAddress, string>
 	if (logger().trace())
 		logger().trace("read " + to_string(rlen) + " bytes", __FILE__, __LINE__);
 
-	const evt_le_meta_event *meta = skipHciEventHdr(buf.data(), buf.size());
+	const size_t count = LEAdvertisementParser::parse(buf, rlen,
+		[&](const LEAdvertisement &advertisement) {
+			const MACAddress &address = advertisement.address();
+			auto it = devices.emplace(address, advertisement.name());
+
+			if (it.second) {
+				logger().debug("found BLE device: "
+					+ address.toString(':') + " " + it.first->second,
+					__FILE__, __LINE__);
+			}
+			else if (it.first->second.empty() && advertisement.hasName()) {
+				it.first->second = advertisement.name();
+				logger().debug("updated BLE device: "
+					+ address.toString(':') + " " + it.first->second,
+					__FILE__, __LINE__);
+			}
+		});
 
-	if (meta->subevent != EVT_LE_ADVERTISING_REPORT) {
-		logger().debug("meta->subevent != EVT_LE_ADVERTISING_REPORT (0x02)",
+	if (count == 0) {
+		logger().debug("no advertising report in the received event",
 			__FILE__, __LINE__);
 		return false;
 	}
 
-	le_advertising_info *info = (le_advertising_info *) (meta->data + 1);
-	if (info->length <= 0)
-		return true;
-
-	MACAddress address(info->bdaddr.b);
-	string name = parseLEName(info->data, info->length);
-
-	auto it = devices.emplace(address, name);
-	if (it.second) {
-		logger().debug("found BLE device: "
-			+ address.toString(':') + " " + name, __FILE__, __LINE__);
-	}
-	else if (devices[address].empty() && !name.empty()) {
-		devices[address] = name;
-		logger().debug("updated BLE device: "
-			+ address.toString(':') + " " + name, __FILE__, __LINE__);
-	}
-
 	return true;
 }
 
@@ -18,6 +18,16 @@ public:
 	void reset() const override;
 	bool detect(const MACAddress &address) const override;
 	std::map<MACAddress, std::string> scan() const override;
+
+	/**
+	 * @brief Perform an inquiry on a raw HCI socket. Names contained
+	 * in the extended inquiry responses are reported immediately.
+	 * Names of other devices are resolved by remote name requests
+	 * issued while the inquiry is still running, several at once.
+	 * A limited count of resolved names is cached per MAC address
+	 * for future scans.
+	 */
+	void streamScan(const ScanCallback &callback) const override;
 	std::map<MACAddress, std::string> lescan(
 			const Poco::Timespan &seconds) const override;
 	HciInfo info() const override;
@@ -0,0 +1,485 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <sys/poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <bluetooth/hci_lib.h>
+
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+
+#include "bluetooth/BluezInquiry.h"
+#include "bluetooth/LEAdvertisement.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const int INQUIRY_LENGTH = 8; // ~10 seconds
+static const uint32_t INQUIRY_GIAC = 0x9e8b33;
+
+/**
+ * Maximal count of remote name requests being processed at once.
+ * Controllers that does not support so many parallel connection
+ * attempts would reject some of them, such requests are retried
+ * later with a lower limit.
+ */
+static const size_t MAX_PENDING_NAMES = 3;
+static const Timespan NAME_TIMEOUT = 5 * Timespan::SECONDS;
+static const Timespan SCAN_TIMEOUT =
+	INQUIRY_LENGTH * 1280 * Timespan::MILLISECONDS + 2 * NAME_TIMEOUT;
+static const int POLL_PERIOD_MS = 100;
+
+/**
+ * Status of a command rejected by the controller because it
+ * cannot process it in parallel with other commands.
+ */
+static const uint8_t HCI_COMMAND_DISALLOWED = 0x0c;
+
+static void throwFromErrno(const int e, const string &prefix)
+{
+	throw IOException(prefix + ": " + ::strerror(e));
+}
+
+BluezNameCache::BluezNameCache(size_t capacity):
+	m_capacity(capacity)
+{
+	if (m_capacity == 0)
+		throw InvalidArgumentException("name cache capacity must be positive");
+}
+
+void BluezNameCache::store(const MACAddress &address, const string &name)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto it = m_names.find(address);
+	if (it != m_names.end()) {
+		it->second = name;
+		m_order.erase(find(m_order.begin(), m_order.end(), address));
+	}
+	else {
+		if (m_names.size() >= m_capacity) {
+			m_names.erase(m_order.front());
+			m_order.pop_front();
+		}
+
+		m_names.emplace(address, name);
+	}
+
+	m_order.push_back(address);
+}
+
+bool BluezNameCache::lookup(const MACAddress &address, string &name) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto it = m_names.find(address);
+	if (it == m_names.end())
+		return false;
+
+	name = it->second;
+	return true;
+}
+
+size_t BluezNameCache::size() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_names.size();
+}
+
+BluezInquiry::BluezInquiry(
+		int sock,
+		const HciInterface::ScanCallback &callback,
+		BluezNameCache &cache):
+	m_sock(sock),
+	m_callback(callback),
+	m_cache(cache),
+	m_maxPending(MAX_PENDING_NAMES),
+	m_inquiryDone(false)
+{
+}
+
+BluezInquiry::~BluezInquiry()
+{
+}
+
+size_t BluezInquiry::reported() const
+{
+	return m_reported.size();
+}
+
+string BluezInquiry::eirName(const uint8_t *eir, size_t length)
+{
+	LEAdvertisement advertisement;
+	LEAdvertisementParser::parseData(eir, length, advertisement);
+
+	return advertisement.name();
+}
+
+void BluezInquiry::run()
+{
+	setupFilter();
+	startInquiry();
+
+	struct pollfd pollst;
+	pollst.fd = m_sock;
+	pollst.events = POLLIN | POLLRDNORM;
+
+	vector<uint8_t> buf(HCI_MAX_EVENT_SIZE);
+
+	try {
+		while (!finished()) {
+			const Timespan timeDiff = SCAN_TIMEOUT - m_started.elapsed();
+			if (timeDiff <= 0) {
+				logger().debug("timeout occured while scanning", __FILE__, __LINE__);
+				break;
+			}
+
+			const int ret = ::poll(&pollst, 1,
+				min<Timespan::TimeDiff>(timeDiff.totalMilliseconds(), POLL_PERIOD_MS));
+			if (ret < 0) {
+				if (errno == EINTR)
+					continue;
+
+				throwFromErrno(errno, "poll failed");
+			}
+
+			if (ret > 0) {
+				const ssize_t rlen = ::read(m_sock, buf.data(), buf.size());
+				if (rlen < 0) {
+					if (errno == EAGAIN || errno == EINTR)
+						continue;
+
+					throwFromErrno(errno, "read failed");
+				}
+
+				processEvent(buf.data(), rlen);
+			}
+
+			expireNames();
+			requestNames();
+		}
+	}
+	catch (...) {
+		cancel();
+		throw;
+	}
+
+	finish();
+}
+
+void BluezInquiry::setupFilter()
+{
+	struct hci_filter filter;
+
+	hci_filter_clear(&filter);
+	hci_filter_set_ptype(HCI_EVENT_PKT, &filter);
+	hci_filter_set_event(EVT_INQUIRY_COMPLETE, &filter);
+	hci_filter_set_event(EVT_INQUIRY_RESULT, &filter);
+	hci_filter_set_event(EVT_INQUIRY_RESULT_WITH_RSSI, &filter);
+	hci_filter_set_event(EVT_EXTENDED_INQUIRY_RESULT, &filter);
+	hci_filter_set_event(EVT_REMOTE_NAME_REQ_COMPLETE, &filter);
+	hci_filter_set_event(EVT_CMD_STATUS, &filter);
+
+	if (::setsockopt(m_sock, SOL_HCI, HCI_FILTER, &filter, sizeof(filter)) < 0)
+		throwFromErrno(errno, "setsockopt(HCI_FILTER)");
+}
+
+void BluezInquiry::startInquiry()
+{
+	inquiry_cp cp;
+	::memset(&cp, 0, sizeof(cp));
+
+	cp.lap[0] = INQUIRY_GIAC & 0xff;
+	cp.lap[1] = (INQUIRY_GIAC >> 8) & 0xff;
+	cp.lap[2] = (INQUIRY_GIAC >> 16) & 0xff;
+	cp.length = INQUIRY_LENGTH;
+	cp.num_rsp = 0; // unlimited
+
+	sendCommand(OCF_INQUIRY, INQUIRY_CP_SIZE, &cp);
+}
+
+void BluezInquiry::sendCommand(uint16_t ocf, uint8_t length, void *param)
+{
+	if (::hci_send_cmd(m_sock, OGF_LINK_CTL, ocf, length, param) < 0)
+		throwFromErrno(errno, "hci_send_cmd(" + to_string(ocf) + ")");
+}
+
+/**
+ * Cancelling is best effort, the operation might have just finished.
+ */
+void BluezInquiry::cancelCommand(uint16_t ocf, uint8_t length, void *param)
+{
+	try {
+		sendCommand(ocf, length, param);
+	}
+	BEEEON_CATCH_CHAIN(logger())
+}
+
+bool BluezInquiry::finished() const
+{
+	return m_inquiryDone && m_waiting.empty() && m_pending.empty();
+}
+
+void BluezInquiry::cancel()
+{
+	if (!m_inquiryDone) {
+		cancelCommand(OCF_INQUIRY_CANCEL, 0, NULL);
+		m_inquiryDone = true;
+	}
+
+	for (const auto &pending : m_pending) {
+		remote_name_req_cancel_cp cp;
+		pending.first.into(cp.bdaddr.b);
+
+		cancelCommand(OCF_REMOTE_NAME_REQ_CANCEL,
+			REMOTE_NAME_REQ_CANCEL_CP_SIZE, &cp);
+	}
+
+	m_pending.clear();
+	m_waiting.clear();
+	m_awaitingStatus.clear();
+}
+
+void BluezInquiry::finish()
+{
+	cancel();
+
+	for (const auto &device : m_seen)
+		resolved(device.first, "unknown");
+}
+
+void BluezInquiry::processEvent(const uint8_t *data, size_t length)
+{
+	if (length < 1 + HCI_EVENT_HDR_SIZE || data[0] != HCI_EVENT_PKT)
+		return;
+
+	const hci_event_hdr *hdr = (const hci_event_hdr *) (data + 1);
+	const uint8_t *params = data + 1 + HCI_EVENT_HDR_SIZE;
+	const size_t plen = min<size_t>(hdr->plen, length - 1 - HCI_EVENT_HDR_SIZE);
+
+	if (logger().trace()) {
+		logger().trace("event " + to_string(hdr->evt)
+			+ " of " + to_string(plen) + " bytes", __FILE__, __LINE__);
+	}
+
+	const size_t count = plen > 0 ? params[0] : 0;
+
+	switch (hdr->evt) {
+	case EVT_INQUIRY_COMPLETE:
+		logger().debug("inquiry complete", __FILE__, __LINE__);
+		m_inquiryDone = true;
+		break;
+
+	case EVT_INQUIRY_RESULT:
+		for (size_t i = 0; i < count && 1 + (i + 1) * INQUIRY_INFO_SIZE <= plen; ++i) {
+			const inquiry_info *info = (const inquiry_info *)
+				(params + 1 + i * INQUIRY_INFO_SIZE);
+
+			found(MACAddress(info->bdaddr.b),
+				info->pscan_rep_mode, info->clock_offset, "");
+		}
+		break;
+
+	case EVT_INQUIRY_RESULT_WITH_RSSI:
+		for (size_t i = 0; i < count && 1 + (i + 1) * INQUIRY_INFO_WITH_RSSI_SIZE <= plen; ++i) {
+			const inquiry_info_with_rssi *info = (const inquiry_info_with_rssi *)
+				(params + 1 + i * INQUIRY_INFO_WITH_RSSI_SIZE);
+
+			found(MACAddress(info->bdaddr.b),
+				info->pscan_rep_mode, info->clock_offset, "");
+		}
+		break;
+
+	case EVT_EXTENDED_INQUIRY_RESULT:
+		for (size_t i = 0; i < count && 1 + (i + 1) * EXTENDED_INQUIRY_INFO_SIZE <= plen; ++i) {
+			const extended_inquiry_info *info = (const extended_inquiry_info *)
+				(params + 1 + i * EXTENDED_INQUIRY_INFO_SIZE);
+
+			found(MACAddress(info->bdaddr.b),
+				info->pscan_rep_mode, info->clock_offset,
+				eirName(info->data, sizeof(info->data)));
+		}
+		break;
+
+	case EVT_REMOTE_NAME_REQ_COMPLETE:
+		if (plen >= EVT_REMOTE_NAME_REQ_COMPLETE_SIZE)
+			processNameComplete(*(const evt_remote_name_req_complete *) params);
+		break;
+
+	case EVT_CMD_STATUS:
+		if (plen >= EVT_CMD_STATUS_SIZE)
+			processCommandStatus(*(const evt_cmd_status *) params);
+		break;
+	}
+}
+
+void BluezInquiry::processCommandStatus(const evt_cmd_status &status)
+{
+	const uint16_t opcode = btohs(status.opcode);
+
+	if (opcode == cmd_opcode_pack(OGF_LINK_CTL, OCF_INQUIRY)) {
+		if (status.status != 0) {
+			// the inquiry is not running, only the names are cancelled
+			m_inquiryDone = true;
+			cancel();
+
+			throw IOException("inquiry failed with status "
+				+ to_string(status.status));
+		}
+
+		return;
+	}
+
+	if (opcode != cmd_opcode_pack(OGF_LINK_CTL, OCF_REMOTE_NAME_REQ))
+		return;
+
+	if (m_awaitingStatus.empty())
+		return;
+
+	const MACAddress address = m_awaitingStatus.front();
+	m_awaitingStatus.pop_front();
+
+	if (status.status == 0)
+		return;
+
+	auto it = m_pending.find(address);
+	if (it == m_pending.end())
+		return;
+
+	m_pending.erase(it);
+
+	if (status.status == HCI_COMMAND_DISALLOWED && !m_pending.empty()) {
+		m_maxPending = m_pending.size();
+
+		logger().debug("lowering count of parallel name requests to "
+			+ to_string(m_maxPending), __FILE__, __LINE__);
+
+		m_waiting.push_front(m_seen.at(address));
+		return;
+	}
+
+	logger().debug("name request for " + address.toString(':')
+		+ " failed with status " + to_string(status.status),
+		__FILE__, __LINE__);
+
+	resolved(address, "unknown");
+}
+
+void BluezInquiry::processNameComplete(const evt_remote_name_req_complete &complete)
+{
+	const MACAddress address(complete.bdaddr.b);
+
+	if (m_pending.erase(address) == 0)
+		return; // cancelled or not ours
+
+	if (complete.status != 0) {
+		resolved(address, "unknown");
+		return;
+	}
+
+	const char *name = (const char *) complete.name;
+	const string value(name, ::strnlen(name, sizeof(complete.name)));
+
+	m_cache.store(address, value);
+	resolved(address, value);
+}
+
+void BluezInquiry::found(
+		const MACAddress &address,
+		uint8_t pscanRepMode,
+		uint16_t clockOffset,
+		const string &name)
+{
+	const NameRequest request = {address, pscanRepMode, clockOffset};
+
+	if (!m_seen.emplace(address, request).second) {
+		if (!name.empty())
+			resolved(address, name);
+
+		return;
+	}
+
+	if (!name.empty()) {
+		m_cache.store(address, name);
+		resolved(address, name);
+		return;
+	}
+
+	string cached;
+	if (m_cache.lookup(address, cached)) {
+		resolved(address, cached);
+		return;
+	}
+
+	m_waiting.push_back(request);
+}
+
+void BluezInquiry::resolved(const MACAddress &address, const string &name)
+{
+	if (!m_reported.emplace(address).second)
+		return;
+
+	logger().debug("detected device "
+			+ address.toString(':')
+			+ " with name "
+			+ name,
+			__FILE__, __LINE__);
+
+	m_callback(address, name);
+}
+
+void BluezInquiry::requestNames()
+{
+	while (!m_waiting.empty() && m_pending.size() < m_maxPending) {
+		const NameRequest request = m_waiting.front();
+		m_waiting.pop_front();
+
+		if (m_reported.find(request.address) != m_reported.end())
+			continue;
+
+		logger().debug("determine name of device " + request.address.toString(':'),
+				__FILE__, __LINE__);
+
+		remote_name_req_cp cp;
+		::memset(&cp, 0, sizeof(cp));
+
+		request.address.into(cp.bdaddr.b);
+		cp.pscan_rep_mode = request.pscanRepMode;
+		cp.clock_offset = request.clockOffset | htobs(0x8000); // offset is valid
+
+		sendCommand(OCF_REMOTE_NAME_REQ, REMOTE_NAME_REQ_CP_SIZE, &cp);
+
+		m_pending.emplace(request.address, Clock());
+		m_awaitingStatus.push_back(request.address);
+	}
+}
+
+void BluezInquiry::expireNames()
+{
+	auto it = m_pending.begin();
+
+	while (it != m_pending.end()) {
+		if (!it->second.isElapsed(NAME_TIMEOUT.totalMicroseconds())) {
+			++it;
+			continue;
+		}
+
+		const MACAddress address = it->first;
+		it = m_pending.erase(it);
+
+		logger().debug("name request for " + address.toString(':') + " timed out",
+				__FILE__, __LINE__);
+
+		remote_name_req_cancel_cp cp;
+		address.into(cp.bdaddr.b);
+
+		cancelCommand(OCF_REMOTE_NAME_REQ_CANCEL,
+			REMOTE_NAME_REQ_CANCEL_CP_SIZE, &cp);
+
+		resolved(address, "unknown");
+	}
+}
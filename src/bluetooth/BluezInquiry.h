@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/hci.h>
+
+#include <Poco/Clock.h>
+#include <Poco/Mutex.h>
+
+#include "bluetooth/HciInterface.h"
+#include "net/MACAddress.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Names of classic Bluetooth devices resolved by inquiries.
+ * The cache holds a limited count of names, the name stored least
+ * recently is dropped when the cache is full.
+ */
+class BluezNameCache {
+public:
+	BluezNameCache(size_t capacity);
+
+	void store(const MACAddress &address, const std::string &name);
+	bool lookup(const MACAddress &address, std::string &name) const;
+	size_t size() const;
+
+private:
+	size_t m_capacity;
+	std::map<MACAddress, std::string> m_names;
+	std::deque<MACAddress> m_order;
+	mutable Poco::FastMutex m_lock;
+};
+
+/**
+ * @brief Single inquiry performed on an opened HCI socket. The inquiry
+ * and remote name requests are sent as raw HCI commands and the socket
+ * is polled for the related events. Names of devices that did not
+ * provide them via EIR are resolved while the inquiry is still running.
+ */
+class BluezInquiry : protected Loggable {
+public:
+	BluezInquiry(
+		int sock,
+		const HciInterface::ScanCallback &callback,
+		BluezNameCache &cache);
+	virtual ~BluezInquiry();
+
+	/**
+	 * Perform the inquiry until all found devices are reported.
+	 * Operations still in progress are cancelled on failure.
+	 */
+	void run();
+	size_t reported() const;
+
+	/**
+	 * Extended inquiry response uses the same format as the
+	 * advertising data.
+	 */
+	static std::string eirName(const uint8_t *eir, size_t length);
+
+protected:
+	/**
+	 * Send the given link control command to the controller.
+	 * @throws IOException on failure
+	 */
+	virtual void sendCommand(uint16_t ocf, uint8_t length, void *param);
+
+	void startInquiry();
+	bool finished() const;
+
+	/**
+	 * Cancel the inquiry and all remote name requests in progress.
+	 */
+	void cancel();
+
+	/**
+	 * Cancel all operations still in progress and report devices
+	 * whose names could not be resolved in time.
+	 */
+	void finish();
+
+	void processEvent(const uint8_t *data, size_t length);
+	void requestNames();
+	void expireNames();
+
+private:
+	struct NameRequest {
+		MACAddress address;
+		uint8_t pscanRepMode;
+		uint16_t clockOffset;
+	};
+
+	void setupFilter();
+	void cancelCommand(uint16_t ocf, uint8_t length, void *param);
+
+	void processCommandStatus(const evt_cmd_status &status);
+	void processNameComplete(const evt_remote_name_req_complete &complete);
+
+	void found(
+		const MACAddress &address,
+		uint8_t pscanRepMode,
+		uint16_t clockOffset,
+		const std::string &name);
+	void resolved(const MACAddress &address, const std::string &name);
+
+private:
+	int m_sock;
+	const HciInterface::ScanCallback &m_callback;
+	BluezNameCache &m_cache;
+	std::map<MACAddress, NameRequest> m_seen;
+	std::set<MACAddress> m_reported;
+	std::deque<NameRequest> m_waiting;
+	std::map<MACAddress, Poco::Clock> m_pending;
+	std::deque<MACAddress> m_awaitingStatus;
+	size_t m_maxPending;
+	bool m_inquiryDone;
+	Poco::Clock m_started;
+};
+
+}
@@ -98,6 +98,12 @@ map<MACAddress, string> DBusHciInterface::scan() const
 	return bluezHci.scan();
 }
 
+void DBusHciInterface::streamScan(const ScanCallback &callback) const
+{
+	BluezHciInterface bluezHci(m_name);
+	bluezHci.streamScan(callback);
+}
+
 map<MACAddress, string> DBusHciInterface::lescan(const Timespan& timeout) const
 {
 	logger().information("starting BLE scan for " +
@@ -107,6 +107,7 @@ public:
 	 * the bluetooh classic devices.
 	 */
 	std::map<MACAddress, std::string> scan() const override;
+	void streamScan(const ScanCallback &callback) const override;
 
 	/**
 	 * @brief Scans the Bluetooth LE network and returns all available
@@ -1,11 +1,18 @@
 #include "bluetooth/HciInterface.h"
 
 using namespace BeeeOn;
+using namespace std;
 
 HciInterface::~HciInterface()
 {
 }
 
+void HciInterface::streamScan(const ScanCallback &callback) const
+{
+	for (const auto &device : scan())
+		callback(device.first, device.second);
+}
+
 HciInterfaceManager::~HciInterfaceManager()
 {
 }
@@ -17,6 +17,7 @@ class HciInterface {
 public:
 	typedef Poco::SharedPtr<HciInterface> Ptr;
 	typedef std::function<void(const MACAddress&, std::vector<unsigned char>&)> WatchCallback;
+	typedef std::function<void(const MACAddress&, const std::string&)> ScanCallback;
 
 	virtual ~HciInterface();
 
@@ -47,6 +48,14 @@ public:
 	 */
 	virtual std::map<MACAddress, std::string> scan() const = 0;
 
+	/**
+	 * Full scan of bluetooth network reporting each found device
+	 * via the given callback as soon as its name is known. Each
+	 * device is reported at most once during a single scan.
+	 * The default implementation reports results of scan().
+	 */
+	virtual void streamScan(const ScanCallback &callback) const;
+
 	/**
 	 * Full scan of low energy bluetooth network.
 	 * Sets parameters for low energy scan and open socket.
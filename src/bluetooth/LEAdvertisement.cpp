@@ -0,0 +1,229 @@
+#include <algorithm>
+
+#include "bluetooth/LEAdvertisement.h"
+
+using namespace BeeeOn;
+using namespace std;
+
+static const uint8_t HCI_EVENT_PACKET = 0x04;
+static const uint8_t HCI_LE_META_EVENT = 0x3e;
+static const uint8_t LE_ADVERTISING_REPORT = 0x02;
+
+/**
+ * Size of the fixed part of a single advertising report:
+ * event type, address type, address and length of data.
+ */
+static const size_t REPORT_HEADER_SIZE = 1 + 1 + 6 + 1;
+
+static const uint8_t AD_NAME_SHORT = 0x08;
+static const uint8_t AD_NAME_COMPLETE = 0x09;
+static const uint8_t AD_SERVICE_DATA_16 = 0x16;
+static const uint8_t AD_MANUFACTURER_DATA = 0xff;
+
+static uint16_t readLE16(const uint8_t *data)
+{
+	return data[0] | (data[1] << 8);
+}
+
+LEAdvertisement::LEAdvertisement():
+	m_addressType(0),
+	m_eventType(0),
+	m_rssi(0),
+	m_payload(nullptr),
+	m_payloadSize(0),
+	m_name(nullptr),
+	m_nameSize(0),
+	m_manufacturerID(0),
+	m_manufacturerData(nullptr),
+	m_manufacturerDataSize(0),
+	m_serviceUUID(0),
+	m_serviceData(nullptr),
+	m_serviceDataSize(0)
+{
+}
+
+const MACAddress &LEAdvertisement::address() const
+{
+	return m_address;
+}
+
+uint8_t LEAdvertisement::addressType() const
+{
+	return m_addressType;
+}
+
+uint8_t LEAdvertisement::eventType() const
+{
+	return m_eventType;
+}
+
+int8_t LEAdvertisement::rssi() const
+{
+	return m_rssi;
+}
+
+bool LEAdvertisement::hasName() const
+{
+	return m_name != nullptr;
+}
+
+string LEAdvertisement::name() const
+{
+	if (m_name == nullptr)
+		return "";
+
+	return string(reinterpret_cast<const char *>(m_name), m_nameSize);
+}
+
+bool LEAdvertisement::hasManufacturerData() const
+{
+	return m_manufacturerData != nullptr;
+}
+
+uint16_t LEAdvertisement::manufacturerID() const
+{
+	return m_manufacturerID;
+}
+
+vector<unsigned char> LEAdvertisement::manufacturerData() const
+{
+	if (m_manufacturerData == nullptr)
+		return {};
+
+	return vector<unsigned char>(
+		m_manufacturerData, m_manufacturerData + m_manufacturerDataSize);
+}
+
+bool LEAdvertisement::hasServiceData() const
+{
+	return m_serviceData != nullptr;
+}
+
+uint16_t LEAdvertisement::serviceUUID() const
+{
+	return m_serviceUUID;
+}
+
+vector<unsigned char> LEAdvertisement::serviceData() const
+{
+	if (m_serviceData == nullptr)
+		return {};
+
+	return vector<unsigned char>(
+		m_serviceData, m_serviceData + m_serviceDataSize);
+}
+
+const uint8_t *LEAdvertisement::payload() const
+{
+	return m_payload;
+}
+
+size_t LEAdvertisement::payloadSize() const
+{
+	return m_payloadSize;
+}
+
+size_t LEAdvertisementParser::parse(
+		const uint8_t *event,
+		size_t length,
+		const Callback &callback)
+{
+	// packet type, event code, parameters length, subevent, count of reports
+	if (length < 5)
+		return 0;
+
+	if (event[0] != HCI_EVENT_PACKET || event[1] != HCI_LE_META_EVENT)
+		return 0;
+
+	if (event[3] != LE_ADVERTISING_REPORT)
+		return 0;
+
+	const size_t end = min<size_t>(length, 3 + event[2]);
+	const unsigned int count = event[4];
+	size_t offset = 5;
+	size_t decoded = 0;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		if (offset + REPORT_HEADER_SIZE > end)
+			break;
+
+		const uint8_t *report = event + offset;
+		const size_t dataLength = report[8];
+
+		// data are followed by RSSI
+		if (offset + REPORT_HEADER_SIZE + dataLength + 1 > end)
+			break;
+
+		LEAdvertisement advertisement;
+		advertisement.m_eventType = report[0];
+		advertisement.m_addressType = report[1];
+		advertisement.m_address = MACAddress(report + 2);
+		advertisement.m_rssi = static_cast<int8_t>(report[REPORT_HEADER_SIZE + dataLength]);
+
+		parseData(report + REPORT_HEADER_SIZE, dataLength, advertisement);
+
+		callback(advertisement);
+
+		offset += REPORT_HEADER_SIZE + dataLength + 1;
+		++decoded;
+	}
+
+	return decoded;
+}
+
+void LEAdvertisementParser::parseData(
+		const uint8_t *data,
+		size_t length,
+		LEAdvertisement &advertisement)
+{
+	advertisement.m_payload = data;
+	advertisement.m_payloadSize = length;
+
+	size_t offset = 0;
+
+	while (offset < length) {
+		const size_t fieldLength = data[offset];
+
+		if (fieldLength == 0)
+			break;
+
+		if (offset + 1 + fieldLength > length)
+			break;
+
+		const uint8_t type = data[offset + 1];
+		const uint8_t *value = data + offset + 2;
+		const size_t valueLength = fieldLength - 1;
+
+		switch (type) {
+		case AD_NAME_SHORT:
+			// prefer the complete name when present
+			if (advertisement.m_name != nullptr)
+				break;
+			// fall through
+		case AD_NAME_COMPLETE:
+			advertisement.m_name = value;
+			advertisement.m_nameSize = valueLength;
+			break;
+
+		case AD_MANUFACTURER_DATA:
+			if (valueLength < 2)
+				break;
+
+			advertisement.m_manufacturerID = readLE16(value);
+			advertisement.m_manufacturerData = value + 2;
+			advertisement.m_manufacturerDataSize = valueLength - 2;
+			break;
+
+		case AD_SERVICE_DATA_16:
+			if (valueLength < 2)
+				break;
+
+			advertisement.m_serviceUUID = readLE16(value);
+			advertisement.m_serviceData = value + 2;
+			advertisement.m_serviceDataSize = valueLength - 2;
+			break;
+		}
+
+		offset += fieldLength + 1;
+	}
+}
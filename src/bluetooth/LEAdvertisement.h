@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "net/MACAddress.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Single LE advertising report decoded from an HCI event.
+ * The instance does not own any data, the name, manufacturer data
+ * and service data refer directly into the buffer of the event.
+ * Thus, it is valid only while the buffer is unchanged. Use name(),
+ * manufacturerData() and serviceData() to obtain copies.
+ */
+class LEAdvertisement {
+public:
+	friend class LEAdvertisementParser;
+
+	LEAdvertisement();
+
+	const MACAddress &address() const;
+	uint8_t addressType() const;
+	uint8_t eventType() const;
+	int8_t rssi() const;
+
+	bool hasName() const;
+	std::string name() const;
+
+	/**
+	 * The manufacturer data does not contain the leading
+	 * company identifier, see manufacturerID().
+	 */
+	bool hasManufacturerData() const;
+	uint16_t manufacturerID() const;
+	std::vector<unsigned char> manufacturerData() const;
+
+	/**
+	 * The service data does not contain the leading 16-bit
+	 * UUID of the service, see serviceUUID().
+	 */
+	bool hasServiceData() const;
+	uint16_t serviceUUID() const;
+	std::vector<unsigned char> serviceData() const;
+
+	/**
+	 * @returns the raw advertising data (all AD structures)
+	 */
+	const uint8_t *payload() const;
+	size_t payloadSize() const;
+
+private:
+	MACAddress m_address;
+	uint8_t m_addressType;
+	uint8_t m_eventType;
+	int8_t m_rssi;
+	const uint8_t *m_payload;
+	size_t m_payloadSize;
+	const uint8_t *m_name;
+	size_t m_nameSize;
+	uint16_t m_manufacturerID;
+	const uint8_t *m_manufacturerData;
+	size_t m_manufacturerDataSize;
+	uint16_t m_serviceUUID;
+	const uint8_t *m_serviceData;
+	size_t m_serviceDataSize;
+};
+
+/**
+ * @brief Decoder of HCI LE Meta events carrying advertising reports.
+ * All AD structures of a report are walked just once and all the
+ * recognized fields are extracted at the same time. The decoder
+ * does not allocate any memory and does not depend on the BlueZ
+ * headers so it can be used for captured traffic as well.
+ */
+class LEAdvertisementParser {
+public:
+	typedef std::function<void(const LEAdvertisement &)> Callback;
+
+	/**
+	 * Decode the given HCI event packet (starting by the packet
+	 * type) and call the callback for each advertising report
+	 * it contains. Other events and malformed reports are skipped.
+	 *
+	 * @returns number of reports decoded
+	 */
+	static size_t parse(
+		const uint8_t *event,
+		size_t length,
+		const Callback &callback);
+
+	/**
+	 * Walk the given advertising data and fill the recognized
+	 * fields of the given advertisement.
+	 */
+	static void parseData(
+		const uint8_t *data,
+		size_t length,
+		LEAdvertisement &advertisement);
+};
+
+}
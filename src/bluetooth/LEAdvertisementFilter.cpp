@@ -0,0 +1,121 @@
+#include <Poco/Exception.h>
+
+#include "bluetooth/LEAdvertisement.h"
+#include "bluetooth/LEAdvertisementFilter.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+static uint64_t digestOf(const uint8_t *data, size_t size)
+{
+	uint64_t digest = FNV_OFFSET_BASIS;
+
+	for (size_t i = 0; i < size; ++i) {
+		digest ^= data[i];
+		digest *= FNV_PRIME;
+	}
+
+	return digest;
+}
+
+LEAdvertisementFilter::LEAdvertisementFilter(
+		const Timespan &reportInterval):
+	m_lastSweep(0),
+	m_suppressed(0)
+{
+	setReportInterval(reportInterval);
+}
+
+void LEAdvertisementFilter::setReportInterval(const Timespan &interval)
+{
+	if (interval < 0)
+		throw InvalidArgumentException("report interval must not be negative");
+
+	FastMutex::ScopedLock guard(m_lock);
+	m_reportInterval = interval;
+}
+
+Timespan LEAdvertisementFilter::reportInterval() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_reportInterval;
+}
+
+bool LEAdvertisementFilter::accept(
+		const MACAddress &address,
+		const uint8_t *data,
+		size_t size,
+		const Timestamp &now)
+{
+	const uint64_t digest = digestOf(data, size);
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_reportInterval == 0)
+		return true;
+
+	if (m_reportInterval <= now - m_lastSweep)
+		sweep(now);
+
+	auto result = m_entries.emplace(address, Entry{digest, now});
+	if (result.second)
+		return true;
+
+	Entry &entry = result.first->second;
+
+	if (entry.digest == digest && m_reportInterval > now - entry.reported) {
+		++m_suppressed;
+		return false;
+	}
+
+	entry.digest = digest;
+	entry.reported = now;
+	return true;
+}
+
+void LEAdvertisementFilter::sweep(const Timestamp &now)
+{
+	auto it = m_entries.begin();
+
+	while (it != m_entries.end()) {
+		if (m_reportInterval <= now - it->second.reported)
+			it = m_entries.erase(it);
+		else
+			++it;
+	}
+
+	m_lastSweep = now;
+}
+
+bool LEAdvertisementFilter::accept(
+		const LEAdvertisement &advertisement,
+		const Timestamp &now)
+{
+	return accept(
+		advertisement.address(),
+		advertisement.payload(),
+		advertisement.payloadSize(),
+		now);
+}
+
+void LEAdvertisementFilter::forget(const MACAddress &address)
+{
+	FastMutex::ScopedLock guard(m_lock);
+	m_entries.erase(address);
+}
+
+size_t LEAdvertisementFilter::size() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_entries.size();
+}
+
+uint64_t LEAdvertisementFilter::suppressed() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_suppressed;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+#include <Poco/Mutex.h>
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+
+#include "net/MACAddress.h"
+
+namespace BeeeOn {
+
+class LEAdvertisement;
+
+/**
+ * @brief Suppression of repeated advertisements. BLE devices usually
+ * advertise the same data many times per second. The filter remembers
+ * a digest of the last data reported for each MAC address and lets
+ * through only advertisements with changed data or those that repeat
+ * the data after the report interval has elapsed.
+ *
+ * The zero report interval disables the filter. Devices that have
+ * not been reported for the report interval are forgotten as their
+ * next advertisement would be reported anyway.
+ */
+class LEAdvertisementFilter {
+public:
+	LEAdvertisementFilter(
+		const Poco::Timespan &reportInterval = 0);
+
+	void setReportInterval(const Poco::Timespan &interval);
+	Poco::Timespan reportInterval() const;
+
+	/**
+	 * @returns true if the given data of the given device
+	 * should be reported to consumers
+	 */
+	bool accept(
+		const MACAddress &address,
+		const uint8_t *data,
+		size_t size,
+		const Poco::Timestamp &now = Poco::Timestamp());
+
+	bool accept(
+		const LEAdvertisement &advertisement,
+		const Poco::Timestamp &now = Poco::Timestamp());
+
+	/**
+	 * Forget the given device, its next advertisement is reported.
+	 */
+	void forget(const MACAddress &address);
+
+	/**
+	 * @returns count of devices being tracked
+	 */
+	size_t size() const;
+
+	/**
+	 * @returns count of advertisements suppressed so far
+	 */
+	uint64_t suppressed() const;
+
+private:
+	struct Entry {
+		uint64_t digest;
+		Poco::Timestamp reported;
+	};
+
+	/**
+	 * Forget devices not reported for the report interval.
+	 * It is called at most once per the report interval.
+	 */
+	void sweep(const Poco::Timestamp &now);
+
+	Poco::Timespan m_reportInterval;
+	std::map<MACAddress, Entry> m_entries;
+	Poco::Timestamp m_lastSweep;
+	uint64_t m_suppressed;
+	mutable Poco::FastMutex m_lock;
+};
+
+}
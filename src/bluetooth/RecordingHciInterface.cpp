@@ -0,0 +1,176 @@
+#include "bluetooth/RecordingHciInterface.h"
+#include "util/InputTrace.h"
+#include "util/InputTraceRecorder.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+const string HciInputTrace::CHANNEL = "ble";
+
+string HciInputTrace::encodeScan(const map<MACAddress, string> &devices)
+{
+	InputTraceEncoder encoder;
+
+	encoder.putUnsigned(LESCAN);
+	encoder.putUnsigned(devices.size());
+
+	for (const auto &pair : devices) {
+		encoder.putUnsigned(pair.first.toNumber());
+		encoder.putString(pair.second);
+	}
+
+	return encoder.data();
+}
+
+string HciInputTrace::encodeAdvertisement(
+		const MACAddress &address,
+		const vector<unsigned char> &data)
+{
+	InputTraceEncoder encoder;
+
+	encoder.putUnsigned(ADVERTISEMENT);
+	encoder.putUnsigned(address.toNumber());
+	encoder.putBytes(data);
+
+	return encoder.data();
+}
+
+string HciInputTrace::encodeRead(
+		Kind kind,
+		const MACAddress &address,
+		const UUID &uuid,
+		const vector<unsigned char> &data)
+{
+	InputTraceEncoder encoder;
+
+	encoder.putUnsigned(kind);
+	encoder.putUnsigned(address.toNumber());
+	encoder.putString(uuid.toString());
+	encoder.putBytes(data);
+
+	return encoder.data();
+}
+
+RecordingHciInterface::RecordingHciInterface(HciInterface::Ptr hci):
+	m_hci(hci)
+{
+}
+
+void RecordingHciInterface::up() const
+{
+	m_hci->up();
+}
+
+void RecordingHciInterface::reset() const
+{
+	m_hci->reset();
+}
+
+bool RecordingHciInterface::detect(const MACAddress &address) const
+{
+	return m_hci->detect(address);
+}
+
+map<MACAddress, string> RecordingHciInterface::scan() const
+{
+	return m_hci->scan();
+}
+
+void RecordingHciInterface::streamScan(const ScanCallback &callback) const
+{
+	m_hci->streamScan(callback);
+}
+
+map<MACAddress, string> RecordingHciInterface::lescan(
+		const Timespan &seconds) const
+{
+	const auto devices = m_hci->lescan(seconds);
+
+	InputTraceRecorder &recorder = InputTraceRecorder::instance();
+	if (recorder.active())
+		recorder.record(HciInputTrace::CHANNEL, HciInputTrace::encodeScan(devices));
+
+	return devices;
+}
+
+HciInfo RecordingHciInterface::info() const
+{
+	return m_hci->info();
+}
+
+HciConnection::Ptr RecordingHciInterface::connect(
+		const MACAddress& address,
+		const Timespan& timeout) const
+{
+	return new RecordingHciConnection(address, m_hci->connect(address, timeout));
+}
+
+void RecordingHciInterface::watch(
+		const MACAddress& address,
+		SharedPtr<WatchCallback> callBack)
+{
+	SharedPtr<WatchCallback> recording = new WatchCallback(
+		[callBack](const MACAddress &address, vector<unsigned char> &data) {
+			InputTraceRecorder &recorder = InputTraceRecorder::instance();
+			if (recorder.active()) {
+				recorder.record(HciInputTrace::CHANNEL,
+					HciInputTrace::encodeAdvertisement(address, data));
+			}
+
+			(*callBack)(address, data);
+		});
+
+	m_hci->watch(address, recording);
+}
+
+void RecordingHciInterface::unwatch(const MACAddress& address)
+{
+	m_hci->unwatch(address);
+}
+
+RecordingHciConnection::RecordingHciConnection(
+		const MACAddress &address,
+		HciConnection::Ptr connection):
+	m_address(address),
+	m_connection(connection)
+{
+}
+
+vector<unsigned char> RecordingHciConnection::read(const UUID& uuid)
+{
+	const auto value = m_connection->read(uuid);
+
+	InputTraceRecorder &recorder = InputTraceRecorder::instance();
+	if (recorder.active()) {
+		recorder.record(HciInputTrace::CHANNEL, HciInputTrace::encodeRead(
+			HciInputTrace::READ, m_address, uuid, value));
+	}
+
+	return value;
+}
+
+void RecordingHciConnection::write(
+		const UUID& uuid,
+		const vector<unsigned char>& value)
+{
+	m_connection->write(uuid, value);
+}
+
+vector<unsigned char> RecordingHciConnection::notifiedWrite(
+		const UUID& notifyUuid,
+		const UUID& writeUuid,
+		const vector<unsigned char>& value,
+		const Timespan& notifyTimeout)
+{
+	const auto result = m_connection->notifiedWrite(
+		notifyUuid, writeUuid, value, notifyTimeout);
+
+	InputTraceRecorder &recorder = InputTraceRecorder::instance();
+	if (recorder.active()) {
+		recorder.record(HciInputTrace::CHANNEL, HciInputTrace::encodeRead(
+			HciInputTrace::NOTIFIED_WRITE, m_address, notifyUuid, result));
+	}
+
+	return result;
+}
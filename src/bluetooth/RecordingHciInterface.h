@@ -0,0 +1,96 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/UUID.h>
+
+#include "bluetooth/HciConnection.h"
+#include "bluetooth/HciInterface.h"
+#include "net/MACAddress.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Encoding of BLE inputs stored in an input trace. The inputs
+ * are results of LE scans, advertising data of watched devices and
+ * values read from GATT characteristics.
+ */
+class HciInputTrace {
+public:
+	static const std::string CHANNEL;
+
+	enum Kind {
+		LESCAN = 0,
+		ADVERTISEMENT = 1,
+		READ = 2,
+		NOTIFIED_WRITE = 3,
+	};
+
+	static std::string encodeScan(
+		const std::map<MACAddress, std::string> &devices);
+	static std::string encodeAdvertisement(
+		const MACAddress &address,
+		const std::vector<unsigned char> &data);
+	static std::string encodeRead(
+		Kind kind,
+		const MACAddress &address,
+		const Poco::UUID &uuid,
+		const std::vector<unsigned char> &data);
+};
+
+/**
+ * @brief Decorator of an HciInterface that records LE scans, received
+ * advertising data and values read via connections into the process-wide
+ * InputTraceRecorder. Unless the recording is active, the calls are just
+ * forwarded to the decorated interface.
+ */
+class RecordingHciInterface : public HciInterface {
+public:
+	RecordingHciInterface(HciInterface::Ptr hci);
+
+	void up() const override;
+	void reset() const override;
+	bool detect(const MACAddress &address) const override;
+	std::map<MACAddress, std::string> scan() const override;
+	void streamScan(const ScanCallback &callback) const override;
+	std::map<MACAddress, std::string> lescan(
+			const Poco::Timespan &seconds) const override;
+	HciInfo info() const override;
+	HciConnection::Ptr connect(
+		const MACAddress& address,
+		const Poco::Timespan& timeout) const override;
+	void watch(
+		const MACAddress& address,
+		Poco::SharedPtr<WatchCallback> callBack) override;
+	void unwatch(const MACAddress& address) override;
+
+private:
+	HciInterface::Ptr m_hci;
+};
+
+class RecordingHciConnection : public HciConnection {
+public:
+	RecordingHciConnection(
+		const MACAddress &address,
+		HciConnection::Ptr connection);
+
+	std::vector<unsigned char> read(const Poco::UUID& uuid) override;
+	void write(
+		const Poco::UUID& uuid,
+		const std::vector<unsigned char>& value) override;
+	std::vector<unsigned char> notifiedWrite(
+		const Poco::UUID& notifyUuid,
+		const Poco::UUID& writeUuid,
+		const std::vector<unsigned char>& value,
+		const Poco::Timespan& notifyTimeout) override;
+
+private:
+	MACAddress m_address;
+	HciConnection::Ptr m_connection;
+};
+
+}
@@ -0,0 +1,211 @@
+#include <Poco/Exception.h>
+
+#include "bluetooth/RecordingHciInterface.h"
+#include "bluetooth/ReplayHciInterface.h"
+#include "di/Injectable.h"
+#include "util/InputTrace.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, ReplayHciInterfaceManager)
+BEEEON_OBJECT_CASTABLE(HciInterfaceManager)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_PROPERTY("tracePath", &ReplayHciInterfaceManager::setTracePath)
+BEEEON_OBJECT_PROPERTY("speed", &ReplayHciInterfaceManager::setSpeed)
+BEEEON_OBJECT_END(BeeeOn, ReplayHciInterfaceManager)
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+void ReplayHciInterface::up() const
+{
+}
+
+void ReplayHciInterface::reset() const
+{
+}
+
+bool ReplayHciInterface::detect(const MACAddress &address) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_seen.find(address) != m_seen.end();
+}
+
+map<MACAddress, string> ReplayHciInterface::scan() const
+{
+	return {};
+}
+
+map<MACAddress, string> ReplayHciInterface::lescan(const Timespan &) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_scanned;
+}
+
+HciInfo ReplayHciInterface::info() const
+{
+	throw NotImplementedException("info is not available for replayed HCI");
+}
+
+HciConnection::Ptr ReplayHciInterface::connect(
+		const MACAddress& address,
+		const Timespan&) const
+{
+	if (!detect(address))
+		throw IOException("device " + address.toString(':') + " is not available");
+
+	return new ReplayHciConnection(address, *this);
+}
+
+void ReplayHciInterface::watch(
+		const MACAddress& address,
+		SharedPtr<WatchCallback> callBack)
+{
+	FastMutex::ScopedLock guard(m_lock);
+	m_watched[address] = callBack;
+}
+
+void ReplayHciInterface::unwatch(const MACAddress& address)
+{
+	FastMutex::ScopedLock guard(m_lock);
+	m_watched.erase(address);
+}
+
+void ReplayHciInterface::feed(const string &payload)
+{
+	InputTraceDecoder decoder(payload);
+	const UInt64 kind = decoder.getUnsigned();
+
+	switch (kind) {
+	case HciInputTrace::LESCAN: {
+		map<MACAddress, string> devices;
+
+		for (UInt64 count = decoder.getUnsigned(); count > 0; --count) {
+			const MACAddress address(decoder.getUnsigned());
+			devices.emplace(address, decoder.getString());
+		}
+
+		FastMutex::ScopedLock guard(m_lock);
+		for (const auto &pair : devices)
+			m_seen.emplace(pair.first);
+
+		m_scanned = devices;
+		break;
+	}
+
+	case HciInputTrace::ADVERTISEMENT: {
+		const MACAddress address(decoder.getUnsigned());
+		vector<unsigned char> data = decoder.getBytes();
+		SharedPtr<WatchCallback> callback;
+
+		{
+			FastMutex::ScopedLock guard(m_lock);
+			m_seen.emplace(address);
+
+			auto it = m_watched.find(address);
+			if (it != m_watched.end())
+				callback = it->second;
+		}
+
+		// the callback is called without the lock held as
+		// it might call watch() or unwatch()
+		if (!callback.isNull())
+			(*callback)(address, data);
+
+		break;
+	}
+
+	case HciInputTrace::READ:
+	case HciInputTrace::NOTIFIED_WRITE: {
+		const MACAddress address(decoder.getUnsigned());
+		const string uuid = decoder.getString();
+
+		FastMutex::ScopedLock guard(m_lock);
+		m_seen.emplace(address);
+		m_values[make_pair(address, uuid)] = decoder.getBytes();
+		break;
+	}
+
+	default:
+		throw DataFormatException("unknown BLE input " + to_string(kind));
+	}
+}
+
+vector<unsigned char> ReplayHciInterface::lastValue(
+		const MACAddress &address,
+		const UUID &uuid) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto it = m_values.find(make_pair(address, uuid.toString()));
+	if (it == m_values.end()) {
+		throw NotFoundException("no value of " + uuid.toString()
+			+ " recorded for " + address.toString(':'));
+	}
+
+	return it->second;
+}
+
+ReplayHciConnection::ReplayHciConnection(
+		const MACAddress &address,
+		const ReplayHciInterface &hci):
+	m_address(address),
+	m_hci(hci)
+{
+}
+
+vector<unsigned char> ReplayHciConnection::read(const UUID& uuid)
+{
+	return m_hci.lastValue(m_address, uuid);
+}
+
+void ReplayHciConnection::write(
+		const UUID&,
+		const vector<unsigned char>&)
+{
+}
+
+vector<unsigned char> ReplayHciConnection::notifiedWrite(
+		const UUID& notifyUuid,
+		const UUID&,
+		const vector<unsigned char>&,
+		const Timespan&)
+{
+	return m_hci.lastValue(m_address, notifyUuid);
+}
+
+ReplayHciInterfaceManager::ReplayHciInterfaceManager():
+	m_hci(new ReplayHciInterface)
+{
+}
+
+void ReplayHciInterfaceManager::setTracePath(const string &path)
+{
+	m_replayer.setTracePath(path);
+}
+
+void ReplayHciInterfaceManager::setSpeed(int speed)
+{
+	m_replayer.setSpeed(speed);
+}
+
+HciInterface::Ptr ReplayHciInterfaceManager::lookup(const string &)
+{
+	return m_hci;
+}
+
+void ReplayHciInterfaceManager::run()
+{
+	StopControl::Run run(m_stopControl);
+
+	m_replayer.replay(
+		HciInputTrace::CHANNEL,
+		[&](const InputTraceRecord &record) {
+			m_hci->feed(record.payload());
+		},
+		m_stopControl);
+}
+
+void ReplayHciInterfaceManager::stop()
+{
+	m_stopControl.requestStop();
+}
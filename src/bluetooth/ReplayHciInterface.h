@@ -0,0 +1,128 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/UUID.h>
+
+#include "bluetooth/HciConnection.h"
+#include "bluetooth/HciInterface.h"
+#include "loop/StopControl.h"
+#include "loop/StoppableRunnable.h"
+#include "net/MACAddress.h"
+#include "util/InputTraceReplayer.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief HciInterface fed by inputs recorded via the RecordingHciInterface.
+ * Advertising data are delivered to the watching callbacks at the recorded
+ * timing. LE scans and reads of characteristics return the most recent
+ * recorded results. All writes succeed.
+ */
+class ReplayHciInterface : public HciInterface {
+public:
+	typedef Poco::SharedPtr<ReplayHciInterface> Ptr;
+
+	void up() const override;
+	void reset() const override;
+	bool detect(const MACAddress &address) const override;
+	std::map<MACAddress, std::string> scan() const override;
+	std::map<MACAddress, std::string> lescan(
+			const Poco::Timespan &seconds) const override;
+
+	/**
+	 * @throws Poco::NotImplementedException
+	 */
+	HciInfo info() const override;
+
+	/**
+	 * @throws Poco::IOException when the device has not been seen yet
+	 */
+	HciConnection::Ptr connect(
+		const MACAddress& address,
+		const Poco::Timespan& timeout) const override;
+	void watch(
+		const MACAddress& address,
+		Poco::SharedPtr<WatchCallback> callBack) override;
+	void unwatch(const MACAddress& address) override;
+
+	/**
+	 * Process a single recorded input.
+	 */
+	void feed(const std::string &payload);
+
+	/**
+	 * @throws Poco::NotFoundException when no value was recorded
+	 */
+	std::vector<unsigned char> lastValue(
+		const MACAddress &address,
+		const Poco::UUID &uuid) const;
+
+private:
+	typedef std::pair<MACAddress, std::string> CharacteristicKey;
+
+	mutable Poco::FastMutex m_lock;
+	std::map<MACAddress, std::string> m_scanned;
+	std::set<MACAddress> m_seen;
+	std::map<CharacteristicKey, std::vector<unsigned char>> m_values;
+	std::map<MACAddress, Poco::SharedPtr<WatchCallback>> m_watched;
+};
+
+class ReplayHciConnection : public HciConnection {
+public:
+	ReplayHciConnection(
+		const MACAddress &address,
+		const ReplayHciInterface &hci);
+
+	std::vector<unsigned char> read(const Poco::UUID& uuid) override;
+	void write(
+		const Poco::UUID& uuid,
+		const std::vector<unsigned char>& value) override;
+	std::vector<unsigned char> notifiedWrite(
+		const Poco::UUID& notifyUuid,
+		const Poco::UUID& writeUuid,
+		const std::vector<unsigned char>& value,
+		const Poco::Timespan& notifyTimeout) override;
+
+private:
+	MACAddress m_address;
+	const ReplayHciInterface &m_hci;
+};
+
+/**
+ * @brief Provides a single ReplayHciInterface regardless of the requested
+ * name and replays the configured trace into it while running.
+ */
+class ReplayHciInterfaceManager :
+	public HciInterfaceManager,
+	public StoppableRunnable {
+public:
+	ReplayHciInterfaceManager();
+
+	void setTracePath(const std::string &path);
+
+	/**
+	 * Speed of replaying relative to the recorded timing,
+	 * 0 to replay as fast as possible.
+	 */
+	void setSpeed(int speed);
+
+	HciInterface::Ptr lookup(const std::string &name) override;
+
+	void run() override;
+	void stop() override;
+
+private:
+	ReplayHciInterface::Ptr m_hci;
+	InputTraceReplayer m_replayer;
+	StopControl m_stopControl;
+};
+
+}
@@ -6,6 +6,8 @@
 #include "core/Exporter.h"
 #include "model/SensorData.h"
 
+using namespace std;
+using namespace Poco;
 using namespace BeeeOn;
 
 void AbstractDistributor::registerExporter(Poco::SharedPtr<Exporter> exporter)
@@ -24,6 +26,55 @@ void AbstractDistributor::registerListener(DistributorListener::Ptr listener)
 	m_eventSource.addListener(listener);
 }
 
+void AbstractDistributor::registerFilter(DistributorFilter::Ptr filter)
+{
+	m_filters.push_back(filter);
+}
+
+const SensorData *AbstractDistributor::applyFilters(
+		const SensorData &data,
+		SensorData &buffer)
+{
+	if (m_filters.empty())
+		return &data;
+
+	buffer = data;
+
+	for (auto filter : m_filters) {
+		if (!filter->filter(buffer))
+			return nullptr;
+	}
+
+	return &buffer;
+}
+
+size_t AbstractDistributor::releaseFilters(
+		vector<SensorData> &released,
+		const Timestamp &until)
+{
+	const size_t first = released.size();
+	vector<SensorData> pending;
+
+	for (size_t i = 0; i < m_filters.size(); ++i) {
+		pending.clear();
+
+		if (m_filters[i]->release(pending, until) == 0)
+			continue;
+
+		for (auto &data : pending) {
+			bool passed = true;
+
+			for (size_t j = i + 1; passed && j < m_filters.size(); ++j)
+				passed = m_filters[j]->filter(data);
+
+			if (passed)
+				released.emplace_back(data);
+		}
+	}
+
+	return released.size() - first;
+}
+
 void AbstractDistributor::setExecutor(AsyncExecutor::Ptr executor)
 {
 	m_eventSource.setAsyncExecutor(executor);
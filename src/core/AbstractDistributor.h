@@ -3,8 +3,10 @@
 #include <vector>
 
 #include <Poco/SharedPtr.h>
+#include <Poco/Timestamp.h>
 
 #include "core/Distributor.h"
+#include "core/DistributorFilter.h"
 #include "core/DistributorListener.h"
 #include "util/EventSource.h"
 #include "util/Loggable.h"
@@ -24,6 +26,12 @@ public:
 
 	void registerListener(DistributorListener::Ptr listener);
 
+	/*
+	 * Register filter. Data are passed through all registered
+	 * filters in order of registration before being exported.
+	 */
+	void registerFilter(DistributorFilter::Ptr filter);
+
 	/*
 	 * Set executor instance for asynchronous data transfer to
 	 * listeners.
@@ -37,7 +45,24 @@ protected:
 	 */
 	void notifyListeners(const SensorData &data);
 
+	/*
+	 * Pass the data through registered filters. The filtered data
+	 * are stored into the given buffer unless there are no filters.
+	 * Returns data to be exported or nullptr when nothing is left.
+	 */
+	const SensorData *applyFilters(const SensorData &data, SensorData &buffer);
+
+	/*
+	 * Collect data released by the registered filters until the given
+	 * time. Data released by a filter are passed through the filters
+	 * registered after it. Returns count of data appended to released.
+	 */
+	size_t releaseFilters(
+		std::vector<SensorData> &released,
+		const Poco::Timestamp &until);
+
 	std::vector<Poco::SharedPtr<Exporter>> m_exporters;
+	std::vector<DistributorFilter::Ptr> m_filters;
 	EventSource<DistributorListener> m_eventSource;
 };
 
@@ -2,14 +2,23 @@
 #include <Poco/Logger.h>
 
 #include "core/AbstractSeeker.h"
+#include "util/SamplingProfiler.h"
 
+using namespace std;
 using namespace Poco;
 using namespace BeeeOn;
 
 AbstractSeeker::AbstractSeeker(const Timespan &duration):
 	m_duration(duration),
-	m_runnable(*this, &AbstractSeeker::seek),
+	m_runnable(*this, &AbstractSeeker::runThread),
 	m_hasStarted(false),
+	m_queued(false),
+	m_running(false),
+	m_finished(false),
+	m_passes(0),
+	m_jobPasses(0),
+	m_yielded(false),
+	m_finishedEvent(false),
 	m_joiner(m_thread)
 {
 }
@@ -33,7 +42,7 @@ Timespan AbstractSeeker::remaining() const
 {
 	FastMutex::ScopedLock guard(m_lock);
 
-	if (m_hasStarted && !m_thread.isRunning())
+	if (m_hasStarted && m_finished)
 		return 0;
 
 	else if (!m_hasStarted)
@@ -50,33 +59,138 @@ void AbstractSeeker::start()
 {
 	FastMutex::ScopedLock guard(m_lock);
 
-	if (m_thread.isRunning())
+	if (m_thread.isRunning() || m_queued)
 		throw IllegalStateException("seeker is already running");
 
 	if (m_hasStarted)
 		throw IllegalStateException("seeker cannot be started twice");
 
+	m_started.update();
+	m_hasStarted = true;
+
 	m_thread.start(m_runnable);
 }
 
+void AbstractSeeker::enqueued()
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_hasStarted)
+		throw IllegalStateException("seeker cannot be started twice");
+
+	m_started.update();
+	m_hasStarted = true;
+	m_queued = true;
+}
+
 bool AbstractSeeker::tryJoin(const Timespan &timeout)
 {
+	bool queued;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		queued = m_queued;
+	}
+
+	if (queued)
+		return m_finishedEvent.tryWait(timeout.totalMilliseconds());
+
 	return m_joiner.tryJoin(timeout);
 }
 
 void AbstractSeeker::cancel()
 {
 	m_stopControl.requestStop();
-	m_joiner.join();
+
+	bool queued;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		queued = m_queued;
+
+		// a waiting seeker would be skipped by the executor
+		if (queued && !m_running && !m_finished) {
+			m_finished = true;
+			m_finishedEvent.set();
+			return;
+		}
+	}
+
+	if (queued)
+		m_finishedEvent.wait();
+	else
+		m_joiner.join();
 }
 
-void AbstractSeeker::seek()
+void AbstractSeeker::runThread()
+{
+	perform();
+}
+
+bool AbstractSeeker::perform(const function<bool()> &contended)
 {
 	{
 		FastMutex::ScopedLock guard(m_lock);
-		m_started.update();
-		m_hasStarted = true;
+
+		if (m_finished)
+			return false;
+
+		m_running = true;
 	}
 
+	// the members are accessed only by the thread performing the seeker
+	m_contended = contended;
+	m_jobPasses = 0;
+	m_yielded = false;
+
+	if (!m_stopControl.shouldStop()) {
+		try {
+			seek();
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_yielded && !m_stopControl.shouldStop()) {
+		m_running = false;
+		return true;
+	}
+
+	m_finished = true;
+	m_finishedEvent.set();
+	return false;
+}
+
+bool AbstractSeeker::nextPass()
+{
+	if (m_stopControl.shouldStop())
+		return false;
+
+	bool queued;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		queued = m_queued;
+	}
+
+	if (remaining() <= 0 && (!queued || m_passes > 0))
+		return false;
+
+	// the contended callback locks the executor, never call it
+	// while holding m_lock
+	if (m_jobPasses > 0 && m_contended && m_contended()) {
+		m_yielded = true;
+		return false;
+	}
+
+	++m_passes;
+	++m_jobPasses;
+	return true;
+}
+
+void AbstractSeeker::seek()
+{
+	SamplingProfiler::labelThread("seeker");
 	seekLoop(m_stopControl);
 }
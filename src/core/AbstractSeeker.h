@@ -1,6 +1,9 @@
 #pragma once
 
+#include <functional>
+
 #include <Poco/Clock.h>
+#include <Poco/Event.h>
 #include <Poco/Mutex.h>
 #include <Poco/RunnableAdapter.h>
 #include <Poco/SharedPtr.h>
@@ -14,15 +17,27 @@
 
 namespace BeeeOn {
 
+class DiscoveryExecutor;
+
 /**
  * @brief AbstractSeeker represents an asynchronous process that seeks
  * for new devices in a certain network. It is basically a thread that
  * performs some technology-specific routines to discover new devices.
  *
+ * The seeker either runs in a dedicated thread (start()) or it is
+ * executed by a shared DiscoveryExecutor. In the latter case, the
+ * duration is counted since the seeker was queued and cancelling
+ * a seeker still waiting in the queue does not wait for the executor.
+ * Seekers loop by nextPass() so that a seeker executed by the
+ * DiscoveryExecutor yields its thread between passes whenever other
+ * seekers are waiting. Thus, all seekers get to seek even if there
+ * are more of them than threads of the executor.
+ *
  * A single AbstractSeeker instance can perform only 1 seek. For every
  * other seek a new AbstractSeeker must be created.
  */
 class AbstractSeeker : public AsyncWork<>, protected Loggable {
+	friend class DiscoveryExecutor;
 public:
 	typedef Poco::SharedPtr<AbstractSeeker> Ptr;
 
@@ -54,7 +69,8 @@ public:
 	void start();
 
 	/**
-	 * @brief Join the seeking thread via Joiner.
+	 * @brief Join the seeking thread via Joiner or wait until
+	 * the executor finishes the seeker.
 	 */
 	bool tryJoin(const Poco::Timespan &timeout) override;
 
@@ -65,8 +81,43 @@ public:
 
 protected:
 	void seek();
+
+	/**
+	 * @brief Seek for devices until remaining() is 0 or the seeking
+	 * is stopped. Implementations are expected to perform a single
+	 * discovery round per iteration of while (nextPass()) {...}.
+	 */
 	virtual void seekLoop(StopControl &control) = 0;
 
+	/**
+	 * @brief Decide whether to perform the next pass of the seekLoop().
+	 * A seeker of a DiscoveryExecutor that has waited in the queue for
+	 * its whole duration still performs a single pass.
+	 *
+	 * @returns false when the seeking is over, stopped or when the
+	 * seeker should yield to other seekers waiting in the executor
+	 */
+	bool nextPass();
+
+private:
+	/**
+	 * @brief Mark the seeker as started by a DiscoveryExecutor.
+	 * @throws Poco::IllegalStateException in case the seeker was already started.
+	 */
+	void enqueued();
+
+	void runThread();
+
+	/**
+	 * @brief Perform the seeking unless it has been cancelled.
+	 * The contended callback tells whether other seekers are waiting
+	 * for a thread. In such case, the seeker yields after a pass.
+	 *
+	 * @returns true when the seeker has yielded and it should be
+	 * performed again later, false when it has finished
+	 */
+	bool perform(const std::function<bool()> &contended = {});
+
 private:
 	Poco::Timespan m_duration;
 	Poco::RunnableAdapter<AbstractSeeker> m_runnable;
@@ -74,6 +125,14 @@ private:
 	mutable Poco::FastMutex m_lock;
 	Poco::Clock m_started;
 	bool m_hasStarted;
+	bool m_queued;
+	bool m_running;
+	bool m_finished;
+	std::function<bool()> m_contended;
+	unsigned int m_passes;
+	unsigned int m_jobPasses;
+	bool m_yielded;
+	Poco::Event m_finishedEvent;
 	StopControl m_stopControl;
 	Joiner m_joiner;
 };
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/NumberParser.h>
+#include <Poco/String.h>
+#include <Poco/StringTokenizer.h>
+
+#include "core/AggregationFilter.h"
+#include "di/Injectable.h"
+#include "model/DevicePrefix.h"
+#include "model/SensorData.h"
+#include "util/MetricsRegistry.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, AggregationFilter)
+BEEEON_OBJECT_CASTABLE(DistributorFilter)
+BEEEON_OBJECT_PROPERTY("rules", &AggregationFilter::setRules)
+BEEEON_OBJECT_PROPERTY("grace", &AggregationFilter::setGrace)
+BEEEON_OBJECT_END(BeeeOn, AggregationFilter)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+static const string ANY = "*";
+static const Int64 NO_END = numeric_limits<Int64>::max();
+
+static Timespan parseWindow(const string &input)
+{
+	string spec = trim(input);
+	Timespan unit;
+
+	if (spec.empty())
+		throw SyntaxException("missing window");
+
+	switch (spec.back()) {
+	case 's':
+		unit = 1 * Timespan::SECONDS;
+		break;
+	case 'm':
+		unit = 1 * Timespan::MINUTES;
+		break;
+	case 'h':
+		unit = 1 * Timespan::HOURS;
+		break;
+	default:
+		throw SyntaxException("window must end with s, m or h: " + spec);
+	}
+
+	spec.pop_back();
+
+	unsigned int count;
+	if (!NumberParser::tryParseUnsigned(trim(spec), count) || count == 0)
+		throw SyntaxException("invalid window: " + input);
+
+	return count * unit.totalMicroseconds();
+}
+
+static AggregationFilter::Function parseFunction(const string &spec)
+{
+	if (spec == "min")
+		return AggregationFilter::FUNCTION_MIN;
+	if (spec == "max")
+		return AggregationFilter::FUNCTION_MAX;
+	if (spec == "mean")
+		return AggregationFilter::FUNCTION_MEAN;
+	if (spec == "last")
+		return AggregationFilter::FUNCTION_LAST;
+
+	throw SyntaxException("unsupported aggregation function: " + spec);
+}
+
+AggregationFilter::Rule AggregationFilter::Rule::parse(const string &spec)
+{
+	const StringTokenizer fields(spec, ":", StringTokenizer::TOK_TRIM);
+	if (fields.count() != 4)
+		throw SyntaxException("expected <device>:<module>:<function>:<window>: " + spec);
+
+	Rule rule;
+
+	try {
+		const string &device = fields[0];
+
+		if (device == ANY) {
+			rule.match = MATCH_ANY;
+		}
+		else if (device.substr(0, 2) == "0x" && device.size() > 4) {
+			rule.match = MATCH_DEVICE;
+			rule.device = DeviceID::parse(device);
+		}
+		else if (device.substr(0, 2) == "0x") {
+			rule.match = MATCH_PREFIX;
+			rule.device = DeviceID(DevicePrefix::fromRaw(NumberParser::parseHex(device)), 0);
+		}
+		else {
+			rule.match = MATCH_PREFIX;
+			rule.device = DeviceID(DevicePrefix::parse(device), 0);
+		}
+	}
+	catch (const Exception &e) {
+		throw SyntaxException("invalid device: " + spec, e);
+	}
+
+	if (fields[1] != ANY) {
+		rule.anyModule = false;
+
+		try {
+			rule.module = ModuleID::parse(fields[1]);
+		}
+		catch (const Exception &e) {
+			throw SyntaxException("invalid module: " + spec, e);
+		}
+	}
+
+	rule.function = parseFunction(fields[2]);
+	rule.window = parseWindow(fields[3]);
+
+	return rule;
+}
+
+bool AggregationFilter::Rule::matches(
+		const DeviceID &device,
+		const ModuleID &module) const
+{
+	if (!anyModule && !(this->module == module))
+		return false;
+
+	switch (match) {
+	case MATCH_PREFIX:
+		return this->device.prefix() == device.prefix();
+	case MATCH_DEVICE:
+		return this->device == device;
+	default:
+		return true;
+	}
+}
+
+Int64 AggregationFilter::Rule::windowOf(Int64 at) const
+{
+	return at - at % window.totalMicroseconds();
+}
+
+void AggregationFilter::SeriesState::start(Int64 window)
+{
+	this->window = window;
+	count = 0;
+	sum = 0;
+}
+
+void AggregationFilter::SeriesState::add(double value, Int64 at)
+{
+	if (count == 0)
+		first = at;
+
+	if (count == 0 || value < min)
+		min = value;
+	if (count == 0 || value > max)
+		max = value;
+
+	count += 1;
+	sum += value;
+	last = value;
+}
+
+double AggregationFilter::SeriesState::result(Function function) const
+{
+	switch (function) {
+	case FUNCTION_MIN:
+		return min;
+	case FUNCTION_MAX:
+		return max;
+	case FUNCTION_MEAN:
+		return sum / count;
+	default:
+		return last;
+	}
+}
+
+bool AggregationFilter::SeriesState::late(Int64 window) const
+{
+	if (window <= released)
+		return true;
+
+	return count > 0 && window < this->window;
+}
+
+Int64 AggregationFilter::SeriesState::stamp() const
+{
+	return count == 1 ? first : window;
+}
+
+AggregationFilter::AggregationFilter():
+	m_grace(0),
+	m_series(256),
+	m_nextEnd(NO_END),
+	m_aggregated(MetricsRegistry::instance().counter(
+		"beeeon_aggregation_filter_samples_total",
+		"Samples absorbed into windows of the AggregationFilter")),
+	m_windows(MetricsRegistry::instance().counter(
+		"beeeon_aggregation_filter_windows_total",
+		"Aggregated values exported by the AggregationFilter"))
+{
+}
+
+AggregationFilter::~AggregationFilter()
+{
+}
+
+void AggregationFilter::setRules(const list<string> &rules)
+{
+	vector<Rule> parsed;
+
+	for (const auto &spec : rules)
+		parsed.emplace_back(Rule::parse(spec));
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	m_rules = parsed;
+	m_series.clear();
+	m_nextEnd = NO_END;
+}
+
+void AggregationFilter::setGrace(const Timespan &grace)
+{
+	if (grace < 0)
+		throw InvalidArgumentException("grace must not be negative");
+
+	FastMutex::ScopedLock guard(m_lock);
+	m_grace = grace;
+}
+
+int AggregationFilter::resolve(
+		const DeviceID &device,
+		const ModuleID &module) const
+{
+	for (size_t i = 0; i < m_rules.size(); ++i) {
+		if (m_rules[i].matches(device, module))
+			return static_cast<int>(i);
+	}
+
+	return -1;
+}
+
+bool AggregationFilter::aggregate(
+		const SensorSeries &series,
+		SeriesState &state,
+		const Rule &rule,
+		double value,
+		Int64 at)
+{
+	const Int64 window = rule.windowOf(at);
+	bool closed = false;
+
+	if (state.count > 0 && state.window != window) {
+		close(series, state, rule);
+		closed = true;
+	}
+
+	if (state.count == 0) {
+		state.start(window);
+		m_nextEnd = min(m_nextEnd, window
+			+ rule.window.totalMicroseconds()
+			+ m_grace.totalMicroseconds());
+	}
+
+	state.add(value, at);
+	return closed;
+}
+
+void AggregationFilter::close(
+		const SensorSeries &series,
+		SeriesState &state,
+		const Rule &rule)
+{
+	const Timestamp at(state.stamp());
+	const SensorValue value(series.module, state.result(rule.function));
+
+	// results closed at once by the same data share the timestamp
+	if (!m_closed.empty() && m_closed.back().deviceID() == series.device
+			&& m_closed.back().timestamp().value() == at) {
+		m_closed.back().insertValue(value);
+	}
+	else {
+		SensorData data;
+		data.setDeviceID(series.device);
+		data.setTimestamp(at);
+		data.insertValue(value);
+
+		m_closed.emplace_back(data);
+	}
+
+	state.released = state.window;
+	state.start(0);
+}
+
+bool AggregationFilter::filter(SensorData &data)
+{
+	const Int64 at = data.timestamp().value().epochMicroseconds();
+	SensorData reduced;
+	bool reducing = false;
+	size_t total = 0;
+	size_t windows = 0;
+	size_t absorbed = 0;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		if (m_rules.empty())
+			return true;
+
+		for (const auto &item : data) {
+			const SensorSeries series = {data.deviceID(), item.moduleID()};
+			SeriesState &state = *m_series.emplace(series).first;
+
+			if (!state.resolved) {
+				state.rule = resolve(data.deviceID(), item.moduleID());
+				state.resolved = true;
+			}
+
+			total += 1;
+
+			const bool valid = item.isValid() && !std::isnan(item.value());
+
+			// samples of released windows are not aggregated again
+			if (state.rule < 0 || !valid
+					|| state.late(m_rules[state.rule].windowOf(at))) {
+				if (reducing)
+					reduced.insertValue(item);
+
+				continue;
+			}
+
+			// copy the data only when some value is aggregated
+			if (!reducing) {
+				reducing = true;
+				reduced.setDeviceID(data.deviceID());
+				reduced.setTimestamp(data.timestamp());
+
+				size_t i = 0;
+				for (const auto &previous : data) {
+					if (++i == total)
+						break;
+
+					reduced.insertValue(previous);
+				}
+			}
+
+			if (aggregate(series, state, m_rules[state.rule], item.value(), at))
+				windows += 1;
+
+			absorbed += 1;
+		}
+	}
+
+	m_aggregated.inc(absorbed);
+	m_windows.inc(windows);
+
+	if (!reducing)
+		return true;
+	if (absorbed == total)
+		return false;
+
+	data = reduced;
+	return true;
+}
+
+size_t AggregationFilter::release(
+		vector<SensorData> &released,
+		const Timestamp &until)
+{
+	const Int64 limit = until.epochMicroseconds();
+	size_t windows = 0;
+	size_t count;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		if (limit >= m_nextEnd) {
+			Int64 next = NO_END;
+
+			m_series.forEach([&](const SensorSeries &series, SeriesState &state) {
+				if (state.count == 0 || state.rule < 0)
+					return;
+
+				const Rule &rule = m_rules[state.rule];
+				const Int64 deadline = state.window
+					+ rule.window.totalMicroseconds()
+					+ m_grace.totalMicroseconds();
+
+				if (deadline <= limit) {
+					close(series, state, rule);
+					windows += 1;
+				}
+				else {
+					next = min(next, deadline);
+				}
+			});
+
+			m_nextEnd = next;
+		}
+
+		count = m_closed.size();
+
+		for (auto &data : m_closed)
+			released.emplace_back(std::move(data));
+
+		m_closed.clear();
+	}
+
+	m_windows.inc(windows);
+	return count;
+}
+
+size_t AggregationFilter::size() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_series.size();
+}
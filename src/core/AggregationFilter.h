@@ -0,0 +1,194 @@
+#pragma once
+
+#include <limits>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "core/DistributorFilter.h"
+#include "core/SensorSeries.h"
+#include "model/DeviceID.h"
+#include "model/ModuleID.h"
+#include "model/SensorData.h"
+#include "util/FlatHashMap.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+class MetricCounter;
+
+/**
+ * @brief AggregationFilter downsamples modules that are reported much
+ * more often than needed (e.g. pressure sensors, IIO sensors or power
+ * meters polled every second). Values of a matching module are
+ * aggregated over tumbling windows aligned to the epoch and a single
+ * value (min, max, mean or last) is exported per window instead of
+ * every sample. Values of modules not matching any rule pass through
+ * unchanged, as well as invalid values.
+ *
+ * The filter keeps only a constant state per module. A window is
+ * closed by the first sample of a later window or when the grace
+ * period after its end is over and the Distributor asks for released
+ * data. The aggregated value is released as separate data stamped with
+ * the start of its window. A window holding a single sample releases
+ * the sample unchanged (with its own timestamp). A sample arriving
+ * after its window has been released (or after a later window has
+ * started) passes through unaggregated.
+ */
+class AggregationFilter :
+	public DistributorFilter,
+	protected Loggable {
+public:
+	typedef Poco::SharedPtr<AggregationFilter> Ptr;
+
+	enum Function {
+		FUNCTION_MIN,
+		FUNCTION_MAX,
+		FUNCTION_MEAN,
+		FUNCTION_LAST,
+	};
+
+	struct Rule {
+		enum DeviceMatch {
+			MATCH_ANY,
+			MATCH_PREFIX,
+			MATCH_DEVICE,
+		};
+
+		DeviceMatch match = MATCH_ANY;
+		/**
+		 * Only prefix of the device is significant
+		 * for MATCH_PREFIX.
+		 */
+		DeviceID device;
+		bool anyModule = true;
+		ModuleID module;
+		Function function = FUNCTION_MEAN;
+		Poco::Timespan window;
+
+		/**
+		 * @brief Parse rule specification
+		 * "<device>:<module>:<function>:<window>". The device is
+		 * either "*", a device prefix (name or hex like "0xa2")
+		 * or a device ID (like "0xa200000000000001"). The module
+		 * is either "*" or a module ID. The function is one of
+		 * min, max, mean and last. The window is a positive count
+		 * of s, m or h (e.g. "30 s" or "5m").
+		 * @throws Poco::SyntaxException
+		 */
+		static Rule parse(const std::string &spec);
+
+		bool matches(const DeviceID &device, const ModuleID &module) const;
+
+		/**
+		 * @returns start of the window the given time belongs to
+		 */
+		Poco::Int64 windowOf(Poco::Int64 at) const;
+	};
+
+	AggregationFilter();
+	~AggregationFilter();
+
+	/**
+	 * @brief Set rules as list of specifications. The first rule
+	 * matching a module applies.
+	 * @see Rule::parse()
+	 */
+	void setRules(const std::list<std::string> &rules);
+
+	/**
+	 * @brief Time to wait after the end of a window for its delayed
+	 * samples before the window is released.
+	 */
+	void setGrace(const Poco::Timespan &grace);
+
+	bool filter(SensorData &data) override;
+
+	/**
+	 * @brief Release values of windows closed by later samples
+	 * and of windows whose grace period is over at the given time.
+	 */
+	size_t release(
+		std::vector<SensorData> &released,
+		const Poco::Timestamp &until) override;
+
+	/**
+	 * @returns count of modules seen since the rules were set
+	 */
+	size_t size() const;
+
+protected:
+	struct SeriesState {
+		/**
+		 * Index of the rule or -1 when no rule matches.
+		 */
+		int rule = -1;
+		bool resolved = false;
+		Poco::Int64 window = 0;
+		/**
+		 * Time of the first sample of the window.
+		 */
+		Poco::Int64 first = 0;
+		unsigned int count = 0;
+		double min = 0;
+		double max = 0;
+		double sum = 0;
+		double last = 0;
+		/**
+		 * Start of the last released window.
+		 */
+		Poco::Int64 released = std::numeric_limits<Poco::Int64>::min();
+
+		void start(Poco::Int64 window);
+		void add(double value, Poco::Int64 at);
+		double result(Function function) const;
+
+		/**
+		 * @returns true if the given window has been already released
+		 * or it precedes the window being collected
+		 */
+		bool late(Poco::Int64 window) const;
+
+		/**
+		 * @returns timestamp of the window result
+		 */
+		Poco::Int64 stamp() const;
+	};
+
+	int resolve(const DeviceID &device, const ModuleID &module) const;
+
+	/**
+	 * @brief Add the value into the window of the series. When the
+	 * value belongs to a later window, the current one is closed.
+	 * @returns true when a window has been closed
+	 */
+	bool aggregate(const SensorSeries &series, SeriesState &state,
+		const Rule &rule, double value, Poco::Int64 at);
+
+	/**
+	 * @brief Append result of the window of the series into
+	 * the released data.
+	 */
+	void close(const SensorSeries &series, SeriesState &state,
+		const Rule &rule);
+
+private:
+	std::vector<Rule> m_rules;
+	Poco::Timespan m_grace;
+	FlatHashMap<SensorSeries, SeriesState, SensorSeries::Hash> m_series;
+	std::vector<SensorData> m_closed;
+	/**
+	 * End of the grace period of the earliest open window.
+	 */
+	Poco::Int64 m_nextEnd;
+	mutable Poco::FastMutex m_lock;
+	MetricCounter &m_aggregated;
+	MetricCounter &m_windows;
+};
+
+}
@@ -1,11 +1,14 @@
 #include <Poco/NumberFormatter.h>
 
 #include "core/AnswerQueue.h"
+#include "util/AllocationTracker.h"
 
 using namespace BeeeOn;
 using namespace Poco;
 using namespace std;
 
+static const AllocationTag ANSWERS_TAG("answers");
+
 AnswerQueue::AnswerQueue():
 	m_disposed(false)
 {
@@ -18,6 +21,7 @@ Answer::Ptr AnswerQueue::newAnswer()
 			"creating Answer for a disposed AnswerQueue");
 	}
 
+	AllocationScope scope(ANSWERS_TAG);
 	return new Answer(*this);
 }
 
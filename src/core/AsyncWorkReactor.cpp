@@ -0,0 +1,71 @@
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/Timestamp.h>
+
+#include "core/AsyncWorkReactor.h"
+#include "di/Injectable.h"
+#include "util/MetricsRegistry.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, AsyncWorkReactor)
+BEEEON_OBJECT_PROPERTY("executor", &AsyncWorkReactor::setExecutor)
+BEEEON_OBJECT_HOOK("cleanup", &AsyncWorkReactor::cleanup)
+BEEEON_OBJECT_END(BeeeOn, AsyncWorkReactor)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+AsyncWorkReactor::AsyncWorkReactor():
+	m_pendingGauge(MetricsRegistry::instance().gauge(
+		"beeeon_async_work_pending",
+		"Asynchronous device operations waiting for completion"))
+{
+}
+
+AsyncWorkReactor::~AsyncWorkReactor()
+{
+	cleanup();
+}
+
+void AsyncWorkReactor::setExecutor(AsyncExecutor::Ptr executor)
+{
+	m_executor = executor;
+}
+
+LambdaTimerTask::Ptr AsyncWorkReactor::schedule(
+		const Timespan &delay,
+		const function<void()> &task)
+{
+	LambdaTimerTask::Ptr timerTask = new LambdaTimerTask([this, task]() {
+		try {
+			task();
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	});
+
+	m_timer.schedule(timerTask, Timestamp() + delay);
+	return timerTask;
+}
+
+void AsyncWorkReactor::invoke(const function<void()> &task)
+{
+	schedule(0, task);
+}
+
+void AsyncWorkReactor::execute(const function<void()> &task)
+{
+	if (m_executor.isNull())
+		throw IllegalStateException("no executor for blocking tasks");
+
+	m_executor->invoke([this, task]() {
+		try {
+			task();
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	});
+}
+
+void AsyncWorkReactor::cleanup()
+{
+	m_timer.cancel(true);
+}
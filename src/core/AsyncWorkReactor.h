@@ -0,0 +1,95 @@
+#pragma once
+
+#include <functional>
+
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Util/Timer.h>
+
+#include "util/AsyncExecutor.h"
+#include "util/ContinuationAsyncWork.h"
+#include "util/LambdaTimerTask.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+class MetricGauge;
+
+/**
+ * @brief AsyncWorkReactor drives asynchronous device operations
+ * represented by ContinuationAsyncWork. Instead of blocking a thread
+ * per operation (sleeping between retransmissions, waiting for
+ * a timeout), device managers schedule the next steps of their
+ * operations here. All the scheduled tasks are executed by a single
+ * shared thread, thus they must not block for a long time. Blocking
+ * steps (e.g. I/O with a device) are passed to the executor via
+ * execute().
+ */
+class AsyncWorkReactor : protected Loggable {
+public:
+	typedef Poco::SharedPtr<AsyncWorkReactor> Ptr;
+
+	AsyncWorkReactor();
+	~AsyncWorkReactor();
+
+	/**
+	 * @brief Set executor for blocking steps of operations.
+	 */
+	void setExecutor(AsyncExecutor::Ptr executor);
+
+	/**
+	 * @brief Execute the given task after the given delay.
+	 * @returns scheduled task that can be cancelled
+	 */
+	LambdaTimerTask::Ptr schedule(
+		const Poco::Timespan &delay,
+		const std::function<void()> &task);
+
+	/**
+	 * @brief Execute the given task as soon as possible.
+	 */
+	void invoke(const std::function<void()> &task);
+
+	/**
+	 * @brief Execute the given potentially blocking task via
+	 * the executor, i.e. outside of the reactor thread.
+	 * @throws Poco::IllegalStateException when no executor is set
+	 */
+	void execute(const std::function<void()> &task);
+
+	/**
+	 * @brief Cancel the given work unless it finishes in time.
+	 */
+	template <typename Result>
+	void deadline(
+		typename ContinuationAsyncWork<Result>::Ptr work,
+		const Poco::Timespan &timeout);
+
+	/**
+	 * @brief Cancel all scheduled tasks and stop the reactor thread.
+	 */
+	void cleanup();
+
+private:
+	Poco::Util::Timer m_timer;
+	AsyncExecutor::Ptr m_executor;
+	MetricGauge &m_pendingGauge;
+};
+
+template <typename Result>
+void AsyncWorkReactor::deadline(
+		typename ContinuationAsyncWork<Result>::Ptr work,
+		const Poco::Timespan &timeout)
+{
+	MetricGauge &gauge = m_pendingGauge;
+	gauge.inc();
+
+	LambdaTimerTask::Ptr task = schedule(timeout, work->cancelLink());
+
+	work->onComplete([task, &gauge](ContinuationAsyncWork<Result> &) {
+		task->cancel();
+		gauge.dec();
+	});
+}
+
+}
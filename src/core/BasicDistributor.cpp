@@ -5,30 +5,59 @@
 
 #include <exception>
 #include <string>
+#include <vector>
 
 #include "di/Injectable.h"
 #include "core/BasicDistributor.h"
 #include "core/Exporter.h"
+#include "core/StageLatency.h"
 #include "model/SensorData.h"
+#include "util/MetricsRegistry.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, BasicDistributor)
 BEEEON_OBJECT_CASTABLE(Distributor)
 BEEEON_OBJECT_PROPERTY("exporters", &BasicDistributor::registerExporter)
 BEEEON_OBJECT_PROPERTY("listeners", &BasicDistributor::registerListener)
 BEEEON_OBJECT_PROPERTY("eventsExecutor", &BasicDistributor::setExecutor)
+BEEEON_OBJECT_PROPERTY("filters", &BasicDistributor::registerFilter)
 BEEEON_OBJECT_END(BeeeOn, BasicDistributor)
 
 using namespace BeeeOn;
 
 void BasicDistributor::exportData(const SensorData &sensorData)
 {
+	static MetricCounter &distributed = MetricsRegistry::instance().counter(
+		"beeeon_distributor_data_total",
+		"Sensor data passed to a distributor",
+		{{"distributor", "BasicDistributor"}});
+
 	Poco::FastMutex::ScopedLock lock(m_exportMutex);
 
+	distributed.inc();
+	StageLatency::instance().record(StageLatency::DISTRIBUTE, sensorData);
+
 	notifyListeners(sensorData);
 
+	SensorData buffer;
+	const SensorData *filtered = applyFilters(sensorData, buffer);
+
+	std::vector<SensorData> released;
+	releaseFilters(released, Poco::Timestamp());
+
+	for (const auto &data : released)
+		ship(data);
+
+	if (filtered != nullptr)
+		ship(*filtered);
+}
+
+void BasicDistributor::ship(const SensorData &data)
+{
 	for (Poco::SharedPtr<Exporter> exporter : m_exporters) {
 		try {
-			exporter->ship(sensorData);
+			if (exporter->ship(data))
+				StageLatency::instance().record(StageLatency::EXPORT, data);
+
 			poco_debug(logger(), "Data shipped successfully");
 
 		} catch (Poco::Exception &ex) {
@@ -11,9 +11,14 @@ class SensorData;
 class BasicDistributor : public AbstractDistributor {
 public:
 	/*
-	 * Export data to all registered exporters.
+	 * Export data to all registered exporters. Data released
+	 * by filters meanwhile are exported as well.
 	 */
 	void exportData(const SensorData &sensorData) override;
+
+protected:
+	void ship(const SensorData &data);
+
 private:
 	Poco::FastMutex m_exportMutex;
 };
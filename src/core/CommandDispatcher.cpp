@@ -1,9 +1,13 @@
+#include <typeinfo>
+
 #include <Poco/Logger.h>
 
 #include "core/CommandDispatcher.h"
+#include "util/MetricsRegistry.h"
 
 using namespace BeeeOn;
 using namespace Poco;
+using namespace std;
 
 CommandDispatcher::~CommandDispatcher()
 {
@@ -30,9 +34,30 @@ void CommandDispatcher::dispatch(Command::Ptr cmd, Answer::Ptr answer)
 
 	logger().debug(cmd->toString(), __FILE__, __LINE__);
 
+	dispatchedCounter(*cmd).inc();
+
 	dispatchImpl(cmd, answer);
 }
 
+MetricCounter &CommandDispatcher::dispatchedCounter(const Command &cmd)
+{
+	const type_index type(typeid(cmd));
+
+	FastMutex::ScopedLock guard(m_countersLock);
+
+	auto it = m_dispatched.find(type);
+	if (it != m_dispatched.end())
+		return *it->second;
+
+	MetricCounter &counter = MetricsRegistry::instance().counter(
+		"beeeon_commands_dispatched_total",
+		"Commands passed to the command dispatcher",
+		{{"command", cmd.name()}});
+
+	m_dispatched.emplace(type, &counter);
+	return counter;
+}
+
 void CommandDispatcher::setEventsExecutor(AsyncExecutor::Ptr executor)
 {
 	m_eventSource.setAsyncExecutor(executor);
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <map>
+#include <typeindex>
+
+#include <Poco/Mutex.h>
 #include <Poco/SharedPtr.h>
 
 #include "core/CommandDispatcherListener.h"
@@ -9,6 +13,8 @@
 
 namespace BeeeOn {
 
+class MetricCounter;
+
 class CommandDispatcher : protected Loggable {
 public:
 	virtual ~CommandDispatcher();
@@ -32,11 +38,20 @@ public:
 protected:
 	virtual void dispatchImpl(Command::Ptr cmd, Answer::Ptr answer) = 0;
 
+	/**
+	 * @brief Resolve the counter of the command type in the
+	 * MetricsRegistry once and cache it. Subsequent dispatches
+	 * of the same command type do not allocate.
+	 */
+	MetricCounter &dispatchedCounter(const Command &cmd);
+
 protected:
 	std::list<Poco::SharedPtr<CommandHandler>> m_commandHandlers;
 
 private:
 	EventSource<CommandDispatcherListener> m_eventSource;
+	Poco::FastMutex m_countersLock;
+	std::map<std::type_index, MetricCounter *> m_dispatched;
 };
 
 }
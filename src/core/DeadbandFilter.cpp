@@ -0,0 +1,422 @@
+#include <cmath>
+#include <fstream>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Logger.h>
+#include <Poco/NumberParser.h>
+#include <Poco/String.h>
+#include <Poco/StringTokenizer.h>
+
+#include "commands/DeviceUnpairCommand.h"
+#include "commands/NewDeviceCommand.h"
+#include "core/DeadbandFilter.h"
+#include "di/Injectable.h"
+#include "model/ModuleType.h"
+#include "model/SensorData.h"
+#include "util/MetricsRegistry.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, DeadbandFilter)
+BEEEON_OBJECT_CASTABLE(DistributorFilter)
+BEEEON_OBJECT_CASTABLE(CommandDispatcherListener)
+BEEEON_OBJECT_CASTABLE(ModuleTypeResolver)
+BEEEON_OBJECT_PROPERTY("rules", &DeadbandFilter::setRules)
+BEEEON_OBJECT_PROPERTY("heartbeat", &DeadbandFilter::setHeartbeat)
+BEEEON_OBJECT_PROPERTY("typesFile", &DeadbandFilter::setTypesFile)
+BEEEON_OBJECT_END(BeeeOn, DeadbandFilter)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+static const string DEFAULT_RULE = "default";
+
+DeadbandFilter::Rule DeadbandFilter::Rule::parse(const string &input)
+{
+	const string spec = trim(input);
+	Rule rule;
+
+	if (spec == "pass")
+		return rule;
+
+	rule.pass = false;
+
+	if (spec == "change")
+		return rule;
+
+	if (spec.empty())
+		throw SyntaxException("missing deadband");
+
+	string absolute = spec;
+	string relative;
+
+	const size_t slash = spec.find('/');
+	if (slash != string::npos) {
+		absolute = spec.substr(0, slash);
+		relative = spec.substr(slash + 1);
+	}
+	else if (!spec.empty() && spec.back() == '%') {
+		absolute.clear();
+		relative = spec;
+	}
+
+	if (!absolute.empty() && !NumberParser::tryParseFloat(absolute, rule.absolute))
+		throw SyntaxException("invalid absolute deadband: " + spec);
+
+	if (!relative.empty()) {
+		if (relative.back() != '%')
+			throw SyntaxException("relative deadband must end with %: " + spec);
+
+		relative.pop_back();
+
+		if (!NumberParser::tryParseFloat(relative, rule.relative))
+			throw SyntaxException("invalid relative deadband: " + spec);
+
+		rule.relative /= 100;
+	}
+
+	if (rule.absolute < 0 || rule.relative < 0)
+		throw SyntaxException("deadband must not be negative: " + spec);
+
+	return rule;
+}
+
+bool DeadbandFilter::Rule::exceeded(double last, double value) const
+{
+	if (pass)
+		return true;
+
+	const double delta = fabs(value - last);
+	return delta > absolute && delta > relative * fabs(last);
+}
+
+DeadbandFilter::DeadbandFilter():
+	m_heartbeat(15 * Timespan::MINUTES),
+	m_series(256),
+	m_passed(MetricsRegistry::instance().counter(
+		"beeeon_deadband_filter_values_total",
+		"Values passed through the DeadbandFilter",
+		{{"verdict", "passed"}})),
+	m_dropped(MetricsRegistry::instance().counter(
+		"beeeon_deadband_filter_values_total",
+		"Values passed through the DeadbandFilter",
+		{{"verdict", "dropped"}}))
+{
+}
+
+DeadbandFilter::~DeadbandFilter()
+{
+}
+
+void DeadbandFilter::setRules(const list<string> &rules)
+{
+	map<string, Rule> parsed;
+	Rule fallback;
+
+	for (const auto &item : rules) {
+		const size_t colon = item.find(':');
+		if (colon == string::npos)
+			throw SyntaxException("expected <module-type>:<rule>: " + item);
+
+		const string type = trim(item.substr(0, colon));
+		const Rule rule = Rule::parse(item.substr(colon + 1));
+
+		if (type == DEFAULT_RULE) {
+			fallback = rule;
+			continue;
+		}
+
+		// fail early on typos
+		ModuleType::Type::parse(type);
+
+		parsed[type] = rule;
+	}
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	m_rules = parsed;
+	m_default = fallback;
+	m_series.clear();
+}
+
+void DeadbandFilter::setHeartbeat(const Timespan &heartbeat)
+{
+	m_heartbeat = heartbeat;
+}
+
+void DeadbandFilter::setTypesFile(const string &file)
+{
+	m_typesFile = file;
+
+	if (m_typesFile.empty())
+		return;
+
+	try {
+		const size_t count = loadTypes();
+
+		logger().information(
+			"loaded types of " + to_string(count) + " devices from " + m_typesFile,
+			__FILE__, __LINE__);
+	}
+	BEEEON_CATCH_CHAIN(logger())
+}
+
+void DeadbandFilter::learnTypes(
+		const DeviceID &device,
+		const vector<string> &types)
+{
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		auto it = m_types.find(device);
+		if (it != m_types.end() && it->second == types)
+			return;
+
+		m_types[device] = types;
+
+		// rules of already seen modules must be resolved again
+		m_series.forEach([&](const SensorSeries &series, SeriesState &state) {
+			if (series.device == device)
+				state.resolved = false;
+		});
+	}
+
+	try {
+		persistTypes();
+	}
+	BEEEON_CATCH_CHAIN(logger())
+}
+
+void DeadbandFilter::forgetDevice(const DeviceID &device)
+{
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		const bool known = m_types.erase(device) > 0;
+		m_series.eraseIf([&](const SensorSeries &series, const SeriesState &) {
+			return series.device == device;
+		});
+
+		if (!known)
+			return;
+	}
+
+	try {
+		persistTypes();
+	}
+	BEEEON_CATCH_CHAIN(logger())
+}
+
+size_t DeadbandFilter::loadTypes()
+{
+	if (m_typesFile.empty() || !File(m_typesFile).exists())
+		return 0;
+
+	ifstream input(m_typesFile);
+	if (!input)
+		throw FileAccessDeniedException("failed to open " + m_typesFile);
+
+	map<DeviceID, vector<string>> loaded;
+	string line;
+
+	while (getline(input, line)) {
+		try {
+			StringTokenizer fields(line, " ",
+				StringTokenizer::TOK_TRIM | StringTokenizer::TOK_IGNORE_EMPTY);
+			if (fields.count() == 0)
+				continue;
+
+			vector<string> &types = loaded[DeviceID::parse(fields[0])];
+			types.assign(fields.begin() + 1, fields.end());
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	for (const auto &pair : loaded)
+		m_types[pair.first] = pair.second;
+
+	m_series.forEach([&](const SensorSeries &, SeriesState &state) {
+		state.resolved = false;
+	});
+
+	return loaded.size();
+}
+
+void DeadbandFilter::persistTypes()
+{
+	if (m_typesFile.empty())
+		return;
+
+	// serialize writers so an older copy never replaces a newer one
+	FastMutex::ScopedLock fileGuard(m_fileLock);
+	map<DeviceID, vector<string>> types;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		types = m_types;
+	}
+
+	const string tmp = m_typesFile + ".tmp";
+
+	ofstream output(tmp, ios::trunc);
+	if (!output)
+		throw FileAccessDeniedException("failed to create " + tmp);
+
+	for (const auto &pair : types) {
+		output << pair.first.toString();
+
+		for (const auto &type : pair.second)
+			output << " " << type;
+
+		output << "\n";
+	}
+
+	output.close();
+	if (!output)
+		throw WriteFileException("failed to write " + tmp);
+
+	File(tmp).renameTo(m_typesFile);
+}
+
+void DeadbandFilter::onDispatch(const Command::Ptr cmd)
+{
+	if (cmd->is<DeviceUnpairCommand>()) {
+		forgetDevice(cmd.cast<DeviceUnpairCommand>()->deviceID());
+		return;
+	}
+
+	if (!cmd->is<NewDeviceCommand>())
+		return;
+
+	const NewDeviceCommand::Ptr newDevice = cmd.cast<NewDeviceCommand>();
+	vector<string> types;
+
+	for (const auto &type : newDevice->dataTypes())
+		types.emplace_back(type.type().toString());
+
+	learnTypes(newDevice->deviceID(), types);
+}
+
+string DeadbandFilter::typeOf(
+		const DeviceID &device,
+		const ModuleID &module) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto types = m_types.find(device);
+	if (types == m_types.end() || module.value() >= types->second.size())
+		return "";
+
+	return types->second[module.value()];
+}
+
+DeadbandFilter::Rule DeadbandFilter::resolve(
+		const DeviceID &device,
+		const ModuleID &module) const
+{
+	auto types = m_types.find(device);
+	if (types == m_types.end() || module.value() >= types->second.size())
+		return m_default;
+
+	auto rule = m_rules.find(types->second[module.value()]);
+	if (rule == m_rules.end())
+		return m_default;
+
+	return rule->second;
+}
+
+bool DeadbandFilter::pass(
+		SeriesState &state,
+		const DeviceID &device,
+		const ModuleID &module,
+		bool valid,
+		double value,
+		Int64 at)
+{
+	if (!state.resolved) {
+		state.rule = resolve(device, module);
+		state.resolved = true;
+	}
+
+	const bool heartbeat = m_heartbeat.totalMicroseconds() >= 0
+		&& at - state.exported >= m_heartbeat.totalMicroseconds();
+
+	if (valid && state.valid && !heartbeat
+			&& !state.rule.exceeded(state.value, value)) {
+		return false;
+	}
+
+	state.valid = valid;
+	state.value = value;
+	state.exported = at;
+
+	return true;
+}
+
+bool DeadbandFilter::filter(SensorData &data)
+{
+	const Int64 at = data.timestamp().value().epochMicroseconds();
+	SensorData reduced;
+	bool reducing = false;
+	size_t total = 0;
+	size_t count = 0;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		for (const auto &item : data) {
+			const bool valid = item.isValid() && !std::isnan(item.value());
+			auto state = m_series.emplace({data.deviceID(), item.moduleID()});
+
+			const bool passed = pass(*state.first, data.deviceID(),
+				item.moduleID(), valid, valid ? item.value() : 0, at);
+
+			// copy the data only when some value is dropped
+			if (!passed && !reducing) {
+				reducing = true;
+				reduced.setDeviceID(data.deviceID());
+				reduced.setTimestamp(data.timestamp());
+
+				size_t i = 0;
+				for (const auto &previous : data) {
+					if (i++ == total)
+						break;
+
+					reduced.insertValue(previous);
+				}
+			}
+			else if (passed && reducing) {
+				reduced.insertValue(item);
+			}
+
+			total += 1;
+			if (passed)
+				count += 1;
+		}
+	}
+
+	m_passed.inc(count);
+	m_dropped.inc(total - count);
+
+	if (!reducing)
+		return true;
+	if (count == 0)
+		return false;
+
+	data = reduced;
+	return true;
+}
+
+size_t DeadbandFilter::size() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_series.size();
+}
+
+size_t DeadbandFilter::knownDevices() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_types.size();
+}
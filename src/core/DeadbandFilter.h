@@ -0,0 +1,174 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "core/CommandDispatcherListener.h"
+#include "core/DistributorFilter.h"
+#include "core/ModuleTypeResolver.h"
+#include "core/SensorSeries.h"
+#include "model/DeviceID.h"
+#include "model/ModuleID.h"
+#include "util/FlatHashMap.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+class MetricCounter;
+
+/**
+ * @brief DeadbandFilter suppresses export of values that have not
+ * changed significantly since the last exported value of the same
+ * module. Many devices re-report identical values every poll,
+ * exporting all of them wastes the uplink and the journal.
+ *
+ * Each module type has its rule (a deadband). A value is exported
+ * when it differs from the last exported one by more than
+ * max(absolute, relative * |last|). The zero deadband means
+ * change-only reporting. Types with the "pass" rule (e.g. events
+ * like motion or shake where repeating values are meaningful)
+ * are never filtered.
+ *
+ * Regardless of the deadband, a value is exported when the heartbeat
+ * interval has elapsed since the last exported value of the module
+ * so the server can tell a quiet device from a dead one. Invalid
+ * values are always exported.
+ *
+ * Types of modules are learned from NewDeviceCommands, thus the
+ * filter must be registered as a listener of the CommandDispatcher.
+ * The learned types are persisted into the types file (if any), thus
+ * devices paired before restart keep their rules. Types and states of
+ * a device are forgotten when it is unpaired. Modules of unknown type
+ * follow the "default" rule. The learned types are available to other
+ * components via the ModuleTypeResolver interface.
+ */
+class DeadbandFilter :
+	public DistributorFilter,
+	public CommandDispatcherListener,
+	public ModuleTypeResolver,
+	protected Loggable {
+public:
+	typedef Poco::SharedPtr<DeadbandFilter> Ptr;
+
+	struct Rule {
+		/**
+		 * Never filter values.
+		 */
+		bool pass = true;
+		double absolute = 0;
+		double relative = 0;
+
+		/**
+		 * @brief Parse rule specification: "pass", "change"
+		 * (zero deadband), "<absolute>", "<relative>%" or
+		 * "<absolute>/<relative>%".
+		 * @throws Poco::SyntaxException
+		 */
+		static Rule parse(const std::string &spec);
+
+		bool exceeded(double last, double value) const;
+	};
+
+	DeadbandFilter();
+	~DeadbandFilter();
+
+	/**
+	 * @brief Set rules as list of "<module-type>:<rule>". The
+	 * module type "default" applies to modules of unknown type.
+	 * @see Rule::parse()
+	 */
+	void setRules(const std::list<std::string> &rules);
+
+	/**
+	 * @brief Set the maximal interval between two exported values
+	 * of a module. Negative value disables the heartbeat.
+	 */
+	void setHeartbeat(const Poco::Timespan &heartbeat);
+
+	/**
+	 * @brief Set file to persist the learned module types into
+	 * and load the types persisted there previously. When empty,
+	 * the types are not persisted.
+	 */
+	void setTypesFile(const std::string &file);
+
+	/**
+	 * @brief Set module types of the given device.
+	 */
+	void learnTypes(const DeviceID &device,
+		const std::vector<std::string> &types);
+
+	/**
+	 * @brief Forget module types and last exported values
+	 * of the given device.
+	 */
+	void forgetDevice(const DeviceID &device);
+
+	bool filter(SensorData &data) override;
+
+	void onDispatch(const Command::Ptr cmd) override;
+
+	std::string typeOf(
+		const DeviceID &device,
+		const ModuleID &module) const override;
+
+	/**
+	 * @returns count of modules with known last exported value
+	 */
+	size_t size() const;
+
+	/**
+	 * @returns count of devices with known module types
+	 */
+	size_t knownDevices() const;
+
+protected:
+	struct SeriesState {
+		Rule rule;
+		bool resolved = false;
+		bool valid = false;
+		double value = 0;
+		Poco::Int64 exported = 0;
+	};
+
+	Rule resolve(const DeviceID &device, const ModuleID &module) const;
+
+	/**
+	 * @returns true when the value should be exported
+	 */
+	bool pass(SeriesState &state, const DeviceID &device,
+		const ModuleID &module, bool valid, double value,
+		Poco::Int64 at);
+
+	/**
+	 * @returns count of devices loaded from the types file
+	 */
+	size_t loadTypes();
+
+	/**
+	 * @brief Write all known types into the types file. The file
+	 * is replaced atomically.
+	 */
+	void persistTypes();
+
+private:
+	std::map<std::string, Rule> m_rules;
+	Rule m_default;
+	Poco::Timespan m_heartbeat;
+	std::string m_typesFile;
+	std::map<DeviceID, std::vector<std::string>> m_types;
+	FlatHashMap<SensorSeries, SeriesState, SensorSeries::Hash> m_series;
+	mutable Poco::FastMutex m_lock;
+	Poco::FastMutex m_fileLock;
+	MetricCounter &m_passed;
+	MetricCounter &m_dropped;
+};
+
+}
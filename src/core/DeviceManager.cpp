@@ -9,8 +9,10 @@
 #include "core/DeviceManager.h"
 #include "core/MemoryDeviceCache.h"
 #include "core/PrefixCommand.h"
+#include "core/StageLatency.h"
 #include "model/SensorData.h"
 #include "util/ClassInfo.h"
+#include "util/MetricsRegistry.h"
 
 using namespace BeeeOn;
 using namespace Poco;
@@ -23,7 +25,11 @@ DeviceManager::DeviceManager(const DevicePrefix &prefix,
 	m_prefix(prefix),
 	m_deviceCache(new MemoryDeviceCache),
 	m_acceptable(acceptable),
-	m_remoteStatusDelivered(false)
+	m_remoteStatusDelivered(false),
+	m_shippedCounter(MetricsRegistry::instance().counter(
+		"beeeon_device_manager_shipped_total",
+		"Sensor data shipped by a device manager",
+		{{"prefix", prefix.toString()}}))
 {
 }
 
@@ -62,6 +68,21 @@ void DeviceManager::setDistributor(Poco::SharedPtr<Distributor> distributor)
 	m_distributor = distributor;
 }
 
+void DeviceManager::setDiscoveryExecutor(DiscoveryExecutor::Ptr executor)
+{
+	m_discoveryExecutor = executor;
+}
+
+void DeviceManager::setWorkReactor(AsyncWorkReactor::Ptr reactor)
+{
+	m_workReactor = reactor;
+}
+
+AsyncWorkReactor::Ptr DeviceManager::workReactor() const
+{
+	return m_workReactor;
+}
+
 bool DeviceManager::accept(const Command::Ptr cmd)
 {
 	if (m_acceptable.find(typeid(*cmd)) == m_acceptable.end())
@@ -81,28 +102,60 @@ void DeviceManager::handle(Command::Ptr cmd, Answer::Ptr answer)
 
 	try {
 		handleGeneric(cmd, result);
-		result->setStatus(Result::Status::SUCCESS);
+
+		if (!adoptDeferred(result, answer))
+			result->setStatus(Result::Status::SUCCESS);
 	}
 	BEEEON_CATCH_CHAIN_ACTION(logger(),
+		adoptDeferred(result, answer);
 		result->setStatus(Result::Status::FAILED)
 	)
 }
 
+DeviceManager::DeferredResult::Ptr DeviceManager::deferResult(Result::Ptr result)
+{
+	DeferredResult::Ptr deferred = new DeferredResult;
+	deferred->result = result;
+
+	FastMutex::ScopedLock guard(m_deferredLock);
+	m_deferred.emplace(result.get(), deferred);
+
+	return deferred;
+}
+
+bool DeviceManager::adoptDeferred(Result::Ptr result, Answer::Ptr answer)
+{
+	FastMutex::ScopedLock guard(m_deferredLock);
+
+	auto it = m_deferred.find(result.get());
+	if (it == m_deferred.end())
+		return false;
+
+	it->second->answer = answer;
+	m_deferred.erase(it);
+
+	return true;
+}
+
 void DeviceManager::handleGeneric(const Command::Ptr cmd, Result::Ptr result)
 {
-	if (cmd->is<DeviceAcceptCommand>())
+	if (cmd->is<DeviceAcceptCommand>()) {
+		// the user is pairing devices of this manager
+		if (!m_discoveryExecutor.isNull())
+			m_discoveryExecutor->prioritize(m_prefix);
+
 		handleAccept(cmd.cast<DeviceAcceptCommand>());
+	}
 	else if (cmd->is<GatewayListenCommand>())
 		handleListen(cmd.cast<GatewayListenCommand>());
 	else if (cmd->is<DeviceUnpairCommand>()) {
 		DeviceUnpairResult::Ptr unpair = result.cast<DeviceUnpairResult>();
 		poco_assert(!unpair.isNull());
 
-		const auto &result = handleUnpair(cmd.cast<DeviceUnpairCommand>());
-		unpair->setUnpaired(result);
+		handleUnpair(cmd.cast<DeviceUnpairCommand>(), unpair);
 	}
 	else if (cmd->is<DeviceSetValueCommand>()) {
-		handleSetValue(cmd.cast<DeviceSetValueCommand>());
+		handleSetValue(cmd.cast<DeviceSetValueCommand>(), result);
 	}
 	else
 		throw NotImplementedException(cmd->toString());
@@ -144,6 +197,14 @@ void DeviceManager::handleListen(const GatewayListenCommand::Ptr cmd)
 	manageUntilFinished("discovery", discovery, timeout);
 }
 
+void DeviceManager::startSeeker(AbstractSeeker::Ptr seeker)
+{
+	if (m_discoveryExecutor.isNull())
+		seeker->start();
+	else
+		m_discoveryExecutor->submit(seeker, m_prefix);
+}
+
 AsyncWork<set<DeviceID>>::Ptr DeviceManager::startUnpair(
 		const DeviceID &,
 		const Timespan &)
@@ -165,10 +226,72 @@ set<DeviceID> DeviceManager::handleUnpair(const DeviceUnpairCommand::Ptr cmd)
 	auto unpair = startUnpair(cmd->deviceID(), timeout);
 	manageUntilFinished("unpair", unpair, timeout);
 
-	if (unpair->result().isNull())
+	return reportUnpaired(cmd, *unpair);
+}
+
+void DeviceManager::handleUnpair(
+		const DeviceUnpairCommand::Ptr cmd,
+		DeviceUnpairResult::Ptr result)
+{
+	if (m_workReactor.isNull()) {
+		result->setUnpaired(handleUnpair(cmd));
+		return;
+	}
+
+	const Clock started;
+	const Timespan &duration = cmd->timeout();
+
+	ScopedLock<FastMutex> guard(m_unpairLock, duration.totalMilliseconds());
+
+	awaitDeferred("unpair", m_pendingUnpair, started, duration);
+
+	const Timespan &timeout = checkDelayedOperation("unpair", started, duration);
+
+	logger().information("starting unpair", __FILE__, __LINE__);
+
+	auto unpair = startUnpair(cmd->deviceID(), timeout);
+	auto continuation = unpair.cast<ContinuationAsyncWork<set<DeviceID>>>();
+
+	if (continuation.isNull()) {
+		manageUntilFinished("unpair", unpair, timeout);
+		result->setUnpaired(reportUnpaired(cmd, *unpair));
+		return;
+	}
+
+	manageDeferred<set<DeviceID>>("unpair", continuation, timeout, result,
+		[this, cmd, result](ContinuationAsyncWork<set<DeviceID>> &done) {
+			result->setUnpaired(reportUnpaired(cmd, done));
+		});
+
+	m_pendingUnpair = continuation;
+}
+
+/**
+ * @brief Rethrow exception that has failed the given work
+ * if it is a ContinuationAsyncWork.
+ */
+template <typename R>
+static void rethrowFailed(AsyncWork<R> &work)
+{
+	const auto continuation = dynamic_cast<ContinuationAsyncWork<R> *>(&work);
+
+	if (continuation == nullptr)
+		return;
+
+	if (continuation->state() == ContinuationAsyncWork<R>::FAILED)
+		continuation->rethrow();
+}
+
+set<DeviceID> DeviceManager::reportUnpaired(
+		const DeviceUnpairCommand::Ptr cmd,
+		AsyncWork<set<DeviceID>> &unpair)
+{
+	rethrowFailed(unpair);
+
+	if (unpair.result().isNull())
 		return {};
 
-	const set<DeviceID> result = unpair->result();
+	const set<DeviceID> result = unpair.result();
 
 	if (result.find(cmd->deviceID()) != result.end() && result.size() == 1) {
 		logger().information("unpair was successful", __FILE__, __LINE__);
@@ -202,12 +325,21 @@ AsyncWork<double>::Ptr DeviceManager::startSetValue(
 }
 
 void DeviceManager::handleSetValue(const DeviceSetValueCommand::Ptr cmd)
+{
+	handleSetValue(cmd, Result::Ptr());
+}
+
+void DeviceManager::handleSetValue(
+		const DeviceSetValueCommand::Ptr cmd,
+		Result::Ptr result)
 {
 	const Clock started;
 	const Timespan &duration = cmd->timeout();
 
 	ScopedLock<FastMutex> guard(m_setValueLock, duration.totalMilliseconds());
 
+	awaitDeferred("set-value", m_pendingSetValue, started, duration);
+
 	const Timespan &timeout = checkDelayedOperation("set-value", started, duration);
 
 	logger().information("starting set-value", __FILE__, __LINE__);
@@ -217,12 +349,51 @@ void DeviceManager::handleSetValue(const DeviceSetValueCommand::Ptr cmd)
 		cmd->moduleID(),
 		cmd->value(),
 		timeout);
-	manageUntilFinished("set-value", operation, timeout);
+	auto continuation = operation.cast<ContinuationAsyncWork<double>>();
+
+	if (result.isNull() || m_workReactor.isNull() || continuation.isNull()) {
+		manageUntilFinished("set-value", operation, timeout);
+		shipSetValue(cmd, *operation);
+		return;
+	}
+
+	manageDeferred<double>("set-value", continuation, timeout, result,
+		[this, cmd](ContinuationAsyncWork<double> &done) {
+			shipSetValue(cmd, done);
+		});
+
+	m_pendingSetValue = continuation;
+}
+
+void DeviceManager::awaitDeferred(
+		const string &opname,
+		AnyAsyncWork::Ptr &pending,
+		const Clock &started,
+		const Timespan &duration)
+{
+	if (pending.isNull())
+		return;
+
+	Timespan remaining = duration - started.elapsed();
+	if (remaining < 0)
+		remaining = 0;
+
+	if (!pending->tryJoin(remaining))
+		throw TimeoutException("previous " + opname + " is still in progress");
+
+	pending = nullptr;
+}
+
+void DeviceManager::shipSetValue(
+		const DeviceSetValueCommand::Ptr cmd,
+		AsyncWork<double> &operation)
+{
+	rethrowFailed(operation);
 
-	if (operation->result().isNull())
+	if (operation.result().isNull())
 		throw IllegalStateException("result of set-value was not provided");
 
-	const auto value = operation->result().value();
+	const auto value = operation.result().value();
 
 	try {
 		if (logger().debug()) {
@@ -243,6 +414,8 @@ void DeviceManager::handleSetValue(const DeviceSetValueCommand::Ptr cmd)
 
 void DeviceManager::ship(const SensorData &sensorData)
 {
+	m_shippedCounter.inc();
+	StageLatency::instance().record(StageLatency::SHIP, sensorData);
 	m_distributor->exportData(sensorData);
 }
 
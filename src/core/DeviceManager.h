@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+#include <map>
 #include <set>
 #include <typeindex>
 
@@ -11,12 +13,16 @@
 #include "commands/DeviceAcceptCommand.h"
 #include "commands/DeviceSetValueCommand.h"
 #include "commands/DeviceUnpairCommand.h"
+#include "commands/DeviceUnpairResult.h"
 #include "commands/GatewayListenCommand.h"
+#include "core/AbstractSeeker.h"
 #include "core/AnswerQueue.h"
+#include "core/AsyncWorkReactor.h"
 #include "core/CommandHandler.h"
 #include "core/CommandSender.h"
 #include "core/DeviceCache.h"
 #include "core/DeviceStatusHandler.h"
+#include "core/DiscoveryExecutor.h"
 #include "core/Distributor.h"
 #include "loop/StoppableRunnable.h"
 #include "loop/StopControl.h"
@@ -25,10 +31,13 @@
 #include "model/ModuleID.h"
 #include "util/AsyncWork.h"
 #include "util/CancellableSet.h"
+#include "util/ContinuationAsyncWork.h"
 #include "util/Loggable.h"
 
 namespace BeeeOn {
 
+class MetricCounter;
+
 /**
  * All classes that manage devices should inherit from this
  * abstract class. It provides a common functionality for this
@@ -71,6 +80,22 @@ public:
 	void setDeviceCache(DeviceCache::Ptr cache);
 	void setDistributor(Poco::SharedPtr<Distributor> distributor);
 
+	/**
+	 * @brief Set executor shared by seekers of all device managers.
+	 * Without it, each seeker runs in its own thread.
+	 */
+	void setDiscoveryExecutor(DiscoveryExecutor::Ptr executor);
+
+	/**
+	 * @brief Set reactor driving asynchronous operations. When set,
+	 * unpair and set-value operations started as ContinuationAsyncWork
+	 * do not block the calling thread until they finish. Their results
+	 * are reported when the work completes or its timeout exceeds.
+	 * A next operation of the same kind waits until the previous one
+	 * finishes.
+	 */
+	void setWorkReactor(AsyncWorkReactor::Ptr reactor);
+
 	/**
 	 * Generic implementation of the CommandHandler::accept() method.
 	 * If the m_acceptable set is initialized appropriately, this
@@ -148,6 +173,13 @@ protected:
 	 */
 	void handleListen(const GatewayListenCommand::Ptr cmd);
 
+	/**
+	 * @brief Start the given seeker via the DiscoveryExecutor if
+	 * configured or in a dedicated thread otherwise. Intended to be
+	 * used from startDiscovery().
+	 */
+	void startSeeker(AbstractSeeker::Ptr seeker);
+
 	/**
 	 * @brief Starts device unpair process in a technology-specific way.
 	 * This method is always called inside a critical section and so its
@@ -198,6 +230,26 @@ protected:
 	 */
 	void handleSetValue(const DeviceSetValueCommand::Ptr cmd);
 
+	/**
+	 * @brief Handle the unpair command and report the unpaired devices
+	 * via the given result. If the unpair is a ContinuationAsyncWork and
+	 * the AsyncWorkReactor is configured, the method does not wait for
+	 * the unpair to finish and the result is completed later.
+	 */
+	void handleUnpair(
+		const DeviceUnpairCommand::Ptr cmd,
+		DeviceUnpairResult::Ptr result);
+
+	/**
+	 * @brief Handle the set-value command and complete the given result.
+	 * If the set-value is a ContinuationAsyncWork and the AsyncWorkReactor
+	 * is configured, the method does not wait for the set-value to finish
+	 * and the result is completed later.
+	 */
+	void handleSetValue(
+		const DeviceSetValueCommand::Ptr cmd,
+		Result::Ptr result);
+
 	/**
 	* Ship data received from a physical device into a collection point.
 	*/
@@ -266,7 +318,78 @@ protected:
 		AnyAsyncWork::Ptr work,
 		const Poco::Timespan &timeout);
 
+	/**
+	 * @returns reactor driving asynchronous operations, it might be null
+	 */
+	AsyncWorkReactor::Ptr workReactor() const;
+
+	/**
+	 * @brief Manage a ContinuationAsyncWork without blocking. The work is
+	 * cancelled unless it finishes in the given timeout. When finished,
+	 * the given finish callback is called from the reactor and the result
+	 * is completed as SUCCESS unless the callback throws an exception.
+	 */
+	template <typename R>
+	void manageDeferred(
+		const std::string &opname,
+		typename ContinuationAsyncWork<R>::Ptr work,
+		const Poco::Timespan &timeout,
+		Result::Ptr result,
+		const std::function<void(ContinuationAsyncWork<R> &)> &finish);
+
 private:
+	/**
+	 * @brief Result of a command that is completed asynchronously.
+	 * The answer is held until the result is completed.
+	 */
+	struct DeferredResult {
+		typedef Poco::SharedPtr<DeferredResult> Ptr;
+
+		Result::Ptr result;
+		Answer::Ptr answer;
+	};
+
+	/**
+	 * @brief Mark the given result as completed asynchronously.
+	 */
+	DeferredResult::Ptr deferResult(Result::Ptr result);
+
+	/**
+	 * @brief Pass the answer to the deferred result (if any).
+	 * @returns true if the given result has been deferred
+	 */
+	bool adoptDeferred(Result::Ptr result, Answer::Ptr answer);
+
+	/**
+	 * @brief Wait until the deferred operation started previously
+	 * finishes. Deferred operations of the same kind thus never
+	 * overlap, as if the operation lock was held until the work
+	 * completes.
+	 *
+	 * @throws Poco::TimeoutException when the previous operation
+	 * does not finish in the given duration
+	 */
+	void awaitDeferred(
+		const std::string &opname,
+		AnyAsyncWork::Ptr &pending,
+		const Poco::Clock &started,
+		const Poco::Timespan &duration);
+
+	/**
+	 * @brief Ship the value set by the given operation.
+	 * @throws Poco::IllegalStateException when no value was set
+	 */
+	void shipSetValue(
+		const DeviceSetValueCommand::Ptr cmd,
+		AsyncWork<double> &operation);
+
+	/**
+	 * @returns devices unpaired by the given unpair operation
+	 */
+	std::set<DeviceID> reportUnpaired(
+		const DeviceUnpairCommand::Ptr cmd,
+		AsyncWork<std::set<DeviceID>> &unpair);
+
 	[[deprecated("use DeviceFetcher instead")]]
 	void requestDeviceList(Answer::Ptr answer);
 	[[deprecated("use DeviceFetcher instead")]]
@@ -284,10 +407,56 @@ private:
 	Poco::FastMutex m_listenLock;
 	Poco::FastMutex m_unpairLock;
 	Poco::FastMutex m_setValueLock;
+	AnyAsyncWork::Ptr m_pendingUnpair;
+	AnyAsyncWork::Ptr m_pendingSetValue;
 	Poco::SharedPtr<Distributor> m_distributor;
+	DiscoveryExecutor::Ptr m_discoveryExecutor;
+	AsyncWorkReactor::Ptr m_workReactor;
+	std::map<const Result *, DeferredResult::Ptr> m_deferred;
+	Poco::FastMutex m_deferredLock;
 	std::set<std::type_index> m_acceptable;
 	CancellableSet m_cancellable;
 	Poco::AtomicCounter m_remoteStatusDelivered;
+	MetricCounter &m_shippedCounter;
 };
 
+template <typename R>
+void DeviceManager::manageDeferred(
+		const std::string &opname,
+		typename ContinuationAsyncWork<R>::Ptr work,
+		const Poco::Timespan &timeout,
+		Result::Ptr result,
+		const std::function<void(ContinuationAsyncWork<R> &)> &finish)
+{
+	DeferredResult::Ptr deferred = deferResult(result);
+	AsyncWorkReactor::Ptr reactor = m_workReactor;
+
+	cancellable().manage(work);
+	reactor->deadline<R>(work, timeout);
+
+	work->onComplete([this, opname, work, reactor, deferred, finish](ContinuationAsyncWork<R> &) {
+		// the work might be completed while holding the cancellable()
+		// lock (via CancellableSet::cancel()), thus continue from the reactor
+		reactor->invoke([this, opname, work, deferred, finish]() {
+			if (work->state() == ContinuationAsyncWork<R>::CANCELLED)
+				logger().information(opname + " has been cancelled", __FILE__, __LINE__);
+
+			cancellable().unmanage(work);
+
+			Result::Status status = Result::Status::SUCCESS;
+
+			try {
+				finish(*work);
+			}
+			BEEEON_CATCH_CHAIN_ACTION(logger(),
+				status = Result::Status::FAILED)
+
+			try {
+				deferred->result->setStatus(status);
+			}
+			BEEEON_CATCH_CHAIN(logger())
+		});
+	});
+}
+
 }
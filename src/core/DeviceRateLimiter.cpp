@@ -0,0 +1,325 @@
+#include <algorithm>
+
+#include <Poco/Exception.h>
+
+#include "core/DeviceRateLimiter.h"
+#include "util/MetricsRegistry.h"
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+/**
+ * Count of deferred data of a device since which even values
+ * of exempt modules are coalesced.
+ */
+static const size_t MAX_DEFERRED = 16;
+
+UInt64 DeviceRateLimiter::DeviceIDHash::operator()(const DeviceID &id) const
+{
+	return id.ident();
+}
+
+DeviceRateLimiter::DeviceRateLimiter():
+	m_interval(0),
+	m_burst(1),
+	m_passed(MetricsRegistry::instance().counter(
+		"beeeon_rate_limiter_data_total",
+		"Sensor data passed through the DeviceRateLimiter",
+		{{"verdict", "passed"}})),
+	m_limited(MetricsRegistry::instance().counter(
+		"beeeon_rate_limiter_data_total",
+		"Sensor data passed through the DeviceRateLimiter",
+		{{"verdict", "limited"}})),
+	m_coalesced(MetricsRegistry::instance().counter(
+		"beeeon_rate_limiter_data_total",
+		"Sensor data passed through the DeviceRateLimiter",
+		{{"verdict", "coalesced"}}))
+{
+}
+
+DeviceRateLimiter::~DeviceRateLimiter()
+{
+}
+
+void DeviceRateLimiter::setInterval(const Timespan &interval)
+{
+	FastMutex::ScopedLock guard(m_lock);
+	m_interval = interval.totalMicroseconds() > 0 ? interval : 0;
+}
+
+void DeviceRateLimiter::setBurst(int burst)
+{
+	if (burst < 1)
+		throw InvalidArgumentException("burst must be at least 1");
+
+	FastMutex::ScopedLock guard(m_lock);
+	m_burst = burst;
+}
+
+void DeviceRateLimiter::setExemptTypes(const set<string> &types)
+{
+	FastMutex::ScopedLock guard(m_lock);
+	m_exemptTypes = types;
+}
+
+void DeviceRateLimiter::setModuleTypes(ModuleTypeResolver::Ptr types)
+{
+	FastMutex::ScopedLock guard(m_lock);
+	m_types = types;
+}
+
+bool DeviceRateLimiter::enabled() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_interval.totalMicroseconds() > 0;
+}
+
+void DeviceRateLimiter::refill(DeviceState &state, const Clock &now) const
+{
+	const Clock::ClockDiff elapsed = now - state.updated;
+	if (elapsed <= 0)
+		return;
+
+	state.tokens = min<double>(m_burst,
+		state.tokens + double(elapsed) / m_interval.totalMicroseconds());
+	state.updated = now;
+}
+
+bool DeviceRateLimiter::admit(const SensorData &data, const Clock &now)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_interval.totalMicroseconds() <= 0)
+		return true;
+
+	auto entry = m_devices.emplace(data.deviceID());
+	DeviceState &state = *entry.first;
+
+	if (entry.second) {
+		state.tokens = m_burst;
+		state.updated = now;
+	}
+	else {
+		refill(state, now);
+	}
+
+	// deferred data must not be overtaken by newer data
+	if (!state.deferred.empty()) {
+		coalesce(state, data);
+		state.coalesced += 1;
+		m_coalesced.inc();
+		return false;
+	}
+
+	if (state.tokens >= 1) {
+		state.tokens -= 1;
+		m_passed.inc();
+		return true;
+	}
+
+	state.deferred.push_back(data);
+	state.limited += 1;
+	m_order.push_back(data.deviceID());
+	m_limited.inc();
+
+	return false;
+}
+
+size_t DeviceRateLimiter::release(vector<SensorData> &released, const Clock &now)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_interval.totalMicroseconds() <= 0)
+		return flushUnlocked(released);
+
+	const size_t count = m_order.size();
+	size_t n = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		const DeviceID device = m_order.front();
+		m_order.pop_front();
+
+		DeviceState *state = m_devices.find(device);
+		if (state == nullptr || state->deferred.empty())
+			continue;
+
+		refill(*state, now);
+
+		if (state->tokens < 1) {
+			m_order.push_back(device);
+			continue;
+		}
+
+		state->tokens -= 1;
+		released.emplace_back(state->deferred.front());
+		state->deferred.pop_front();
+		n += 1;
+
+		if (!state->deferred.empty())
+			m_order.push_back(device);
+	}
+
+	return n;
+}
+
+size_t DeviceRateLimiter::flush(vector<SensorData> &released)
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return flushUnlocked(released);
+}
+
+size_t DeviceRateLimiter::flushUnlocked(vector<SensorData> &released)
+{
+	size_t n = 0;
+
+	for (const auto &device : m_order) {
+		DeviceState *state = m_devices.find(device);
+		if (state == nullptr)
+			continue;
+
+		for (const auto &data : state->deferred)
+			released.emplace_back(data);
+
+		n += state->deferred.size();
+		state->deferred.clear();
+	}
+
+	m_order.clear();
+	return n;
+}
+
+Timespan DeviceRateLimiter::nextRelease(const Clock &now) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	Timespan next = -1;
+
+	for (const auto &device : m_order) {
+		const DeviceState *state = m_devices.find(device);
+		if (state == nullptr || state->deferred.empty())
+			continue;
+
+		if (m_interval.totalMicroseconds() <= 0)
+			return 0;
+
+		const double tokens = state->tokens
+			+ double(max<Clock::ClockDiff>(0, now - state->updated))
+				/ m_interval.totalMicroseconds();
+
+		const Timespan wait = tokens >= 1 ? 0 :
+			Timespan::TimeDiff((1 - tokens) * m_interval.totalMicroseconds());
+
+		if (next < 0 || wait < next)
+			next = wait;
+	}
+
+	return next;
+}
+
+size_t DeviceRateLimiter::deferred() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_order.size();
+}
+
+void DeviceRateLimiter::report(vector<Offender> &offenders)
+{
+	const size_t first = offenders.size();
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		m_devices.forEach([&](const DeviceID &device, DeviceState &state) {
+			if (state.limited == 0 && state.coalesced == 0)
+				return;
+
+			offenders.push_back({device, state.limited, state.coalesced});
+			state.limited = 0;
+			state.coalesced = 0;
+		});
+	}
+
+	sort(offenders.begin() + first, offenders.end(),
+		[](const Offender &a, const Offender &b) {
+			return a.limited + a.coalesced > b.limited + b.coalesced;
+		});
+}
+
+bool DeviceRateLimiter::exempt(const DeviceID &device, const ModuleID &module) const
+{
+	if (m_exemptTypes.empty() || m_types.isNull())
+		return false;
+
+	return m_exemptTypes.find(m_types->typeOf(device, module)) != m_exemptTypes.end();
+}
+
+void DeviceRateLimiter::coalesce(DeviceState &state, const SensorData &data) const
+{
+	const bool backlog = state.deferred.size() >= MAX_DEFERRED;
+
+	for (const auto &value : data) {
+		if (backlog || !exempt(data.deviceID(), value.moduleID()))
+			erase(state.deferred, value.moduleID());
+	}
+
+	if (!state.deferred.empty()
+			&& state.deferred.back().timestamp().value() == data.timestamp().value()
+			&& !overlaps(state.deferred.back(), data)) {
+		for (const auto &value : data)
+			state.deferred.back().insertValue(value);
+	}
+	else {
+		state.deferred.push_back(data);
+	}
+}
+
+bool DeviceRateLimiter::overlaps(const SensorData &a, const SensorData &b)
+{
+	for (const auto &value : b) {
+		const bool found = any_of(a.begin(), a.end(),
+			[&](const SensorValue &other) {
+				return other.moduleID() == value.moduleID();
+			});
+
+		if (found)
+			return true;
+	}
+
+	return false;
+}
+
+void DeviceRateLimiter::erase(deque<SensorData> &deferred, const ModuleID &module)
+{
+	for (auto it = deferred.begin(); it != deferred.end(); ) {
+		const bool found = any_of(it->begin(), it->end(),
+			[&](const SensorValue &value) {
+				return value.moduleID() == module;
+			});
+
+		if (!found) {
+			++it;
+			continue;
+		}
+
+		SensorData reduced;
+		reduced.setDeviceID(it->deviceID());
+		reduced.setTimestamp(it->timestamp());
+		bool empty = true;
+
+		for (const auto &value : *it) {
+			if (value.moduleID() == module)
+				continue;
+
+			reduced.insertValue(value);
+			empty = false;
+		}
+
+		if (empty) {
+			it = deferred.erase(it);
+		}
+		else {
+			*it = reduced;
+			++it;
+		}
+	}
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Poco/Clock.h>
+#include <Poco/Mutex.h>
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "core/ModuleTypeResolver.h"
+#include "model/DeviceID.h"
+#include "model/SensorData.h"
+#include "util/FlatHashMap.h"
+
+namespace BeeeOn {
+
+class MetricCounter;
+
+/**
+ * @brief DeviceRateLimiter limits the rate of data exported for each
+ * device by a token bucket. A device reporting in a tight loop would
+ * otherwise fill the ExporterQueues and evict data of all the other
+ * devices by the drop-oldest policy.
+ *
+ * Each device gains one token per interval up to the burst. Data of
+ * a device with a token are admitted immediately. Data of a device
+ * without a token are deferred, further data of that device are
+ * deferred behind them. A newer value replaces the deferred value
+ * of the same module (coalescing), deferred values of other modules
+ * are kept with their own timestamps. Values of the exempt module
+ * types (e.g. events) are not coalesced unless the device has too
+ * many deferred data. Thus the held back state of a device is bounded
+ * by the count of its modules and a short backlog. Deferred data are
+ * released one by one in round-robin order across devices as their
+ * tokens refill.
+ *
+ * The count of deferred and coalesced data of each device is kept
+ * for reporting of offending devices.
+ */
+class DeviceRateLimiter {
+public:
+	struct Offender {
+		DeviceID device;
+		/**
+		 * Data that exceeded the rate limit.
+		 */
+		unsigned int limited;
+		/**
+		 * Data deferred behind already deferred data.
+		 */
+		unsigned int coalesced;
+	};
+
+	DeviceRateLimiter();
+	~DeviceRateLimiter();
+
+	/**
+	 * @brief Set the minimal average interval between data of
+	 * a device. Zero or negative interval disables the limiting.
+	 */
+	void setInterval(const Poco::Timespan &interval);
+
+	/**
+	 * @brief Set how many data of a device can be admitted
+	 * at once after a quiet period.
+	 */
+	void setBurst(int burst);
+
+	/**
+	 * @brief Set types of modules whose values are not coalesced.
+	 */
+	void setExemptTypes(const std::set<std::string> &types);
+
+	/**
+	 * @brief Set source of the module types. Without it, no values
+	 * are exempt from coalescing.
+	 */
+	void setModuleTypes(ModuleTypeResolver::Ptr types);
+
+	bool enabled() const;
+
+	/**
+	 * @returns true when the data can be exported immediately,
+	 * false when the data have been deferred or coalesced
+	 */
+	bool admit(const SensorData &data,
+		const Poco::Clock &now = Poco::Clock());
+
+	/**
+	 * @brief Append deferred data of devices whose tokens have
+	 * been refilled to the given vector. Each device is visited
+	 * at most once in the round-robin order. When the limiting
+	 * is disabled, all deferred data are released.
+	 * @returns count of released data
+	 */
+	size_t release(std::vector<SensorData> &released,
+		const Poco::Clock &now = Poco::Clock());
+
+	/**
+	 * @brief Append all deferred data to the given vector
+	 * regardless of tokens (e.g. on shutdown).
+	 * @returns count of released data
+	 */
+	size_t flush(std::vector<SensorData> &released);
+
+	/**
+	 * @returns time until the next deferred data can be released
+	 * or a negative value when there are no deferred data
+	 */
+	Poco::Timespan nextRelease(const Poco::Clock &now = Poco::Clock()) const;
+
+	/**
+	 * @returns count of devices with deferred data
+	 */
+	size_t deferred() const;
+
+	/**
+	 * @brief Collect devices that exceeded the rate limit since
+	 * the last report ordered from the worst one.
+	 */
+	void report(std::vector<Offender> &offenders);
+
+protected:
+	struct DeviceIDHash {
+		Poco::UInt64 operator()(const DeviceID &id) const;
+	};
+
+	struct DeviceState {
+		double tokens = 0;
+		Poco::Clock updated;
+		/**
+		 * Deferred data from the oldest ones.
+		 */
+		std::deque<SensorData> deferred;
+		unsigned int limited = 0;
+		unsigned int coalesced = 0;
+	};
+
+	void refill(DeviceState &state, const Poco::Clock &now) const;
+
+	size_t flushUnlocked(std::vector<SensorData> &released);
+
+	/**
+	 * @brief Defer the data behind the already deferred ones. Values
+	 * of the data replace deferred values of the same modules unless
+	 * they are exempt. Data with the same timestamp as the newest
+	 * deferred data are merged into them unless both contain a value
+	 * of the same module (an exempt value kept by the coalescing).
+	 */
+	void coalesce(DeviceState &state, const SensorData &data) const;
+
+	/**
+	 * @returns true if both data contain a value of the same module
+	 */
+	static bool overlaps(const SensorData &a, const SensorData &b);
+
+	/**
+	 * @brief Remove deferred values of the given module, deferred
+	 * data left empty are removed.
+	 */
+	static void erase(std::deque<SensorData> &deferred, const ModuleID &module);
+
+	bool exempt(const DeviceID &device, const ModuleID &module) const;
+
+private:
+	Poco::Timespan m_interval;
+	int m_burst;
+	std::set<std::string> m_exemptTypes;
+	ModuleTypeResolver::Ptr m_types;
+	FlatHashMap<DeviceID, DeviceState, DeviceIDHash> m_devices;
+	std::deque<DeviceID> m_order;
+	mutable Poco::FastMutex m_lock;
+	MetricCounter &m_passed;
+	MetricCounter &m_limited;
+	MetricCounter &m_coalesced;
+};
+
+}
@@ -0,0 +1,268 @@
+#include <fstream>
+
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+
+#include "core/DiscoveryExecutor.h"
+#include "di/Injectable.h"
+#include "util/MetricsRegistry.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, DiscoveryExecutor)
+BEEEON_OBJECT_PROPERTY("maxThreads", &DiscoveryExecutor::setMaxThreads)
+BEEEON_OBJECT_PROPERTY("priorityPeriod", &DiscoveryExecutor::setPriorityPeriod)
+BEEEON_OBJECT_HOOK("cleanup", &DiscoveryExecutor::cleanup)
+BEEEON_OBJECT_END(BeeeOn, DiscoveryExecutor)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+static const Timespan JOIN_TIMEOUT = 5 * Timespan::SECONDS;
+
+/**
+ * @returns value of the given key from /proc/self/status or -1
+ */
+static Int64 processStatus(const string &key)
+{
+	ifstream in("/proc/self/status");
+	string name;
+	Int64 value;
+
+	while (in >> name) {
+		if (name == key && in >> value)
+			return value;
+
+		in.ignore(1024, '\n');
+	}
+
+	return -1;
+}
+
+DiscoveryExecutor::DiscoveryExecutor():
+	m_maxThreads(2),
+	m_priorityPeriod(10 * Timespan::MINUTES),
+	m_prioritizedAt(0),
+	m_running(0),
+	m_peakWorkers(0),
+	m_shutdown(false),
+	m_workersGauge(MetricsRegistry::instance().gauge(
+		"beeeon_discovery_workers",
+		"Threads executing seekers of device managers")),
+	m_queuedGauge(MetricsRegistry::instance().gauge(
+		"beeeon_discovery_queued",
+		"Seekers waiting for a free discovery thread"))
+{
+}
+
+DiscoveryExecutor::~DiscoveryExecutor()
+{
+	cleanup();
+}
+
+void DiscoveryExecutor::setMaxThreads(int count)
+{
+	if (count <= 0)
+		throw InvalidArgumentException("maxThreads must be positive");
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (!m_workers.empty())
+		throw IllegalStateException("cannot change maxThreads after start");
+
+	m_maxThreads = count;
+}
+
+void DiscoveryExecutor::setPriorityPeriod(const Timespan &period)
+{
+	if (period < 0)
+		throw InvalidArgumentException("priorityPeriod must not be negative");
+
+	m_priorityPeriod = period;
+}
+
+void DiscoveryExecutor::prioritize(const DevicePrefix &prefix)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	m_priorityPrefix = prefix.toString();
+	m_prioritizedAt.update();
+}
+
+bool DiscoveryExecutor::prioritized(const string &prefix) const
+{
+	if (m_priorityPrefix.empty())
+		return false;
+
+	if (m_prioritizedAt.isElapsed(m_priorityPeriod.totalMicroseconds()))
+		return false;
+
+	return m_priorityPrefix == prefix;
+}
+
+void DiscoveryExecutor::submit(AbstractSeeker::Ptr seeker, const DevicePrefix &prefix)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_shutdown)
+		throw IllegalStateException("discovery executor is shutting down");
+
+	seeker->enqueued();
+	m_queue.push_back({seeker, prefix.toString()});
+	m_queuedGauge.set(m_queue.size());
+
+	if (m_running < m_maxThreads)
+		startWorker();
+}
+
+size_t DiscoveryExecutor::peakWorkers() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_peakWorkers;
+}
+
+void DiscoveryExecutor::startWorker()
+{
+	if (m_workers.empty())
+		m_workers.resize(m_maxThreads);
+
+	for (size_t i = 0; i < m_workers.size(); ++i) {
+		Worker &worker = m_workers[i];
+
+		if (worker.busy)
+			continue;
+
+		if (worker.thread.isNull()) {
+			worker.thread = new Thread;
+			worker.thread->setName("discovery-" + to_string(i));
+		}
+		else {
+			// the worker has already left its loop, release
+			// resources of the finished thread before reusing it
+			worker.thread->join();
+		}
+
+		worker.busy = true;
+		worker.thread->startFunc([this, i]() {
+			runWorker(i);
+		});
+
+		++m_running;
+		m_workersGauge.set(m_running);
+
+		if (m_running > m_peakWorkers)
+			m_peakWorkers = m_running;
+
+		return;
+	}
+}
+
+bool DiscoveryExecutor::nextJob(Job &job)
+{
+	if (m_queue.empty())
+		return false;
+
+	auto selected = m_queue.begin();
+
+	for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+		if (prioritized(it->prefix)) {
+			selected = it;
+			break;
+		}
+	}
+
+	job = *selected;
+	m_queue.erase(selected);
+	m_queuedGauge.set(m_queue.size());
+
+	return true;
+}
+
+void DiscoveryExecutor::runWorker(size_t index)
+{
+	while (true) {
+		Job job;
+
+		{
+			FastMutex::ScopedLock guard(m_lock);
+
+			if (!nextJob(job)) {
+				m_workers[index].busy = false;
+				--m_running;
+				m_workersGauge.set(m_running);
+
+				if (m_running == 0)
+					reportIdle();
+
+				return;
+			}
+		}
+
+		if (logger().debug()) {
+			logger().debug("executing seeker of " + job.prefix,
+				__FILE__, __LINE__);
+		}
+
+		const bool yielded = job.seeker->perform([this]() {
+			FastMutex::ScopedLock guard(m_lock);
+			return !m_queue.empty();
+		});
+
+		if (!yielded)
+			continue;
+
+		bool shutdown;
+
+		{
+			FastMutex::ScopedLock guard(m_lock);
+			shutdown = m_shutdown;
+
+			// let the waiting seekers run before the next pass
+			if (!shutdown) {
+				m_queue.push_back(job);
+				m_queuedGauge.set(m_queue.size());
+			}
+		}
+
+		if (shutdown)
+			job.seeker->cancel();
+	}
+}
+
+void DiscoveryExecutor::reportIdle()
+{
+	logger().information(
+		"discovery finished, peak workers: " + to_string(m_peakWorkers)
+		+ ", process threads: " + to_string(processStatus("Threads:"))
+		+ ", peak RSS: " + to_string(processStatus("VmHWM:")) + " kB",
+		__FILE__, __LINE__);
+}
+
+void DiscoveryExecutor::cleanup()
+{
+	vector<SharedPtr<Thread>> threads;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		m_shutdown = true;
+
+		for (auto &job : m_queue)
+			job.seeker->cancel();
+
+		m_queue.clear();
+		m_queuedGauge.set(0);
+
+		for (auto &worker : m_workers) {
+			if (!worker.thread.isNull())
+				threads.emplace_back(worker.thread);
+		}
+	}
+
+	for (auto thread : threads) {
+		if (!thread->tryJoin(JOIN_TIMEOUT.totalMilliseconds())) {
+			logger().warning("discovery thread " + thread->name()
+				+ " did not finish in time",
+				__FILE__, __LINE__);
+		}
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Thread.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Timespan.h>
+
+#include "core/AbstractSeeker.h"
+#include "model/DevicePrefix.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+class MetricGauge;
+
+/**
+ * @brief DiscoveryExecutor runs seekers of all device managers on
+ * a bounded set of threads. A single GatewayListenCommand starts
+ * discovery in all device managers at once. Instead of spawning
+ * a thread for each of them, the seekers are queued and executed
+ * by at most maxThreads workers. Workers are started on demand and
+ * they exit when the queue is empty, so no threads are kept while
+ * there is no discovery in progress.
+ *
+ * A seeker usually loops for its whole duration. To serve all the
+ * seekers within that duration, a seeker yields its worker after
+ * each pass (see AbstractSeeker::nextPass()) whenever other seekers
+ * are waiting and it is queued again at the end.
+ *
+ * Seekers of the device manager the user is actively pairing on
+ * (i.e. a device of its prefix has been accepted recently) are
+ * executed before the others.
+ */
+class DiscoveryExecutor : protected Loggable {
+public:
+	typedef Poco::SharedPtr<DiscoveryExecutor> Ptr;
+
+	DiscoveryExecutor();
+	~DiscoveryExecutor();
+
+	/**
+	 * @brief Maximal number of seekers running concurrently.
+	 */
+	void setMaxThreads(int count);
+
+	/**
+	 * @brief How long a prefix stays prioritized after prioritize().
+	 */
+	void setPriorityPeriod(const Poco::Timespan &period);
+
+	/**
+	 * @brief Prefer seekers of the given prefix for the priority period.
+	 */
+	void prioritize(const DevicePrefix &prefix);
+
+	/**
+	 * @brief Queue the seeker for execution.
+	 * @throws Poco::IllegalStateException in case the seeker was already
+	 * started or the executor is being shut down
+	 */
+	void submit(AbstractSeeker::Ptr seeker, const DevicePrefix &prefix);
+
+	/**
+	 * @returns the maximal number of workers running at once
+	 */
+	size_t peakWorkers() const;
+
+	/**
+	 * @brief Cancel all queued seekers and wait for the running ones.
+	 */
+	void cleanup();
+
+private:
+	struct Job {
+		AbstractSeeker::Ptr seeker;
+		std::string prefix;
+	};
+
+	struct Worker {
+		Poco::SharedPtr<Poco::Thread> thread;
+		bool busy;
+	};
+
+	bool prioritized(const std::string &prefix) const;
+	bool nextJob(Job &job);
+	void startWorker();
+	void runWorker(size_t index);
+	void reportIdle();
+
+private:
+	size_t m_maxThreads;
+	Poco::Timespan m_priorityPeriod;
+	std::string m_priorityPrefix;
+	Poco::Timestamp m_prioritizedAt;
+
+	std::deque<Job> m_queue;
+	std::vector<Worker> m_workers;
+	size_t m_running;
+	size_t m_peakWorkers;
+	bool m_shutdown;
+	mutable Poco::FastMutex m_lock;
+
+	MetricGauge &m_workersGauge;
+	MetricGauge &m_queuedGauge;
+};
+
+}
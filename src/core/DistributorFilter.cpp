@@ -0,0 +1,19 @@
+#include "core/DistributorFilter.h"
+#include "model/SensorData.h"
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+DistributorFilter::DistributorFilter()
+{
+}
+
+DistributorFilter::~DistributorFilter()
+{
+}
+
+size_t DistributorFilter::release(vector<SensorData> &, const Timestamp &)
+{
+	return 0;
+}
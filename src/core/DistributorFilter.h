@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+#include <Poco/SharedPtr.h>
+#include <Poco/Timestamp.h>
+
+namespace BeeeOn {
+
+class SensorData;
+
+/**
+ * @brief Interface of a stage between a Distributor and its Exporters.
+ *
+ * Implement the DistributorFilter and register it with the Distributor
+ * to reduce data being exported. Listeners of the Distributor are
+ * notified about the data before any filtering.
+ */
+class DistributorFilter {
+public:
+	typedef Poco::SharedPtr<DistributorFilter> Ptr;
+
+	DistributorFilter();
+	virtual ~DistributorFilter();
+
+	/**
+	 * @brief Filter the given data in place. Values that should
+	 * not be exported are removed from the data.
+	 * @returns false when there is nothing to be exported
+	 */
+	virtual bool filter(SensorData &data) = 0;
+
+	/**
+	 * @brief Release data held back by the filter (e.g. results
+	 * of aggregation windows) that are due until the given time.
+	 * Timestamp::TIMEVAL_MAX releases all of them. The released
+	 * data have already passed this filter. The default
+	 * implementation holds nothing back.
+	 * @returns count of data appended to released
+	 */
+	virtual size_t release(
+		std::vector<SensorData> &released,
+		const Poco::Timestamp &until);
+};
+
+}
@@ -3,6 +3,9 @@
 #include <Poco/Exception.h>
 
 #include "core/ExporterQueue.h"
+#include "core/StageLatency.h"
+#include "util/ClassInfo.h"
+#include "util/MetricsRegistry.h"
 
 using namespace BeeeOn;
 using namespace std;
@@ -18,7 +21,20 @@ ExporterQueue::ExporterQueue(
 	m_sent(0),
 	m_failDetector(treshold),
 	m_capacity(capacity),
-	m_batchSize(batchSize)
+	m_batchSize(batchSize),
+	m_frontDequeued(false),
+	m_sentCounter(MetricsRegistry::instance().counter(
+		"beeeon_exporter_sent_total",
+		"Sensor data successfully shipped by an exporter",
+		{{"exporter", ClassInfo::forPointer(exporter.get()).name()}})),
+	m_droppedCounter(MetricsRegistry::instance().counter(
+		"beeeon_exporter_dropped_total",
+		"Sensor data dropped due to a full exporter queue",
+		{{"exporter", ClassInfo::forPointer(exporter.get()).name()}})),
+	m_queuedGauge(MetricsRegistry::instance().gauge(
+		"beeeon_exporter_queued",
+		"Sensor data waiting in an exporter queue",
+		{{"exporter", ClassInfo::forPointer(exporter.get()).name()}}))
 {
 }
 
@@ -32,10 +48,14 @@ void ExporterQueue::enqueue(const SensorData &sensorData)
 
 	if (m_queue.size() >= m_capacity && m_capacity > 0) {
 		m_queue.pop();
+		m_frontDequeued = false;
 		++m_dropped;
+		m_droppedCounter.inc();
+		m_queuedGauge.dec();
 	}
 
 	m_queue.push(sensorData);
+	m_queuedGauge.inc();
 }
 
 unsigned int ExporterQueue::exportBatch()
@@ -47,8 +67,16 @@ unsigned int ExporterQueue::exportBatch()
 
 	try {
 		for (i = 0; (i < m_batchSize || m_batchSize <= 0) && !isEmpty(); ++i) {
-			if (m_exporter->ship(front())) {
+			const SensorData &data = front();
+
+			// the front is retried until it is shipped
+			if (markFrontDequeued())
+				StageLatency::instance().record(StageLatency::DEQUEUE, data);
+
+			if (m_exporter->ship(data)) {
+				StageLatency::instance().record(StageLatency::EXPORT, data);
 				++m_sent;
+				m_sentCounter.inc();
 				pop();
 			}
 			else {
@@ -119,8 +147,21 @@ SensorData &ExporterQueue::front()
 	return m_queue.front();
 }
 
+bool ExporterQueue::markFrontDequeued()
+{
+	FastMutex::ScopedLock lock(m_queueMutex);
+
+	if (m_frontDequeued)
+		return false;
+
+	m_frontDequeued = true;
+	return true;
+}
+
 void ExporterQueue::pop()
 {
 	FastMutex::ScopedLock lock(m_queueMutex);
 	m_queue.pop();
+	m_frontDequeued = false;
+	m_queuedGauge.dec();
 }
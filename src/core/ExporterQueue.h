@@ -13,6 +13,9 @@
 
 namespace BeeeOn {
 
+class MetricCounter;
+class MetricGauge;
+
 class ExporterQueue : protected Loggable {
 public:
 	typedef Poco::SharedPtr<ExporterQueue> Ptr;
@@ -62,6 +65,11 @@ private:
 	SensorData &front();
 	void pop();
 
+	/**
+	 * @returns true when the front is dequeued for the first time
+	 */
+	bool markFrontDequeued();
+
 private:
 	mutable Poco::FastMutex m_queueMutex;
 
@@ -74,6 +82,14 @@ private:
 	std::queue<SensorData> m_queue;
 	unsigned int m_capacity;
 	unsigned int m_batchSize;
+	/**
+	 * The front has already been recorded as dequeued.
+	 */
+	bool m_frontDequeued;
+
+	MetricCounter &m_sentCounter;
+	MetricCounter &m_droppedCounter;
+	MetricGauge &m_queuedGauge;
 };
 
 }
@@ -8,6 +8,7 @@
 #include "core/Version.h"
 #include "di/Injectable.h"
 #include "model/GatewayID.h"
+#include "util/StartupTracer.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, GatewayInfo)
 BEEEON_OBJECT_PROPERTY("certificatePath", &GatewayInfo::setCertPath)
@@ -54,6 +55,8 @@ GatewayID GatewayInfo::gatewayID() const
 
 void GatewayInfo::initialize()
 {
+	StartupTracer::Scope trace("GatewayInfo::initialize");
+
 	if (!m_keyPath.empty())
 		loadPrivateKey();
 
@@ -0,0 +1,337 @@
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Logger.h>
+#include <Poco/NumberFormatter.h>
+#include <Poco/NumberParser.h>
+#include <Poco/StringTokenizer.h>
+
+#include "commands/ServerLastValueCommand.h"
+#include "commands/ServerLastValueResult.h"
+#include "core/LastValueStore.h"
+#include "di/Injectable.h"
+#include "model/SensorData.h"
+#include "util/DataReader.h"
+#include "util/DataWriter.h"
+#include "util/MetricsRegistry.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, LastValueStore)
+BEEEON_OBJECT_CASTABLE(DistributorListener)
+BEEEON_OBJECT_CASTABLE(CommandHandler)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_PROPERTY("maxAge", &LastValueStore::setMaxAge)
+BEEEON_OBJECT_PROPERTY("file", &LastValueStore::setFile)
+BEEEON_OBJECT_PROPERTY("persistInterval", &LastValueStore::setPersistInterval)
+BEEEON_OBJECT_PROPERTY("fallback", &LastValueStore::setFallback)
+BEEEON_OBJECT_END(BeeeOn, LastValueStore)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+namespace BeeeOn {
+
+/**
+ * @brief Iterate over the given values formatted as records
+ * "<device> <module> <value-bits> <timestamp>". The value is stored
+ * as hexadecimal representation of its bits to be restored exactly.
+ */
+class LastValueRecords : public DataIterator {
+public:
+	typedef map<pair<DeviceID, ModuleID>, LastValueStore::Entry> Values;
+
+	LastValueRecords(const Values &values):
+		m_values(values),
+		m_current(m_values.begin())
+	{
+	}
+
+	bool hasNext() override
+	{
+		return m_current != m_values.end();
+	}
+
+	string next() override
+	{
+		if (m_current == m_values.end())
+			throw IllegalStateException("no more records");
+
+		UInt64 bits;
+		memcpy(&bits, &m_current->second.value, sizeof(bits));
+
+		string record;
+		record += m_current->first.first.toString();
+		record += " ";
+		record += m_current->first.second.toString();
+		record += " ";
+		record += NumberFormatter::formatHex(bits);
+		record += " ";
+		record += to_string(m_current->second.at.epochMicroseconds());
+
+		++m_current;
+		return record;
+	}
+
+private:
+	const Values &m_values;
+	Values::const_iterator m_current;
+};
+
+}
+
+LastValueStore::LastValueStore():
+	m_maxAge(10 * Timespan::MINUTES),
+	m_persistInterval(5 * Timespan::MINUTES),
+	m_dirty(false),
+	m_localCounter(MetricsRegistry::instance().counter(
+		"beeeon_last_value_local_total",
+		"Last value requests answered without the remote server"))
+{
+}
+
+void LastValueStore::setMaxAge(const Timespan &age)
+{
+	if (age < 0)
+		throw InvalidArgumentException("maxAge must not be negative");
+
+	m_maxAge = age;
+}
+
+void LastValueStore::setFile(const string &file)
+{
+	m_file = file;
+}
+
+void LastValueStore::setPersistInterval(const Timespan &interval)
+{
+	if (interval <= 0)
+		throw InvalidArgumentException("persistInterval must be positive");
+
+	m_persistInterval = interval;
+}
+
+void LastValueStore::setFallback(SharedPtr<CommandHandler> handler)
+{
+	m_fallback = handler;
+}
+
+void LastValueStore::update(
+		const DeviceID &device,
+		const ModuleID &module,
+		double value,
+		const Timestamp &at)
+{
+	RWLock::ScopedWriteLock guard(m_lock);
+
+	auto it = m_values.find({device, module});
+	if (it == m_values.end()) {
+		m_values.emplace(Key(device, module), Entry{value, at});
+	}
+	else {
+		if (it->second.at > at)
+			return;
+
+		it->second = {value, at};
+	}
+
+	m_dirty = true;
+}
+
+Nullable<LastValueStore::Entry> LastValueStore::lookup(
+		const DeviceID &device,
+		const ModuleID &module) const
+{
+	RWLock::ScopedReadLock guard(m_lock);
+
+	auto it = m_values.find({device, module});
+	if (it == m_values.end())
+		return {};
+
+	return it->second;
+}
+
+Nullable<LastValueStore::Entry> LastValueStore::fresh(
+		const DeviceID &device,
+		const ModuleID &module) const
+{
+	const auto entry = lookup(device, module);
+	if (entry.isNull())
+		return {};
+
+	if (entry.value().at.isElapsed(m_maxAge.totalMicroseconds()))
+		return {};
+
+	return entry;
+}
+
+size_t LastValueStore::size() const
+{
+	RWLock::ScopedReadLock guard(m_lock);
+	return m_values.size();
+}
+
+void LastValueStore::onExport(const SensorData &data)
+{
+	const Timestamp &at = data.timestamp().value();
+
+	for (const auto &item : data) {
+		if (!item.isValid() || std::isnan(item.value()))
+			continue;
+
+		update(data.deviceID(), item.moduleID(), item.value(), at);
+	}
+}
+
+bool LastValueStore::accept(const Command::Ptr cmd)
+{
+	return cmd->is<ServerLastValueCommand>();
+}
+
+void LastValueStore::handle(Command::Ptr cmd, Answer::Ptr answer)
+{
+	ServerLastValueCommand::Ptr lastValue = cmd.cast<ServerLastValueCommand>();
+	if (lastValue.isNull())
+		throw IllegalStateException("received unexpected command");
+
+	const auto entry = fresh(lastValue->deviceID(), lastValue->moduleID());
+	if (entry.isNull() && !m_fallback.isNull()) {
+		m_fallback->handle(cmd, answer);
+		return;
+	}
+
+	ServerLastValueResult::Ptr result = new ServerLastValueResult(answer);
+	result->setDeviceID(lastValue->deviceID());
+	result->setModuleID(lastValue->moduleID());
+
+	if (entry.isNull()) {
+		result->setStatus(Result::Status::FAILED);
+		return;
+	}
+
+	result->setValue(entry.value().value);
+	result->setStatus(Result::Status::SUCCESS);
+
+	m_localCounter.inc();
+}
+
+void LastValueStore::run()
+{
+	StopControl::Run run(m_stopControl);
+
+	if (m_file.empty())
+		return;
+
+	try {
+		const size_t count = load();
+
+		logger().information(
+			"loaded " + to_string(count) + " last values from " + m_file,
+			__FILE__, __LINE__);
+	}
+	BEEEON_CATCH_CHAIN(logger())
+
+	while (run) {
+		run.waitStoppable(m_persistInterval);
+
+		try {
+			persist();
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+}
+
+void LastValueStore::stop()
+{
+	m_stopControl.requestStop();
+}
+
+size_t LastValueStore::load()
+{
+	if (m_file.empty() || !File(m_file).exists())
+		return 0;
+
+	ifstream input(m_file);
+	if (!input)
+		throw FileAccessDeniedException("failed to open " + m_file);
+
+	DataReader reader(input);
+	size_t count = 0;
+
+	while (reader.hasNext()) {
+		const string record = reader.next();
+
+		try {
+			StringTokenizer fields(record, " ", StringTokenizer::TOK_TRIM);
+			if (fields.count() != 4)
+				throw SyntaxException("unexpected record: " + record);
+
+			const UInt64 bits = NumberParser::parseHex64(fields[2]);
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+
+			update(
+				DeviceID::parse(fields[0]),
+				ModuleID::parse(fields[1]),
+				value,
+				Timestamp(NumberParser::parse64(fields[3])));
+
+			count += 1;
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+
+	RWLock::ScopedWriteLock guard(m_lock);
+	m_dirty = false;
+
+	return count;
+}
+
+void LastValueStore::persist()
+{
+	if (m_file.empty())
+		return;
+
+	LastValueRecords::Values values;
+
+	{
+		RWLock::ScopedWriteLock guard(m_lock);
+
+		if (!m_dirty)
+			return;
+
+		values = m_values;
+		m_dirty = false;
+	}
+
+	const string tmp = m_file + ".tmp";
+
+	try {
+		ofstream output(tmp, ios::trunc);
+		if (!output)
+			throw FileAccessDeniedException("failed to create " + tmp);
+
+		LastValueRecords records(values);
+		DataWriter writer(output);
+		writer.write(records);
+
+		output.close();
+		if (!output)
+			throw WriteFileException("failed to write " + tmp);
+
+		File(tmp).renameTo(m_file);
+	}
+	catch (...) {
+		RWLock::ScopedWriteLock guard(m_lock);
+		m_dirty = true;
+		throw;
+	}
+
+	if (logger().debug()) {
+		logger().debug(
+			"persisted " + to_string(values.size()) + " last values",
+			__FILE__, __LINE__);
+	}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <Poco/Nullable.h>
+#include <Poco/RWLock.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+
+#include "core/CommandHandler.h"
+#include "core/DistributorListener.h"
+#include "loop/StopControl.h"
+#include "loop/StoppableRunnable.h"
+#include "model/DeviceID.h"
+#include "model/ModuleID.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+class MetricCounter;
+
+/**
+ * @brief LastValueStore remembers the last value of each module of each
+ * device that has passed through the Distributor. It handles every
+ * ServerLastValueCommand and answers it locally when the remembered
+ * value is not older than the configured maxAge. Otherwise, the command
+ * is forwarded to the configured fallback handler (the remote server).
+ *
+ * The table is periodically persisted into the configured file (if any)
+ * and loaded back when the store starts. Each record is a single line
+ * written via the DataWriter, thus a corrupted record is just skipped.
+ */
+class LastValueStore :
+	public DistributorListener,
+	public CommandHandler,
+	public StoppableRunnable,
+	protected Loggable {
+public:
+	typedef Poco::SharedPtr<LastValueStore> Ptr;
+
+	struct Entry {
+		double value;
+		Poco::Timestamp at;
+	};
+
+	LastValueStore();
+
+	/**
+	 * @brief Maximal age of a value to be answered locally.
+	 */
+	void setMaxAge(const Poco::Timespan &age);
+
+	/**
+	 * @brief File to persist the values into. When empty,
+	 * the values are not persisted.
+	 */
+	void setFile(const std::string &file);
+
+	/**
+	 * @brief Interval of persisting the changed values.
+	 */
+	void setPersistInterval(const Poco::Timespan &interval);
+
+	/**
+	 * @brief Handler of commands asking for values that are not
+	 * fresh. When not set, such commands fail.
+	 */
+	void setFallback(Poco::SharedPtr<CommandHandler> handler);
+
+	/**
+	 * @brief Remember the given value unless a newer one is known.
+	 */
+	void update(
+		const DeviceID &device,
+		const ModuleID &module,
+		double value,
+		const Poco::Timestamp &at);
+
+	Poco::Nullable<Entry> lookup(
+		const DeviceID &device,
+		const ModuleID &module) const;
+
+	/**
+	 * @returns value not older than maxAge or null if no such
+	 * value is known
+	 */
+	Poco::Nullable<Entry> fresh(
+		const DeviceID &device,
+		const ModuleID &module) const;
+
+	size_t size() const;
+
+	void onExport(const SensorData &data) override;
+
+	/**
+	 * @brief Accept every ServerLastValueCommand. The handle()
+	 * decides whether the command is answered locally or forwarded
+	 * to the fallback.
+	 */
+	bool accept(const Command::Ptr cmd) override;
+	void handle(Command::Ptr cmd, Answer::Ptr answer) override;
+
+	/**
+	 * @brief Load the persisted values and persist changes
+	 * periodically until stopped.
+	 */
+	void run() override;
+	void stop() override;
+
+	/**
+	 * @brief Load values from the configured file.
+	 * @returns count of loaded records
+	 */
+	size_t load();
+
+	/**
+	 * @brief Write all values into the configured file. The file
+	 * is replaced atomically.
+	 */
+	void persist();
+
+private:
+	typedef std::pair<DeviceID, ModuleID> Key;
+
+	Poco::Timespan m_maxAge;
+	std::string m_file;
+	Poco::Timespan m_persistInterval;
+	Poco::SharedPtr<CommandHandler> m_fallback;
+	std::map<Key, Entry> m_values;
+	bool m_dirty;
+	mutable Poco::RWLock m_lock;
+	StopControl m_stopControl;
+	MetricCounter &m_localCounter;
+};
+
+}
@@ -0,0 +1,11 @@
+#include "core/ModuleTypeResolver.h"
+
+using namespace BeeeOn;
+
+ModuleTypeResolver::ModuleTypeResolver()
+{
+}
+
+ModuleTypeResolver::~ModuleTypeResolver()
+{
+}
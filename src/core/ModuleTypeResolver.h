@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+#include <Poco/SharedPtr.h>
+
+#include "model/DeviceID.h"
+#include "model/ModuleID.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Interface of a source of module types of devices known
+ * to the gateway.
+ */
+class ModuleTypeResolver {
+public:
+	typedef Poco::SharedPtr<ModuleTypeResolver> Ptr;
+
+	ModuleTypeResolver();
+	virtual ~ModuleTypeResolver();
+
+	/**
+	 * @returns name of the type of the given module (e.g. "motion")
+	 * or an empty string when the type is not known
+	 */
+	virtual std::string typeOf(
+		const DeviceID &device,
+		const ModuleID &module) const = 0;
+};
+
+}
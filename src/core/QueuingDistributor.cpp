@@ -1,8 +1,16 @@
+#include <algorithm>
+#include <set>
+#include <vector>
+
 #include <Poco/Exception.h>
 #include <Poco/Logger.h>
 
 #include "core/QueuingDistributor.h"
+#include "core/StageLatency.h"
 #include "di/Injectable.h"
+#include "util/AllocationTracker.h"
+#include "util/MetricsRegistry.h"
+#include "util/SamplingProfiler.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, QueuingDistributor)
 BEEEON_OBJECT_CASTABLE(Distributor)
@@ -15,6 +23,12 @@ BEEEON_OBJECT_PROPERTY("batchSize", &QueuingDistributor::setQueueBatchSize)
 BEEEON_OBJECT_PROPERTY("treshold", &QueuingDistributor::setQueueTreshold)
 BEEEON_OBJECT_PROPERTY("eventsExecutor", &QueuingDistributor::setExecutor)
 BEEEON_OBJECT_PROPERTY("listeners", &QueuingDistributor::registerListener)
+BEEEON_OBJECT_PROPERTY("filters", &QueuingDistributor::registerFilter)
+BEEEON_OBJECT_PROPERTY("rateLimit", &QueuingDistributor::setRateLimit)
+BEEEON_OBJECT_PROPERTY("rateLimitBurst", &QueuingDistributor::setRateLimitBurst)
+BEEEON_OBJECT_PROPERTY("rateLimitReport", &QueuingDistributor::setRateLimitReport)
+BEEEON_OBJECT_PROPERTY("rateLimitExempt", &QueuingDistributor::setRateLimitExempt)
+BEEEON_OBJECT_PROPERTY("moduleTypes", &QueuingDistributor::setModuleTypes)
 BEEEON_OBJECT_END(BeeeOn, QueuingDistributor)
 
 using namespace BeeeOn;
@@ -26,6 +40,8 @@ const static Timespan DEFAULT_EMPTY_TIMEOUT = Timespan(5 * Timespan::SECONDS);
 const static int DEFAULT_QUEUE_CAPACITY = 1000;
 const static int DEFAULT_BATCH_SIZE = 30;
 const static int DEFAULT_TRESHOLD = 10;
+const static Timespan DEFAULT_REPORT_INTERVAL = Timespan(1 * Timespan::MINUTES);
+static const AllocationTag DISTRIBUTOR_TAG("distributor");
 
 QueuingDistributor::QueuingDistributor():
 	m_stop(false),
@@ -33,7 +49,8 @@ QueuingDistributor::QueuingDistributor():
 	m_idleTimeout(DEFAULT_EMPTY_TIMEOUT),
 	m_queueCapacity(DEFAULT_QUEUE_CAPACITY),
 	m_batchSize(DEFAULT_BATCH_SIZE),
-	m_treshold(DEFAULT_TRESHOLD)
+	m_treshold(DEFAULT_TRESHOLD),
+	m_reportInterval(DEFAULT_REPORT_INTERVAL)
 {
 }
 
@@ -81,6 +98,37 @@ void QueuingDistributor::setIdleTimeout(const Timespan &timeout)
 	m_idleTimeout = timeout;
 }
 
+void QueuingDistributor::setRateLimit(const Timespan &interval)
+{
+	if (interval < 0)
+		throw InvalidArgumentException("rate limit must not be negative");
+
+	m_limiter.setInterval(interval);
+}
+
+void QueuingDistributor::setRateLimitBurst(int burst)
+{
+	m_limiter.setBurst(burst);
+}
+
+void QueuingDistributor::setRateLimitExempt(const list<string> &types)
+{
+	m_limiter.setExemptTypes(set<string>(types.begin(), types.end()));
+}
+
+void QueuingDistributor::setModuleTypes(ModuleTypeResolver::Ptr types)
+{
+	m_limiter.setModuleTypes(types);
+}
+
+void QueuingDistributor::setRateLimitReport(const Timespan &interval)
+{
+	if (interval <= 0)
+		throw InvalidArgumentException("rate limit report interval must be positive");
+
+	m_reportInterval = interval;
+}
+
 void QueuingDistributor::registerExporter(SharedPtr<Exporter> exporter)
 {
 	ExporterQueue::Ptr queue = new ExporterQueue(exporter,
@@ -98,11 +146,16 @@ void QueuingDistributor::registerExporter(SharedPtr<Exporter> exporter)
 
 void QueuingDistributor::run()
 {
+	SamplingProfiler::labelThread("distributor");
+	AllocationTracker::tagThread(DISTRIBUTOR_TAG);
 	logger().debug("distributor started");
 
 	while (!m_stop) {
 		unsigned int cannotExport = 0;
 
+		releaseFiltered(Timestamp());
+		const Timespan nextRelease = releaseLimited();
+
 		for (auto q : m_queues) {
 			if (q->canExport(m_deadTimeout)) {
 				if (q->exportBatch() == 0)
@@ -114,10 +167,19 @@ void QueuingDistributor::run()
 		}
 
 		// nothing was exported
-		if (cannotExport == m_queues.size())
-			m_newData.tryWait(m_idleTimeout.totalMilliseconds());
+		if (cannotExport == m_queues.size()) {
+			Timespan timeout = m_idleTimeout;
+
+			// wake up in time to release data held by the limiter
+			if (nextRelease >= 0 && nextRelease < timeout)
+				timeout = max<Timespan::TimeDiff>(nextRelease.totalMicroseconds(), 1000);
+
+			m_newData.tryWait(timeout.totalMilliseconds());
+		}
 	}
 
+	flush();
+
 	m_stop = false;
 	logger().debug("distributor stopped");
 }
@@ -132,13 +194,94 @@ void QueuingDistributor::stop()
 
 void QueuingDistributor::exportData(const SensorData &sensorData)
 {
+	static MetricCounter &distributed = MetricsRegistry::instance().counter(
+		"beeeon_distributor_data_total",
+		"Sensor data passed to a distributor",
+		{{"distributor", "QueuingDistributor"}});
+
 	if (m_stop)
 		return;
 
+	distributed.inc();
+	StageLatency::instance().record(StageLatency::DISTRIBUTE, sensorData);
+
 	notifyListeners(sensorData);
 
+	SensorData buffer;
+	const SensorData *filtered = applyFilters(sensorData, buffer);
+
+	releaseFiltered(Timestamp());
+
+	if (filtered == nullptr)
+		return;
+
+	if (m_limiter.admit(*filtered))
+		enqueue(*filtered);
+
+	m_newData.set();
+}
+
+void QueuingDistributor::enqueue(const SensorData &data)
+{
 	for (auto q : m_queues)
-		q->enqueue(sensorData);
+		q->enqueue(data);
+}
+
+void QueuingDistributor::releaseFiltered(const Timestamp &until)
+{
+	vector<SensorData> released;
+	if (releaseFilters(released, until) == 0)
+		return;
+
+	for (const auto &data : released) {
+		if (m_limiter.admit(data))
+			enqueue(data);
+	}
 
 	m_newData.set();
 }
+
+void QueuingDistributor::flush()
+{
+	// windows of filters and deferred data would be lost otherwise
+	releaseFiltered(Timestamp::TIMEVAL_MAX);
+
+	vector<SensorData> released;
+	m_limiter.flush(released);
+
+	for (const auto &data : released)
+		enqueue(data);
+
+	for (auto q : m_queues) {
+		while (q->canExport(m_deadTimeout)) {
+			if (q->exportBatch() == 0)
+				break;
+		}
+	}
+}
+
+Timespan QueuingDistributor::releaseLimited()
+{
+	vector<SensorData> released;
+	m_limiter.release(released);
+
+	for (const auto &data : released)
+		enqueue(data);
+
+	if (m_lastReport.isElapsed(m_reportInterval.totalMicroseconds())) {
+		vector<DeviceRateLimiter::Offender> offenders;
+		m_limiter.report(offenders);
+
+		for (const auto &offender : offenders) {
+			logger().warning("device " + offender.device.toString()
+				+ " exceeded rate limit: "
+				+ to_string(offender.limited) + " limited, "
+				+ to_string(offender.coalesced) + " coalesced",
+				__FILE__, __LINE__);
+		}
+
+		m_lastReport.update();
+	}
+
+	return m_limiter.nextRelease();
+}
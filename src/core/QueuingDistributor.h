@@ -1,6 +1,11 @@
 #pragma once
 
+#include <list>
+#include <string>
+#include <vector>
+
 #include <Poco/AtomicCounter.h>
+#include <Poco/Clock.h>
 #include <Poco/Event.h>
 #include <Poco/Mutex.h>
 #include <Poco/SharedPtr.h>
@@ -8,7 +13,9 @@
 #include <Poco/Timestamp.h>
 
 #include "core/AbstractDistributor.h"
+#include "core/DeviceRateLimiter.h"
 #include "core/ExporterQueue.h"
+#include "core/ModuleTypeResolver.h"
 #include "loop/StoppableRunnable.h"
 #include "model/SensorData.h"
 
@@ -38,10 +45,64 @@ public:
 	 */
 	void setIdleTimeout(const Poco::Timespan &timeout);
 
+	/**
+	 * Minimal average interval between data of a single device.
+	 * Data exceeding the rate are deferred and coalesced so that
+	 * a device reporting in a tight loop cannot evict data of other
+	 * devices from the ExporterQueues. Zero disables the limit
+	 * (default). Deferred data are exported when stopping.
+	 * @see DeviceRateLimiter
+	 */
+	void setRateLimit(const Poco::Timespan &interval);
+
+	/**
+	 * Count of data of a single device that can be exported at once
+	 * without being limited.
+	 */
+	void setRateLimitBurst(int burst);
+
+	/**
+	 * Values of the given module types (e.g. events) are not
+	 * coalesced by the rate limiter.
+	 */
+	void setRateLimitExempt(const std::list<std::string> &types);
+
+	/**
+	 * Source of module types to identify the exempt modules.
+	 */
+	void setModuleTypes(ModuleTypeResolver::Ptr types);
+
+	/**
+	 * Devices that exceeded the rate limit are reported in the given
+	 * interval.
+	 */
+	void setRateLimitReport(const Poco::Timespan &interval);
+
 	void run() override;
 	void stop() override;
 
 protected:
+	void enqueue(const SensorData &data);
+
+	/**
+	 * Enqueue data released by filters until the given time
+	 * unless they are held by the rate limiter.
+	 */
+	void releaseFiltered(const Poco::Timestamp &until);
+
+	/**
+	 * Export all data held back by filters and the rate limiter
+	 * and all queued data unless the exporters fail.
+	 */
+	void flush();
+
+	/**
+	 * Enqueue data released by the rate limiter and report offending
+	 * devices when it is time to.
+	 * @returns time until the next release or a negative value
+	 */
+	Poco::Timespan releaseLimited();
+
 	std::vector<ExporterQueue::Ptr> m_queues;
 	Poco::Event m_newData;
 	Poco::AtomicCounter m_stop;
@@ -50,6 +111,9 @@ protected:
 	int m_queueCapacity;
 	int m_batchSize;
 	int m_treshold;
+	DeviceRateLimiter m_limiter;
+	Poco::Timespan m_reportInterval;
+	Poco::Clock m_lastReport;
 };
 
 }
@@ -0,0 +1,15 @@
+#include "core/SensorSeries.h"
+
+using namespace Poco;
+using namespace BeeeOn;
+
+bool SensorSeries::operator ==(const SensorSeries &other) const
+{
+	return device == other.device && module == other.module;
+}
+
+UInt64 SensorSeries::Hash::operator()(const SensorSeries &series) const
+{
+	return series.device.ident()
+		^ (static_cast<UInt64>(series.module.value()) << 48);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Poco/Types.h>
+
+#include "model/DeviceID.h"
+#include "model/ModuleID.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Identification of a series of values reported by a single
+ * module of a single device. It is intended as a key of FlatHashMap.
+ */
+struct SensorSeries {
+	DeviceID device;
+	ModuleID module;
+
+	bool operator ==(const SensorSeries &other) const;
+
+	struct Hash {
+		Poco::UInt64 operator()(const SensorSeries &series) const;
+	};
+};
+
+}
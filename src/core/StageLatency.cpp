@@ -0,0 +1,75 @@
+#include <Poco/Exception.h>
+#include <Poco/SingletonHolder.h>
+#include <Poco/Timestamp.h>
+
+#include "core/StageLatency.h"
+#include "model/SensorData.h"
+#include "util/MetricsRegistry.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+StageLatency::StageLatency()
+{
+	for (int i = 0; i < STAGE_COUNT; ++i) {
+		const auto stage = static_cast<Stage>(i);
+
+		m_histograms[i] = &MetricsRegistry::instance().histogram(
+			"beeeon_stage_latency_seconds",
+			"Time since creation of data when reaching a stage of export",
+			{{"stage", name(stage)}});
+	}
+}
+
+StageLatency &StageLatency::instance()
+{
+	static SingletonHolder<StageLatency> singleton;
+	return *singleton.get();
+}
+
+void StageLatency::record(Stage stage, const SensorData &data)
+{
+	const Timestamp now;
+	record(stage, Timespan(now - data.timestamp().value()));
+}
+
+void StageLatency::record(Stage stage, const Timespan &latency)
+{
+	poco_assert(stage < STAGE_COUNT);
+	m_histograms[stage]->record(latency);
+}
+
+LatencyHistogram::Snapshot StageLatency::snapshot(Stage stage) const
+{
+	if (stage >= STAGE_COUNT)
+		throw InvalidArgumentException("invalid stage " + to_string(stage));
+
+	return m_histograms[stage]->snapshot();
+}
+
+void StageLatency::reset()
+{
+	for (auto histogram : m_histograms)
+		histogram->reset();
+}
+
+string StageLatency::name(Stage stage)
+{
+	switch (stage) {
+	case SHIP:
+		return "ship";
+	case DISTRIBUTE:
+		return "distribute";
+	case DEQUEUE:
+		return "dequeue";
+	case EXPORT:
+		return "export";
+	case GWS_SEND:
+		return "gws-send";
+	case GWS_CONFIRM:
+		return "gws-confirm";
+	default:
+		throw InvalidArgumentException("invalid stage " + to_string(stage));
+	}
+}
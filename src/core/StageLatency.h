@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+
+#include <Poco/Timespan.h>
+
+#include "util/LatencyHistogram.h"
+
+namespace BeeeOn {
+
+class SensorData;
+
+/**
+ * @brief StageLatency collects latencies of SensorData on their way
+ * from a device manager to the server. At each stage, the time elapsed
+ * since SensorData::timestamp() is recorded into a histogram dedicated
+ * to that stage. Comparing histograms of subsequent stages shows where
+ * the time goes.
+ *
+ * Recording is lock-free and costs a clock read and a few relaxed
+ * atomic increments, so it is always enabled. The histograms are
+ * registered in the MetricsRegistry as beeeon_stage_latency_seconds.
+ */
+class StageLatency {
+public:
+	enum Stage {
+		/**
+		 * DeviceManager::ship() called.
+		 */
+		SHIP = 0,
+		/**
+		 * Distributor::exportData() called.
+		 */
+		DISTRIBUTE,
+		/**
+		 * Data taken out of an ExporterQueue to be shipped.
+		 */
+		DEQUEUE,
+		/**
+		 * Exporter::ship() accepted the data.
+		 */
+		EXPORT,
+		/**
+		 * GWServerConnector sent the data to the server.
+		 */
+		GWS_SEND,
+		/**
+		 * Server confirmed reception of the data.
+		 */
+		GWS_CONFIRM,
+		STAGE_COUNT,
+	};
+
+	StageLatency();
+
+	static StageLatency &instance();
+
+	void record(Stage stage, const SensorData &data);
+	void record(Stage stage, const Poco::Timespan &latency);
+
+	LatencyHistogram::Snapshot snapshot(Stage stage) const;
+
+	void reset();
+
+	static std::string name(Stage stage);
+
+private:
+	LatencyHistogram *m_histograms[STAGE_COUNT];
+};
+
+}
@@ -1,3 +1,5 @@
+#include <sstream>
+
 #include <Poco/Crypto/Cipher.h>
 #include <Poco/Crypto/CipherFactory.h>
 #include <Poco/Crypto/CipherKey.h>
@@ -16,12 +18,15 @@
 #include "commands/ServerLastValueResult.h"
 #include "core/Command.h"
 #include "core/CommandDispatcher.h"
+#include "core/StageLatency.h"
 #include "core/TestingCenter.h"
 #include "credentials/PasswordCredentials.h"
 #include "credentials/PinCredentials.h"
 #include "di/Injectable.h"
 #include "model/ModuleType.h"
 #include "util/ArgsParser.h"
+#include "util/InputTraceRecorder.h"
+#include "util/SamplingProfiler.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, TestingCenter)
 BEEEON_OBJECT_CASTABLE(CommandHandler)
@@ -30,6 +35,7 @@ BEEEON_OBJECT_PROPERTY("commandDispatcher", &TestingCenter::setCommandDispatcher
 BEEEON_OBJECT_PROPERTY("console", &TestingCenter::setConsole)
 BEEEON_OBJECT_PROPERTY("credentialsStorage", &TestingCenter::setCredentialsStorage)
 BEEEON_OBJECT_PROPERTY("cryptoConfig", &TestingCenter::setCryptoConfig)
+BEEEON_OBJECT_PROPERTY("historian", &TestingCenter::setHistorian)
 BEEEON_OBJECT_PROPERTY("pairedDevices", &TestingCenter::setPairedDevices)
 BEEEON_OBJECT_END(BeeeOn, TestingCenter)
 
@@ -450,6 +456,151 @@ static void credentialsAction(TestingCenter::ActionContext &context)
 	}
 }
 
+static void latencyAction(TestingCenter::ActionContext &context)
+{
+	ConsoleSession &console = context.console;
+	const StageLatency &latency = StageLatency::instance();
+
+	if (context.args.size() > 1 && context.args[1] == "help") {
+		console.print("usage: latency");
+		console.print("prints latency (us) of data since their creation at each stage:");
+
+		for (int i = 0; i < StageLatency::STAGE_COUNT; ++i)
+			console.print("  " + StageLatency::name(static_cast<StageLatency::Stage>(i)));
+
+		return;
+	}
+
+	for (int i = 0; i < StageLatency::STAGE_COUNT; ++i) {
+		const auto stage = static_cast<StageLatency::Stage>(i);
+		const LatencyHistogram::Snapshot &snapshot = latency.snapshot(stage);
+
+		console.print(StageLatency::name(stage)
+			+ " count " + to_string(snapshot.count())
+			+ " mean " + to_string(snapshot.mean())
+			+ " p50 " + to_string(snapshot.percentile(0.5))
+			+ " p90 " + to_string(snapshot.percentile(0.9))
+			+ " p99 " + to_string(snapshot.percentile(0.99))
+			+ " p999 " + to_string(snapshot.percentile(0.999))
+			+ " max " + to_string(snapshot.max()));
+	}
+}
+
+static void profilerAction(TestingCenter::ActionContext &context)
+{
+	ConsoleSession &console = context.console;
+	SamplingProfiler &profiler = SamplingProfiler::instance();
+
+	if (context.args.size() < 2 || context.args[1] == "help") {
+		console.print("usage: profiler <action> [<args>...]");
+		console.print("actions:");
+		console.print("  start [<interval-us>]");
+		console.print("  stop");
+		console.print("  status");
+		console.print("  clear");
+		console.print("  dump");
+		return;
+	}
+
+	const string &action = context.args[1];
+
+	if (action == "start") {
+		if (context.args.size() > 2)
+			profiler.start(NumberParser::parse(context.args[2]));
+		else
+			profiler.start();
+	}
+	else if (action == "stop") {
+		profiler.stop();
+	}
+	else if (action == "status") {
+		console.print(string(profiler.running() ? "running" : "stopped")
+			+ " samples " + to_string(profiler.sampleCount()));
+	}
+	else if (action == "clear") {
+		profiler.clear();
+	}
+	else if (action == "dump") {
+		ostringstream out;
+		profiler.dump(out);
+
+		StringTokenizer lines(out.str(), "\n", StringTokenizer::TOK_IGNORE_EMPTY);
+		for (const auto &line : lines)
+			console.print(line);
+	}
+	else {
+		console.print("unrecognized action: " + action);
+	}
+}
+
+static void traceAction(TestingCenter::ActionContext &context)
+{
+	ConsoleSession &console = context.console;
+	InputTraceRecorder &recorder = InputTraceRecorder::instance();
+
+	if (context.args.size() < 2 || context.args[1] == "help") {
+		console.print("usage: trace <action> [<args>...]");
+		console.print("actions:");
+		console.print("  start <path>");
+		console.print("  stop");
+		console.print("  status");
+		return;
+	}
+
+	const string &action = context.args[1];
+
+	if (action == "start") {
+		assureArgs(context, 3, "trace start");
+		recorder.start(context.args[2]);
+	}
+	else if (action == "stop") {
+		recorder.stop();
+	}
+	else if (action == "status") {
+		console.print(string(recorder.active() ? "recording" : "stopped")
+			+ " records " + to_string(recorder.recorded()));
+	}
+	else {
+		console.print("unrecognized action: " + action);
+	}
+}
+
+static void historyAction(TestingCenter::ActionContext &context)
+{
+	ConsoleSession &console = context.console;
+
+	if (context.args.size() < 3 || context.args[1] == "help") {
+		console.print("usage: history <device-id> <module-id> [<from> [<to>]]");
+		console.print("prints values in range [from, to) as <timestamp-ms> <value>");
+		console.print("from and to are seconds since epoch, last hour by default");
+		return;
+	}
+
+	if (context.historian.isNull()) {
+		console.print("historian is disabled");
+		return;
+	}
+
+	const DeviceID device = DeviceID::parse(context.args[1]);
+	const ModuleID module = ModuleID::parse(context.args[2]);
+
+	Timestamp to;
+	Timestamp from = to - 1 * Timespan::HOURS;
+
+	if (context.args.size() > 3)
+		from = Timestamp::fromEpochTime(NumberParser::parse64(context.args[3]));
+	if (context.args.size() > 4)
+		to = Timestamp::fromEpochTime(NumberParser::parse64(context.args[4]));
+
+	vector<HistorianStore::Point> points;
+	context.historian->query(device, module, from, to, points);
+
+	for (const auto &point : points) {
+		console.print(to_string(point.at.epochMicroseconds() / 1000)
+			+ " " + NumberFormatter::format(point.value));
+	}
+}
+
 TestingCenter::TestingCenter():
 	m_stop(0)
 {
@@ -458,6 +609,10 @@ TestingCenter::TestingCenter():
 	registerAction("wait-queue", waitQueueAction, "wait for new command answers");
 	registerAction("device", deviceAction, "simulate device in server database");
 	registerAction("credentials", credentialsAction, "manage credentials storage");
+	registerAction("latency", latencyAction, "show latency of data at stages of export");
+	registerAction("profiler", profilerAction, "control sampling profiler");
+	registerAction("trace", traceAction, "record inputs of device managers");
+	registerAction("history", historyAction, "query local history of sensor values");
 }
 
 void TestingCenter::registerAction(
@@ -495,6 +650,11 @@ void TestingCenter::setCryptoConfig(SharedPtr<CryptoConfig> config)
 	m_cryptoConfig = config;
 }
 
+void TestingCenter::setHistorian(HistorianExporter::Ptr historian)
+{
+	m_historian = historian;
+}
+
 void TestingCenter::printHelp(ConsoleSession &session)
 {
 	session.print("Gateway Testing Center");
@@ -529,7 +689,8 @@ void TestingCenter::processLine(ConsoleSession &session, const string &line)
 	}
 
 	ActionContext context {session, m_devices, m_mutex,
-		*this, args, m_credentialsStorage, m_cryptoConfig, m_newDevices, m_acceptedDevices, m_seenDevices};
+		*this, args, m_credentialsStorage, m_cryptoConfig, m_newDevices, m_acceptedDevices, m_seenDevices,
+		m_historian};
 	Action f = it->second.action;
 
 	try {
@@ -6,6 +6,7 @@
 #include "util/ConfigurationLoader.h"
 #include "util/ConfigurationSaver.h"
 #include "di/Injectable.h"
+#include "util/StartupTracer.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, FileCredentialsStorage)
 BEEEON_OBJECT_CASTABLE(CredentialsStorage)
@@ -86,6 +87,8 @@ void FileCredentialsStorage::clear()
 
 void FileCredentialsStorage::load()
 {
+	StartupTracer::Scope trace("FileCredentialsStorage::load");
+
 	if (m_file.empty())
 		return;
 
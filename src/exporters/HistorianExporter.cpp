@@ -0,0 +1,126 @@
+#include <cmath>
+
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+
+#include "di/Injectable.h"
+#include "exporters/HistorianExporter.h"
+#include "model/SensorData.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, HistorianExporter)
+BEEEON_OBJECT_CASTABLE(Exporter)
+BEEEON_OBJECT_PROPERTY("rootDir", &HistorianExporter::setRootDir)
+BEEEON_OBJECT_PROPERTY("partitionDuration", &HistorianExporter::setPartitionDuration)
+BEEEON_OBJECT_PROPERTY("retention", &HistorianExporter::setRetention)
+BEEEON_OBJECT_PROPERTY("sizeLimit", &HistorianExporter::setSizeLimit)
+BEEEON_OBJECT_PROPERTY("blockPoints", &HistorianExporter::setBlockPoints)
+BEEEON_OBJECT_PROPERTY("maxFuture", &HistorianExporter::setMaxFuture)
+BEEEON_OBJECT_PROPERTY("flushInterval", &HistorianExporter::setFlushInterval)
+BEEEON_OBJECT_HOOK("done", &HistorianExporter::open)
+BEEEON_OBJECT_HOOK("cleanup", &HistorianExporter::flush)
+BEEEON_OBJECT_END(BeeeOn, HistorianExporter)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+HistorianExporter::HistorianExporter():
+	m_flushInterval(1 * Timespan::HOURS)
+{
+}
+
+void HistorianExporter::setRootDir(const string &dir)
+{
+	m_store.setRootDir(dir);
+}
+
+void HistorianExporter::setPartitionDuration(const Timespan &duration)
+{
+	m_store.setPartitionDuration(duration);
+}
+
+void HistorianExporter::setRetention(const Timespan &retention)
+{
+	m_store.setRetention(retention);
+}
+
+void HistorianExporter::setSizeLimit(int bytes)
+{
+	if (bytes <= 0)
+		throw InvalidArgumentException("sizeLimit must be positive");
+
+	m_store.setSizeLimit(bytes);
+}
+
+void HistorianExporter::setBlockPoints(int points)
+{
+	if (points <= 0)
+		throw InvalidArgumentException("blockPoints must be positive");
+
+	m_store.setBlockPoints(points);
+}
+
+void HistorianExporter::setMaxFuture(const Timespan &future)
+{
+	m_store.setMaxFuture(future);
+}
+
+void HistorianExporter::setFlushInterval(const Timespan &interval)
+{
+	if (interval < 0)
+		throw InvalidArgumentException("flushInterval must not be negative");
+
+	m_flushInterval = interval;
+}
+
+void HistorianExporter::open()
+{
+	m_store.open();
+}
+
+void HistorianExporter::flush()
+{
+	FastMutex::ScopedLock guard(m_flushLock);
+
+	m_store.flush();
+	m_lastFlush.update();
+}
+
+bool HistorianExporter::ship(const SensorData &data)
+{
+	const Timestamp &at = data.timestamp().value();
+
+	try {
+		for (const auto &item : data) {
+			if (!item.isValid() || std::isnan(item.value()))
+				continue;
+
+			m_store.append(data.deviceID(), item.moduleID(), at, item.value());
+		}
+
+		FastMutex::ScopedLock guard(m_flushLock);
+
+		if (m_lastFlush.isElapsed(m_flushInterval.totalMicroseconds())) {
+			m_store.flush();
+			m_lastFlush.update();
+		}
+	}
+	BEEEON_CATCH_CHAIN(logger())
+
+	return true;
+}
+
+void HistorianExporter::query(
+		const DeviceID &device,
+		const ModuleID &module,
+		const Timestamp &from,
+		const Timestamp &to,
+		vector<HistorianStore::Point> &points) const
+{
+	m_store.query(device, module, from, to, points);
+}
+
+HistorianStore &HistorianExporter::store()
+{
+	return m_store;
+}
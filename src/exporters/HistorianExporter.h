@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+
+#include "core/Exporter.h"
+#include "exporters/HistorianStore.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief HistorianExporter keeps history of all shipped sensor values
+ * in the embedded HistorianStore. The history can be queried locally
+ * (e.g. via TestingCenter) for diagnostics or edge analytics.
+ *
+ * Values are collected in memory and sealed into the store when
+ * the flushInterval elapses or when a block is full. Thus, at most
+ * flushInterval of history might be lost on power failure.
+ */
+class HistorianExporter : public Exporter, protected Loggable {
+public:
+	typedef Poco::SharedPtr<HistorianExporter> Ptr;
+
+	HistorianExporter();
+
+	void setRootDir(const std::string &dir);
+	void setPartitionDuration(const Poco::Timespan &duration);
+	void setRetention(const Poco::Timespan &retention);
+	void setSizeLimit(int bytes);
+	void setBlockPoints(int points);
+	void setMaxFuture(const Poco::Timespan &future);
+	void setFlushInterval(const Poco::Timespan &interval);
+
+	/**
+	 * @brief Open the underlying store.
+	 */
+	void open();
+
+	/**
+	 * @brief Seal all collected values into the store.
+	 */
+	void flush();
+
+	/**
+	 * Append all valid values of the given data into the history.
+	 * @returns always true, failing writes are retried on the next flush
+	 */
+	bool ship(const SensorData &data) override;
+
+	/**
+	 * @brief Find history of the given module in range [from, to).
+	 * @see HistorianStore::query()
+	 */
+	void query(
+		const DeviceID &device,
+		const ModuleID &module,
+		const Poco::Timestamp &from,
+		const Poco::Timestamp &to,
+		std::vector<HistorianStore::Point> &points) const;
+
+	HistorianStore &store();
+
+private:
+	HistorianStore m_store;
+	Poco::Timespan m_flushInterval;
+	Poco::Timestamp m_lastFlush;
+	Poco::FastMutex m_flushLock;
+};
+
+}
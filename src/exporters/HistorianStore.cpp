@@ -0,0 +1,589 @@
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include <Poco/Checksum.h>
+#include <Poco/DirectoryIterator.h>
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/Logger.h>
+#include <Poco/NumberParser.h>
+#include <Poco/Path.h>
+
+#include "exporters/HistorianStore.h"
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+static const UInt32 BLOCK_MAGIC = 0x47545331; // "GTS1"
+static const string PARTITION_EXTENSION = "gts";
+
+/**
+ * magic, series name length, count, min time, max time,
+ * data length and CRC-32 of data
+ */
+static const size_t BLOCK_HEADER_SIZE = 4 + 1 + 4 + 8 + 8 + 4 + 4;
+
+static const Int64 NO_TIME = numeric_limits<Int64>::min();
+
+static void writeUInt(string &out, UInt64 value, unsigned int bytes)
+{
+	for (int i = bytes - 1; i >= 0; --i)
+		out.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+}
+
+static UInt64 readUInt(const char *in, unsigned int bytes)
+{
+	UInt64 value = 0;
+
+	for (unsigned int i = 0; i < bytes; ++i)
+		value = (value << 8) | static_cast<UInt8>(in[i]);
+
+	return value;
+}
+
+static UInt32 crc32(const string &data)
+{
+	Checksum checksum(Checksum::TYPE_CRC32);
+	checksum.update(data);
+	return checksum.checksum();
+}
+
+static Int64 toMillis(const Timestamp &at)
+{
+	return at.epochMicroseconds() / 1000;
+}
+
+HistorianStore::HistorianStore():
+	m_partitionDuration(1 * Timespan::DAYS),
+	m_retention(365 * Timespan::DAYS),
+	m_sizeLimit(64 * 1024 * 1024),
+	m_maxFuture(1 * Timespan::HOURS),
+	m_blockPoints(512),
+	m_newest(NO_TIME),
+	m_current(NO_TIME),
+	m_pending(0)
+{
+}
+
+HistorianStore::~HistorianStore()
+{
+}
+
+void HistorianStore::setRootDir(const string &dir)
+{
+	m_rootDir = dir;
+}
+
+void HistorianStore::setPartitionDuration(const Timespan &duration)
+{
+	if (duration < 1 * Timespan::SECONDS)
+		throw InvalidArgumentException("partition duration must be at least 1 s");
+
+	m_partitionDuration = duration;
+}
+
+void HistorianStore::setRetention(const Timespan &retention)
+{
+	if (retention <= 0)
+		throw InvalidArgumentException("retention must be positive");
+
+	m_retention = retention;
+}
+
+void HistorianStore::setSizeLimit(UInt64 bytes)
+{
+	if (bytes == 0)
+		throw InvalidArgumentException("size limit must be positive");
+
+	m_sizeLimit = bytes;
+}
+
+void HistorianStore::setMaxFuture(const Timespan &future)
+{
+	if (future < 0)
+		throw InvalidArgumentException("max future must not be negative");
+
+	m_maxFuture = future;
+}
+
+void HistorianStore::setBlockPoints(unsigned int points)
+{
+	if (points == 0)
+		throw InvalidArgumentException("block points must be positive");
+
+	m_blockPoints = points;
+}
+
+void HistorianStore::open()
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	File root(m_rootDir);
+	root.createDirectories();
+
+	m_partitions.clear();
+
+	for (DirectoryIterator it(root); it != DirectoryIterator(); ++it) {
+		const Path &path = it.path();
+
+		if (path.getExtension() != PARTITION_EXTENSION || !it->isFile())
+			continue;
+
+		Int64 partition;
+		if (!NumberParser::tryParse64(path.getBaseName(), partition)) {
+			logger().warning("skipping unexpected file " + path.toString(),
+				__FILE__, __LINE__);
+			continue;
+		}
+
+		const UInt64 size = it->getSize();
+		const UInt64 valid = validSize(path.toString(), size);
+
+		if (valid < size) {
+			logger().warning("truncating partition " + path.toString()
+				+ " from " + to_string(size) + " to " + to_string(valid),
+				__FILE__, __LINE__);
+
+			File(path).setSize(valid);
+		}
+
+		m_partitions[partition] = valid;
+	}
+
+	if (!m_partitions.empty())
+		m_current = m_partitions.rbegin()->first;
+
+	logger().information("opened " + to_string(m_partitions.size())
+		+ " partitions in " + m_rootDir, __FILE__, __LINE__);
+}
+
+string HistorianStore::seriesName(const DeviceID &device, const ModuleID &module)
+{
+	return device.toString() + ":" + module.toString();
+}
+
+Int64 HistorianStore::partitionOf(Int64 time) const
+{
+	const Int64 duration = m_partitionDuration.totalMilliseconds();
+
+	if (time >= 0)
+		return time / duration * duration;
+
+	return -((-time + duration - 1) / duration) * duration;
+}
+
+string HistorianStore::partitionPath(Int64 partition) const
+{
+	Path path(m_rootDir);
+	path.makeDirectory();
+	path.setFileName(to_string(partition) + "." + PARTITION_EXTENSION);
+
+	return path.toString();
+}
+
+void HistorianStore::append(
+		const DeviceID &device,
+		const ModuleID &module,
+		const Timestamp &at,
+		double value)
+{
+	const Int64 time = toMillis(at);
+	const Int64 now = toMillis(Timestamp{});
+
+	if (time > now + m_maxFuture.totalMilliseconds()) {
+		logger().warning("dropping point of " + seriesName(device, module)
+			+ " too far in the future", __FILE__, __LINE__);
+
+		return;
+	}
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	const Int64 limit = horizon(now);
+
+	if (limit != NO_TIME && time < limit) {
+		if (logger().debug()) {
+			logger().debug("dropping point of " + seriesName(device, module)
+				+ " older than retention", __FILE__, __LINE__);
+		}
+
+		return;
+	}
+
+	const Int64 partition = partitionOf(time);
+
+	if (m_current == NO_TIME || partition > m_current) {
+		sealBefore(partition);
+		m_current = partition;
+	}
+
+	const BlockKey key(partition, seriesName(device, module));
+	Block &block = m_blocks[key];
+
+	if (block.encoder.count() == 0) {
+		block.minTime = time;
+		block.maxTime = time;
+	}
+	else {
+		block.minTime = min(block.minTime, time);
+		block.maxTime = max(block.maxTime, time);
+	}
+
+	block.encoder.append(time, value);
+	m_pending += 1;
+
+	if (m_newest == NO_TIME || time > m_newest)
+		m_newest = time;
+
+	if (block.encoder.count() >= m_blockPoints)
+		seal(partition, {key});
+}
+
+void HistorianStore::flush()
+{
+	FastMutex::ScopedLock guard(m_lock);
+	sealBefore(numeric_limits<Int64>::max());
+}
+
+void HistorianStore::sealBefore(Int64 partition)
+{
+	map<Int64, vector<BlockKey>> sealed;
+
+	for (const auto &pair : m_blocks) {
+		const Int64 blockPartition = get<0>(pair.first);
+
+		if (blockPartition < partition)
+			sealed[blockPartition].emplace_back(pair.first);
+	}
+
+	for (const auto &pair : sealed)
+		seal(pair.first, pair.second);
+}
+
+void HistorianStore::seal(Int64 partition, const vector<BlockKey> &keys)
+{
+	string out;
+	size_t points = 0;
+
+	for (const auto &key : keys) {
+		const Block &block = m_blocks.at(key);
+		const string series = get<1>(key).substr(0, 0xff);
+		const string &data = block.encoder.data();
+
+		writeUInt(out, BLOCK_MAGIC, 4);
+		writeUInt(out, series.size(), 1);
+		out += series;
+		writeUInt(out, block.encoder.count(), 4);
+		writeUInt(out, static_cast<UInt64>(block.minTime), 8);
+		writeUInt(out, static_cast<UInt64>(block.maxTime), 8);
+		writeUInt(out, data.size(), 4);
+		writeUInt(out, crc32(data), 4);
+		out += data;
+
+		points += block.encoder.count();
+	}
+
+	const string path = partitionPath(partition);
+	const UInt64 size = m_partitions.count(partition) ? m_partitions[partition] : 0;
+
+	ofstream file(path, ios::binary | ios::app);
+	file.write(out.data(), out.size());
+	file.close();
+
+	if (!file) {
+		// do not leave a partial block behind
+		try {
+			if (File(path).exists())
+				File(path).setSize(size);
+		}
+		BEEEON_CATCH_CHAIN(logger())
+
+		throw WriteFileException("failed to write partition " + path);
+	}
+
+	m_partitions[partition] = size + out.size();
+
+	for (const auto &key : keys)
+		m_blocks.erase(key);
+
+	m_pending -= points;
+
+	enforceLimits();
+}
+
+Int64 HistorianStore::horizon(Int64 now) const
+{
+	if (m_newest == NO_TIME)
+		return NO_TIME;
+
+	// points ahead of the current time must not shift the retention
+	return min(m_newest, now) - m_retention.totalMilliseconds();
+}
+
+void HistorianStore::enforceLimits()
+{
+	const Int64 duration = m_partitionDuration.totalMilliseconds();
+	const Int64 limit = horizon(toMillis(Timestamp{}));
+
+	if (limit != NO_TIME) {
+		while (!m_partitions.empty()) {
+			const Int64 oldest = m_partitions.begin()->first;
+
+			if (oldest == m_current || oldest + duration > limit)
+				break;
+
+			logger().information("dropping partition "
+				+ to_string(oldest) + " due to retention",
+				__FILE__, __LINE__);
+
+			dropPartition(oldest);
+		}
+	}
+
+	UInt64 usage = 0;
+	for (const auto &pair : m_partitions)
+		usage += pair.second;
+
+	while (usage > m_sizeLimit && m_partitions.size() > 1) {
+		const auto oldest = m_partitions.begin();
+
+		if (oldest->first == m_current)
+			break;
+
+		logger().information("dropping partition "
+			+ to_string(oldest->first) + " due to size limit",
+			__FILE__, __LINE__);
+
+		usage -= oldest->second;
+		dropPartition(oldest->first);
+	}
+}
+
+void HistorianStore::dropPartition(Int64 partition)
+{
+	try {
+		File(partitionPath(partition)).remove();
+	}
+	BEEEON_CATCH_CHAIN(logger())
+
+	m_partitions.erase(partition);
+
+	for (auto it = m_blocks.begin(); it != m_blocks.end();) {
+		if (get<0>(it->first) == partition) {
+			m_pending -= it->second.encoder.count();
+			it = m_blocks.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+UInt64 HistorianStore::validSize(const string &path, UInt64 size) const
+{
+	ifstream file(path, ios::binary);
+	if (!file)
+		throw OpenFileException("failed to open partition " + path);
+
+	UInt64 offset = 0;
+	char header[BLOCK_HEADER_SIZE];
+	string data;
+
+	while (offset + BLOCK_HEADER_SIZE <= size) {
+		if (!file.read(header, 5) || readUInt(header, 4) != BLOCK_MAGIC)
+			break;
+
+		const size_t nameLength = readUInt(header + 4, 1);
+		file.seekg(nameLength, ios::cur);
+
+		if (!file.read(header + 5, BLOCK_HEADER_SIZE - 5))
+			break;
+
+		const size_t length = readUInt(header + 25, 4);
+		const UInt64 end = offset + BLOCK_HEADER_SIZE + nameLength + length;
+
+		if (end > size)
+			break;
+
+		// only the last block might have been written partially
+		if (end == size) {
+			data.resize(length);
+
+			if (length > 0 && !file.read(&data[0], length))
+				break;
+			if (crc32(data) != readUInt(header + 29, 4))
+				break;
+		}
+		else {
+			file.seekg(length, ios::cur);
+		}
+
+		offset = end;
+	}
+
+	return offset;
+}
+
+void HistorianStore::query(
+		const DeviceID &device,
+		const ModuleID &module,
+		const Timestamp &from,
+		const Timestamp &to,
+		vector<Point> &points) const
+{
+	const Int64 begin = toMillis(from);
+	const Int64 end = toMillis(to);
+	const Int64 duration = m_partitionDuration.totalMilliseconds();
+	const string series = seriesName(device, module);
+
+	// size of each partition limits reading to blocks sealed before
+	// the collected blocks have been copied
+	vector<pair<string, UInt64>> partitions;
+	vector<pair<string, size_t>> collected;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		for (const auto &pair : m_partitions) {
+			if (pair.first < end && pair.first + duration > begin)
+				partitions.emplace_back(partitionPath(pair.first), pair.second);
+		}
+
+		for (const auto &pair : m_blocks) {
+			const Block &block = pair.second;
+
+			if (get<1>(pair.first) != series)
+				continue;
+			if (block.maxTime < begin || block.minTime >= end)
+				continue;
+
+			collected.emplace_back(block.encoder.data(), block.encoder.count());
+		}
+	}
+
+	const size_t first = points.size();
+
+	for (const auto &partition : partitions) {
+		try {
+			readPartition(partition.first, partition.second,
+				series, begin, end, points);
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+
+	for (const auto &block : collected)
+		decode(block.first, block.second, begin, end, points);
+
+	stable_sort(points.begin() + first, points.end(),
+		[](const Point &a, const Point &b) {
+			return a.at < b.at;
+		});
+}
+
+void HistorianStore::readPartition(
+		const string &path,
+		UInt64 limit,
+		const string &series,
+		Int64 from,
+		Int64 to,
+		vector<Point> &points) const
+{
+	ifstream file(path, ios::binary);
+	if (!file) {
+		// dropped meanwhile
+		return;
+	}
+
+	UInt64 offset = 0;
+	char header[BLOCK_HEADER_SIZE];
+	string name;
+	string data;
+
+	while (offset + BLOCK_HEADER_SIZE <= limit) {
+		if (!file.read(header, 5))
+			break;
+
+		if (readUInt(header, 4) != BLOCK_MAGIC) {
+			logger().warning("corrupted block at " + to_string(offset)
+				+ " of " + path, __FILE__, __LINE__);
+			break;
+		}
+
+		name.resize(readUInt(header + 4, 1));
+		if (!file.read(&name[0], name.size()))
+			break;
+
+		if (!file.read(header + 5, BLOCK_HEADER_SIZE - 5))
+			break;
+
+		const size_t count = readUInt(header + 5, 4);
+		const Int64 minTime = static_cast<Int64>(readUInt(header + 9, 8));
+		const Int64 maxTime = static_cast<Int64>(readUInt(header + 17, 8));
+		const size_t length = readUInt(header + 25, 4);
+		const UInt32 crc = readUInt(header + 29, 4);
+
+		offset += BLOCK_HEADER_SIZE + name.size() + length;
+		if (offset > limit)
+			break;
+
+		if (name != series || maxTime < from || minTime >= to) {
+			file.seekg(length, ios::cur);
+			continue;
+		}
+
+		data.resize(length);
+		if (length > 0 && !file.read(&data[0], length))
+			break;
+
+		if (crc32(data) != crc) {
+			logger().warning("checksum mismatch of block at "
+				+ to_string(offset - length) + " of " + path,
+				__FILE__, __LINE__);
+			continue;
+		}
+
+		decode(data, count, from, to, points);
+	}
+}
+
+void HistorianStore::decode(
+		const string &data,
+		size_t count,
+		Int64 from,
+		Int64 to,
+		vector<Point> &points)
+{
+	GorillaDecoder decoder(data, count);
+	Int64 time;
+	double value;
+
+	while (decoder.next(time, value)) {
+		if (time >= from && time < to)
+			points.push_back({Timestamp(time * 1000), value});
+	}
+}
+
+UInt64 HistorianStore::diskUsage() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	UInt64 usage = 0;
+	for (const auto &pair : m_partitions)
+		usage += pair.second;
+
+	return usage;
+}
+
+size_t HistorianStore::partitionCount() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_partitions.size();
+}
+
+size_t HistorianStore::pendingPoints() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_pending;
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Types.h>
+
+#include "model/DeviceID.h"
+#include "model/ModuleID.h"
+#include "util/GorillaCodec.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief HistorianStore is an embedded append-only store of time series,
+ * one series per (device, module). Points are collected in memory into
+ * blocks compressed by the GorillaEncoder. A block is sealed (appended
+ * to the file of its partition) when it is full, when a newer partition
+ * starts or on flush().
+ *
+ * Data are partitioned by time, each partition is a single file in the
+ * root directory named by the start of the partition (in milliseconds).
+ * Whole partitions are dropped when they are older than the retention
+ * (relative to the newest point, but never to a point later than the
+ * current time) or when the total size of partitions
+ * exceeds the size limit. The partition being written is never dropped,
+ * thus the size limit should be large enough to hold several partitions.
+ *
+ * Each block in a partition file consists of a header identifying its
+ * series, count of points and their time range followed by the encoded
+ * points protected by CRC-32. Queries skip blocks of other series and
+ * of other time ranges without decoding them. A truncated or corrupted
+ * tail of a partition (e.g. after power loss) is cut off by open(),
+ * thus blocks appended later are readable.
+ */
+class HistorianStore : protected Loggable {
+public:
+	typedef Poco::SharedPtr<HistorianStore> Ptr;
+
+	struct Point {
+		Poco::Timestamp at;
+		double value;
+	};
+
+	HistorianStore();
+	~HistorianStore();
+
+	void setRootDir(const std::string &dir);
+	void setPartitionDuration(const Poco::Timespan &duration);
+	void setRetention(const Poco::Timespan &retention);
+	void setSizeLimit(Poco::UInt64 bytes);
+
+	/**
+	 * @brief Maximal time a point can be ahead of the current time.
+	 * Later points are rejected, e.g. when a device has a broken clock.
+	 */
+	void setMaxFuture(const Poco::Timespan &future);
+
+	/**
+	 * @brief Maximal count of points in a single block.
+	 */
+	void setBlockPoints(unsigned int points);
+
+	/**
+	 * @brief Discover partitions in the root directory. Partitions
+	 * are truncated to their last complete block.
+	 */
+	void open();
+
+	/**
+	 * @brief Append point into the series of the given module.
+	 * Points older than the retention or further than maxFuture
+	 * ahead of the current time are dropped.
+	 */
+	void append(
+		const DeviceID &device,
+		const ModuleID &module,
+		const Poco::Timestamp &at,
+		double value);
+
+	/**
+	 * @brief Seal all blocks that are being collected.
+	 */
+	void flush();
+
+	/**
+	 * @brief Find points of the given module in range [from, to).
+	 * Both sealed and collected points are searched. The points
+	 * are sorted by their time.
+	 */
+	void query(
+		const DeviceID &device,
+		const ModuleID &module,
+		const Poco::Timestamp &from,
+		const Poco::Timestamp &to,
+		std::vector<Point> &points) const;
+
+	/**
+	 * @returns total size of all partition files
+	 */
+	Poco::UInt64 diskUsage() const;
+
+	size_t partitionCount() const;
+
+	/**
+	 * @returns count of points that are not sealed yet
+	 */
+	size_t pendingPoints() const;
+
+protected:
+	struct Block {
+		GorillaEncoder encoder;
+		Poco::Int64 minTime;
+		Poco::Int64 maxTime;
+	};
+
+	/**
+	 * Key of a block being collected: partition and series.
+	 */
+	typedef std::tuple<Poco::Int64, std::string> BlockKey;
+
+	static std::string seriesName(const DeviceID &device, const ModuleID &module);
+
+	Poco::Int64 partitionOf(Poco::Int64 time) const;
+	std::string partitionPath(Poco::Int64 partition) const;
+
+	/**
+	 * @brief Append the given blocks into the file of the partition.
+	 */
+	void seal(Poco::Int64 partition, const std::vector<BlockKey> &keys);
+
+	/**
+	 * @brief Seal blocks of partitions older than the given one.
+	 */
+	void sealBefore(Poco::Int64 partition);
+
+	/**
+	 * @returns time before which the points violate the retention or
+	 * NO_TIME if no point has been appended yet
+	 */
+	Poco::Int64 horizon(Poco::Int64 now) const;
+
+	/**
+	 * @brief Drop partitions violating the retention or the size limit.
+	 */
+	void enforceLimits();
+
+	void dropPartition(Poco::Int64 partition);
+
+	/**
+	 * @returns size of the leading complete blocks of the given
+	 * partition file, the last block must also match its checksum
+	 */
+	Poco::UInt64 validSize(const std::string &path, Poco::UInt64 size) const;
+
+	/**
+	 * @brief Read points of the series from the first limit bytes
+	 * of the given partition file.
+	 */
+	void readPartition(
+		const std::string &path,
+		Poco::UInt64 limit,
+		const std::string &series,
+		Poco::Int64 from,
+		Poco::Int64 to,
+		std::vector<Point> &points) const;
+
+	static void decode(
+		const std::string &data,
+		size_t count,
+		Poco::Int64 from,
+		Poco::Int64 to,
+		std::vector<Point> &points);
+
+private:
+	std::string m_rootDir;
+	Poco::Timespan m_partitionDuration;
+	Poco::Timespan m_retention;
+	Poco::UInt64 m_sizeLimit;
+	Poco::Timespan m_maxFuture;
+	unsigned int m_blockPoints;
+
+	std::map<BlockKey, Block> m_blocks;
+	std::map<Poco::Int64, Poco::UInt64> m_partitions;
+	Poco::Int64 m_newest;
+	Poco::Int64 m_current;
+	size_t m_pending;
+	mutable Poco::FastMutex m_lock;
+};
+
+}
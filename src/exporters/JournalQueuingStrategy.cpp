@@ -16,10 +16,13 @@
 #include "di/Injectable.h"
 #include "exporters/JournalQueuingStrategy.h"
 #include "io/SafeWriter.h"
+#include "util/AllocationTracker.h"
 #include "util/ChecksumSensorDataFormatter.h"
 #include "util/ChecksumSensorDataParser.h"
 #include "util/JSONSensorDataFormatter.h"
 #include "util/JSONSensorDataParser.h"
+#include "util/MetricsRegistry.h"
+#include "util/StartupTracer.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, JournalQueuingStrategy)
 BEEEON_OBJECT_CASTABLE(QueuingStrategy)
@@ -37,6 +40,7 @@ using namespace BeeeOn;
 
 static const RegularExpression BUFFER_REGEX("^[a-fA-F0-9]{40}$");
 static const RegularExpression INDEX_REGEX("^index$");
+static const AllocationTag JOURNAL_TAG("journal");
 static const RegularExpression INDEX_LOCK_REGEX("^index.lock$");
 
 JournalQueuingStrategy::JournalQueuingStrategy():
@@ -180,6 +184,8 @@ void JournalQueuingStrategy::prescanBuffers(Timestamp &newest, BrokenHandler bro
 
 void JournalQueuingStrategy::setup()
 {
+	StartupTracer::Scope trace("JournalQueuingStrategy::setup");
+
 	const auto &newest = initIndexAndScan(
 		[&](const string &name, size_t, Timestamp &)
 		{
@@ -307,12 +313,24 @@ Journal::Ptr JournalQueuingStrategy::index() const
 
 void JournalQueuingStrategy::push(const vector<SensorData> &data)
 {
+	static MetricCounter &pushed = MetricsRegistry::instance().counter(
+		"beeeon_journal_pushed_total",
+		"Sensor data persisted into a journal");
+	static MetricCounter &bytes = MetricsRegistry::instance().counter(
+		"beeeon_journal_written_bytes_total",
+		"Bytes of buffers written into a journal");
+
+	AllocationScope scope(JOURNAL_TAG);
+
 	const string &buffer = FileBuffer::formatEntries(data);
 	if (!garbageCollect(buffer.size()))
 		dropOldestBuffers(buffer.size());
 
 	const auto &name = writeData(buffer);
 	m_index->append(name, "0");
+
+	pushed.inc(data.size());
+	bytes.inc(buffer.size());
 }
 
 size_t JournalQueuingStrategy::readEntries(
@@ -351,6 +369,8 @@ size_t JournalQueuingStrategy::readEntries(
 
 size_t JournalQueuingStrategy::precacheEntries(size_t count)
 {
+	AllocationScope scope(JOURNAL_TAG);
+
 	const auto total = readEntries(
 		[&](const Entry &entry) {
 			m_entryCache.emplace_back(entry);
@@ -417,6 +437,12 @@ static void updateStatus(
 
 void JournalQueuingStrategy::pop(size_t count)
 {
+	static MetricCounter &popped = MetricsRegistry::instance().counter(
+		"beeeon_journal_popped_total",
+		"Sensor data removed from a journal");
+
+	AllocationScope scope(JOURNAL_TAG);
+
 	// status to be updated for each buffer
 	map<string, size_t> status;
 
@@ -468,6 +494,8 @@ void JournalQueuingStrategy::pop(size_t count)
 	k = 0;
 	for (auto it = m_entryCache.begin(); k < cacheCount; ++k)
 		it = m_entryCache.erase(it);
+
+	popped.inc(total);
 }
 
 void JournalQueuingStrategy::collectReferenced(set<string> &referenced) const
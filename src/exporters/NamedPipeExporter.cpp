@@ -9,6 +9,7 @@
 
 #include "di/Injectable.h"
 #include "exporters/NamedPipeExporter.h"
+#include "util/MetricsRegistry.h"
 #include "util/NullSensorDataFormatter.h"
 #include "util/SensorDataFormatter.h"
 
@@ -37,10 +38,16 @@ NamedPipeExporter::~NamedPipeExporter()
 
 bool NamedPipeExporter::ship(const SensorData &data)
 {
+	static MetricCounter &noReader = MetricsRegistry::instance().counter(
+		"beeeon_pipe_exporter_no_reader_total",
+		"Sensor data dropped because there was no reader of the pipe");
+
 	int fd = openPipe();
 
-	if (fd < 0 && errno == ENXIO)
+	if (fd < 0 && errno == ENXIO) {
+		noReader.inc();
 		return true;
+	}
 	if (fd < 0 && errno == EINTR)
 		return false;
 
@@ -132,6 +139,10 @@ int NamedPipeExporter::openPipe()
 
 bool NamedPipeExporter::writeAndClose(int fd, const string &msg)
 {
+	static MetricCounter &written = MetricsRegistry::instance().counter(
+		"beeeon_pipe_exporter_written_bytes_total",
+		"Bytes written into the pipe");
+
 	ssize_t totalLength = msg.size();
 	ssize_t restLength = 0;
 
@@ -152,6 +163,7 @@ bool NamedPipeExporter::writeAndClose(int fd, const string &msg)
 		}
 
 		restLength += writtenLength;
+		written.inc(writtenLength);
 	} while(restLength < totalLength);
 
 	if (logger().debug()) {
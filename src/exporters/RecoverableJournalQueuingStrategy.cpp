@@ -11,6 +11,7 @@
 #include "di/Injectable.h"
 #include "exporters/RecoverableJournalQueuingStrategy.h"
 #include "io/SafeWriter.h"
+#include "util/StartupTracer.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, RecoverableJournalQueuingStrategy)
 BEEEON_OBJECT_CASTABLE(QueuingStrategy)
@@ -55,6 +56,8 @@ void RecoverableJournalQueuingStrategy::setDisableLostRecovery(bool disable)
 
 void RecoverableJournalQueuingStrategy::setup()
 {
+	StartupTracer::Scope trace("RecoverableJournalQueuingStrategy::setup");
+
 	File indexFile = pathTo("index");
 	Timestamp modified;
 
@@ -14,6 +14,7 @@
 #include "di/Injectable.h"
 #include "fitp/FitpDevice.h"
 #include "fitp/FitpDeviceManager.h"
+#include "util/StartupTracer.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, FitpDeviceManager)
 BEEEON_OBJECT_CASTABLE(StoppableRunnable)
@@ -28,6 +29,8 @@ BEEEON_OBJECT_PROPERTY("band", &FitpDeviceManager::setBand)
 BEEEON_OBJECT_PROPERTY("channel", &FitpDeviceManager::setChannel)
 BEEEON_OBJECT_PROPERTY("power", &FitpDeviceManager::setPower)
 BEEEON_OBJECT_PROPERTY("txRetries", &FitpDeviceManager::setTxRetries)
+BEEEON_OBJECT_PROPERTY("receiveBatch", &FitpDeviceManager::setReceiveBatch)
+BEEEON_OBJECT_PROPERTY("maxIdleWait", &FitpDeviceManager::setMaxIdleWait)
 BEEEON_OBJECT_PROPERTY("distributor", &FitpDeviceManager::setDistributor)
 BEEEON_OBJECT_PROPERTY("gatewayInfo", &FitpDeviceManager::setGatewayInfo)
 BEEEON_OBJECT_PROPERTY("commandDispatcher", &FitpDeviceManager::setCommandDispatcher)
@@ -68,7 +71,10 @@ FitpDeviceManager::FitpDeviceManager():
 	m_configFile(FITP_CONFIG_PATH),
 	m_listening(false),
 	m_listenCallback(*this, &FitpDeviceManager::stopListen),
-	m_listenTimer(0, 0)
+	m_listenTimer(0, 0),
+	m_receiver([](vector<uint8_t> &data) {
+		fitp_received_data(data);
+	})
 {
 }
 
@@ -297,8 +303,20 @@ void FitpDeviceManager::setTxRetries(int retries)
 	m_linkParams.tx_max_retries = retries;
 }
 
+void FitpDeviceManager::setReceiveBatch(int size)
+{
+	m_receiver.setBatchSize(size);
+}
+
+void FitpDeviceManager::setMaxIdleWait(const Timespan &wait)
+{
+	m_receiver.setMaxIdleWait(wait);
+}
+
 void FitpDeviceManager::initFitp()
 {
+	StartupTracer::Scope trace("FitpDeviceManager::initFitp");
+
 	logger().information(
 		"configuration file path: "
 		+ m_configFile,
@@ -487,19 +505,24 @@ void FitpDeviceManager::run()
 	StopControl::Run run(m_stopControl);
 
 	while (run) {
-		vector<uint8_t> data;
+		const size_t count = m_receiver.receive();
 
-		fitp_received_data(data);
-		if (!data.empty()) {
-			if (isDataMessage(data)) {
-				processDataMsg(data);
-			}
-			else if (isJoinMessage(data)) {
-				processJoinMsg(data);
-			}
+		if (count == 0) {
+			run.waitStoppable(m_receiver.idleWait());
+			continue;
 		}
+
+		for (size_t i = 0; i < count; ++i)
+			processFrame(m_receiver.frame(i));
 	}
+}
 
+void FitpDeviceManager::processFrame(const vector<uint8_t> &data)
+{
+	if (isDataMessage(data))
+		processDataMsg(data);
+	else if (isJoinMessage(data))
+		processJoinMsg(data);
 }
 
 void FitpDeviceManager::stop()
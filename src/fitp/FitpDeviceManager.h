@@ -10,6 +10,7 @@
 #include "core/DeviceManager.h"
 #include "core/GatewayInfo.h"
 #include "fitp/FitpDevice.h"
+#include "fitp/FitpReceiver.h"
 #include "model/DeviceID.h"
 
 namespace BeeeOn {
@@ -155,6 +156,20 @@ public:
 	 */
 	void setTxRetries(int retries);
 
+	/**
+	 * Sets maximal count of frames taken from fitp at once.
+	 * Condition: size > 0
+	 */
+	void setReceiveBatch(int size);
+
+	/**
+	 * Sets maximal time to wait between polls of fitp when no frame
+	 * is being received. The wait starts at 1 ms and it is doubled
+	 * while the radio is idle. It is also the maximal delay of a frame
+	 * received after a period of idleness.
+	 */
+	void setMaxIdleWait(const Poco::Timespan &wait);
+
 	void setGatewayInfo(Poco::SharedPtr<GatewayInfo> info);
 
 	/**
@@ -223,6 +238,7 @@ protected:
 private:
 	void stopListen(Poco::Timer &timer);
 	int channelCnt();
+	void processFrame(const std::vector<uint8_t> &data);
 
 private:
 	std::map<DeviceID, FitpDevice::Ptr> m_devices;
@@ -234,6 +250,7 @@ private:
 	Poco::Timer m_listenTimer;
 	Poco::FastMutex m_lock;
 	Poco::SharedPtr<GatewayInfo> m_gatewayInfo;
+	FitpReceiver m_receiver;
 };
 
 }
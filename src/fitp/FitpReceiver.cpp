@@ -0,0 +1,81 @@
+#include <Poco/Exception.h>
+
+#include "fitp/FitpReceiver.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const size_t DEFAULT_BATCH_SIZE = 16;
+static const Timespan MIN_IDLE_WAIT = 1 * Timespan::MILLISECONDS;
+static const Timespan DEFAULT_MAX_IDLE_WAIT = 20 * Timespan::MILLISECONDS;
+
+FitpReceiver::FitpReceiver(const Source &source):
+	m_source(source),
+	m_batchSize(DEFAULT_BATCH_SIZE),
+	m_maxIdleWait(DEFAULT_MAX_IDLE_WAIT),
+	m_idleWait(0),
+	m_count(0)
+{
+}
+
+void FitpReceiver::setBatchSize(int size)
+{
+	if (size <= 0)
+		throw InvalidArgumentException("batch size must be positive");
+
+	m_batchSize = size;
+}
+
+void FitpReceiver::setMaxIdleWait(const Timespan &wait)
+{
+	if (wait < MIN_IDLE_WAIT) {
+		throw InvalidArgumentException(
+			"max idle wait must be at least "
+			+ to_string(MIN_IDLE_WAIT.totalMilliseconds()) + " ms");
+	}
+
+	m_maxIdleWait = wait;
+}
+
+size_t FitpReceiver::receive()
+{
+	m_count = 0;
+
+	while (m_count < m_batchSize) {
+		if (m_frames.size() <= m_count)
+			m_frames.emplace_back();
+
+		auto &frame = m_frames[m_count];
+
+		frame.clear();
+		m_source(frame);
+
+		if (frame.empty())
+			break;
+
+		++m_count;
+	}
+
+	if (m_count > 0)
+		m_idleWait = 0;
+	else if (m_idleWait == 0)
+		m_idleWait = MIN_IDLE_WAIT;
+	else if (m_idleWait < m_maxIdleWait)
+		m_idleWait = min(m_maxIdleWait.totalMicroseconds(), 2 * m_idleWait.totalMicroseconds());
+
+	return m_count;
+}
+
+const vector<uint8_t> &FitpReceiver::frame(size_t index) const
+{
+	if (index >= m_count)
+		throw RangeException("no such frame " + to_string(index));
+
+	return m_frames[index];
+}
+
+Timespan FitpReceiver::idleWait() const
+{
+	return m_idleWait;
+}
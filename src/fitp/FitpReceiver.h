@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <Poco/Timespan.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Thin wrapper around the receive side of the fitp library.
+ * The library provides only fitp_received_data() that returns an empty
+ * frame immediately when nothing has been received. FitpReceiver drains
+ * the received frames in batches into buffers that are reused among
+ * calls. When nothing is received, the caller is advised how long to
+ * block (e.g. via StopControl::Run::waitStoppable()) before polling
+ * again. The wait grows exponentially while the radio is idle and
+ * it is reset by any received frame.
+ */
+class FitpReceiver {
+public:
+	typedef std::function<void(std::vector<uint8_t> &data)> Source;
+
+	FitpReceiver(const Source &source);
+
+	/**
+	 * @brief Set maximal count of frames received by a single call
+	 * of receive().
+	 */
+	void setBatchSize(int size);
+
+	/**
+	 * @brief Set upper bound of the wait returned by idleWait().
+	 * It is also the upper bound of the delay of a frame received
+	 * after a period of idleness.
+	 */
+	void setMaxIdleWait(const Poco::Timespan &wait);
+
+	/**
+	 * @brief Receive frames from the source until it reports no
+	 * more data or the batch is full.
+	 * @returns count of frames accessible via frame()
+	 */
+	size_t receive();
+
+	/**
+	 * @returns frame at the given index of the last received batch
+	 */
+	const std::vector<uint8_t> &frame(size_t index) const;
+
+	/**
+	 * @returns time to wait before the next call of receive()
+	 */
+	Poco::Timespan idleWait() const;
+
+private:
+	Source m_source;
+	size_t m_batchSize;
+	Poco::Timespan m_maxIdleWait;
+	Poco::Timespan m_idleWait;
+	std::vector<std::vector<uint8_t>> m_frames;
+	size_t m_count;
+};
+
+}
@@ -11,6 +11,7 @@
 #include "di/Injectable.h"
 #include "hotplug/HotplugEvent.h"
 #include "hotplug/UDevMonitor.h"
+#include "util/StartupTracer.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, UDevMonitor)
 BEEEON_OBJECT_CASTABLE(StoppableRunnable)
@@ -133,6 +134,8 @@ HotplugEvent UDevMonitor::createEvent(struct udev_device *dev) const
 
 void UDevMonitor::initialScan()
 {
+	StartupTracer::Scope trace("UDevMonitor::initialScan");
+
 	logger().information("initial subsystem udev scan", __FILE__, __LINE__);
 
 	struct udev_enumerate *en = ::udev_enumerate_new(m_udev);
@@ -0,0 +1,103 @@
+#include <Poco/Exception.h>
+
+#include "iio/IIOAggregator.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+IIOAggregator::IIOAggregator(Mode mode):
+	m_mode(mode)
+{
+	reset();
+}
+
+void IIOAggregator::add(double value)
+{
+	if (m_count == 0) {
+		m_min = value;
+		m_max = value;
+	}
+	else {
+		if (value < m_min)
+			m_min = value;
+		if (value > m_max)
+			m_max = value;
+	}
+
+	m_last = value;
+	m_sum += value;
+	++m_count;
+}
+
+bool IIOAggregator::empty() const
+{
+	return m_count == 0;
+}
+
+size_t IIOAggregator::count() const
+{
+	return m_count;
+}
+
+double IIOAggregator::last() const
+{
+	return m_last;
+}
+
+double IIOAggregator::mean() const
+{
+	return m_count == 0 ? 0 : m_sum / m_count;
+}
+
+double IIOAggregator::min() const
+{
+	return m_min;
+}
+
+double IIOAggregator::max() const
+{
+	return m_max;
+}
+
+double IIOAggregator::value() const
+{
+	if (m_count == 0)
+		throw IllegalStateException("no samples to aggregate");
+
+	switch (m_mode) {
+	case LAST:
+		return last();
+	case MEAN:
+		return mean();
+	case MIN:
+		return min();
+	case MAX:
+		return max();
+	}
+
+	throw IllegalStateException("unexpected aggregation mode");
+}
+
+void IIOAggregator::reset()
+{
+	m_count = 0;
+	m_last = 0;
+	m_sum = 0;
+	m_min = 0;
+	m_max = 0;
+}
+
+IIOAggregator::Mode IIOAggregator::parseMode(const string &name)
+{
+	if (name == "last")
+		return LAST;
+	if (name == "mean")
+		return MEAN;
+	if (name == "min")
+		return MIN;
+	if (name == "max")
+		return MAX;
+
+	throw InvalidArgumentException("unknown aggregation: " + name);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace BeeeOn {
+
+/**
+ * @brief Aggregation of samples of a single channel collected between
+ * two consecutive shipments. The IIO devices can provide samples at
+ * a much higher rate than is useful to ship, the aggregation reduces
+ * them into a single value.
+ */
+class IIOAggregator {
+public:
+	enum Mode {
+		/**
+		 * No aggregation, the last sample is shipped.
+		 */
+		LAST,
+		MEAN,
+		MIN,
+		MAX,
+	};
+
+	IIOAggregator(Mode mode = MEAN);
+
+	void add(double value);
+
+	bool empty() const;
+	size_t count() const;
+
+	double last() const;
+	double mean() const;
+	double min() const;
+	double max() const;
+
+	/**
+	 * @returns aggregated value according to the mode
+	 * @throws Poco::IllegalStateException when there is no sample
+	 */
+	double value() const;
+
+	void reset();
+
+	/**
+	 * @brief Parse mode from its name: last, mean, min or max.
+	 * @throws Poco::InvalidArgumentException for unknown name
+	 */
+	static Mode parseMode(const std::string &name);
+
+private:
+	Mode m_mode;
+	size_t m_count;
+	double m_last;
+	double m_sum;
+	double m_min;
+	double m_max;
+};
+
+}
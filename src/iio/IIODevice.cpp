@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cctype>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+#include <Poco/NumberParser.h>
+#include <Poco/String.h>
+
+#include "iio/IIODevice.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const string DEVICE_PREFIX = "iio:device";
+static const string SCAN_ELEMENTS = "scan_elements";
+static const string ENABLE_SUFFIX = "_en";
+
+double IIOChannel::value(const uint8_t *sample) const
+{
+	const int64_t raw = scanType.decode(sample + position);
+	return (raw + offset) * scale;
+}
+
+IIODevice::IIODevice(const Path &sysfs, const Path &node):
+	m_sysfs(sysfs),
+	m_node(node),
+	m_sampleSize(0)
+{
+	m_sysfs.makeDirectory();
+}
+
+const Path &IIODevice::sysfs() const
+{
+	return m_sysfs;
+}
+
+const Path &IIODevice::node() const
+{
+	return m_node;
+}
+
+string IIODevice::name() const
+{
+	return m_name;
+}
+
+string IIODevice::label() const
+{
+	return m_label;
+}
+
+const vector<IIOChannel> &IIODevice::channels() const
+{
+	return m_channels;
+}
+
+Path IIODevice::scanElementsDir() const
+{
+	Path path(m_sysfs);
+	path.pushDirectory(SCAN_ELEMENTS);
+	return path;
+}
+
+size_t IIODevice::sampleSize() const
+{
+	return m_sampleSize;
+}
+
+string IIODevice::channelType(const string &name)
+{
+	string type = name;
+
+	if (type.find("in_") == 0)
+		type = type.substr(3);
+	else if (type.find("out_") == 0)
+		type = type.substr(4);
+
+	while (!type.empty() && isdigit(type.back()))
+		type.pop_back();
+
+	return type;
+}
+
+string IIODevice::readAttribute(const Path &path) const
+{
+	FileInputStream input(path.toString());
+	string value;
+
+	getline(input, value);
+	return trim(value);
+}
+
+void IIODevice::writeAttribute(const Path &path, const string &value) const
+{
+	FileOutputStream output(path.toString(), ios::out | ios::trunc);
+	output << value;
+	output.close();
+}
+
+double IIODevice::readNumber(const vector<string> &names, double defaultValue) const
+{
+	for (const auto &name : names) {
+		const Path path(m_sysfs, name);
+
+		if (File(path).exists())
+			return NumberParser::parseFloat(readAttribute(path));
+	}
+
+	return defaultValue;
+}
+
+void IIODevice::loadChannel(const string &name)
+{
+	const Path scanElements = scanElementsDir();
+	const string direction = name.substr(0, name.find('_') + 1);
+
+	IIOChannel channel;
+	channel.name = name;
+	channel.type = channelType(name);
+	channel.index = NumberParser::parseUnsigned(
+		readAttribute(Path(scanElements, name + "_index")));
+	channel.scanType = IIOScanType::parse(
+		readAttribute(Path(scanElements, name + "_type")));
+	channel.enabled = readAttribute(Path(scanElements, name + ENABLE_SUFFIX)) == "1";
+	channel.position = 0;
+
+	// per-channel attributes take precedence over the shared ones
+	channel.scale = readNumber({
+		name + "_scale",
+		direction + channel.type + "_scale"},
+		1.0);
+	channel.offset = readNumber({
+		name + "_offset",
+		direction + channel.type + "_offset"},
+		0.0);
+
+	m_channels.emplace_back(channel);
+}
+
+void IIODevice::load()
+{
+	m_name = readAttribute(Path(m_sysfs, "name"));
+
+	const Path label(m_sysfs, "label");
+	m_label = File(label).exists() ? readAttribute(label) : "";
+
+	m_channels.clear();
+
+	vector<string> names;
+	File(scanElementsDir()).list(names);
+
+	for (const auto &file : names) {
+		if (file.size() <= ENABLE_SUFFIX.size())
+			continue;
+		if (file.compare(file.size() - ENABLE_SUFFIX.size(), ENABLE_SUFFIX.size(), ENABLE_SUFFIX))
+			continue;
+
+		loadChannel(file.substr(0, file.size() - ENABLE_SUFFIX.size()));
+	}
+
+	sort(m_channels.begin(), m_channels.end(),
+		[](const IIOChannel &a, const IIOChannel &b) {
+			return a.index < b.index;
+		});
+
+	computeLayout();
+}
+
+/**
+ * Each value is aligned to its storage size and the sample is padded
+ * to the largest storage size as done by the kernel.
+ */
+void IIODevice::computeLayout()
+{
+	size_t offset = 0;
+	size_t alignment = 1;
+
+	for (auto &channel : m_channels) {
+		if (!channel.enabled)
+			continue;
+
+		const size_t bytes = channel.scanType.storageBytes();
+
+		if (offset % bytes)
+			offset += bytes - offset % bytes;
+
+		channel.position = offset;
+		offset += channel.scanType.length();
+		alignment = max(alignment, bytes);
+	}
+
+	if (offset % alignment)
+		offset += alignment - offset % alignment;
+
+	m_sampleSize = offset;
+}
+
+void IIODevice::enableBuffer(
+		const set<string> &channels,
+		const string &trigger,
+		unsigned int length)
+{
+	if (length == 0)
+		throw InvalidArgumentException("buffer length must be positive");
+
+	// buffer must be disabled while changing its configuration
+	disableBuffer();
+
+	const Path scanElements = scanElementsDir();
+
+	for (auto &channel : m_channels) {
+		channel.enabled = channels.find(channel.name) != channels.end();
+		writeAttribute(Path(scanElements, channel.name + ENABLE_SUFFIX),
+			channel.enabled ? "1" : "0");
+	}
+
+	computeLayout();
+
+	if (m_sampleSize == 0)
+		throw IllegalStateException("no channel enabled for " + m_sysfs.toString());
+
+	if (!trigger.empty())
+		writeAttribute(Path(m_sysfs, Path("trigger/current_trigger")), trigger);
+
+	writeAttribute(Path(m_sysfs, Path("buffer/length")), to_string(length));
+	writeAttribute(Path(m_sysfs, Path("buffer/enable")), "1");
+}
+
+void IIODevice::disableBuffer()
+{
+	writeAttribute(Path(m_sysfs, Path("buffer/enable")), "0");
+}
+
+vector<IIODevice> IIODevice::discover(const Path &sysfsRoot, const Path &devRoot)
+{
+	File root(sysfsRoot);
+	vector<IIODevice> devices;
+
+	if (!root.exists())
+		return devices;
+
+	vector<string> names;
+	root.list(names);
+	sort(names.begin(), names.end());
+
+	for (const auto &name : names) {
+		if (name.find(DEVICE_PREFIX) != 0)
+			continue;
+
+		Path sysfs(sysfsRoot, name);
+		sysfs.makeDirectory();
+
+		if (!File(Path(sysfs, SCAN_ELEMENTS)).exists())
+			continue;
+
+		devices.emplace_back(sysfs, Path(devRoot, name));
+	}
+
+	return devices;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Poco/Path.h>
+
+#include "iio/IIOScanType.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Channel of an IIO device that can be captured via the buffered
+ * interface. The processed value of the channel is computed as
+ * <code>(raw + offset) * scale</code> in units defined by the IIO ABI
+ * for the channel type (e.g. kPa for pressure, m°C for temperature).
+ */
+struct IIOChannel {
+	/**
+	 * Name of the channel as in the sysfs, e.g. <code>in_pressure</code>
+	 * or <code>in_voltage0</code>.
+	 */
+	std::string name;
+
+	/**
+	 * Type of the channel, i.e. name without the direction prefix and
+	 * the channel number, e.g. <code>pressure</code> or <code>voltage</code>.
+	 */
+	std::string type;
+
+	unsigned int index;
+	IIOScanType scanType;
+	double scale;
+	double offset;
+	bool enabled;
+
+	/**
+	 * Position of the channel inside a sample, it is valid only
+	 * for enabled channels.
+	 */
+	size_t position;
+
+	/**
+	 * @returns processed value of the channel from the given sample
+	 */
+	double value(const uint8_t *sample) const;
+};
+
+/**
+ * @brief IIO device described by a directory in sysfs (typically
+ * <code>/sys/bus/iio/devices/iio:deviceN</code>) and its character
+ * device (typically <code>/dev/iio:deviceN</code>) providing samples
+ * of the buffered interface.
+ *
+ * The device is configured by writing into its sysfs attributes:
+ * scan elements are enabled, trigger is selected and the buffer is
+ * enabled. Each sample read from the character device then contains
+ * values of the enabled channels ordered by their index. Each value
+ * is aligned to its storage size.
+ */
+class IIODevice {
+public:
+	IIODevice(const Poco::Path &sysfs, const Poco::Path &node);
+
+	/**
+	 * @brief Read name and label of the device and its scan elements.
+	 */
+	void load();
+
+	const Poco::Path &sysfs() const;
+	const Poco::Path &node() const;
+	std::string name() const;
+
+	/**
+	 * @returns label of the device (e.g. its placement) given by
+	 * firmware or an empty string when the device has no label
+	 */
+	std::string label() const;
+
+	/**
+	 * @returns channels of the device ordered by their index
+	 */
+	const std::vector<IIOChannel> &channels() const;
+
+	/**
+	 * @brief Enable scan elements of the given channels and disable all
+	 * others, select the trigger (if not empty), set the buffer length
+	 * and enable the buffer.
+	 */
+	void enableBuffer(
+		const std::set<std::string> &channels,
+		const std::string &trigger,
+		unsigned int length);
+
+	/**
+	 * @brief Disable buffer of the device.
+	 */
+	void disableBuffer();
+
+	/**
+	 * @returns size of a single sample of the enabled channels
+	 */
+	size_t sampleSize() const;
+
+	/**
+	 * @brief Find IIO devices providing the buffered interface.
+	 * Devices without scan elements are skipped. The returned
+	 * devices must be loaded before use.
+	 */
+	static std::vector<IIODevice> discover(
+		const Poco::Path &sysfsRoot,
+		const Poco::Path &devRoot);
+
+	/**
+	 * @returns type of channel for the given channel name
+	 */
+	static std::string channelType(const std::string &name);
+
+private:
+	Poco::Path scanElementsDir() const;
+	void loadChannel(const std::string &name);
+	double readNumber(const std::vector<std::string> &names, double defaultValue) const;
+	void computeLayout();
+
+	std::string readAttribute(const Poco::Path &path) const;
+	void writeAttribute(const Poco::Path &path, const std::string &value) const;
+
+private:
+	Poco::Path m_sysfs;
+	Poco::Path m_node;
+	std::string m_name;
+	std::string m_label;
+	std::vector<IIOChannel> m_channels;
+	size_t m_sampleSize;
+};
+
+}
@@ -0,0 +1,99 @@
+#include <Poco/Exception.h>
+#include <Poco/NumberParser.h>
+#include <Poco/RegularExpression.h>
+#include <Poco/String.h>
+
+#include "iio/IIOScanType.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+size_t IIOScanType::storageBytes() const
+{
+	return storageBits / 8;
+}
+
+size_t IIOScanType::length() const
+{
+	return storageBytes() * repeat;
+}
+
+int64_t IIOScanType::decode(const uint8_t *data) const
+{
+	const size_t bytes = storageBytes();
+	uint64_t raw = 0;
+
+	if (bigEndian) {
+		for (size_t i = 0; i < bytes; ++i)
+			raw = (raw << 8) | data[i];
+	}
+	else {
+		for (size_t i = 0; i < bytes; ++i)
+			raw |= static_cast<uint64_t>(data[i]) << (8 * i);
+	}
+
+	raw >>= shift;
+
+	if (bits < 64) {
+		const uint64_t mask = (static_cast<uint64_t>(1) << bits) - 1;
+		raw &= mask;
+
+		if (isSigned && (raw & (static_cast<uint64_t>(1) << (bits - 1))))
+			raw |= ~mask;
+	}
+
+	return static_cast<int64_t>(raw);
+}
+
+string IIOScanType::toString() const
+{
+	string result = bigEndian ? "be:" : "le:";
+	result += isSigned ? "s" : "u";
+	result += to_string(bits) + "/" + to_string(storageBits);
+
+	if (repeat > 1)
+		result += "X" + to_string(repeat);
+
+	return result + ">>" + to_string(shift);
+}
+
+IIOScanType IIOScanType::parse(const string &input)
+{
+	const RegularExpression pattern("^(le|be):([su])([0-9]+)/([0-9]+)(X([0-9]+))?>>([0-9]+)$");
+	const string descriptor = trim(input);
+	RegularExpression::MatchVec m;
+
+	if (!pattern.match(descriptor, 0, m))
+		throw SyntaxException("invalid scan type: " + descriptor);
+
+	const auto group = [&](size_t i) {
+		return descriptor.substr(m[i].offset, m[i].length);
+	};
+
+	IIOScanType type;
+	type.bigEndian = group(1) == "be";
+	type.isSigned = group(2) == "s";
+	type.bits = NumberParser::parseUnsigned(group(3));
+	type.storageBits = NumberParser::parseUnsigned(group(4));
+	type.repeat = m[6].offset == string::npos ? 1 : NumberParser::parseUnsigned(group(6));
+	type.shift = NumberParser::parseUnsigned(group(7));
+
+	switch (type.storageBits) {
+	case 8:
+	case 16:
+	case 32:
+	case 64:
+		break;
+	default:
+		throw SyntaxException("unsupported storage bits: " + descriptor);
+	}
+
+	if (type.bits == 0 || type.bits + type.shift > type.storageBits)
+		throw SyntaxException("bits do not fit into storage: " + descriptor);
+
+	if (type.repeat == 0)
+		throw SyntaxException("invalid repeat: " + descriptor);
+
+	return type;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace BeeeOn {
+
+/**
+ * @brief Type descriptor of an IIO scan element as found in files
+ * <code>scan_elements/in_*_type</code>. The descriptor has format
+ * <code>[be|le]:[s|u]bits/storagebits[Xrepeat]>>shift</code>, e.g.
+ * <code>le:s12/16>>4</code>. It describes how a channel value is stored
+ * inside a sample read from the buffer <code>/dev/iio:deviceN</code>.
+ */
+struct IIOScanType {
+	bool bigEndian;
+	bool isSigned;
+	unsigned int bits;
+	unsigned int storageBits;
+	unsigned int shift;
+	unsigned int repeat;
+
+	/**
+	 * @returns size of a single stored value in bytes, the stored
+	 * value is aligned to its size inside a sample
+	 */
+	size_t storageBytes() const;
+
+	/**
+	 * @returns count of bytes occupied by the channel inside a sample
+	 */
+	size_t length() const;
+
+	/**
+	 * @brief Decode the (first) raw value stored at the given position.
+	 * The value is converted from the declared endianness, shifted,
+	 * masked and sign extended when necessary.
+	 */
+	int64_t decode(const uint8_t *data) const;
+
+	std::string toString() const;
+
+	/**
+	 * @throws Poco::SyntaxException for an invalid descriptor
+	 */
+	static IIOScanType parse(const std::string &input);
+};
+
+}
@@ -0,0 +1,555 @@
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <Poco/Exception.h>
+#include <Poco/Hash.h>
+#include <Poco/Timestamp.h>
+
+#include "commands/NewDeviceCommand.h"
+#include "core/CommandDispatcher.h"
+#include "di/Injectable.h"
+#include "iio/IIOSensorManager.h"
+#include "model/SensorData.h"
+#include "model/SensorValue.h"
+#include "util/BlockingAsyncWork.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, IIOSensorManager)
+BEEEON_OBJECT_CASTABLE(CommandHandler)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_CASTABLE(DeviceStatusHandler)
+BEEEON_OBJECT_PROPERTY("deviceCache", &IIOSensorManager::setDeviceCache)
+BEEEON_OBJECT_PROPERTY("distributor", &IIOSensorManager::setDistributor)
+BEEEON_OBJECT_PROPERTY("commandDispatcher", &IIOSensorManager::setCommandDispatcher)
+BEEEON_OBJECT_PROPERTY("sysfsRoot", &IIOSensorManager::setSysfsRoot)
+BEEEON_OBJECT_PROPERTY("devRoot", &IIOSensorManager::setDevRoot)
+BEEEON_OBJECT_PROPERTY("refresh", &IIOSensorManager::setRefresh)
+BEEEON_OBJECT_PROPERTY("trigger", &IIOSensorManager::setTrigger)
+BEEEON_OBJECT_PROPERTY("bufferLength", &IIOSensorManager::setBufferLength)
+BEEEON_OBJECT_PROPERTY("aggregation", &IIOSensorManager::setAggregation)
+BEEEON_OBJECT_PROPERTY("vendor", &IIOSensorManager::setVendor)
+BEEEON_OBJECT_END(BeeeOn, IIOSensorManager)
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+#define PRODUCT "IIO Sensor"
+
+static const Timespan MAX_POLL_TIMEOUT = 500 * Timespan::MILLISECONDS;
+
+/**
+ * Identifiers of IIO devices carry the tag in the highest byte of
+ * their ident part to distinguish them from the device of the
+ * PressureSensorManager sharing the same prefix.
+ */
+static const uint64_t ID_TAG = 0x49ULL << 48; // 'I'
+static const uint64_t ID_TAG_MASK = 0xffULL << 48;
+static const uint64_t ID_HASH_MASK = (1ULL << 48) - 1;
+
+/**
+ * Supported channel types and factors converting their processed
+ * values from the IIO units into the BeeeOn units.
+ */
+struct ChannelMapping {
+	const char *type;
+	ModuleType::Type moduleType;
+	double factor;
+};
+
+static const ChannelMapping MAPPINGS[] = {
+	{"pressure", ModuleType::Type::TYPE_PRESSURE, 10.0},           // kPa -> hPa
+	{"temp", ModuleType::Type::TYPE_TEMPERATURE, 0.001},           // m°C -> °C
+	{"humidityrelative", ModuleType::Type::TYPE_HUMIDITY, 0.001},  // m% -> %
+	{"illuminance", ModuleType::Type::TYPE_LUMINANCE, 1.0},        // lux
+};
+
+IIOSensorManager::IIOSensorManager():
+	DeviceManager(DevicePrefix::PREFIX_PRESSURE_SENSOR, {
+		typeid(GatewayListenCommand),
+		typeid(DeviceAcceptCommand),
+		typeid(DeviceUnpairCommand),
+	}),
+	m_sysfsRoot("/sys/bus/iio/devices/"),
+	m_devRoot("/dev/"),
+	m_refresh(30 * Timespan::SECONDS),
+	m_bufferLength(64),
+	m_aggregation(IIOAggregator::MEAN),
+	m_vendor("BeeeOn"),
+	m_rescan(true)
+{
+}
+
+IIOSensorManager::~IIOSensorManager()
+{
+}
+
+void IIOSensorManager::setSysfsRoot(const string &path)
+{
+	m_sysfsRoot = Path(path).makeDirectory();
+}
+
+void IIOSensorManager::setDevRoot(const string &path)
+{
+	m_devRoot = Path(path).makeDirectory();
+}
+
+void IIOSensorManager::setRefresh(const Timespan &refresh)
+{
+	if (refresh <= 0)
+		throw InvalidArgumentException("refresh time must be positive");
+
+	m_refresh = refresh;
+}
+
+void IIOSensorManager::setTrigger(const string &trigger)
+{
+	m_trigger = trigger;
+}
+
+void IIOSensorManager::setBufferLength(int length)
+{
+	if (length <= 0)
+		throw InvalidArgumentException("buffer length must be positive");
+
+	m_bufferLength = length;
+}
+
+void IIOSensorManager::setAggregation(const string &aggregation)
+{
+	m_aggregation = IIOAggregator::parseMode(aggregation);
+}
+
+void IIOSensorManager::setVendor(const string &vendor)
+{
+	m_vendor = vendor;
+}
+
+void IIOSensorManager::run()
+{
+	poco_information(logger(), "IIO sensor manager started");
+
+	StopControl::Run run(m_stopControl);
+	Timestamp lastShip;
+
+	while (run) {
+		if (m_rescan.exchange(false))
+			rescan();
+
+		if (!syncBuffers()) {
+			run.waitStoppable(-1);
+			lastShip.update();
+			continue;
+		}
+
+		const Timespan remaining = m_refresh - lastShip.elapsed();
+		if (remaining <= 0) {
+			shipAggregated();
+			lastShip.update();
+			continue;
+		}
+
+		pollSamples(remaining < MAX_POLL_TIMEOUT ? remaining : MAX_POLL_TIMEOUT);
+	}
+
+	closeBuffers();
+
+	poco_information(logger(), "IIO sensor manager finished");
+}
+
+void IIOSensorManager::stop()
+{
+	DeviceManager::stop();
+}
+
+void IIOSensorManager::handleRemoteStatus(
+		const DevicePrefix &prefix,
+		const set<DeviceID> &devices,
+		const DeviceStatusHandler::DeviceValues &values)
+{
+	DeviceManager::handleRemoteStatus(prefix, devices, values);
+	m_stopControl.requestWakeup();
+}
+
+AsyncWork<>::Ptr IIOSensorManager::startDiscovery(const Timespan &)
+{
+	const auto sensors = discover();
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		m_discovered.clear();
+		for (const auto &pair : sensors)
+			m_discovered.emplace(pair.first);
+	}
+
+	for (const auto &pair : sensors) {
+		if (deviceCache()->paired(pair.first))
+			continue;
+
+		list<ModuleType> types;
+		for (const auto &module : pair.second.modules)
+			types.emplace_back(module.type);
+
+		dispatch(new NewDeviceCommand(
+			pair.first,
+			m_vendor,
+			PRODUCT + string(" ") + pair.second.device->name(),
+			types,
+			m_refresh));
+	}
+
+	m_rescan = true;
+	m_stopControl.requestWakeup();
+
+	return BlockingAsyncWork<>::instance();
+}
+
+bool IIOSensorManager::accept(const Command::Ptr cmd)
+{
+	if (!DeviceManager::accept(cmd))
+		return false;
+
+	if (cmd->is<DeviceAcceptCommand>()) {
+		const DeviceID &id = cmd.cast<DeviceAcceptCommand>()->deviceID();
+
+		FastMutex::ScopedLock guard(m_lock);
+		return m_discovered.find(id) != m_discovered.end();
+	}
+
+	if (cmd->is<DeviceUnpairCommand>())
+		return isTagged(cmd.cast<DeviceUnpairCommand>()->deviceID());
+
+	return true;
+}
+
+void IIOSensorManager::handleAccept(const DeviceAcceptCommand::Ptr cmd)
+{
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		if (m_discovered.find(cmd->deviceID()) == m_discovered.end())
+			throw NotFoundException("accept: " + cmd->deviceID().toString());
+	}
+
+	if (deviceCache()->paired(cmd->deviceID())) {
+		poco_warning(logger(), "ignoring accept of already paired device");
+		return;
+	}
+
+	deviceCache()->markPaired(cmd->deviceID());
+	m_stopControl.requestWakeup();
+
+	DeviceManager::handleAccept(cmd);
+}
+
+AsyncWork<set<DeviceID>>::Ptr IIOSensorManager::startUnpair(
+		const DeviceID &id,
+		const Timespan &)
+{
+	auto work = BlockingAsyncWork<set<DeviceID>>::instance();
+
+	if (deviceCache()->paired(id)) {
+		deviceCache()->markUnpaired(id);
+		work->setResult({id});
+		m_stopControl.requestWakeup();
+	}
+	else {
+		poco_warning(logger(), "ignoring unpair of not paired device "
+			+ id.toString());
+	}
+
+	return work;
+}
+
+map<DeviceID, IIOSensorManager::Sensor> IIOSensorManager::discover()
+{
+	map<DeviceID, Sensor> sensors;
+
+	for (const auto &device : IIODevice::discover(m_sysfsRoot, m_devRoot)) {
+		SharedPtr<IIODevice> loaded = new IIODevice(device);
+
+		try {
+			loaded->load();
+		}
+		catch (const Exception &e) {
+			logger().warning("skipping IIO device "
+				+ device.sysfs().toString() + ": " + e.displayText(),
+				__FILE__, __LINE__);
+			continue;
+		}
+
+		Sensor sensor = {loaded, {}, -1, false};
+		const auto &channels = loaded->channels();
+
+		for (size_t i = 0; i < channels.size(); ++i) {
+			for (const auto &mapping : MAPPINGS) {
+				if (channels[i].type != mapping.type)
+					continue;
+
+				sensor.modules.push_back({
+					i,
+					ModuleType(mapping.moduleType),
+					mapping.factor,
+					IIOAggregator(m_aggregation)});
+				break;
+			}
+		}
+
+		if (sensor.modules.empty()) {
+			if (logger().debug()) {
+				logger().debug("no supported channel of "
+					+ loaded->name() + " at " + loaded->sysfs().toString(),
+					__FILE__, __LINE__);
+			}
+
+			continue;
+		}
+
+		unsigned int instance = 0;
+		DeviceID id = buildID(*loaded, instance);
+
+		while (sensors.find(id) != sensors.end())
+			id = buildID(*loaded, ++instance);
+
+		sensors.emplace(id, sensor);
+	}
+
+	return sensors;
+}
+
+void IIOSensorManager::rescan()
+{
+	closeBuffers();
+	m_sensors = discover();
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	m_discovered.clear();
+	for (const auto &pair : m_sensors) {
+		m_discovered.emplace(pair.first);
+
+		logger().information("found IIO device " + pair.second.device->name()
+			+ " at " + pair.second.device->sysfs().toString()
+			+ " as " + pair.first.toString(),
+			__FILE__, __LINE__);
+	}
+}
+
+bool IIOSensorManager::syncBuffers()
+{
+	size_t open = 0;
+
+	for (auto &pair : m_sensors) {
+		auto &sensor = pair.second;
+		const bool paired = deviceCache()->paired(pair.first);
+
+		if (paired && sensor.fd < 0 && !sensor.failed)
+			openBuffer(pair.first, sensor);
+		else if (!paired && sensor.fd >= 0)
+			closeBuffer(pair.first, sensor);
+
+		if (sensor.fd >= 0)
+			++open;
+	}
+
+	return open > 0;
+}
+
+void IIOSensorManager::openBuffer(const DeviceID &id, Sensor &sensor)
+{
+	set<string> channels;
+	for (const auto &module : sensor.modules)
+		channels.emplace(sensor.device->channels()[module.channel].name);
+
+	try {
+		sensor.device->enableBuffer(channels, m_trigger, m_bufferLength);
+	}
+	catch (const Exception &e) {
+		logger().error("failed to enable buffer of " + id.toString()
+			+ ": " + e.displayText(),
+			__FILE__, __LINE__);
+
+		sensor.failed = true;
+		return;
+	}
+
+	const string node = sensor.device->node().toString();
+
+	sensor.fd = ::open(node.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (sensor.fd < 0) {
+		logger().error("failed to open " + node + ": " + ::strerror(errno),
+			__FILE__, __LINE__);
+
+		sensor.failed = true;
+		sensor.device->disableBuffer();
+		return;
+	}
+
+	const size_t size = sensor.device->sampleSize() * m_bufferLength;
+	if (m_buffer.size() < size)
+		m_buffer.resize(size);
+
+	for (auto &module : sensor.modules)
+		module.aggregator.reset();
+
+	logger().information("reading " + to_string(channels.size())
+		+ " channels of " + id.toString()
+		+ " from " + node
+		+ ", sample size: " + to_string(sensor.device->sampleSize()),
+		__FILE__, __LINE__);
+}
+
+void IIOSensorManager::closeBuffer(const DeviceID &id, Sensor &sensor)
+{
+	if (sensor.fd < 0)
+		return;
+
+	::close(sensor.fd);
+	sensor.fd = -1;
+
+	try {
+		sensor.device->disableBuffer();
+	}
+	catch (const Exception &e) {
+		logger().log(e, __FILE__, __LINE__);
+	}
+
+	if (logger().debug()) {
+		logger().debug("closed buffer of " + id.toString(),
+			__FILE__, __LINE__);
+	}
+}
+
+void IIOSensorManager::closeBuffers()
+{
+	for (auto &pair : m_sensors)
+		closeBuffer(pair.first, pair.second);
+}
+
+void IIOSensorManager::pollSamples(const Timespan &timeout)
+{
+	vector<struct pollfd> fds;
+	vector<pair<const DeviceID, Sensor> *> sensors;
+
+	for (auto &pair : m_sensors) {
+		if (pair.second.fd < 0)
+			continue;
+
+		fds.push_back({pair.second.fd, POLLIN, 0});
+		sensors.push_back(&pair);
+	}
+
+	const int ret = ::poll(fds.data(), fds.size(), timeout.totalMilliseconds());
+	if (ret < 0) {
+		if (errno == EINTR)
+			return;
+
+		throw IOException("poll of IIO buffers failed: " + string(::strerror(errno)));
+	}
+
+	for (size_t i = 0; i < fds.size() && ret > 0; ++i) {
+		auto &pair = *sensors[i];
+
+		if (fds[i].revents & POLLIN) {
+			readSamples(pair.first, pair.second);
+		}
+		else if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+			logger().warning("buffer of " + pair.first.toString() + " has failed",
+				__FILE__, __LINE__);
+
+			closeBuffer(pair.first, pair.second);
+			pair.second.failed = true;
+		}
+	}
+}
+
+void IIOSensorManager::readSamples(const DeviceID &id, Sensor &sensor)
+{
+	const size_t sampleSize = sensor.device->sampleSize();
+	const ssize_t ret = ::read(sensor.fd, m_buffer.data(),
+		sampleSize * m_bufferLength);
+
+	if (ret < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return;
+
+		logger().error("failed to read samples of " + id.toString()
+			+ ": " + ::strerror(errno),
+			__FILE__, __LINE__);
+
+		closeBuffer(id, sensor);
+		sensor.failed = true;
+		return;
+	}
+
+	if (ret == 0) {
+		logger().warning("unexpected end of buffer of " + id.toString(),
+			__FILE__, __LINE__);
+
+		closeBuffer(id, sensor);
+		sensor.failed = true;
+		return;
+	}
+
+	const auto &channels = sensor.device->channels();
+	const size_t count = ret / sampleSize;
+
+	for (size_t i = 0; i < count; ++i) {
+		const uint8_t *sample = m_buffer.data() + i * sampleSize;
+
+		for (auto &module : sensor.modules) {
+			const double value = channels[module.channel].value(sample);
+			module.aggregator.add(value * module.factor);
+		}
+	}
+
+	if (logger().trace()) {
+		logger().trace("read " + to_string(count) + " samples of " + id.toString(),
+			__FILE__, __LINE__);
+	}
+}
+
+void IIOSensorManager::shipAggregated()
+{
+	for (auto &pair : m_sensors) {
+		auto &sensor = pair.second;
+
+		if (sensor.fd < 0)
+			continue;
+
+		SensorData data;
+		data.setDeviceID(pair.first);
+
+		for (size_t i = 0; i < sensor.modules.size(); ++i) {
+			auto &aggregator = sensor.modules[i].aggregator;
+
+			if (aggregator.empty())
+				continue;
+
+			data.insertValue(SensorValue(ModuleID(i), aggregator.value()));
+			aggregator.reset();
+		}
+
+		if (!data.isEmpty())
+			ship(data);
+	}
+}
+
+DeviceID IIOSensorManager::buildID(const IIODevice &device, unsigned int instance) const
+{
+	string key = device.name() + ":" + device.label();
+	if (instance > 0)
+		key += ":" + to_string(instance);
+
+	const uint64_t h = Poco::hash(key);
+	return DeviceID(DevicePrefix::PREFIX_PRESSURE_SENSOR, ID_TAG | (h & ID_HASH_MASK));
+}
+
+bool IIOSensorManager::isTagged(const DeviceID &id)
+{
+	return (id.ident() & ID_TAG_MASK) == ID_TAG;
+}
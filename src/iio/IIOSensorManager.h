@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Poco/Mutex.h>
+#include <Poco/Path.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+
+#include "commands/DeviceAcceptCommand.h"
+#include "commands/DeviceUnpairCommand.h"
+#include "commands/GatewayListenCommand.h"
+#include "core/DeviceManager.h"
+#include "iio/IIOAggregator.h"
+#include "iio/IIODevice.h"
+#include "model/DeviceID.h"
+#include "model/ModuleType.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Manager of sensors available via the Linux IIO subsystem.
+ * The IIO devices are discovered in sysfs (/sys/bus/iio/devices).
+ * Each device with supported channels (pressure, temperature, relative
+ * humidity and illuminance) is represented as a single BeeeOn device
+ * with a module per channel.
+ *
+ * Paired devices are read via the IIO buffered interface. The scan
+ * elements of the supported channels are enabled, the configured
+ * trigger is selected and samples are read from the character device
+ * (/dev/iio:deviceN) whenever they are available. The samples are
+ * decoded according to the scan element types and aggregated until
+ * the next refresh when the aggregated values are shipped.
+ *
+ * The IIO devices are configured via sysfs and thus the manager
+ * requires write access to the related sysfs attributes.
+ *
+ * The devices share the prefix with the PressureSensorManager. Their
+ * identifiers are tagged and built from the device name and label,
+ * so they do not depend on the order of probing. Commands targeting
+ * a single device are accepted only for the tagged devices.
+ */
+class IIOSensorManager : public DeviceManager {
+public:
+	IIOSensorManager();
+	~IIOSensorManager();
+
+	void run() override;
+	void stop() override;
+
+	/**
+	 * @brief Directory with IIO devices, /sys/bus/iio/devices by default.
+	 */
+	void setSysfsRoot(const std::string &path);
+
+	/**
+	 * @brief Directory with character devices of IIO devices,
+	 * /dev by default.
+	 */
+	void setDevRoot(const std::string &path);
+
+	/**
+	 * @brief Period of shipping aggregated values.
+	 */
+	void setRefresh(const Poco::Timespan &refresh);
+
+	/**
+	 * @brief Name of trigger to be selected for each device. If empty,
+	 * the current trigger of devices is kept.
+	 */
+	void setTrigger(const std::string &trigger);
+
+	/**
+	 * @brief Length of the kernel buffer in samples. It is also the
+	 * maximal count of samples read at once.
+	 */
+	void setBufferLength(int length);
+
+	/**
+	 * @brief Aggregation of samples between shipments:
+	 * last (no aggregation), mean, min or max.
+	 */
+	void setAggregation(const std::string &aggregation);
+
+	void setVendor(const std::string &vendor);
+
+	/**
+	 * @brief Accept device commands only for devices of this manager
+	 * as the prefix is shared with the PressureSensorManager.
+	 */
+	bool accept(const Command::Ptr cmd) override;
+
+	/**
+	 * @brief Wake-up the main thread when received new status.
+	 */
+	void handleRemoteStatus(
+		const DevicePrefix &prefix,
+		const std::set<DeviceID> &devices,
+		const DeviceStatusHandler::DeviceValues &values) override;
+
+protected:
+	void handleAccept(const DeviceAcceptCommand::Ptr cmd) override;
+	AsyncWork<>::Ptr startDiscovery(const Poco::Timespan &timeout) override;
+	AsyncWork<std::set<DeviceID>>::Ptr startUnpair(
+			const DeviceID &id,
+			const Poco::Timespan &timeout) override;
+
+private:
+	/**
+	 * @brief Module of a device mapped to a channel of the IIO device.
+	 */
+	struct Module {
+		size_t channel;
+		ModuleType type;
+		double factor;
+		IIOAggregator aggregator;
+	};
+
+	struct Sensor {
+		Poco::SharedPtr<IIODevice> device;
+		std::vector<Module> modules;
+		int fd;
+		bool failed;
+	};
+
+	/**
+	 * @brief Discover IIO devices and build sensors from devices
+	 * with at least one supported channel.
+	 */
+	std::map<DeviceID, Sensor> discover();
+
+	/**
+	 * @brief Replace the current sensors by newly discovered ones.
+	 */
+	void rescan();
+
+	/**
+	 * @brief Open buffers of paired sensors and close buffers of
+	 * unpaired ones.
+	 * @returns true if there is at least one open buffer
+	 */
+	bool syncBuffers();
+
+	void openBuffer(const DeviceID &id, Sensor &sensor);
+	void closeBuffer(const DeviceID &id, Sensor &sensor);
+	void closeBuffers();
+
+	/**
+	 * @brief Wait up to the given timeout for samples of any open
+	 * buffer and process them.
+	 */
+	void pollSamples(const Poco::Timespan &timeout);
+	void readSamples(const DeviceID &id, Sensor &sensor);
+	void shipAggregated();
+
+	/**
+	 * @brief Build a tagged ID from the device name and label. The
+	 * instance distinguishes devices with the same name and label.
+	 */
+	DeviceID buildID(const IIODevice &device, unsigned int instance) const;
+	static bool isTagged(const DeviceID &id);
+
+private:
+	Poco::Path m_sysfsRoot;
+	Poco::Path m_devRoot;
+	Poco::Timespan m_refresh;
+	std::string m_trigger;
+	unsigned int m_bufferLength;
+	IIOAggregator::Mode m_aggregation;
+	std::string m_vendor;
+
+	std::map<DeviceID, Sensor> m_sensors;
+	std::vector<uint8_t> m_buffer;
+	std::atomic<bool> m_rescan;
+
+	Poco::FastMutex m_lock;
+	std::set<DeviceID> m_discovered;
+};
+
+}
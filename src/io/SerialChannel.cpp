@@ -0,0 +1,318 @@
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <Poco/Clock.h>
+#include <Poco/Logger.h>
+#include <Poco/Message.h>
+
+#include "io/SerialChannel.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+SerialChannel::Settings::Settings(
+		unsigned int baudRate_,
+		unsigned int dataBits_,
+		Parity parity_,
+		unsigned int stopBits_):
+	baudRate(baudRate_),
+	dataBits(dataBits_),
+	parity(parity_),
+	stopBits(stopBits_)
+{
+}
+
+string SerialChannel::Settings::toString() const
+{
+	string parityName = "N";
+	if (parity == PARITY_EVEN)
+		parityName = "E";
+	else if (parity == PARITY_ODD)
+		parityName = "O";
+
+	return to_string(baudRate) + " "
+		+ to_string(dataBits) + parityName + to_string(stopBits);
+}
+
+SerialChannel::SerialChannel(
+		int fd,
+		const string &name,
+		SerialFraming::Ptr framing,
+		FrameHandler onFrame,
+		ErrorHandler onError):
+	m_fd(fd),
+	m_name(name),
+	m_framing(framing),
+	m_onFrame(onFrame),
+	m_onError(onError),
+	m_open(true),
+	m_receivedBytes(0),
+	m_receivedFrames(0)
+{
+	const int flags = ::fcntl(m_fd, F_GETFL);
+	if (flags < 0 || ::fcntl(m_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		const int e = errno;
+		::close(m_fd);
+
+		throw IOException("failed to make " + name + " non-blocking: "
+			+ string(::strerror(e)));
+	}
+}
+
+SerialChannel::~SerialChannel()
+{
+	if (::close(m_fd) < 0) {
+		logger().warning("failed to close " + m_name + ": "
+			+ string(::strerror(errno)),
+			__FILE__, __LINE__);
+	}
+}
+
+int SerialChannel::fd() const
+{
+	return m_fd;
+}
+
+const string &SerialChannel::name() const
+{
+	return m_name;
+}
+
+bool SerialChannel::isOpen() const
+{
+	return m_open;
+}
+
+void SerialChannel::write(const string &data, const Timespan &timeout)
+{
+	FastMutex::ScopedLock guard(m_writeLock);
+
+	if (!m_open)
+		throw IllegalStateException("channel " + m_name + " is closed");
+
+	if (logger().trace()) {
+		logger().dump(
+			"writing to " + m_name + " " + to_string(data.size()) + " B",
+			data.data(),
+			data.size(),
+			Message::PRIO_TRACE);
+	}
+
+	const Clock started;
+	size_t total = 0;
+
+	while (total < data.size()) {
+		const ssize_t ret = ::write(m_fd, data.data() + total, data.size() - total);
+
+		if (ret >= 0) {
+			total += ret;
+			continue;
+		}
+
+		if (errno == EINTR)
+			continue;
+
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw IOException("failed to write to " + m_name + ": "
+				+ string(::strerror(errno)));
+		}
+
+		const Timespan remaining = timeout - started.elapsed();
+		if (timeout >= 0 && remaining <= 0)
+			throw TimeoutException("writing to " + m_name + " has timed out");
+
+		struct pollfd pfd = {m_fd, POLLOUT, 0};
+		const int ms = timeout < 0 ? -1 : remaining.totalMilliseconds() + 1;
+
+		if (::poll(&pfd, 1, ms) < 0 && errno != EINTR) {
+			throw IOException("failed to poll " + m_name + ": "
+				+ string(::strerror(errno)));
+		}
+	}
+}
+
+void SerialChannel::receive(char *buffer, size_t size)
+{
+	while (true) {
+		const ssize_t ret = ::read(m_fd, buffer, size);
+
+		if (ret > 0) {
+			m_pending.append(buffer, ret);
+			m_receivedBytes += ret;
+
+			if (logger().trace()) {
+				logger().dump(
+					"reading from " + m_name + " " + to_string(ret) + " B",
+					buffer,
+					ret,
+					Message::PRIO_TRACE);
+			}
+
+			deliver();
+
+			if (static_cast<size_t>(ret) < size)
+				return;
+
+			continue;
+		}
+
+		if (ret == 0)
+			throw IOException("end of file reached on " + m_name);
+
+		if (errno == EINTR)
+			continue;
+
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return;
+
+		throw IOException("failed to read from " + m_name + ": "
+			+ string(::strerror(errno)));
+	}
+}
+
+void SerialChannel::deliver()
+{
+	while (m_open && m_framing->extract(m_pending, m_frame)) {
+		++m_receivedFrames;
+
+		try {
+			m_onFrame(m_frame);
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+}
+
+void SerialChannel::fail(const Exception &e)
+{
+	if (!m_open.exchange(false))
+		return;
+
+	if (!m_onError)
+		return;
+
+	try {
+		m_onError(e);
+	}
+	BEEEON_CATCH_CHAIN(logger())
+}
+
+void SerialChannel::close()
+{
+	m_open = false;
+}
+
+UInt64 SerialChannel::receivedBytes() const
+{
+	return m_receivedBytes;
+}
+
+UInt64 SerialChannel::receivedFrames() const
+{
+	return m_receivedFrames;
+}
+
+static speed_t toSpeed(unsigned int baudRate)
+{
+	switch (baudRate) {
+	case 1200:
+		return B1200;
+	case 2400:
+		return B2400;
+	case 4800:
+		return B4800;
+	case 9600:
+		return B9600;
+	case 19200:
+		return B19200;
+	case 38400:
+		return B38400;
+	case 57600:
+		return B57600;
+	case 115200:
+		return B115200;
+	case 230400:
+		return B230400;
+	default:
+		throw InvalidArgumentException(
+			"unsupported baud rate: " + to_string(baudRate));
+	}
+}
+
+static tcflag_t toCharacterSize(unsigned int dataBits)
+{
+	switch (dataBits) {
+	case 5:
+		return CS5;
+	case 6:
+		return CS6;
+	case 7:
+		return CS7;
+	case 8:
+		return CS8;
+	default:
+		throw InvalidArgumentException(
+			"unsupported data bits: " + to_string(dataBits));
+	}
+}
+
+int SerialChannel::openPort(const string &dev, const Settings &settings)
+{
+	if (settings.stopBits != 1 && settings.stopBits != 2) {
+		throw InvalidArgumentException(
+			"unsupported stop bits: " + to_string(settings.stopBits));
+	}
+
+	const speed_t speed = toSpeed(settings.baudRate);
+	const tcflag_t size = toCharacterSize(settings.dataBits);
+
+	const int fd = ::open(dev.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		throw IOException("failed to open " + dev + ": "
+			+ string(::strerror(errno)));
+	}
+
+	struct termios tty;
+
+	if (::tcgetattr(fd, &tty) < 0) {
+		const int e = errno;
+		::close(fd);
+
+		throw IOException("failed to read attributes of " + dev + ": "
+			+ string(::strerror(e)));
+	}
+
+	::cfmakeraw(&tty);
+	::cfsetispeed(&tty, speed);
+	::cfsetospeed(&tty, speed);
+
+	tty.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+	tty.c_cflag |= size | CLOCAL | CREAD;
+
+	if (settings.parity == PARITY_EVEN)
+		tty.c_cflag |= PARENB;
+	else if (settings.parity == PARITY_ODD)
+		tty.c_cflag |= PARENB | PARODD;
+
+	if (settings.stopBits == 2)
+		tty.c_cflag |= CSTOPB;
+
+	// reading is driven by the reactor, never block in read()
+	tty.c_cc[VMIN] = 0;
+	tty.c_cc[VTIME] = 0;
+
+	if (::tcsetattr(fd, TCSANOW, &tty) < 0 || ::tcflush(fd, TCIOFLUSH) < 0) {
+		const int e = errno;
+		::close(fd);
+
+		throw IOException("failed to configure " + dev + ": "
+			+ string(::strerror(e)));
+	}
+
+	return fd;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include <Poco/Exception.h>
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "io/SerialFraming.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Serial port registered in the SerialReactor. The channel
+ * owns a non-blocking file descriptor of the port (a tty or a pseudo
+ * terminal). Reading is performed by the reactor thread that splits
+ * the received data into frames according to the channel's framing
+ * and passes them to the frame handler. Writing is performed directly
+ * by the calling thread.
+ *
+ * The file descriptor is closed when the last reference to the channel
+ * is dropped, i.e. never while the reactor thread is still using it.
+ */
+class SerialChannel : protected Loggable {
+public:
+	typedef Poco::SharedPtr<SerialChannel> Ptr;
+
+	/**
+	 * @brief Called from the reactor thread for each received frame.
+	 */
+	typedef std::function<void(const std::string &frame)> FrameHandler;
+
+	/**
+	 * @brief Called from the reactor thread when the channel fails
+	 * (e.g. the device is unplugged). The channel is unregistered
+	 * from the reactor before the handler is called.
+	 */
+	typedef std::function<void(const Poco::Exception &e)> ErrorHandler;
+
+	enum Parity {
+		PARITY_NONE,
+		PARITY_EVEN,
+		PARITY_ODD,
+	};
+
+	/**
+	 * @brief Line settings applied via termios when opening a serial port.
+	 */
+	struct Settings {
+		unsigned int baudRate;
+		unsigned int dataBits;
+		Parity parity;
+		unsigned int stopBits;
+
+		Settings(
+			unsigned int baudRate = 9600,
+			unsigned int dataBits = 8,
+			Parity parity = PARITY_NONE,
+			unsigned int stopBits = 1);
+
+		std::string toString() const;
+	};
+
+	/**
+	 * @brief Create channel for the given file descriptor. The channel
+	 * takes ownership of the file descriptor and switches it into
+	 * the non-blocking mode.
+	 */
+	SerialChannel(
+		int fd,
+		const std::string &name,
+		SerialFraming::Ptr framing,
+		FrameHandler onFrame,
+		ErrorHandler onError);
+	~SerialChannel();
+
+	int fd() const;
+	const std::string &name() const;
+
+	/**
+	 * @returns false if the channel has been closed or it has failed
+	 */
+	bool isOpen() const;
+
+	/**
+	 * @brief Write all the given data into the serial port. If the
+	 * port cannot accept more data, wait until it can or until the
+	 * timeout exceeds.
+	 *
+	 * @throws Poco::IllegalStateException when the channel is closed
+	 * @throws Poco::TimeoutException when the timeout exceeds
+	 * @throws Poco::IOException in case of a write failure
+	 */
+	void write(const std::string &data, const Poco::Timespan &timeout);
+
+	/**
+	 * @brief Read all data available in the serial port and pass
+	 * all complete frames to the frame handler. Called by the reactor.
+	 *
+	 * @throws Poco::IOException when reading fails or EOF is reached
+	 */
+	void receive(char *buffer, size_t size);
+
+	/**
+	 * @brief Mark the channel as closed and notify the error handler.
+	 * Called by the reactor.
+	 */
+	void fail(const Poco::Exception &e);
+
+	/**
+	 * @brief Mark the channel as closed. The file descriptor is still
+	 * kept open until the channel is destroyed.
+	 */
+	void close();
+
+	Poco::UInt64 receivedBytes() const;
+	Poco::UInt64 receivedFrames() const;
+
+	/**
+	 * @brief Open the given serial port in the non-blocking mode
+	 * and configure it according to the given settings.
+	 *
+	 * @returns file descriptor of the open port
+	 * @throws Poco::IOException when the port cannot be opened
+	 * or configured
+	 */
+	static int openPort(const std::string &dev, const Settings &settings);
+
+protected:
+	void deliver();
+
+private:
+	int m_fd;
+	std::string m_name;
+	SerialFraming::Ptr m_framing;
+	FrameHandler m_onFrame;
+	ErrorHandler m_onError;
+	std::string m_pending;
+	std::string m_frame;
+	std::atomic<bool> m_open;
+	std::atomic<Poco::UInt64> m_receivedBytes;
+	std::atomic<Poco::UInt64> m_receivedFrames;
+	Poco::FastMutex m_writeLock;
+};
+
+}
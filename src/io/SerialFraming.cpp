@@ -0,0 +1,41 @@
+#include "io/SerialFraming.h"
+
+using namespace BeeeOn;
+using namespace std;
+
+SerialFraming::~SerialFraming()
+{
+}
+
+DelimitedSerialFraming::DelimitedSerialFraming(char delimiter):
+	m_delimiter(delimiter)
+{
+}
+
+bool DelimitedSerialFraming::extract(string &buffer, string &frame)
+{
+	size_t begin = 0;
+
+	while (begin < buffer.size() && buffer[begin] == m_delimiter)
+		++begin;
+
+	const size_t end = buffer.find(m_delimiter, begin);
+	if (end == string::npos) {
+		buffer.erase(0, begin);
+		return false;
+	}
+
+	frame.assign(buffer, begin, end - begin);
+	buffer.erase(0, end + 1);
+	return true;
+}
+
+bool RawSerialFraming::extract(string &buffer, string &frame)
+{
+	if (buffer.empty())
+		return false;
+
+	frame.clear();
+	frame.swap(buffer);
+	return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+
+#include <Poco/SharedPtr.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Strategy splitting a stream of bytes received from a serial
+ * port into protocol frames. Each protocol connected via the
+ * SerialReactor provides its own framing.
+ */
+class SerialFraming {
+public:
+	typedef Poco::SharedPtr<SerialFraming> Ptr;
+
+	virtual ~SerialFraming();
+
+	/**
+	 * @brief Extract the first complete frame from the given buffer.
+	 * The bytes of the extracted frame (and any garbage preceding it)
+	 * are removed from the buffer.
+	 *
+	 * @returns false when the buffer does not contain a complete frame
+	 */
+	virtual bool extract(std::string &buffer, std::string &frame) = 0;
+};
+
+/**
+ * @brief Frames separated by a delimiter (a new line by default).
+ * The delimiter is not part of the extracted frames and empty frames
+ * are skipped.
+ */
+class DelimitedSerialFraming : public SerialFraming {
+public:
+	DelimitedSerialFraming(char delimiter = '\n');
+
+	bool extract(std::string &buffer, std::string &frame) override;
+
+private:
+	char m_delimiter;
+};
+
+/**
+ * @brief No framing, all bytes received at once are passed as
+ * a single frame.
+ */
+class RawSerialFraming : public SerialFraming {
+public:
+	bool extract(std::string &buffer, std::string &frame) override;
+};
+
+}
@@ -0,0 +1,273 @@
+#include <cerrno>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/Thread.h>
+
+#include "di/Injectable.h"
+#include "io/SerialReactor.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, SerialReactor)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_PROPERTY("maxEvents", &SerialReactor::setMaxEvents)
+BEEEON_OBJECT_PROPERTY("readSize", &SerialReactor::setReadSize)
+BEEEON_OBJECT_END(BeeeOn, SerialReactor)
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+SerialReactor::SerialReactor():
+	m_epoll(-1),
+	m_wakeup(-1),
+	m_buffer(1024),
+	m_maxEvents(16),
+	m_reactorThread(0)
+{
+	m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+	if (m_epoll < 0) {
+		throw IOException("failed to create epoll: "
+			+ string(::strerror(errno)));
+	}
+
+	m_wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_wakeup < 0) {
+		const int e = errno;
+		::close(m_epoll);
+
+		throw IOException("failed to create eventfd: " + string(::strerror(e)));
+	}
+
+	struct epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = m_wakeup;
+
+	if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event) < 0) {
+		const int e = errno;
+		::close(m_wakeup);
+		::close(m_epoll);
+
+		throw IOException("failed to register eventfd: " + string(::strerror(e)));
+	}
+}
+
+SerialReactor::~SerialReactor()
+{
+	m_channels.clear();
+
+	::close(m_wakeup);
+	::close(m_epoll);
+}
+
+void SerialReactor::setMaxEvents(int count)
+{
+	if (count <= 0)
+		throw InvalidArgumentException("maxEvents must be positive");
+
+	m_maxEvents = count;
+}
+
+void SerialReactor::setReadSize(int size)
+{
+	if (size <= 0)
+		throw InvalidArgumentException("readSize must be positive");
+
+	m_buffer.resize(size);
+}
+
+SerialChannel::Ptr SerialReactor::open(
+		const string &dev,
+		const SerialChannel::Settings &settings,
+		SerialFraming::Ptr framing,
+		SerialChannel::FrameHandler onFrame,
+		SerialChannel::ErrorHandler onError)
+{
+	const int fd = SerialChannel::openPort(dev, settings);
+
+	logger().information("opened " + dev + " (" + settings.toString() + ")",
+		__FILE__, __LINE__);
+
+	return attach(fd, dev, framing, onFrame, onError);
+}
+
+SerialChannel::Ptr SerialReactor::attach(
+		int fd,
+		const string &name,
+		SerialFraming::Ptr framing,
+		SerialChannel::FrameHandler onFrame,
+		SerialChannel::ErrorHandler onError)
+{
+	SerialChannel::Ptr channel = new SerialChannel(
+		fd, name, framing, onFrame, onError);
+
+	registerChannel(channel);
+	return channel;
+}
+
+void SerialReactor::registerChannel(SerialChannel::Ptr channel)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	struct epoll_event event = {};
+	event.events = EPOLLIN | EPOLLRDHUP;
+	event.data.fd = channel->fd();
+
+	if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, channel->fd(), &event) < 0) {
+		throw IOException("failed to register " + channel->name() + ": "
+			+ string(::strerror(errno)));
+	}
+
+	m_channels.emplace(channel->fd(), channel);
+}
+
+void SerialReactor::close(SerialChannel::Ptr channel)
+{
+	unregister(channel);
+	channel->close();
+}
+
+void SerialReactor::unregister(SerialChannel::Ptr channel)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto it = m_channels.find(channel->fd());
+	if (it != m_channels.end() && it->second == channel) {
+		if (::epoll_ctl(m_epoll, EPOLL_CTL_DEL, channel->fd(), nullptr) < 0) {
+			logger().warning("failed to unregister " + channel->name() + ": "
+				+ string(::strerror(errno)),
+				__FILE__, __LINE__);
+		}
+
+		m_channels.erase(it);
+	}
+
+	// the channel might have been unregistered by the reactor thread
+	// that is still calling its error handler
+	while (m_dispatching == channel) {
+		if (Thread::currentTid() == m_reactorThread)
+			break;
+
+		m_dispatched.wait(m_lock);
+	}
+}
+
+SerialChannel::Ptr SerialReactor::beginDispatch(int fd)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto it = m_channels.find(fd);
+	if (it == m_channels.end())
+		return nullptr;
+
+	m_dispatching = it->second;
+	return m_dispatching;
+}
+
+void SerialReactor::endDispatch()
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	m_dispatching = nullptr;
+	m_dispatched.broadcast();
+}
+
+size_t SerialReactor::count() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_channels.size();
+}
+
+void SerialReactor::run()
+{
+	StopControl::Run run(m_stopControl);
+	vector<struct epoll_event> events(m_maxEvents);
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		m_reactorThread = Thread::currentTid();
+	}
+
+	logger().information("starting serial reactor", __FILE__, __LINE__);
+
+	while (run) {
+		const int ret = ::epoll_wait(m_epoll, events.data(), events.size(), -1);
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			throw IOException("epoll_wait failed: " + string(::strerror(errno)));
+		}
+
+		for (int i = 0; i < ret; ++i) {
+			if (events[i].data.fd == m_wakeup) {
+				drainWakeup();
+				continue;
+			}
+
+			SerialChannel::Ptr channel = beginDispatch(events[i].data.fd);
+			if (channel.isNull())
+				continue;
+
+			try {
+				process(channel, events[i].events);
+			}
+			catch (...) {
+				endDispatch();
+				throw;
+			}
+
+			endDispatch();
+		}
+	}
+
+	logger().information("serial reactor has finished", __FILE__, __LINE__);
+}
+
+void SerialReactor::process(SerialChannel::Ptr channel, uint32_t events)
+{
+	try {
+		if (events & EPOLLIN)
+			channel->receive(m_buffer.data(), m_buffer.size());
+
+		if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+			throw IOException("connection to " + channel->name() + " was lost");
+	}
+	catch (const Exception &e) {
+		logger().log(e, __FILE__, __LINE__);
+
+		unregister(channel);
+		channel->fail(e);
+	}
+}
+
+void SerialReactor::stop()
+{
+	m_stopControl.requestStop();
+	wakeup();
+}
+
+void SerialReactor::wakeup()
+{
+	const uint64_t one = 1;
+
+	if (::write(m_wakeup, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+		logger().error("failed to wake up reactor: " + string(::strerror(errno)),
+			__FILE__, __LINE__);
+	}
+}
+
+void SerialReactor::drainWakeup()
+{
+	uint64_t value;
+
+	if (::read(m_wakeup, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+		logger().error("failed to drain wakeup: " + string(::strerror(errno)),
+			__FILE__, __LINE__);
+	}
+}
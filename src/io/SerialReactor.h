@@ -0,0 +1,120 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Poco/Condition.h>
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Thread.h>
+
+#include "io/SerialChannel.h"
+#include "io/SerialFraming.h"
+#include "loop/StopControl.h"
+#include "loop/StoppableRunnable.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief SerialReactor serves multiple serial ports (dongles) from
+ * a single thread. Each serial port is registered as a SerialChannel
+ * with its own framing and handlers. The reactor waits via epoll()
+ * for data on all registered ports and delivers complete frames to
+ * the appropriate handlers.
+ *
+ * Frame handlers are called from the reactor thread. They must not
+ * block for a long time as they delay processing of all other ports.
+ * Writing into a channel is performed directly by the calling thread
+ * and does not involve the reactor.
+ */
+class SerialReactor : public StoppableRunnable, protected Loggable {
+public:
+	typedef Poco::SharedPtr<SerialReactor> Ptr;
+
+	SerialReactor();
+	~SerialReactor();
+
+	/**
+	 * @brief Maximal number of events processed by a single
+	 * epoll_wait() call.
+	 */
+	void setMaxEvents(int count);
+
+	/**
+	 * @brief Size of buffer used for reading from serial ports.
+	 */
+	void setReadSize(int size);
+
+	/**
+	 * @brief Open the given serial port, configure it according to
+	 * the given settings and register it.
+	 */
+	SerialChannel::Ptr open(
+		const std::string &dev,
+		const SerialChannel::Settings &settings,
+		SerialFraming::Ptr framing,
+		SerialChannel::FrameHandler onFrame,
+		SerialChannel::ErrorHandler onError = {});
+
+	/**
+	 * @brief Register an already open file descriptor (e.g. a pseudo
+	 * terminal). The reactor takes ownership of the file descriptor.
+	 */
+	SerialChannel::Ptr attach(
+		int fd,
+		const std::string &name,
+		SerialFraming::Ptr framing,
+		SerialChannel::FrameHandler onFrame,
+		SerialChannel::ErrorHandler onError = {});
+
+	/**
+	 * @brief Unregister the given channel. If a handler of the channel
+	 * is being called by the reactor thread at the moment, the call
+	 * waits until it returns. No handler of the channel is called
+	 * after this call returns. When called from a handler (i.e. by
+	 * the reactor thread), the call does not wait.
+	 */
+	void close(SerialChannel::Ptr channel);
+
+	/**
+	 * @returns number of registered channels
+	 */
+	size_t count() const;
+
+	void run() override;
+	void stop() override;
+
+protected:
+	void wakeup();
+	void drainWakeup();
+	void registerChannel(SerialChannel::Ptr channel);
+	void unregister(SerialChannel::Ptr channel);
+
+	/**
+	 * @brief Find the channel registered for the given file descriptor
+	 * and mark it as being dispatched by the reactor thread.
+	 */
+	SerialChannel::Ptr beginDispatch(int fd);
+	void endDispatch();
+
+	/**
+	 * @brief Process the given event of the given channel.
+	 */
+	void process(SerialChannel::Ptr channel, uint32_t events);
+
+private:
+	int m_epoll;
+	int m_wakeup;
+	std::vector<char> m_buffer;
+	size_t m_maxEvents;
+	std::map<int, SerialChannel::Ptr> m_channels;
+	SerialChannel::Ptr m_dispatching;
+	Poco::Thread::TID m_reactorThread;
+	Poco::Condition m_dispatched;
+	mutable Poco::FastMutex m_lock;
+	StopControl m_stopControl;
+};
+
+}
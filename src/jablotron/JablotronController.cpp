@@ -6,18 +6,24 @@
 #include <Poco/RegularExpression.h>
 
 #include "di/Injectable.h"
+#include "io/SerialFraming.h"
 #include "jablotron/JablotronController.h"
+#include "util/InputTraceRecorder.h"
 #include "util/UnsafePtr.h"
 
 using namespace std;
 using namespace Poco;
 using namespace BeeeOn;
 
+const string JablotronController::TRACE_CHANNEL = "jablotron";
+
 static const string CMD_BEGIN = "\x1B";
 static const string CMD_END   = "\n";
 
 static const string CMD_VERSION   = "WHO AM I?";
 
+static const Timespan WRITE_TIMEOUT = 1 * Timespan::SECONDS;
+
 static string CMD_READ_SLOT(unsigned int i)
 {
 	return "GET SLOT:" + NumberFormatter::format0(i, 2);
@@ -68,7 +74,9 @@ JablotronController::JablotronController():
 	m_ioJoinTimeout(2 * Timespan::SECONDS),
 	m_ioReadTimeout(500 * Timespan::MILLISECONDS),
 	m_ioErrorSleep(2 * Timespan::SECONDS),
-	m_ioLoop(*this, &JablotronController::ioLoop)
+	m_ioLoop(*this, &JablotronController::ioLoop),
+	m_reconnecting(false),
+	m_reconnectLoop(*this, &JablotronController::reconnectLoop)
 {
 }
 
@@ -112,8 +120,19 @@ void JablotronController::setIOErrorSleep(const Timespan &delay)
 	m_ioErrorSleep = delay;
 }
 
+void JablotronController::setSerialReactor(SerialReactor::Ptr reactor)
+{
+	m_reactor = reactor;
+}
+
 void JablotronController::probe(const string &dev)
 {
+	if (!m_reactor.isNull()) {
+		probeChannel(dev);
+		return;
+	}
+
+	FastMutex::ScopedLock requestGuard(m_requestLock);
 	FastMutex::ScopedLock guard(m_lock);
 
 	if (!m_ioThread.isNull()) {
@@ -132,22 +151,28 @@ void JablotronController::probe(const string &dev)
 
 void JablotronController::release(const string &dev)
 {
-	FastMutex::ScopedLock guard(m_lock);
+	ScopedLockWithUnlock<FastMutex> guard(m_lock);
 
 	m_requestEvent.set();
 	m_pollEvent.set();
 
-	stopIO(dev);
+	SerialChannel::Ptr channel = stopIO(dev);
+	guard.unlock();
+
+	closeChannel(channel);
 }
 
 void JablotronController::dispose()
 {
-	FastMutex::ScopedLock guard(m_lock);
+	ScopedLockWithUnlock<FastMutex> guard(m_lock);
 
 	m_requestEvent.set();
 	m_pollEvent.set();
 
-	stopIO(m_port.devicePath());
+	SerialChannel::Ptr channel = stopIO(devicePath());
+	guard.unlock();
+
+	closeChannel(channel);
 }
 
 void JablotronController::startIO()
@@ -166,13 +191,29 @@ void JablotronController::startIO()
 	m_ioThread->start(m_ioLoop);
 }
 
-void JablotronController::stopIO(const string &dev)
+SerialChannel::Ptr JablotronController::stopIO(const string &dev)
 {
+	if (!m_reactor.isNull()) {
+		if (devicePath() != dev)
+			return nullptr;
+
+		m_reconnectDev.clear();
+		m_reconnectEvent.set();
+
+		SerialChannel::Ptr channel = m_channel;
+		m_channel = nullptr;
+
+		if (!channel.isNull())
+			logger().information("closing " + dev);
+
+		return channel;
+	}
+
 	if (m_ioThread.isNull())
-		return;
+		return nullptr;
 
 	if (m_port.devicePath() != dev)
-		return;
+		return nullptr;
 
 	logger().information("stopping I/O thread");
 
@@ -183,6 +224,25 @@ void JablotronController::stopIO(const string &dev)
 
 	m_ioThread = nullptr;
 	m_joiner = nullptr;
+	return nullptr;
+}
+
+void JablotronController::closeChannel(SerialChannel::Ptr channel)
+{
+	SharedPtr<Thread> thread;
+	SharedPtr<Joiner> joiner;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		thread = m_reconnectThread;
+		joiner = m_reconnectJoiner;
+	}
+
+	if (!joiner.isNull() && !joiner->tryJoin(m_ioJoinTimeout))
+		logger().critical("timeout while joining reconnect thread", __FILE__, __LINE__);
+
+	if (!channel.isNull())
+		m_reactor->close(channel);
 }
 
 Nullable<uint32_t> JablotronController::readSlot(
@@ -283,9 +343,11 @@ string JablotronController::command(const string &request, const Timespan &timeo
 	while (!m_responses.empty())
 		m_responses.pop();
 
-	writePort(CMD_BEGIN + request + CMD_END);
+	const SerialChannel::Ptr channel = m_channel;
 	tmpGuard.unlock();
 
+	writePort(CMD_BEGIN + request + CMD_END, channel);
+
 	while (!m_stopControl.shouldStop()) {
 		ScopedLockWithUnlock<FastMutex> tmp2guard(m_lock);
 
@@ -379,6 +441,8 @@ void JablotronController::processMessage(const string &message)
 		const auto product = message.substr(m[2].offset, m[2].length);
 		const auto data = message.substr(m[3].offset, m[3].length);
 
+		InputTraceRecorder::instance().record(TRACE_CHANNEL, message);
+
 		FastMutex::ScopedLock guard(m_lock);
 
 		const JablotronReport report = {address, product, data};
@@ -482,7 +546,7 @@ void JablotronController::probePort(const string &dev)
 	catch (const TimeoutException &) {
 	}
 
-	writePort(CMD_BEGIN + CMD_VERSION + CMD_END);
+	writePort(CMD_BEGIN + CMD_VERSION + CMD_END, nullptr);
 
 	for (size_t i = 0; i < m_maxProbeAttempts; ++i) {
 		try {
@@ -499,6 +563,151 @@ void JablotronController::probePort(const string &dev)
 	throw TimeoutException("probe failed, version response was not received");
 }
 
+void JablotronController::probeChannel(const string &dev)
+{
+	FastMutex::ScopedLock requestGuard(m_requestLock);
+	ScopedLockWithUnlock<FastMutex> guard(m_lock);
+
+	if (!m_channel.isNull() || !m_reconnectDev.empty()) {
+		logger().information(devicePath() + " is already open, ignoring " + dev);
+		return;
+	}
+
+	while (!m_responses.empty())
+		m_responses.pop();
+	while (!m_reports.empty())
+		m_reports.pop();
+
+	m_requestEvent.reset();
+	m_pollEvent.reset();
+
+	logger().information("probing port " + dev);
+
+	m_channel = openChannel(dev);
+	guard.unlock();
+
+	for (size_t i = 0; i < m_maxProbeAttempts; ++i) {
+		SerialChannel::Ptr channel;
+
+		{
+			FastMutex::ScopedLock attemptGuard(m_lock);
+			channel = m_channel;
+		}
+
+		if (channel.isNull())
+			break;
+
+		// the welcome message is received as a response and dropped
+		writePort(CMD_BEGIN + CMD_VERSION + CMD_END, channel);
+
+		const Clock started;
+
+		while (!started.isElapsed(m_probeTimeout.totalMicroseconds())) {
+			const Timespan remaining = m_probeTimeout - started.elapsed();
+			m_requestEvent.tryWait(remaining.totalMilliseconds() + 1);
+
+			FastMutex::ScopedLock responseGuard(m_lock);
+
+			while (!m_responses.empty()) {
+				const string response = m_responses.front();
+				m_responses.pop();
+
+				if (receivedVersion(CMD_END + response + CMD_END))
+					return;
+			}
+		}
+	}
+
+	ScopedLockWithUnlock<FastMutex> failedGuard(m_lock);
+	SerialChannel::Ptr channel = stopIO(dev);
+	failedGuard.unlock();
+
+	closeChannel(channel);
+
+	throw TimeoutException("probe failed, version response was not received");
+}
+
+SerialChannel::Ptr JablotronController::openChannel(const string &dev)
+{
+	return m_reactor->open(
+		dev,
+		SerialChannel::Settings(57600, 8, SerialChannel::PARITY_NONE, 1),
+		new DelimitedSerialFraming('\n'),
+		[this](const string &message) {
+			processMessage(message);
+		},
+		[this](const Exception &e) {
+			channelFailed(e);
+		});
+}
+
+void JablotronController::channelFailed(const Exception &e)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	// the port is being released
+	if (m_channel.isNull())
+		return;
+
+	logger().warning("serial port " + devicePath() + " has failed: "
+		+ e.displayText(),
+		__FILE__, __LINE__);
+
+	m_reconnectDev = m_channel->name();
+	m_channel = nullptr;
+	m_requestEvent.set();
+	m_pollEvent.set();
+
+	if (m_reconnecting)
+		return;
+
+	// the previous reconnect thread has already left its loop
+	if (!m_reconnectJoiner.isNull())
+		m_reconnectJoiner->join();
+
+	m_reconnecting = true;
+	m_reconnectEvent.reset();
+	m_reconnectJoiner = nullptr;
+	m_reconnectThread = new Thread;
+	m_reconnectJoiner = new Joiner(*m_reconnectThread);
+	m_reconnectThread->start(m_reconnectLoop);
+}
+
+void JablotronController::reconnectLoop()
+{
+	while (true) {
+		m_reconnectEvent.tryWait(m_ioErrorSleep.totalMilliseconds());
+
+		FastMutex::ScopedLock guard(m_lock);
+
+		if (!m_reconnectDev.empty()) {
+			try {
+				m_channel = openChannel(m_reconnectDev);
+				logger().notice("reconnected " + m_reconnectDev);
+
+				m_reconnectDev.clear();
+			}
+			BEEEON_CATCH_CHAIN(logger())
+		}
+
+		if (m_reconnectDev.empty()) {
+			m_reconnecting = false;
+			break;
+		}
+	}
+}
+
+string JablotronController::devicePath()
+{
+	if (!m_channel.isNull())
+		return m_channel->name();
+
+	if (!m_reconnectDev.empty())
+		return m_reconnectDev;
+
+	return m_port.devicePath();
+}
+
 bool JablotronController::receivedVersion(const string &response)
 {
 	static const RegularExpression pattern("\\n([A-Z ]+V[0-9]\\.[0-9])( [A-Z]+)?\\n");
@@ -516,11 +725,15 @@ bool JablotronController::receivedVersion(const string &response)
 	return false;
 }
 
-void JablotronController::writePort(const string &request)
+void JablotronController::writePort(
+		const string &request,
+		SerialChannel::Ptr channel)
 {
+	const string path = channel.isNull() ? m_port.devicePath() : channel->name();
+
 	if (logger().trace()) {
 		logger().dump(
-			"writing to port " + m_port.devicePath() + " "
+			"writing to port " + path + " "
 			+ to_string(request.size()) + " B",
 			request.data(),
 			request.size(),
@@ -528,12 +741,20 @@ void JablotronController::writePort(const string &request)
 	}
 	else if (logger().debug()) {
 		logger().debug(
-			"writing to port " + m_port.devicePath() + " "
+			"writing to port " + path + " "
 			+ to_string(request.size()) + " B",
 			__FILE__, __LINE__);
 	}
 
-	m_port.write(request);
+	if (m_reactor.isNull()) {
+		m_port.write(request);
+		return;
+	}
+
+	if (channel.isNull())
+		throw IllegalStateException("no serial port is open");
+
+	channel->write(request, WRITE_TIMEOUT);
 }
 
 string JablotronController::readPort(const Timespan &timeout)
@@ -11,7 +11,9 @@
 #include <Poco/Thread.h>
 #include <Poco/Timespan.h>
 
+#include "io/SerialChannel.h"
 #include "io/SerialPort.h"
+#include "io/SerialReactor.h"
 #include "jablotron/JablotronReport.h"
 #include "loop/StopControl.h"
 #include "util/Joiner.h"
@@ -23,6 +25,12 @@ namespace BeeeOn {
  * @brief JablotronController provides access to the Turris Dongle
  * that is connected via a serial port. The Turris Dongle must be
  * probed to start an internal I/O thread that handles incoming messages.
+ *
+ * If a SerialReactor is configured, no internal I/O thread is started.
+ * The serial port is registered into the reactor instead and incoming
+ * messages are handled by the reactor thread. When the serial port
+ * fails, it is reopened every ioErrorSleep until it succeeds or until
+ * the port is released.
  */
 class JablotronController : Loggable {
 public:
@@ -32,6 +40,11 @@ public:
 		BEEP_FAST,
 	};
 
+	/**
+	 * @brief Channel of reports captured by the InputTraceRecorder.
+	 */
+	static const std::string TRACE_CHANNEL;
+
 	JablotronController();
 
 	/**
@@ -65,6 +78,12 @@ public:
 	 */
 	void setIOErrorSleep(const Poco::Timespan &delay);
 
+	/**
+	 * @brief Configure reactor to handle the serial port instead of
+	 * the internal I/O thread.
+	 */
+	void setSerialReactor(SerialReactor::Ptr reactor);
+
 	/**
 	 * @brief Probe the given serial port (e.g. "/dev/ttyUSB0") and if
 	 * it proves to be a Jablotron control station, the internal I/O
@@ -179,8 +198,25 @@ protected:
 	 * dev matches the currently used serial port.
 	 * The call blocks until the I/O threads finishes or
 	 * the ioJoinTimeout exceeds.
+	 *
+	 * In case of the reactor, the channel of the serial port is
+	 * detached and returned. It must be closed via closeChannel()
+	 * after m_lock is released because closing waits for handlers
+	 * running in the reactor thread that lock m_lock.
 	 */
-	void stopIO(const std::string &dev);
+	SerialChannel::Ptr stopIO(const std::string &dev);
+
+	/**
+	 * @brief Stop reconnecting and close the given channel (if any).
+	 * Must not be called with m_lock held.
+	 */
+	void closeChannel(SerialChannel::Ptr channel);
+
+	/**
+	 * @brief Open the given port via the reactor and register
+	 * the handlers of this controller.
+	 */
+	SerialChannel::Ptr openChannel(const std::string &dev);
 
 	/**
 	 * @brief Probe the given port and test whether it is
@@ -189,6 +225,30 @@ protected:
 	 */
 	void probePort(const std::string &dev);
 
+	/**
+	 * @brief Open the given port via the reactor and test whether it
+	 * is an appropriate Turris Dongle. The port is closed on failure.
+	 */
+	void probeChannel(const std::string &dev);
+
+	/**
+	 * @brief Called by the reactor when the serial port fails.
+	 * It starts the reconnect thread that reopens the port.
+	 */
+	void channelFailed(const Poco::Exception &e);
+
+	/**
+	 * @brief The entry into the reconnect thread. It tries to reopen
+	 * the failed serial port every ioErrorSleep until it succeeds
+	 * or until the port is released.
+	 */
+	void reconnectLoop();
+
+	/**
+	 * @returns path of the currently used serial port
+	 */
+	std::string devicePath();
+
 	/**
 	 * @brief Parse the response to be the version string.
 	 * @returns true if the version string was recognized
@@ -237,11 +297,18 @@ protected:
 	 */
 	void ioLoop();
 
-	void writePort(const std::string &request);
+	/**
+	 * @brief Write the request into the serial port or into the given
+	 * channel when the reactor is used. The call blocks until the data
+	 * is written and thus it must not be called with m_lock held.
+	 */
+	void writePort(const std::string &request, SerialChannel::Ptr channel);
 	std::string readPort(const Poco::Timespan &timeout);
 
 private:
 	SerialPort m_port;
+	SerialReactor::Ptr m_reactor;
+	SerialChannel::Ptr m_channel;
 	std::queue<std::string> m_responses;
 	Poco::Event m_requestEvent;
 	std::queue<JablotronReport> m_reports;
@@ -258,6 +325,13 @@ private:
 	Poco::RunnableAdapter<JablotronController> m_ioLoop;
 	StopControl m_stopControl;
 
+	std::string m_reconnectDev;
+	bool m_reconnecting;
+	Poco::Event m_reconnectEvent;
+	Poco::SharedPtr<Poco::Thread> m_reconnectThread;
+	Poco::SharedPtr<Joiner> m_reconnectJoiner;
+	Poco::RunnableAdapter<JablotronController> m_reconnectLoop;
+
 	Poco::FastMutex m_lock;
 	Poco::FastMutex m_requestLock;
 };
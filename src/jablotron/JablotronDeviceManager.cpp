@@ -15,6 +15,7 @@
 #include "hotplug/HotplugEvent.h"
 #include "model/SensorData.h"
 #include "util/BlockingAsyncWork.h"
+#include "util/ContinuationAsyncWork.h"
 #include "util/UnsafePtr.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, JablotronDeviceManager)
@@ -35,6 +36,8 @@ BEEEON_OBJECT_PROPERTY("probeTimeout", &JablotronDeviceManager::setProbeTimeout)
 BEEEON_OBJECT_PROPERTY("ioJoinTimeout", &JablotronDeviceManager::setIOJoinTimeout)
 BEEEON_OBJECT_PROPERTY("ioReadTimeout", &JablotronDeviceManager::setIOReadTimeout)
 BEEEON_OBJECT_PROPERTY("ioErrorSleep", &JablotronDeviceManager::setIOErrorSleep)
+BEEEON_OBJECT_PROPERTY("serialReactor", &JablotronDeviceManager::setSerialReactor)
+BEEEON_OBJECT_PROPERTY("workReactor", &JablotronDeviceManager::setWorkReactor)
 BEEEON_OBJECT_END(BeeeOn, JablotronDeviceManager)
 
 using namespace BeeeOn;
@@ -156,6 +159,11 @@ void JablotronDeviceManager::setIOErrorSleep(const Timespan &delay)
 	m_controller.setIOErrorSleep(delay);
 }
 
+void JablotronDeviceManager::setSerialReactor(SerialReactor::Ptr reactor)
+{
+	m_controller.setSerialReactor(reactor);
+}
+
 DeviceID JablotronDeviceManager::buildID(uint32_t address)
 {
 	const auto primary = JablotronGadget::Info::primaryAddress(address);
@@ -295,7 +303,7 @@ vector<JablotronGadget> JablotronDeviceManager::readGadgets(
 			continue;
 		}
 
-		const auto info = JablotronGadget::Info::resolve(address);
+		const auto &info = JablotronGadget::Info::resolve(address);
 		if (!info) {
 			logger().warning(
 				"unrecognized gadget address "
@@ -444,7 +452,7 @@ void JablotronDeviceManager::syncSlots()
 
 void JablotronDeviceManager::shipReport(const JablotronReport &report)
 {
-	const auto info = JablotronGadget::Info::resolve(report.address);
+	const auto &info = JablotronGadget::Info::resolve(report.address);
 	if (!info) {
 		logger().warning(
 			"unrecognized device by address "
@@ -713,6 +721,22 @@ AsyncWork<double>::Ptr JablotronDeviceManager::startSetValue(
 	}
 
 	BackOff::Ptr backoff = m_txBackOffFactory->create();
+
+	if (!workReactor().isNull()) {
+		TXRequest::Ptr request = new TXRequest;
+		request->work = new ContinuationAsyncWork<double>;
+		request->backoff = backoff;
+		request->pgx = m_pgx;
+		request->pgy = m_pgy;
+		request->alarm = m_alarm;
+		request->beep = m_beep;
+		request->value = static_cast<double>(v);
+		request->timeout = timeout;
+
+		transmitTX(request);
+		return request->work;
+	}
+
 	Timespan delay;
 
 	do {
@@ -725,3 +749,44 @@ AsyncWork<double>::Ptr JablotronDeviceManager::startSetValue(
 	work->setResult(static_cast<double>(v));
 	return work;
 }
+
+void JablotronDeviceManager::transmitTX(TXRequest::Ptr request)
+{
+	workReactor()->execute([this, request]() {
+		ContinuationAsyncWork<double>::Ptr work = request->work;
+
+		if (work->finished())
+			return;
+
+		const Timespan remaining = request->timeout - request->started.elapsed();
+
+		if (remaining <= 0) {
+			work->fail(TimeoutException("set-value timeout has exceeded"));
+			return;
+		}
+
+		try {
+			m_controller.sendTX(
+				request->pgx,
+				request->pgy,
+				request->alarm,
+				request->beep,
+				remaining);
+		}
+		catch (const Exception &e) {
+			work->fail(e);
+			return;
+		}
+
+		const Timespan delay = request->backoff->next();
+
+		if (delay == BackOff::STOP) {
+			work->complete(request->value);
+			return;
+		}
+
+		workReactor()->schedule(delay, [this, request]() {
+			transmitTX(request);
+		});
+	});
+}
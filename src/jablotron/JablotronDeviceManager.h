@@ -3,6 +3,7 @@
 #include <list>
 #include <set>
 
+#include <Poco/Clock.h>
 #include <Poco/Mutex.h>
 
 #include "commands/DeviceAcceptCommand.h"
@@ -11,11 +12,13 @@
 #include "commands/GatewayListenCommand.h"
 #include "core/DeviceManager.h"
 #include "hotplug/HotplugListener.h"
+#include "io/SerialReactor.h"
 #include "jablotron/JablotronController.h"
 #include "jablotron/JablotronGadget.h"
 #include "jablotron/JablotronReport.h"
 #include "model/ModuleType.h"
 #include "util/BackOff.h"
+#include "util/ContinuationAsyncWork.h"
 
 namespace BeeeOn {
 
@@ -110,6 +113,11 @@ public:
 	 */
 	void setIOErrorSleep(const Poco::Timespan &delay);
 
+	/**
+	 * @see JablotronController::setSerialReactor
+	 */
+	void setSerialReactor(SerialReactor::Ptr reactor);
+
 	void onAdd(const HotplugEvent &e) override;
 	void onRemove(const HotplugEvent &e) override;
 
@@ -162,6 +170,33 @@ protected:
 			const double value,
 			const Poco::Timespan &timeout) override;
 
+	/**
+	 * @brief TX packet captured when a set-value starts. Its
+	 * retransmissions always send the captured state.
+	 */
+	struct TXRequest {
+		typedef Poco::SharedPtr<TXRequest> Ptr;
+
+		ContinuationAsyncWork<double>::Ptr work;
+		BackOff::Ptr backoff;
+		bool pgx;
+		bool pgy;
+		bool alarm;
+		JablotronController::Beep beep;
+		double value;
+		Poco::Clock started;
+		Poco::Timespan timeout;
+	};
+
+	/**
+	 * @brief Send the TX packet via the executor of the AsyncWorkReactor
+	 * and schedule its retransmission in the reactor according to the
+	 * backoff. Each transmission is limited by the time remaining until
+	 * the timeout of the request. The work is completed with the value
+	 * of the request after the last transmission.
+	 */
+	void transmitTX(TXRequest::Ptr request);
+
 	/**
 	 * @brief Recognizes compatible dongle by testing HotplugEvent property
 	 * as <code>tty.BEEEON_DONGLE == jablotron</code>.
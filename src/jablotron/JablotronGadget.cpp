@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <iterator>
 #include <vector>
 
 #include <Poco/Exception.h>
@@ -12,53 +14,171 @@ using namespace BeeeOn;
 static const Timespan REFRESH_TIME_9MIN = 9 * Timespan::MINUTES;
 static const Timespan REFRESH_TIME_NONE = -1;
 
-static const uint32_t RC86K_FIRST = 0x800000;
-static const uint32_t RC86K_LAST  = 0x87ffff;
-static const uint32_t RC86K_DIFF  = 0x100000;
+static constexpr uint32_t RC86K_FIRST = 0x800000;
+static constexpr uint32_t RC86K_LAST  = 0x87ffff;
+static constexpr uint32_t RC86K_DIFF  = 0x100000;
+
+static constexpr uint32_t RC86K_SECONDARY_FIRST = RC86K_FIRST + RC86K_DIFF;
+static constexpr uint32_t RC86K_SECONDARY_LAST  = RC86K_LAST + RC86K_DIFF;
+
+/**
+ * Address ranges of gadget types sorted by the first address to be
+ * searched by the binary search.
+ */
+struct AddressRange {
+	uint32_t firstAddress;
+	uint32_t lastAddress;
+	JablotronGadget::Type type;
+};
+
+static constexpr AddressRange ADDRESS_RANGES[] = {
+	{0x180000, 0x1bffff, JablotronGadget::JA81M},
+	{0x1c0000, 0x1dffff, JablotronGadget::JA83M},
+	{0x240000, 0x25ffff, JablotronGadget::TP82N},
+	{0x580000, 0x59ffff, JablotronGadget::JA80L},
+	{0x640000, 0x65ffff, JablotronGadget::JA83P},
+	{0x760000, 0x76ffff, JablotronGadget::JA85ST},
+	{0x7f0000, 0x7fffff, JablotronGadget::JA82SH},
+	{RC86K_FIRST, RC86K_LAST, JablotronGadget::RC86K},
+	{0xcf0000, 0xcfffff, JablotronGadget::AC88},
+};
+
+static constexpr size_t ADDRESS_RANGES_COUNT =
+	sizeof(ADDRESS_RANGES) / sizeof(ADDRESS_RANGES[0]);
+
+static constexpr bool sortedFrom(size_t i)
+{
+	return i + 1 >= ADDRESS_RANGES_COUNT
+		|| (ADDRESS_RANGES[i].firstAddress <= ADDRESS_RANGES[i].lastAddress
+			&& ADDRESS_RANGES[i].lastAddress < ADDRESS_RANGES[i + 1].firstAddress
+			&& sortedFrom(i + 1));
+}
+
+static_assert(sortedFrom(0), "ADDRESS_RANGES must be sorted and must not overlap");
+
+static void decodeAC88(
+		const uint32_t,
+		const JablotronPayload &payload,
+		vector<SensorValue> &values)
+{
+	values.push_back({0, static_cast<double>(payload.get(JablotronPayload::KEY_RELAY))});
+}
 
-static const uint32_t RC86K_SECONDARY_FIRST = RC86K_FIRST + RC86K_DIFF;
-static const uint32_t RC86K_SECONDARY_LAST  = RC86K_LAST + RC86K_DIFF;
+static void decodeJA80L(
+		const uint32_t,
+		const JablotronPayload &payload,
+		vector<SensorValue> &values)
+{
+	if (payload.has(JablotronPayload::KEY_BUTTON))
+		values.push_back({0, 1.0});
+	if (payload.has(JablotronPayload::KEY_TAMPER))
+		values.push_back({1, 1.0});
+
+	values.push_back({2, static_cast<double>(payload.get(JablotronPayload::KEY_BLACKOUT))});
+}
+
+/**
+ * Decoder of JA-81M and JA-83M.
+ */
+static void decodeMagnetic(
+		const uint32_t,
+		const JablotronPayload &payload,
+		vector<SensorValue> &values)
+{
+	if (payload.has(JablotronPayload::KEY_SENSOR))
+		values.push_back({0, static_cast<double>(payload.get(JablotronPayload::KEY_ACT))});
+	if (payload.has(JablotronPayload::KEY_TAMPER))
+		values.push_back({1, static_cast<double>(payload.get(JablotronPayload::KEY_ACT))});
+
+	values.push_back({2, static_cast<double>(payload.battery())});
+}
+
+/**
+ * Decoder of JA-82SH, JA-83P and JA-85ST.
+ */
+static void decodeDetector(
+		const uint32_t,
+		const JablotronPayload &payload,
+		vector<SensorValue> &values)
+{
+	if (payload.has(JablotronPayload::KEY_SENSOR))
+		values.push_back({0, 1.0});
+	if (payload.has(JablotronPayload::KEY_TAMPER))
+		values.push_back({1, static_cast<double>(payload.get(JablotronPayload::KEY_ACT))});
+
+	values.push_back({2, static_cast<double>(payload.battery())});
+}
+
+static void decodeRC86K(
+		const uint32_t address,
+		const JablotronPayload &payload,
+		vector<SensorValue> &values)
+{
+	if (!payload.has(JablotronPayload::KEY_PANIC)) {
+		const bool primary = address == JablotronGadget::Info::primaryAddress(address);
+		const ModuleID module = primary? 0 : 1;
+		values.push_back({module, static_cast<double>(payload.get(JablotronPayload::KEY_ARM))});
+	}
+	else {
+		values.push_back({2, 1.0});
+	}
+
+	values.push_back({3, static_cast<double>(payload.battery())});
+}
+
+static void decodeTP82N(
+		const uint32_t,
+		const JablotronPayload &payload,
+		vector<SensorValue> &values)
+{
+	if (payload.hasValue(JablotronPayload::KEY_INT))
+		values.push_back({0, payload.temperature(JablotronPayload::KEY_INT)});
+	if (payload.hasValue(JablotronPayload::KEY_SET))
+		values.push_back({1, payload.temperature(JablotronPayload::KEY_SET)});
+
+	values.push_back({2, static_cast<double>(payload.battery())});
+}
 
 const vector<JablotronGadget::Info> JablotronGadget::GADGETS = {
 	{0xcf0000, 0xcfffff,   AC88, REFRESH_TIME_NONE, {
 		{ModuleType::Type::TYPE_ON_OFF},
-	}},
+	}, decodeAC88},
 	{0x580000, 0x59ffff,  JA80L, REFRESH_TIME_NONE, {
 		{ModuleType::Type::TYPE_ON_OFF},
 		{ModuleType::Type::TYPE_SECURITY_ALERT},
 		{ModuleType::Type::TYPE_SECURITY_ALERT},
-	}},
+	}, decodeJA80L},
 	{0x180000, 0x1bffff,  JA81M, REFRESH_TIME_9MIN, {
 		{ModuleType::Type::TYPE_OPEN_CLOSE},
 		{ModuleType::Type::TYPE_SECURITY_ALERT},
 		{ModuleType::Type::TYPE_BATTERY},
-	}},
+	}, decodeMagnetic},
 	{0x7f0000, 0x7fffff, JA82SH, REFRESH_TIME_9MIN, {
 		{ModuleType::Type::TYPE_SHAKE},
 		{ModuleType::Type::TYPE_SECURITY_ALERT},
 		{ModuleType::Type::TYPE_BATTERY},
-	}},
+	}, decodeDetector},
 	{0x1c0000, 0x1dffff,  JA83M, REFRESH_TIME_9MIN, {
 		{ModuleType::Type::TYPE_OPEN_CLOSE},
 		{ModuleType::Type::TYPE_SECURITY_ALERT},
 		{ModuleType::Type::TYPE_BATTERY},
-	}},
+	}, decodeMagnetic},
 	{0x640000, 0x65ffff,  JA83P, REFRESH_TIME_9MIN, {
 		{ModuleType::Type::TYPE_MOTION},
 		{ModuleType::Type::TYPE_SECURITY_ALERT},
 		{ModuleType::Type::TYPE_BATTERY},
-	}},
+	}, decodeDetector},
 	{0x760000, 0x76ffff, JA85ST, REFRESH_TIME_9MIN, {
 		{ModuleType::Type::TYPE_FIRE},
 		{ModuleType::Type::TYPE_SECURITY_ALERT},
 		{ModuleType::Type::TYPE_BATTERY},
-	}},
+	}, decodeDetector},
 	{RC86K_FIRST, RC86K_LAST, RC86K,  REFRESH_TIME_NONE, {
 		{ModuleType::Type::TYPE_OPEN_CLOSE},
 		{ModuleType::Type::TYPE_OPEN_CLOSE},
 		{ModuleType::Type::TYPE_SECURITY_ALERT},
 		{ModuleType::Type::TYPE_BATTERY},
-	}},
+	}, decodeRC86K},
 	{0x240000, 0x25ffff, TP82N,  REFRESH_TIME_NONE, {
 		{ModuleType::Type::TYPE_TEMPERATURE, {
 			ModuleType::Attribute::ATTR_INNER,
@@ -69,7 +189,7 @@ const vector<JablotronGadget::Info> JablotronGadget::GADGETS = {
 			ModuleType::Attribute::ATTR_INNER
 		}},
 		{ModuleType::Type::TYPE_BATTERY},
-	}},
+	}, decodeTP82N},
 };
 
 JablotronGadget::Info::operator bool() const
@@ -110,98 +230,48 @@ string JablotronGadget::Info::name() const
 	}
 }
 
-JablotronGadget::Info JablotronGadget::Info::resolve(
+const JablotronGadget::Info &JablotronGadget::Info::resolve(
 		const uint32_t address)
 {
+	static const Info invalid = {0, 0, NONE, -1, {}, nullptr};
+
 	const auto primary = primaryAddress(address);
 
-	for (const auto &gadget : GADGETS) {
-		if (primary < gadget.firstAddress || gadget.lastAddress < primary)
-			continue;
+	const auto it = upper_bound(
+		begin(ADDRESS_RANGES), end(ADDRESS_RANGES), primary,
+		[](const uint32_t value, const AddressRange &range) {
+			return value < range.firstAddress;
+		});
 
-		return gadget;
-	}
+	if (it == begin(ADDRESS_RANGES))
+		return invalid;
+
+	const AddressRange &range = *(it - 1);
+	if (range.lastAddress < primary)
+		return invalid;
+
+	const Info &info = GADGETS[range.type];
+	poco_assert(info.type == range.type);
 
-	static const Info invalid = {0, 0, NONE, -1, {}};
-	return invalid;
+	return info;
 }
 
 vector<SensorValue> JablotronGadget::Info::parse(const JablotronReport &report) const
 {
 	vector<SensorValue> values;
-
-	switch (type) {
-	case JablotronGadget::AC88:
-		values.push_back({0, static_cast<double>(report.get("RELAY"))});
-		break;
-
-	case JablotronGadget::JA80L:
-		if (report.has("BUTTON"))
-			values.push_back({0, 1.0});
-		if (report.has("TAMPER"))
-			values.push_back({1, 1.0});
-
-		values.push_back({2, static_cast<double>(report.get("BLACKOUT"))});
-		break;
-
-	case JablotronGadget::JA81M:
-		if (report.has("SENSOR"))
-			values.push_back({0, static_cast<double>(report.get("ACT"))});
-		if (report.has("TAMPER"))
-			values.push_back({1, static_cast<double>(report.get("ACT"))});
-
-		values.push_back({2, static_cast<double>(report.battery())});
-		break;
-
-	case JablotronGadget::JA83M:
-		if (report.has("SENSOR"))
-			values.push_back({0, static_cast<double>(report.get("ACT"))});
-		if (report.has("TAMPER"))
-			values.push_back({1, static_cast<double>(report.get("ACT"))});
-
-		values.push_back({2, static_cast<double>(report.battery())});
-		break;
-
-	case JablotronGadget::JA82SH:
-	case JablotronGadget::JA83P:
-	case JablotronGadget::JA85ST:
-		if (report.has("SENSOR"))
-			values.push_back({0, 1.0});
-		if (report.has("TAMPER"))
-			values.push_back({1, static_cast<double>(report.get("ACT"))});
-
-		values.push_back({2, static_cast<double>(report.battery())});
-		break;
-
-	case JablotronGadget::RC86K:
-		if (!report.has("PANIC")) {
-			const bool primary = report.address == primaryAddress(report.address);
-			const ModuleID module = primary? 0 : 1;
-			values.push_back({module, static_cast<double>(report.get("ARM"))});
-		}
-		else {
-			values.push_back({2, 1.0});
-		}
-
-		values.push_back({3, static_cast<double>(report.battery())});
-		break;
-
-	case JablotronGadget::TP82N:
-		if (report.has("INT", true))
-			values.push_back({0, report.temperature("INT")});
-		if (report.has("SET", true))
-			values.push_back({1, report.temperature("SET")});
-
-		values.push_back({2, static_cast<double>(report.battery())});
-		break;
-
-	case JablotronGadget::NONE:
-		poco_assert(false);
-	}
-
+	decode(report.address, JablotronPayload::parse(report.data), values);
 	return values;
 }
 
+void JablotronGadget::Info::decode(
+		const uint32_t address,
+		const JablotronPayload &payload,
+		vector<SensorValue> &values) const
+{
+	poco_assert(decoder != nullptr);
+	decoder(address, payload, values);
+}
+
 uint32_t JablotronGadget::Info::primaryAddress(const uint32_t address)
 {
 	if (RC86K_SECONDARY_FIRST <= address && address <= RC86K_SECONDARY_LAST)
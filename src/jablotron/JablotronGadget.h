@@ -8,6 +8,7 @@
 
 #include "model/ModuleType.h"
 #include "model/SensorValue.h"
+#include "jablotron/JablotronPayload.h"
 #include "jablotron/JablotronReport.h"
 
 namespace BeeeOn {
@@ -37,11 +38,21 @@ public:
 	 * address range denotes a gadget device type.
 	 */
 	struct Info {
+		/**
+		 * @brief Converts the tokenized payload of a report coming from
+		 * the given address into values of the gadget's modules.
+		 */
+		typedef void (*Decoder)(
+			const uint32_t address,
+			const JablotronPayload &payload,
+			std::vector<SensorValue> &values);
+
 		const uint32_t firstAddress;
 		const uint32_t lastAddress;
 		const Type type;
 		const Poco::Timespan refreshTime;
 		const std::list<ModuleType> modules;
+		const Decoder decoder;
 
 		operator bool() const;
 		bool operator !() const;
@@ -54,9 +65,19 @@ public:
 		std::vector<SensorValue> parse(const JablotronReport &report) const;
 
 		/**
-		 * @returns gadget info instance based on the given address
+		 * @brief Converts the already tokenized payload of a report
+		 * coming from the given address.
+		 */
+		void decode(
+			const uint32_t address,
+			const JablotronPayload &payload,
+			std::vector<SensorValue> &values) const;
+
+		/**
+		 * @returns gadget info instance based on the given address,
+		 * the address ranges are looked up by a binary search
 		 */
-		static Info resolve(const uint32_t address);
+		static const Info &resolve(const uint32_t address);
 
 		/**
 		 * @returns primary address of the gadget which is usually the
@@ -93,6 +114,9 @@ private:
 	const uint32_t m_address;
 	const Info m_info;
 
+	/**
+	 * Information about gadget types indexed by JablotronGadget::Type.
+	 */
 	static const std::vector<Info> GADGETS;
 };
 
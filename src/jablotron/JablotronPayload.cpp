@@ -0,0 +1,180 @@
+#include <cstring>
+
+#include <Poco/Exception.h>
+
+#include "jablotron/JablotronPayload.h"
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+static const unsigned BATTERY_HIGH = 100;
+static const unsigned BATTERY_LOW  = 5;
+
+static const char DEGREE = static_cast<char>(0xb0);
+
+struct KeywordName {
+	const char *name;
+	size_t length;
+	JablotronPayload::Keyword keyword;
+};
+
+static const KeywordName KEYWORDS[] = {
+	{"ACT",      3, JablotronPayload::KEY_ACT},
+	{"ARM",      3, JablotronPayload::KEY_ARM},
+	{"BEACON",   6, JablotronPayload::KEY_BEACON},
+	{"BLACKOUT", 8, JablotronPayload::KEY_BLACKOUT},
+	{"BUTTON",   6, JablotronPayload::KEY_BUTTON},
+	{"INT",      3, JablotronPayload::KEY_INT},
+	{"LB",       2, JablotronPayload::KEY_LB},
+	{"PANIC",    5, JablotronPayload::KEY_PANIC},
+	{"RELAY",    5, JablotronPayload::KEY_RELAY},
+	{"SENSOR",   6, JablotronPayload::KEY_SENSOR},
+	{"SET",      3, JablotronPayload::KEY_SET},
+	{"TAMPER",   6, JablotronPayload::KEY_TAMPER},
+};
+
+static_assert(sizeof(KEYWORDS) / sizeof(KEYWORDS[0]) == JablotronPayload::KEY_COUNT,
+	"each keyword must have its name");
+
+static bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static int lookupKeyword(const char *name, size_t length)
+{
+	for (const auto &keyword : KEYWORDS) {
+		if (keyword.length == length && memcmp(keyword.name, name, length) == 0)
+			return keyword.keyword;
+	}
+
+	return -1;
+}
+
+/**
+ * Parse value in the format <code>-?[0-9][0-9]\.[0-9]\xb0C</code>.
+ * The temperature is computed from tenths of degree to obtain exactly
+ * the same value as NumberParser::parseFloat() does.
+ */
+static bool parseTemperature(const char *value, const char *end, double &result)
+{
+	const bool negative = value < end && *value == '-';
+	if (negative)
+		++value;
+
+	if (end - value < 6)
+		return false;
+
+	if (!isDigit(value[0]) || !isDigit(value[1]) || value[2] != '.' || !isDigit(value[3]))
+		return false;
+
+	if (value[4] != DEGREE || value[5] != 'C')
+		return false;
+
+	const int tenths = (value[0] - '0') * 100 + (value[1] - '0') * 10 + (value[3] - '0');
+	result = (negative ? -tenths : tenths) / 10.0;
+	return true;
+}
+
+JablotronPayload::JablotronPayload():
+	m_flags(0),
+	m_prefixed(0),
+	m_binary(0),
+	m_temperatures(0)
+{
+	for (auto &value : m_values)
+		value = 0;
+}
+
+bool JablotronPayload::has(Keyword keyword) const
+{
+	return m_flags & (1 << keyword);
+}
+
+bool JablotronPayload::hasValue(Keyword keyword) const
+{
+	return m_prefixed & (1 << keyword);
+}
+
+int JablotronPayload::get(Keyword keyword) const
+{
+	if (!(m_binary & (1 << keyword)))
+		throw NotFoundException("no value " + string(KEYWORDS[keyword].name));
+
+	return static_cast<int>(m_values[keyword]);
+}
+
+double JablotronPayload::temperature(Keyword keyword) const
+{
+	if (!(m_temperatures & (1 << keyword)))
+		throw NotFoundException("no value " + string(KEYWORDS[keyword].name));
+
+	return m_values[keyword];
+}
+
+unsigned int JablotronPayload::battery() const
+{
+	return get(KEY_LB) ? BATTERY_LOW : BATTERY_HIGH;
+}
+
+void JablotronPayload::parseToken(const char *token, const char *end)
+{
+	const char *colon = static_cast<const char *>(memchr(token, ':', end - token));
+	const char *nameEnd = colon == nullptr ? end : colon;
+
+	const int keyword = lookupKeyword(token, nameEnd - token);
+	if (keyword < 0)
+		return;
+
+	const uint32_t bit = 1 << keyword;
+
+	if (colon == nullptr) {
+		m_flags |= bit;
+		return;
+	}
+
+	m_prefixed |= bit;
+
+	// the first valid value of a keyword wins
+	if ((m_binary | m_temperatures) & bit)
+		return;
+
+	const char *value = colon + 1;
+
+	if (end - value == 1 && (*value == '0' || *value == '1')) {
+		m_values[keyword] = *value - '0';
+		m_binary |= bit;
+	}
+	else if (parseTemperature(value, end, m_values[keyword])) {
+		m_temperatures |= bit;
+	}
+}
+
+JablotronPayload JablotronPayload::parse(const string &data)
+{
+	JablotronPayload payload;
+
+	const char *p = data.data();
+	const char *end = p + data.size();
+
+	while (p < end) {
+		while (p < end && isSpace(*p))
+			++p;
+
+		const char *token = p;
+
+		while (p < end && !isSpace(*p))
+			++p;
+
+		if (token < p)
+			payload.parseToken(token, p);
+	}
+
+	return payload;
+}
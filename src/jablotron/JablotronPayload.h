@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace BeeeOn {
+
+/**
+ * @brief Payload of a JablotronReport tokenized in a single pass.
+ * Keywords known to the gadget decoders are remembered as flags
+ * (e.g. <code>SENSOR</code>), binary values (e.g. <code>ACT:1</code>)
+ * or temperatures (e.g. <code>INT:21.5\xb0C</code>). Unknown keywords
+ * are ignored. The accessors behave the same way as the equally
+ * named methods of JablotronReport but they do not search the payload
+ * again.
+ */
+class JablotronPayload {
+public:
+	enum Keyword {
+		KEY_ACT,
+		KEY_ARM,
+		KEY_BEACON,
+		KEY_BLACKOUT,
+		KEY_BUTTON,
+		KEY_INT,
+		KEY_LB,
+		KEY_PANIC,
+		KEY_RELAY,
+		KEY_SENSOR,
+		KEY_SET,
+		KEY_TAMPER,
+		KEY_COUNT,
+	};
+
+	JablotronPayload();
+
+	/**
+	 * @returns true if the payload contains the keyword without value
+	 */
+	bool has(Keyword keyword) const;
+
+	/**
+	 * @returns true if the payload contains the keyword followed by
+	 * a colon regardless of validity of the value
+	 */
+	bool hasValue(Keyword keyword) const;
+
+	/**
+	 * @returns value 0 or 1 associated with the given keyword
+	 * @throws Poco::NotFoundException if no such keyword with value
+	 * is present in the payload
+	 */
+	int get(Keyword keyword) const;
+
+	/**
+	 * @returns temperature associated with the given keyword
+	 * @throws Poco::NotFoundException if no such keyword with value
+	 * in the format <code>##.#\xb0C</code> is present in the payload
+	 */
+	double temperature(Keyword keyword) const;
+
+	/**
+	 * @returns battery status in percents based on the value of
+	 * <code>LB</code>
+	 * @throws Poco::NotFoundException if there is no <code>LB</code>
+	 */
+	unsigned int battery() const;
+
+	/**
+	 * @brief Tokenize the given payload data.
+	 */
+	static JablotronPayload parse(const std::string &data);
+
+private:
+	void parseToken(const char *token, const char *end);
+
+private:
+	uint32_t m_flags;
+	uint32_t m_prefixed;
+	uint32_t m_binary;
+	uint32_t m_temperatures;
+	double m_values[KEY_COUNT];
+};
+
+}
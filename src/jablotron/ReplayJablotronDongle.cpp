@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <Poco/Exception.h>
+#include <Poco/FileStream.h>
+#include <Poco/Logger.h>
+#include <Poco/NumberFormatter.h>
+#include <Poco/NumberParser.h>
+#include <Poco/RegularExpression.h>
+
+#include "di/Injectable.h"
+#include "io/AutoClose.h"
+#include "jablotron/JablotronController.h"
+#include "jablotron/ReplayJablotronDongle.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, ReplayJablotronDongle)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_PROPERTY("tracePath", &ReplayJablotronDongle::setTracePath)
+BEEEON_OBJECT_PROPERTY("speed", &ReplayJablotronDongle::setSpeed)
+BEEEON_OBJECT_PROPERTY("linkPath", &ReplayJablotronDongle::setLinkPath)
+BEEEON_OBJECT_END(BeeeOn, ReplayJablotronDongle)
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const string CMD_BEGIN = "\x1B";
+static const string CMD_END = "\n";
+static const string DONGLE_VERSION = "TURRIS DONGLE V1.4";
+static const unsigned int SLOT_COUNT = 32;
+static const Timespan POLL_TIMEOUT = 100 * Timespan::MILLISECONDS;
+
+ReplayJablotronDongle::ReplayJablotronDongle():
+	m_probed(false)
+{
+}
+
+void ReplayJablotronDongle::setTracePath(const string &path)
+{
+	m_tracePath = path;
+	m_replayer.setTracePath(path);
+}
+
+void ReplayJablotronDongle::setSpeed(int speed)
+{
+	m_replayer.setSpeed(speed);
+}
+
+void ReplayJablotronDongle::setLinkPath(const string &path)
+{
+	m_linkPath = path;
+}
+
+int ReplayJablotronDongle::openTerminal()
+{
+	const int fd = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (fd < 0)
+		throw IOException("posix_openpt: " + string(::strerror(errno)));
+
+	if (::grantpt(fd) < 0 || ::unlockpt(fd) < 0) {
+		const int error = errno;
+		::close(fd);
+		throw IOException("failed to unlock pseudo terminal: " + string(::strerror(error)));
+	}
+
+	const char *slave = ::ptsname(fd);
+	if (slave == nullptr) {
+		const int error = errno;
+		::close(fd);
+		throw IOException("ptsname: " + string(::strerror(error)));
+	}
+
+	// a stale link might be left by a previous run
+	::unlink(m_linkPath.c_str());
+
+	if (::symlink(slave, m_linkPath.c_str()) < 0) {
+		const int error = errno;
+		::close(fd);
+		throw IOException("failed to link " + m_linkPath + ": " + ::strerror(error));
+	}
+
+	logger().information(
+		"emulating Turris Dongle at " + m_linkPath + " -> " + slave,
+		__FILE__, __LINE__);
+
+	return fd;
+}
+
+void ReplayJablotronDongle::collectAddresses()
+{
+	static const RegularExpression pattern("^\\[([0-9]{8})\\]");
+
+	FileInputStream in(m_tracePath, ios::in | ios::binary);
+	InputTraceReader reader(in);
+	InputTraceRecord record;
+
+	while (reader.next(record) && m_addresses.size() < SLOT_COUNT) {
+		if (record.channel() != JablotronController::TRACE_CHANNEL)
+			continue;
+
+		RegularExpression::MatchVec m;
+		if (!pattern.match(record.payload(), 0, m))
+			continue;
+
+		const uint32_t address = NumberParser::parseUnsigned(
+			record.payload().substr(m[1].offset, m[1].length));
+
+		if (find(m_addresses.begin(), m_addresses.end(), address) == m_addresses.end())
+			m_addresses.emplace_back(address);
+	}
+
+	logger().information(
+		"trace contains " + to_string(m_addresses.size()) + " gadgets",
+		__FILE__, __LINE__);
+}
+
+void ReplayJablotronDongle::writeMessage(int fd, const string &message)
+{
+	const string data = "\n" + message + "\n";
+	size_t written = 0;
+
+	while (written < data.size()) {
+		const ssize_t ret = ::write(fd, data.data() + written, data.size() - written);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			throw IOException("failed to write to pseudo terminal: " + string(::strerror(errno)));
+
+		written += ret;
+	}
+}
+
+void ReplayJablotronDongle::handleRequest(int fd, const string &request)
+{
+	static const RegularExpression readSlot("^GET SLOT:([0-9][0-9])$");
+	RegularExpression::MatchVec m;
+
+	if (logger().debug())
+		logger().debug("request: " + request, __FILE__, __LINE__);
+
+	if (request == "WHO AM I?") {
+		writeMessage(fd, DONGLE_VERSION);
+		m_probed = true;
+	}
+	else if (readSlot.match(request, 0, m)) {
+		const string &slot = request.substr(m[1].offset, m[1].length);
+		const unsigned int i = NumberParser::parseUnsigned(slot);
+
+		if (i < m_addresses.size())
+			writeMessage(fd, "SLOT:" + slot + " [" + NumberFormatter::format0(m_addresses[i], 8) + "]");
+		else
+			writeMessage(fd, "SLOT:" + slot + " [--------]");
+	}
+	else {
+		writeMessage(fd, "OK");
+	}
+}
+
+void ReplayJablotronDongle::replay(int fd)
+{
+	while (!m_probed) {
+		m_stopControl.waitStoppable(POLL_TIMEOUT);
+		if (m_stopControl.shouldStop())
+			return;
+	}
+
+	m_replayer.replay(
+		JablotronController::TRACE_CHANNEL,
+		[&](const InputTraceRecord &record) {
+			writeMessage(fd, record.payload());
+		},
+		m_stopControl);
+}
+
+void ReplayJablotronDongle::run()
+{
+	StopControl::Run run(m_stopControl);
+
+	collectAddresses();
+
+	FdAutoClose fd(openTerminal());
+
+	m_replayThread.startFunc([&]() {
+		try {
+			replay(*fd);
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	});
+
+	try {
+		serve(*fd, run);
+	}
+	catch (...) {
+		m_stopControl.requestStop();
+		m_replayThread.join();
+		::unlink(m_linkPath.c_str());
+		throw;
+	}
+
+	m_replayThread.join();
+	::unlink(m_linkPath.c_str());
+}
+
+void ReplayJablotronDongle::serve(int fd, StopControl::Run &run)
+{
+	string buffer;
+
+	while (run) {
+		struct pollfd pfd = {fd, POLLIN, 0};
+
+		const int ret = ::poll(&pfd, 1, POLL_TIMEOUT.totalMilliseconds());
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			throw IOException("poll: " + string(::strerror(errno)));
+		if (ret == 0)
+			continue;
+
+		if (pfd.revents & POLLHUP) {
+			// nobody has opened the slave side yet
+			run.waitStoppable(POLL_TIMEOUT);
+			continue;
+		}
+
+		char data[256];
+		const ssize_t length = ::read(fd, data, sizeof(data));
+		if (length < 0 && (errno == EINTR || errno == EIO))
+			continue;
+		if (length < 0)
+			throw IOException("failed to read pseudo terminal: " + string(::strerror(errno)));
+
+		buffer.append(data, length);
+
+		size_t end;
+		while ((end = buffer.find(CMD_END)) != string::npos) {
+			const size_t begin = buffer.rfind(CMD_BEGIN, end);
+
+			if (begin != string::npos)
+				handleRequest(fd, buffer.substr(begin + 1, end - begin - 1));
+
+			buffer.erase(0, end + 1);
+		}
+	}
+}
+
+void ReplayJablotronDongle::stop()
+{
+	m_stopControl.requestStop();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <Poco/Thread.h>
+
+#include "loop/StopControl.h"
+#include "loop/StoppableRunnable.h"
+#include "util/InputTraceReplayer.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief ReplayJablotronDongle emulates the Turris Dongle on a pseudo
+ * terminal and sends reports recorded into an input trace through it.
+ * The slave side of the pseudo terminal is linked to the configured
+ * path. After the path is announced to the JablotronDeviceManager (e.g.
+ * via the PipeHotplugMonitor), the JablotronController probes it as
+ * a real serial port.
+ *
+ * The emulator answers the version request, reports addresses found
+ * in the trace as the contents of slots and confirms all other commands
+ * by OK. Replaying of the reports starts once the dongle is probed.
+ */
+class ReplayJablotronDongle :
+	public StoppableRunnable,
+	protected Loggable {
+public:
+	ReplayJablotronDongle();
+
+	void setTracePath(const std::string &path);
+
+	/**
+	 * Speed of replaying relative to the recorded timing,
+	 * 0 to replay as fast as possible.
+	 */
+	void setSpeed(int speed);
+
+	/**
+	 * Path where to create a symlink to the pseudo terminal.
+	 */
+	void setLinkPath(const std::string &path);
+
+	void run() override;
+	void stop() override;
+
+protected:
+	int openTerminal();
+	void collectAddresses();
+	void serve(int fd, StopControl::Run &run);
+	void handleRequest(int fd, const std::string &request);
+	void writeMessage(int fd, const std::string &message);
+	void replay(int fd);
+
+private:
+	std::string m_tracePath;
+	std::string m_linkPath;
+	InputTraceReplayer m_replayer;
+	std::vector<uint32_t> m_addresses;
+	std::atomic<bool> m_probed;
+	Poco::Thread m_replayThread;
+	StopControl m_stopControl;
+};
+
+}
@@ -1,13 +1,20 @@
+#include <cstdlib>
+
 #include <Poco/Net/RemoteSyslogChannel.h>
 
 #include "core/GatewayInfo.h"
 #include "di/DIDaemon.h"
 #include "util/PosixSignal.h"
+#include "util/SamplingProfiler.h"
+#include "util/StartupTracer.h"
 
 using namespace BeeeOn;
 
 int main(int argc, char **argv)
 {
+	// the tracer measures the startup since its creation
+	StartupTracer::instance();
+
 	About about;
 
 	about.requirePocoVersion = 0x01070000;
@@ -16,6 +23,17 @@ int main(int argc, char **argv)
 	about.version = GatewayInfo::version();
 	PosixSignal::handle("SIGUSR1", [](int) {});
 
+	// SIGUSR1 is used to interrupt blocking calls of threads,
+	// thus the profiler is toggled by SIGUSR2. The profiler is
+	// available only when the output file is configured.
+	const char *profilePath = std::getenv("BEEEON_PROFILE_PATH");
+	if (profilePath != nullptr && *profilePath != '\0') {
+		SamplingProfiler::instance().startToggleHandler(profilePath);
+		PosixSignal::handle("SIGUSR2", [](int) {
+			SamplingProfiler::requestToggle();
+		});
+	}
+
 	Poco::Net::RemoteSyslogChannel::registerChannel();
 	DIDaemon::up(argc, argv, about);
 }
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <Poco/Exception.h>
+
+#include "di/Injectable.h"
+#include "io/AutoClose.h"
+#include "net/PrometheusMetricsServer.h"
+#include "util/MetricsRegistry.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, PrometheusMetricsServer)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_PROPERTY("socketPath", &PrometheusMetricsServer::setSocketPath)
+BEEEON_OBJECT_PROPERTY("requestTimeout", &PrometheusMetricsServer::setRequestTimeout)
+BEEEON_OBJECT_END(BeeeOn, PrometheusMetricsServer)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+static const Timespan ACCEPT_TIMEOUT = 1 * Timespan::SECONDS;
+static const size_t REQUEST_BUFFER_SIZE = 1024;
+
+PrometheusMetricsServer::PrometheusMetricsServer():
+	m_requestTimeout(100 * Timespan::MILLISECONDS)
+{
+}
+
+PrometheusMetricsServer::~PrometheusMetricsServer()
+{
+}
+
+void PrometheusMetricsServer::setSocketPath(const string &path)
+{
+	m_socketPath = path;
+}
+
+void PrometheusMetricsServer::setRequestTimeout(const Timespan &timeout)
+{
+	if (timeout < 0)
+		throw InvalidArgumentException("request timeout must be non-negative");
+
+	m_requestTimeout = timeout;
+}
+
+int PrometheusMetricsServer::listen()
+{
+	struct sockaddr_un addr;
+
+	if (m_socketPath.empty() || m_socketPath.size() >= sizeof(addr.sun_path))
+		throw InvalidArgumentException("invalid socket path: " + m_socketPath);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, m_socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+	const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		throw IOException("failed to create socket: " + string(strerror(errno)));
+
+	::unlink(m_socketPath.c_str());
+
+	if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+		const int err = errno;
+		::close(fd);
+		throw IOException("failed to bind " + m_socketPath + ": " + strerror(err));
+	}
+
+	if (::listen(fd, 4) < 0) {
+		const int err = errno;
+		::close(fd);
+		throw IOException("failed to listen on " + m_socketPath + ": " + strerror(err));
+	}
+
+	return fd;
+}
+
+void PrometheusMetricsServer::run()
+{
+	StopControl::Run run(m_stopControl);
+
+	FdAutoClose server(listen());
+
+	logger().information("serving metrics at " + m_socketPath,
+		__FILE__, __LINE__);
+
+	while (run) {
+		struct pollfd pfd = {*server, POLLIN, 0};
+
+		const int ret = ::poll(&pfd, 1, ACCEPT_TIMEOUT.totalMilliseconds());
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			throw IOException("failed to poll metrics socket: " + string(strerror(errno)));
+		if (ret == 0)
+			continue;
+
+		const int client = ::accept4(*server, NULL, NULL, SOCK_CLOEXEC);
+		if (client < 0) {
+			logger().warning("failed to accept: " + string(strerror(errno)),
+				__FILE__, __LINE__);
+			continue;
+		}
+
+		FdAutoClose guard(client);
+
+		try {
+			serve(client);
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+
+	::unlink(m_socketPath.c_str());
+}
+
+void PrometheusMetricsServer::serve(int fd)
+{
+	char request[REQUEST_BUFFER_SIZE];
+	ssize_t length = 0;
+
+	struct pollfd pfd = {fd, POLLIN, 0};
+	if (::poll(&pfd, 1, m_requestTimeout.totalMilliseconds()) > 0)
+		length = ::recv(fd, request, sizeof(request), MSG_DONTWAIT);
+
+	ostringstream body;
+	MetricsRegistry::instance().print(body);
+
+	string response;
+
+	if (length >= 4 && strncmp(request, "GET ", 4) == 0) {
+		const string &content = body.str();
+
+		response = "HTTP/1.0 200 OK\r\n"
+			"Content-Type: text/plain; version=0.0.4\r\n"
+			"Content-Length: " + to_string(content.size()) + "\r\n"
+			"Connection: close\r\n"
+			"\r\n" + content;
+	}
+	else {
+		response = body.str();
+	}
+
+	// a client that does not read must not block the server,
+	// zero SO_SNDTIMEO would mean no timeout at all
+	const Timespan sendTimeout = max(m_requestTimeout,
+		Timespan(1 * Timespan::MILLISECONDS));
+
+	struct timeval timeout;
+	timeout.tv_sec = sendTimeout.totalSeconds();
+	timeout.tv_usec = sendTimeout.useconds();
+
+	if (::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0)
+		throw IOException("failed to set send timeout: " + string(strerror(errno)));
+
+	size_t written = 0;
+
+	while (written < response.size()) {
+		const ssize_t ret = ::send(fd, response.data() + written,
+			response.size() - written, MSG_NOSIGNAL);
+
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			throw TimeoutException("client does not read metrics");
+		if (ret < 0)
+			throw IOException("failed to write metrics: " + string(strerror(errno)));
+
+		written += ret;
+	}
+}
+
+void PrometheusMetricsServer::stop()
+{
+	m_stopControl.requestStop();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+#include <Poco/Timespan.h>
+
+#include "loop/StopControl.h"
+#include "loop/StoppableRunnable.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief PrometheusMetricsServer exposes contents of the MetricsRegistry
+ * in the Prometheus text format on a local Unix socket. The endpoint is
+ * read-only. A client that starts with an HTTP GET request (e.g.
+ * curl --unix-socket) receives an HTTP response, any other client
+ * (e.g. socat) receives just the plain text. Each connection is closed
+ * after the metrics are written.
+ */
+class PrometheusMetricsServer : public StoppableRunnable, protected Loggable {
+public:
+	PrometheusMetricsServer();
+	~PrometheusMetricsServer();
+
+	void setSocketPath(const std::string &path);
+
+	/**
+	 * Maximal time to wait for a request of a client before the metrics
+	 * are written in the plain text. Writing to a client that does not
+	 * read the metrics fails after the same timeout.
+	 */
+	void setRequestTimeout(const Poco::Timespan &timeout);
+
+	void run() override;
+	void stop() override;
+
+protected:
+	int listen();
+	void serve(int fd);
+
+private:
+	std::string m_socketPath;
+	Poco::Timespan m_requestTimeout;
+	StopControl m_stopControl;
+};
+
+}
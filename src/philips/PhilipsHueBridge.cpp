@@ -15,6 +15,8 @@
 
 #include "net/HTTPUtil.h"
 #include "philips/PhilipsHueBridge.h"
+#include "util/InputTrace.h"
+#include "util/InputTraceRecorder.h"
 #include "util/JsonUtil.h"
 
 #define MAX_ATTEMPTS 6
@@ -397,6 +399,18 @@ HTTPEntireResponse PhilipsHueBridge::sendRequest(HTTPRequest& request,
 	logger().debug("sending HTTP request to " + address.toString() +
 		request.getURI(), __FILE__, __LINE__);
 
-	return HTTPUtil::makeRequest(
+	HTTPEntireResponse response = HTTPUtil::makeRequest(
 		request, address.host().toString(), address.port(), message, timeout);
+
+	InputTraceRecorder &recorder = InputTraceRecorder::instance();
+	if (recorder.active()) {
+		InputTraceEncoder encoder;
+		encoder.putString(request.getMethod());
+		encoder.putString(request.getURI());
+		encoder.putString(response.getBody());
+
+		recorder.record("philipshue", encoder.data());
+	}
+
+	return response;
 }
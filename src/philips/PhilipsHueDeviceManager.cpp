@@ -29,6 +29,7 @@ BEEEON_OBJECT_CASTABLE(CommandHandler)
 BEEEON_OBJECT_CASTABLE(DeviceStatusHandler)
 BEEEON_OBJECT_PROPERTY("deviceCache", &PhilipsHueDeviceManager::setDeviceCache)
 BEEEON_OBJECT_PROPERTY("distributor", &PhilipsHueDeviceManager::setDistributor)
+BEEEON_OBJECT_PROPERTY("discoveryExecutor", &PhilipsHueDeviceManager::setDiscoveryExecutor)
 BEEEON_OBJECT_PROPERTY("commandDispatcher", &PhilipsHueDeviceManager::setCommandDispatcher)
 BEEEON_OBJECT_PROPERTY("upnpTimeout", &PhilipsHueDeviceManager::setUPnPTimeout)
 BEEEON_OBJECT_PROPERTY("httpTimeout", &PhilipsHueDeviceManager::setHTTPTimeout)
@@ -222,7 +223,7 @@ void PhilipsHueDeviceManager::handleGeneric(const Command::Ptr cmd, Result::Ptr
 AsyncWork<>::Ptr PhilipsHueDeviceManager::startDiscovery(const Timespan &timeout)
 {
 	PhilipsHueSeeker::Ptr seeker = new PhilipsHueSeeker(*this, timeout);
-	seeker->start();
+	startSeeker(seeker);
 
 	return seeker;
 }
@@ -510,7 +511,7 @@ void PhilipsHueDeviceManager::PhilipsHueSeeker::seekLoop(StopControl &control)
 	Timestamp now;
 	StopControl::Run run(control);
 
-	while (remaining() > 0) {
+	while (nextPass()) {
 		for (auto device : m_parent.seekBulbs(control)) {
 			if (!run)
 				break;
@@ -100,6 +100,20 @@ AsyncWork<>::Ptr PressureSensorManager::startDiscovery(const Timespan &)
 	return BlockingAsyncWork<>::instance();
 }
 
+bool PressureSensorManager::accept(const Command::Ptr cmd)
+{
+	if (!DeviceManager::accept(cmd))
+		return false;
+
+	if (cmd->is<DeviceAcceptCommand>())
+		return cmd.cast<DeviceAcceptCommand>()->deviceID() == pairedID();
+
+	if (cmd->is<DeviceUnpairCommand>())
+		return cmd.cast<DeviceUnpairCommand>()->deviceID() == pairedID();
+
+	return true;
+}
+
 void PressureSensorManager::handleAccept(const DeviceAcceptCommand::Ptr cmd)
 {
 	if (cmd->deviceID() != pairedID())
@@ -52,6 +52,12 @@ public:
 	 */
 	void setUnit(const std::string &unit);
 
+	/**
+	 * @brief Accept device commands only for the configured sensor
+	 * as the prefix is shared with the IIOSensorManager.
+	 */
+	bool accept(const Command::Ptr cmd) override;
+
 	/**
 	 * @brief Wake-up the main thread when received new status.
 	 */
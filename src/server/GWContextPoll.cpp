@@ -1,9 +1,12 @@
 #include "server/GWContextPoll.h"
+#include "util/AllocationTracker.h"
 
 using namespace std;
 using namespace Poco;
 using namespace BeeeOn;
 
+static const AllocationTag CONTEXTS_TAG("gws.contexts");
+
 GWContextPoll::~GWContextPoll()
 {
 	clear();
@@ -11,6 +14,7 @@ GWContextPoll::~GWContextPoll()
 
 void GWContextPoll::insert(GWMessageContext::Ptr context)
 {
+	AllocationScope scope(CONTEXTS_TAG);
 	FastMutex::ScopedLock guard(m_mutex);
 	m_messages.emplace(context->id(), context);
 }
@@ -10,6 +10,7 @@
 #include "commands/ServerDeviceListResult.h"
 #include "commands/ServerLastValueResult.h"
 #include "core/CommandDispatcher.h"
+#include "core/StageLatency.h"
 #include "di/Injectable.h"
 #include "gwmessage/GWDeviceListRequest.h"
 #include "gwmessage/GWDeviceListResponse.h"
@@ -22,6 +23,10 @@
 #include "gwmessage/GWSensorDataConfirm.h"
 #include "server/GWServerConnector.h"
 #include "server/ServerAnswer.h"
+#include "util/AllocationTracker.h"
+#include "util/MetricsRegistry.h"
+#include "util/SamplingProfiler.h"
+#include "util/StartupTracer.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, GWServerConnector)
 BEEEON_OBJECT_CASTABLE(StoppableLoop)
@@ -40,6 +45,7 @@ BEEEON_OBJECT_PROPERTY("inactiveMultiplier", &GWServerConnector::setInactiveMult
 BEEEON_OBJECT_PROPERTY("sslConfig", &GWServerConnector::setSSLConfig)
 BEEEON_OBJECT_PROPERTY("gatewayInfo", &GWServerConnector::setGatewayInfo)
 BEEEON_OBJECT_PROPERTY("commandDispatcher", &GWServerConnector::setCommandDispatcher)
+BEEEON_OBJECT_PROPERTY("lastValueForwarded", &GWServerConnector::setLastValueForwarded)
 BEEEON_OBJECT_END(BeeeOn, GWServerConnector)
 
 using namespace std;
@@ -47,6 +53,18 @@ using namespace Poco;
 using namespace Poco::Net;
 using namespace BeeeOn;
 
+static const AllocationTag GWS_TAG("gws");
+
+static void recordStageLatency(StageLatency::Stage stage, GWMessage::Ptr message)
+{
+	GWSensorDataExport::Ptr dataExport = message.cast<GWSensorDataExport>();
+	if (dataExport.isNull())
+		return;
+
+	for (const auto &data : dataExport->data())
+		StageLatency::instance().record(stage, data);
+}
+
 GWServerConnector::GWServerConnector():
 	m_port(0),
 	m_pollTimeout(250 * Timespan::MILLISECONDS),
@@ -57,10 +75,27 @@ GWServerConnector::GWServerConnector():
 	m_resendTimeout(20 * Timespan::SECONDS),
 	m_maxMessageSize(4096),
 	m_inactiveMultiplier(5),
+	m_lastValueForwarded(false),
 	m_receiveBuffer(m_maxMessageSize),
 	m_isConnected(false),
 	m_stop(false),
-	m_outputQueue(readyToSendEvent())
+	m_outputQueue(readyToSendEvent()),
+	m_firstExportTraced(false),
+	m_exportsCounter(MetricsRegistry::instance().counter(
+		"beeeon_gws_exports_total",
+		"Sensor data export messages sent to server")),
+	m_confirmsCounter(MetricsRegistry::instance().counter(
+		"beeeon_gws_confirms_total",
+		"Sensor data exports confirmed by server")),
+	m_resendsCounter(MetricsRegistry::instance().counter(
+		"beeeon_gws_resends_total",
+		"Messages scheduled for resend due to missing response")),
+	m_reconnectsCounter(MetricsRegistry::instance().counter(
+		"beeeon_gws_reconnects_total",
+		"Successful (re)connections to server")),
+	m_connectedGauge(MetricsRegistry::instance().gauge(
+		"beeeon_gws_connected",
+		"Whether the connection to server is established"))
 {
 }
 
@@ -94,6 +129,8 @@ void GWServerConnector::stop()
 void GWServerConnector::startSender()
 {
 	m_senderThread.startFunc([this](){
+		SamplingProfiler::labelThread("gws-sender");
+		AllocationTracker::tagThread(GWS_TAG);
 		runSender();
 	});
 }
@@ -146,12 +183,16 @@ void GWServerConnector::forwardContext(GWMessageContext::Ptr context)
 		GWTimedContext::Ptr timedContext = context.cast<GWTimedContext>();
 
 		const GlobalID &id = timedContext->id();
+		// a task has already been set when the message is being resent
+		const bool resent = !timedContext->missingResponseTask().isNull();
 
 		LambdaTimerTask::Ptr task = new LambdaTimerTask(
 			[this, id](){
 				GWMessageContext::Ptr context = m_contextPoll.remove(id);
-				if (!context.isNull())
+				if (!context.isNull()) {
+					m_resendsCounter.inc();
 					m_outputQueue.enqueue(context);
+				}
 			}
 		);
 
@@ -169,6 +210,18 @@ void GWServerConnector::forwardContext(GWMessageContext::Ptr context)
 			e.rethrow();
 		}
 
+		if (!timedContext->message().cast<GWSensorDataExport>().isNull()) {
+			m_exportsCounter.inc();
+
+			if (!m_firstExportTraced) {
+				StartupTracer::instance().mark("first-export");
+				m_firstExportTraced = true;
+			}
+		}
+
+		if (!resent)
+			recordStageLatency(StageLatency::GWS_SEND, timedContext->message());
+
 		m_timer.schedule(task, Timestamp() + m_resendTimeout);
 	}
 	else if (!context.isNull()) {
@@ -197,11 +250,16 @@ void GWServerConnector::reconnect()
 	connectAndRegisterUnlocked();
 	m_isConnected = true;
 	m_connectedEvent.set();
+
+	m_reconnectsCounter.inc();
+	m_connectedGauge.set(1);
 }
 
 void GWServerConnector::startReceiver()
 {
 	m_receiverThread.startFunc([this](){
+		SamplingProfiler::labelThread("gws-receiver");
+		AllocationTracker::tagThread(GWS_TAG);
 		runReceiver();
 	});
 }
@@ -382,6 +440,7 @@ void GWServerConnector::disconnectUnlocked()
 {
 	if (!m_socket.isNull()) {
 		m_socket = nullptr;
+		m_connectedGauge.set(0);
 
 		logger().information("disconnected", __FILE__, __LINE__);
 	}
@@ -519,6 +578,11 @@ void GWServerConnector::setInactiveMultiplier(int multiplier)
 	m_inactiveMultiplier = multiplier;
 }
 
+void GWServerConnector::setLastValueForwarded(bool forwarded)
+{
+	m_lastValueForwarded = forwarded;
+}
+
 bool GWServerConnector::ship(const SensorData &data)
 {
 	if (!m_isConnected)
@@ -543,7 +607,7 @@ bool GWServerConnector::accept(const Command::Ptr cmd)
 {
 	return cmd->is<NewDeviceCommand>()
 		|| cmd->is<ServerDeviceListCommand>()
-		|| cmd->is<ServerLastValueCommand>();
+		|| (cmd->is<ServerLastValueCommand>() && !m_lastValueForwarded);
 }
 
 void GWServerConnector::handle(Command::Ptr cmd, Answer::Ptr answer)
@@ -745,7 +809,12 @@ void GWServerConnector::handleResponse(GWResponse::Ptr response)
 
 void GWServerConnector::handleSensorDataConfirm(GWSensorDataConfirm::Ptr confirm)
 {
-	m_contextPoll.remove(confirm->id());
+	GWMessageContext::Ptr context = m_contextPoll.remove(confirm->id());
+	if (context.isNull())
+		return;
+
+	m_confirmsCounter.inc();
+	recordStageLatency(StageLatency::GWS_CONFIRM, context->message());
 }
 
 void GWServerConnector::handleAck(GWAck::Ptr ack)
@@ -37,6 +37,9 @@
 
 namespace BeeeOn {
 
+class MetricCounter;
+class MetricGauge;
+
 /**
  * @brief The GWServerConnector allows the BeeeOn Gateway to communicate
  * with the BeeeOn Server using WebSocket. It automatically connects
@@ -73,6 +76,13 @@ public:
 	void setSSLConfig(Poco::SharedPtr<SSLClient> config);
 	void setInactiveMultiplier(int multiplier);
 
+	/**
+	 * @brief ServerLastValueCommand is not accepted when it is forwarded
+	 * to the connector by another handler (LastValueStore) that decides
+	 * whether the value must be requested from the server.
+	 */
+	void setLastValueForwarded(bool forwarded);
+
 	bool accept(const Command::Ptr cmd) override;
 	void handle(Command::Ptr cmd, Answer::Ptr answer) override;
 
@@ -222,6 +232,7 @@ private:
 	Poco::Timestamp m_lastReceived;
 	Poco::FastMutex m_lastReceivedMutex;
 	int m_inactiveMultiplier;
+	bool m_lastValueForwarded;
 
 	Poco::FastMutex m_dispatchLock;
 
@@ -241,6 +252,17 @@ private:
 	GWContextPoll m_contextPoll;
 	GWSOutputQueue m_outputQueue;
 	Poco::Util::Timer m_timer;
+
+	/**
+	 * Accessed only by the sender thread.
+	 */
+	bool m_firstExportTraced;
+
+	MetricCounter &m_exportsCounter;
+	MetricCounter &m_confirmsCounter;
+	MetricCounter &m_resendsCounter;
+	MetricCounter &m_reconnectsCounter;
+	MetricGauge &m_connectedGauge;
 };
 
 }
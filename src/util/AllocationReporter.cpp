@@ -0,0 +1,84 @@
+#include <sstream>
+
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/StringTokenizer.h>
+
+#include "di/Injectable.h"
+#include "util/AllocationReporter.h"
+#include "util/MetricsRegistry.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, AllocationReporter)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_PROPERTY("interval", &AllocationReporter::setInterval)
+BEEEON_OBJECT_END(BeeeOn, AllocationReporter)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+AllocationReporter::AllocationReporter():
+	m_interval(1 * Timespan::HOURS)
+{
+}
+
+void AllocationReporter::setInterval(const Timespan &interval)
+{
+	if (interval <= 0)
+		throw InvalidArgumentException("interval must be positive");
+
+	m_interval = interval;
+}
+
+void AllocationReporter::report(const AllocationSnapshot &current)
+{
+	MetricsRegistry &metrics = MetricsRegistry::instance();
+
+	for (const auto &pair : current.tags()) {
+		metrics.gauge(
+			"beeeon_heap_live_bytes",
+			"Bytes allocated and not yet freed per subsystem",
+			{{"tag", pair.first}}).set(pair.second.liveBytes());
+	}
+
+	ostringstream out;
+	current.diff(m_previous, out);
+
+	logger().information(
+		"heap live " + to_string(current.liveBytes()) + " B, changes since "
+		+ to_string((current.at() - m_previous.at()) / Timespan::SECONDS) + " s:",
+		__FILE__, __LINE__);
+
+	StringTokenizer lines(out.str(), "\n", StringTokenizer::TOK_IGNORE_EMPTY);
+	for (const auto &line : lines)
+		logger().information(line, __FILE__, __LINE__);
+
+	m_previous = current;
+}
+
+void AllocationReporter::run()
+{
+	StopControl::Run run(m_stopControl);
+
+	if (!AllocationTracker::enabled()) {
+		logger().warning(
+			"allocation tracking is not built in, configure with ENABLE_ALLOC_TRACKING",
+			__FILE__, __LINE__);
+		return;
+	}
+
+	m_previous = AllocationTracker::snapshot();
+
+	while (run) {
+		run.waitStoppable(m_interval);
+		if (!run)
+			break;
+
+		report(AllocationTracker::snapshot());
+	}
+}
+
+void AllocationReporter::stop()
+{
+	m_stopControl.requestStop();
+}
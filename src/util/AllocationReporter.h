@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Poco/Timespan.h>
+
+#include "loop/StopControl.h"
+#include "loop/StoppableRunnable.h"
+#include "util/AllocationTracker.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief AllocationReporter periodically takes a snapshot of the
+ * AllocationTracker and logs changes since the previous one. Live
+ * bytes of each tag are published as the metric beeeon_heap_live_bytes
+ * so a slow growth can be observed over days of running. When tracking
+ * of allocations is disabled, the reporter just logs a warning and exits.
+ */
+class AllocationReporter : public StoppableRunnable, protected Loggable {
+public:
+	AllocationReporter();
+
+	void setInterval(const Poco::Timespan &interval);
+
+	void run() override;
+	void stop() override;
+
+protected:
+	void report(const AllocationSnapshot &current);
+
+private:
+	Poco::Timespan m_interval;
+	AllocationSnapshot m_previous;
+	StopControl m_stopControl;
+};
+
+}
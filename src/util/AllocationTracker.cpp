@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "util/AllocationTracker.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+struct TagCounters {
+	atomic<UInt64> allocations;
+	atomic<UInt64> deallocations;
+	atomic<UInt64> allocatedBytes;
+	atomic<UInt64> freedBytes;
+};
+
+/**
+ * All the state is constant-initialized so it is usable by
+ * allocations made during initialization of static objects.
+ */
+static TagCounters counters[AllocationTracker::MAX_TAGS];
+static const char *tagNames[AllocationTracker::MAX_TAGS] = {"untagged"};
+static atomic<unsigned int> tagCount(1);
+static atomic_flag tagLock = ATOMIC_FLAG_INIT;
+static thread_local unsigned int currentTag = 0;
+
+#ifdef HAVE_ALLOC_TRACKING
+
+/**
+ * Header preceding each tracked allocation. Its size keeps
+ * the alignment of the returned memory as given by malloc().
+ */
+struct AllocationHeader {
+	UInt64 size;
+	UInt32 tag;
+	UInt32 magic;
+};
+
+static_assert(sizeof(AllocationHeader) == 16, "unexpected size of AllocationHeader");
+
+static const UInt32 HEADER_MAGIC = 0xbeee0a11;
+
+static void *trackedAlloc(size_t size)
+{
+	AllocationHeader *header = static_cast<AllocationHeader *>(
+		::malloc(sizeof(AllocationHeader) + size));
+	if (header == nullptr)
+		return nullptr;
+
+	const unsigned int tag = currentTag;
+
+	header->size = size;
+	header->tag = tag;
+	header->magic = HEADER_MAGIC;
+
+	counters[tag].allocations.fetch_add(1, memory_order_relaxed);
+	counters[tag].allocatedBytes.fetch_add(size, memory_order_relaxed);
+
+	return header + 1;
+}
+
+static void trackedFree(void *p)
+{
+	if (p == nullptr)
+		return;
+
+	AllocationHeader *header = static_cast<AllocationHeader *>(p) - 1;
+
+	if (header->magic != HEADER_MAGIC)
+		::abort(); // freeing memory not allocated by operator new
+
+	const unsigned int tag = header->tag;
+	header->magic = 0;
+
+	counters[tag].deallocations.fetch_add(1, memory_order_relaxed);
+	counters[tag].freedBytes.fetch_add(header->size, memory_order_relaxed);
+
+	::free(header);
+}
+
+static void *allocOrThrow(size_t size)
+{
+	while (true) {
+		void *p = trackedAlloc(size);
+		if (p != nullptr)
+			return p;
+
+		new_handler handler = get_new_handler();
+		if (handler == nullptr)
+			throw bad_alloc();
+
+		handler();
+	}
+}
+
+void *operator new(size_t size)
+{
+	return allocOrThrow(size);
+}
+
+void *operator new[](size_t size)
+{
+	return allocOrThrow(size);
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+	try {
+		return allocOrThrow(size);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+	try {
+		return allocOrThrow(size);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+
+void operator delete(void *p) noexcept
+{
+	trackedFree(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	trackedFree(p);
+}
+
+void operator delete(void *p, const nothrow_t &) noexcept
+{
+	trackedFree(p);
+}
+
+void operator delete[](void *p, const nothrow_t &) noexcept
+{
+	trackedFree(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	trackedFree(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	trackedFree(p);
+}
+
+#endif
+
+AllocationTag::AllocationTag(const char *name):
+	m_index(AllocationTracker::registerTag(name))
+{
+}
+
+unsigned int AllocationTag::index() const
+{
+	return m_index;
+}
+
+const char *AllocationTag::name() const
+{
+	return AllocationTracker::tagName(m_index);
+}
+
+AllocationScope::AllocationScope(const AllocationTag &tag):
+	m_previous(AllocationTracker::enterScope(tag.index()))
+{
+}
+
+AllocationScope::~AllocationScope()
+{
+	AllocationTracker::leaveScope(m_previous);
+}
+
+Int64 AllocationStats::liveBlocks() const
+{
+	return static_cast<Int64>(allocations) - static_cast<Int64>(deallocations);
+}
+
+Int64 AllocationStats::liveBytes() const
+{
+	return static_cast<Int64>(allocatedBytes) - static_cast<Int64>(freedBytes);
+}
+
+AllocationSnapshot::AllocationSnapshot():
+	m_at(0)
+{
+}
+
+AllocationSnapshot::AllocationSnapshot(
+		const Timestamp &at,
+		const map<string, AllocationStats> &tags):
+	m_at(at),
+	m_tags(tags)
+{
+}
+
+Timestamp AllocationSnapshot::at() const
+{
+	return m_at;
+}
+
+const map<string, AllocationStats> &AllocationSnapshot::tags() const
+{
+	return m_tags;
+}
+
+AllocationStats AllocationSnapshot::stats(const string &tag) const
+{
+	auto it = m_tags.find(tag);
+	if (it == m_tags.end())
+		return AllocationStats();
+
+	return it->second;
+}
+
+Int64 AllocationSnapshot::liveBytes() const
+{
+	Int64 bytes = 0;
+
+	for (const auto &pair : m_tags)
+		bytes += pair.second.liveBytes();
+
+	return bytes;
+}
+
+static string signedString(Int64 value)
+{
+	return (value >= 0 ? "+" : "") + to_string(value);
+}
+
+void AllocationSnapshot::diff(
+		const AllocationSnapshot &before,
+		ostream &out) const
+{
+	struct Row {
+		string tag;
+		AllocationStats now;
+		AllocationStats then;
+
+		Int64 growth() const
+		{
+			return now.liveBytes() - then.liveBytes();
+		}
+	};
+
+	vector<Row> rows;
+
+	for (const auto &pair : m_tags)
+		rows.push_back({pair.first, pair.second, before.stats(pair.first)});
+
+	stable_sort(rows.begin(), rows.end(),
+		[](const Row &a, const Row &b) {
+			return a.growth() > b.growth();
+		});
+
+	for (const auto &row : rows) {
+		out << row.tag
+			<< " live " << row.now.liveBytes()
+			<< " (" << signedString(row.growth()) << ")"
+			<< " blocks " << row.now.liveBlocks()
+			<< " (" << signedString(row.now.liveBlocks() - row.then.liveBlocks()) << ")"
+			<< " allocs " << (row.now.allocations - row.then.allocations)
+			<< "\n";
+	}
+}
+
+bool AllocationTracker::enabled()
+{
+#ifdef HAVE_ALLOC_TRACKING
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AllocationTracker::tagThread(const AllocationTag &tag)
+{
+	currentTag = tag.index();
+}
+
+unsigned int AllocationTracker::registerTag(const char *name)
+{
+	while (tagLock.test_and_set(memory_order_acquire))
+		; // registration happens rarely, mostly during startup
+
+	const unsigned int count = tagCount.load(memory_order_relaxed);
+	unsigned int index = count;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		if (::strcmp(tagNames[i], name) == 0) {
+			index = i;
+			break;
+		}
+	}
+
+	if (index == count) {
+		if (count < MAX_TAGS) {
+			tagNames[index] = name;
+			tagCount.store(count + 1, memory_order_release);
+		}
+		else {
+			index = 0; // too many tags, attributed to "untagged"
+		}
+	}
+
+	tagLock.clear(memory_order_release);
+	return index;
+}
+
+const char *AllocationTracker::tagName(unsigned int index)
+{
+	return tagNames[index];
+}
+
+unsigned int AllocationTracker::enterScope(unsigned int index)
+{
+	const unsigned int previous = currentTag;
+	currentTag = index;
+	return previous;
+}
+
+void AllocationTracker::leaveScope(unsigned int previous)
+{
+	currentTag = previous;
+}
+
+AllocationSnapshot AllocationTracker::snapshot()
+{
+	const unsigned int count = tagCount.load(memory_order_acquire);
+	map<string, AllocationStats> tags;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		AllocationStats &stats = tags[tagNames[i]];
+
+		stats.allocations = counters[i].allocations.load(memory_order_relaxed);
+		stats.deallocations = counters[i].deallocations.load(memory_order_relaxed);
+		stats.allocatedBytes = counters[i].allocatedBytes.load(memory_order_relaxed);
+		stats.freedBytes = counters[i].freedBytes.load(memory_order_relaxed);
+	}
+
+	return AllocationSnapshot(Timestamp(), tags);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include <Poco/Timestamp.h>
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Tag of a subsystem to which heap allocations are attributed.
+ * Tags are expected to be defined as static objects, e.g.:
+ *
+ *   static const AllocationTag TAG("journal");
+ *
+ * The name must have static storage duration. Tags of the same name
+ * share the same counters.
+ */
+class AllocationTag {
+public:
+	AllocationTag(const char *name);
+
+	unsigned int index() const;
+	const char *name() const;
+
+private:
+	unsigned int m_index;
+};
+
+/**
+ * @brief Attributes all allocations made by the current thread to the
+ * given tag while the scope exists. Scopes can be nested, the innermost
+ * one wins. When no scope exists, the tag of the thread is used.
+ */
+class AllocationScope {
+public:
+	AllocationScope(const AllocationTag &tag);
+	~AllocationScope();
+
+	AllocationScope(const AllocationScope &) = delete;
+	AllocationScope &operator =(const AllocationScope &) = delete;
+
+private:
+	unsigned int m_previous;
+};
+
+/**
+ * @brief Counters of a single tag.
+ */
+struct AllocationStats {
+	Poco::UInt64 allocations = 0;
+	Poco::UInt64 deallocations = 0;
+	Poco::UInt64 allocatedBytes = 0;
+	Poco::UInt64 freedBytes = 0;
+
+	/**
+	 * Allocations might be freed under another tag than they were
+	 * allocated with (e.g. a buffer passed between threads). Thus,
+	 * the live values of a single tag might be negative.
+	 */
+	Poco::Int64 liveBlocks() const;
+	Poco::Int64 liveBytes() const;
+};
+
+/**
+ * @brief Counters of all tags at a certain time.
+ */
+class AllocationSnapshot {
+public:
+	AllocationSnapshot();
+	AllocationSnapshot(
+		const Poco::Timestamp &at,
+		const std::map<std::string, AllocationStats> &tags);
+
+	Poco::Timestamp at() const;
+	const std::map<std::string, AllocationStats> &tags() const;
+
+	/**
+	 * @returns stats of the given tag or zeros if the tag is unknown
+	 */
+	AllocationStats stats(const std::string &tag) const;
+
+	Poco::Int64 liveBytes() const;
+
+	/**
+	 * Write a human-readable report of changes since the given
+	 * older snapshot, one tag per line ordered by growth of live
+	 * bytes (the biggest growth first):
+	 *
+	 *   <tag> live <bytes> (<+-delta>) blocks <count> (<+-delta>) allocs <count>
+	 */
+	void diff(const AllocationSnapshot &before, std::ostream &out) const;
+
+private:
+	Poco::Timestamp m_at;
+	std::map<std::string, AllocationStats> m_tags;
+};
+
+/**
+ * @brief Opt-in accounting of heap allocations per subsystem tag.
+ *
+ * The tracking is available only in builds configured with
+ * ENABLE_ALLOC_TRACKING (off by default). Such builds replace
+ * the global operators new and delete and each allocation carries
+ * a small header with its size and tag so it is attributed correctly
+ * when freed. Otherwise, tags and scopes are no-ops and snapshots
+ * report no allocations.
+ */
+class AllocationTracker {
+public:
+	enum {
+		MAX_TAGS = 64,
+	};
+
+	/**
+	 * @returns true when the gateway is built with allocation tracking
+	 */
+	static bool enabled();
+
+	/**
+	 * Set the default tag of the calling thread. It is used
+	 * for allocations outside of any AllocationScope.
+	 */
+	static void tagThread(const AllocationTag &tag);
+
+	static AllocationSnapshot snapshot();
+
+private:
+	friend class AllocationTag;
+	friend class AllocationScope;
+
+	static unsigned int registerTag(const char *name);
+	static const char *tagName(unsigned int index);
+	static unsigned int enterScope(unsigned int index);
+	static void leaveScope(unsigned int previous);
+};
+
+}
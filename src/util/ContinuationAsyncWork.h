@@ -0,0 +1,400 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <list>
+
+#include <Poco/Event.h>
+#include <Poco/Exception.h>
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
+
+#include "util/AsyncWork.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief ContinuationAsyncWork is an AsyncWork completed explicitly by
+ * its producer via complete(), fail() or cancel(). It does not own any
+ * thread. Instead of blocking in tryJoin(), its consumer can register
+ * callbacks by onComplete() or compose dependent steps by then() and
+ * thenAsync(). The callbacks are called by the thread that completes
+ * the work (or immediately when registered after completion), thus
+ * they should not block.
+ *
+ * Failure and cancellation propagate to the dependent steps. Cancelling
+ * a dependent step cancels the work it depends on.
+ */
+template <typename Result = Poco::Void>
+class ContinuationAsyncWork : public AsyncWork<Result>, protected Loggable {
+	template <typename Other>
+	friend class ContinuationAsyncWork;
+public:
+	typedef Poco::SharedPtr<ContinuationAsyncWork<Result>> Ptr;
+	typedef std::function<void(ContinuationAsyncWork<Result> &)> Callback;
+
+	enum State {
+		RUNNING,
+		SUCCEEDED,
+		FAILED,
+		CANCELLED,
+	};
+
+	ContinuationAsyncWork();
+	~ContinuationAsyncWork();
+
+	/**
+	 * @brief Set hook called when the work is cancelled while running.
+	 * The producer can stop the underlying operation there.
+	 */
+	void setCancelHook(const std::function<void()> &hook);
+
+	/**
+	 * @brief Finish the work successfully with the given result.
+	 * @returns false when the work has already finished
+	 */
+	bool complete(const Result &result);
+
+	/**
+	 * @brief Finish the work as failed by the given exception.
+	 * @returns false when the work has already finished
+	 */
+	bool fail(const Poco::Exception &e);
+
+	void cancel() override;
+	bool tryJoin(const Poco::Timespan &timeout) override;
+
+	State state() const;
+	bool finished() const;
+
+	/**
+	 * @brief Throw the exception that has failed the work.
+	 * @throws Poco::IllegalStateException when not failed
+	 */
+	void rethrow() const;
+
+	/**
+	 * @brief Register callback to be called once the work finishes
+	 * in any way.
+	 */
+	void onComplete(const Callback &callback);
+
+	/**
+	 * @brief Create work finished by the given step applied to the
+	 * result of this work. Exception thrown by the step fails the
+	 * created work.
+	 */
+	template <typename Next>
+	typename ContinuationAsyncWork<Next>::Ptr then(
+		const std::function<Next(const Result &)> &step);
+
+	/**
+	 * @brief Create work finished together with the asynchronous
+	 * step started with the result of this work.
+	 */
+	template <typename Next>
+	typename ContinuationAsyncWork<Next>::Ptr thenAsync(
+		const std::function<typename ContinuationAsyncWork<Next>::Ptr(const Result &)> &step);
+
+	/**
+	 * @returns hook cancelling this work as long as it exists,
+	 * it is safe to be called after this work is destroyed
+	 */
+	std::function<void()> cancelLink();
+
+protected:
+	/**
+	 * @brief Wake up joiners and call callbacks of the just
+	 * finished work.
+	 */
+	void notify(std::list<Callback> &callbacks);
+
+	/**
+	 * @brief Make the given work finish the same way as this one.
+	 */
+	template <typename Other>
+	void propagate(ContinuationAsyncWork<Other> &other) const;
+
+private:
+	struct Link {
+		Poco::Mutex lock;
+		ContinuationAsyncWork<Result> *work;
+	};
+
+	mutable Poco::FastMutex m_lock;
+	State m_state;
+	Poco::SharedPtr<Poco::Exception> m_error;
+	std::function<void()> m_cancelHook;
+	std::list<Callback> m_callbacks;
+	Poco::Event m_finished;
+	Poco::SharedPtr<Link> m_link;
+};
+
+template <typename Result>
+ContinuationAsyncWork<Result>::ContinuationAsyncWork():
+	m_state(RUNNING),
+	m_finished(false),
+	m_link(new Link)
+{
+	m_link->work = this;
+}
+
+template <typename Result>
+ContinuationAsyncWork<Result>::~ContinuationAsyncWork()
+{
+	Poco::Mutex::ScopedLock guard(m_link->lock);
+	m_link->work = nullptr;
+}
+
+template <typename Result>
+void ContinuationAsyncWork<Result>::setCancelHook(const std::function<void()> &hook)
+{
+	Poco::FastMutex::ScopedLock guard(m_lock);
+	m_cancelHook = hook;
+}
+
+template <typename Result>
+bool ContinuationAsyncWork<Result>::complete(const Result &result)
+{
+	std::list<Callback> callbacks;
+
+	{
+		Poco::FastMutex::ScopedLock guard(m_lock);
+
+		if (m_state != RUNNING)
+			return false;
+
+		this->setResult(result);
+		m_state = SUCCEEDED;
+		callbacks.swap(m_callbacks);
+	}
+
+	notify(callbacks);
+	return true;
+}
+
+template <typename Result>
+bool ContinuationAsyncWork<Result>::fail(const Poco::Exception &e)
+{
+	std::list<Callback> callbacks;
+
+	{
+		Poco::FastMutex::ScopedLock guard(m_lock);
+
+		if (m_state != RUNNING)
+			return false;
+
+		m_error = e.clone();
+		m_state = FAILED;
+		callbacks.swap(m_callbacks);
+	}
+
+	notify(callbacks);
+	return true;
+}
+
+template <typename Result>
+void ContinuationAsyncWork<Result>::cancel()
+{
+	std::list<Callback> callbacks;
+	std::function<void()> hook;
+
+	{
+		Poco::FastMutex::ScopedLock guard(m_lock);
+
+		if (m_state != RUNNING)
+			return;
+
+		m_state = CANCELLED;
+		callbacks.swap(m_callbacks);
+		hook = m_cancelHook;
+	}
+
+	if (hook) {
+		try {
+			hook();
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+
+	notify(callbacks);
+}
+
+template <typename Result>
+bool ContinuationAsyncWork<Result>::tryJoin(const Poco::Timespan &timeout)
+{
+	if (timeout <= 0)
+		return finished();
+
+	return m_finished.tryWait(timeout.totalMilliseconds());
+}
+
+template <typename Result>
+typename ContinuationAsyncWork<Result>::State ContinuationAsyncWork<Result>::state() const
+{
+	Poco::FastMutex::ScopedLock guard(m_lock);
+	return m_state;
+}
+
+template <typename Result>
+bool ContinuationAsyncWork<Result>::finished() const
+{
+	return state() != RUNNING;
+}
+
+template <typename Result>
+void ContinuationAsyncWork<Result>::rethrow() const
+{
+	Poco::FastMutex::ScopedLock guard(m_lock);
+
+	if (m_error.isNull())
+		throw Poco::IllegalStateException("work has not failed");
+
+	m_error->rethrow();
+}
+
+template <typename Result>
+void ContinuationAsyncWork<Result>::onComplete(const Callback &callback)
+{
+	Poco::ScopedLockWithUnlock<Poco::FastMutex> guard(m_lock);
+
+	if (m_state == RUNNING) {
+		m_callbacks.emplace_back(callback);
+		return;
+	}
+
+	guard.unlock();
+
+	try {
+		callback(*this);
+	}
+	BEEEON_CATCH_CHAIN(logger())
+}
+
+template <typename Result>
+void ContinuationAsyncWork<Result>::notify(std::list<Callback> &callbacks)
+{
+	m_finished.set();
+
+	for (auto &callback : callbacks) {
+		try {
+			callback(*this);
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+}
+
+template <typename Result>
+std::function<void()> ContinuationAsyncWork<Result>::cancelLink()
+{
+	Poco::SharedPtr<Link> link = m_link;
+
+	return [link]() {
+		Poco::Mutex::ScopedLock guard(link->lock);
+
+		if (link->work != nullptr)
+			link->work->cancel();
+	};
+}
+
+template <typename Result>
+template <typename Other>
+void ContinuationAsyncWork<Result>::propagate(ContinuationAsyncWork<Other> &other) const
+{
+	switch (state()) {
+	case FAILED:
+		try {
+			rethrow();
+		}
+		catch (const Poco::Exception &e) {
+			other.fail(e);
+		}
+		break;
+
+	case CANCELLED:
+		other.cancel();
+		break;
+
+	default:
+		break;
+	}
+}
+
+template <typename Result>
+template <typename Next>
+typename ContinuationAsyncWork<Next>::Ptr ContinuationAsyncWork<Result>::then(
+		const std::function<Next(const Result &)> &step)
+{
+	typename ContinuationAsyncWork<Next>::Ptr next = new ContinuationAsyncWork<Next>;
+	next->setCancelHook(cancelLink());
+
+	onComplete([next, step](ContinuationAsyncWork<Result> &self) {
+		if (self.state() != SUCCEEDED) {
+			self.propagate(*next);
+			return;
+		}
+
+		try {
+			next->complete(step(self.result().value()));
+		}
+		catch (const Poco::Exception &e) {
+			next->fail(e);
+		}
+		catch (const std::exception &e) {
+			next->fail(Poco::Exception(e.what()));
+		}
+	});
+
+	return next;
+}
+
+template <typename Result>
+template <typename Next>
+typename ContinuationAsyncWork<Next>::Ptr ContinuationAsyncWork<Result>::thenAsync(
+		const std::function<typename ContinuationAsyncWork<Next>::Ptr(const Result &)> &step)
+{
+	typename ContinuationAsyncWork<Next>::Ptr next = new ContinuationAsyncWork<Next>;
+	next->setCancelHook(cancelLink());
+
+	onComplete([next, step](ContinuationAsyncWork<Result> &self) {
+		if (self.state() != SUCCEEDED) {
+			self.propagate(*next);
+			return;
+		}
+
+		typename ContinuationAsyncWork<Next>::Ptr inner;
+
+		try {
+			inner = step(self.result().value());
+		}
+		catch (const Poco::Exception &e) {
+			next->fail(e);
+			return;
+		}
+		catch (const std::exception &e) {
+			next->fail(Poco::Exception(e.what()));
+			return;
+		}
+
+		if (inner.isNull()) {
+			next->fail(Poco::IllegalStateException("no work has been started"));
+			return;
+		}
+
+		// cancelling of the result cancels the running step
+		next->setCancelHook(inner->cancelLink());
+
+		inner->onComplete([next](ContinuationAsyncWork<Next> &done) {
+			if (done.state() == ContinuationAsyncWork<Next>::SUCCEEDED)
+				next->complete(done.result().value());
+			else
+				done.propagate(*next);
+		});
+	});
+
+	return next;
+}
+
+}
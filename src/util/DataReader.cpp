@@ -1,6 +1,6 @@
+#include <cstring>
+
 #include <Poco/Checksum.h>
-#include <Poco/File.h>
-#include <Poco/NumberParser.h>
 #include <Poco/Exception.h>
 #include <Poco/Logger.h>
 
@@ -13,10 +13,42 @@ using namespace std;
 
 const unsigned long DataReader::CHECKSUM_WIDTH = DataWriter::CHECKSUM_WIDTH;
 
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Parse exactly CHECKSUM_WIDTH hexadecimal digits.
+ */
+static bool parseChecksum(const char *data, uint32_t &checksum)
+{
+	checksum = 0;
+
+	for (unsigned long i = 0; i < DataReader::CHECKSUM_WIDTH; ++i) {
+		const char c = data[i];
+		uint32_t digit;
+
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else
+			return false;
+
+		checksum = (checksum << 4) | digit;
+	}
+
+	return true;
+}
+
 DataReader::DataReader(istream &input):
 	m_nextValid(false),
 	m_input(input),
-	m_dataRead(0)
+	m_dataRead(0),
+	m_buffer(CHUNK_SIZE),
+	m_begin(0),
+	m_end(0),
+	m_eof(false)
 {
 }
 
@@ -45,10 +77,10 @@ string DataReader::next()
 	throw IllegalStateException("no more data available");
 }
 
-uint32_t DataReader::checksum(string &data) const
+uint32_t DataReader::checksum(const char *data, size_t length) const
 {
 	Checksum realChecksum;
-	realChecksum.update(data);
+	realChecksum.update(data, length);
 
 	return realChecksum.checksum();
 }
@@ -59,7 +91,7 @@ size_t DataReader::skip(size_t count)
 
 	size_t skipped = 0;
 
-	while (count-- && prefetchNext())
+	while (count-- && prefetchNext(false))
 		++skipped;
 
 	m_nextValid = false;
@@ -75,47 +107,83 @@ size_t DataReader::dataRead() const
 	return m_dataRead;
 }
 
-bool DataReader::prefetchNext()
+void DataReader::fill()
 {
-	m_data.clear();
+	if (m_begin > 0) {
+		::memmove(m_buffer.data(), m_buffer.data() + m_begin, m_end - m_begin);
+		m_end -= m_begin;
+		m_begin = 0;
+	}
 
-	size_t skipped = 0;
+	// a line longer than the buffer
+	if (m_end == m_buffer.size())
+		m_buffer.resize(m_buffer.size() * 2);
+
+	m_input.read(m_buffer.data() + m_end, m_buffer.size() - m_end);
+	m_end += m_input.gcount();
+
+	if (!m_input)
+		m_eof = true;
+}
+
+bool DataReader::nextLine(const char *&line, size_t &length)
+{
+	size_t scanned = m_begin;
 
 	while (true) {
-		try {
-			string line;
-			getline(m_input, line);
+		const char *data = m_buffer.data();
+		const void *newline = ::memchr(data + scanned, '\n', m_end - scanned);
+
+		if (newline != nullptr) {
+			line = data + m_begin;
+			length = static_cast<const char *>(newline) - line;
+			m_begin += length + 1;
+			return true;
+		}
 
-			if (m_input.eof()) {
-				if (skipped > 0)
-					logger().warning("EOF reached, skipped %d invalid data", skipped);
+		if (m_eof) {
+			m_begin = m_end;
+			return false;
+		}
 
-				return false;
-			}
+		// fill() moves the unprocessed data to the beginning
+		scanned = m_end - m_begin;
+		fill();
+	}
+}
+
+bool DataReader::prefetchNext(bool keepData)
+{
+	m_data.clear();
 
-			uint32_t savedChecksum;
+	size_t skipped = 0;
+	const char *line;
+	size_t length;
+
+	while (nextLine(line, length)) {
+		uint32_t savedChecksum;
 
-			savedChecksum = NumberParser::parseHex(line.substr(0, CHECKSUM_WIDTH));
-			m_data = line.substr(DataWriter::CHECKSUM_WIDTH);
+		if (length >= CHECKSUM_WIDTH && parseChecksum(line, savedChecksum)) {
+			const char *data = line + CHECKSUM_WIDTH;
+			const size_t dataLength = length - CHECKSUM_WIDTH;
 
-			if (checksum(m_data) == savedChecksum) {
+			if (checksum(data, dataLength) == savedChecksum) {
 				if (skipped > 0)
 					logger().warning("skipped %d invalid data", skipped);
 
+				if (keepData)
+					m_data.assign(data, dataLength);
+
 				m_nextValid = true;
 				return true;
 			}
 		}
-		catch (const Exception &e) {
-			logger().log(e, __FILE__, __LINE__);
-		}
-		catch (exception &e) {
-			poco_critical(logger(), e.what());
-		}
-		catch (...) {
-			poco_critical(logger(), "unknown error occurred while reading data");
-		}
 
 		++skipped;
 	}
+
+	if (skipped > 0)
+		logger().warning("EOF reached, skipped %d invalid data", skipped);
+
+	return false;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <istream>
+#include <vector>
 
 #include "util/Loggable.h"
 #include "util/DataIterator.h"
@@ -12,6 +13,10 @@ namespace BeeeOn {
  * @brief Serves to read and verify data written by the DataWriter.
  *
  * Invalid data (wrong format or wrong checksum) from the input stream are skipped.
+ *
+ * The input stream is read in chunks into an internal buffer and lines
+ * are split in place, so only the valid data returned by next() are copied.
+ * An incomplete last line (not terminated by a newline) is ignored.
  */
 class DataReader : public DataIterator, protected Loggable {
 public:
@@ -54,14 +59,33 @@ public:
 	size_t dataRead() const;
 
 private:
-	bool prefetchNext();
-	uint32_t checksum(std::string &data) const;
+	bool prefetchNext(bool keepData = true);
+	uint32_t checksum(const char *data, size_t length) const;
+
+	/**
+	 * @brief Locate the next complete line in the buffer, read more
+	 * data from the input stream if needed. The line is valid until
+	 * the next call.
+	 * @return False when there are no more complete lines.
+	 */
+	bool nextLine(const char *&line, size_t &length);
+
+	/**
+	 * @brief Move the unprocessed data to the beginning of the buffer
+	 * and read the next chunk from the input stream after them.
+	 */
+	void fill();
 
 private:
 	bool m_nextValid;
 	std::istream &m_input;
 	size_t m_dataRead;
 	std::string m_data;
+
+	std::vector<char> m_buffer;
+	size_t m_begin;
+	size_t m_end;
+	bool m_eof;
 };
 
 }
@@ -1,5 +1,6 @@
+#include <cstring>
+
 #include <Poco/Checksum.h>
-#include <Poco/NumberFormatter.h>
 
 #include "util/DataWriter.h"
 
@@ -7,8 +8,25 @@ using namespace BeeeOn;
 using namespace Poco;
 using namespace std;
 
-DataWriter::DataWriter(ostream &output):
-	m_output(output)
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+/**
+ * Format the checksum as exactly CHECKSUM_WIDTH uppercase
+ * hexadecimal digits.
+ */
+static void formatChecksum(char *out, uint32_t checksum)
+{
+	for (int i = DataWriter::CHECKSUM_WIDTH - 1; i >= 0; --i) {
+		out[i] = HEX_DIGITS[checksum & 0x0f];
+		checksum >>= 4;
+	}
+}
+
+DataWriter::DataWriter(ostream &output, size_t bufferSize):
+	m_output(output),
+	m_buffer(new char[bufferSize]),
+	m_bufferSize(bufferSize),
+	m_used(0)
 {
 }
 
@@ -17,22 +35,56 @@ size_t DataWriter::write(DataIterator &iterator)
 	size_t dataWritten = 0;
 
 	while (iterator.hasNext()) {
-		string data = iterator.next();
-
-		string hexChecksum;
-		NumberFormatter::appendHex(hexChecksum, checksum(data), CHECKSUM_WIDTH);
-
-		m_output << hexChecksum << data << endl;
+		const string &data = iterator.next();
+		append(data.data(), data.size());
 
 		++dataWritten;
 	}
 
+	flushBuffer();
+	m_output.flush();
+
 	return dataWritten;
 }
 
-uint32_t DataWriter::checksum(const string &data) const
+void DataWriter::append(const char *data, size_t length)
+{
+	const size_t recordLength = CHECKSUM_WIDTH + length + 1;
+
+	if (m_used + recordLength > m_bufferSize)
+		flushBuffer();
+
+	if (recordLength > m_bufferSize) {
+		char hexChecksum[CHECKSUM_WIDTH];
+		formatChecksum(hexChecksum, checksum(data, length));
+
+		m_output.write(hexChecksum, CHECKSUM_WIDTH);
+		m_output.write(data, length);
+		m_output.put('\n');
+		return;
+	}
+
+	char *record = m_buffer.get() + m_used;
+
+	formatChecksum(record, checksum(data, length));
+	::memcpy(record + CHECKSUM_WIDTH, data, length);
+	record[recordLength - 1] = '\n';
+
+	m_used += recordLength;
+}
+
+void DataWriter::flushBuffer()
+{
+	if (m_used == 0)
+		return;
+
+	m_output.write(m_buffer.get(), m_used);
+	m_used = 0;
+}
+
+uint32_t DataWriter::checksum(const char *data, size_t length) const
 {
 	Checksum checksum;
-	checksum.update(data);
+	checksum.update(data, length);
 	return checksum.checksum();
 }
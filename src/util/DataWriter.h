@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <ostream>
 
 #include "util/DataIterator.h"
@@ -9,12 +10,18 @@ namespace BeeeOn {
 /**
  * @class DataWriter
  * @brief Serves to write data with their checksum to the output stream.
+ *
+ * The records are formatted into an internal buffer which is written
+ * into the output stream when full and at the end of each write().
+ * The output stream is flushed once per write() call.
  */
 class DataWriter {
 public:
 	const static int CHECKSUM_WIDTH = 8;
+	const static size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
 
-	explicit DataWriter(std::ostream &output);
+	explicit DataWriter(std::ostream &output,
+		size_t bufferSize = DEFAULT_BUFFER_SIZE);
 
 	/**
 	 * @brief Writes all the data provided by the given DataIterator to the output stream.
@@ -31,10 +38,17 @@ public:
 	size_t write(DataIterator &iterator);
 
 private:
-	uint32_t checksum(const std::string &data) const;
+	void append(const char *data, size_t length);
+	void flushBuffer();
+	uint32_t checksum(const char *data, size_t length) const;
 
 public:
 	std::ostream &m_output;
+
+private:
+	std::unique_ptr<char[]> m_buffer;
+	size_t m_bufferSize;
+	size_t m_used;
 };
 
 }
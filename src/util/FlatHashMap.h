@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief FlatHashMap is a hash table with open addressing and linear
+ * probing. All entries live in a single contiguous array, thus lookups
+ * of small keys touch usually a single cache line. It is intended for
+ * hot paths with many lookups and rare insertions.
+ *
+ * Entries are removed by eraseIf() that rebuilds the whole table, thus
+ * removals should be rare. Pointers to values are invalidated by
+ * insertion and removal.
+ *
+ * The Hash is a functor returning a 64-bit hash of the Key. The hash
+ * is mixed before use so it does not have to be uniformly distributed.
+ * Key and Value must be default constructible.
+ */
+template <typename Key, typename Value, typename Hash>
+class FlatHashMap {
+public:
+	FlatHashMap(size_t capacity = 16);
+
+	/**
+	 * @returns value of the given key or nullptr when not present
+	 */
+	Value *find(const Key &key);
+	const Value *find(const Key &key) const;
+
+	/**
+	 * @brief Find value of the given key or insert a default
+	 * constructed one.
+	 * @returns the value and whether it was just inserted
+	 */
+	std::pair<Value *, bool> emplace(const Key &key);
+
+	size_t size() const;
+	size_t capacity() const;
+	void clear();
+
+	/**
+	 * @brief Remove all entries for which pred(key, value) is true.
+	 * @returns count of removed entries
+	 */
+	template <typename P>
+	size_t eraseIf(P pred);
+
+	/**
+	 * @brief Call f(key, value) for each entry.
+	 */
+	template <typename F>
+	void forEach(F f);
+
+protected:
+	struct Slot {
+		Key key;
+		Value value;
+		bool used = false;
+	};
+
+	/**
+	 * @returns index of slot holding the key or of the empty slot
+	 * where the key would be inserted
+	 */
+	size_t probe(const std::vector<Slot> &slots, const Key &key) const;
+
+	void grow();
+
+private:
+	std::vector<Slot> m_slots;
+	size_t m_size;
+};
+
+template <typename Key, typename Value, typename Hash>
+FlatHashMap<Key, Value, Hash>::FlatHashMap(size_t capacity):
+	m_size(0)
+{
+	size_t slots = 4;
+
+	while (slots < capacity * 2)
+		slots *= 2;
+
+	m_slots.resize(slots);
+}
+
+template <typename Key, typename Value, typename Hash>
+size_t FlatHashMap<Key, Value, Hash>::probe(
+		const std::vector<Slot> &slots,
+		const Key &key) const
+{
+	// Fibonacci hashing spreads sequential keys over the table
+	const Poco::UInt64 mixed = static_cast<Poco::UInt64>(Hash()(key))
+		* 0x9e3779b97f4a7c15ULL;
+	const size_t mask = slots.size() - 1;
+	size_t i = static_cast<size_t>(mixed >> 32) & mask;
+
+	while (slots[i].used && !(slots[i].key == key))
+		i = (i + 1) & mask;
+
+	return i;
+}
+
+template <typename Key, typename Value, typename Hash>
+Value *FlatHashMap<Key, Value, Hash>::find(const Key &key)
+{
+	Slot &slot = m_slots[probe(m_slots, key)];
+	return slot.used ? &slot.value : nullptr;
+}
+
+template <typename Key, typename Value, typename Hash>
+const Value *FlatHashMap<Key, Value, Hash>::find(const Key &key) const
+{
+	const Slot &slot = m_slots[probe(m_slots, key)];
+	return slot.used ? &slot.value : nullptr;
+}
+
+template <typename Key, typename Value, typename Hash>
+std::pair<Value *, bool> FlatHashMap<Key, Value, Hash>::emplace(const Key &key)
+{
+	size_t i = probe(m_slots, key);
+
+	if (m_slots[i].used)
+		return {&m_slots[i].value, false};
+
+	// keep load factor at most 1/2 to keep probe sequences short
+	if ((m_size + 1) * 2 > m_slots.size()) {
+		grow();
+		i = probe(m_slots, key);
+	}
+
+	Slot &slot = m_slots[i];
+	slot.key = key;
+	slot.value = Value();
+	slot.used = true;
+	m_size += 1;
+
+	return {&slot.value, true};
+}
+
+template <typename Key, typename Value, typename Hash>
+void FlatHashMap<Key, Value, Hash>::grow()
+{
+	std::vector<Slot> slots(m_slots.size() * 2);
+
+	for (auto &slot : m_slots) {
+		if (!slot.used)
+			continue;
+
+		slots[probe(slots, slot.key)] = std::move(slot);
+	}
+
+	m_slots.swap(slots);
+}
+
+template <typename Key, typename Value, typename Hash>
+size_t FlatHashMap<Key, Value, Hash>::size() const
+{
+	return m_size;
+}
+
+template <typename Key, typename Value, typename Hash>
+size_t FlatHashMap<Key, Value, Hash>::capacity() const
+{
+	return m_slots.size() / 2;
+}
+
+template <typename Key, typename Value, typename Hash>
+void FlatHashMap<Key, Value, Hash>::clear()
+{
+	for (auto &slot : m_slots)
+		slot = Slot();
+
+	m_size = 0;
+}
+
+template <typename Key, typename Value, typename Hash>
+template <typename P>
+size_t FlatHashMap<Key, Value, Hash>::eraseIf(P pred)
+{
+	// reinserting the kept entries keeps probe sequences unbroken
+	std::vector<Slot> slots(m_slots.size());
+	size_t erased = 0;
+
+	for (auto &slot : m_slots) {
+		if (!slot.used)
+			continue;
+
+		if (pred(const_cast<const Key &>(slot.key),
+				const_cast<const Value &>(slot.value))) {
+			erased += 1;
+			continue;
+		}
+
+		slots[probe(slots, slot.key)] = std::move(slot);
+	}
+
+	m_slots.swap(slots);
+	m_size -= erased;
+
+	return erased;
+}
+
+template <typename Key, typename Value, typename Hash>
+template <typename F>
+void FlatHashMap<Key, Value, Hash>::forEach(F f)
+{
+	for (auto &slot : m_slots) {
+		if (slot.used)
+			f(const_cast<const Key &>(slot.key), slot.value);
+	}
+}
+
+}
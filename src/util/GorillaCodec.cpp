@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <cstring>
+
+#include <Poco/Exception.h>
+
+#include "util/GorillaCodec.h"
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+/**
+ * Leading zeros are stored in 5 bits.
+ */
+static const unsigned int MAX_LEADING = 31;
+
+/**
+ * Marks that no XOR window has been established yet.
+ */
+static const unsigned int NO_WINDOW = 65;
+
+/**
+ * Ranges of delta of deltas and the bits they are stored in,
+ * prefixed by '10', '110' and '1110' respectively. Other values
+ * are stored in 64 bits prefixed by '1111'.
+ */
+static const struct {
+	Int64 min;
+	Int64 max;
+	unsigned int bits;
+} TIME_BUCKETS[] = {
+	{-63, 64, 7},
+	{-255, 256, 9},
+	{-2047, 2048, 12},
+};
+
+static UInt64 toBits(double value)
+{
+	UInt64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static double fromBits(UInt64 bits)
+{
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+GorillaEncoder::GorillaEncoder()
+{
+	clear();
+}
+
+void GorillaEncoder::clear()
+{
+	m_data.clear();
+	m_free = 0;
+	m_count = 0;
+	m_time = 0;
+	m_delta = 0;
+	m_value = 0;
+	m_leading = NO_WINDOW;
+	m_trailing = 0;
+}
+
+void GorillaEncoder::append(Int64 time, double value)
+{
+	const UInt64 bits = toBits(value);
+
+	if (m_count == 0) {
+		writeBits(static_cast<UInt64>(time), 64);
+		writeBits(bits, 64);
+	}
+	else {
+		writeTime(time);
+		writeValue(bits);
+	}
+
+	m_delta = m_count == 0 ? 0 : time - m_time;
+	m_time = time;
+	m_value = bits;
+	m_count += 1;
+}
+
+size_t GorillaEncoder::count() const
+{
+	return m_count;
+}
+
+const string &GorillaEncoder::data() const
+{
+	return m_data;
+}
+
+void GorillaEncoder::writeBits(UInt64 value, unsigned int count)
+{
+	while (count > 0) {
+		if (m_free == 0) {
+			m_data.push_back('\0');
+			m_free = 8;
+		}
+
+		const unsigned int take = min(count, m_free);
+		const UInt8 chunk = (value >> (count - take)) & ((1u << take) - 1);
+
+		m_data.back() |= static_cast<char>(chunk << (m_free - take));
+		m_free -= take;
+		count -= take;
+	}
+}
+
+void GorillaEncoder::writeTime(Int64 time)
+{
+	const Int64 dod = (time - m_time) - m_delta;
+
+	if (dod == 0) {
+		writeBits(0, 1);
+		return;
+	}
+
+	for (unsigned int i = 0; i < 3; ++i) {
+		const auto &bucket = TIME_BUCKETS[i];
+
+		if (dod >= bucket.min && dod <= bucket.max) {
+			// i + 1 ones terminated by zero
+			writeBits(((1u << (i + 1)) - 1) << 1, i + 2);
+			writeBits(static_cast<UInt64>(dod - bucket.min), bucket.bits);
+			return;
+		}
+	}
+
+	writeBits(0xf, 4);
+	writeBits(static_cast<UInt64>(dod), 64);
+}
+
+void GorillaEncoder::writeValue(UInt64 bits)
+{
+	const UInt64 xored = bits ^ m_value;
+
+	if (xored == 0) {
+		writeBits(0, 1);
+		return;
+	}
+
+	unsigned int leading = __builtin_clzll(xored);
+	const unsigned int trailing = __builtin_ctzll(xored);
+
+	if (leading > MAX_LEADING)
+		leading = MAX_LEADING;
+
+	if (m_leading != NO_WINDOW && leading >= m_leading && trailing >= m_trailing) {
+		// '10': meaningful bits fit into the previous window
+		writeBits(0x2, 2);
+		writeBits(xored >> m_trailing, 64 - m_leading - m_trailing);
+		return;
+	}
+
+	const unsigned int meaningful = 64 - leading - trailing;
+
+	// '11': new window
+	writeBits(0x3, 2);
+	writeBits(leading, 5);
+	writeBits(meaningful - 1, 6);
+	writeBits(xored >> trailing, meaningful);
+
+	m_leading = leading;
+	m_trailing = trailing;
+}
+
+GorillaDecoder::GorillaDecoder(const string &data, size_t count):
+	m_data(data),
+	m_byte(0),
+	m_bit(0),
+	m_count(count),
+	m_read(0),
+	m_time(0),
+	m_delta(0),
+	m_value(0),
+	m_leading(NO_WINDOW),
+	m_trailing(0)
+{
+}
+
+bool GorillaDecoder::next(Int64 &time, double &value)
+{
+	if (m_read >= m_count)
+		return false;
+
+	if (m_read == 0) {
+		m_time = static_cast<Int64>(readBits(64));
+		m_value = readBits(64);
+	}
+	else {
+		const Int64 next = readTime();
+		m_delta = next - m_time;
+		m_time = next;
+		m_value = readValue();
+	}
+
+	m_read += 1;
+
+	time = m_time;
+	value = fromBits(m_value);
+	return true;
+}
+
+UInt64 GorillaDecoder::readBits(unsigned int count)
+{
+	UInt64 result = 0;
+
+	while (count > 0) {
+		if (m_byte >= m_data.size())
+			throw DataFormatException("encoded points are truncated");
+
+		const unsigned int available = 8 - m_bit;
+		const unsigned int take = min(count, available);
+		const UInt8 byte = static_cast<UInt8>(m_data[m_byte]);
+		const UInt8 chunk = (byte >> (available - take)) & ((1u << take) - 1);
+
+		result = (result << take) | chunk;
+		m_bit += take;
+		count -= take;
+
+		if (m_bit == 8) {
+			m_bit = 0;
+			m_byte += 1;
+		}
+	}
+
+	return result;
+}
+
+Int64 GorillaDecoder::readTime()
+{
+	Int64 dod;
+
+	if (readBits(1) == 0) {
+		dod = 0;
+	}
+	else {
+		unsigned int i = 0;
+
+		while (i < 3 && readBits(1) == 1)
+			i += 1;
+
+		if (i < 3)
+			dod = static_cast<Int64>(readBits(TIME_BUCKETS[i].bits)) + TIME_BUCKETS[i].min;
+		else
+			dod = static_cast<Int64>(readBits(64));
+	}
+
+	return m_time + m_delta + dod;
+}
+
+UInt64 GorillaDecoder::readValue()
+{
+	if (readBits(1) == 0)
+		return m_value;
+
+	if (readBits(1) == 1) {
+		m_leading = readBits(5);
+		const unsigned int meaningful = readBits(6) + 1;
+		m_trailing = 64 - m_leading - meaningful;
+	}
+	else if (m_leading == NO_WINDOW) {
+		throw DataFormatException("no XOR window has been established");
+	}
+
+	const unsigned int meaningful = 64 - m_leading - m_trailing;
+	return m_value ^ (readBits(meaningful) << m_trailing);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief GorillaEncoder compresses a series of (time, value) points
+ * as described in the paper "Gorilla: A Fast, Scalable, In-Memory Time
+ * Series Database". Times (in milliseconds) are encoded as delta of
+ * deltas, values as XOR with the previous value. Series sampled
+ * in regular intervals with slowly changing values need just a few
+ * bits per point.
+ *
+ * The first point is stored as raw 64-bit time and value. Times do not
+ * have to be monotonic, but points out of order take more space.
+ */
+class GorillaEncoder {
+public:
+	GorillaEncoder();
+
+	void append(Poco::Int64 time, double value);
+
+	/**
+	 * @returns count of appended points
+	 */
+	size_t count() const;
+
+	/**
+	 * @returns encoded points, the last byte is padded by zeros
+	 */
+	const std::string &data() const;
+
+	void clear();
+
+protected:
+	void writeBits(Poco::UInt64 value, unsigned int count);
+	void writeTime(Poco::Int64 time);
+	void writeValue(Poco::UInt64 bits);
+
+private:
+	std::string m_data;
+	unsigned int m_free;
+	size_t m_count;
+	Poco::Int64 m_time;
+	Poco::Int64 m_delta;
+	Poco::UInt64 m_value;
+	unsigned int m_leading;
+	unsigned int m_trailing;
+};
+
+/**
+ * @brief GorillaDecoder reads points encoded by the GorillaEncoder.
+ */
+class GorillaDecoder {
+public:
+	/**
+	 * @param data encoded points
+	 * @param count count of the encoded points
+	 */
+	GorillaDecoder(const std::string &data, size_t count);
+
+	/**
+	 * @brief Decode the next point.
+	 * @returns false when all the points have been decoded
+	 * @throws Poco::DataFormatException when the data are truncated
+	 */
+	bool next(Poco::Int64 &time, double &value);
+
+protected:
+	Poco::UInt64 readBits(unsigned int count);
+	Poco::Int64 readTime();
+	Poco::UInt64 readValue();
+
+private:
+	const std::string &m_data;
+	size_t m_byte;
+	unsigned int m_bit;
+	size_t m_count;
+	size_t m_read;
+	Poco::Int64 m_time;
+	Poco::Int64 m_delta;
+	Poco::UInt64 m_value;
+	unsigned int m_leading;
+	unsigned int m_trailing;
+};
+
+}
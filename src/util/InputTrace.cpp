@@ -0,0 +1,230 @@
+#include <Poco/Exception.h>
+
+#include "util/InputTrace.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const string TRACE_MAGIC = "BTRC";
+static const char TRACE_VERSION = 1;
+
+/**
+ * Limit of a single string in a trace to detect corrupted
+ * traces before allocating too much memory.
+ */
+static const UInt64 MAX_STRING_LENGTH = 16 * 1024 * 1024;
+
+static void appendUnsigned(string &out, UInt64 value)
+{
+	while (value >= 0x80) {
+		out += static_cast<char>((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+
+	out += static_cast<char>(value);
+}
+
+InputTraceRecord::InputTraceRecord()
+{
+}
+
+InputTraceRecord::InputTraceRecord(
+		const Timespan &offset,
+		const string &channel,
+		const string &payload):
+	m_offset(offset),
+	m_channel(channel),
+	m_payload(payload)
+{
+}
+
+Timespan InputTraceRecord::offset() const
+{
+	return m_offset;
+}
+
+const string &InputTraceRecord::channel() const
+{
+	return m_channel;
+}
+
+const string &InputTraceRecord::payload() const
+{
+	return m_payload;
+}
+
+void InputTraceEncoder::putUnsigned(UInt64 value)
+{
+	appendUnsigned(m_data, value);
+}
+
+void InputTraceEncoder::putString(const string &value)
+{
+	appendUnsigned(m_data, value.size());
+	m_data += value;
+}
+
+void InputTraceEncoder::putBytes(const vector<unsigned char> &value)
+{
+	appendUnsigned(m_data, value.size());
+	m_data.append(value.begin(), value.end());
+}
+
+const string &InputTraceEncoder::data() const
+{
+	return m_data;
+}
+
+InputTraceDecoder::InputTraceDecoder(const string &data):
+	m_data(data),
+	m_offset(0)
+{
+}
+
+UInt64 InputTraceDecoder::getUnsigned()
+{
+	UInt64 value = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		if (m_offset >= m_data.size())
+			throw DataFormatException("truncated number in trace payload");
+
+		const unsigned char c = m_data[m_offset++];
+		value |= static_cast<UInt64>(c & 0x7f) << shift;
+
+		if ((c & 0x80) == 0)
+			return value;
+	}
+
+	throw DataFormatException("too long number in trace payload");
+}
+
+string InputTraceDecoder::getString()
+{
+	const UInt64 length = getUnsigned();
+
+	if (length > m_data.size() - m_offset)
+		throw DataFormatException("truncated string in trace payload");
+
+	const string value = m_data.substr(m_offset, length);
+	m_offset += length;
+
+	return value;
+}
+
+vector<unsigned char> InputTraceDecoder::getBytes()
+{
+	const string &value = getString();
+	return vector<unsigned char>(value.begin(), value.end());
+}
+
+bool InputTraceDecoder::atEnd() const
+{
+	return m_offset >= m_data.size();
+}
+
+InputTraceWriter::InputTraceWriter(ostream &out):
+	m_out(out),
+	m_first(true)
+{
+	m_out << TRACE_MAGIC << TRACE_VERSION;
+}
+
+void InputTraceWriter::write(
+		const string &channel,
+		const string &payload,
+		const Timestamp &at)
+{
+	Timespan delta = 0;
+
+	if (m_first)
+		m_first = false;
+	else if (at > m_last)
+		delta = at - m_last;
+
+	if (at > m_last)
+		m_last = at;
+
+	string record;
+	appendUnsigned(record, delta.totalMicroseconds());
+	appendUnsigned(record, channel.size());
+	record += channel;
+	appendUnsigned(record, payload.size());
+	record += payload;
+
+	m_out.write(record.data(), record.size());
+}
+
+static bool readUnsigned(istream &in, UInt64 &value, bool mayEnd)
+{
+	value = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		const int c = in.get();
+
+		if (c == char_traits<char>::eof()) {
+			if (mayEnd && shift == 0)
+				return false;
+
+			throw DataFormatException("truncated number in trace");
+		}
+
+		value |= static_cast<UInt64>(c & 0x7f) << shift;
+
+		if ((c & 0x80) == 0)
+			return true;
+	}
+
+	throw DataFormatException("too long number in trace");
+}
+
+static string readString(istream &in)
+{
+	UInt64 length;
+	readUnsigned(in, length, false);
+
+	if (length > MAX_STRING_LENGTH)
+		throw DataFormatException("too long string in trace: " + to_string(length));
+
+	string value(length, '\0');
+	in.read(&value[0], length);
+
+	if (static_cast<UInt64>(in.gcount()) != length)
+		throw DataFormatException("truncated string in trace");
+
+	return value;
+}
+
+InputTraceReader::InputTraceReader(istream &in):
+	m_in(in),
+	m_offset(0)
+{
+	string header(TRACE_MAGIC.size() + 1, '\0');
+	m_in.read(&header[0], header.size());
+
+	if (static_cast<size_t>(m_in.gcount()) != header.size())
+		throw DataFormatException("missing trace header");
+
+	if (header.compare(0, TRACE_MAGIC.size(), TRACE_MAGIC) != 0)
+		throw DataFormatException("invalid trace header");
+
+	if (header.back() != TRACE_VERSION)
+		throw DataFormatException("unsupported trace version " + to_string(header.back()));
+}
+
+bool InputTraceReader::next(InputTraceRecord &record)
+{
+	UInt64 delta;
+
+	if (!readUnsigned(m_in, delta, true))
+		return false;
+
+	const string &channel = readString(m_in);
+	const string &payload = readString(m_in);
+
+	m_offset += delta;
+	record = InputTraceRecord(m_offset, channel, payload);
+
+	return true;
+}
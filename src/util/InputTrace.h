@@ -0,0 +1,116 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Single input captured in a trace. The offset is relative
+ * to the first record of the trace. The channel identifies the
+ * source of the input (e.g. "zwave", "jablotron", "ble") and the
+ * payload is an opaque value interpreted by the source.
+ */
+class InputTraceRecord {
+public:
+	InputTraceRecord();
+	InputTraceRecord(
+		const Poco::Timespan &offset,
+		const std::string &channel,
+		const std::string &payload);
+
+	Poco::Timespan offset() const;
+	const std::string &channel() const;
+	const std::string &payload() const;
+
+private:
+	Poco::Timespan m_offset;
+	std::string m_channel;
+	std::string m_payload;
+};
+
+/**
+ * @brief Helper for building compact binary payloads. Numbers are
+ * encoded as variable-length integers (7 bits per byte), strings
+ * and byte arrays are prefixed by their length.
+ */
+class InputTraceEncoder {
+public:
+	void putUnsigned(Poco::UInt64 value);
+	void putString(const std::string &value);
+	void putBytes(const std::vector<unsigned char> &value);
+
+	const std::string &data() const;
+
+private:
+	std::string m_data;
+};
+
+/**
+ * @brief Reads payloads created by the InputTraceEncoder.
+ * @throws Poco::DataFormatException when the payload is truncated
+ */
+class InputTraceDecoder {
+public:
+	InputTraceDecoder(const std::string &data);
+
+	Poco::UInt64 getUnsigned();
+	std::string getString();
+	std::vector<unsigned char> getBytes();
+
+	bool atEnd() const;
+
+private:
+	const std::string m_data;
+	size_t m_offset;
+};
+
+/**
+ * @brief Writes records into a trace stream. The stream starts with
+ * a header followed by records. Each record consists of the time
+ * elapsed since the previous record, the channel and the payload.
+ */
+class InputTraceWriter {
+public:
+	InputTraceWriter(std::ostream &out);
+
+	void write(
+		const std::string &channel,
+		const std::string &payload,
+		const Poco::Timestamp &at = Poco::Timestamp());
+
+private:
+	std::ostream &m_out;
+	Poco::Timestamp m_last;
+	bool m_first;
+};
+
+/**
+ * @brief Reads records written by the InputTraceWriter.
+ */
+class InputTraceReader {
+public:
+	/**
+	 * @throws Poco::DataFormatException when the header is invalid
+	 */
+	InputTraceReader(std::istream &in);
+
+	/**
+	 * Read the next record from the stream.
+	 * @returns false when there are no more records
+	 * @throws Poco::DataFormatException when the record is corrupted
+	 */
+	bool next(InputTraceRecord &record);
+
+private:
+	std::istream &m_in;
+	Poco::Timespan m_offset;
+};
+
+}
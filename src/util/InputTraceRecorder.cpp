@@ -0,0 +1,82 @@
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/SingletonHolder.h>
+
+#include "util/InputTraceRecorder.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+InputTraceRecorder::InputTraceRecorder():
+	m_active(false),
+	m_recorded(0)
+{
+}
+
+InputTraceRecorder::~InputTraceRecorder()
+{
+	try {
+		stop();
+	}
+	BEEEON_CATCH_CHAIN(logger())
+}
+
+InputTraceRecorder &InputTraceRecorder::instance()
+{
+	static SingletonHolder<InputTraceRecorder> singleton;
+	return *singleton.get();
+}
+
+void InputTraceRecorder::start(const string &path)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_active)
+		throw IllegalStateException("input trace is already recorded into " + m_path);
+
+	m_file.reset(new FileOutputStream(path, ios::out | ios::trunc | ios::binary));
+	m_writer.reset(new InputTraceWriter(*m_file));
+	m_path = path;
+	m_recorded = 0;
+
+	m_active = true;
+
+	logger().information("recording input trace into " + path, __FILE__, __LINE__);
+}
+
+void InputTraceRecorder::stop()
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (!m_active)
+		return;
+
+	m_active = false;
+
+	m_writer.reset();
+	m_file->close();
+	m_file.reset();
+
+	logger().information(
+		"recorded " + to_string(m_recorded) + " inputs into " + m_path,
+		__FILE__, __LINE__);
+}
+
+UInt64 InputTraceRecorder::recorded() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_recorded;
+}
+
+void InputTraceRecorder::append(const string &channel, const string &payload)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	// stopped meanwhile
+	if (!m_active)
+		return;
+
+	m_writer->write(channel, payload);
+	++m_recorded;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <Poco/FileStream.h>
+#include <Poco/Mutex.h>
+#include <Poco/Types.h>
+
+#include "util/InputTrace.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Process-wide recorder of raw inputs of device managers.
+ * The sources of inputs (Z-Wave network, Jablotron dongle, BLE
+ * interface, Philips Hue bridge) call record() with their raw
+ * inputs. Unless a recording is started, the call costs a single
+ * atomic load.
+ *
+ * The recorded trace can be replayed via the InputTraceReplayer.
+ */
+class InputTraceRecorder : protected Loggable {
+public:
+	InputTraceRecorder();
+	~InputTraceRecorder();
+
+	static InputTraceRecorder &instance();
+
+	/**
+	 * Start recording into the given file. The file is truncated.
+	 * @throws IllegalStateException when already recording
+	 */
+	void start(const std::string &path);
+
+	/**
+	 * Stop recording and close the trace file.
+	 */
+	void stop();
+
+	bool active() const
+	{
+		return m_active.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Record the given input if the recording is active.
+	 */
+	void record(const std::string &channel, const std::string &payload)
+	{
+		if (active())
+			append(channel, payload);
+	}
+
+	/**
+	 * @returns number of records written since the last start().
+	 */
+	Poco::UInt64 recorded() const;
+
+private:
+	void append(const std::string &channel, const std::string &payload);
+
+private:
+	std::atomic<bool> m_active;
+	mutable Poco::FastMutex m_lock;
+	std::string m_path;
+	std::unique_ptr<Poco::FileOutputStream> m_file;
+	std::unique_ptr<InputTraceWriter> m_writer;
+	Poco::UInt64 m_recorded;
+};
+
+}
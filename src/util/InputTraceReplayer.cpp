@@ -0,0 +1,78 @@
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/FileStream.h>
+#include <Poco/Logger.h>
+
+#include "util/InputTraceReplayer.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+InputTraceReplayer::InputTraceReplayer():
+	m_speed(1)
+{
+}
+
+void InputTraceReplayer::setTracePath(const string &path)
+{
+	m_tracePath = path;
+}
+
+void InputTraceReplayer::setSpeed(double speed)
+{
+	if (speed < 0)
+		throw InvalidArgumentException("replay speed must not be negative");
+
+	m_speed = speed;
+}
+
+size_t InputTraceReplayer::replay(
+		const string &channel,
+		const Handler &handler,
+		StopControl &stopControl) const
+{
+	FileInputStream in(m_tracePath, ios::in | ios::binary);
+	InputTraceReader reader(in);
+
+	logger().information(
+		"replaying " + channel + " inputs from " + m_tracePath
+		+ (m_speed > 0 ? " at speed " + to_string(m_speed) : " at maximal speed"),
+		__FILE__, __LINE__);
+
+	const Clock started;
+	InputTraceRecord record;
+	size_t count = 0;
+
+	while (!stopControl.shouldStop() && reader.next(record)) {
+		if (record.channel() != channel)
+			continue;
+
+		if (m_speed > 0) {
+			const Timespan due(static_cast<Timespan::TimeDiff>(
+				record.offset().totalMicroseconds() / m_speed));
+			const Timespan remaining = due - started.elapsed();
+
+			if (remaining > 0)
+				stopControl.waitStoppable(remaining);
+
+			if (stopControl.shouldStop())
+				break;
+		}
+
+		handler(record);
+		++count;
+	}
+
+	const Timespan elapsed = started.elapsed();
+
+	logger().information(
+		"replayed " + to_string(count) + " " + channel + " inputs in "
+		+ to_string(elapsed.totalMilliseconds()) + " ms"
+		+ (elapsed > 0 ?
+			" (" + to_string(count * Timespan::SECONDS / elapsed.totalMicroseconds())
+				+ " inputs/s)" : ""),
+		__FILE__, __LINE__);
+
+	return count;
+}
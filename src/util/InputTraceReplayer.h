@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "loop/StopControl.h"
+#include "util/InputTrace.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Feeds records of a trace recorded by the InputTraceRecorder
+ * back into a mock of an input layer. The records can be replayed
+ * with their original timing (speed 1), scaled timing or as fast as
+ * possible (speed 0).
+ */
+class InputTraceReplayer : protected Loggable {
+public:
+	typedef std::function<void(const InputTraceRecord &record)> Handler;
+
+	InputTraceReplayer();
+
+	void setTracePath(const std::string &path);
+
+	/**
+	 * Set speed of replaying relative to the recorded timing.
+	 * The value 0 means to replay as fast as possible.
+	 */
+	void setSpeed(double speed);
+
+	/**
+	 * Replay all records of the given channel by passing them to
+	 * the handler. Replaying ends at the end of the trace or when
+	 * the stop is requested.
+	 *
+	 * @returns number of replayed records
+	 */
+	size_t replay(
+		const std::string &channel,
+		const Handler &handler,
+		StopControl &stopControl) const;
+
+private:
+	std::string m_tracePath;
+	double m_speed;
+};
+
+}
@@ -0,0 +1,164 @@
+#include <cmath>
+
+#include <Poco/Exception.h>
+
+#include "util/LatencyHistogram.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const Int64 MAX_VALUE = (Int64(1) << LatencyHistogram::MAX_EXPONENT) - 1;
+
+LatencyHistogram::Snapshot::Snapshot():
+	m_counts(BUCKETS, 0),
+	m_count(0),
+	m_sum(0),
+	m_max(0)
+{
+}
+
+UInt64 LatencyHistogram::Snapshot::count() const
+{
+	return m_count;
+}
+
+Int64 LatencyHistogram::Snapshot::max() const
+{
+	return m_count == 0 ? -1 : m_max;
+}
+
+Int64 LatencyHistogram::Snapshot::mean() const
+{
+	return m_count == 0 ? -1 : m_sum / m_count;
+}
+
+UInt64 LatencyHistogram::Snapshot::sum() const
+{
+	return m_sum;
+}
+
+Int64 LatencyHistogram::Snapshot::percentile(double fraction) const
+{
+	if (fraction < 0 || fraction > 1)
+		throw InvalidArgumentException("percentile must be in range 0..1");
+
+	if (m_count == 0)
+		return -1;
+
+	UInt64 rank = static_cast<UInt64>(ceil(fraction * m_count));
+	if (rank == 0)
+		rank = 1;
+
+	UInt64 seen = 0;
+
+	for (unsigned int i = 0; i < BUCKETS; ++i) {
+		seen += m_counts[i];
+
+		if (seen >= rank)
+			return std::min(upperBound(i), m_max);
+	}
+
+	return m_max;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+void LatencyHistogram::record(const Timespan &latency)
+{
+	record(latency.totalMicroseconds());
+}
+
+void LatencyHistogram::record(Int64 us)
+{
+	if (us < 0)
+		us = 0;
+	else if (us > MAX_VALUE)
+		us = MAX_VALUE;
+
+	Stripe &stripe = m_stripes[currentStripe()];
+
+	stripe.counts[bucketOf(us)].fetch_add(1, memory_order_relaxed);
+	stripe.sum.fetch_add(us, memory_order_relaxed);
+
+	Int64 max = stripe.max.load(memory_order_relaxed);
+	while (us > max && !stripe.max.compare_exchange_weak(
+			max, us, memory_order_relaxed)) {
+	}
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+	Snapshot snapshot;
+
+	for (const auto &stripe : m_stripes) {
+		for (unsigned int i = 0; i < BUCKETS; ++i) {
+			const UInt64 count = stripe.counts[i].load(memory_order_relaxed);
+
+			snapshot.m_counts[i] += count;
+			snapshot.m_count += count;
+		}
+
+		snapshot.m_sum += stripe.sum.load(memory_order_relaxed);
+		snapshot.m_max = std::max(snapshot.m_max,
+			stripe.max.load(memory_order_relaxed));
+	}
+
+	return snapshot;
+}
+
+void LatencyHistogram::reset()
+{
+	for (auto &stripe : m_stripes) {
+		for (auto &count : stripe.counts)
+			count.store(0, memory_order_relaxed);
+
+		stripe.sum.store(0, memory_order_relaxed);
+		stripe.max.store(0, memory_order_relaxed);
+	}
+}
+
+unsigned int LatencyHistogram::bucketOf(Int64 us)
+{
+	if (us < SUB_BUCKETS)
+		return us < 0 ? 0 : us;
+
+	if (us > MAX_VALUE)
+		us = MAX_VALUE;
+
+	const unsigned int exponent = 63 - __builtin_clzll(us);
+	const unsigned int sub = (us >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+
+	return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+Int64 LatencyHistogram::lowerBound(unsigned int bucket)
+{
+	const unsigned int group = bucket / SUB_BUCKETS;
+	const unsigned int sub = bucket % SUB_BUCKETS;
+
+	if (group == 0)
+		return sub;
+
+	return Int64(SUB_BUCKETS + sub) << (group - 1);
+}
+
+Int64 LatencyHistogram::upperBound(unsigned int bucket)
+{
+	if (bucket + 1 >= BUCKETS)
+		return MAX_VALUE;
+
+	return lowerBound(bucket + 1) - 1;
+}
+
+unsigned int LatencyHistogram::currentStripe()
+{
+	static atomic<unsigned int> next(0);
+	thread_local unsigned int stripe =
+		next.fetch_add(1, memory_order_relaxed) % STRIPES;
+
+	return stripe;
+}
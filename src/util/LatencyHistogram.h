@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+namespace BeeeOn {
+
+/**
+ * @brief Lock-free histogram of latencies (in microseconds) with
+ * a log-linear (HDR-like) bucketing. Each power of two is split into
+ * SUB_BUCKETS linear buckets, thus the relative error of reported
+ * values is bounded by 1/SUB_BUCKETS (about 6 %) over the whole
+ * range from 1 us up to 2^MAX_EXPONENT us (about 12 days). Greater
+ * values are clamped.
+ *
+ * Recording is wait-free: a thread updates only relaxed atomic
+ * counters of its own stripe, so threads do not contend on a lock
+ * nor (mostly) on a cache line. Readers merge all stripes into
+ * a Snapshot.
+ */
+class LatencyHistogram {
+public:
+	enum {
+		SUB_BUCKET_BITS = 4,
+		SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+		MAX_EXPONENT = 40,
+		BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS,
+		STRIPES = 4,
+	};
+
+	/**
+	 * @brief Consistent copy of the histogram at some point in time.
+	 */
+	class Snapshot {
+	public:
+		Snapshot();
+
+		Poco::UInt64 count() const;
+		Poco::Int64 max() const;
+		Poco::Int64 mean() const;
+
+		/**
+		 * @returns sum of all recorded values.
+		 */
+		Poco::UInt64 sum() const;
+
+		/**
+		 * @returns upper bound of the bucket containing the value
+		 * below which the given fraction (0..1) of records falls,
+		 * -1 when there are no records.
+		 */
+		Poco::Int64 percentile(double fraction) const;
+
+	private:
+		friend class LatencyHistogram;
+
+		std::vector<Poco::UInt64> m_counts;
+		Poco::UInt64 m_count;
+		Poco::UInt64 m_sum;
+		Poco::Int64 m_max;
+	};
+
+	LatencyHistogram();
+
+	LatencyHistogram(const LatencyHistogram &) = delete;
+	LatencyHistogram &operator =(const LatencyHistogram &) = delete;
+
+	void record(const Poco::Timespan &latency);
+	void record(Poco::Int64 us);
+
+	Snapshot snapshot() const;
+
+	/**
+	 * Clear all records. Records performed concurrently with reset
+	 * might be partially preserved.
+	 */
+	void reset();
+
+	static unsigned int bucketOf(Poco::Int64 us);
+	static Poco::Int64 lowerBound(unsigned int bucket);
+	static Poco::Int64 upperBound(unsigned int bucket);
+
+private:
+	struct Stripe {
+		std::atomic<Poco::UInt64> counts[BUCKETS];
+		std::atomic<Poco::UInt64> sum;
+		std::atomic<Poco::Int64> max;
+	};
+
+	static unsigned int currentStripe();
+
+	Stripe m_stripes[STRIPES];
+};
+
+}
@@ -0,0 +1,252 @@
+#include <cctype>
+#include <limits>
+
+#include <Poco/Exception.h>
+#include <Poco/SingletonHolder.h>
+
+#include "util/MetricsRegistry.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+static const struct {
+	double value;
+	const char *label;
+} QUANTILES[] = {
+	{0.5, "0.5"},
+	{0.9, "0.9"},
+	{0.99, "0.99"},
+	{0.999, "0.999"},
+};
+
+MetricCounter::MetricCounter():
+	m_value(0)
+{
+}
+
+UInt64 MetricCounter::value() const
+{
+	return m_value.load(memory_order_relaxed);
+}
+
+MetricGauge::MetricGauge():
+	m_value(0)
+{
+}
+
+Int64 MetricGauge::value() const
+{
+	return m_value.load(memory_order_relaxed);
+}
+
+MetricsRegistry &MetricsRegistry::instance()
+{
+	static SingletonHolder<MetricsRegistry> singleton;
+	return *singleton.get();
+}
+
+void MetricsRegistry::assureValidName(const string &name)
+{
+	if (name.empty())
+		throw InvalidArgumentException("metric name must not be empty");
+
+	for (size_t i = 0; i < name.size(); ++i) {
+		const char c = name[i];
+
+		if (isalpha(c) || c == '_' || c == ':')
+			continue;
+		if (i > 0 && isdigit(c))
+			continue;
+
+		throw InvalidArgumentException("invalid metric name: " + name);
+	}
+}
+
+static string escapeLabelValue(const string &value)
+{
+	string result;
+	result.reserve(value.size());
+
+	for (const char c : value) {
+		switch (c) {
+		case '\\':
+			result += "\\\\";
+			break;
+		case '"':
+			result += "\\\"";
+			break;
+		case '\n':
+			result += "\\n";
+			break;
+		default:
+			result += c;
+		}
+	}
+
+	return result;
+}
+
+string MetricsRegistry::formatLabels(const Labels &labels)
+{
+	if (labels.empty())
+		return "";
+
+	string result = "{";
+
+	for (const auto &pair : labels) {
+		if (result.size() > 1)
+			result += ",";
+
+		result += pair.first + "=\"" + escapeLabelValue(pair.second) + "\"";
+	}
+
+	return result + "}";
+}
+
+MetricsRegistry::Family &MetricsRegistry::family(
+		const string &name,
+		const string &help,
+		Type type,
+		const Labels &labels)
+{
+	assureValidName(name);
+
+	for (const auto &pair : labels)
+		assureValidName(pair.first);
+
+	auto it = m_families.find(name);
+	if (it == m_families.end()) {
+		Family family;
+		family.type = type;
+		family.help = help;
+
+		it = m_families.emplace(name, move(family)).first;
+	}
+	else if (it->second.type != type) {
+		throw IllegalStateException(
+			"metric " + name + " is already registered with another type");
+	}
+
+	return it->second;
+}
+
+MetricCounter &MetricsRegistry::counter(
+		const string &name,
+		const string &help,
+		const Labels &labels)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto &counters = family(name, help, COUNTER, labels).counters;
+	auto &counter = counters[labels];
+
+	if (!counter)
+		counter.reset(new MetricCounter);
+
+	return *counter;
+}
+
+MetricGauge &MetricsRegistry::gauge(
+		const string &name,
+		const string &help,
+		const Labels &labels)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto &gauges = family(name, help, GAUGE, labels).gauges;
+	auto &gauge = gauges[labels];
+
+	if (!gauge)
+		gauge.reset(new MetricGauge);
+
+	return *gauge;
+}
+
+LatencyHistogram &MetricsRegistry::histogram(
+		const string &name,
+		const string &help,
+		const Labels &labels)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto &histograms = family(name, help, SUMMARY, labels).histograms;
+	auto &histogram = histograms[labels];
+
+	if (!histogram)
+		histogram.reset(new LatencyHistogram);
+
+	return *histogram;
+}
+
+void MetricsRegistry::printSummary(
+		ostream &out,
+		const string &name,
+		const Labels &labels,
+		const LatencyHistogram &histogram)
+{
+	const LatencyHistogram::Snapshot &snapshot = histogram.snapshot();
+
+	for (const auto &quantile : QUANTILES) {
+		Labels quantileLabels = labels;
+		quantileLabels["quantile"] = quantile.label;
+
+		out << name << formatLabels(quantileLabels) << " ";
+
+		if (snapshot.count() == 0)
+			out << "NaN";
+		else
+			out << snapshot.percentile(quantile.value) / 1000000.0;
+
+		out << "\n";
+	}
+
+	// the sum grows without bound, 6 significant digits would hide
+	// its increments soon, 15 digits represent any sum of microseconds
+	// below 10^15 (about 31 years) exactly
+	const streamsize precision = out.precision(numeric_limits<double>::digits10);
+	out << name << "_sum" << formatLabels(labels)
+		<< " " << snapshot.sum() / 1000000.0 << "\n";
+	out.precision(precision);
+
+	out << name << "_count" << formatLabels(labels) << " " << snapshot.count() << "\n";
+}
+
+void MetricsRegistry::print(ostream &out) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	for (const auto &pair : m_families) {
+		const string &name = pair.first;
+		const Family &family = pair.second;
+
+		out << "# HELP " << name << " " << family.help << "\n";
+
+		switch (family.type) {
+		case COUNTER:
+			out << "# TYPE " << name << " counter\n";
+
+			for (const auto &metric : family.counters) {
+				out << name << formatLabels(metric.first)
+					<< " " << metric.second->value() << "\n";
+			}
+			break;
+
+		case GAUGE:
+			out << "# TYPE " << name << " gauge\n";
+
+			for (const auto &metric : family.gauges) {
+				out << name << formatLabels(metric.first)
+					<< " " << metric.second->value() << "\n";
+			}
+			break;
+
+		case SUMMARY:
+			out << "# TYPE " << name << " summary\n";
+
+			for (const auto &metric : family.histograms)
+				printSummary(out, name, metric.first, *metric.second);
+			break;
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include <Poco/Mutex.h>
+#include <Poco/Types.h>
+
+#include "util/LatencyHistogram.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Monotonically increasing counter. Updates are lock-free
+ * and allocation-free.
+ */
+class MetricCounter {
+public:
+	MetricCounter();
+
+	void inc(Poco::UInt64 count = 1)
+	{
+		m_value.fetch_add(count, std::memory_order_relaxed);
+	}
+
+	Poco::UInt64 value() const;
+
+private:
+	std::atomic<Poco::UInt64> m_value;
+};
+
+/**
+ * @brief Gauge represents a value that can go up and down. Updates
+ * are lock-free and allocation-free.
+ */
+class MetricGauge {
+public:
+	MetricGauge();
+
+	void set(Poco::Int64 value)
+	{
+		m_value.store(value, std::memory_order_relaxed);
+	}
+
+	void inc(Poco::Int64 delta = 1)
+	{
+		m_value.fetch_add(delta, std::memory_order_relaxed);
+	}
+
+	void dec(Poco::Int64 delta = 1)
+	{
+		m_value.fetch_sub(delta, std::memory_order_relaxed);
+	}
+
+	Poco::Int64 value() const;
+
+private:
+	std::atomic<Poco::Int64> m_value;
+};
+
+/**
+ * @brief Central registry of metrics of the gateway. Metrics are
+ * identified by a name and a set of labels. Registration is
+ * serialized by a lock and thus it should be done once, e.g. when
+ * constructing the instrumented object. The returned references are
+ * valid until the end of the process, so the instrumented code keeps
+ * them and updates them without any lock.
+ *
+ * Latencies are represented by LatencyHistogram and exposed as
+ * Prometheus summaries (in seconds).
+ */
+class MetricsRegistry {
+public:
+	typedef std::map<std::string, std::string> Labels;
+
+	static MetricsRegistry &instance();
+
+	MetricCounter &counter(
+		const std::string &name,
+		const std::string &help,
+		const Labels &labels = {});
+
+	MetricGauge &gauge(
+		const std::string &name,
+		const std::string &help,
+		const Labels &labels = {});
+
+	LatencyHistogram &histogram(
+		const std::string &name,
+		const std::string &help,
+		const Labels &labels = {});
+
+	/**
+	 * Write all metrics in the Prometheus text exposition
+	 * format (version 0.0.4).
+	 */
+	void print(std::ostream &out) const;
+
+	static void assureValidName(const std::string &name);
+
+	/**
+	 * @returns labels formatted as {name="value",...} or an empty
+	 * string if there are no labels.
+	 */
+	static std::string formatLabels(const Labels &labels);
+
+private:
+	enum Type {
+		COUNTER,
+		GAUGE,
+		SUMMARY,
+	};
+
+	struct Family {
+		Type type;
+		std::string help;
+		std::map<Labels, std::unique_ptr<MetricCounter>> counters;
+		std::map<Labels, std::unique_ptr<MetricGauge>> gauges;
+		std::map<Labels, std::unique_ptr<LatencyHistogram>> histograms;
+	};
+
+	Family &family(
+		const std::string &name,
+		const std::string &help,
+		Type type,
+		const Labels &labels);
+
+	static void printSummary(
+		std::ostream &out,
+		const std::string &name,
+		const Labels &labels,
+		const LatencyHistogram &histogram);
+
+private:
+	mutable Poco::FastMutex m_lock;
+	std::map<std::string, Family> m_families;
+};
+
+}
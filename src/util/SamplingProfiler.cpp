@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/NumberFormatter.h>
+#include <Poco/SingletonHolder.h>
+
+#include "util/SamplingProfiler.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+/**
+ * Frames of the signal handler and of the signal trampoline
+ * at the top of each backtrace.
+ */
+static const int SKIP_FRAMES = 2;
+
+static atomic<SamplingProfiler *> activeProfiler(nullptr);
+static thread_local const char *threadRole = nullptr;
+
+static sem_t toggleSemaphore;
+static atomic<bool> toggleReady(false);
+
+SamplingProfiler::SamplingProfiler():
+	m_head(0),
+	m_clearedAt(0),
+	m_running(false)
+{
+}
+
+SamplingProfiler::~SamplingProfiler()
+{
+	if (m_running)
+		stop();
+}
+
+SamplingProfiler &SamplingProfiler::instance()
+{
+	static SingletonHolder<SamplingProfiler> singleton;
+	return *singleton.get();
+}
+
+void SamplingProfiler::labelThread(const char *role)
+{
+	threadRole = role;
+}
+
+void SamplingProfiler::onSignal(int)
+{
+	const int savedErrno = errno;
+
+	SamplingProfiler *profiler = activeProfiler.load(memory_order_acquire);
+	if (profiler != nullptr) {
+		void *frames[MAX_DEPTH + SKIP_FRAMES];
+		const int depth = ::backtrace(frames, MAX_DEPTH + SKIP_FRAMES);
+
+		if (depth > SKIP_FRAMES)
+			profiler->record(frames + SKIP_FRAMES, depth - SKIP_FRAMES);
+	}
+
+	errno = savedErrno;
+}
+
+void SamplingProfiler::record(void **frames, int depth)
+{
+	const UInt64 index = m_head.fetch_add(1, memory_order_relaxed);
+	Sample &sample = m_samples[index % CAPACITY];
+
+	sample.sequence.store(0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	sample.role = threadRole;
+	sample.tid = ::syscall(SYS_gettid);
+	sample.depth = depth;
+
+	for (int i = 0; i < depth; ++i)
+		sample.frames[i] = frames[i];
+
+	sample.sequence.store(index + 1, memory_order_release);
+}
+
+void SamplingProfiler::start(const Timespan &interval)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_running)
+		throw IllegalStateException("profiler is already running");
+
+	if (interval <= 0)
+		throw InvalidArgumentException("sampling interval must be positive");
+
+	if (!m_samples) {
+		m_samples.reset(new Sample[CAPACITY]);
+
+		for (size_t i = 0; i < CAPACITY; ++i)
+			m_samples[i].sequence.store(0, memory_order_relaxed);
+	}
+
+	// the first call of backtrace() loads libgcc which is not
+	// safe to do from within a signal handler
+	void *dummy[1];
+	::backtrace(dummy, 1);
+
+	struct sigaction action;
+	::memset(&action, 0, sizeof(action));
+	action.sa_handler = &SamplingProfiler::onSignal;
+	action.sa_flags = SA_RESTART;
+	::sigemptyset(&action.sa_mask);
+
+	if (::sigaction(SIGPROF, &action, nullptr) < 0)
+		throw SystemException("sigaction: " + string(::strerror(errno)));
+
+	activeProfiler.store(this, memory_order_release);
+	m_running = true;
+
+	struct itimerval timer;
+	timer.it_interval.tv_sec = interval.totalSeconds();
+	timer.it_interval.tv_usec = interval.totalMicroseconds() % Timespan::SECONDS;
+	timer.it_value = timer.it_interval;
+
+	if (::setitimer(ITIMER_PROF, &timer, nullptr) < 0) {
+		activeProfiler.store(nullptr, memory_order_release);
+		m_running = false;
+
+		throw SystemException("setitimer: " + string(::strerror(errno)));
+	}
+
+	logger().information(
+		"profiler started with interval "
+		+ to_string(interval.totalMicroseconds()) + " us",
+		__FILE__, __LINE__);
+}
+
+void SamplingProfiler::stop()
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (!m_running)
+		return;
+
+	struct itimerval timer;
+	::memset(&timer, 0, sizeof(timer));
+	::setitimer(ITIMER_PROF, &timer, nullptr);
+
+	// the handler stays installed as a pending SIGPROF
+	// would terminate the process otherwise
+	activeProfiler.store(nullptr, memory_order_release);
+	m_running = false;
+
+	logger().information(
+		"profiler stopped, " + to_string(sampleCount()) + " samples",
+		__FILE__, __LINE__);
+}
+
+bool SamplingProfiler::running() const
+{
+	return m_running;
+}
+
+void SamplingProfiler::clear()
+{
+	m_clearedAt = m_head.load();
+}
+
+UInt64 SamplingProfiler::sampleCount() const
+{
+	return m_head.load() - m_clearedAt.load();
+}
+
+string SamplingProfiler::symbolName(void *address) const
+{
+	Dl_info info;
+
+	if (::dladdr(address, &info) == 0 || info.dli_fname == nullptr)
+		return NumberFormatter::formatHex(reinterpret_cast<UIntPtr>(address), true);
+
+	if (info.dli_sname != nullptr) {
+		int status = 0;
+		char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+
+		string name = status == 0 ? demangled : info.dli_sname;
+		::free(demangled);
+
+		// semicolon separates frames in the folded format
+		replace(name.begin(), name.end(), ';', ':');
+		return name;
+	}
+
+	// offset within the module usable with addr2line
+	const char *module = ::strrchr(info.dli_fname, '/');
+	const UIntPtr offset = reinterpret_cast<UIntPtr>(address)
+		- reinterpret_cast<UIntPtr>(info.dli_fbase);
+
+	return string(module == nullptr ? info.dli_fname : module + 1)
+		+ "+" + NumberFormatter::formatHex(offset, true);
+}
+
+void SamplingProfiler::dump(ostream &out) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (!m_samples)
+		return;
+
+	const UInt64 head = m_head.load(memory_order_acquire);
+	UInt64 from = m_clearedAt.load();
+
+	if (head > CAPACITY && head - CAPACITY > from)
+		from = head - CAPACITY;
+
+	map<void *, string> symbols;
+	map<string, size_t> stacks;
+
+	for (UInt64 i = from; i < head; ++i) {
+		const Sample &sample = m_samples[i % CAPACITY];
+
+		const UInt64 sequence = sample.sequence.load(memory_order_acquire);
+		if (sequence != i + 1)
+			continue;
+
+		const char *role = sample.role;
+		const pid_t tid = sample.tid;
+		const int depth = min<int>(sample.depth, MAX_DEPTH);
+		void *frames[MAX_DEPTH];
+
+		for (int k = 0; k < depth; ++k)
+			frames[k] = sample.frames[k];
+
+		// the slot might have been overwritten while copying
+		atomic_thread_fence(memory_order_acquire);
+		if (sample.sequence.load(memory_order_relaxed) != sequence)
+			continue;
+
+		// unlabelled threads are distinguished by their TID
+		string stack = role == nullptr ? "tid-" + to_string(tid) : role;
+
+		for (int k = depth - 1; k >= 0; --k) {
+			auto it = symbols.find(frames[k]);
+			if (it == symbols.end())
+				it = symbols.emplace(frames[k], symbolName(frames[k])).first;
+
+			stack += ";" + it->second;
+		}
+
+		stacks[stack] += 1;
+	}
+
+	for (const auto &pair : stacks)
+		out << pair.first << " " << pair.second << "\n";
+}
+
+void SamplingProfiler::startToggleHandler(const string &dumpPath)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (toggleReady)
+		throw IllegalStateException("toggle handler is already running");
+
+	if (::sem_init(&toggleSemaphore, 0, 0) < 0)
+		throw SystemException("sem_init: " + string(::strerror(errno)));
+
+	m_dumpPath = dumpPath;
+	toggleReady = true;
+
+	m_toggleThread.setName("profiler");
+	m_toggleThread.startFunc([this]() {
+		runToggleHandler();
+	});
+}
+
+void SamplingProfiler::requestToggle()
+{
+	if (toggleReady)
+		::sem_post(&toggleSemaphore);
+}
+
+void SamplingProfiler::runToggleHandler()
+{
+	labelThread("profiler");
+
+	while (true) {
+		if (::sem_wait(&toggleSemaphore) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			logger().critical(
+				"sem_wait: " + string(::strerror(errno)),
+				__FILE__, __LINE__);
+			break;
+		}
+
+		try {
+			if (running()) {
+				stop();
+				writeDump();
+			}
+			else {
+				clear();
+				start();
+			}
+		}
+		BEEEON_CATCH_CHAIN(logger())
+	}
+}
+
+void SamplingProfiler::writeDump() const
+{
+	ostringstream out;
+	dump(out);
+
+	// the gateway usually runs as root, never follow a symlink
+	// planted in place of the dump file and never block on a FIFO
+	const int fd = ::open(m_dumpPath.c_str(),
+		O_WRONLY | O_CREAT | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC, 0600);
+	if (fd < 0)
+		throw FileException("open " + m_dumpPath + ": " + string(::strerror(errno)));
+
+	// a hard link or a foreign file must be left untouched
+	struct stat st;
+	if (::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)
+			|| st.st_nlink != 1 || st.st_uid != ::geteuid()) {
+		::close(fd);
+		throw FileException("refusing to write into " + m_dumpPath);
+	}
+
+	if (::ftruncate(fd, 0) < 0) {
+		const string error = ::strerror(errno);
+		::close(fd);
+		throw WriteFileException("truncate " + m_dumpPath + ": " + error);
+	}
+
+	const string &content = out.str();
+	size_t written = 0;
+
+	while (written < content.size()) {
+		const ssize_t ret = ::write(fd, content.data() + written, content.size() - written);
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret < 0) {
+			const string error = ::strerror(errno);
+			::close(fd);
+			throw WriteFileException("write " + m_dumpPath + ": " + error);
+		}
+
+		written += ret;
+	}
+
+	::close(fd);
+
+	logger().notice("folded stacks written to " + m_dumpPath, __FILE__, __LINE__);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include <sys/types.h>
+
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Statistical CPU profiler of the whole process. When running,
+ * the SIGPROF timer fires after each interval of the consumed CPU time
+ * and the interrupted thread stores its backtrace into a lock-free ring
+ * buffer. The collected samples can be dumped as folded stacks suitable
+ * for generating flame graphs (flamegraph.pl, speedscope, etc.).
+ *
+ * Threads can be labelled by their role via labelThread(). The label
+ * is the first element of each folded stack so samples of different
+ * threads can be attributed. Unlabelled threads are reported by TID.
+ *
+ * When the ring buffer is full, the oldest samples are overwritten.
+ * The buffer is allocated by the first start() so the profiler costs
+ * nothing unless it is used.
+ */
+class SamplingProfiler : protected Loggable {
+public:
+	enum {
+		CAPACITY = 4096,
+		MAX_DEPTH = 32,
+	};
+
+	SamplingProfiler();
+	~SamplingProfiler();
+
+	static SamplingProfiler &instance();
+
+	/**
+	 * Label the calling thread by the given role. The role must
+	 * have static storage duration (e.g. a string literal) as it
+	 * is referenced from the signal handler.
+	 */
+	static void labelThread(const char *role);
+
+	/**
+	 * Start sampling with the given interval of CPU time.
+	 * @throws IllegalStateException when already running
+	 */
+	void start(const Poco::Timespan &interval = 10 * Poco::Timespan::MILLISECONDS);
+
+	/**
+	 * Stop sampling. The collected samples are kept until clear().
+	 */
+	void stop();
+
+	bool running() const;
+
+	/**
+	 * Drop all collected samples.
+	 */
+	void clear();
+
+	/**
+	 * @returns number of samples collected since the last clear()
+	 * including those that have been overwritten.
+	 */
+	Poco::UInt64 sampleCount() const;
+
+	/**
+	 * Write the collected samples as folded stacks, one stack per line:
+	 * <role>;<outermost>;...;<innermost> <count>
+	 */
+	void dump(std::ostream &out) const;
+
+	/**
+	 * Start a helper thread toggling the profiler upon requestToggle().
+	 * When the profiler is toggled off, the folded stacks are written
+	 * into the given file. The file is created with mode 0600 and it
+	 * is never opened through a symlink. An existing file is replaced
+	 * only when it is a regular file of the current user with no other
+	 * hard links.
+	 */
+	void startToggleHandler(const std::string &dumpPath);
+
+	/**
+	 * Ask the toggle handler to start or stop the profiler.
+	 * The call is async-signal-safe.
+	 */
+	static void requestToggle();
+
+private:
+	struct Sample {
+		std::atomic<Poco::UInt64> sequence;
+		const char *role;
+		pid_t tid;
+		int depth;
+		void *frames[MAX_DEPTH];
+	};
+
+	static void onSignal(int sig);
+	void record(void **frames, int depth);
+
+	void runToggleHandler();
+	void writeDump() const;
+
+	std::string symbolName(void *address) const;
+
+private:
+	std::unique_ptr<Sample[]> m_samples;
+	std::atomic<Poco::UInt64> m_head;
+	std::atomic<Poco::UInt64> m_clearedAt;
+	std::atomic<bool> m_running;
+
+	mutable Poco::FastMutex m_lock;
+	std::string m_dumpPath;
+	Poco::Thread m_toggleThread;
+};
+
+}
@@ -0,0 +1,85 @@
+#include <sstream>
+
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+#include <Poco/StringTokenizer.h>
+
+#include "di/Injectable.h"
+#include "util/StartupReporter.h"
+#include "util/StartupTracer.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, StartupReporter)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_PROPERTY("budget", &StartupReporter::setBudget)
+BEEEON_OBJECT_PROPERTY("exportBudget", &StartupReporter::setExportBudget)
+BEEEON_OBJECT_END(BeeeOn, StartupReporter)
+
+using namespace std;
+using namespace Poco;
+using namespace BeeeOn;
+
+static const Timespan POLL_INTERVAL = 1 * Timespan::SECONDS;
+
+StartupReporter::StartupReporter():
+	m_budget(10 * Timespan::SECONDS),
+	m_exportBudget(60 * Timespan::SECONDS)
+{
+}
+
+void StartupReporter::setBudget(const Timespan &budget)
+{
+	if (budget <= 0)
+		throw InvalidArgumentException("budget must be positive");
+
+	m_budget = budget;
+}
+
+void StartupReporter::setExportBudget(const Timespan &budget)
+{
+	if (budget <= 0)
+		throw InvalidArgumentException("export budget must be positive");
+
+	m_exportBudget = budget;
+}
+
+void StartupReporter::checkBudget(const string &milestone, const Timespan &budget)
+{
+	StartupTracer &tracer = StartupTracer::instance();
+
+	if (tracer.withinBudget(milestone, budget))
+		return;
+
+	logger().warning(
+		"milestone " + milestone + " reached after "
+		+ to_string(tracer.milestone(milestone).totalMilliseconds())
+		+ " ms, budget is " + to_string(budget.totalMilliseconds()) + " ms",
+		__FILE__, __LINE__);
+}
+
+void StartupReporter::run()
+{
+	StopControl::Run run(m_stopControl);
+	StartupTracer &tracer = StartupTracer::instance();
+
+	tracer.mark("started");
+
+	ostringstream out;
+	tracer.print(out);
+
+	StringTokenizer lines(out.str(), "\n", StringTokenizer::TOK_IGNORE_EMPTY);
+	for (const auto &line : lines)
+		logger().information(line, __FILE__, __LINE__);
+
+	checkBudget("started", m_budget);
+
+	while (run && tracer.milestone("first-export") < 0)
+		run.waitStoppable(POLL_INTERVAL);
+
+	if (tracer.milestone("first-export") >= 0)
+		checkBudget("first-export", m_exportBudget);
+}
+
+void StartupReporter::stop()
+{
+	m_stopControl.requestStop();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Poco/Timespan.h>
+
+#include "loop/StopControl.h"
+#include "loop/StoppableRunnable.h"
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief StartupReporter marks the milestone "started" when it is run,
+ * i.e. after all instances have been created by the dependency injection
+ * and their "done" hooks finished. It logs the phases recorded by the
+ * StartupTracer and waits for the milestone "first-export". Reaching
+ * a milestone after its budget is reported as a warning.
+ */
+class StartupReporter : public StoppableRunnable, protected Loggable {
+public:
+	StartupReporter();
+
+	/**
+	 * Budget of time to reach the milestone "started".
+	 */
+	void setBudget(const Poco::Timespan &budget);
+
+	/**
+	 * Budget of time to reach the milestone "first-export".
+	 */
+	void setExportBudget(const Poco::Timespan &budget);
+
+	void run() override;
+	void stop() override;
+
+protected:
+	void checkBudget(const std::string &milestone, const Poco::Timespan &budget);
+
+private:
+	Poco::Timespan m_budget;
+	Poco::Timespan m_exportBudget;
+	StopControl m_stopControl;
+};
+
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <iomanip>
+
+#include <Poco/SingletonHolder.h>
+
+#include "util/StartupTracer.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+StartupTracer::Scope::Scope(const string &name, StartupTracer &tracer):
+	m_tracer(tracer),
+	m_name(name)
+{
+}
+
+StartupTracer::Scope::~Scope()
+{
+	try {
+		m_tracer.record(m_name, m_started, m_started.elapsed());
+	}
+	catch (...) {
+	}
+}
+
+StartupTracer::StartupTracer()
+{
+}
+
+StartupTracer &StartupTracer::instance()
+{
+	static SingletonHolder<StartupTracer> singleton;
+	return *singleton.get();
+}
+
+Timespan StartupTracer::elapsed() const
+{
+	return m_origin.elapsed();
+}
+
+void StartupTracer::record(
+		const string &name,
+		const Clock &started,
+		const Timespan &duration)
+{
+	FastMutex::ScopedLock guard(m_lock);
+	m_phases.push_back({name, started - m_origin, duration});
+}
+
+void StartupTracer::mark(const string &name)
+{
+	const Timespan at = elapsed();
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	if (m_milestones.emplace(name, at).second) {
+		logger().information(
+			"startup milestone " + name + " reached after "
+			+ to_string(at.totalMilliseconds()) + " ms",
+			__FILE__, __LINE__);
+	}
+}
+
+Timespan StartupTracer::milestone(const string &name) const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto it = m_milestones.find(name);
+	if (it == m_milestones.end())
+		return -1;
+
+	return it->second;
+}
+
+vector<StartupTracer::Phase> StartupTracer::phases() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	vector<Phase> result(m_phases);
+
+	stable_sort(result.begin(), result.end(),
+		[](const Phase &a, const Phase &b) {
+			return a.start < b.start;
+		});
+
+	return result;
+}
+
+bool StartupTracer::withinBudget(
+		const string &milestone,
+		const Timespan &budget) const
+{
+	const Timespan at = this->milestone(milestone);
+	return at >= 0 && at <= budget;
+}
+
+void StartupTracer::print(ostream &out) const
+{
+	vector<Phase> phases = this->phases();
+	vector<pair<string, Timespan>> milestones;
+
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		milestones.assign(m_milestones.begin(), m_milestones.end());
+	}
+
+	stable_sort(phases.begin(), phases.end(),
+		[](const Phase &a, const Phase &b) {
+			return a.duration > b.duration;
+		});
+
+	stable_sort(milestones.begin(), milestones.end(),
+		[](const pair<string, Timespan> &a, const pair<string, Timespan> &b) {
+			return a.second < b.second;
+		});
+
+	for (const auto &phase : phases) {
+		out << setw(8) << phase.duration.totalMilliseconds() << " ms "
+			<< phase.name
+			<< " (at " << phase.start.totalMilliseconds() << " ms)"
+			<< "\n";
+	}
+
+	for (const auto &milestone : milestones) {
+		out << setw(8) << milestone.second.totalMilliseconds() << " ms "
+			<< "milestone " << milestone.first
+			<< "\n";
+	}
+}
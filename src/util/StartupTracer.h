@@ -0,0 +1,102 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Poco/Clock.h>
+#include <Poco/Mutex.h>
+#include <Poco/Timespan.h>
+
+#include "util/Loggable.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Records durations of startup phases of the gateway (e.g.
+ * "done" hooks of instances created by the dependency injection)
+ * and times of milestones (e.g. the first export of data) relative
+ * to the start of the process.
+ *
+ * The origin of time is the creation of the tracer, thus it should
+ * be created at the very beginning of main() by calling instance().
+ */
+class StartupTracer : protected Loggable {
+public:
+	struct Phase {
+		std::string name;
+		Poco::Timespan start;
+		Poco::Timespan duration;
+	};
+
+	/**
+	 * @brief Records duration of its lifetime as a phase.
+	 */
+	class Scope {
+	public:
+		Scope(const std::string &name,
+			StartupTracer &tracer = StartupTracer::instance());
+		~Scope();
+
+		Scope(const Scope &) = delete;
+		Scope &operator =(const Scope &) = delete;
+
+	private:
+		StartupTracer &m_tracer;
+		std::string m_name;
+		Poco::Clock m_started;
+	};
+
+	StartupTracer();
+
+	static StartupTracer &instance();
+
+	/**
+	 * @returns time elapsed since creation of the tracer
+	 */
+	Poco::Timespan elapsed() const;
+
+	void record(
+		const std::string &name,
+		const Poco::Clock &started,
+		const Poco::Timespan &duration);
+
+	/**
+	 * Record the current time as the given milestone. Only the first
+	 * occurrence of each milestone is recorded.
+	 */
+	void mark(const std::string &name);
+
+	/**
+	 * @returns time of the milestone or -1 if it has not been reached
+	 */
+	Poco::Timespan milestone(const std::string &name) const;
+
+	/**
+	 * @returns recorded phases ordered by their start
+	 */
+	std::vector<Phase> phases() const;
+
+	/**
+	 * @returns true when the milestone has been reached within
+	 * the given budget
+	 */
+	bool withinBudget(
+		const std::string &milestone,
+		const Poco::Timespan &budget) const;
+
+	/**
+	 * Print phases ordered by their duration (the longest first)
+	 * followed by milestones in the order they were reached.
+	 */
+	void print(std::ostream &out) const;
+
+private:
+	Poco::Clock m_origin;
+	mutable Poco::FastMutex m_lock;
+	std::vector<Phase> m_phases;
+	std::map<std::string, Poco::Timespan> m_milestones;
+};
+
+}
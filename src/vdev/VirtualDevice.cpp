@@ -9,7 +9,9 @@ using namespace Poco;
 using namespace std;
 
 VirtualDevice::VirtualDevice():
-	m_refresh(5 * Timespan::SECONDS)
+	m_refresh(5 * Timespan::SECONDS),
+	m_jitter(0),
+	m_burst(1)
 {
 }
 
@@ -80,6 +82,33 @@ void VirtualDevice::setRefresh(Timespan refresh)
 	m_refresh = refresh;
 }
 
+Timespan VirtualDevice::jitter() const
+{
+	return m_jitter;
+}
+
+void VirtualDevice::setJitter(Timespan jitter)
+{
+	if (jitter < 0)
+		throw InvalidArgumentException(
+			"invalid jitter: " + to_string(jitter.totalMilliseconds()));
+
+	m_jitter = jitter;
+}
+
+unsigned int VirtualDevice::burst() const
+{
+	return m_burst;
+}
+
+void VirtualDevice::setBurst(unsigned int burst)
+{
+	if (burst == 0)
+		throw InvalidArgumentException("invalid burst: 0");
+
+	m_burst = burst;
+}
+
 void VirtualDevice::setDeviceId(const DeviceID &deviceId)
 {
 	m_deviceID = deviceId;
@@ -38,12 +38,28 @@ public:
 	void setRefresh(Poco::Timespan refresh);
 	Poco::Timespan refresh() const;
 
+	/**
+	 * Set maximal random deviation of the refresh time. Each activation
+	 * of the device is planned to refresh +/- random(jitter).
+	 */
+	void setJitter(Poco::Timespan jitter);
+	Poco::Timespan jitter() const;
+
+	/**
+	 * Set count of SensorData generated and shipped back-to-back
+	 * on each activation of the device.
+	 */
+	void setBurst(unsigned int burst);
+	unsigned int burst() const;
+
 	bool modifyValue(
 		const ModuleID &moduleID, double value);
 	SensorData generate();
 
 private:
 	Poco::Timespan m_refresh;
+	Poco::Timespan m_jitter;
+	unsigned int m_burst;
 	std::string m_vendorName;
 	std::string m_productName;
 	std::list<VirtualModule::Ptr> m_modules;
@@ -1,6 +1,7 @@
 #include <sstream>
 
 #include <Poco/NumberParser.h>
+#include <Poco/Thread.h>
 #include <Poco/Util/AbstractConfiguration.h>
 
 #include "commands/DeviceAcceptCommand.h"
@@ -13,6 +14,7 @@
 #include "core/Distributor.h"
 #include "di/Injectable.h"
 #include "model/SensorData.h"
+#include "util/StartupTracer.h"
 #include "vdev/VirtualDeviceManager.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, VirtualDeviceManager)
@@ -32,6 +34,7 @@ using namespace Poco::Util;
 using namespace std;
 
 const static unsigned int DEFAULT_REFRESH_SECS = 30;
+const static unsigned int MAX_SHARDS = 64;
 
 VirtualDeviceManager::VirtualDeviceManager():
 	DeviceManager(DevicePrefix::PREFIX_VIRTUAL_DEVICE, {
@@ -41,6 +44,25 @@ VirtualDeviceManager::VirtualDeviceManager():
 		typeid(DeviceSetValueCommand),
 	})
 {
+	m_shards.emplace_back(new Shard);
+}
+
+VirtualDeviceManager::ShardRunnable::ShardRunnable(
+		VirtualDeviceManager &manager,
+		Shard &shard):
+	m_manager(manager),
+	m_shard(shard)
+{
+}
+
+void VirtualDeviceManager::ShardRunnable::run()
+{
+	m_manager.runShard(m_shard);
+}
+
+VirtualDeviceManager::Shard &VirtualDeviceManager::shardOf(const DeviceID &id)
+{
+	return *m_shards[id.ident() % m_shards.size()];
 }
 
 void VirtualDeviceManager::registerDevice(
@@ -74,7 +96,13 @@ void VirtualDeviceManager::logDeviceParsed(VirtualDevice::Ptr device)
 		+ ", paired: "
 		+ (deviceCache()->paired(device->deviceID()) ? "yes" : "no")
 		+ ", refresh: "
-		+ to_string(device->refresh().totalSeconds())
+		+ to_string(device->refresh().totalMilliseconds())
+		+ " ms"
+		+ ", jitter: "
+		+ to_string(device->jitter().totalMilliseconds())
+		+ " ms"
+		+ ", burst: "
+		+ to_string(device->burst())
 		+ ", vendor: "
 		+ device->vendorName()
 		+ ", product: "
@@ -96,11 +124,15 @@ void VirtualDeviceManager::logDeviceParsed(VirtualDevice::Ptr device)
 }
 
 VirtualDevice::Ptr VirtualDeviceManager::parseDevice(
-	AutoPtr <AbstractConfiguration> cfg)
+	AutoPtr <AbstractConfiguration> cfg,
+	unsigned int instance)
 {
 	VirtualDevice::Ptr device = new VirtualDevice;
 
 	DeviceID id = DeviceID::parse(cfg->getString("device_id"));
+	if (instance > 0)
+		id = DeviceID(id.prefix(), id.ident() + instance);
+
 	if (id.prefix() != DevicePrefix::PREFIX_VIRTUAL_DEVICE) {
 		device->setDeviceId(
 			DeviceID(DevicePrefix::PREFIX_VIRTUAL_DEVICE, id.ident()));
@@ -115,8 +147,17 @@ VirtualDevice::Ptr VirtualDeviceManager::parseDevice(
 		device->setDeviceId(id);
 	}
 
-	unsigned int refresh = cfg->getUInt("refresh", DEFAULT_REFRESH_SECS);
-	device->setRefresh(refresh * Timespan::SECONDS);
+	if (cfg->has("refresh_ms")) {
+		device->setRefresh(
+			cfg->getUInt("refresh_ms") * Timespan::MILLISECONDS);
+	}
+	else {
+		unsigned int refresh = cfg->getUInt("refresh", DEFAULT_REFRESH_SECS);
+		device->setRefresh(refresh * Timespan::SECONDS);
+	}
+
+	device->setJitter(cfg->getUInt("jitter_ms", 0) * Timespan::MILLISECONDS);
+	device->setBurst(cfg->getUInt("burst", 1));
 
 	if (cfg->getBool("paired", false))
 		deviceCache()->markPaired(id);
@@ -142,7 +183,9 @@ VirtualDevice::Ptr VirtualDeviceManager::parseDevice(
 			break;
 		}
 	}
-	logDeviceParsed(device);
+
+	if (instance == 0)
+		logDeviceParsed(device);
 
 	return device;
 }
@@ -170,37 +213,63 @@ void VirtualDeviceManager::setConfigFile(const string &file)
 
 void VirtualDeviceManager::installVirtualDevices()
 {
+	StartupTracer::Scope trace("VirtualDeviceManager::installVirtualDevices");
+
 	logger().information("loading configuration from: " + m_configFile);
 	AutoPtr<AbstractConfiguration> cfg = new IniFileConfiguration(m_configFile);
 
 	m_requestDeviceList =
 		cfg->getBool("virtual-devices.request.device_list", true);
 
+	const unsigned int shards = cfg->getUInt("virtual-devices.shards", 1);
+	if (shards < 1 || shards > MAX_SHARDS) {
+		throw InvalidArgumentException(
+			"shards must be in range 1.." + to_string(MAX_SHARDS));
+	}
+
+	m_shards.clear();
+	for (unsigned int i = 0; i < shards; ++i)
+		m_shards.emplace_back(new Shard);
+
 	for (int i = 0; cfg->has("virtual-device" + to_string(i) + ".enable"); ++i) {
 		const string &prefix = "virtual-device" + to_string(i);
 
 		if (!cfg->getBool(prefix + ".enable", false))
 			continue;
 
-		try {
-			VirtualDevice::Ptr device = parseDevice(
-				cfg->createView(prefix));
-			registerDevice(device);
+		const unsigned int instances = cfg->getUInt(prefix + ".instances", 1);
+
+		for (unsigned int k = 0; k < instances; ++k) {
+			try {
+				VirtualDevice::Ptr device = parseDevice(
+					cfg->createView(prefix), k);
+				registerDevice(device);
+			}
+			catch (const Exception &ex) {
+				logger().log(ex, __FILE__, __LINE__);
+				logger().error(
+					"virtual device was not parsed or registered successfully",
+					__FILE__, __LINE__
+				);
+				break;
+			}
 		}
-		catch (const Exception &ex) {
-			logger().log(ex, __FILE__, __LINE__);
-			logger().error(
-				"virtual device was not parsed or registered successfully",
+
+		if (instances > 1) {
+			logger().information(
+				"virtual device template " + prefix
+				+ " instantiated " + to_string(instances) + " times",
 				__FILE__, __LINE__
 			);
-			continue;
 		}
 	}
 
 	logger().information(
 		"loaded "
 		+ to_string(m_virtualDevicesMap.size())
-		+ " virtual devices",
+		+ " virtual devices in "
+		+ to_string(m_shards.size())
+		+ " shard(s)",
 		__FILE__, __LINE__
 	);
 }
@@ -220,7 +289,6 @@ void VirtualDeviceManager::dispatchNewDevice(VirtualDevice::Ptr device)
 void VirtualDeviceManager::doListenCommand(
 	const GatewayListenCommand::Ptr)
 {
-	FastMutex::ScopedLock guard(m_lock);
 	for (auto &item : m_virtualDevicesMap) {
 		if (!deviceCache()->paired(item.first))
 			dispatchNewDevice(item.second);
@@ -230,11 +298,13 @@ void VirtualDeviceManager::doListenCommand(
 void VirtualDeviceManager::doDeviceAcceptCommand(
 		const DeviceAcceptCommand::Ptr cmd)
 {
-	FastMutex::ScopedLock guard(m_lock);
 	auto it = m_virtualDevicesMap.find(cmd->deviceID());
 	if (it == m_virtualDevicesMap.end())
 		throw NotFoundException("accept " + cmd->deviceID().toString());
 
+	Shard &shard = shardOf(cmd->deviceID());
+	FastMutex::ScopedLock guard(shard.lock);
+
 	if (deviceCache()->paired(cmd->deviceID())) {
 		logger().warning(
 			"ignoring accept for paired device "
@@ -243,15 +313,13 @@ void VirtualDeviceManager::doDeviceAcceptCommand(
 		);
 	}
 
-	const VirtualDeviceEntry entry(it->second);
 	deviceCache()->markPaired(cmd->deviceID());
-	scheduleEntryUnlocked(entry);
+	pairAndScheduleUnlocked(shard, it->second);
 }
 
 void VirtualDeviceManager::doUnpairCommand(
 		const DeviceUnpairCommand::Ptr cmd)
 {
-	FastMutex::ScopedLock guard(m_lock);
 	auto it = m_virtualDevicesMap.find(cmd->deviceID());
 	if (it == m_virtualDevicesMap.end()) {
 		logger().warning(
@@ -263,6 +331,9 @@ void VirtualDeviceManager::doUnpairCommand(
 		return;
 	}
 
+	Shard &shard = shardOf(cmd->deviceID());
+	FastMutex::ScopedLock guard(shard.lock);
+
 	if (!deviceCache()->paired(cmd->deviceID())) {
 		logger().warning(
 			"unpairing device that is not paired: "
@@ -272,16 +343,18 @@ void VirtualDeviceManager::doUnpairCommand(
 	}
 
 	deviceCache()->markUnpaired(cmd->deviceID());
+	shard.paired.erase(cmd->deviceID());
 }
 
 void VirtualDeviceManager::doSetValueCommand(
 	const DeviceSetValueCommand::Ptr cmd)
 {
-	FastMutex::ScopedLock guard(m_lock);
 	auto it = m_virtualDevicesMap.find(cmd->deviceID());
 	if (it == m_virtualDevicesMap.end())
 		throw NotFoundException("set-value: " + cmd->deviceID().toString());
 
+	FastMutex::ScopedLock guard(shardOf(cmd->deviceID()).lock);
+
 	for (auto &item : it->second->modules()) {
 		if (item->moduleID() == cmd->moduleID()) {
 			if (item->reaction() == VirtualModule::REACTION_NONE) {
@@ -330,126 +403,148 @@ void VirtualDeviceManager::handleRemoteStatus(
 
 void VirtualDeviceManager::scheduleAllEntries()
 {
-	FastMutex::ScopedLock guard(m_lock);
 	for (auto &item : m_virtualDevicesMap) {
-		if (deviceCache()->paired(item.first)) {
-			const VirtualDeviceEntry entry(item.second);
-			scheduleEntryUnlocked(VirtualDeviceEntry(item.second));
-		}
-	}
-}
+		Shard &shard = shardOf(item.first);
+		FastMutex::ScopedLock guard(shard.lock);
 
-bool VirtualDeviceManager::isEmptyQueue()
-{
-	FastMutex::ScopedLock guard(m_lock);
-	return m_virtualDeviceQueue.empty();
+		if (deviceCache()->paired(item.first))
+			pairAndScheduleUnlocked(shard, item.second);
+		else
+			shard.paired.erase(item.first);
+	}
 }
 
 void VirtualDeviceManager::run()
 {
 	scheduleAllEntries();
 
-	StopControl::Run run(m_stopControl);
+	vector<SharedPtr<ShardRunnable>> runnables;
+	vector<SharedPtr<Thread>> threads;
 
-	while (run) {
-		if (isEmptyQueue()) {
-			logger().debug(
-				"empty queue of devices",
-				__FILE__, __LINE__);
-			run.waitStoppable(-1);
-			continue;
-		}
+	for (size_t i = 1; i < m_shards.size(); ++i) {
+		runnables.emplace_back(new ShardRunnable(*this, *m_shards[i]));
+		threads.emplace_back(new Thread("vdev-shard-" + to_string(i)));
+		threads.back()->start(*runnables.back());
+	}
 
-		ScopedLockWithUnlock<FastMutex> guard(m_lock);
-		const VirtualDeviceEntry entry = m_virtualDeviceQueue.top();
+	runShard(*m_shards.front());
 
-		if (!deviceCache()->paired(entry.device()->deviceID())) {
-			logger().debug(
-				"unpaired device "
-				+ entry.device()->deviceID().toString()
-				+ " was removed from queue",
-				__FILE__, __LINE__);
-			m_virtualDeviceQueue.pop();
-			continue;
-		}
+	for (auto thread : threads)
+		thread->join();
+}
+
+void VirtualDeviceManager::runShard(Shard &shard)
+{
+	StopControl::Run run(shard.stopControl);
+	vector<VirtualDeviceEntry> expired;
+	vector<SensorData> generated;
+
+	while (run) {
+		ScopedLockWithUnlock<FastMutex> guard(shard.lock);
 
-		Timestamp now;
-		const Timestamp &activationTime = entry.activationTime();
-		const Timespan sleepTime(activationTime - now);
-		if (sleepTime.totalMilliseconds() > 0) {
+		const Timestamp now;
+		shard.wheel.advance(now, expired);
+
+		if (expired.empty()) {
+			const Timespan sleepTime = shard.wheel.untilNext(now);
 			guard.unlock();
-			logger().debug(
-				"device "
-				+ entry.device()->deviceID().toString()
-				+ " will be activated in "
-				+ to_string(sleepTime.totalMilliseconds())
-				+ " milliseconds",
-				__FILE__, __LINE__);
+
+			if (sleepTime < 0) {
+				logger().debug(
+					"empty queue of devices",
+					__FILE__, __LINE__);
+			}
+
 			run.waitStoppable(sleepTime);
 			continue;
 		}
 
-		m_virtualDeviceQueue.pop();
+		for (auto &entry : expired) {
+			const VirtualDevice::Ptr device = entry.device();
 
-		logger().debug(
-			"device "
-			+ entry.device()->deviceID().toString()
-			+ " is being processed",
-			__FILE__, __LINE__);
+			if (shard.paired.find(device->deviceID()) == shard.paired.end()) {
+				if (logger().debug()) {
+					logger().debug(
+						"unpaired device "
+						+ device->deviceID().toString()
+						+ " was removed from queue",
+						__FILE__, __LINE__);
+				}
 
-		SensorData sensorData = entry.device()->generate();
-		if (!sensorData.isEmpty()) {
-			ship(entry.device()->generate());
-		}
-		else {
-			poco_debug(logger(), "received empty SensorData");
+				shard.scheduled.erase(device->deviceID());
+				continue;
+			}
+
+			if (logger().trace()) {
+				logger().trace(
+					"device "
+					+ device->deviceID().toString()
+					+ " is being processed",
+					__FILE__, __LINE__);
+			}
+
+			for (unsigned int i = 0; i < device->burst(); ++i) {
+				SensorData sensorData = device->generate();
+				if (sensorData.isEmpty()) {
+					poco_debug(logger(), "received empty SensorData");
+					break;
+				}
+
+				generated.emplace_back(sensorData);
+			}
+
+			scheduleEntryUnlocked(shard, entry);
 		}
 
-		scheduleEntryUnlocked(entry);
+		expired.clear();
+		guard.unlock();
+
+		for (const auto &sensorData : generated)
+			ship(sensorData);
+
+		generated.clear();
 	}
 }
 
 void VirtualDeviceManager::stop()
 {
 	DeviceManager::stop();
+
+	for (auto shard : m_shards)
+		shard->stopControl.requestStop();
+
 	answerQueue().dispose();
 }
 
-void VirtualDeviceManager::scheduleEntryUnlocked(VirtualDeviceEntry entry)
+void VirtualDeviceManager::pairAndScheduleUnlocked(
+		Shard &shard,
+		VirtualDevice::Ptr device)
 {
-	entry.setInserted(Timestamp());
-	m_virtualDeviceQueue.push(entry);
-	m_stopControl.requestWakeup();
-}
+	shard.paired.emplace(device->deviceID());
 
-bool VirtualDeviceEntryComparator::lessThan(
-	const VirtualDeviceEntry &deviceQueue1,
-	const VirtualDeviceEntry &deviceQueue2) const
-{
-	return deviceQueue1.activationTime() > deviceQueue2.activationTime();
+	if (shard.scheduled.emplace(device->deviceID()).second)
+		scheduleEntryUnlocked(shard, VirtualDeviceEntry(device));
 }
 
-VirtualDeviceEntry::VirtualDeviceEntry(VirtualDevice::Ptr device)
+void VirtualDeviceManager::scheduleEntryUnlocked(
+		Shard &shard,
+		VirtualDeviceEntry entry)
 {
-	m_device = device;
-}
+	const VirtualDevice::Ptr device = entry.device();
+	Timespan delay = device->refresh();
 
-void VirtualDeviceEntry::setInserted(const Timestamp &t)
-{
-	m_inserted = t;
-}
+	if (device->jitter() > 0) {
+		const Timespan::TimeDiff jitter = device->jitter().totalMicroseconds();
+		const UInt32 range = static_cast<UInt32>(2 * jitter + 1);
 
-Timestamp VirtualDeviceEntry::inserted() const
-{
-	return m_inserted;
-}
+		delay += Timespan(shard.random.next(range)) - Timespan(jitter);
 
-VirtualDevice::Ptr VirtualDeviceEntry::device() const
-{
-	return m_device;
-}
+		if (delay < Timespan::MILLISECONDS)
+			delay = Timespan::MILLISECONDS;
+	}
 
-Timestamp VirtualDeviceEntry::activationTime() const
-{
-	return inserted() + device()->refresh();
+	entry.setInserted(Timestamp());
+	entry.setDelay(delay);
+	shard.wheel.schedule(entry);
+	shard.stopControl.requestWakeup();
 }
@@ -1,76 +1,23 @@
 #pragma once
 
-#include <queue>
+#include <set>
 #include <string>
+#include <vector>
 
+#include <Poco/Mutex.h>
+#include <Poco/Random.h>
+#include <Poco/Runnable.h>
 #include <Poco/SharedPtr.h>
 #include <Poco/Timestamp.h>
 #include <Poco/Util/IniFileConfiguration.h>
 
 #include "core/DeviceManager.h"
+#include "loop/StopControl.h"
 #include "vdev/VirtualDevice.h"
+#include "vdev/VirtualDeviceTimerWheel.h"
 
 namespace BeeeOn {
 
-/**
- * Represents entry in a calendar. It contains time when entry
- * was inserted into the calendar and information about device.
- *
- * Note: Calendar serves for planning of data sending from modules.
- */
-class VirtualDeviceEntry {
-public:
-	VirtualDeviceEntry(VirtualDevice::Ptr device);
-
-	/**
-	* Sets time when entry was inserted into a calendar.
-	*/
-	void setInserted(const Poco::Timestamp &t);
-
-	/**
-	* Returns time when entry was inserted into a calendar.
-	*/
-	Poco::Timestamp inserted() const;
-
-	/**
-	* Returns time when entry (device) will be activated
-	* (when data will be sent).
-	 *
-	* activationTime = timeInserted + refreshTime
-	*/
-	Poco::Timestamp activationTime() const;
-
-	/**
-	* Returns information about device.
-	*/
-	VirtualDevice::Ptr device() const;
-
-private:
-	Poco::Timestamp m_inserted;
-	VirtualDevice::Ptr m_device;
-};
-
-/**
- * Ensures comparison of entries in a calendar.
- */
-class VirtualDeviceEntryComparator {
-public:
-	/**
-	* Returns entry with lower activation time.
-	*/
-	bool lessThan(const VirtualDeviceEntry &deviceQueue1,
-		const VirtualDeviceEntry &deviceQueue2) const;
-
-	/**
-	* Returns entry with lower activation time.
-	*/
-	bool operator ()(const VirtualDeviceEntry &deviceQueue1,
-		const VirtualDeviceEntry &deviceQueue2) const
-	{
-		return lessThan(deviceQueue1, deviceQueue2);
-	}
-};
-
 /**
  * Ensures configuration of virtual devices from configuration file
  * virtual-devices.ini and it is able to send NewDeviceCommand to CommandDispatcher
@@ -83,6 +30,14 @@ public:
  * - GatewayListenCommand, DeviceAcceptCommand - device attempts to pair
  * - DeviceSetValueCommand - modification of module value
  * - DeviceUnpairCommand - device attempts to unpair
+ *
+ * To serve as a synthetic load generator, a single configured device
+ * can be instantiated multiple times (option instances), its refresh
+ * can be given in milliseconds (refresh_ms) with random jitter
+ * (jitter_ms) and it can ship multiple SensorData per activation
+ * (burst). Devices are planned in a timer wheel and split among
+ * the given number of shards (virtual-devices.shards), each
+ * served by its own thread.
  */
 class VirtualDeviceManager : public DeviceManager {
 public:
@@ -115,10 +70,12 @@ public:
 
 	/**
 	 * Processes information about virtual device loaded from configuration
-	 * file.
+	 * file. The instance is added to the identifier of the device to allow
+	 * creating many devices from a single template.
 	 */
 	VirtualDevice::Ptr parseDevice(
-		Poco::AutoPtr<Poco::Util::AbstractConfiguration> cfg);
+		Poco::AutoPtr<Poco::Util::AbstractConfiguration> cfg,
+		unsigned int instance = 0);
 
 	/**
 	 * Processes information about virtual module loaded from configuration
@@ -133,17 +90,6 @@ public:
 	 */
 	void scheduleAllEntries();
 
-	/**
-	 * Checks if a queue of virtual devices is empty.
-	 */
-	bool isEmptyQueue();
-
-	/**
-	 * Sets time when an entry was inserted into a queue and pushes
-	 * this entry to the queue.
-	 */
-	void scheduleEntryUnlocked(VirtualDeviceEntry entry);
-
 	/**
 	 * Logs information about loaded virtual devices and modules.
 	 * Detail of information can be selected from possibilities:
@@ -189,14 +135,59 @@ protected:
 	*/
 	void doUnpairCommand(const DeviceUnpairCommand::Ptr cmd);
 
+private:
+	/**
+	 * Part of virtual devices planned and served by a single thread.
+	 * The paired set caches pairing status of the shard's devices
+	 * so the device cache is not consulted on every activation.
+	 * The scheduled set avoids planning a device more than once.
+	 */
+	struct Shard {
+		typedef Poco::SharedPtr<Shard> Ptr;
+
+		Poco::FastMutex lock;
+		VirtualDeviceTimerWheel wheel;
+		std::set<DeviceID> paired;
+		std::set<DeviceID> scheduled;
+		Poco::Random random;
+		StopControl stopControl;
+	};
+
+	class ShardRunnable : public Poco::Runnable {
+	public:
+		ShardRunnable(VirtualDeviceManager &manager, Shard &shard);
+
+		void run() override;
+
+	private:
+		VirtualDeviceManager &m_manager;
+		Shard &m_shard;
+	};
+
+	Shard &shardOf(const DeviceID &id);
+
+	/**
+	 * Serves activations of devices of the given shard until stopped.
+	 */
+	void runShard(Shard &shard);
+
+	/**
+	 * Sets time when an entry was inserted into a timer wheel, computes
+	 * its delay with respect to the jitter and plans the entry.
+	 */
+	void scheduleEntryUnlocked(Shard &shard, VirtualDeviceEntry entry);
+
+	/**
+	 * Marks the device as paired in the shard and plans it unless
+	 * it is already planned.
+	 */
+	void pairAndScheduleUnlocked(Shard &shard, VirtualDevice::Ptr device);
+
 private:
 	std::map<DeviceID, VirtualDevice::Ptr> m_virtualDevicesMap;
 	std::string m_configFile;
-	std::priority_queue<VirtualDeviceEntry,
-		std::vector<VirtualDeviceEntry>,
-		VirtualDeviceEntryComparator> m_virtualDeviceQueue;
+	std::vector<Shard::Ptr> m_shards;
 	bool m_requestDeviceList;
-	Poco::FastMutex m_lock;
 };
 
 }
@@ -0,0 +1,143 @@
+#include <Poco/Exception.h>
+
+#include "vdev/VirtualDeviceTimerWheel.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+VirtualDeviceEntry::VirtualDeviceEntry(VirtualDevice::Ptr device):
+	m_delay(device->refresh()),
+	m_device(device)
+{
+}
+
+void VirtualDeviceEntry::setInserted(const Timestamp &t)
+{
+	m_inserted = t;
+}
+
+Timestamp VirtualDeviceEntry::inserted() const
+{
+	return m_inserted;
+}
+
+void VirtualDeviceEntry::setDelay(const Timespan &delay)
+{
+	m_delay = delay;
+}
+
+Timespan VirtualDeviceEntry::delay() const
+{
+	return m_delay;
+}
+
+VirtualDevice::Ptr VirtualDeviceEntry::device() const
+{
+	return m_device;
+}
+
+Timestamp VirtualDeviceEntry::activationTime() const
+{
+	return inserted() + delay();
+}
+
+VirtualDeviceTimerWheel::VirtualDeviceTimerWheel(
+		const Timespan &tick,
+		size_t slots,
+		const Timestamp &origin):
+	m_tick(tick),
+	m_origin(origin),
+	m_slots(slots),
+	m_current(0),
+	m_size(0)
+{
+	if (tick <= 0)
+		throw InvalidArgumentException("tick of timer wheel must be positive");
+
+	if (slots == 0)
+		throw InvalidArgumentException("timer wheel must have at least 1 slot");
+}
+
+uint64_t VirtualDeviceTimerWheel::tickOf(const Timestamp &t) const
+{
+	if (t <= m_origin)
+		return 0;
+
+	return (t - m_origin) / m_tick.totalMicroseconds();
+}
+
+Timestamp VirtualDeviceTimerWheel::timeOf(uint64_t tick) const
+{
+	return m_origin + Timespan(tick * m_tick.totalMicroseconds());
+}
+
+void VirtualDeviceTimerWheel::schedule(const VirtualDeviceEntry &entry)
+{
+	uint64_t tick = tickOf(entry.activationTime());
+	if (tick < m_current)
+		tick = m_current;
+
+	m_slots[tick % m_slots.size()].emplace_back(entry);
+	++m_size;
+}
+
+void VirtualDeviceTimerWheel::advance(
+		const Timestamp &now,
+		vector<VirtualDeviceEntry> &expired)
+{
+	const uint64_t target = tickOf(now);
+	if (target < m_current)
+		return;
+
+	uint64_t steps = target - m_current + 1;
+	if (steps > m_slots.size())
+		steps = m_slots.size();
+
+	for (uint64_t i = 0; i < steps && m_size > 0; ++i) {
+		auto &slot = m_slots[(m_current + i) % m_slots.size()];
+
+		for (auto it = slot.begin(); it != slot.end();) {
+			if (tickOf(it->activationTime()) > target) {
+				++it;
+				continue;
+			}
+
+			expired.emplace_back(*it);
+			it = slot.erase(it);
+			--m_size;
+		}
+	}
+
+	m_current = target + 1;
+}
+
+Timespan VirtualDeviceTimerWheel::untilNext(const Timestamp &now) const
+{
+	if (m_size == 0)
+		return -1;
+
+	for (size_t i = 0; i < m_slots.size(); ++i) {
+		const uint64_t tick = m_current + i;
+
+		for (const auto &entry : m_slots[tick % m_slots.size()]) {
+			if (tickOf(entry.activationTime()) > tick)
+				continue;
+
+			const Timestamp &at = timeOf(tick);
+			return at > now ? Timespan(at - now) : Timespan(0);
+		}
+	}
+
+	return m_tick.totalMicroseconds() * m_slots.size();
+}
+
+bool VirtualDeviceTimerWheel::empty() const
+{
+	return m_size == 0;
+}
+
+size_t VirtualDeviceTimerWheel::size() const
+{
+	return m_size;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+
+#include "vdev/VirtualDevice.h"
+
+namespace BeeeOn {
+
+/**
+ * Represents entry in a calendar. It contains time when entry
+ * was inserted into the calendar, the delay after which it
+ * should be activated and information about device.
+ *
+ * Note: Calendar serves for planning of data sending from modules.
+ */
+class VirtualDeviceEntry {
+public:
+	VirtualDeviceEntry(VirtualDevice::Ptr device);
+
+	/**
+	* Sets time when entry was inserted into a calendar.
+	*/
+	void setInserted(const Poco::Timestamp &t);
+
+	/**
+	* Returns time when entry was inserted into a calendar.
+	*/
+	Poco::Timestamp inserted() const;
+
+	/**
+	 * Sets delay after the insertion time when the entry is activated.
+	 * By default, the refresh time of the device is used.
+	 */
+	void setDelay(const Poco::Timespan &delay);
+
+	/**
+	 * Returns delay after the insertion time when the entry is activated.
+	 */
+	Poco::Timespan delay() const;
+
+	/**
+	* Returns time when entry (device) will be activated
+	* (when data will be sent).
+	 *
+	* activationTime = timeInserted + delay
+	*/
+	Poco::Timestamp activationTime() const;
+
+	/**
+	* Returns information about device.
+	*/
+	VirtualDevice::Ptr device() const;
+
+private:
+	Poco::Timestamp m_inserted;
+	Poco::Timespan m_delay;
+	VirtualDevice::Ptr m_device;
+};
+
+/**
+ * @brief Hashed timer wheel planning activations of virtual devices.
+ *
+ * The time is divided into ticks of a constant length. Every entry
+ * is placed into the slot (tick % slots) of its activation time.
+ * Scheduling is O(1) and advancing the wheel visits only the slots
+ * of ticks that have elapsed since the last advance. Entries that
+ * are planned more than one rotation ahead just stay in their slot
+ * until their tick comes.
+ *
+ * The wheel is not thread-safe, callers must serialize access.
+ */
+class VirtualDeviceTimerWheel {
+public:
+	VirtualDeviceTimerWheel(
+		const Poco::Timespan &tick = 1 * Poco::Timespan::MILLISECONDS,
+		size_t slots = 1024,
+		const Poco::Timestamp &origin = Poco::Timestamp());
+
+	/**
+	 * Plan the given entry to its activation time. Entries whose
+	 * activation time has already passed are activated by the
+	 * next call to advance().
+	 */
+	void schedule(const VirtualDeviceEntry &entry);
+
+	/**
+	 * Move the wheel up to the given time and append all entries
+	 * that should be activated until then to the expired vector.
+	 */
+	void advance(
+		const Poco::Timestamp &now,
+		std::vector<VirtualDeviceEntry> &expired);
+
+	/**
+	 * @returns time remaining to the nearest activation within one
+	 * rotation of the wheel or duration of the whole rotation if there
+	 * is no such activation. If the wheel is empty, returns -1.
+	 */
+	Poco::Timespan untilNext(const Poco::Timestamp &now) const;
+
+	bool empty() const;
+	size_t size() const;
+
+private:
+	uint64_t tickOf(const Poco::Timestamp &t) const;
+	Poco::Timestamp timeOf(uint64_t tick) const;
+
+private:
+	Poco::Timespan m_tick;
+	Poco::Timestamp m_origin;
+	std::vector<std::vector<VirtualDeviceEntry>> m_slots;
+	uint64_t m_current;
+	size_t m_size;
+};
+
+}
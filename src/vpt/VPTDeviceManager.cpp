@@ -19,6 +19,7 @@ BEEEON_OBJECT_CASTABLE(CommandHandler)
 BEEEON_OBJECT_CASTABLE(DeviceStatusHandler)
 BEEEON_OBJECT_PROPERTY("deviceCache", &VPTDeviceManager::setDeviceCache)
 BEEEON_OBJECT_PROPERTY("distributor", &VPTDeviceManager::setDistributor)
+BEEEON_OBJECT_PROPERTY("discoveryExecutor", &VPTDeviceManager::setDiscoveryExecutor)
 BEEEON_OBJECT_PROPERTY("commandDispatcher", &VPTDeviceManager::setCommandDispatcher)
 BEEEON_OBJECT_PROPERTY("refresh", &VPTDeviceManager::setRefresh)
 BEEEON_OBJECT_PROPERTY("interfaceBlackList", &VPTDeviceManager::setBlackList)
@@ -252,7 +253,7 @@ void VPTDeviceManager::handleGeneric(const Command::Ptr cmd, Result::Ptr result)
 AsyncWork<>::Ptr VPTDeviceManager::startDiscovery(const Timespan &timeout)
 {
 	VPTSeeker::Ptr seeker = new VPTSeeker(*this, timeout);
-	seeker->start();
+	startSeeker(seeker);
 	return seeker;
 }
 
@@ -419,7 +420,7 @@ void VPTDeviceManager::VPTSeeker::seekLoop(StopControl &control)
 {
 	StopControl::Run run(control);
 
-	while (remaining() > 0) {
+	while (nextPass()) {
 		for (auto device : m_parent.seekDevices(control)) {
 			if (!run)
 				break;
@@ -3,7 +3,9 @@
 #include <Poco/Exception.h>
 #include <Poco/Logger.h>
 
+#include "util/InputTraceRecorder.h"
 #include "zwave/AbstractZWaveNetwork.h"
+#include "zwave/ZWaveEventTrace.h"
 
 using namespace std;
 using namespace Poco;
@@ -85,6 +87,10 @@ ZWaveNetwork::PollEvent AbstractZWaveNetwork::pollEvent(
 
 void AbstractZWaveNetwork::notifyEvent(const PollEvent &event)
 {
+	InputTraceRecorder &recorder = InputTraceRecorder::instance();
+	if (recorder.active())
+		recorder.record(ZWaveEventTrace::CHANNEL, ZWaveEventTrace::encode(event));
+
 	FastMutex::ScopedLock guard(m_lock);
 
 	m_eventsQueue.emplace_back(event);
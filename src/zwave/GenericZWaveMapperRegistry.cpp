@@ -13,6 +13,7 @@
 #include "zwave/GenericZWaveMapperRegistry.h"
 #include "zwave/ZWaveNode.h"
 #include "zwave/ZWaveTypeMappingParser.h"
+#include "zwave/ZWaveTypeMappingTable.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, GenericZWaveMapperRegistry)
 BEEEON_OBJECT_CASTABLE(ZWaveMapperRegistry)
@@ -253,6 +254,11 @@ GenericZWaveMapperRegistry::GenericZWaveMapperRegistry()
 
 void GenericZWaveMapperRegistry::loadTypesMapping(const string &file)
 {
+	if (file.empty()) {
+		loadBuiltinTypesMapping();
+		return;
+	}
+
 	logger().information("loading types-mapping from: " + file);
 	FileInputStream in(file);
 
@@ -262,12 +268,25 @@ void GenericZWaveMapperRegistry::loadTypesMapping(const string &file)
 void GenericZWaveMapperRegistry::loadTypesMapping(istream &in)
 {
 	ZWaveTypeMappingParser parser;
+	applyTypesMapping(parser.parse(in));
+}
+
+void GenericZWaveMapperRegistry::loadBuiltinTypesMapping()
+{
+	logger().information("loading built-in types-mapping of "
+		+ to_string(ZWaveTypeMappingTable::size()) + " types");
+
+	applyTypesMapping(ZWaveTypeMappingTable::sequence());
+}
 
+void GenericZWaveMapperRegistry::applyTypesMapping(
+		const TypeMappingParser<ZWaveType>::TypeMappingSequence &sequence)
+{
 	map<pair<uint8_t, uint8_t>, ModuleType> typesMapping;
 	map<pair<uint8_t, uint8_t>, unsigned int> typesOrder;
 	unsigned int order = 0;
 
-	for (const auto &map : parser.parse(in)) {
+	for (const auto &map : sequence) {
 		const auto zwave = map.first;
 		const auto beeeon = map.second;
 
@@ -6,7 +6,9 @@
 #include "model/ModuleID.h"
 #include "model/ModuleType.h"
 #include "util/Loggable.h"
+#include "util/TypeMappingParser.h"
 #include "zwave/ZWaveMapperRegistry.h"
+#include "zwave/ZWaveTypeMappingParser.h"
 
 namespace BeeeOn {
 
@@ -83,10 +85,18 @@ public:
 
 	/**
 	 * @brief Load XML file with the types mapping between Z-Wave and BeeeOn.
+	 * An empty path loads the mapping compiled into the gateway (see
+	 * ZWaveTypeMappingTable). The XML file is useful during development
+	 * to try a modified mapping without rebuilding.
 	 */
 	void loadTypesMapping(const std::string &file);
 	void loadTypesMapping(std::istream &in);
 
+	/**
+	 * @brief Load the types mapping compiled into the gateway.
+	 */
+	void loadBuiltinTypesMapping();
+
 	/**
 	 * @breif Map the given ZWaveNode instance on-fly to the BeeeOn system
 	 * by using the GenericMapper.
@@ -94,6 +104,9 @@ public:
 	Mapper::Ptr resolve(const ZWaveNode &node) override;
 
 private:
+	void applyTypesMapping(
+		const TypeMappingParser<ZWaveType>::TypeMappingSequence &sequence);
+
 	/**
 	 * The m_typesMapping maps Z-Wave command classes to BeeeOn types.
 	 */
@@ -20,13 +20,14 @@
 
 #include "di/Injectable.h"
 #include "hotplug/HotplugEvent.h"
+#include "util/SamplingProfiler.h"
+#include "util/StartupTracer.h"
 #include "util/ZipIterator.h"
 #include "zwave/OZWNetwork.h"
 #include "zwave/OZWNotificationEvent.h"
 #include "zwave/OZWPocoLoggerAdapter.h"
 #include "zwave/ZWaveNodeEvent.h"
 #include "zwave/ZWaveDriverEvent.h"
-#include "zwave/ZWaveSerialProber.h"
 
 BEEEON_OBJECT_BEGIN(BeeeOn, OZWNetwork)
 BEEEON_OBJECT_CASTABLE(HotplugListener)
@@ -40,7 +41,10 @@ BEEEON_OBJECT_PROPERTY("statisticsInterval", &OZWNetwork::setStatisticsInterval)
 BEEEON_OBJECT_PROPERTY("networkKey", &OZWNetwork::setNetworkKey)
 BEEEON_OBJECT_PROPERTY("controllersToReset", &OZWNetwork::setControllersToReset)
 BEEEON_OBJECT_PROPERTY("executor", &OZWNetwork::setExecutor)
+BEEEON_OBJECT_PROPERTY("serialReactor", &OZWNetwork::setSerialReactor)
+BEEEON_OBJECT_PROPERTY("probeTimeout", &OZWNetwork::setProbeTimeout)
 BEEEON_OBJECT_PROPERTY("listeners", &OZWNetwork::registerListener)
+BEEEON_OBJECT_PROPERTY("lazyInit", &OZWNetwork::setLazyInit)
 BEEEON_OBJECT_HOOK("done", &OZWNetwork::configure)
 BEEEON_OBJECT_HOOK("cleanup", &OZWNetwork::cleanup)
 BEEEON_OBJECT_END(BeeeOn, OZWNetwork)
@@ -84,6 +88,7 @@ OZWNetwork::OZWNetwork():
 	m_retryTimeout(OZW_DEFAULT_RETRY_TIMEOUT),
 	m_assumeAwake(OZW_DEFAULT_ASSUME_AWAKE),
 	m_driverMaxAttempts(OZW_DEFAULT_DRIVER_MAX_ATTEMPTS),
+	m_lazyInit(false),
 	m_configured(false),
 	m_command(*this)
 {
@@ -171,6 +176,11 @@ void OZWNetwork::setStatisticsInterval(const Timespan &interval)
 	m_statisticsRunner.setInterval(interval);
 }
 
+void OZWNetwork::setLazyInit(bool lazy)
+{
+	m_lazyInit = lazy;
+}
+
 void OZWNetwork::setControllersToReset(const list<string> &homes)
 {
 	for (const auto &home : homes)
@@ -188,6 +198,16 @@ void OZWNetwork::setExecutor(AsyncExecutor::Ptr executor)
 	m_eventSource.setAsyncExecutor(executor);
 }
 
+void OZWNetwork::setSerialReactor(SerialReactor::Ptr reactor)
+{
+	m_prober.setSerialReactor(reactor);
+}
+
+void OZWNetwork::setProbeTimeout(const Timespan &timeout)
+{
+	m_prober.setTimeout(timeout);
+}
+
 void OZWNetwork::checkDirectory(const Path &path)
 {
 	File file(path);
@@ -219,12 +239,29 @@ void OZWNetwork::prepareDirectory(const Path &path)
 }
 
 void OZWNetwork::configure()
+{
+	checkDirectory(m_configPath);
+	prepareDirectory(m_userPath);
+
+	if (m_lazyInit) {
+		logger().information(
+			"OpenZWave initialization deferred until a dongle appears",
+			__FILE__, __LINE__);
+		return;
+	}
+
+	initOpenZWave();
+}
+
+void OZWNetwork::initOpenZWave()
 {
 	FastMutex::ScopedLock guard0(m_lock);
 	FastMutex::ScopedLock guard1(m_managerLock);
 
-	checkDirectory(m_configPath);
-	prepareDirectory(m_userPath);
+	if (m_configured)
+		return;
+
+	StartupTracer::Scope trace("OZWNetwork::initOpenZWave");
 
 	Options::Create(m_configPath.toString(), m_userPath.toString(), "");
 
@@ -281,12 +318,15 @@ void OZWNetwork::configure()
 
 void OZWNetwork::cleanup()
 {
-	if (!m_configured)
-		return;
+	m_prober.stop();
 
 	FastMutex::ScopedLock guard0(m_lock);
 	FastMutex::ScopedLock guard1(m_managerLock);
 
+	// initOpenZWave() might be running in parallel when initialized lazily
+	if (!m_configured)
+		return;
+
 	Manager::Get()->RemoveWatcher(&ozwNotification, this);
 
 	try {
@@ -316,24 +356,31 @@ void OZWNetwork::onAdd(const HotplugEvent &event)
 	if (!matchEvent(event))
 		return;
 
-	logger().information("registering dongle " + event.toString());
+	if (event.subsystem() == "tty"
+			&& event.properties()->getBool("tty.BEEEON_PROBE", false)) {
+		logger().information("probing dongle " + event.toString());
 
-	Driver::ControllerInterface iftype = Driver::ControllerInterface_Unknown;
+		m_prober.probe(event, [this](const HotplugEvent &detected) {
+			addDriver(detected);
+		});
+		return;
+	}
 
-	if (event.subsystem() == "tty") {
-		if (event.properties()->getBool("tty.BEEEON_PROBE", false)) {
-			SerialPort port(event.node());
-			ZWaveSerialProber::setupPort(port);
-			ZWaveSerialProber prober(port);
+	addDriver(event);
+}
 
-			prober.probe(10 * Timespan::MILLISECONDS);
-		}
+void OZWNetwork::addDriver(const HotplugEvent &event)
+{
+	logger().information("registering dongle " + event.toString());
 
+	Driver::ControllerInterface iftype = Driver::ControllerInterface_Unknown;
+
+	if (event.subsystem() == "tty")
 		iftype = Driver::ControllerInterface_Serial;
-	}
-	else {
+	else
 		iftype = Driver::ControllerInterface_Hid;
-	}
+
+	initOpenZWave();
 
 	FastMutex::ScopedLock guard(m_managerLock);
 	Manager::Get()->AddDriver(event.node(), iftype);
@@ -344,7 +391,13 @@ void OZWNetwork::onRemove(const HotplugEvent &event)
 	if (!matchEvent(event))
 		return;
 
+	m_prober.cancel(event.node());
+
 	FastMutex::ScopedLock guard(m_managerLock);
+
+	if (!m_configured)
+		return;
+
 	Manager::Get()->RemoveDriver(event.node());
 
 	logger().information("dongle unregistered " + event.toString());
@@ -356,6 +409,9 @@ void OZWNetwork::ozwNotification(
 	OZWNetwork *processor =
 		reinterpret_cast<OZWNetwork *>(context);
 
+	// notifications are delivered by a thread of the OpenZWave library
+	SamplingProfiler::labelThread("ozw");
+
 	try {
 		processor->onNotification(notification);
 	}
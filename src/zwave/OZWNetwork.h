@@ -11,6 +11,7 @@
 #include <Poco/Timespan.h>
 
 #include "hotplug/HotplugListener.h"
+#include "io/SerialReactor.h"
 #include "loop/StoppableLoop.h"
 #include "util/EventSource.h"
 #include "util/PeriodicRunner.h"
@@ -18,6 +19,7 @@
 #include "zwave/OZWCommand.h"
 #include "zwave/ZWaveListener.h"
 #include "zwave/ZWaveNode.h"
+#include "zwave/ZWaveParallelProber.h"
 
 namespace OpenZWave {
 
@@ -40,6 +42,10 @@ namespace BeeeOn {
  * automatically by DI. The deinitialization is implemented via OZWNetwork::cleanup()
  * (also called by DI).
  *
+ * When lazyInit is enabled, the OZW library is not initialized by configure()
+ * but when the first Z-Wave dongle appears. Gateways without any Z-Wave dongle
+ * thus do not pay for loading of the OZW device database during startup.
+ *
  * The OZWNetwork is able to handle multiple Z-Wave dongles (according to OZW). It
  * assigns dongles via the hotplug mechanism. It recognizes dongles with property
  * tty.BEEEON_DONGLE == "zwave". Currently, only dongles connected via tty are supported.
@@ -117,12 +123,32 @@ public:
 	 */
 	void setControllersToReset(const std::list<std::string> &homes);
 
+	/**
+	 * @brief Defer initialization of the OZW library until the first
+	 * Z-Wave dongle is detected.
+	 */
+	void setLazyInit(bool lazy);
+
 	/**
 	 * @brief Set asynchronous executor used for asynchronous tasks
 	 * and events reporting.
 	 */
 	void setExecutor(AsyncExecutor::Ptr executor);
 
+	/**
+	 * @brief Set reactor used to probe serial ports of Z-Wave
+	 * dongles. If not set, each serial port is read by its probing
+	 * thread.
+	 * After probing, the serial port is left to the OpenZWave library.
+	 */
+	void setSerialReactor(SerialReactor::Ptr reactor);
+
+	/**
+	 * @brief Set deadline of probing of serial devices marked by
+	 * BEEEON_PROBE. The devices are probed concurrently.
+	 */
+	void setProbeTimeout(const Poco::Timespan &timeout);
+
 	/**
 	 * @brief Register a ZWaveListener that would be receiving events.
 	 */
@@ -147,9 +173,8 @@ public:
 	void onRemove(const HotplugEvent &event) override;
 
 	/**
-	 * @brief Initialize OZW library, set options and register self
-	 * as a watcher for handling notifications. The statistics reporter
-	 * is started.
+	 * @brief Check the configured directories and initialize OZW library
+	 * unless the lazy initialization is enabled.
 	 */
 	void configure();
 
@@ -471,6 +496,19 @@ protected:
 	 */
 	std::string valueForList(const OpenZWave::ValueID &valueID, const int value);
 
+	/**
+	 * @brief Initialize OZW library, set options and register self
+	 * as a watcher for handling notifications. The statistics reporter
+	 * is started. Calling it when already initialized does nothing.
+	 */
+	void initOpenZWave();
+
+	/**
+	 * @brief Register the dongle reported by the given event into
+	 * the OZW library.
+	 */
+	void addDriver(const HotplugEvent &event);
+
 private:
 	Poco::Path m_configPath;
 	Poco::Path m_userPath;
@@ -481,6 +519,7 @@ private:
 	unsigned int m_driverMaxAttempts;
 	std::set<uint32_t> m_controllersToReset;
 	std::vector<uint8_t> m_networkKey;
+	bool m_lazyInit;
 
 	/**
 	 * Homes and nodes maintained by the OZWNetwork instance.
@@ -488,9 +527,11 @@ private:
 	std::map<uint32_t, std::map<uint8_t, OZWNode>> m_homes;
 
 	/**
-	 * Set after the OZWNetwork::configure() finishes successfuly.
+	 * Set after the OZWNetwork::initOpenZWave() finishes successfuly.
 	 * The OZWNetwork::cleanup() does nothing, if the m_configured
-	 * is false to not segfault when configure() fails.
+	 * is false to not segfault when configure() fails. As OpenZWave
+	 * can be initialized lazily by a hotplug event, it is tested
+	 * only while holding the m_managerLock.
 	 */
 	Poco::AtomicCounter m_configured;
 
@@ -511,6 +552,7 @@ private:
 	OZWCommand m_command;
 	EventSource<ZWaveListener> m_eventSource;
 	AsyncExecutor::Ptr m_executor;
+	ZWaveParallelProber m_prober;
 	PeriodicRunner m_statisticsRunner;
 };
 
@@ -0,0 +1,77 @@
+#include <Poco/Logger.h>
+
+#include "di/Injectable.h"
+#include "zwave/ReplayZWaveNetwork.h"
+#include "zwave/ZWaveEventTrace.h"
+
+BEEEON_OBJECT_BEGIN(BeeeOn, ReplayZWaveNetwork)
+BEEEON_OBJECT_CASTABLE(HotplugListener)
+BEEEON_OBJECT_CASTABLE(ZWaveNetwork)
+BEEEON_OBJECT_CASTABLE(StoppableRunnable)
+BEEEON_OBJECT_PROPERTY("tracePath", &ReplayZWaveNetwork::setTracePath)
+BEEEON_OBJECT_PROPERTY("speed", &ReplayZWaveNetwork::setSpeed)
+BEEEON_OBJECT_END(BeeeOn, ReplayZWaveNetwork)
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+ReplayZWaveNetwork::ReplayZWaveNetwork()
+{
+}
+
+void ReplayZWaveNetwork::setTracePath(const string &path)
+{
+	m_replayer.setTracePath(path);
+}
+
+void ReplayZWaveNetwork::setSpeed(int speed)
+{
+	m_replayer.setSpeed(speed);
+}
+
+void ReplayZWaveNetwork::run()
+{
+	StopControl::Run run(m_stopControl);
+
+	m_replayer.replay(
+		ZWaveEventTrace::CHANNEL,
+		[&](const InputTraceRecord &record) {
+			notifyEvent(ZWaveEventTrace::decode(record.payload()));
+		},
+		m_stopControl);
+}
+
+void ReplayZWaveNetwork::stop()
+{
+	m_stopControl.requestStop();
+}
+
+void ReplayZWaveNetwork::startInclusion()
+{
+	notifyEvent(PollEvent::createInclusionStart());
+	notifyEvent(PollEvent::createInclusionDone());
+}
+
+void ReplayZWaveNetwork::cancelInclusion()
+{
+}
+
+void ReplayZWaveNetwork::startRemoveNode()
+{
+	notifyEvent(PollEvent::createRemoveNodeStart());
+	notifyEvent(PollEvent::createRemoveNodeDone());
+}
+
+void ReplayZWaveNetwork::cancelRemoveNode()
+{
+}
+
+void ReplayZWaveNetwork::postValue(const ZWaveNode::Value &value)
+{
+	if (logger().debug()) {
+		logger().debug(
+			"ignoring posted value " + value.toString(),
+			__FILE__, __LINE__);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+#include "hotplug/HotplugListener.h"
+#include "loop/StopControl.h"
+#include "loop/StoppableRunnable.h"
+#include "util/InputTraceReplayer.h"
+#include "zwave/AbstractZWaveNetwork.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief ReplayZWaveNetwork is a mock of the Z-Wave network that
+ * feeds events recorded into an input trace to the ZWaveDeviceManager.
+ * It allows to benchmark the ZWaveDeviceManager reproducibly without
+ * any real Z-Wave hardware.
+ *
+ * Inclusion and node removal are simulated by emitting the appropriate
+ * start and done events. Posted values are just logged. Hotplug events
+ * are ignored, the network is available as long as it is running.
+ */
+class ReplayZWaveNetwork :
+	public HotplugListener,
+	public AbstractZWaveNetwork,
+	public StoppableRunnable {
+public:
+	ReplayZWaveNetwork();
+
+	void setTracePath(const std::string &path);
+
+	/**
+	 * Speed of replaying relative to the recorded timing,
+	 * 0 to replay as fast as possible.
+	 */
+	void setSpeed(int speed);
+
+	void run() override;
+	void stop() override;
+
+	void startInclusion() override;
+	void cancelInclusion() override;
+	void startRemoveNode() override;
+	void cancelRemoveNode() override;
+	void postValue(const ZWaveNode::Value &value) override;
+
+private:
+	InputTraceReplayer m_replayer;
+	StopControl m_stopControl;
+};
+
+}
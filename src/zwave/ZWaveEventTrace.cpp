@@ -0,0 +1,144 @@
+#include <Poco/Exception.h>
+
+#include "util/InputTrace.h"
+#include "zwave/ZWaveEventTrace.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+const string ZWaveEventTrace::CHANNEL = "zwave";
+
+static void encodeCommandClass(
+		InputTraceEncoder &encoder,
+		const ZWaveNode::CommandClass &cc)
+{
+	encoder.putUnsigned(cc.id());
+	encoder.putUnsigned(cc.index());
+	encoder.putUnsigned(cc.instance());
+	encoder.putString(cc.name());
+}
+
+static ZWaveNode::CommandClass decodeCommandClass(InputTraceDecoder &decoder)
+{
+	const uint8_t id = decoder.getUnsigned();
+	const uint8_t index = decoder.getUnsigned();
+	const uint8_t instance = decoder.getUnsigned();
+
+	return ZWaveNode::CommandClass(id, index, instance, decoder.getString());
+}
+
+static void encodeNode(InputTraceEncoder &encoder, const ZWaveNode &node)
+{
+	encoder.putUnsigned(node.home());
+	encoder.putUnsigned(node.node());
+	encoder.putUnsigned(node.controller() ? 1 : 0);
+	encoder.putUnsigned(node.support());
+	encoder.putUnsigned(node.productId());
+	encoder.putString(node.product());
+	encoder.putUnsigned(node.productType());
+	encoder.putUnsigned(node.vendorId());
+	encoder.putString(node.vendor());
+	encoder.putUnsigned(node.queried() ? 1 : 0);
+
+	encoder.putUnsigned(node.commandClasses().size());
+	for (const auto &cc : node.commandClasses())
+		encodeCommandClass(encoder, cc);
+}
+
+static ZWaveNode decodeNode(InputTraceDecoder &decoder)
+{
+	const uint32_t home = decoder.getUnsigned();
+	const uint8_t id = decoder.getUnsigned();
+	const bool controller = decoder.getUnsigned() != 0;
+
+	ZWaveNode node({home, id}, controller);
+	node.setSupport(decoder.getUnsigned());
+	node.setProductId(decoder.getUnsigned());
+	node.setProduct(decoder.getString());
+	node.setProductType(decoder.getUnsigned());
+	node.setVendorId(decoder.getUnsigned());
+	node.setVendor(decoder.getString());
+	node.setQueried(decoder.getUnsigned() != 0);
+
+	const size_t count = decoder.getUnsigned();
+	for (size_t i = 0; i < count; ++i)
+		node.add(decodeCommandClass(decoder));
+
+	return node;
+}
+
+string ZWaveEventTrace::encode(const ZWaveNetwork::PollEvent &event)
+{
+	InputTraceEncoder encoder;
+	encoder.putUnsigned(event.type());
+
+	switch (event.type()) {
+	case ZWaveNetwork::PollEvent::EVENT_NEW_NODE:
+	case ZWaveNetwork::PollEvent::EVENT_UPDATE_NODE:
+	case ZWaveNetwork::PollEvent::EVENT_REMOVE_NODE:
+		encodeNode(encoder, event.node());
+		break;
+
+	case ZWaveNetwork::PollEvent::EVENT_VALUE:
+		encoder.putUnsigned(event.value().node().home);
+		encoder.putUnsigned(event.value().node().node);
+		encodeCommandClass(encoder, event.value().commandClass());
+		encoder.putString(event.value().value());
+		encoder.putString(event.value().unit());
+		break;
+
+	default:
+		break;
+	}
+
+	return encoder.data();
+}
+
+ZWaveNetwork::PollEvent ZWaveEventTrace::decode(const string &payload)
+{
+	InputTraceDecoder decoder(payload);
+
+	switch (decoder.getUnsigned()) {
+	case ZWaveNetwork::PollEvent::EVENT_NONE:
+		return ZWaveNetwork::PollEvent();
+
+	case ZWaveNetwork::PollEvent::EVENT_NEW_NODE:
+		return ZWaveNetwork::PollEvent::createNewNode(decodeNode(decoder));
+
+	case ZWaveNetwork::PollEvent::EVENT_UPDATE_NODE:
+		return ZWaveNetwork::PollEvent::createUpdateNode(decodeNode(decoder));
+
+	case ZWaveNetwork::PollEvent::EVENT_REMOVE_NODE:
+		return ZWaveNetwork::PollEvent::createRemoveNode(decodeNode(decoder));
+
+	case ZWaveNetwork::PollEvent::EVENT_VALUE: {
+		const uint32_t home = decoder.getUnsigned();
+		const uint8_t node = decoder.getUnsigned();
+		const ZWaveNode::CommandClass &cc = decodeCommandClass(decoder);
+		const string &value = decoder.getString();
+		const string &unit = decoder.getString();
+
+		return ZWaveNetwork::PollEvent::createValue(
+			ZWaveNode::Value({home, node}, cc, value, unit));
+	}
+
+	case ZWaveNetwork::PollEvent::EVENT_INCLUSION_START:
+		return ZWaveNetwork::PollEvent::createInclusionStart();
+
+	case ZWaveNetwork::PollEvent::EVENT_INCLUSION_DONE:
+		return ZWaveNetwork::PollEvent::createInclusionDone();
+
+	case ZWaveNetwork::PollEvent::EVENT_REMOVE_NODE_START:
+		return ZWaveNetwork::PollEvent::createRemoveNodeStart();
+
+	case ZWaveNetwork::PollEvent::EVENT_REMOVE_NODE_DONE:
+		return ZWaveNetwork::PollEvent::createRemoveNodeDone();
+
+	case ZWaveNetwork::PollEvent::EVENT_READY:
+		return ZWaveNetwork::PollEvent::createReady();
+
+	default:
+		throw DataFormatException("unknown type of Z-Wave event in trace");
+	}
+}
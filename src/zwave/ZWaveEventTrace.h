@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "zwave/ZWaveNetwork.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Serialization of Z-Wave poll events for purposes of recording
+ * and replaying traces of the Z-Wave network.
+ *
+ * @see InputTraceRecorder
+ */
+class ZWaveEventTrace {
+public:
+	static const std::string CHANNEL;
+
+	static std::string encode(const ZWaveNetwork::PollEvent &event);
+
+	/**
+	 * @throws Poco::DataFormatException when the payload is invalid
+	 */
+	static ZWaveNetwork::PollEvent decode(const std::string &payload);
+};
+
+}
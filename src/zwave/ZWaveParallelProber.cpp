@@ -0,0 +1,238 @@
+#include <vector>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/Logger.h>
+
+#include "hotplug/HotplugEvent.h"
+#include "io/SerialPort.h"
+#include "util/SamplingProfiler.h"
+#include "zwave/ZWaveParallelProber.h"
+#include "zwave/ZWaveSerialProber.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+ZWaveParallelProber::ZWaveParallelProber():
+	m_timeout(10 * Timespan::MILLISECONDS),
+	m_nextJob(0)
+{
+}
+
+ZWaveParallelProber::~ZWaveParallelProber()
+{
+	stop();
+}
+
+void ZWaveParallelProber::setSerialReactor(SerialReactor::Ptr reactor)
+{
+	m_reactor = reactor;
+}
+
+void ZWaveParallelProber::setTimeout(const Timespan &timeout)
+{
+	if (timeout <= 0)
+		throw InvalidArgumentException("probe timeout must be positive");
+
+	m_timeout = timeout;
+}
+
+void ZWaveParallelProber::probe(const HotplugEvent &event, const Handler &detected)
+{
+	const string &id = ZWaveProbeCache::identify(event);
+
+	switch (m_cache.lookup(id)) {
+	case ZWaveProbeCache::ZWAVE:
+		logger().information("known Z-Wave controller " + id
+			+ " at " + event.node(), __FILE__, __LINE__);
+		detected(event);
+		return;
+
+	case ZWaveProbeCache::OTHER:
+		logger().information("skipping " + event.node()
+			+ ", known device " + id + " is not Z-Wave controller",
+			__FILE__, __LINE__);
+		return;
+
+	case ZWaveProbeCache::UNKNOWN:
+		break;
+	}
+
+	reap();
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	for (const auto &pair : m_jobs) {
+		const Job &job = pair.second;
+
+		// a cancelled job would never report the replugged device
+		if (job.node == event.node() && !job.cancelled && !job.finished) {
+			logger().debug("probing of " + event.node() + " is in progress",
+				__FILE__, __LINE__);
+			return;
+		}
+	}
+
+	const UInt64 jobID = m_nextJob++;
+
+	Job &job = m_jobs[jobID];
+	job.node = event.node();
+	job.thread = new Thread("zwave-probe");
+	job.cancelled = false;
+	job.finished = false;
+
+	const Clock requested;
+	const Timespan timeout = m_timeout;
+
+	job.thread->startFunc([this, jobID, event, requested, timeout, detected]() {
+		execute(jobID, event, timeout - requested.elapsed(), detected);
+	});
+}
+
+void ZWaveParallelProber::execute(
+		UInt64 jobID,
+		const HotplugEvent &event,
+		const Timespan &timeout,
+		const Handler &detected)
+{
+	SamplingProfiler::labelThread("zwave-probe");
+
+	const string &id = ZWaveProbeCache::identify(event);
+	bool zwave = false;
+	bool definite = true;
+
+	try {
+		probeNode(event.node(), timeout);
+		zwave = true;
+	}
+	catch (const DataFormatException &e) {
+		logger().information("device " + event.node()
+			+ " is not Z-Wave controller: " + e.displayText(),
+			__FILE__, __LINE__);
+	}
+	catch (const Exception &e) {
+		// the device might be busy, slow or a misbehaving controller,
+		// do not remember it
+		logger().information("failed to probe device " + event.node()
+			+ ": " + e.displayText(),
+			__FILE__, __LINE__);
+		definite = false;
+	}
+
+	ScopedLockWithUnlock<FastMutex> guard(m_lock);
+
+	Job &job = m_jobs[jobID];
+	job.finished = true;
+
+	if (job.cancelled)
+		return;
+
+	if (definite)
+		m_cache.store(id, zwave);
+
+	guard.unlock();
+
+	if (!zwave)
+		return;
+
+	try {
+		detected(event);
+	}
+	BEEEON_CATCH_CHAIN(logger())
+}
+
+void ZWaveParallelProber::probeNode(const string &node, const Timespan &timeout)
+{
+	if (!m_reactor.isNull()) {
+		ZWaveSerialProber prober(*m_reactor, node);
+		prober.probe(timeout);
+	}
+	else {
+		SerialPort port(node);
+		ZWaveSerialProber::setupPort(port);
+		ZWaveSerialProber prober(port);
+
+		prober.probe(timeout);
+	}
+}
+
+void ZWaveParallelProber::cancel(const string &node)
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	for (auto &pair : m_jobs) {
+		if (pair.second.node == node)
+			pair.second.cancelled = true;
+	}
+}
+
+void ZWaveParallelProber::stop()
+{
+	ScopedLockWithUnlock<FastMutex> guard(m_lock);
+
+	for (auto &pair : m_jobs)
+		pair.second.cancelled = true;
+
+	guard.unlock();
+
+	wait();
+}
+
+void ZWaveParallelProber::wait()
+{
+	ScopedLockWithUnlock<FastMutex> guard(m_lock);
+
+	vector<SharedPtr<Thread>> threads;
+	for (const auto &pair : m_jobs)
+		threads.emplace_back(pair.second.thread);
+
+	guard.unlock();
+
+	for (auto &thread : threads)
+		thread->join();
+
+	reap();
+}
+
+void ZWaveParallelProber::reap()
+{
+	ScopedLockWithUnlock<FastMutex> guard(m_lock);
+
+	vector<SharedPtr<Thread>> threads;
+
+	for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+		if (it->second.finished) {
+			threads.emplace_back(it->second.thread);
+			it = m_jobs.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	guard.unlock();
+
+	// threads are finished or about to return
+	for (auto &thread : threads)
+		thread->join();
+}
+
+size_t ZWaveParallelProber::running() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+
+	size_t count = 0;
+
+	for (const auto &pair : m_jobs) {
+		if (!pair.second.finished)
+			++count;
+	}
+
+	return count;
+}
+
+const ZWaveProbeCache &ZWaveParallelProber::cache() const
+{
+	return m_cache;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include <Poco/Mutex.h>
+#include <Poco/SharedPtr.h>
+#include <Poco/Thread.h>
+#include <Poco/Timespan.h>
+#include <Poco/Types.h>
+
+#include "io/SerialReactor.h"
+#include "util/Loggable.h"
+#include "zwave/ZWaveProbeCache.h"
+
+namespace BeeeOn {
+
+class HotplugEvent;
+
+/**
+ * @brief ZWaveParallelProber identifies Z-Wave controllers among
+ * serial devices reported by hotplug events. Each device is probed
+ * by ZWaveSerialProber in a separate thread, thus a slow or silent
+ * device does not delay probing of the others. All devices reported
+ * at once (e.g. during the initial scan on boot) are resolved within
+ * a single timeout that is counted since the probe is requested.
+ *
+ * Results are cached by the identity of the USB serial device,
+ * a replugged device is resolved without probing. Only a Z-Wave
+ * controller and a device answering with data not following the Z-Wave
+ * serial API are cached. Failures to open or read the device, timeouts
+ * and protocol errors are not cached, such a device is probed again
+ * when it reappears.
+ */
+class ZWaveParallelProber : protected Loggable {
+public:
+	typedef std::function<void(const HotplugEvent &event)> Handler;
+
+	ZWaveParallelProber();
+	~ZWaveParallelProber();
+
+	/**
+	 * @brief Set reactor to probe serial ports with. If not set,
+	 * each serial port is read by its probing thread.
+	 */
+	void setSerialReactor(SerialReactor::Ptr reactor);
+
+	/**
+	 * @brief Set deadline of probing of a single device.
+	 */
+	void setTimeout(const Poco::Timespan &timeout);
+
+	/**
+	 * @brief Resolve whether the device reported by the given event
+	 * is a Z-Wave controller. The detected handler is called when it
+	 * is. A cached result is resolved immediately from the calling
+	 * thread. Otherwise, the device is probed asynchronously and the
+	 * handler is called from the probing thread.
+	 *
+	 * Devices already being probed are ignored unless their probing
+	 * has been cancelled (e.g. the device has been replugged while
+	 * being probed). In such case, the device is probed again.
+	 */
+	void probe(const HotplugEvent &event, const Handler &detected);
+
+	/**
+	 * @brief Do not report the device of the given node even if
+	 * its probing succeeds. Used when the device is unplugged.
+	 */
+	void cancel(const std::string &node);
+
+	/**
+	 * @brief Cancel all probes and wait until they finish.
+	 */
+	void stop();
+
+	/**
+	 * @brief Wait until all running probes finish.
+	 */
+	void wait();
+
+	/**
+	 * @returns count of running probes
+	 */
+	size_t running() const;
+
+	const ZWaveProbeCache &cache() const;
+
+protected:
+	/**
+	 * @brief Probe the device in the context of its thread.
+	 */
+	void execute(
+		Poco::UInt64 jobID,
+		const HotplugEvent &event,
+		const Poco::Timespan &timeout,
+		const Handler &detected);
+
+	/**
+	 * @brief Probe the serial port of the given node.
+	 * @throws Poco::Exception when the device is not a Z-Wave controller
+	 */
+	void probeNode(const std::string &node, const Poco::Timespan &timeout);
+
+	/**
+	 * @brief Join threads of finished probes.
+	 */
+	void reap();
+
+private:
+	struct Job {
+		std::string node;
+		Poco::SharedPtr<Poco::Thread> thread;
+		bool cancelled;
+		bool finished;
+	};
+
+	SerialReactor::Ptr m_reactor;
+	Poco::Timespan m_timeout;
+	ZWaveProbeCache m_cache;
+
+	/**
+	 * Jobs are identified by a sequence number because a cancelled
+	 * job of a node can still be running when the node is probed
+	 * again.
+	 */
+	std::map<Poco::UInt64, Job> m_jobs;
+	Poco::UInt64 m_nextJob;
+	mutable Poco::FastMutex m_lock;
+};
+
+}
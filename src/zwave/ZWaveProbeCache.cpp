@@ -0,0 +1,48 @@
+#include "hotplug/HotplugEvent.h"
+#include "zwave/ZWaveProbeCache.h"
+
+using namespace BeeeOn;
+using namespace Poco;
+using namespace std;
+
+string ZWaveProbeCache::identify(const HotplugEvent &event)
+{
+	const auto properties = event.properties();
+	const string serial = properties->getString("tty.ID_SERIAL_SHORT", "");
+
+	if (serial.empty())
+		return "";
+
+	return properties->getString("tty.ID_VENDOR_ID", "")
+		+ ":" + properties->getString("tty.ID_MODEL_ID", "")
+		+ ":" + serial;
+}
+
+ZWaveProbeCache::Result ZWaveProbeCache::lookup(const string &id) const
+{
+	if (id.empty())
+		return UNKNOWN;
+
+	FastMutex::ScopedLock guard(m_lock);
+
+	auto it = m_results.find(id);
+	if (it == m_results.end())
+		return UNKNOWN;
+
+	return it->second ? ZWAVE : OTHER;
+}
+
+void ZWaveProbeCache::store(const string &id, bool zwave)
+{
+	if (id.empty())
+		return;
+
+	FastMutex::ScopedLock guard(m_lock);
+	m_results[id] = zwave;
+}
+
+size_t ZWaveProbeCache::size() const
+{
+	FastMutex::ScopedLock guard(m_lock);
+	return m_results.size();
+}
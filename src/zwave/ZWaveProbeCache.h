@@ -0,0 +1,55 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <Poco/Mutex.h>
+
+namespace BeeeOn {
+
+class HotplugEvent;
+
+/**
+ * @brief Results of probing serial devices for Z-Wave controllers.
+ * The results are indexed by identity of the USB serial device
+ * (vendor, model and serial number as reported by udev). Thus,
+ * a replugged device is recognized without probing it again even
+ * when it appears under a different device node.
+ *
+ * Devices without a serial number cannot be told apart from other
+ * devices of the same model and they are never cached.
+ */
+class ZWaveProbeCache {
+public:
+	enum Result {
+		UNKNOWN,
+		ZWAVE,
+		OTHER,
+	};
+
+	/**
+	 * @returns identity of the device reported by the given event
+	 * or an empty string when the device cannot be identified
+	 */
+	static std::string identify(const HotplugEvent &event);
+
+	/**
+	 * @returns cached result for the given identity, UNKNOWN when
+	 * there is no such result or the identity is empty
+	 */
+	Result lookup(const std::string &id) const;
+
+	/**
+	 * @brief Cache result of probing of the given device. Empty
+	 * identities are ignored.
+	 */
+	void store(const std::string &id, bool zwave);
+
+	size_t size() const;
+
+private:
+	std::map<std::string, bool> m_results;
+	mutable Poco::FastMutex m_lock;
+};
+
+}
@@ -0,0 +1,58 @@
+#include "zwave/ZWaveSerialFraming.h"
+
+using namespace BeeeOn;
+using namespace std;
+
+static const char SOF  = 0x01;
+static const char ACK  = 0x06;
+static const char NACK = 0x15;
+static const char CAN  = 0x18;
+
+static const size_t HEADER_SIZE = 2;
+
+ZWaveSerialFraming::ZWaveSerialFraming():
+	m_dropped(0)
+{
+}
+
+bool ZWaveSerialFraming::extract(string &buffer, string &frame)
+{
+	size_t begin = 0;
+
+	while (begin < buffer.size()) {
+		const char c = buffer[begin];
+
+		if (c == SOF || c == ACK || c == NACK || c == CAN)
+			break;
+
+		++begin;
+	}
+
+	buffer.erase(0, begin);
+	m_dropped += begin;
+
+	if (buffer.empty())
+		return false;
+
+	if (buffer[0] != SOF) {
+		frame.assign(1, buffer[0]);
+		buffer.erase(0, 1);
+		return true;
+	}
+
+	if (buffer.size() < HEADER_SIZE)
+		return false;
+
+	const size_t size = HEADER_SIZE + static_cast<uint8_t>(buffer[1]);
+	if (buffer.size() < size)
+		return false;
+
+	frame.assign(buffer, 0, size);
+	buffer.erase(0, size);
+	return true;
+}
+
+size_t ZWaveSerialFraming::dropped() const
+{
+	return m_dropped;
+}
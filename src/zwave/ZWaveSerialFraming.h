@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include <Poco/SharedPtr.h>
+
+#include "io/SerialFraming.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Framing of the Z-Wave serial API. A frame is either a single
+ * byte ACK, NACK or CAN, or a data frame starting with SOF followed by
+ * its length, the payload and a checksum. Bytes that cannot start any
+ * frame are dropped. The checksum is not verified by the framing.
+ */
+class ZWaveSerialFraming : public SerialFraming {
+public:
+	typedef Poco::SharedPtr<ZWaveSerialFraming> Ptr;
+
+	ZWaveSerialFraming();
+
+	bool extract(std::string &buffer, std::string &frame) override;
+
+	/**
+	 * @returns count of dropped bytes, a device sending such bytes
+	 * does not speak the Z-Wave serial API
+	 */
+	size_t dropped() const;
+
+private:
+	std::atomic<size_t> m_dropped;
+};
+
+}
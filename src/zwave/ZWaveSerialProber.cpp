@@ -16,11 +16,22 @@ static const char RESPONSE  = 0x01;
 static const char VERSION   = 0x15;
 static const char ACK       = 0x06;
 static const char NACK      = 0x15;
+static const char CAN       = 0x18;
 
 static const size_t HEADER_SIZE = 2;
 
 ZWaveSerialProber::ZWaveSerialProber(SerialPort &port):
-	m_port(port)
+	m_port(&port),
+	m_reactor(nullptr),
+	m_failed(false)
+{
+}
+
+ZWaveSerialProber::ZWaveSerialProber(SerialReactor &reactor, const string &dev):
+	m_port(nullptr),
+	m_reactor(&reactor),
+	m_dev(dev),
+	m_failed(false)
 {
 }
 
@@ -31,17 +42,70 @@ void ZWaveSerialProber::probe(const Timespan &timeout)
 	if (timeout < 0)
 		throw InvalidArgumentException("timeout must not be negative");
 
-	if (!m_port.isOpen())
-		m_port.open();
+	if (m_reactor != nullptr) {
+		openChannel();
+	}
+	else {
+		if (!m_port->isOpen())
+			m_port->open();
+
+		m_port->flush();
+	}
 
-	m_port.flush();
+	string ver;
 
-	nack(timeout - started.elapsed());
-	const auto &ver = version(timeout - started.elapsed());
+	try {
+		nack(timeout - started.elapsed());
+		ver = version(timeout - started.elapsed());
+	}
+	catch (...) {
+		closeChannel();
+		throw;
+	}
+
+	closeChannel();
 
 	logger().information("detected " + ver);
 }
 
+void ZWaveSerialProber::openChannel()
+{
+	m_received.clear();
+	m_failed = false;
+	m_receivedEvent.reset();
+
+	m_framing = new ZWaveSerialFraming;
+	m_channel = m_reactor->open(
+		m_dev,
+		settings(),
+		m_framing,
+		[&](const string &frame) {
+			receiveFrame(frame);
+		},
+		[&](const Exception &) {
+			FastMutex::ScopedLock guard(m_receivedLock);
+			m_failed = true;
+			m_receivedEvent.set();
+		});
+}
+
+void ZWaveSerialProber::closeChannel()
+{
+	if (m_channel.isNull())
+		return;
+
+	m_reactor->close(m_channel);
+	m_channel = nullptr;
+}
+
+void ZWaveSerialProber::receiveFrame(const string &frame)
+{
+	FastMutex::ScopedLock guard(m_receivedLock);
+
+	m_received += frame;
+	m_receivedEvent.set();
+}
+
 string ZWaveSerialProber::buildMessage(const vector<uint8_t> payload) const
 {
 	poco_assert(payload.size() <= 254);
@@ -79,8 +143,13 @@ void ZWaveSerialProber::writeAll(const string &s, const Timespan &timeout)
 			__FILE__, __LINE__);
 	}
 
+	if (!m_channel.isNull()) {
+		m_channel->write(s, timeout);
+		return;
+	}
+
 	while (total < s.size()) {
-		size_t wlen = m_port.write(s.data() + total, s.size() - total);
+		size_t wlen = m_port->write(s.data() + total, s.size() - total);
 
 		if (wlen == 0) {
 			if (!started.isElapsed(timeout.totalMicroseconds()))
@@ -115,11 +184,11 @@ string ZWaveSerialProber::read(size_t max, const Timespan &timeout)
 	}
 
 	if (s.empty()) {
-		s = m_port.read(timeout);
+		s = fetch(timeout);
 
 		if (s.size() > max) {
-			m_buffer = {s.begin() + s.size(), s.end()};
-			s.erase(s.begin() + s.size(), s.end());
+			m_buffer = {s.begin() + max, s.end()};
+			s.erase(s.begin() + max, s.end());
 		}
 	}
 
@@ -139,6 +208,37 @@ string ZWaveSerialProber::read(size_t max, const Timespan &timeout)
 	return s;
 }
 
+string ZWaveSerialProber::fetch(const Timespan &timeout)
+{
+	if (m_channel.isNull())
+		return m_port->read(timeout);
+
+	const Clock started;
+
+	while (true) {
+		ScopedLockWithUnlock<FastMutex> guard(m_receivedLock);
+
+		if (!m_received.empty()) {
+			string data;
+			data.swap(m_received);
+			return data;
+		}
+
+		if (m_failed)
+			throw IOException("serial port " + m_dev + " has failed");
+
+		guard.unlock();
+
+		const Timespan remaining = timeout - started.elapsed();
+		if (remaining <= 0 && m_framing->dropped() > 0)
+			throw DataFormatException("no Z-Wave frame received from " + m_dev);
+		if (remaining <= 0)
+			throw TimeoutException("no data received from " + m_dev);
+
+		m_receivedEvent.tryWait(remaining.totalMilliseconds() + 1);
+	}
+}
+
 void ZWaveSerialProber::nack(const Timespan &timeout)
 {
 	if (logger().debug())
@@ -156,8 +256,13 @@ void ZWaveSerialProber::writeAck(const Timespan &timeout)
 void ZWaveSerialProber::readAck(const Timespan &timeout)
 {
 	const auto &ack = read(1, timeout);
-	if (ack != string{ACK})
-		throw ProtocolException("received unexpected data, expected ACK");
+	if (ack == string{ACK})
+		return;
+
+	if (ack != string{NACK} && ack != string{CAN} && ack != string{SOF})
+		throw DataFormatException("received non Z-Wave data, expected ACK");
+
+	throw ProtocolException("received unexpected data, expected ACK");
 }
 
 size_t ZWaveSerialProber::decodeHeader(const string &message) const
@@ -252,3 +357,8 @@ void ZWaveSerialProber::setupPort(SerialPort &port)
 	port.setParity(SerialPort::PARITY_NONE);
 	port.setStopBits(SerialPort::STOPBITS_1);
 }
+
+SerialChannel::Settings ZWaveSerialProber::settings()
+{
+	return SerialChannel::Settings(115200, 8, SerialChannel::PARITY_NONE, 1);
+}
@@ -3,10 +3,15 @@
 #include <string>
 #include <vector>
 
+#include <Poco/Event.h>
+#include <Poco/Mutex.h>
 #include <Poco/Timespan.h>
 
+#include "io/SerialChannel.h"
 #include "io/SerialPort.h"
+#include "io/SerialReactor.h"
 #include "util/Loggable.h"
+#include "zwave/ZWaveSerialFraming.h"
 
 namespace BeeeOn {
 
@@ -15,10 +20,15 @@ namespace BeeeOn {
  * a serial port is a Z-Wave controller. We try to obtain its version
  * (and report it). If the version cannot be obtained an exception is
  * thrown.
+ *
+ * The prober works either with a SerialPort read synchronously or
+ * with a SerialReactor. In the latter case, the serial port is
+ * registered into the reactor only while probing.
  */
 class ZWaveSerialProber : Loggable {
 public:
 	ZWaveSerialProber(SerialPort &port);
+	ZWaveSerialProber(SerialReactor &reactor, const std::string &dev);
 
 	/**
 	 * @brief Probe the configured serial port and try to find a
@@ -32,6 +42,9 @@ public:
 	 * @throws Poco::InvalidArgumentException - when timeout is invalid
 	 * @throws Poco::TimeoutException - when timeout exceeds while probing
 	 * @throws Poco::ProtocolException - when the remote device gives unexpected results
+	 * @throws Poco::DataFormatException - when the remote device answers with
+	 * data not following the Z-Wave serial API at all, i.e. it is definitely
+	 * not a Z-Wave controller
 	 */
 	void probe(const Poco::Timespan &timeout);
 
@@ -41,6 +54,11 @@ public:
 	 */
 	static void setupPort(SerialPort &port);
 
+	/**
+	 * @returns settings typical for Z-Wave controllers
+	 */
+	static SerialChannel::Settings settings();
+
 protected:
 	/**
 	 * @brief Build a message from the given payload. The header with
@@ -59,6 +77,18 @@ protected:
 	void writeAll(const std::string &s, const Poco::Timespan &timeout);
 	std::string read(size_t max, const Poco::Timespan &timeout);
 
+	/**
+	 * @brief Read data either from the serial port or from frames
+	 * received by the reactor.
+	 *
+	 * @throws Poco::TimeoutException
+	 */
+	std::string fetch(const Poco::Timespan &timeout);
+
+	void openChannel();
+	void closeChannel();
+	void receiveFrame(const std::string &frame);
+
 	void writeAck(const Poco::Timespan &timeout);
 	void readAck(const Poco::Timespan &timeout);
 	size_t decodeHeader(const std::string &message) const;
@@ -69,8 +99,17 @@ protected:
 	std::string version(const Poco::Timespan &timeout);
 
 private:
-	SerialPort &m_port;
+	SerialPort *m_port;
+	SerialReactor *m_reactor;
+	std::string m_dev;
+	SerialChannel::Ptr m_channel;
+	ZWaveSerialFraming::Ptr m_framing;
 	std::string m_buffer;
+
+	std::string m_received;
+	bool m_failed;
+	Poco::FastMutex m_receivedLock;
+	Poco::Event m_receivedEvent;
 };
 
 }
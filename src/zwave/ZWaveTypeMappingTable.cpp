@@ -0,0 +1,39 @@
+#include "zwave/ZWaveTypeMappingTable.h"
+
+using namespace BeeeOn;
+using namespace std;
+
+static constexpr ZWaveTypeMappingEntry ENTRIES[] = {
+#include "zwave/ZWaveTypeMappingTable.inc"
+};
+
+static constexpr size_t ENTRIES_COUNT = sizeof(ENTRIES) / sizeof(ENTRIES[0]);
+
+const ZWaveTypeMappingEntry *ZWaveTypeMappingTable::begin()
+{
+	return ENTRIES;
+}
+
+const ZWaveTypeMappingEntry *ZWaveTypeMappingTable::end()
+{
+	return ENTRIES + ENTRIES_COUNT;
+}
+
+size_t ZWaveTypeMappingTable::size()
+{
+	return ENTRIES_COUNT;
+}
+
+TypeMappingParser<ZWaveType>::TypeMappingSequence ZWaveTypeMappingTable::sequence()
+{
+	TypeMappingParser<ZWaveType>::TypeMappingSequence sequence;
+	sequence.reserve(ENTRIES_COUNT);
+
+	for (const auto &entry : ENTRIES) {
+		sequence.emplace_back(
+			ZWaveType(entry.commandClass, entry.index),
+			ModuleType::parse(entry.type));
+	}
+
+	return sequence;
+}
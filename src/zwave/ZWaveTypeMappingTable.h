@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util/TypeMappingParser.h"
+#include "zwave/ZWaveTypeMappingParser.h"
+
+namespace BeeeOn {
+
+/**
+ * @brief Single mapping of a Z-Wave command class (and its index)
+ * to the BeeeOn type. The type is in the same format as the attribute
+ * type of the element <code><beeeon /></code> of types-mapping.xml.
+ */
+struct ZWaveTypeMappingEntry {
+	uint8_t commandClass;
+	uint8_t index;
+	const char *type;
+};
+
+/**
+ * @brief Z-Wave types mapping compiled into the gateway. The table is
+ * generated from conf/types-mapping.xml during build by the script
+ * tools/gateway-compile-types-mapping.py and thus it is always the same
+ * as the installed XML file. Using the table avoids building a DOM of
+ * the XML file during every startup.
+ */
+class ZWaveTypeMappingTable {
+public:
+	static const ZWaveTypeMappingEntry *begin();
+	static const ZWaveTypeMappingEntry *end();
+	static size_t size();
+
+	/**
+	 * @returns the table in the same form as ZWaveTypeMappingParser
+	 * returns for the XML file
+	 * @throws Poco::InvalidArgumentException for an invalid type
+	 */
+	static TypeMappingParser<ZWaveType>::TypeMappingSequence sequence();
+};
+
+}
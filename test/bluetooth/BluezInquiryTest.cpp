@@ -0,0 +1,402 @@
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+
+#include "cppunit/BetterAssert.h"
+#include "bluetooth/BluezInquiry.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class BluezInquiryTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(BluezInquiryTest);
+	CPPUNIT_TEST(testInquiryResults);
+	CPPUNIT_TEST(testTruncatedResult);
+	CPPUNIT_TEST(testNameResolution);
+	CPPUNIT_TEST(testCachedName);
+	CPPUNIT_TEST(testCommandDisallowed);
+	CPPUNIT_TEST(testInquiryFailed);
+	CPPUNIT_TEST(testFinish);
+	CPPUNIT_TEST(testNameCacheBounded);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testInquiryResults();
+	void testTruncatedResult();
+	void testNameResolution();
+	void testCachedName();
+	void testCommandDisallowed();
+	void testInquiryFailed();
+	void testFinish();
+	void testNameCacheBounded();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BluezInquiryTest);
+
+static const MACAddress DEVICE_A = MACAddress::parse("00:11:22:33:44:01", ':');
+static const MACAddress DEVICE_B = MACAddress::parse("00:11:22:33:44:02", ':');
+static const MACAddress DEVICE_C = MACAddress::parse("00:11:22:33:44:03", ':');
+static const MACAddress DEVICE_D = MACAddress::parse("00:11:22:33:44:04", ':');
+
+/**
+ * Inquiry without any HCI socket, the sent commands are recorded
+ * and events are fed directly by the test.
+ */
+class TestingBluezInquiry : public BluezInquiry {
+public:
+	TestingBluezInquiry(BluezNameCache &cache):
+		BluezInquiry(-1, m_report, cache)
+	{
+		m_report = [&](const MACAddress &address, const string &name) {
+			reported[address] = name;
+		};
+	}
+
+	using BluezInquiry::startInquiry;
+	using BluezInquiry::finished;
+	using BluezInquiry::finish;
+	using BluezInquiry::requestNames;
+
+	void process(const vector<uint8_t> &event)
+	{
+		processEvent(event.data(), event.size());
+	}
+
+	vector<uint16_t> commands;
+	vector<MACAddress> requested;
+	vector<MACAddress> cancelled;
+	map<MACAddress, string> reported;
+
+protected:
+	void sendCommand(uint16_t ocf, uint8_t, void *param) override
+	{
+		commands.emplace_back(ocf);
+
+		if (ocf == OCF_REMOTE_NAME_REQ) {
+			const remote_name_req_cp *cp = (const remote_name_req_cp *) param;
+			requested.emplace_back(MACAddress(cp->bdaddr.b));
+		}
+		else if (ocf == OCF_REMOTE_NAME_REQ_CANCEL) {
+			const remote_name_req_cancel_cp *cp = (const remote_name_req_cancel_cp *) param;
+			cancelled.emplace_back(MACAddress(cp->bdaddr.b));
+		}
+	}
+
+private:
+	HciInterface::ScanCallback m_report;
+};
+
+static vector<uint8_t> event(uint8_t evt, const vector<uint8_t> &params)
+{
+	vector<uint8_t> data = {HCI_EVENT_PKT, evt, static_cast<uint8_t>(params.size())};
+	data.insert(data.end(), params.begin(), params.end());
+	return data;
+}
+
+template <typename T>
+static void append(vector<uint8_t> &params, const T &info)
+{
+	const uint8_t *raw = (const uint8_t *) &info;
+	params.insert(params.end(), raw, raw + sizeof(info));
+}
+
+static vector<uint8_t> inquiryResult(const vector<MACAddress> &devices)
+{
+	vector<uint8_t> params = {static_cast<uint8_t>(devices.size())};
+
+	for (const auto &address : devices) {
+		inquiry_info info;
+		::memset(&info, 0, sizeof(info));
+		address.into(info.bdaddr.b);
+		append(params, info);
+	}
+
+	return event(EVT_INQUIRY_RESULT, params);
+}
+
+static vector<uint8_t> inquiryResultWithRSSI(const MACAddress &address)
+{
+	inquiry_info_with_rssi info;
+	::memset(&info, 0, sizeof(info));
+	address.into(info.bdaddr.b);
+	info.rssi = -60;
+
+	vector<uint8_t> params = {1};
+	append(params, info);
+	return event(EVT_INQUIRY_RESULT_WITH_RSSI, params);
+}
+
+static vector<uint8_t> extendedInquiryResult(
+		const MACAddress &address,
+		const string &name)
+{
+	extended_inquiry_info info;
+	::memset(&info, 0, sizeof(info));
+	address.into(info.bdaddr.b);
+
+	info.data[0] = name.size() + 1;
+	info.data[1] = 0x09; // complete local name
+	::memcpy(info.data + 2, name.data(), name.size());
+
+	vector<uint8_t> params = {1};
+	append(params, info);
+	return event(EVT_EXTENDED_INQUIRY_RESULT, params);
+}
+
+static vector<uint8_t> nameComplete(
+		const MACAddress &address,
+		const string &name,
+		uint8_t status = 0)
+{
+	evt_remote_name_req_complete complete;
+	::memset(&complete, 0, sizeof(complete));
+	complete.status = status;
+	address.into(complete.bdaddr.b);
+	::memcpy(complete.name, name.data(), name.size());
+
+	vector<uint8_t> params;
+	append(params, complete);
+	return event(EVT_REMOTE_NAME_REQ_COMPLETE, params);
+}
+
+static vector<uint8_t> commandStatus(uint16_t ocf, uint8_t status)
+{
+	evt_cmd_status cmd;
+	cmd.status = status;
+	cmd.ncmd = 1;
+	cmd.opcode = htobs(cmd_opcode_pack(OGF_LINK_CTL, ocf));
+
+	vector<uint8_t> params;
+	append(params, cmd);
+	return event(EVT_CMD_STATUS, params);
+}
+
+static vector<uint8_t> inquiryComplete()
+{
+	return event(EVT_INQUIRY_COMPLETE, {0});
+}
+
+/**
+ * All kinds of inquiry results are parsed. A name carried via EIR
+ * is reported immediately, other devices wait for their names.
+ */
+void BluezInquiryTest::testInquiryResults()
+{
+	BluezNameCache cache(8);
+	TestingBluezInquiry inquiry(cache);
+
+	inquiry.startInquiry();
+	CPPUNIT_ASSERT_EQUAL(1, inquiry.commands.size());
+	CPPUNIT_ASSERT_EQUAL(OCF_INQUIRY, inquiry.commands[0]);
+
+	inquiry.process(inquiryResult({DEVICE_A, DEVICE_B}));
+	inquiry.process(inquiryResultWithRSSI(DEVICE_C));
+	inquiry.process(extendedInquiryResult(DEVICE_D, "Phone"));
+
+	CPPUNIT_ASSERT_EQUAL(1, inquiry.reported.size());
+	CPPUNIT_ASSERT_EQUAL("Phone", inquiry.reported[DEVICE_D]);
+
+	string name;
+	CPPUNIT_ASSERT(cache.lookup(DEVICE_D, name));
+	CPPUNIT_ASSERT_EQUAL("Phone", name);
+
+	inquiry.requestNames();
+
+	CPPUNIT_ASSERT_EQUAL(3, inquiry.requested.size());
+	CPPUNIT_ASSERT(inquiry.requested[0] == DEVICE_A);
+	CPPUNIT_ASSERT(inquiry.requested[1] == DEVICE_B);
+	CPPUNIT_ASSERT(inquiry.requested[2] == DEVICE_C);
+}
+
+/**
+ * Results not fitting into the event are ignored as well as events
+ * that are not HCI events at all.
+ */
+void BluezInquiryTest::testTruncatedResult()
+{
+	BluezNameCache cache(8);
+	TestingBluezInquiry inquiry(cache);
+
+	vector<uint8_t> truncated = inquiryResult({DEVICE_A, DEVICE_B});
+	truncated.resize(truncated.size() - 1);
+
+	inquiry.process(truncated);
+	inquiry.process({HCI_EVENT_PKT});
+	inquiry.process({HCI_ACLDATA_PKT, EVT_INQUIRY_COMPLETE, 1, 0});
+	inquiry.requestNames();
+
+	CPPUNIT_ASSERT_EQUAL(1, inquiry.requested.size());
+	CPPUNIT_ASSERT(inquiry.requested[0] == DEVICE_A);
+	CPPUNIT_ASSERT(!inquiry.finished());
+}
+
+/**
+ * At most 3 names are requested at once. The next name is requested
+ * when one of them completes. Resolved names are cached.
+ */
+void BluezInquiryTest::testNameResolution()
+{
+	BluezNameCache cache(8);
+	TestingBluezInquiry inquiry(cache);
+
+	inquiry.startInquiry();
+	inquiry.process(inquiryResult({DEVICE_A, DEVICE_B, DEVICE_C, DEVICE_D}));
+	inquiry.requestNames();
+
+	CPPUNIT_ASSERT_EQUAL(3, inquiry.requested.size());
+
+	inquiry.process(nameComplete(DEVICE_A, "Headset"));
+	inquiry.process(nameComplete(DEVICE_B, "", 0x04));
+
+	CPPUNIT_ASSERT_EQUAL(2, inquiry.reported.size());
+	CPPUNIT_ASSERT_EQUAL("Headset", inquiry.reported[DEVICE_A]);
+	CPPUNIT_ASSERT_EQUAL("unknown", inquiry.reported[DEVICE_B]);
+
+	string name;
+	CPPUNIT_ASSERT(cache.lookup(DEVICE_A, name));
+	CPPUNIT_ASSERT_EQUAL("Headset", name);
+	CPPUNIT_ASSERT(!cache.lookup(DEVICE_B, name));
+
+	inquiry.requestNames();
+	CPPUNIT_ASSERT_EQUAL(4, inquiry.requested.size());
+	CPPUNIT_ASSERT(inquiry.requested[3] == DEVICE_D);
+
+	inquiry.process(inquiryComplete());
+	inquiry.process(nameComplete(DEVICE_C, "Keyboard"));
+	CPPUNIT_ASSERT(!inquiry.finished());
+
+	inquiry.process(nameComplete(DEVICE_D, "Mouse"));
+	CPPUNIT_ASSERT(inquiry.finished());
+	CPPUNIT_ASSERT_EQUAL(4, inquiry.reported.size());
+}
+
+void BluezInquiryTest::testCachedName()
+{
+	BluezNameCache cache(8);
+	cache.store(DEVICE_A, "Speaker");
+
+	TestingBluezInquiry inquiry(cache);
+
+	inquiry.process(inquiryResult({DEVICE_A}));
+	inquiry.requestNames();
+
+	CPPUNIT_ASSERT(inquiry.requested.empty());
+	CPPUNIT_ASSERT_EQUAL("Speaker", inquiry.reported[DEVICE_A]);
+}
+
+/**
+ * A name request rejected by the controller as disallowed lowers
+ * the count of parallel requests and it is retried later.
+ */
+void BluezInquiryTest::testCommandDisallowed()
+{
+	BluezNameCache cache(8);
+	TestingBluezInquiry inquiry(cache);
+
+	inquiry.process(inquiryResult({DEVICE_A, DEVICE_B, DEVICE_C}));
+	inquiry.requestNames();
+	CPPUNIT_ASSERT_EQUAL(3, inquiry.requested.size());
+
+	inquiry.process(commandStatus(OCF_REMOTE_NAME_REQ, 0));
+	inquiry.process(commandStatus(OCF_REMOTE_NAME_REQ, 0x0c));
+	inquiry.process(commandStatus(OCF_REMOTE_NAME_REQ, 0));
+
+	inquiry.requestNames();
+	CPPUNIT_ASSERT_EQUAL(3, inquiry.requested.size());
+	CPPUNIT_ASSERT(inquiry.reported.empty());
+
+	inquiry.process(nameComplete(DEVICE_A, "Headset"));
+	inquiry.requestNames();
+
+	CPPUNIT_ASSERT_EQUAL(4, inquiry.requested.size());
+	CPPUNIT_ASSERT(inquiry.requested[3] == DEVICE_B);
+
+	inquiry.process(nameComplete(DEVICE_C, "Keyboard"));
+	inquiry.requestNames();
+
+	// the limit stays lowered, nothing else is waiting
+	CPPUNIT_ASSERT_EQUAL(4, inquiry.requested.size());
+}
+
+/**
+ * When the inquiry fails, the name requests in progress are
+ * cancelled and the failure is reported.
+ */
+void BluezInquiryTest::testInquiryFailed()
+{
+	BluezNameCache cache(8);
+	TestingBluezInquiry inquiry(cache);
+
+	inquiry.startInquiry();
+	inquiry.process(inquiryResult({DEVICE_A, DEVICE_B}));
+	inquiry.requestNames();
+	CPPUNIT_ASSERT_EQUAL(2, inquiry.requested.size());
+
+	CPPUNIT_ASSERT_THROW(
+		inquiry.process(commandStatus(OCF_INQUIRY, 0x0c)),
+		IOException);
+
+	CPPUNIT_ASSERT_EQUAL(2, inquiry.cancelled.size());
+	CPPUNIT_ASSERT(inquiry.cancelled[0] == DEVICE_A);
+	CPPUNIT_ASSERT(inquiry.cancelled[1] == DEVICE_B);
+	CPPUNIT_ASSERT(inquiry.finished());
+
+	for (const auto &ocf : inquiry.commands)
+		CPPUNIT_ASSERT(ocf != OCF_INQUIRY_CANCEL);
+}
+
+/**
+ * Finishing cancels the inquiry and name requests in progress
+ * and reports the devices without names.
+ */
+void BluezInquiryTest::testFinish()
+{
+	BluezNameCache cache(8);
+	TestingBluezInquiry inquiry(cache);
+
+	inquiry.startInquiry();
+	inquiry.process(inquiryResult({DEVICE_A}));
+	inquiry.requestNames();
+	inquiry.finish();
+
+	CPPUNIT_ASSERT_EQUAL(4, inquiry.commands.size());
+	CPPUNIT_ASSERT_EQUAL(OCF_INQUIRY_CANCEL, inquiry.commands[2]);
+	CPPUNIT_ASSERT_EQUAL(OCF_REMOTE_NAME_REQ_CANCEL, inquiry.commands[3]);
+	CPPUNIT_ASSERT_EQUAL(1, inquiry.cancelled.size());
+	CPPUNIT_ASSERT(inquiry.cancelled[0] == DEVICE_A);
+	CPPUNIT_ASSERT_EQUAL("unknown", inquiry.reported[DEVICE_A]);
+
+	// a late response is ignored
+	inquiry.process(nameComplete(DEVICE_A, "Headset"));
+	CPPUNIT_ASSERT_EQUAL("unknown", inquiry.reported[DEVICE_A]);
+}
+
+/**
+ * The cache drops the name stored least recently when it is full.
+ */
+void BluezInquiryTest::testNameCacheBounded()
+{
+	BluezNameCache cache(2);
+	string name;
+
+	cache.store(DEVICE_A, "A");
+	cache.store(DEVICE_B, "B");
+	cache.store(DEVICE_A, "A2");
+	cache.store(DEVICE_C, "C");
+
+	CPPUNIT_ASSERT_EQUAL(2, cache.size());
+	CPPUNIT_ASSERT(!cache.lookup(DEVICE_B, name));
+	CPPUNIT_ASSERT(cache.lookup(DEVICE_A, name));
+	CPPUNIT_ASSERT_EQUAL("A2", name);
+	CPPUNIT_ASSERT(cache.lookup(DEVICE_C, name));
+	CPPUNIT_ASSERT_EQUAL("C", name);
+
+	CPPUNIT_ASSERT_THROW(BluezNameCache(0), InvalidArgumentException);
+}
+
+}
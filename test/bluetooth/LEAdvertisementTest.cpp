@@ -0,0 +1,275 @@
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+
+#include "cppunit/BetterAssert.h"
+#include "bluetooth/LEAdvertisement.h"
+#include "bluetooth/LEAdvertisementFilter.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class LEAdvertisementTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(LEAdvertisementTest);
+	CPPUNIT_TEST(testParseSingleReport);
+	CPPUNIT_TEST(testParseMultipleReports);
+	CPPUNIT_TEST(testParseTruncated);
+	CPPUNIT_TEST(testParseOtherEvent);
+	CPPUNIT_TEST(testPreferCompleteName);
+	CPPUNIT_TEST(testFilterRepeated);
+	CPPUNIT_TEST(testFilterChanged);
+	CPPUNIT_TEST(testFilterDisabled);
+	CPPUNIT_TEST(testFilterSweep);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testParseSingleReport();
+	void testParseMultipleReports();
+	void testParseTruncated();
+	void testParseOtherEvent();
+	void testPreferCompleteName();
+	void testFilterRepeated();
+	void testFilterChanged();
+	void testFilterDisabled();
+	void testFilterSweep();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LEAdvertisementTest);
+
+static const uint8_t ADDRESS1[6] = {0x66, 0x55, 0x44, 0x33, 0x22, 0x11};
+static const uint8_t ADDRESS2[6] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+
+/**
+ * Append a single advertising report into the given event
+ * and update its parameters length and count of reports.
+ */
+static void appendReport(
+		vector<uint8_t> &event,
+		const uint8_t address[6],
+		const vector<uint8_t> &data,
+		int8_t rssi)
+{
+	if (event.empty())
+		event = {0x04, 0x3e, 2, 0x02, 0};
+
+	event.push_back(0x00); // ADV_IND
+	event.push_back(0x01); // random address
+	event.insert(event.end(), address, address + 6);
+	event.push_back(data.size());
+	event.insert(event.end(), data.begin(), data.end());
+	event.push_back(static_cast<uint8_t>(rssi));
+
+	event[2] = event.size() - 3;
+	event[4] += 1;
+}
+
+static const vector<uint8_t> BEEWI_DATA = {
+	// flags
+	0x02, 0x01, 0x06,
+	// complete name "BeeWi"
+	0x06, 0x09, 'B', 'e', 'e', 'W', 'i',
+	// manufacturer data of company 0x000d
+	0x06, 0xff, 0x0d, 0x00, 0x05, 0x00, 0xe1,
+	// service data of UUID 0x180f (battery)
+	0x04, 0x16, 0x0f, 0x18, 0x5a,
+};
+
+void LEAdvertisementTest::testParseSingleReport()
+{
+	vector<uint8_t> event;
+	appendReport(event, ADDRESS1, BEEWI_DATA, -60);
+
+	vector<string> names;
+	vector<vector<unsigned char>> manufacturer;
+
+	const size_t count = LEAdvertisementParser::parse(event.data(), event.size(),
+		[&](const LEAdvertisement &advertisement) {
+			CPPUNIT_ASSERT_EQUAL(
+				MACAddress(ADDRESS1).toString(':'),
+				advertisement.address().toString(':'));
+			CPPUNIT_ASSERT_EQUAL(1, advertisement.addressType());
+			CPPUNIT_ASSERT_EQUAL(-60, advertisement.rssi());
+
+			CPPUNIT_ASSERT(advertisement.hasName());
+			names.push_back(advertisement.name());
+
+			CPPUNIT_ASSERT(advertisement.hasManufacturerData());
+			CPPUNIT_ASSERT_EQUAL(0x000d, advertisement.manufacturerID());
+			manufacturer.push_back(advertisement.manufacturerData());
+
+			CPPUNIT_ASSERT(advertisement.hasServiceData());
+			CPPUNIT_ASSERT_EQUAL(0x180f, advertisement.serviceUUID());
+			CPPUNIT_ASSERT_EQUAL(1, advertisement.serviceData().size());
+			CPPUNIT_ASSERT_EQUAL(0x5a, advertisement.serviceData()[0]);
+
+			CPPUNIT_ASSERT_EQUAL(BEEWI_DATA.size(), advertisement.payloadSize());
+		});
+
+	CPPUNIT_ASSERT_EQUAL(1, count);
+	CPPUNIT_ASSERT_EQUAL(1, names.size());
+	CPPUNIT_ASSERT_EQUAL("BeeWi", names[0]);
+	CPPUNIT_ASSERT_EQUAL(1, manufacturer.size());
+	CPPUNIT_ASSERT(manufacturer[0] == vector<unsigned char>({0x05, 0x00, 0xe1}));
+}
+
+void LEAdvertisementTest::testParseMultipleReports()
+{
+	vector<uint8_t> event;
+	appendReport(event, ADDRESS1, BEEWI_DATA, -60);
+	appendReport(event, ADDRESS2, {}, -80);
+
+	vector<string> addresses;
+
+	const size_t count = LEAdvertisementParser::parse(event.data(), event.size(),
+		[&](const LEAdvertisement &advertisement) {
+			addresses.push_back(advertisement.address().toString(':'));
+		});
+
+	CPPUNIT_ASSERT_EQUAL(2, count);
+	CPPUNIT_ASSERT_EQUAL(2, addresses.size());
+	CPPUNIT_ASSERT_EQUAL(MACAddress(ADDRESS1).toString(':'), addresses[0]);
+	CPPUNIT_ASSERT_EQUAL(MACAddress(ADDRESS2).toString(':'), addresses[1]);
+}
+
+/**
+ * @brief Reports exceeding the event are not decoded, the reports
+ * preceding them are.
+ */
+void LEAdvertisementTest::testParseTruncated()
+{
+	vector<uint8_t> event;
+	appendReport(event, ADDRESS1, BEEWI_DATA, -60);
+	appendReport(event, ADDRESS2, BEEWI_DATA, -80);
+
+	unsigned int calls = 0;
+	const auto callback = [&](const LEAdvertisement &) {
+		calls += 1;
+	};
+
+	CPPUNIT_ASSERT_EQUAL(1, LEAdvertisementParser::parse(
+		event.data(), event.size() - 1, callback));
+	CPPUNIT_ASSERT_EQUAL(1, calls);
+
+	CPPUNIT_ASSERT_EQUAL(0, LEAdvertisementParser::parse(
+		event.data(), 12, callback));
+	CPPUNIT_ASSERT_EQUAL(1, calls);
+}
+
+void LEAdvertisementTest::testParseOtherEvent()
+{
+	// LE Connection Complete
+	const vector<uint8_t> event = {0x04, 0x3e, 0x03, 0x01, 0x00, 0x40};
+
+	unsigned int calls = 0;
+	const size_t count = LEAdvertisementParser::parse(event.data(), event.size(),
+		[&](const LEAdvertisement &) {
+			calls += 1;
+		});
+
+	CPPUNIT_ASSERT_EQUAL(0, count);
+	CPPUNIT_ASSERT_EQUAL(0, calls);
+}
+
+void LEAdvertisementTest::testPreferCompleteName()
+{
+	const vector<uint8_t> data = {
+		0x03, 0x08, 'B', 'e',
+		0x06, 0x09, 'B', 'e', 'e', 'W', 'i',
+		0x04, 0x08, 'B', 'e', 'e',
+	};
+
+	LEAdvertisement advertisement;
+	LEAdvertisementParser::parseData(data.data(), data.size(), advertisement);
+
+	CPPUNIT_ASSERT_EQUAL("BeeWi", advertisement.name());
+	CPPUNIT_ASSERT(!advertisement.hasManufacturerData());
+	CPPUNIT_ASSERT(!advertisement.hasServiceData());
+}
+
+void LEAdvertisementTest::testFilterRepeated()
+{
+	LEAdvertisementFilter filter(10 * Timespan::SECONDS);
+	const MACAddress address(ADDRESS1);
+	const Timestamp start;
+
+	CPPUNIT_ASSERT(filter.accept(address, BEEWI_DATA.data(), BEEWI_DATA.size(), start));
+	CPPUNIT_ASSERT(!filter.accept(address, BEEWI_DATA.data(), BEEWI_DATA.size(),
+		start + 1 * Timespan::SECONDS));
+	CPPUNIT_ASSERT(!filter.accept(address, BEEWI_DATA.data(), BEEWI_DATA.size(),
+		start + 9 * Timespan::SECONDS));
+	CPPUNIT_ASSERT(filter.accept(address, BEEWI_DATA.data(), BEEWI_DATA.size(),
+		start + 10 * Timespan::SECONDS));
+
+	CPPUNIT_ASSERT_EQUAL(1, filter.size());
+	CPPUNIT_ASSERT_EQUAL(2, filter.suppressed());
+
+	filter.forget(address);
+	CPPUNIT_ASSERT_EQUAL(0, filter.size());
+	CPPUNIT_ASSERT(filter.accept(address, BEEWI_DATA.data(), BEEWI_DATA.size(),
+		start + 11 * Timespan::SECONDS));
+}
+
+/**
+ * @brief Changed data and data of other devices are never suppressed.
+ */
+void LEAdvertisementTest::testFilterChanged()
+{
+	LEAdvertisementFilter filter(10 * Timespan::SECONDS);
+	const Timestamp start;
+
+	vector<uint8_t> data = BEEWI_DATA;
+
+	CPPUNIT_ASSERT(filter.accept(MACAddress(ADDRESS1), data.data(), data.size(), start));
+	CPPUNIT_ASSERT(filter.accept(MACAddress(ADDRESS2), data.data(), data.size(), start));
+
+	data.back() = 0x5b;
+
+	CPPUNIT_ASSERT(filter.accept(MACAddress(ADDRESS1), data.data(), data.size(),
+		start + 1 * Timespan::SECONDS));
+	CPPUNIT_ASSERT(!filter.accept(MACAddress(ADDRESS1), data.data(), data.size(),
+		start + 2 * Timespan::SECONDS));
+
+	CPPUNIT_ASSERT_EQUAL(2, filter.size());
+	CPPUNIT_ASSERT_EQUAL(1, filter.suppressed());
+}
+
+void LEAdvertisementTest::testFilterDisabled()
+{
+	LEAdvertisementFilter filter;
+	const MACAddress address(ADDRESS1);
+
+	CPPUNIT_ASSERT(filter.accept(address, BEEWI_DATA.data(), BEEWI_DATA.size()));
+	CPPUNIT_ASSERT(filter.accept(address, BEEWI_DATA.data(), BEEWI_DATA.size()));
+	CPPUNIT_ASSERT_EQUAL(0, filter.suppressed());
+
+	CPPUNIT_ASSERT_THROW(filter.setReportInterval(-1), InvalidArgumentException);
+}
+
+/**
+ * @brief Devices not reported for the report interval are forgotten.
+ */
+void LEAdvertisementTest::testFilterSweep()
+{
+	LEAdvertisementFilter filter(10 * Timespan::SECONDS);
+	const Timestamp start;
+
+	CPPUNIT_ASSERT(filter.accept(MACAddress(ADDRESS1),
+		BEEWI_DATA.data(), BEEWI_DATA.size(), start));
+	CPPUNIT_ASSERT(filter.accept(MACAddress(ADDRESS2),
+		BEEWI_DATA.data(), BEEWI_DATA.size(), start + 5 * Timespan::SECONDS));
+	CPPUNIT_ASSERT_EQUAL(2, filter.size());
+
+	CPPUNIT_ASSERT(!filter.accept(MACAddress(ADDRESS2),
+		BEEWI_DATA.data(), BEEWI_DATA.size(), start + 12 * Timespan::SECONDS));
+	CPPUNIT_ASSERT_EQUAL(1, filter.size());
+
+	CPPUNIT_ASSERT(filter.accept(MACAddress(ADDRESS2),
+		BEEWI_DATA.data(), BEEWI_DATA.size(), start + 16 * Timespan::SECONDS));
+	CPPUNIT_ASSERT_EQUAL(1, filter.size());
+	CPPUNIT_ASSERT_EQUAL(1, filter.suppressed());
+}
+
+}
@@ -0,0 +1,369 @@
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+#include <Poco/Timestamp.h>
+
+#include "cppunit/BetterAssert.h"
+
+#include "core/AggregationFilter.h"
+#include "core/SensorDataTesting.h"
+#include "model/SensorData.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class AggregationFilterTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(AggregationFilterTest);
+	CPPUNIT_TEST(testParseRule);
+	CPPUNIT_TEST(testParseRuleInvalid);
+	CPPUNIT_TEST(testPassThrough);
+	CPPUNIT_TEST(testMean);
+	CPPUNIT_TEST(testFunctions);
+	CPPUNIT_TEST(testMixedModules);
+	CPPUNIT_TEST(testInvalidValues);
+	CPPUNIT_TEST(testSkippedWindows);
+	CPPUNIT_TEST(testSingleSample);
+	CPPUNIT_TEST(testReleaseAll);
+	CPPUNIT_TEST(testFirstRuleApplies);
+	CPPUNIT_TEST(testGrace);
+	CPPUNIT_TEST(testLateSample);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testParseRule();
+	void testParseRuleInvalid();
+	void testPassThrough();
+	void testMean();
+	void testFunctions();
+	void testMixedModules();
+	void testInvalidValues();
+	void testSkippedWindows();
+	void testSingleSample();
+	void testReleaseAll();
+	void testFirstRuleApplies();
+	void testGrace();
+	void testLateSample();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AggregationFilterTest);
+
+static const DeviceID OTHER_DEVICE(0xa300000000000002);
+
+/**
+ * @brief Release data of TEST_DEVICE from the filter until the given second
+ * and return their values keyed by the second of their timestamp.
+ */
+static map<int, TestValues> release(AggregationFilter &filter, int second)
+{
+	vector<SensorData> released;
+	map<int, TestValues> result;
+
+	filter.release(released, Timestamp::fromEpochTime(TEST_EPOCH + second));
+
+	for (const auto &data : released) {
+		CPPUNIT_ASSERT(data.deviceID() == TEST_DEVICE);
+
+		const int at = data.timestamp().value().epochTime() - TEST_EPOCH;
+		result[at] = valuesOf(data);
+	}
+
+	return result;
+}
+
+void AggregationFilterTest::testParseRule()
+{
+	AggregationFilter::Rule rule;
+
+	rule = AggregationFilter::Rule::parse("*:*:mean:30s");
+	CPPUNIT_ASSERT_EQUAL(AggregationFilter::Rule::MATCH_ANY, rule.match);
+	CPPUNIT_ASSERT(rule.anyModule);
+	CPPUNIT_ASSERT_EQUAL(AggregationFilter::FUNCTION_MEAN, rule.function);
+	CPPUNIT_ASSERT_EQUAL(30, rule.window.totalSeconds());
+
+	rule = AggregationFilter::Rule::parse(" 0xa3 : 1 : max : 5 m ");
+	CPPUNIT_ASSERT_EQUAL(AggregationFilter::Rule::MATCH_PREFIX, rule.match);
+	CPPUNIT_ASSERT(rule.device.prefix() == TEST_DEVICE.prefix());
+	CPPUNIT_ASSERT(!rule.anyModule);
+	CPPUNIT_ASSERT_EQUAL(1, rule.module.value());
+	CPPUNIT_ASSERT_EQUAL(AggregationFilter::FUNCTION_MAX, rule.function);
+	CPPUNIT_ASSERT_EQUAL(300, rule.window.totalSeconds());
+
+	rule = AggregationFilter::Rule::parse("0xa300000000000001:*:last:1h");
+	CPPUNIT_ASSERT_EQUAL(AggregationFilter::Rule::MATCH_DEVICE, rule.match);
+	CPPUNIT_ASSERT(rule.device == TEST_DEVICE);
+	CPPUNIT_ASSERT_EQUAL(AggregationFilter::FUNCTION_LAST, rule.function);
+	CPPUNIT_ASSERT_EQUAL(3600, rule.window.totalSeconds());
+
+	CPPUNIT_ASSERT(rule.matches(TEST_DEVICE, ModuleID(5)));
+	CPPUNIT_ASSERT(!rule.matches(OTHER_DEVICE, ModuleID(5)));
+}
+
+void AggregationFilterTest::testParseRuleInvalid()
+{
+	CPPUNIT_ASSERT_THROW(AggregationFilter::Rule::parse(""), SyntaxException);
+	CPPUNIT_ASSERT_THROW(AggregationFilter::Rule::parse("*:*:mean"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(AggregationFilter::Rule::parse("*:*:median:1m"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(AggregationFilter::Rule::parse("*:*:mean:0s"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(AggregationFilter::Rule::parse("*:*:mean:1d"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(AggregationFilter::Rule::parse("*:*:mean:m"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(AggregationFilter::Rule::parse("*:x:mean:1m"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(AggregationFilter::Rule::parse("0xzz:*:mean:1m"), SyntaxException);
+
+	AggregationFilter filter;
+	CPPUNIT_ASSERT_THROW(filter.setRules({"*:*:mean:1m", "*:*"}), SyntaxException);
+}
+
+/**
+ * @brief Without rules or without a matching rule, the data pass
+ * through unchanged.
+ */
+void AggregationFilterTest::testPassThrough()
+{
+	AggregationFilter filter;
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}})) == (TestValues{{0, 1}}));
+
+	filter.setRules({"0xa300000000000002:*:mean:10s", "*:3:mean:10s"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}, {1, 2}}))
+		== (TestValues{{0, 1}, {1, 2}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 1}, {1, 2}}))
+		== (TestValues{{0, 1}, {1, 2}}));
+	CPPUNIT_ASSERT_EQUAL(2, filter.size());
+}
+
+/**
+ * @brief Samples of a window are dropped, the mean of the window is
+ * released when the window is over, stamped with the window start.
+ */
+void AggregationFilterTest::testMean()
+{
+	AggregationFilter filter;
+	filter.setRules({"*:*:mean:10s"});
+
+	for (int i = 0; i < 10; ++i)
+		CPPUNIT_ASSERT(applyFilter(filter, makeData(i, {{0, double(i + 1)}})) == DROPPED);
+
+	CPPUNIT_ASSERT(release(filter, 9).empty());
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(10, {{0, 100}})) == DROPPED);
+	CPPUNIT_ASSERT(release(filter, 10)
+		== (map<int, TestValues>{{0, {{0, 5.5}}}}));
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(15, {{0, 200}})) == DROPPED);
+	CPPUNIT_ASSERT(release(filter, 19).empty());
+	CPPUNIT_ASSERT(release(filter, 20)
+		== (map<int, TestValues>{{10, {{0, 150}}}}));
+	CPPUNIT_ASSERT(release(filter, 100).empty());
+}
+
+/**
+ * @brief Results of windows closed at once are released together.
+ */
+void AggregationFilterTest::testFunctions()
+{
+	AggregationFilter filter;
+	filter.setRules({
+		"*:0:min:1m",
+		"*:1:max:1m",
+		"*:2:last:1m",
+		"*:3:mean:1m",
+	});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 5}, {1, 5}, {2, 5}, {3, 5}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(20, {{0, -3}, {1, 8}, {2, 1}, {3, 1}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(40, {{0, 2}, {1, 7}, {2, 4}, {3, 3}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(60, {{0, 0}, {1, 0}, {2, 0}, {3, 0}})) == DROPPED);
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(1, filter.release(released, Timestamp::fromEpochTime(TEST_EPOCH + 60)));
+	CPPUNIT_ASSERT(released[0].timestamp().value() == Timestamp::fromEpochTime(TEST_EPOCH));
+
+	CPPUNIT_ASSERT(valuesOf(released[0]) == (TestValues{{0, -3}, {1, 8}, {2, 4}, {3, 3}}));
+}
+
+/**
+ * @brief Modules without a rule are exported immediately while
+ * the others are aggregated.
+ */
+void AggregationFilterTest::testMixedModules()
+{
+	AggregationFilter filter;
+	filter.setRules({"0xa3:1:max:10s"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}, {1, 10}, {2, 100}}))
+		== (TestValues{{0, 1}, {2, 100}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(5, {{0, 2}, {1, 20}, {2, 200}}))
+		== (TestValues{{0, 2}, {2, 200}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(10, {{0, 3}, {1, 5}, {2, 300}}))
+		== (TestValues{{0, 3}, {2, 300}}));
+
+	CPPUNIT_ASSERT(release(filter, 10)
+		== (map<int, TestValues>{{0, {{1, 20}}}}));
+}
+
+/**
+ * @brief Invalid values pass through and do not affect the window.
+ */
+void AggregationFilterTest::testInvalidValues()
+{
+	AggregationFilter filter;
+	filter.setRules({"*:*:mean:10s"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 2}})) == DROPPED);
+
+	SensorData invalid = makeData(1, {});
+	invalid.insertValue(SensorValue(ModuleID(0)));
+	CPPUNIT_ASSERT(filter.filter(invalid));
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(2, {{0, NAN}})) != DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(3, {{0, 4}})) == DROPPED);
+
+	CPPUNIT_ASSERT(release(filter, 10)
+		== (map<int, TestValues>{{0, {{0, 3}}}}));
+}
+
+/**
+ * @brief When a module does not report for several windows, its last
+ * window is released on time and nothing is released for the windows
+ * without samples.
+ */
+void AggregationFilterTest::testSkippedWindows()
+{
+	AggregationFilter filter;
+	filter.setRules({"*:*:last:10s"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(9, {{0, 2}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(95, {{0, 3}})) == DROPPED);
+	CPPUNIT_ASSERT(release(filter, 95)
+		== (map<int, TestValues>{{0, {{0, 2}}}}));
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(99, {{0, 4}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(100, {{0, 5}})) == DROPPED);
+	CPPUNIT_ASSERT(release(filter, 100)
+		== (map<int, TestValues>{{90, {{0, 4}}}}));
+}
+
+/**
+ * @brief A window with a single sample releases the sample
+ * with its own timestamp.
+ */
+void AggregationFilterTest::testSingleSample()
+{
+	AggregationFilter filter;
+	filter.setRules({"*:*:mean:1m"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(7, {{0, 42}})) == DROPPED);
+	CPPUNIT_ASSERT(release(filter, 59).empty());
+	CPPUNIT_ASSERT(release(filter, 60)
+		== (map<int, TestValues>{{7, {{0, 42}}}}));
+}
+
+/**
+ * @brief Windows that are not over yet are released on demand
+ * (e.g. when the gateway is stopping).
+ */
+void AggregationFilterTest::testReleaseAll()
+{
+	AggregationFilter filter;
+	filter.setRules({"*:*:max:1h"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}, {1, 5}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 3}})) == DROPPED);
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(0, filter.release(released, Timestamp::fromEpochTime(TEST_EPOCH + 60)));
+	CPPUNIT_ASSERT_EQUAL(1, filter.release(released, Timestamp(Timestamp::TIMEVAL_MAX)));
+
+	TestValues values;
+	for (const auto &data : released) {
+		CPPUNIT_ASSERT(data.timestamp().value() == Timestamp::fromEpochTime(TEST_EPOCH));
+
+		for (const auto &item : data)
+			values.emplace(item.moduleID().value(), item.value());
+	}
+
+	CPPUNIT_ASSERT(values == (TestValues{{0, 3}, {1, 5}}));
+	CPPUNIT_ASSERT_EQUAL(0, filter.release(released, Timestamp(Timestamp::TIMEVAL_MAX)));
+}
+
+/**
+ * @brief Rules are tried in the given order and each device has its
+ * own windows.
+ */
+void AggregationFilterTest::testFirstRuleApplies()
+{
+	AggregationFilter filter;
+	filter.setRules({"0xa300000000000002:*:max:10s", "0xa3:*:min:10s"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}}, OTHER_DEVICE)) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 9}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 9}}, OTHER_DEVICE)) == DROPPED);
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(2, filter.release(released, Timestamp::fromEpochTime(TEST_EPOCH + 10)));
+
+	map<DeviceID, double> values;
+	for (const auto &data : released) {
+		for (const auto &item : data)
+			values.emplace(data.deviceID(), item.value());
+	}
+
+	CPPUNIT_ASSERT(values == (map<DeviceID, double>{{TEST_DEVICE, 1}, {OTHER_DEVICE, 9}}));
+}
+
+/**
+ * @brief A window without later samples is released only when its
+ * grace period is over. Delayed samples arriving during the grace
+ * period are still aggregated.
+ */
+void AggregationFilterTest::testGrace()
+{
+	AggregationFilter filter;
+	filter.setRules({"*:*:max:10s"});
+	filter.setGrace(5 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(2, {{0, 1}})) == DROPPED);
+	CPPUNIT_ASSERT(release(filter, 10).empty());
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(8, {{0, 7}})) == DROPPED);
+	CPPUNIT_ASSERT(release(filter, 14).empty());
+	CPPUNIT_ASSERT(release(filter, 15)
+		== (map<int, TestValues>{{0, {{0, 7}}}}));
+}
+
+/**
+ * @brief Samples of released windows and samples preceding the window
+ * being collected pass through unaggregated.
+ */
+void AggregationFilterTest::testLateSample()
+{
+	AggregationFilter filter;
+	filter.setRules({"*:*:mean:10s"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(5, {{0, 3}})) == DROPPED);
+	CPPUNIT_ASSERT(release(filter, 10)
+		== (map<int, TestValues>{{0, {{0, 2}}}}));
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(9, {{0, 10}}))
+		== (TestValues{{0, 10}}));
+	CPPUNIT_ASSERT(release(filter, 100).empty());
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(25, {{0, 4}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(15, {{0, 5}}))
+		== (TestValues{{0, 5}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(27, {{0, 6}})) == DROPPED);
+
+	CPPUNIT_ASSERT(release(filter, 30)
+		== (map<int, TestValues>{{20, {{0, 5}}}}));
+}
+
+}
@@ -10,6 +10,7 @@
 #include "core/AnswerQueue.h"
 #include "core/CommandHandler.h"
 #include "core/AsyncCommandDispatcher.h"
+#include "util/AllocationTracker.h"
 #include "util/ParallelExecutor.h"
 
 using namespace Poco;
@@ -27,6 +28,7 @@ class AnswerQueueTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testSetResultAfterLock);
 	CPPUNIT_TEST(testCreateAnswerAfterLock);
 	CPPUNIT_TEST(testDisposeUnusedAnswer);
+	CPPUNIT_TEST(testBoundedMemory);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -42,6 +44,7 @@ public:
 	void testSetResultAfterLock();
 	void testCreateAnswerAfterLock();
 	void testDisposeUnusedAnswer();
+	void testBoundedMemory();
 
 private:
 	ParallelExecutor::Ptr m_executor;
@@ -471,4 +474,40 @@ void AnswerQueueTest::testDisposeUnusedAnswer()
 
 }
 
+/**
+ * @brief Creating and removing answers in a loop does not grow
+ * the heap attributed to the AnswerQueue. The test is effective
+ * only when the suite is built with ENABLE_ALLOC_TRACKING.
+ */
+void AnswerQueueTest::testBoundedMemory()
+{
+	AnswerQueue queue;
+
+	auto cycle = [&](unsigned int count) {
+		for (unsigned int i = 0; i < count; ++i) {
+			Answer::Ptr answer = queue.newAnswer();
+			answer->setDirty(true);
+			queue.remove(answer);
+		}
+	};
+
+	// warm up
+	cycle(100);
+	const AllocationSnapshot &before = AllocationTracker::snapshot();
+
+	cycle(10000);
+	const AllocationSnapshot &after = AllocationTracker::snapshot();
+
+	CPPUNIT_ASSERT_EQUAL(0, queue.size());
+
+	if (!AllocationTracker::enabled())
+		return;
+
+	CPPUNIT_ASSERT(after.stats("answers").allocations
+		> before.stats("answers").allocations);
+	CPPUNIT_ASSERT_EQUAL(
+		before.stats("answers").liveBytes(),
+		after.stats("answers").liveBytes());
+}
+
 }
@@ -0,0 +1,150 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Clock.h>
+#include <Poco/Event.h>
+#include <Poco/Exception.h>
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "core/AsyncWorkReactor.h"
+#include "util/ParallelExecutor.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class AsyncWorkReactorTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(AsyncWorkReactorTest);
+	CPPUNIT_TEST(testSchedule);
+	CPPUNIT_TEST(testCancelScheduled);
+	CPPUNIT_TEST(testDeadlineExpires);
+	CPPUNIT_TEST(testDeadlineCompleted);
+	CPPUNIT_TEST(testExecute);
+	CPPUNIT_TEST(testExecuteWithoutExecutor);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() override;
+	void tearDown() override;
+
+	void testSchedule();
+	void testCancelScheduled();
+	void testDeadlineExpires();
+	void testDeadlineCompleted();
+	void testExecute();
+	void testExecuteWithoutExecutor();
+
+private:
+	AsyncWorkReactor::Ptr m_reactor;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AsyncWorkReactorTest);
+
+void AsyncWorkReactorTest::setUp()
+{
+	m_reactor = new AsyncWorkReactor;
+}
+
+void AsyncWorkReactorTest::tearDown()
+{
+	m_reactor->cleanup();
+	m_reactor = nullptr;
+}
+
+void AsyncWorkReactorTest::testSchedule()
+{
+	Event done;
+	const Clock started;
+	Timespan elapsed;
+
+	m_reactor->schedule(50 * Timespan::MILLISECONDS, [&]() {
+		elapsed = started.elapsed();
+		done.set();
+	});
+
+	CPPUNIT_ASSERT(done.tryWait(1000));
+	CPPUNIT_ASSERT(elapsed >= 50 * Timespan::MILLISECONDS);
+}
+
+void AsyncWorkReactorTest::testCancelScheduled()
+{
+	AtomicCounter called;
+
+	LambdaTimerTask::Ptr task = m_reactor->schedule(
+		100 * Timespan::MILLISECONDS, [&]() {
+			++called;
+		});
+
+	task->cancel();
+	Thread::sleep(200);
+
+	CPPUNIT_ASSERT_EQUAL(0, called.value());
+}
+
+/**
+ * Work not finished until its deadline is cancelled by the reactor.
+ */
+void AsyncWorkReactorTest::testDeadlineExpires()
+{
+	ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+	const Clock started;
+
+	m_reactor->deadline<int>(work, 50 * Timespan::MILLISECONDS);
+
+	CPPUNIT_ASSERT(work->tryJoin(1 * Timespan::SECONDS));
+	CPPUNIT_ASSERT(started.elapsed() >= 50 * Timespan::MILLISECONDS);
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::CANCELLED, work->state());
+}
+
+/**
+ * Completing the work in time disarms its deadline.
+ */
+void AsyncWorkReactorTest::testDeadlineCompleted()
+{
+	ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+
+	m_reactor->deadline<int>(work, 100 * Timespan::MILLISECONDS);
+	CPPUNIT_ASSERT(work->complete(5));
+
+	Thread::sleep(200);
+
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::SUCCEEDED, work->state());
+	CPPUNIT_ASSERT_EQUAL(5, work->result().value());
+}
+
+/**
+ * A blocking task passed to execute() does not delay tasks
+ * scheduled in the reactor.
+ */
+void AsyncWorkReactorTest::testExecute()
+{
+	m_reactor->setExecutor(new ParallelExecutor);
+
+	Event release;
+	Event blocked;
+	Event scheduled;
+
+	m_reactor->execute([&]() {
+		blocked.set();
+		release.wait();
+	});
+
+	CPPUNIT_ASSERT(blocked.tryWait(1000));
+
+	m_reactor->invoke([&]() {
+		scheduled.set();
+	});
+
+	CPPUNIT_ASSERT(scheduled.tryWait(1000));
+	release.set();
+}
+
+void AsyncWorkReactorTest::testExecuteWithoutExecutor()
+{
+	CPPUNIT_ASSERT_THROW(
+		m_reactor->execute([]() {}),
+		IllegalStateException);
+}
+
+}
@@ -0,0 +1,273 @@
+#include <cmath>
+#include <list>
+#include <map>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+#include <Poco/Timestamp.h>
+
+#include "cppunit/BetterAssert.h"
+#include "cppunit/FileTestFixture.h"
+
+#include "commands/DeviceUnpairCommand.h"
+#include "commands/NewDeviceCommand.h"
+#include "core/DeadbandFilter.h"
+#include "core/SensorDataTesting.h"
+#include "model/ModuleType.h"
+#include "model/SensorData.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class DeadbandFilterTest : public FileTestFixture {
+	CPPUNIT_TEST_SUITE(DeadbandFilterTest);
+	CPPUNIT_TEST(testParseRule);
+	CPPUNIT_TEST(testParseRuleInvalid);
+	CPPUNIT_TEST(testDefaultPass);
+	CPPUNIT_TEST(testChangeOnly);
+	CPPUNIT_TEST(testDeadbandByType);
+	CPPUNIT_TEST(testHeartbeat);
+	CPPUNIT_TEST(testInvalidValues);
+	CPPUNIT_TEST(testLearnFromNewDevice);
+	CPPUNIT_TEST(testTypesOfNotAnnounced);
+	CPPUNIT_TEST(testForgetUnpaired);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testParseRule();
+	void testParseRuleInvalid();
+	void testDefaultPass();
+	void testChangeOnly();
+	void testDeadbandByType();
+	void testHeartbeat();
+	void testInvalidValues();
+	void testLearnFromNewDevice();
+	void testTypesOfNotAnnounced();
+	void testForgetUnpaired();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DeadbandFilterTest);
+
+static const DeviceID OTHER_DEVICE(0xa300000000000002);
+
+void DeadbandFilterTest::testParseRule()
+{
+	DeadbandFilter::Rule rule;
+
+	rule = DeadbandFilter::Rule::parse("pass");
+	CPPUNIT_ASSERT(rule.pass);
+
+	rule = DeadbandFilter::Rule::parse(" change ");
+	CPPUNIT_ASSERT(!rule.pass);
+	CPPUNIT_ASSERT_EQUAL(0.0, rule.absolute);
+	CPPUNIT_ASSERT_EQUAL(0.0, rule.relative);
+
+	rule = DeadbandFilter::Rule::parse("0.5");
+	CPPUNIT_ASSERT(!rule.pass);
+	CPPUNIT_ASSERT_EQUAL(0.5, rule.absolute);
+	CPPUNIT_ASSERT_EQUAL(0.0, rule.relative);
+
+	rule = DeadbandFilter::Rule::parse("2%");
+	CPPUNIT_ASSERT_EQUAL(0.0, rule.absolute);
+	CPPUNIT_ASSERT_EQUAL(0.02, rule.relative);
+
+	rule = DeadbandFilter::Rule::parse("1/5%");
+	CPPUNIT_ASSERT_EQUAL(1.0, rule.absolute);
+	CPPUNIT_ASSERT_EQUAL(0.05, rule.relative);
+}
+
+void DeadbandFilterTest::testParseRuleInvalid()
+{
+	CPPUNIT_ASSERT_THROW(DeadbandFilter::Rule::parse(""), SyntaxException);
+	CPPUNIT_ASSERT_THROW(DeadbandFilter::Rule::parse("abc"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(DeadbandFilter::Rule::parse("1/5"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(DeadbandFilter::Rule::parse("-1"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(DeadbandFilter::Rule::parse("x%"), SyntaxException);
+
+	DeadbandFilter filter;
+	CPPUNIT_ASSERT_THROW(filter.setRules({"temperature"}), SyntaxException);
+}
+
+/**
+ * @brief Without rules, nothing is filtered.
+ */
+void DeadbandFilterTest::testDefaultPass()
+{
+	DeadbandFilter filter;
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}})) == (TestValues{{0, 1}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 1}})) == (TestValues{{0, 1}}));
+	CPPUNIT_ASSERT_EQUAL(1, filter.size());
+}
+
+/**
+ * @brief Repeated values are dropped, data with some repeated values
+ * are reduced to the changed ones only.
+ */
+void DeadbandFilterTest::testChangeOnly()
+{
+	DeadbandFilter filter;
+	filter.setRules({"default:change"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}, {1, 10}}))
+		== (TestValues{{0, 1}, {1, 10}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 1}, {1, 10}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(2, {{0, 1}, {1, 11}}))
+		== (TestValues{{1, 11}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(3, {{0, 2}, {1, 11}}))
+		== (TestValues{{0, 2}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(4, {{0, 2}, {1, 11}, {2, 0}}))
+		== (TestValues{{2, 0}}));
+	CPPUNIT_ASSERT_EQUAL(3, filter.size());
+}
+
+/**
+ * @brief The deadband is given by the type of module and is measured
+ * against the last exported value, thus a slow drift is exported
+ * eventually.
+ */
+void DeadbandFilterTest::testDeadbandByType()
+{
+	DeadbandFilter filter;
+	filter.setRules({"temperature:0.5", "humidity:10%", "default:pass"});
+	filter.learnTypes(TEST_DEVICE, {"temperature", "humidity", "motion"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 20}, {1, 50}, {2, 1}}))
+		== (TestValues{{0, 20}, {1, 50}, {2, 1}}));
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 20.3}, {1, 54}, {2, 1}}))
+		== (TestValues{{2, 1}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(2, {{0, 20.5}, {1, 45}}))
+		== DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(3, {{0, 20.6}, {1, 44}}))
+		== (TestValues{{0, 20.6}, {1, 44}}));
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(4, {{0, 20.2}, {1, 40}}))
+		== DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(5, {{0, 20.0}, {1, 39}}))
+		== (TestValues{{0, 20.0}, {1, 39}}));
+}
+
+/**
+ * @brief A value is exported when the heartbeat has elapsed since
+ * the last exported value regardless of the deadband.
+ */
+void DeadbandFilterTest::testHeartbeat()
+{
+	DeadbandFilter filter;
+	filter.setRules({"default:change"});
+	filter.setHeartbeat(60 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}})) != DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(30, {{0, 1}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(59, {{0, 1}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(60, {{0, 1}})) != DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(61, {{0, 1}})) == DROPPED);
+
+	filter.setHeartbeat(-1);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1000, {{0, 1}})) == DROPPED);
+}
+
+/**
+ * @brief Invalid values are always exported and the next valid value
+ * is exported as well.
+ */
+void DeadbandFilterTest::testInvalidValues()
+{
+	DeadbandFilter filter;
+	filter.setRules({"default:change"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 1}})) != DROPPED);
+
+	SensorData invalid = makeData(1, {});
+	invalid.insertValue(SensorValue(ModuleID(0)));
+	CPPUNIT_ASSERT(filter.filter(invalid));
+	CPPUNIT_ASSERT(filter.filter(invalid));
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(2, {{0, NAN}})) != DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(3, {{0, 1}})) != DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(4, {{0, 1}})) == DROPPED);
+}
+
+/**
+ * @brief Types of modules are learned from dispatched NewDeviceCommands
+ * even for modules that have already been seen.
+ */
+void DeadbandFilterTest::testLearnFromNewDevice()
+{
+	DeadbandFilter filter;
+	filter.setRules({"temperature:1", "default:pass"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 20}})) != DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 20.5}})) != DROPPED);
+
+	filter.onDispatch(new NewDeviceCommand(TEST_DEVICE, "vendor", "product",
+		{ModuleType(ModuleType::Type::TYPE_TEMPERATURE)}));
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(2, {{0, 21}})) == DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(3, {{0, 21.6}})) != DROPPED);
+
+	CPPUNIT_ASSERT_EQUAL("temperature", filter.typeOf(TEST_DEVICE, ModuleID(0)));
+	CPPUNIT_ASSERT_EQUAL("", filter.typeOf(TEST_DEVICE, ModuleID(1)));
+	CPPUNIT_ASSERT_EQUAL("", filter.typeOf(OTHER_DEVICE, ModuleID(0)));
+}
+
+/**
+ * @brief Devices paired before restart are never announced again.
+ * Their types are loaded from the types file, devices of unknown
+ * types follow the default rule.
+ */
+void DeadbandFilterTest::testTypesOfNotAnnounced()
+{
+	DeadbandFilter learning;
+	learning.setTypesFile(testingPath().toString());
+	learning.onDispatch(new NewDeviceCommand(TEST_DEVICE, "vendor", "product",
+		{ModuleType(ModuleType::Type::TYPE_TEMPERATURE)}));
+
+	DeadbandFilter filter;
+	filter.setRules({"temperature:1", "default:pass"});
+	filter.setTypesFile(testingPath().toString());
+
+	CPPUNIT_ASSERT_EQUAL(1, filter.knownDevices());
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 20}})) != DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 20.5}})) == DROPPED);
+
+	SensorData other = makeData(0, {{0, 20}});
+	other.setDeviceID(OTHER_DEVICE);
+	CPPUNIT_ASSERT(filter.filter(other));
+	other.setTimestamp(Timestamp::fromEpochTime(TEST_EPOCH + 1));
+	CPPUNIT_ASSERT(filter.filter(other));
+}
+
+/**
+ * @brief Unpaired devices are forgotten, thus the filter does not
+ * grow with devices that have come and gone.
+ */
+void DeadbandFilterTest::testForgetUnpaired()
+{
+	DeadbandFilter filter;
+	filter.setRules({"temperature:1", "default:pass"});
+	filter.setTypesFile(testingPath().toString());
+	filter.learnTypes(TEST_DEVICE, {"temperature"});
+
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(0, {{0, 20}})) != DROPPED);
+	CPPUNIT_ASSERT_EQUAL(1, filter.size());
+	CPPUNIT_ASSERT_EQUAL(1, filter.knownDevices());
+
+	filter.onDispatch(new DeviceUnpairCommand(TEST_DEVICE));
+
+	CPPUNIT_ASSERT_EQUAL(0, filter.size());
+	CPPUNIT_ASSERT_EQUAL(0, filter.knownDevices());
+
+	DeadbandFilter reloaded;
+	reloaded.setTypesFile(testingPath().toString());
+	CPPUNIT_ASSERT_EQUAL(0, reloaded.knownDevices());
+
+	// the module is of unknown type now
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(1, {{0, 20}})) != DROPPED);
+	CPPUNIT_ASSERT(applyFilter(filter, makeData(2, {{0, 20.5}})) != DROPPED);
+}
+
+}
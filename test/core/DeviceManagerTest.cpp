@@ -0,0 +1,322 @@
+#include <set>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Event.h>
+#include <Poco/Exception.h>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "commands/DeviceSetValueCommand.h"
+#include "commands/DeviceUnpairCommand.h"
+#include "commands/DeviceUnpairResult.h"
+#include "core/AnswerQueue.h"
+#include "core/DeviceManager.h"
+#include "core/Distributor.h"
+#include "model/SensorData.h"
+#include "util/ContinuationAsyncWork.h"
+#include "util/ParallelExecutor.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class TestingDistributor : public Distributor {
+public:
+	void exportData(const SensorData &data) override
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		m_data.emplace_back(data);
+	}
+
+	size_t count()
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		return m_data.size();
+	}
+
+private:
+	FastMutex m_lock;
+	vector<SensorData> m_data;
+};
+
+/**
+ * Device manager starting unpair and set-value as ContinuationAsyncWork
+ * that are finished explicitly by the test.
+ */
+class DeferredDeviceManager : public DeviceManager {
+public:
+	DeferredDeviceManager():
+		DeviceManager(DevicePrefix::PREFIX_VIRTUAL_DEVICE, {
+			typeid(DeviceSetValueCommand),
+			typeid(DeviceUnpairCommand),
+		})
+	{
+	}
+
+	void run() override
+	{
+	}
+
+	ContinuationAsyncWork<double>::Ptr setValue(size_t i)
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		return m_setValue.at(i);
+	}
+
+	size_t setValueCount()
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		return m_setValue.size();
+	}
+
+	ContinuationAsyncWork<set<DeviceID>>::Ptr unpair()
+	{
+		FastMutex::ScopedLock guard(m_lock);
+		return m_unpair;
+	}
+
+	Event &started()
+	{
+		return m_started;
+	}
+
+protected:
+	AsyncWork<set<DeviceID>>::Ptr startUnpair(
+			const DeviceID &,
+			const Timespan &) override
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		m_unpair = new ContinuationAsyncWork<set<DeviceID>>;
+		m_started.set();
+		return m_unpair;
+	}
+
+	AsyncWork<double>::Ptr startSetValue(
+			const DeviceID &,
+			const ModuleID &,
+			const double,
+			const Timespan &) override
+	{
+		FastMutex::ScopedLock guard(m_lock);
+
+		m_setValue.emplace_back(new ContinuationAsyncWork<double>);
+		m_started.set();
+		return m_setValue.back();
+	}
+
+private:
+	FastMutex m_lock;
+	vector<ContinuationAsyncWork<double>::Ptr> m_setValue;
+	ContinuationAsyncWork<set<DeviceID>>::Ptr m_unpair;
+	Event m_started;
+};
+
+class DeviceManagerTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(DeviceManagerTest);
+	CPPUNIT_TEST(testDeferredSetValueCompleted);
+	CPPUNIT_TEST(testDeferredSetValueFailed);
+	CPPUNIT_TEST(testDeferredSetValueDeadline);
+	CPPUNIT_TEST(testDeferredSetValueCancelled);
+	CPPUNIT_TEST(testDeferredSetValueSerialized);
+	CPPUNIT_TEST(testDeferredUnpairCompleted);
+	CPPUNIT_TEST(testDeferredUnpairDeadline);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() override;
+	void tearDown() override;
+
+	void testDeferredSetValueCompleted();
+	void testDeferredSetValueFailed();
+	void testDeferredSetValueDeadline();
+	void testDeferredSetValueCancelled();
+	void testDeferredSetValueSerialized();
+	void testDeferredUnpairCompleted();
+	void testDeferredUnpairDeadline();
+
+private:
+	Answer::Ptr setValue();
+	Answer::Ptr unpair();
+
+	AnswerQueue m_queue;
+	AsyncWorkReactor::Ptr m_reactor;
+	SharedPtr<TestingDistributor> m_distributor;
+	SharedPtr<DeferredDeviceManager> m_manager;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DeviceManagerTest);
+
+static const DeviceID DEVICE_ID(DevicePrefix::PREFIX_VIRTUAL_DEVICE, 0x42);
+
+void DeviceManagerTest::setUp()
+{
+	m_reactor = new AsyncWorkReactor;
+	m_reactor->setExecutor(new ParallelExecutor);
+	m_distributor = new TestingDistributor;
+
+	m_manager = new DeferredDeviceManager;
+	m_manager->setDistributor(m_distributor);
+	m_manager->setWorkReactor(m_reactor);
+}
+
+void DeviceManagerTest::tearDown()
+{
+	m_manager->stop();
+	m_reactor->cleanup();
+}
+
+Answer::Ptr DeviceManagerTest::setValue()
+{
+	Answer::Ptr answer = new Answer(m_queue);
+
+	m_manager->handle(new DeviceSetValueCommand(
+		DEVICE_ID, ModuleID(0), 1, 1 * Timespan::SECONDS), answer);
+
+	return answer;
+}
+
+Answer::Ptr DeviceManagerTest::unpair()
+{
+	Answer::Ptr answer = new Answer(m_queue);
+
+	m_manager->handle(new DeviceUnpairCommand(
+		DEVICE_ID, 1 * Timespan::SECONDS), answer);
+
+	return answer;
+}
+
+/**
+ * The handle() returns before the set-value finishes. The result
+ * is completed and the value shipped when the work completes.
+ */
+void DeviceManagerTest::testDeferredSetValueCompleted()
+{
+	Answer::Ptr answer = setValue();
+
+	CPPUNIT_ASSERT_EQUAL(1, m_manager->setValueCount());
+	CPPUNIT_ASSERT(answer->isPending());
+
+	m_manager->setValue(0)->complete(1);
+	answer->waitNotPending(1 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT(answer->at(0)->status() == Result::Status::SUCCESS);
+	CPPUNIT_ASSERT_EQUAL(1, m_distributor->count());
+}
+
+void DeviceManagerTest::testDeferredSetValueFailed()
+{
+	Answer::Ptr answer = setValue();
+
+	m_manager->setValue(0)->fail(IOException("transmission failed"));
+	answer->waitNotPending(1 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT(answer->at(0)->status() == Result::Status::FAILED);
+	CPPUNIT_ASSERT_EQUAL(0, m_distributor->count());
+}
+
+/**
+ * The set-value not finished in the timeout of the command
+ * is cancelled and its result fails.
+ */
+void DeviceManagerTest::testDeferredSetValueDeadline()
+{
+	Answer::Ptr answer = setValue();
+
+	answer->waitNotPending(3 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT_EQUAL(
+		ContinuationAsyncWork<double>::CANCELLED,
+		m_manager->setValue(0)->state());
+	CPPUNIT_ASSERT(answer->at(0)->status() == Result::Status::FAILED);
+	CPPUNIT_ASSERT_EQUAL(0, m_distributor->count());
+}
+
+/**
+ * Stopping the manager cancels the deferred set-value.
+ */
+void DeviceManagerTest::testDeferredSetValueCancelled()
+{
+	Answer::Ptr answer = setValue();
+
+	m_manager->stop();
+	answer->waitNotPending(1 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT_EQUAL(
+		ContinuationAsyncWork<double>::CANCELLED,
+		m_manager->setValue(0)->state());
+	CPPUNIT_ASSERT(answer->at(0)->status() == Result::Status::FAILED);
+}
+
+/**
+ * A set-value is not started until the previous deferred
+ * set-value finishes.
+ */
+void DeviceManagerTest::testDeferredSetValueSerialized()
+{
+	Answer::Ptr first = setValue();
+	CPPUNIT_ASSERT(m_manager->started().tryWait(1000));
+
+	Answer::Ptr second;
+	Thread thread;
+
+	thread.startFunc([&]() {
+		second = setValue();
+	});
+
+	CPPUNIT_ASSERT(!m_manager->started().tryWait(200));
+	CPPUNIT_ASSERT_EQUAL(1, m_manager->setValueCount());
+
+	m_manager->setValue(0)->complete(1);
+
+	CPPUNIT_ASSERT(m_manager->started().tryWait(1000));
+	thread.join();
+
+	CPPUNIT_ASSERT_EQUAL(2, m_manager->setValueCount());
+
+	m_manager->setValue(1)->complete(1);
+	first->waitNotPending(1 * Timespan::SECONDS);
+	second->waitNotPending(1 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT(first->at(0)->status() == Result::Status::SUCCESS);
+	CPPUNIT_ASSERT(second->at(0)->status() == Result::Status::SUCCESS);
+}
+
+void DeviceManagerTest::testDeferredUnpairCompleted()
+{
+	Answer::Ptr answer = unpair();
+
+	CPPUNIT_ASSERT(answer->isPending());
+
+	m_manager->unpair()->complete({DEVICE_ID});
+	answer->waitNotPending(1 * Timespan::SECONDS);
+
+	Result::Ptr result = answer->at(0);
+	CPPUNIT_ASSERT(result->status() == Result::Status::SUCCESS);
+	CPPUNIT_ASSERT_EQUAL(1, result.cast<DeviceUnpairResult>()->unpaired().size());
+	CPPUNIT_ASSERT(result.cast<DeviceUnpairResult>()->unpaired().count(DEVICE_ID) == 1);
+}
+
+/**
+ * The unpair not finished in time is cancelled and, as in case
+ * of the blocking unpair, no device is reported as unpaired.
+ */
+void DeviceManagerTest::testDeferredUnpairDeadline()
+{
+	Answer::Ptr answer = unpair();
+
+	answer->waitNotPending(3 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT_EQUAL(
+		ContinuationAsyncWork<set<DeviceID>>::CANCELLED,
+		m_manager->unpair()->state());
+
+	Result::Ptr result = answer->at(0);
+	CPPUNIT_ASSERT(result->status() == Result::Status::SUCCESS);
+	CPPUNIT_ASSERT(result.cast<DeviceUnpairResult>()->unpaired().empty());
+}
+
+}
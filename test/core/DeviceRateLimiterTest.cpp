@@ -0,0 +1,321 @@
+#include <map>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/Timestamp.h>
+
+#include "cppunit/BetterAssert.h"
+
+#include "core/DeviceRateLimiter.h"
+#include "core/ModuleTypeResolver.h"
+#include "core/SensorDataTesting.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class DeviceRateLimiterTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(DeviceRateLimiterTest);
+	CPPUNIT_TEST(testDisabled);
+	CPPUNIT_TEST(testBurst);
+	CPPUNIT_TEST(testCoalesce);
+	CPPUNIT_TEST(testExemptTypes);
+	CPPUNIT_TEST(testExemptSameTimestamp);
+	CPPUNIT_TEST(testFlush);
+	CPPUNIT_TEST(testIsolation);
+	CPPUNIT_TEST(testRoundRobin);
+	CPPUNIT_TEST(testReport);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testDisabled();
+	void testBurst();
+	void testCoalesce();
+	void testExemptTypes();
+	void testExemptSameTimestamp();
+	void testFlush();
+	void testIsolation();
+	void testRoundRobin();
+	void testReport();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DeviceRateLimiterTest);
+
+static const DeviceID CHATTY(0xa300000000000001);
+static const DeviceID QUIET1(0xa300000000000002);
+static const DeviceID QUIET2(0xa300000000000003);
+
+class TestingModuleTypes : public ModuleTypeResolver {
+public:
+	string typeOf(const DeviceID &, const ModuleID &module) const override
+	{
+		return module.value() == 1 ? "motion" : "temperature";
+	}
+};
+
+static Clock at(int ms)
+{
+	return Clock(Clock::ClockVal(1000000000)) + ms * Timespan::MILLISECONDS;
+}
+
+void DeviceRateLimiterTest::testDisabled()
+{
+	DeviceRateLimiter limiter;
+	CPPUNIT_ASSERT(!limiter.enabled());
+
+	for (int i = 0; i < 100; ++i)
+		CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 1}}, CHATTY), at(0)));
+
+	CPPUNIT_ASSERT_EQUAL(0, limiter.deferred());
+	CPPUNIT_ASSERT(limiter.nextRelease(at(0)) < 0);
+}
+
+/**
+ * @brief The burst is admitted immediately, then a single data per
+ * interval is released.
+ */
+void DeviceRateLimiterTest::testBurst()
+{
+	DeviceRateLimiter limiter;
+	limiter.setInterval(1 * Timespan::SECONDS);
+	limiter.setBurst(3);
+	CPPUNIT_ASSERT(limiter.enabled());
+
+	CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 1}}, CHATTY), at(0)));
+	CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 2}}, CHATTY), at(0)));
+	CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 3}}, CHATTY), at(0)));
+	CPPUNIT_ASSERT(!limiter.admit(makeData(0, {{0, 4}}, CHATTY), at(0)));
+	CPPUNIT_ASSERT(!limiter.admit(makeData(0, {{0, 5}}, CHATTY), at(400)));
+	CPPUNIT_ASSERT_EQUAL(1, limiter.deferred());
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(0, limiter.release(released, at(500)));
+	CPPUNIT_ASSERT_EQUAL(500, limiter.nextRelease(at(500)).totalMilliseconds());
+
+	CPPUNIT_ASSERT_EQUAL(1, limiter.release(released, at(1000)));
+	CPPUNIT_ASSERT_EQUAL(1, released.size());
+	CPPUNIT_ASSERT(valuesOf(released[0]) == (TestValues{{0, 5}}));
+	CPPUNIT_ASSERT_EQUAL(0, limiter.deferred());
+
+	// the token has been consumed by the released data
+	CPPUNIT_ASSERT(!limiter.admit(makeData(0, {{0, 6}}, CHATTY), at(1500)));
+	CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 6}}, QUIET1), at(1500)));
+
+	// disabling releases everything
+	limiter.setInterval(0);
+	CPPUNIT_ASSERT_EQUAL(0, limiter.nextRelease(at(1500)).totalMicroseconds());
+	CPPUNIT_ASSERT_EQUAL(1, limiter.release(released, at(1500)));
+	CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 7}}, CHATTY), at(1500)));
+
+	CPPUNIT_ASSERT_THROW(limiter.setBurst(0), InvalidArgumentException);
+}
+
+/**
+ * @brief Newer values replace older values of the same module,
+ * values of other modules are kept with their own timestamps.
+ */
+void DeviceRateLimiterTest::testCoalesce()
+{
+	DeviceRateLimiter limiter;
+	limiter.setInterval(1 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 0}}, CHATTY), at(0)));
+	CPPUNIT_ASSERT(!limiter.admit(makeData(1, {{0, 1}, {1, 1}}, CHATTY), at(100)));
+	CPPUNIT_ASSERT(!limiter.admit(makeData(2, {{1, 2}, {2, 2}}, CHATTY), at(200)));
+	CPPUNIT_ASSERT(!limiter.admit(makeData(2, {{3, 2}}, CHATTY), at(300)));
+	CPPUNIT_ASSERT_EQUAL(1, limiter.deferred());
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(1, limiter.release(released, at(1000)));
+
+	CPPUNIT_ASSERT(CHATTY == released[0].deviceID());
+	CPPUNIT_ASSERT(Timestamp::fromEpochTime(TEST_EPOCH + 1) == released[0].timestamp().value());
+	CPPUNIT_ASSERT(valuesOf(released[0]) == (TestValues{{0, 1}}));
+	CPPUNIT_ASSERT_EQUAL(1, limiter.deferred());
+
+	CPPUNIT_ASSERT_EQUAL(0, limiter.release(released, at(1500)));
+	CPPUNIT_ASSERT_EQUAL(1, limiter.release(released, at(2000)));
+
+	CPPUNIT_ASSERT(Timestamp::fromEpochTime(TEST_EPOCH + 2) == released[1].timestamp().value());
+	CPPUNIT_ASSERT(valuesOf(released[1]) == (TestValues{{1, 2}, {2, 2}, {3, 2}}));
+	CPPUNIT_ASSERT_EQUAL(0, limiter.deferred());
+}
+
+/**
+ * @brief Values of exempt module types are not coalesced until
+ * the backlog of the device is full.
+ */
+void DeviceRateLimiterTest::testExemptTypes()
+{
+	DeviceRateLimiter limiter;
+	limiter.setInterval(1 * Timespan::SECONDS);
+	limiter.setExemptTypes({"motion"});
+	limiter.setModuleTypes(new TestingModuleTypes);
+
+	CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 20}}, CHATTY), at(0)));
+
+	for (int i = 1; i <= 4; ++i) {
+		CPPUNIT_ASSERT(!limiter.admit(
+			makeData(i, {{0, 20.0 + i}, {1, double(i % 2)}}, CHATTY), at(i)));
+	}
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(4, limiter.flush(released));
+
+	for (int i = 0; i < 3; ++i) {
+		CPPUNIT_ASSERT(Timestamp::fromEpochTime(TEST_EPOCH + i + 1) == released[i].timestamp().value());
+		CPPUNIT_ASSERT(valuesOf(released[i]) == (TestValues{{1, double((i + 1) % 2)}}));
+	}
+
+	CPPUNIT_ASSERT(valuesOf(released[3]) == (TestValues{{0, 24}, {1, 0}}));
+
+	// backlog of events is bounded
+	for (int i = 5; i < 100; ++i)
+		limiter.admit(makeData(i, {{1, double(i % 2)}}, CHATTY), at(i));
+
+	released.clear();
+	CPPUNIT_ASSERT(limiter.flush(released) <= 16);
+	CPPUNIT_ASSERT(valuesOf(released.back()) == (TestValues{{1, 1}}));
+}
+
+/**
+ * @brief An exempt value is never merged into deferred data already
+ * holding a value of the same module, even when both have the same
+ * timestamp. Values of other modules are still merged.
+ */
+void DeviceRateLimiterTest::testExemptSameTimestamp()
+{
+	DeviceRateLimiter limiter;
+	limiter.setInterval(1 * Timespan::SECONDS);
+	limiter.setExemptTypes({"motion"});
+	limiter.setModuleTypes(new TestingModuleTypes);
+
+	CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 20}}, CHATTY), at(0)));
+	CPPUNIT_ASSERT(!limiter.admit(makeData(1, {{1, 1}}, CHATTY), at(100)));
+	CPPUNIT_ASSERT(!limiter.admit(makeData(1, {{1, 0}}, CHATTY), at(200)));
+	CPPUNIT_ASSERT(!limiter.admit(makeData(1, {{0, 21}}, CHATTY), at(300)));
+	CPPUNIT_ASSERT_EQUAL(1, limiter.deferred());
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(2, limiter.flush(released));
+
+	CPPUNIT_ASSERT(valuesOf(released[0]) == (TestValues{{1, 1}}));
+	CPPUNIT_ASSERT(valuesOf(released[1]) == (TestValues{{0, 21}, {1, 0}}));
+}
+
+/**
+ * @brief Flush releases all deferred data regardless of tokens.
+ */
+void DeviceRateLimiterTest::testFlush()
+{
+	DeviceRateLimiter limiter;
+	limiter.setInterval(1 * Timespan::MINUTES);
+
+	for (const auto &device : {CHATTY, QUIET1}) {
+		CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 1}}, device), at(0)));
+		CPPUNIT_ASSERT(!limiter.admit(makeData(1, {{0, 2}}, device), at(0)));
+		CPPUNIT_ASSERT(!limiter.admit(makeData(2, {{1, 3}}, device), at(0)));
+	}
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(0, limiter.release(released, at(1000)));
+	CPPUNIT_ASSERT_EQUAL(4, limiter.flush(released));
+	CPPUNIT_ASSERT_EQUAL(0, limiter.deferred());
+	CPPUNIT_ASSERT(limiter.nextRelease(at(1000)) < 0);
+
+	CPPUNIT_ASSERT(CHATTY == released[0].deviceID());
+	CPPUNIT_ASSERT(valuesOf(released[0]) == (TestValues{{0, 2}}));
+	CPPUNIT_ASSERT(valuesOf(released[1]) == (TestValues{{1, 3}}));
+	CPPUNIT_ASSERT(QUIET1 == released[2].deviceID());
+}
+
+/**
+ * @brief A device reporting in a tight loop does not affect other
+ * devices and it holds back at most a single data.
+ */
+void DeviceRateLimiterTest::testIsolation()
+{
+	DeviceRateLimiter limiter;
+	limiter.setInterval(1 * Timespan::SECONDS);
+	limiter.setBurst(2);
+
+	unsigned int admitted = 0;
+	unsigned int quiet = 0;
+
+	for (int ms = 0; ms < 10000; ++ms) {
+		if (limiter.admit(makeData(0, {{0, double(ms)}}, CHATTY), at(ms)))
+			admitted += 1;
+
+		if (ms % 2000 == 0) {
+			if (limiter.admit(makeData(0, {{0, 1}}, QUIET1), at(ms)))
+				quiet += 1;
+			if (limiter.admit(makeData(0, {{0, 1}}, QUIET2), at(ms)))
+				quiet += 1;
+		}
+
+		vector<SensorData> released;
+		admitted += limiter.release(released, at(ms));
+
+		CPPUNIT_ASSERT(limiter.deferred() <= 1);
+	}
+
+	CPPUNIT_ASSERT_EQUAL(10, quiet);
+	CPPUNIT_ASSERT(admitted >= 10 && admitted <= 12);
+}
+
+/**
+ * @brief Deferred data are released in the order of deferral and
+ * each device is visited once per release.
+ */
+void DeviceRateLimiterTest::testRoundRobin()
+{
+	DeviceRateLimiter limiter;
+	limiter.setInterval(1 * Timespan::SECONDS);
+
+	for (const auto &device : {QUIET2, CHATTY, QUIET1}) {
+		CPPUNIT_ASSERT(limiter.admit(makeData(0, {{0, 1}}, device), at(0)));
+		CPPUNIT_ASSERT(!limiter.admit(makeData(0, {{0, 2}}, device), at(0)));
+	}
+
+	CPPUNIT_ASSERT_EQUAL(3, limiter.deferred());
+
+	vector<SensorData> released;
+	CPPUNIT_ASSERT_EQUAL(3, limiter.release(released, at(1000)));
+
+	CPPUNIT_ASSERT(QUIET2 == released[0].deviceID());
+	CPPUNIT_ASSERT(CHATTY == released[1].deviceID());
+	CPPUNIT_ASSERT(QUIET1 == released[2].deviceID());
+	CPPUNIT_ASSERT_EQUAL(0, limiter.deferred());
+}
+
+void DeviceRateLimiterTest::testReport()
+{
+	DeviceRateLimiter limiter;
+	limiter.setInterval(1 * Timespan::SECONDS);
+
+	for (int i = 0; i < 5; ++i)
+		limiter.admit(makeData(0, {{0, 1}}, CHATTY), at(0));
+	for (int i = 0; i < 3; ++i)
+		limiter.admit(makeData(0, {{0, 1}}, QUIET1), at(0));
+	limiter.admit(makeData(0, {{0, 1}}, QUIET2), at(0));
+
+	vector<DeviceRateLimiter::Offender> offenders;
+	limiter.report(offenders);
+
+	CPPUNIT_ASSERT_EQUAL(2, offenders.size());
+	CPPUNIT_ASSERT(CHATTY == offenders[0].device);
+	CPPUNIT_ASSERT_EQUAL(1, offenders[0].limited);
+	CPPUNIT_ASSERT_EQUAL(3, offenders[0].coalesced);
+	CPPUNIT_ASSERT(QUIET1 == offenders[1].device);
+	CPPUNIT_ASSERT_EQUAL(1, offenders[1].limited);
+	CPPUNIT_ASSERT_EQUAL(1, offenders[1].coalesced);
+
+	offenders.clear();
+	limiter.report(offenders);
+	CPPUNIT_ASSERT(offenders.empty());
+}
+
+}
@@ -0,0 +1,327 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Event.h>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "core/DiscoveryExecutor.h"
+
+using namespace std;
+using namespace Poco;
+
+namespace BeeeOn {
+
+class DiscoveryExecutorTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(DiscoveryExecutorTest);
+	CPPUNIT_TEST(testBoundedThreads);
+	CPPUNIT_TEST(testPriority);
+	CPPUNIT_TEST(testCancelQueued);
+	CPPUNIT_TEST(testStartTwice);
+	CPPUNIT_TEST(testMoreSeekersThanThreads);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testBoundedThreads();
+	void testPriority();
+	void testCancelQueued();
+	void testStartTwice();
+	void testMoreSeekersThanThreads();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DiscoveryExecutorTest);
+
+/**
+ * @brief Seeker blocking until released or stopped. It records
+ * the order of execution and the number of concurrent seekers.
+ */
+class BlockingSeeker : public AbstractSeeker {
+public:
+	typedef SharedPtr<BlockingSeeker> Ptr;
+
+	BlockingSeeker(
+			const string &name,
+			vector<string> &order,
+			FastMutex &lock,
+			AtomicCounter &concurrent,
+			AtomicCounter &peak):
+		AbstractSeeker(10 * Timespan::SECONDS),
+		m_name(name),
+		m_order(order),
+		m_lock(lock),
+		m_concurrent(concurrent),
+		m_peak(peak)
+	{
+	}
+
+	void release()
+	{
+		m_release.set();
+	}
+
+	void waitStarted()
+	{
+		m_started.wait(5000);
+	}
+
+protected:
+	void seekLoop(StopControl &control) override
+	{
+		const int concurrent = ++m_concurrent;
+
+		{
+			FastMutex::ScopedLock guard(m_lock);
+			m_order.emplace_back(m_name);
+
+			if (concurrent > m_peak)
+				m_peak = concurrent;
+		}
+
+		m_started.set();
+
+		StopControl::Run run(control);
+
+		while (run && !m_release.tryWait(10))
+			;
+
+		--m_concurrent;
+	}
+
+private:
+	string m_name;
+	vector<string> &m_order;
+	FastMutex &m_lock;
+	AtomicCounter &m_concurrent;
+	AtomicCounter &m_peak;
+	Event m_started;
+	Event m_release;
+};
+
+/**
+ * @brief Seeker looping over short passes for its whole duration
+ * like the seekers of device managers do.
+ */
+class PassingSeeker : public AbstractSeeker {
+public:
+	typedef SharedPtr<PassingSeeker> Ptr;
+
+	PassingSeeker(
+			const Timespan &duration,
+			AtomicCounter &concurrent,
+			AtomicCounter &peak):
+		AbstractSeeker(duration),
+		m_concurrent(concurrent),
+		m_peak(peak)
+	{
+	}
+
+	int passes() const
+	{
+		return m_passes.value();
+	}
+
+protected:
+	void seekLoop(StopControl &control) override
+	{
+		StopControl::Run run(control);
+
+		while (nextPass()) {
+			const int concurrent = ++m_concurrent;
+			if (concurrent > m_peak)
+				m_peak = concurrent;
+
+			++m_passes;
+			run.waitStoppable(20 * Timespan::MILLISECONDS);
+
+			--m_concurrent;
+
+			if (!run)
+				break;
+		}
+	}
+
+private:
+	AtomicCounter &m_concurrent;
+	AtomicCounter &m_peak;
+	AtomicCounter m_passes;
+};
+
+/**
+ * @brief No more than maxThreads seekers are running at once and
+ * all submitted seekers are executed eventually.
+ */
+void DiscoveryExecutorTest::testBoundedThreads()
+{
+	DiscoveryExecutor executor;
+	executor.setMaxThreads(2);
+
+	vector<string> order;
+	FastMutex lock;
+	AtomicCounter concurrent;
+	AtomicCounter peak;
+	vector<BlockingSeeker::Ptr> seekers;
+
+	for (int i = 0; i < 5; ++i) {
+		seekers.emplace_back(new BlockingSeeker(
+			to_string(i), order, lock, concurrent, peak));
+		executor.submit(seekers.back(), DevicePrefix::PREFIX_VPT);
+	}
+
+	for (auto seeker : seekers) {
+		seeker->waitStarted();
+		seeker->release();
+		CPPUNIT_ASSERT(seeker->tryJoin(5 * Timespan::SECONDS));
+	}
+
+	CPPUNIT_ASSERT_EQUAL(5, order.size());
+	CPPUNIT_ASSERT_EQUAL(2, peak.value());
+	CPPUNIT_ASSERT_EQUAL(2, executor.peakWorkers());
+
+	executor.cleanup();
+}
+
+/**
+ * @brief Seekers of the prioritized prefix are executed before
+ * the seekers queued earlier.
+ */
+void DiscoveryExecutorTest::testPriority()
+{
+	DiscoveryExecutor executor;
+	executor.setMaxThreads(1);
+
+	vector<string> order;
+	FastMutex lock;
+	AtomicCounter concurrent;
+	AtomicCounter peak;
+
+	BlockingSeeker::Ptr first = new BlockingSeeker(
+		"first", order, lock, concurrent, peak);
+	BlockingSeeker::Ptr vpt = new BlockingSeeker(
+		"vpt", order, lock, concurrent, peak);
+	BlockingSeeker::Ptr hue = new BlockingSeeker(
+		"hue", order, lock, concurrent, peak);
+
+	executor.submit(first, DevicePrefix::PREFIX_VPT);
+	first->waitStarted();
+
+	executor.submit(vpt, DevicePrefix::PREFIX_VPT);
+	executor.submit(hue, DevicePrefix::PREFIX_PHILIPS_HUE);
+	executor.prioritize(DevicePrefix::PREFIX_PHILIPS_HUE);
+
+	first->release();
+	hue->waitStarted();
+	hue->release();
+	vpt->waitStarted();
+	vpt->release();
+
+	CPPUNIT_ASSERT(vpt->tryJoin(5 * Timespan::SECONDS));
+
+	CPPUNIT_ASSERT_EQUAL(3, order.size());
+	CPPUNIT_ASSERT_EQUAL("first", order[0]);
+	CPPUNIT_ASSERT_EQUAL("hue", order[1]);
+	CPPUNIT_ASSERT_EQUAL("vpt", order[2]);
+
+	executor.cleanup();
+}
+
+/**
+ * @brief Cancelling a seeker waiting in the queue returns immediately
+ * and the seeker is never executed.
+ */
+void DiscoveryExecutorTest::testCancelQueued()
+{
+	DiscoveryExecutor executor;
+	executor.setMaxThreads(1);
+
+	vector<string> order;
+	FastMutex lock;
+	AtomicCounter concurrent;
+	AtomicCounter peak;
+
+	BlockingSeeker::Ptr running = new BlockingSeeker(
+		"running", order, lock, concurrent, peak);
+	BlockingSeeker::Ptr queued = new BlockingSeeker(
+		"queued", order, lock, concurrent, peak);
+
+	executor.submit(running, DevicePrefix::PREFIX_VPT);
+	running->waitStarted();
+	executor.submit(queued, DevicePrefix::PREFIX_VPT);
+
+	CPPUNIT_ASSERT(!queued->tryJoin(10 * Timespan::MILLISECONDS));
+	queued->cancel();
+	CPPUNIT_ASSERT(queued->tryJoin(0));
+	CPPUNIT_ASSERT_EQUAL(0, queued->remaining().totalMicroseconds());
+
+	running->cancel();
+	CPPUNIT_ASSERT(running->tryJoin(0));
+
+	executor.cleanup();
+
+	CPPUNIT_ASSERT_EQUAL(1, order.size());
+	CPPUNIT_ASSERT_EQUAL("running", order[0]);
+}
+
+void DiscoveryExecutorTest::testStartTwice()
+{
+	DiscoveryExecutor executor;
+
+	vector<string> order;
+	FastMutex lock;
+	AtomicCounter concurrent;
+	AtomicCounter peak;
+
+	BlockingSeeker::Ptr seeker = new BlockingSeeker(
+		"seeker", order, lock, concurrent, peak);
+
+	executor.submit(seeker, DevicePrefix::PREFIX_VPT);
+
+	CPPUNIT_ASSERT_THROW(
+		executor.submit(seeker, DevicePrefix::PREFIX_VPT),
+		IllegalStateException);
+	CPPUNIT_ASSERT_THROW(seeker->start(), IllegalStateException);
+
+	seeker->cancel();
+	executor.cleanup();
+
+	CPPUNIT_ASSERT_THROW(
+		executor.submit(AbstractSeeker::Ptr(new BlockingSeeker(
+			"late", order, lock, concurrent, peak)),
+			DevicePrefix::PREFIX_VPT),
+		IllegalStateException);
+}
+
+/**
+ * @brief Seekers running for the whole listen duration do not
+ * occupy the threads. They yield after each pass when other seekers
+ * are waiting and thus all of them get to seek within the duration.
+ */
+void DiscoveryExecutorTest::testMoreSeekersThanThreads()
+{
+	DiscoveryExecutor executor;
+	executor.setMaxThreads(2);
+
+	AtomicCounter concurrent;
+	AtomicCounter peak;
+	vector<PassingSeeker::Ptr> seekers;
+
+	for (int i = 0; i < 4; ++i) {
+		seekers.emplace_back(new PassingSeeker(
+			500 * Timespan::MILLISECONDS, concurrent, peak));
+		executor.submit(seekers.back(), DevicePrefix::PREFIX_VPT);
+	}
+
+	for (auto seeker : seekers)
+		CPPUNIT_ASSERT(seeker->tryJoin(5 * Timespan::SECONDS));
+
+	for (auto seeker : seekers) {
+		CPPUNIT_ASSERT(seeker->passes() > 1);
+		CPPUNIT_ASSERT_EQUAL(0, seeker->remaining().totalMicroseconds());
+	}
+
+	CPPUNIT_ASSERT(peak.value() <= 2);
+	CPPUNIT_ASSERT_EQUAL(2, executor.peakWorkers());
+
+	executor.cleanup();
+}
+
+}
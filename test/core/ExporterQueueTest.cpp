@@ -9,6 +9,7 @@
 #include "cppunit/BetterAssert.h"
 
 #include "core/ExporterQueue.h"
+#include "core/StageLatency.h"
 #include "model/DeviceID.h"
 
 using namespace std;
@@ -80,6 +81,7 @@ class ExporterQueueTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testQueueOverloaded);
 	CPPUNIT_TEST(testExporterBroken);
 	CPPUNIT_TEST(testExporterFull);
+	CPPUNIT_TEST(testDequeueRecordedOnce);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -87,6 +89,7 @@ public:
 	void testQueueOverloaded();
 	void testExporterBroken();
 	void testExporterFull();
+	void testDequeueRecordedOnce();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(ExporterQueueTest);
@@ -284,4 +287,31 @@ void ExporterQueueTest::testExporterFull()
 	);
 }
 
+/**
+ * The test verifies that the latency of dequeueing is recorded once
+ * per data even when shipping of the data is retried.
+ */
+void ExporterQueueTest::testDequeueRecordedOnce()
+{
+	SharedPtr<Exporter> exporter = new QueueTestingExporter(&QueueTestingExporter::shipFull);
+
+	ExporterQueue queue(exporter, 10, 20, 1);
+	StageLatency::instance().reset();
+
+	SensorData data;
+	data.setDeviceID(DeviceID(0x1111222233334444UL));
+	queue.enqueue(data);
+	queue.enqueue(data);
+
+	for (int i = 0; i < 5; ++i)
+		CPPUNIT_ASSERT_EQUAL(0, queue.exportBatch());
+
+	CPPUNIT_ASSERT_EQUAL(1, StageLatency::instance().snapshot(StageLatency::DEQUEUE).count());
+
+	exporter.cast<QueueTestingExporter>()->setOK();
+
+	CPPUNIT_ASSERT_EQUAL(2, queue.exportBatch());
+	CPPUNIT_ASSERT_EQUAL(2, StageLatency::instance().snapshot(StageLatency::DEQUEUE).count());
+}
+
 }
@@ -0,0 +1,229 @@
+#include <cmath>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Timestamp.h>
+
+#include "cppunit/BetterAssert.h"
+#include "cppunit/FileTestFixture.h"
+
+#include "commands/ServerDeviceListCommand.h"
+#include "commands/ServerLastValueCommand.h"
+#include "commands/ServerLastValueResult.h"
+#include "core/AnswerQueue.h"
+#include "core/CommandHandler.h"
+#include "core/LastValueStore.h"
+#include "model/DevicePrefix.h"
+#include "model/SensorData.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class LastValueStoreTest : public FileTestFixture {
+	CPPUNIT_TEST_SUITE(LastValueStoreTest);
+	CPPUNIT_TEST(testUpdateKeepsNewest);
+	CPPUNIT_TEST(testOnExport);
+	CPPUNIT_TEST(testAcceptLastValue);
+	CPPUNIT_TEST(testHandle);
+	CPPUNIT_TEST(testHandleForwardsStale);
+	CPPUNIT_TEST(testHandleStaleWithoutFallback);
+	CPPUNIT_TEST(testPersistLoad);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testUpdateKeepsNewest();
+	void testOnExport();
+	void testAcceptLastValue();
+	void testHandle();
+	void testHandleForwardsStale();
+	void testHandleStaleWithoutFallback();
+	void testPersistLoad();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LastValueStoreTest);
+
+class TestingFallback : public CommandHandler {
+public:
+	bool accept(const Command::Ptr) override
+	{
+		return true;
+	}
+
+	void handle(Command::Ptr cmd, Answer::Ptr) override
+	{
+		m_handled.emplace_back(cmd);
+	}
+
+	vector<Command::Ptr> m_handled;
+};
+
+static const DeviceID DEVICE(0xa300000000000001);
+
+void LastValueStoreTest::testUpdateKeepsNewest()
+{
+	LastValueStore store;
+	const Timestamp now;
+
+	store.update(DEVICE, ModuleID(0), 10.0, now);
+	store.update(DEVICE, ModuleID(0), 5.0, now - 1 * Timespan::SECONDS);
+
+	CPPUNIT_ASSERT_EQUAL(1, store.size());
+	CPPUNIT_ASSERT_EQUAL(10.0, store.lookup(DEVICE, ModuleID(0)).value().value);
+
+	store.update(DEVICE, ModuleID(0), 15.0, now + 1 * Timespan::SECONDS);
+	CPPUNIT_ASSERT_EQUAL(15.0, store.lookup(DEVICE, ModuleID(0)).value().value);
+
+	CPPUNIT_ASSERT(store.lookup(DEVICE, ModuleID(1)).isNull());
+}
+
+/**
+ * @brief Only valid values of the distributed data are remembered.
+ */
+void LastValueStoreTest::testOnExport()
+{
+	LastValueStore store;
+
+	SensorData data;
+	data.setDeviceID(DEVICE);
+	data.insertValue(SensorValue(ModuleID(0), 21.5));
+	data.insertValue(SensorValue(ModuleID(1), NAN));
+	data.insertValue(SensorValue(ModuleID(2)));
+
+	store.onExport(data);
+
+	CPPUNIT_ASSERT_EQUAL(1, store.size());
+	CPPUNIT_ASSERT_EQUAL(21.5, store.lookup(DEVICE, ModuleID(0)).value().value);
+	CPPUNIT_ASSERT(store.lookup(DEVICE, ModuleID(1)).isNull());
+	CPPUNIT_ASSERT(store.lookup(DEVICE, ModuleID(2)).isNull());
+}
+
+/**
+ * @brief Every ServerLastValueCommand is accepted regardless of
+ * the age of the value. Other commands are never accepted.
+ */
+void LastValueStoreTest::testAcceptLastValue()
+{
+	LastValueStore store;
+	store.setMaxAge(1 * Timespan::MINUTES);
+
+	store.update(DEVICE, ModuleID(0), 1.0, Timestamp{});
+	store.update(DEVICE, ModuleID(1), 2.0, Timestamp{} - 2 * Timespan::MINUTES);
+
+	CPPUNIT_ASSERT(store.accept(new ServerLastValueCommand(DEVICE, ModuleID(0))));
+	CPPUNIT_ASSERT(store.accept(new ServerLastValueCommand(DEVICE, ModuleID(1))));
+	CPPUNIT_ASSERT(store.accept(new ServerLastValueCommand(DEVICE, ModuleID(2))));
+	CPPUNIT_ASSERT(!store.accept(
+		new ServerDeviceListCommand(DevicePrefix::PREFIX_VIRTUAL_DEVICE)));
+}
+
+void LastValueStoreTest::testHandle()
+{
+	LastValueStore store;
+	store.update(DEVICE, ModuleID(3), 42.0, Timestamp{});
+
+	AnswerQueue queue;
+	Answer::Ptr answer = new Answer(queue);
+
+	store.handle(new ServerLastValueCommand(DEVICE, ModuleID(3)), answer);
+
+	CPPUNIT_ASSERT_EQUAL(1, answer->resultsCount());
+
+	ServerLastValueResult::Ptr result = answer->at(0).cast<ServerLastValueResult>();
+	CPPUNIT_ASSERT(!result.isNull());
+	CPPUNIT_ASSERT(result->status() == Result::Status::SUCCESS);
+	CPPUNIT_ASSERT_EQUAL(DEVICE, result->deviceID());
+	CPPUNIT_ASSERT_EQUAL(ModuleID(3), result->moduleID());
+	CPPUNIT_ASSERT_EQUAL(42.0, result->value());
+
+	queue.remove(answer);
+}
+
+/**
+ * @brief Commands asking for stale or unknown values are forwarded
+ * to the fallback. Fresh values are answered without the fallback.
+ */
+void LastValueStoreTest::testHandleForwardsStale()
+{
+	SharedPtr<TestingFallback> fallback = new TestingFallback;
+
+	LastValueStore store;
+	store.setMaxAge(1 * Timespan::MINUTES);
+	store.setFallback(fallback);
+
+	store.update(DEVICE, ModuleID(0), 1.0, Timestamp{});
+	store.update(DEVICE, ModuleID(1), 2.0, Timestamp{} - 2 * Timespan::MINUTES);
+
+	AnswerQueue queue;
+	Answer::Ptr fresh = new Answer(queue);
+	Answer::Ptr stale = new Answer(queue);
+	Answer::Ptr unknown = new Answer(queue);
+
+	store.handle(new ServerLastValueCommand(DEVICE, ModuleID(0)), fresh);
+	store.handle(new ServerLastValueCommand(DEVICE, ModuleID(1)), stale);
+	store.handle(new ServerLastValueCommand(DEVICE, ModuleID(2)), unknown);
+
+	CPPUNIT_ASSERT_EQUAL(1, fresh->resultsCount());
+	CPPUNIT_ASSERT(fresh->at(0)->status() == Result::Status::SUCCESS);
+	CPPUNIT_ASSERT_EQUAL(0, stale->resultsCount());
+	CPPUNIT_ASSERT_EQUAL(0, unknown->resultsCount());
+
+	CPPUNIT_ASSERT_EQUAL(2, fallback->m_handled.size());
+
+	const auto first = fallback->m_handled[0].cast<ServerLastValueCommand>();
+	CPPUNIT_ASSERT_EQUAL(ModuleID(1), first->moduleID());
+
+	const auto second = fallback->m_handled[1].cast<ServerLastValueCommand>();
+	CPPUNIT_ASSERT_EQUAL(ModuleID(2), second->moduleID());
+
+	queue.remove(fresh);
+	queue.remove(stale);
+	queue.remove(unknown);
+}
+
+/**
+ * @brief Without a fallback, command asking for a stale value fails.
+ */
+void LastValueStoreTest::testHandleStaleWithoutFallback()
+{
+	LastValueStore store;
+	store.setMaxAge(1 * Timespan::MINUTES);
+	store.update(DEVICE, ModuleID(1), 2.0, Timestamp{} - 2 * Timespan::MINUTES);
+
+	AnswerQueue queue;
+	Answer::Ptr answer = new Answer(queue);
+
+	store.handle(new ServerLastValueCommand(DEVICE, ModuleID(1)), answer);
+
+	CPPUNIT_ASSERT_EQUAL(1, answer->resultsCount());
+	CPPUNIT_ASSERT(answer->at(0)->status() == Result::Status::FAILED);
+
+	queue.remove(answer);
+}
+
+/**
+ * @brief Persisted values are loaded back exactly, including their
+ * timestamps.
+ */
+void LastValueStoreTest::testPersistLoad()
+{
+	const Timestamp at(1500000000123456);
+
+	LastValueStore store;
+	store.setFile(testingPath().toString());
+	store.update(DEVICE, ModuleID(0), 0.1, at);
+	store.update(DEVICE, ModuleID(1), -273.15, at + 1);
+	store.persist();
+
+	LastValueStore loaded;
+	loaded.setFile(testingPath().toString());
+
+	CPPUNIT_ASSERT_EQUAL(2, loaded.load());
+	CPPUNIT_ASSERT_EQUAL(0.1, loaded.lookup(DEVICE, ModuleID(0)).value().value);
+	CPPUNIT_ASSERT(loaded.lookup(DEVICE, ModuleID(0)).value().at == at);
+	CPPUNIT_ASSERT_EQUAL(-273.15, loaded.lookup(DEVICE, ModuleID(1)).value().value);
+	CPPUNIT_ASSERT(loaded.lookup(DEVICE, ModuleID(1)).value().at == at + 1);
+}
+
+}
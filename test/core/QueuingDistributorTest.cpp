@@ -8,6 +8,7 @@
 #include <Poco/Logger.h>
 #include <Poco/Mutex.h>
 #include <Poco/SharedPtr.h>
+#include <Poco/Timespan.h>
 
 #include "cppunit/BetterAssert.h"
 
@@ -127,12 +128,14 @@ class QueuingDistributorTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testExportIsOk);
 	CPPUNIT_TEST(testFullExporter);
 	CPPUNIT_TEST(testNoConnectivityExporter);
+	CPPUNIT_TEST(testFlushOnStop);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
 	void testExportIsOk();
 	void testFullExporter();
 	void testNoConnectivityExporter();
+	void testFlushOnStop();
 
 	LoopRunner m_loopRunner;
 };
@@ -297,4 +300,34 @@ void QueuingDistributorTest::testNoConnectivityExporter()
 	m_loopRunner.stop();
 }
 
+/**
+ * The test verifies that data deferred by the rate limiter are not lost
+ * when the distributor stops, they are delivered to exporters instead.
+ */
+void QueuingDistributorTest::testFlushOnStop()
+{
+	SharedPtr<QueuingDistributor> distributor = new QueuingDistributor;
+	SharedPtr<Exporter> exporter = new TestingExporter;
+
+	distributor->setRateLimit(1 * Timespan::HOURS);
+	distributor->setRateLimitBurst(1);
+	distributor->registerExporter(exporter);
+
+	m_loopRunner.addRunnable(distributor);
+	m_loopRunner.start();
+
+	SensorData data;
+	DeviceID id(0x1111222233334444UL);
+	data.setDeviceID(id);
+	distributor->exportData(data);
+	distributor->exportData(data);
+
+	CPPUNIT_ASSERT(exporter.cast<TestingExporter>()->waitShipAttempt());
+	CPPUNIT_ASSERT_EQUAL(1, exporter.cast<TestingExporter>()->m_shipped);
+
+	m_loopRunner.stop();
+
+	CPPUNIT_ASSERT_EQUAL(2, exporter.cast<TestingExporter>()->m_shipped);
+}
+
 }
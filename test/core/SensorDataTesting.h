@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+
+#include <Poco/Timestamp.h>
+
+#include "model/DeviceID.h"
+#include "model/SensorData.h"
+
+namespace BeeeOn {
+
+/**
+ * Values of SensorData keyed by their module IDs.
+ */
+typedef std::map<unsigned int, double> TestValues;
+
+/**
+ * Epoch second of the test data, it is aligned to a whole hour.
+ */
+static const int TEST_EPOCH = 1500000000 - 1500000000 % 3600;
+
+static const DeviceID TEST_DEVICE(0xa300000000000001);
+
+/**
+ * Result of applyFilter() when the whole data has been dropped.
+ */
+static const TestValues DROPPED = {{0xffff, 0}};
+
+/**
+ * @brief Create data of the given device stamped by the given
+ * count of seconds since the TEST_EPOCH.
+ */
+inline SensorData makeData(
+		int second,
+		const TestValues &values,
+		const DeviceID &device = TEST_DEVICE)
+{
+	SensorData data;
+	data.setDeviceID(device);
+	data.setTimestamp(Poco::Timestamp::fromEpochTime(TEST_EPOCH + second));
+
+	for (const auto &pair : values)
+		data.insertValue(SensorValue(ModuleID(pair.first), pair.second));
+
+	return data;
+}
+
+inline TestValues valuesOf(const SensorData &data)
+{
+	TestValues result;
+
+	for (const auto &item : data)
+		result.emplace(item.moduleID().value(), item.value());
+
+	return result;
+}
+
+/**
+ * @brief Apply the filter and return the remaining values or DROPPED
+ * when the whole data has been dropped.
+ */
+template <typename Filter>
+TestValues applyFilter(Filter &filter, SensorData data)
+{
+	if (!filter.filter(data))
+		return DROPPED;
+
+	return valuesOf(data);
+}
+
+}
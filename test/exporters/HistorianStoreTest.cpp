@@ -0,0 +1,368 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/File.h>
+#include <Poco/Path.h>
+#include <Poco/Timestamp.h>
+
+#include "cppunit/BetterAssert.h"
+#include "cppunit/FileTestFixture.h"
+#include "exporters/HistorianStore.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class HistorianStoreTest : public FileTestFixture {
+	CPPUNIT_TEST_SUITE(HistorianStoreTest);
+	CPPUNIT_TEST(testQueryPending);
+	CPPUNIT_TEST(testQuerySealed);
+	CPPUNIT_TEST(testPartitionRollover);
+	CPPUNIT_TEST(testReopen);
+	CPPUNIT_TEST(testTruncatedTail);
+	CPPUNIT_TEST(testRetention);
+	CPPUNIT_TEST(testSizeLimit);
+	CPPUNIT_TEST(testRejectFuture);
+	CPPUNIT_TEST(testRetentionClampedToNow);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp();
+	void testQueryPending();
+	void testQuerySealed();
+	void testPartitionRollover();
+	void testReopen();
+	void testTruncatedTail();
+	void testRetention();
+	void testSizeLimit();
+	void testRejectFuture();
+	void testRetentionClampedToNow();
+
+private:
+	void fill(HistorianStore &store, int days);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HistorianStoreTest);
+
+static const DeviceID DEVICE_A(0xa300000000000001);
+static const DeviceID DEVICE_B(0xa300000000000002);
+static const Timespan INTERVAL = 5 * Timespan::MINUTES;
+static const int POINTS_PER_DAY = 288;
+
+/**
+ * @brief The HistorianStore maintains partition files inside
+ * a directory.
+ */
+void HistorianStoreTest::setUp()
+{
+	FileTestFixture::setUpAsDirectory();
+}
+
+/**
+ * @brief Append a point every 5 minutes into 2 series
+ * for the given count of days since epoch.
+ */
+void HistorianStoreTest::fill(HistorianStore &store, int days)
+{
+	for (int i = 0; i < days * POINTS_PER_DAY; ++i) {
+		const Timestamp at(i * INTERVAL.totalMicroseconds());
+
+		store.append(DEVICE_A, ModuleID(0), at, 20 + (i % 40) * 0.25);
+		store.append(DEVICE_B, ModuleID(1), at, i);
+	}
+}
+
+/**
+ * @brief Points not sealed yet are found by query.
+ */
+void HistorianStoreTest::testQueryPending()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.open();
+
+	store.append(DEVICE_A, ModuleID(0), Timestamp(3000000), 3.0);
+	store.append(DEVICE_A, ModuleID(0), Timestamp(1000000), 1.0);
+	store.append(DEVICE_A, ModuleID(0), Timestamp(2000000), 2.0);
+	store.append(DEVICE_A, ModuleID(1), Timestamp(2000000), 20.0);
+
+	CPPUNIT_ASSERT_EQUAL(4, store.pendingPoints());
+	CPPUNIT_ASSERT_EQUAL(0, store.diskUsage());
+
+	vector<HistorianStore::Point> points;
+	store.query(DEVICE_A, ModuleID(0), Timestamp(0), Timestamp(3000000), points);
+
+	CPPUNIT_ASSERT_EQUAL(2, points.size());
+	CPPUNIT_ASSERT(points[0].at == Timestamp(1000000));
+	CPPUNIT_ASSERT_EQUAL(1.0, points[0].value);
+	CPPUNIT_ASSERT(points[1].at == Timestamp(2000000));
+	CPPUNIT_ASSERT_EQUAL(2.0, points[1].value);
+}
+
+/**
+ * @brief Full blocks are sealed on their own, the rest on flush().
+ * Query combines sealed and pending points.
+ */
+void HistorianStoreTest::testQuerySealed()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.setBlockPoints(100);
+	store.open();
+
+	fill(store, 1);
+
+	CPPUNIT_ASSERT_EQUAL(1, store.partitionCount());
+	CPPUNIT_ASSERT_EQUAL(2 * (POINTS_PER_DAY % 100), store.pendingPoints());
+	CPPUNIT_ASSERT(store.diskUsage() > 0);
+
+	vector<HistorianStore::Point> points;
+	store.query(DEVICE_B, ModuleID(1), Timestamp(0),
+		Timestamp(POINTS_PER_DAY * INTERVAL.totalMicroseconds()), points);
+
+	CPPUNIT_ASSERT_EQUAL(POINTS_PER_DAY, points.size());
+
+	for (int i = 0; i < POINTS_PER_DAY; ++i) {
+		CPPUNIT_ASSERT(points[i].at == Timestamp(i * INTERVAL.totalMicroseconds()));
+		CPPUNIT_ASSERT_EQUAL(double(i), points[i].value);
+	}
+
+	store.flush();
+	CPPUNIT_ASSERT_EQUAL(0, store.pendingPoints());
+
+	points.clear();
+	store.query(DEVICE_A, ModuleID(0),
+		Timestamp(99 * INTERVAL.totalMicroseconds()),
+		Timestamp(102 * INTERVAL.totalMicroseconds()),
+		points);
+
+	CPPUNIT_ASSERT_EQUAL(3, points.size());
+	CPPUNIT_ASSERT_EQUAL(20 + 19 * 0.25, points[0].value);
+	CPPUNIT_ASSERT_EQUAL(20 + 20 * 0.25, points[1].value);
+	CPPUNIT_ASSERT_EQUAL(20 + 21 * 0.25, points[2].value);
+
+	points.clear();
+	store.query(DEVICE_A, ModuleID(1), Timestamp(0), Timestamp(Timestamp::TIMEVAL_MAX), points);
+	CPPUNIT_ASSERT(points.empty());
+}
+
+/**
+ * @brief Starting a new partition seals all blocks of the older ones.
+ * Queries spanning multiple partitions return points in order.
+ */
+void HistorianStoreTest::testPartitionRollover()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.open();
+
+	fill(store, 3);
+
+	CPPUNIT_ASSERT_EQUAL(2, store.partitionCount());
+	CPPUNIT_ASSERT_EQUAL(2 * POINTS_PER_DAY, store.pendingPoints());
+	CPPUNIT_ASSERT(File(Path(testingPath(), "86400000.gts")).exists());
+	CPPUNIT_ASSERT(!File(Path(testingPath(), "172800000.gts")).exists());
+
+	vector<HistorianStore::Point> points;
+	store.query(DEVICE_B, ModuleID(1),
+		Timestamp((POINTS_PER_DAY - 1) * INTERVAL.totalMicroseconds()),
+		Timestamp((2 * POINTS_PER_DAY + 2) * INTERVAL.totalMicroseconds()),
+		points);
+
+	CPPUNIT_ASSERT_EQUAL(POINTS_PER_DAY + 3, points.size());
+
+	for (size_t i = 0; i < points.size(); ++i)
+		CPPUNIT_ASSERT_EQUAL(double(POINTS_PER_DAY - 1 + i), points[i].value);
+}
+
+/**
+ * @brief Sealed points survive reopening of the store.
+ */
+void HistorianStoreTest::testReopen()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.open();
+
+	fill(store, 2);
+	store.flush();
+
+	const UInt64 usage = store.diskUsage();
+
+	HistorianStore reopened;
+	reopened.setRootDir(testingPath().toString());
+	reopened.open();
+
+	CPPUNIT_ASSERT_EQUAL(2, reopened.partitionCount());
+	CPPUNIT_ASSERT_EQUAL(usage, reopened.diskUsage());
+
+	vector<HistorianStore::Point> points;
+	reopened.query(DEVICE_A, ModuleID(0), Timestamp(0), Timestamp(Timestamp::TIMEVAL_MAX), points);
+
+	CPPUNIT_ASSERT_EQUAL(2 * POINTS_PER_DAY, points.size());
+
+	for (size_t i = 0; i < points.size(); ++i)
+		CPPUNIT_ASSERT_EQUAL(20 + (i % 40) * 0.25, points[i].value);
+}
+
+/**
+ * @brief A partially written block at the end of a partition
+ * (e.g. after power failure) is cut off on open, preceding blocks
+ * and blocks appended after reopening are readable.
+ */
+void HistorianStoreTest::testTruncatedTail()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.setBlockPoints(100);
+	store.open();
+
+	fill(store, 1);
+	store.flush();
+
+	File partition(Path(testingPath(), "0.gts"));
+	partition.setSize(partition.getSize() - 7);
+
+	const UInt64 truncated = partition.getSize();
+
+	HistorianStore reopened;
+	reopened.setRootDir(testingPath().toString());
+	reopened.open();
+
+	CPPUNIT_ASSERT(reopened.diskUsage() < truncated);
+	CPPUNIT_ASSERT_EQUAL(reopened.diskUsage(), partition.getSize());
+
+	vector<HistorianStore::Point> points;
+	reopened.query(DEVICE_B, ModuleID(1), Timestamp(0), Timestamp(Timestamp::TIMEVAL_MAX), points);
+
+	CPPUNIT_ASSERT_EQUAL(200, points.size());
+
+	for (size_t i = 0; i < points.size(); ++i)
+		CPPUNIT_ASSERT_EQUAL(double(i), points[i].value);
+
+	const Timestamp at(POINTS_PER_DAY * INTERVAL.totalMicroseconds() - 1000);
+	reopened.append(DEVICE_B, ModuleID(1), at, -1.0);
+	reopened.flush();
+
+	points.clear();
+	reopened.query(DEVICE_B, ModuleID(1), Timestamp(0), Timestamp(Timestamp::TIMEVAL_MAX), points);
+
+	CPPUNIT_ASSERT_EQUAL(201, points.size());
+	CPPUNIT_ASSERT(points.back().at == at);
+	CPPUNIT_ASSERT_EQUAL(-1.0, points.back().value);
+}
+
+/**
+ * @brief Partitions older than the retention (relative to the newest
+ * point) are dropped and points older than the retention are ignored.
+ */
+void HistorianStoreTest::testRetention()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.setRetention(2 * Timespan::DAYS);
+	store.open();
+
+	fill(store, 4);
+	store.flush();
+
+	CPPUNIT_ASSERT_EQUAL(3, store.partitionCount());
+	CPPUNIT_ASSERT(!File(Path(testingPath(), "0.gts")).exists());
+
+	store.append(DEVICE_A, ModuleID(0), Timestamp(0), 1.0);
+	CPPUNIT_ASSERT_EQUAL(0, store.pendingPoints());
+
+	vector<HistorianStore::Point> points;
+	store.query(DEVICE_B, ModuleID(1), Timestamp(0), Timestamp(Timestamp::TIMEVAL_MAX), points);
+
+	CPPUNIT_ASSERT_EQUAL(3 * POINTS_PER_DAY, points.size());
+	CPPUNIT_ASSERT_EQUAL(double(POINTS_PER_DAY), points.front().value);
+}
+
+/**
+ * @brief The oldest partitions are dropped to fit the size limit,
+ * the current partition is always kept.
+ */
+void HistorianStoreTest::testSizeLimit()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.open();
+
+	fill(store, 1);
+	store.flush();
+
+	const UInt64 daily = store.diskUsage();
+
+	HistorianStore limited;
+	limited.setRootDir(Path(testingPath(), "limited").toString());
+	limited.setSizeLimit(2 * daily + daily / 2);
+	limited.open();
+
+	fill(limited, 5);
+	limited.flush();
+
+	CPPUNIT_ASSERT_EQUAL(2, limited.partitionCount());
+	CPPUNIT_ASSERT(limited.diskUsage() <= 2 * daily + daily / 2);
+
+	limited.setSizeLimit(1);
+	limited.append(DEVICE_A, ModuleID(0), Timestamp(10 * Timespan::DAYS), 1.0);
+	limited.flush();
+
+	CPPUNIT_ASSERT_EQUAL(1, limited.partitionCount());
+
+	vector<HistorianStore::Point> points;
+	limited.query(DEVICE_A, ModuleID(0), Timestamp(0), Timestamp(Timestamp::TIMEVAL_MAX), points);
+
+	CPPUNIT_ASSERT_EQUAL(1, points.size());
+	CPPUNIT_ASSERT(points[0].at == Timestamp(10 * Timespan::DAYS));
+}
+
+/**
+ * @brief Points further than maxFuture ahead of the current time
+ * are rejected.
+ */
+void HistorianStoreTest::testRejectFuture()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.setMaxFuture(1 * Timespan::HOURS);
+	store.open();
+
+	const Timestamp now;
+
+	store.append(DEVICE_A, ModuleID(0), now + 30 * Timespan::MINUTES, 1.0);
+	CPPUNIT_ASSERT_EQUAL(1, store.pendingPoints());
+
+	store.append(DEVICE_A, ModuleID(0), now + 2 * Timespan::HOURS, 2.0);
+	CPPUNIT_ASSERT_EQUAL(1, store.pendingPoints());
+
+	vector<HistorianStore::Point> points;
+	store.query(DEVICE_A, ModuleID(0), Timestamp(0), Timestamp(Timestamp::TIMEVAL_MAX), points);
+
+	CPPUNIT_ASSERT_EQUAL(1, points.size());
+	CPPUNIT_ASSERT_EQUAL(1.0, points[0].value);
+}
+
+/**
+ * @brief Point ahead of the current time does not shift the retention,
+ * it is always relative to a time not later than now.
+ */
+void HistorianStoreTest::testRetentionClampedToNow()
+{
+	HistorianStore store;
+	store.setRootDir(testingPath().toString());
+	store.setRetention(1 * Timespan::HOURS);
+	store.setMaxFuture(1 * Timespan::HOURS);
+	store.open();
+
+	const Timestamp now;
+
+	store.append(DEVICE_A, ModuleID(0), now + 50 * Timespan::MINUTES, 1.0);
+	store.append(DEVICE_A, ModuleID(0), now - 30 * Timespan::MINUTES, 2.0);
+	CPPUNIT_ASSERT_EQUAL(2, store.pendingPoints());
+
+	store.append(DEVICE_A, ModuleID(0), now - 2 * Timespan::HOURS, 3.0);
+	CPPUNIT_ASSERT_EQUAL(2, store.pendingPoints());
+}
+
+}
@@ -0,0 +1,133 @@
+#include <deque>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+
+#include "cppunit/BetterAssert.h"
+#include "fitp/FitpReceiver.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class FitpReceiverTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(FitpReceiverTest);
+	CPPUNIT_TEST(testReceiveBatches);
+	CPPUNIT_TEST(testBuffersReused);
+	CPPUNIT_TEST(testIdleWait);
+	CPPUNIT_TEST(testInvalidSettings);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() override;
+
+	void testReceiveBatches();
+	void testBuffersReused();
+	void testIdleWait();
+	void testInvalidSettings();
+
+private:
+	FitpReceiver::Source source();
+
+	deque<vector<uint8_t>> m_pending;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FitpReceiverTest);
+
+void FitpReceiverTest::setUp()
+{
+	m_pending.clear();
+}
+
+/**
+ * Source behaving as fitp_received_data(), it provides an empty
+ * frame when there is nothing pending.
+ */
+FitpReceiver::Source FitpReceiverTest::source()
+{
+	return [&](vector<uint8_t> &data) {
+		if (m_pending.empty())
+			return;
+
+		data = m_pending.front();
+		m_pending.pop_front();
+	};
+}
+
+void FitpReceiverTest::testReceiveBatches()
+{
+	FitpReceiver receiver(source());
+	receiver.setBatchSize(2);
+
+	m_pending = {{1, 1}, {2, 2, 2}, {3}};
+
+	CPPUNIT_ASSERT_EQUAL(2, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(2, receiver.frame(0).size());
+	CPPUNIT_ASSERT_EQUAL(1, receiver.frame(0)[0]);
+	CPPUNIT_ASSERT_EQUAL(3, receiver.frame(1).size());
+	CPPUNIT_ASSERT_EQUAL(2, receiver.frame(1)[0]);
+	CPPUNIT_ASSERT_EQUAL(0, receiver.idleWait().totalMicroseconds());
+
+	CPPUNIT_ASSERT_EQUAL(1, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(1, receiver.frame(0).size());
+	CPPUNIT_ASSERT_EQUAL(3, receiver.frame(0)[0]);
+	CPPUNIT_ASSERT_THROW(receiver.frame(1), RangeException);
+
+	CPPUNIT_ASSERT_EQUAL(0, receiver.receive());
+	CPPUNIT_ASSERT_THROW(receiver.frame(0), RangeException);
+}
+
+void FitpReceiverTest::testBuffersReused()
+{
+	FitpReceiver receiver(source());
+	receiver.setBatchSize(1);
+
+	m_pending = {vector<uint8_t>(64, 0xaa), vector<uint8_t>(32, 0x55)};
+
+	CPPUNIT_ASSERT_EQUAL(1, receiver.receive());
+	const uint8_t *buffer = receiver.frame(0).data();
+
+	CPPUNIT_ASSERT_EQUAL(1, receiver.receive());
+	CPPUNIT_ASSERT(buffer == receiver.frame(0).data());
+	CPPUNIT_ASSERT_EQUAL(32, receiver.frame(0).size());
+	CPPUNIT_ASSERT_EQUAL(0x55, receiver.frame(0)[31]);
+}
+
+void FitpReceiverTest::testIdleWait()
+{
+	FitpReceiver receiver(source());
+	receiver.setMaxIdleWait(5 * Timespan::MILLISECONDS);
+
+	CPPUNIT_ASSERT_EQUAL(0, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(1, receiver.idleWait().totalMilliseconds());
+	CPPUNIT_ASSERT_EQUAL(0, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(2, receiver.idleWait().totalMilliseconds());
+	CPPUNIT_ASSERT_EQUAL(0, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(4, receiver.idleWait().totalMilliseconds());
+	CPPUNIT_ASSERT_EQUAL(0, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(5, receiver.idleWait().totalMilliseconds());
+	CPPUNIT_ASSERT_EQUAL(0, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(5, receiver.idleWait().totalMilliseconds());
+
+	m_pending = {{1}};
+
+	CPPUNIT_ASSERT_EQUAL(1, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(0, receiver.idleWait().totalMicroseconds());
+
+	CPPUNIT_ASSERT_EQUAL(0, receiver.receive());
+	CPPUNIT_ASSERT_EQUAL(1, receiver.idleWait().totalMilliseconds());
+}
+
+void FitpReceiverTest::testInvalidSettings()
+{
+	FitpReceiver receiver(source());
+
+	CPPUNIT_ASSERT_THROW(receiver.setBatchSize(0), InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(receiver.setBatchSize(-1), InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(receiver.setMaxIdleWait(0), InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(
+		receiver.setMaxIdleWait(500 * Timespan::MICROSECONDS),
+		InvalidArgumentException);
+}
+
+}
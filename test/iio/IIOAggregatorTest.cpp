@@ -0,0 +1,85 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+
+#include "cppunit/BetterAssert.h"
+#include "iio/IIOAggregator.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class IIOAggregatorTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(IIOAggregatorTest);
+	CPPUNIT_TEST(testEmpty);
+	CPPUNIT_TEST(testModes);
+	CPPUNIT_TEST(testReset);
+	CPPUNIT_TEST(testParseMode);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testEmpty();
+	void testModes();
+	void testReset();
+	void testParseMode();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IIOAggregatorTest);
+
+void IIOAggregatorTest::testEmpty()
+{
+	IIOAggregator aggregator;
+
+	CPPUNIT_ASSERT(aggregator.empty());
+	CPPUNIT_ASSERT_EQUAL(0, aggregator.count());
+	CPPUNIT_ASSERT_THROW(aggregator.value(), IllegalStateException);
+}
+
+void IIOAggregatorTest::testModes()
+{
+	IIOAggregator last(IIOAggregator::LAST);
+	IIOAggregator mean(IIOAggregator::MEAN);
+	IIOAggregator min(IIOAggregator::MIN);
+	IIOAggregator max(IIOAggregator::MAX);
+
+	for (const double value : {3.0, -1.0, 7.0, 1.0}) {
+		last.add(value);
+		mean.add(value);
+		min.add(value);
+		max.add(value);
+	}
+
+	CPPUNIT_ASSERT_EQUAL(4, mean.count());
+	CPPUNIT_ASSERT_EQUAL(1.0, last.value());
+	CPPUNIT_ASSERT_EQUAL(2.5, mean.value());
+	CPPUNIT_ASSERT_EQUAL(-1.0, min.value());
+	CPPUNIT_ASSERT_EQUAL(7.0, max.value());
+}
+
+void IIOAggregatorTest::testReset()
+{
+	IIOAggregator aggregator(IIOAggregator::MIN);
+
+	aggregator.add(-5);
+	aggregator.add(5);
+	CPPUNIT_ASSERT_EQUAL(-5.0, aggregator.value());
+
+	aggregator.reset();
+	CPPUNIT_ASSERT(aggregator.empty());
+
+	aggregator.add(10);
+	aggregator.add(20);
+	CPPUNIT_ASSERT_EQUAL(10.0, aggregator.value());
+	CPPUNIT_ASSERT_EQUAL(15.0, aggregator.mean());
+}
+
+void IIOAggregatorTest::testParseMode()
+{
+	CPPUNIT_ASSERT(IIOAggregator::parseMode("last") == IIOAggregator::LAST);
+	CPPUNIT_ASSERT(IIOAggregator::parseMode("mean") == IIOAggregator::MEAN);
+	CPPUNIT_ASSERT(IIOAggregator::parseMode("min") == IIOAggregator::MIN);
+	CPPUNIT_ASSERT(IIOAggregator::parseMode("max") == IIOAggregator::MAX);
+	CPPUNIT_ASSERT_THROW(IIOAggregator::parseMode("median"), InvalidArgumentException);
+}
+
+}
@@ -0,0 +1,243 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+#include <Poco/File.h>
+#include <Poco/FileStream.h>
+
+#include "cppunit/BetterAssert.h"
+#include "cppunit/FileTestFixture.h"
+#include "iio/IIODevice.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class IIODeviceTest : public FileTestFixture {
+	CPPUNIT_TEST_SUITE(IIODeviceTest);
+	CPPUNIT_TEST(testChannelType);
+	CPPUNIT_TEST(testLoad);
+	CPPUNIT_TEST(testLoadLabel);
+	CPPUNIT_TEST(testEnableBuffer);
+	CPPUNIT_TEST(testEnableBufferNoChannel);
+	CPPUNIT_TEST(testValue);
+	CPPUNIT_TEST(testDiscover);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() override;
+
+	void testChannelType();
+	void testLoad();
+	void testLoadLabel();
+	void testEnableBuffer();
+	void testEnableBufferNoChannel();
+	void testValue();
+	void testDiscover();
+
+private:
+	void createAttribute(const string &name, const string &value);
+	string readAttribute(const string &name);
+
+	Path m_sysfs;
+	Path m_dev;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IIODeviceTest);
+
+/**
+ * Create a fake sysfs tree of a BMP280-like device with channels
+ * temperature (index 0), pressure (index 1) and timestamp (index 2).
+ * Only the timestamp is initially enabled.
+ */
+void IIODeviceTest::setUp()
+{
+	setUpAsDirectory();
+
+	m_sysfs = Path(testingPath(), "sys/");
+	m_dev = Path(testingPath(), "dev/");
+	File(m_dev).createDirectories();
+
+	createAttribute("iio:device0/name", "bmp280\n");
+	createAttribute("iio:device0/in_temp_scale", "10\n");
+	createAttribute("iio:device0/in_pressure_scale", "0.001\n");
+	createAttribute("iio:device0/in_pressure_offset", "100\n");
+	createAttribute("iio:device0/scan_elements/in_temp_en", "0\n");
+	createAttribute("iio:device0/scan_elements/in_temp_index", "0\n");
+	createAttribute("iio:device0/scan_elements/in_temp_type", "le:s16/16>>0\n");
+	createAttribute("iio:device0/scan_elements/in_pressure_en", "0\n");
+	createAttribute("iio:device0/scan_elements/in_pressure_index", "1\n");
+	createAttribute("iio:device0/scan_elements/in_pressure_type", "le:u32/32>>0\n");
+	createAttribute("iio:device0/scan_elements/in_timestamp_en", "1\n");
+	createAttribute("iio:device0/scan_elements/in_timestamp_index", "2\n");
+	createAttribute("iio:device0/scan_elements/in_timestamp_type", "le:s64/64>>0\n");
+	createAttribute("iio:device0/buffer/enable", "0\n");
+	createAttribute("iio:device0/buffer/length", "2\n");
+	createAttribute("iio:device0/trigger/current_trigger", "\n");
+
+	// device without buffered interface
+	createAttribute("iio:device1/name", "adc\n");
+	// triggers are listed among devices as well
+	createAttribute("trigger0/name", "sysfstrig0\n");
+}
+
+void IIODeviceTest::createAttribute(const string &name, const string &value)
+{
+	const Path path(m_sysfs, name);
+	File(path.parent()).createDirectories();
+
+	FileOutputStream output(path.toString());
+	output << value;
+}
+
+string IIODeviceTest::readAttribute(const string &name)
+{
+	FileInputStream input(Path(m_sysfs, name).toString());
+	string value;
+
+	getline(input, value);
+	return value;
+}
+
+void IIODeviceTest::testChannelType()
+{
+	CPPUNIT_ASSERT_EQUAL("pressure", IIODevice::channelType("in_pressure"));
+	CPPUNIT_ASSERT_EQUAL("voltage", IIODevice::channelType("in_voltage12"));
+	CPPUNIT_ASSERT_EQUAL("humidityrelative", IIODevice::channelType("in_humidityrelative"));
+	CPPUNIT_ASSERT_EQUAL("current", IIODevice::channelType("out_current1"));
+}
+
+void IIODeviceTest::testLoad()
+{
+	IIODevice device(Path(m_sysfs, "iio:device0"), Path(m_dev, "iio:device0"));
+	device.load();
+
+	CPPUNIT_ASSERT_EQUAL("bmp280", device.name());
+	CPPUNIT_ASSERT(device.label().empty());
+
+	const auto &channels = device.channels();
+	CPPUNIT_ASSERT_EQUAL(3, channels.size());
+
+	CPPUNIT_ASSERT_EQUAL("in_temp", channels[0].name);
+	CPPUNIT_ASSERT_EQUAL("temp", channels[0].type);
+	CPPUNIT_ASSERT_EQUAL(0, channels[0].index);
+	CPPUNIT_ASSERT_EQUAL(10.0, channels[0].scale);
+	CPPUNIT_ASSERT_EQUAL(0.0, channels[0].offset);
+	CPPUNIT_ASSERT(!channels[0].enabled);
+
+	CPPUNIT_ASSERT_EQUAL("in_pressure", channels[1].name);
+	CPPUNIT_ASSERT_EQUAL("pressure", channels[1].type);
+	CPPUNIT_ASSERT_EQUAL(1, channels[1].index);
+	CPPUNIT_ASSERT_EQUAL(0.001, channels[1].scale);
+	CPPUNIT_ASSERT_EQUAL(100.0, channels[1].offset);
+	CPPUNIT_ASSERT_EQUAL("le:u32/32>>0", channels[1].scanType.toString());
+	CPPUNIT_ASSERT(!channels[1].enabled);
+
+	CPPUNIT_ASSERT_EQUAL("in_timestamp", channels[2].name);
+	CPPUNIT_ASSERT(channels[2].enabled);
+	CPPUNIT_ASSERT_EQUAL(0, channels[2].position);
+
+	CPPUNIT_ASSERT_EQUAL(8, device.sampleSize());
+}
+
+/**
+ * Enabling of temperature and pressure must update the scan elements
+ * and the buffer attributes. The pressure value is aligned to 4 bytes.
+ */
+/**
+ * The optional label is read together with the name as both
+ * identify the device independently of its sysfs index.
+ */
+void IIODeviceTest::testLoadLabel()
+{
+	createAttribute("iio:device0/label", "outdoor\n");
+
+	IIODevice device(Path(m_sysfs, "iio:device0"), Path(m_dev, "iio:device0"));
+	device.load();
+
+	CPPUNIT_ASSERT_EQUAL("bmp280", device.name());
+	CPPUNIT_ASSERT_EQUAL("outdoor", device.label());
+}
+
+void IIODeviceTest::testEnableBuffer()
+{
+	IIODevice device(Path(m_sysfs, "iio:device0"), Path(m_dev, "iio:device0"));
+	device.load();
+
+	device.enableBuffer({"in_temp", "in_pressure"}, "sysfstrig0", 16);
+
+	CPPUNIT_ASSERT_EQUAL("1", readAttribute("iio:device0/scan_elements/in_temp_en"));
+	CPPUNIT_ASSERT_EQUAL("1", readAttribute("iio:device0/scan_elements/in_pressure_en"));
+	CPPUNIT_ASSERT_EQUAL("0", readAttribute("iio:device0/scan_elements/in_timestamp_en"));
+	CPPUNIT_ASSERT_EQUAL("sysfstrig0", readAttribute("iio:device0/trigger/current_trigger"));
+	CPPUNIT_ASSERT_EQUAL("16", readAttribute("iio:device0/buffer/length"));
+	CPPUNIT_ASSERT_EQUAL("1", readAttribute("iio:device0/buffer/enable"));
+
+	const auto &channels = device.channels();
+	CPPUNIT_ASSERT_EQUAL(0, channels[0].position);
+	CPPUNIT_ASSERT_EQUAL(4, channels[1].position);
+	CPPUNIT_ASSERT_EQUAL(8, device.sampleSize());
+
+	device.enableBuffer({"in_temp", "in_timestamp"}, "", 4);
+
+	CPPUNIT_ASSERT_EQUAL("0", readAttribute("iio:device0/scan_elements/in_pressure_en"));
+	CPPUNIT_ASSERT_EQUAL("1", readAttribute("iio:device0/scan_elements/in_timestamp_en"));
+	CPPUNIT_ASSERT_EQUAL("sysfstrig0", readAttribute("iio:device0/trigger/current_trigger"));
+	CPPUNIT_ASSERT_EQUAL("4", readAttribute("iio:device0/buffer/length"));
+	CPPUNIT_ASSERT_EQUAL(8, channels[2].position);
+	CPPUNIT_ASSERT_EQUAL(16, device.sampleSize());
+
+	device.disableBuffer();
+	CPPUNIT_ASSERT_EQUAL("0", readAttribute("iio:device0/buffer/enable"));
+}
+
+void IIODeviceTest::testEnableBufferNoChannel()
+{
+	IIODevice device(Path(m_sysfs, "iio:device0"), Path(m_dev, "iio:device0"));
+	device.load();
+
+	CPPUNIT_ASSERT_THROW(
+		device.enableBuffer({"in_humidityrelative"}, "", 16),
+		IllegalStateException);
+	CPPUNIT_ASSERT_THROW(
+		device.enableBuffer({"in_temp"}, "", 0),
+		InvalidArgumentException);
+
+	CPPUNIT_ASSERT_EQUAL("0", readAttribute("iio:device0/buffer/enable"));
+}
+
+/**
+ * Decode a sample as it would be read from /dev/iio:device0.
+ */
+void IIODeviceTest::testValue()
+{
+	IIODevice device(Path(m_sysfs, "iio:device0"), Path(m_dev, "iio:device0"));
+	device.load();
+	device.enableBuffer({"in_temp", "in_pressure"}, "", 16);
+
+	const uint8_t sample[] = {
+		0x2a, 0xf8,             // temp: -2006
+		0x00, 0x00,             // padding
+		0xa0, 0x86, 0x01, 0x00, // pressure: 100000
+	};
+
+	const auto &channels = device.channels();
+	CPPUNIT_ASSERT_EQUAL(-20060.0, channels[0].value(sample));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(100.1, channels[1].value(sample), 0.000001);
+}
+
+void IIODeviceTest::testDiscover()
+{
+	const auto devices = IIODevice::discover(m_sysfs, m_dev);
+
+	CPPUNIT_ASSERT_EQUAL(1, devices.size());
+	CPPUNIT_ASSERT_EQUAL(
+		Path(m_sysfs, "iio:device0/").toString(),
+		devices[0].sysfs().toString());
+	CPPUNIT_ASSERT_EQUAL(
+		Path(m_dev, "iio:device0").toString(),
+		devices[0].node().toString());
+
+	CPPUNIT_ASSERT(IIODevice::discover(Path(m_sysfs, "missing/"), m_dev).empty());
+}
+
+}
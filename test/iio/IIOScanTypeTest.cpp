@@ -0,0 +1,102 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+
+#include "cppunit/BetterAssert.h"
+#include "iio/IIOScanType.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class IIOScanTypeTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(IIOScanTypeTest);
+	CPPUNIT_TEST(testParse);
+	CPPUNIT_TEST(testParseRepeat);
+	CPPUNIT_TEST(testParseInvalid);
+	CPPUNIT_TEST(testDecodeUnsigned);
+	CPPUNIT_TEST(testDecodeSigned);
+	CPPUNIT_TEST(testDecodeBigEndian);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testParse();
+	void testParseRepeat();
+	void testParseInvalid();
+	void testDecodeUnsigned();
+	void testDecodeSigned();
+	void testDecodeBigEndian();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IIOScanTypeTest);
+
+void IIOScanTypeTest::testParse()
+{
+	const IIOScanType type = IIOScanType::parse("le:s12/16>>4\n");
+
+	CPPUNIT_ASSERT(!type.bigEndian);
+	CPPUNIT_ASSERT(type.isSigned);
+	CPPUNIT_ASSERT_EQUAL(12, type.bits);
+	CPPUNIT_ASSERT_EQUAL(16, type.storageBits);
+	CPPUNIT_ASSERT_EQUAL(4, type.shift);
+	CPPUNIT_ASSERT_EQUAL(1, type.repeat);
+	CPPUNIT_ASSERT_EQUAL(2, type.storageBytes());
+	CPPUNIT_ASSERT_EQUAL(2, type.length());
+	CPPUNIT_ASSERT_EQUAL("le:s12/16>>4", type.toString());
+}
+
+void IIOScanTypeTest::testParseRepeat()
+{
+	const IIOScanType type = IIOScanType::parse("be:u16/16X3>>0");
+
+	CPPUNIT_ASSERT(type.bigEndian);
+	CPPUNIT_ASSERT(!type.isSigned);
+	CPPUNIT_ASSERT_EQUAL(3, type.repeat);
+	CPPUNIT_ASSERT_EQUAL(2, type.storageBytes());
+	CPPUNIT_ASSERT_EQUAL(6, type.length());
+	CPPUNIT_ASSERT_EQUAL("be:u16/16X3>>0", type.toString());
+}
+
+void IIOScanTypeTest::testParseInvalid()
+{
+	CPPUNIT_ASSERT_THROW(IIOScanType::parse(""), SyntaxException);
+	CPPUNIT_ASSERT_THROW(IIOScanType::parse("me:s12/16>>4"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(IIOScanType::parse("le:x12/16>>4"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(IIOScanType::parse("le:s12/16"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(IIOScanType::parse("le:s12/12>>0"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(IIOScanType::parse("le:s16/16>>4"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(IIOScanType::parse("le:s0/16>>0"), SyntaxException);
+	CPPUNIT_ASSERT_THROW(IIOScanType::parse("le:u8/8X0>>0"), SyntaxException);
+}
+
+void IIOScanTypeTest::testDecodeUnsigned()
+{
+	const uint8_t data[] = {0x78, 0x56, 0x34, 0x12};
+
+	CPPUNIT_ASSERT_EQUAL(0x12345678, IIOScanType::parse("le:u32/32>>0").decode(data));
+	CPPUNIT_ASSERT_EQUAL(0x5678, IIOScanType::parse("le:u16/16>>0").decode(data));
+	CPPUNIT_ASSERT_EQUAL(0x567, IIOScanType::parse("le:u12/16>>4").decode(data));
+	CPPUNIT_ASSERT_EQUAL(0x78, IIOScanType::parse("le:u8/8>>0").decode(data));
+}
+
+void IIOScanTypeTest::testDecodeSigned()
+{
+	const uint8_t minusOne[] = {0xf0, 0xff};
+	const uint8_t minusTwo[] = {0xfe, 0xff, 0xff, 0xff};
+	const uint8_t positive[] = {0xf0, 0x07};
+
+	CPPUNIT_ASSERT_EQUAL(-1, IIOScanType::parse("le:s12/16>>4").decode(minusOne));
+	CPPUNIT_ASSERT_EQUAL(-2, IIOScanType::parse("le:s32/32>>0").decode(minusTwo));
+	CPPUNIT_ASSERT_EQUAL(0x7f, IIOScanType::parse("le:s12/16>>4").decode(positive));
+	CPPUNIT_ASSERT_EQUAL(0xfff, IIOScanType::parse("le:u12/16>>4").decode(minusOne));
+}
+
+void IIOScanTypeTest::testDecodeBigEndian()
+{
+	const uint8_t data[] = {0x01, 0x02, 0x03, 0x00};
+
+	CPPUNIT_ASSERT_EQUAL(0x010203, IIOScanType::parse("be:u24/32>>8").decode(data));
+	CPPUNIT_ASSERT_EQUAL(0x0102, IIOScanType::parse("be:s16/16>>0").decode(data));
+}
+
+}
@@ -0,0 +1,93 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cppunit/BetterAssert.h"
+#include "io/SerialFraming.h"
+
+using namespace std;
+
+namespace BeeeOn {
+
+class SerialFramingTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(SerialFramingTest);
+	CPPUNIT_TEST(testDelimited);
+	CPPUNIT_TEST(testDelimitedIncomplete);
+	CPPUNIT_TEST(testDelimitedCustom);
+	CPPUNIT_TEST(testRaw);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testDelimited();
+	void testDelimitedIncomplete();
+	void testDelimitedCustom();
+	void testRaw();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SerialFramingTest);
+
+void SerialFramingTest::testDelimited()
+{
+	DelimitedSerialFraming framing;
+	string buffer = "\nTURRIS DONGLE V1.4\n\n[12345678] JA-81M SENSOR LB:0 ACT:1\n";
+	string frame;
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("TURRIS DONGLE V1.4", frame);
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("[12345678] JA-81M SENSOR LB:0 ACT:1", frame);
+
+	CPPUNIT_ASSERT(!framing.extract(buffer, frame));
+	CPPUNIT_ASSERT(buffer.empty());
+}
+
+/**
+ * An incomplete frame must be kept in the buffer until the rest
+ * of it is received.
+ */
+void SerialFramingTest::testDelimitedIncomplete()
+{
+	DelimitedSerialFraming framing;
+	string buffer = "\n\nOK\nERR";
+	string frame;
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("OK", frame);
+
+	CPPUNIT_ASSERT(!framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("ERR", buffer);
+
+	buffer += "OR\n";
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("ERROR", frame);
+	CPPUNIT_ASSERT(buffer.empty());
+}
+
+void SerialFramingTest::testDelimitedCustom()
+{
+	DelimitedSerialFraming framing(';');
+	string buffer = "a;b\nc;";
+	string frame;
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("a", frame);
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("b\nc", frame);
+
+	CPPUNIT_ASSERT(!framing.extract(buffer, frame));
+}
+
+void SerialFramingTest::testRaw()
+{
+	RawSerialFraming framing;
+	string buffer = "\x01\x02\n";
+	string frame;
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("\x01\x02\n", frame);
+	CPPUNIT_ASSERT(buffer.empty());
+
+	CPPUNIT_ASSERT(!framing.extract(buffer, frame));
+}
+
+}
@@ -0,0 +1,398 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/AtomicCounter.h>
+#include <Poco/Event.h>
+#include <Poco/Exception.h>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "io/SerialReactor.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+/**
+ * Tests of SerialReactor that simulate serial ports by pseudo
+ * terminals. The test writes into (and reads from) the master side
+ * while the reactor uses the slave side as a serial port.
+ */
+class SerialReactorTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(SerialReactorTest);
+	CPPUNIT_TEST(testReceiveFrames);
+	CPPUNIT_TEST(testFrameSplitAcrossReads);
+	CPPUNIT_TEST(testWrite);
+	CPPUNIT_TEST(testMultiplePorts);
+	CPPUNIT_TEST(testHangup);
+	CPPUNIT_TEST(testClose);
+	CPPUNIT_TEST(testCloseWaitsForHandler);
+	CPPUNIT_TEST(testCloseFromHandler);
+	CPPUNIT_TEST(testOpenMissing);
+	CPPUNIT_TEST(testUnsupportedSettings);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() override;
+	void tearDown() override;
+
+	void testReceiveFrames();
+	void testFrameSplitAcrossReads();
+	void testWrite();
+	void testMultiplePorts();
+	void testHangup();
+	void testClose();
+	void testCloseWaitsForHandler();
+	void testCloseFromHandler();
+	void testOpenMissing();
+	void testUnsupportedSettings();
+
+private:
+	/**
+	 * Open a pseudo terminal and return its master side.
+	 * The path to the slave side is stored into slave.
+	 */
+	int openMaster(string &slave);
+	void writeMaster(int master, const string &data);
+	string readMaster(int master, size_t size);
+
+	SerialChannel::Ptr open(const string &slave, const string &tag);
+
+	/**
+	 * Wait until the given number of frames is received.
+	 */
+	bool waitFrames(size_t count);
+
+	SerialReactor::Ptr m_reactor;
+	Thread m_thread;
+	vector<int> m_masters;
+
+	FastMutex m_lock;
+	vector<string> m_frames;
+	vector<string> m_errors;
+	Event m_event;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SerialReactorTest);
+
+static const long WAIT_MS = 1000;
+
+void SerialReactorTest::setUp()
+{
+	m_frames.clear();
+	m_errors.clear();
+	m_event.reset();
+
+	m_reactor = new SerialReactor;
+	m_thread.start(*m_reactor);
+}
+
+void SerialReactorTest::tearDown()
+{
+	m_reactor->stop();
+	m_thread.join();
+	m_reactor = nullptr;
+
+	for (const auto master : m_masters)
+		::close(master);
+
+	m_masters.clear();
+}
+
+int SerialReactorTest::openMaster(string &slave)
+{
+	const int master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+	CPPUNIT_ASSERT(master >= 0);
+
+	m_masters.push_back(master);
+
+	CPPUNIT_ASSERT_EQUAL(0, ::grantpt(master));
+	CPPUNIT_ASSERT_EQUAL(0, ::unlockpt(master));
+
+	slave = ::ptsname(master);
+	return master;
+}
+
+void SerialReactorTest::writeMaster(int master, const string &data)
+{
+	CPPUNIT_ASSERT_EQUAL(
+		ssize_t(data.size()),
+		::write(master, data.data(), data.size()));
+}
+
+string SerialReactorTest::readMaster(int master, size_t size)
+{
+	string data;
+	char buffer[64];
+
+	while (data.size() < size) {
+		struct pollfd pfd = {master, POLLIN, 0};
+		if (::poll(&pfd, 1, WAIT_MS) <= 0)
+			break;
+
+		const ssize_t ret = ::read(master, buffer, sizeof(buffer));
+		if (ret <= 0)
+			break;
+
+		data.append(buffer, ret);
+	}
+
+	return data;
+}
+
+SerialChannel::Ptr SerialReactorTest::open(const string &slave, const string &tag)
+{
+	return m_reactor->open(
+		slave,
+		SerialChannel::Settings(57600),
+		new DelimitedSerialFraming('\n'),
+		[this, tag](const string &frame) {
+			FastMutex::ScopedLock guard(m_lock);
+			m_frames.emplace_back(tag + frame);
+			m_event.set();
+		},
+		[this, tag](const Exception &e) {
+			FastMutex::ScopedLock guard(m_lock);
+			m_errors.emplace_back(tag + e.name());
+			m_event.set();
+		});
+}
+
+bool SerialReactorTest::waitFrames(size_t count)
+{
+	while (true) {
+		{
+			FastMutex::ScopedLock guard(m_lock);
+			if (m_frames.size() >= count)
+				return true;
+		}
+
+		if (!m_event.tryWait(WAIT_MS))
+			return false;
+	}
+}
+
+void SerialReactorTest::testReceiveFrames()
+{
+	string slave;
+	const int master = openMaster(slave);
+
+	SerialChannel::Ptr channel = open(slave, "");
+	CPPUNIT_ASSERT_EQUAL(1, m_reactor->count());
+	CPPUNIT_ASSERT_EQUAL(slave, channel->name());
+
+	writeMaster(master, "\nTURRIS DONGLE V1.4\n\n[12345678] JA-81M SENSOR LB:0 ACT:1\n");
+
+	CPPUNIT_ASSERT(waitFrames(2));
+
+	FastMutex::ScopedLock guard(m_lock);
+	CPPUNIT_ASSERT_EQUAL(2, m_frames.size());
+	CPPUNIT_ASSERT_EQUAL("TURRIS DONGLE V1.4", m_frames[0]);
+	CPPUNIT_ASSERT_EQUAL("[12345678] JA-81M SENSOR LB:0 ACT:1", m_frames[1]);
+	CPPUNIT_ASSERT_EQUAL(2, channel->receivedFrames());
+	CPPUNIT_ASSERT_EQUAL(57, channel->receivedBytes());
+}
+
+void SerialReactorTest::testFrameSplitAcrossReads()
+{
+	string slave;
+	const int master = openMaster(slave);
+
+	open(slave, "");
+
+	writeMaster(master, "\nWHO AM");
+	CPPUNIT_ASSERT(!waitFrames(1));
+
+	writeMaster(master, " I?\n");
+	CPPUNIT_ASSERT(waitFrames(1));
+
+	FastMutex::ScopedLock guard(m_lock);
+	CPPUNIT_ASSERT_EQUAL(1, m_frames.size());
+	CPPUNIT_ASSERT_EQUAL("WHO AM I?", m_frames[0]);
+}
+
+void SerialReactorTest::testWrite()
+{
+	string slave;
+	const int master = openMaster(slave);
+
+	SerialChannel::Ptr channel = open(slave, "");
+
+	channel->write("\x1BWHO AM I?\n", 1 * Timespan::SECONDS);
+	CPPUNIT_ASSERT_EQUAL("\x1BWHO AM I?\n", readMaster(master, 11));
+}
+
+/**
+ * All ports are served by a single reactor thread and frames
+ * are delivered to the handlers of the appropriate channels.
+ */
+void SerialReactorTest::testMultiplePorts()
+{
+	string slaveA;
+	string slaveB;
+	const int masterA = openMaster(slaveA);
+	const int masterB = openMaster(slaveB);
+
+	open(slaveA, "A:");
+	open(slaveB, "B:");
+	CPPUNIT_ASSERT_EQUAL(2, m_reactor->count());
+
+	writeMaster(masterA, "first\n");
+	CPPUNIT_ASSERT(waitFrames(1));
+
+	writeMaster(masterB, "second\n");
+	CPPUNIT_ASSERT(waitFrames(2));
+
+	writeMaster(masterA, "third\n");
+	CPPUNIT_ASSERT(waitFrames(3));
+
+	FastMutex::ScopedLock guard(m_lock);
+	CPPUNIT_ASSERT_EQUAL(3, m_frames.size());
+	CPPUNIT_ASSERT_EQUAL("A:first", m_frames[0]);
+	CPPUNIT_ASSERT_EQUAL("B:second", m_frames[1]);
+	CPPUNIT_ASSERT_EQUAL("A:third", m_frames[2]);
+}
+
+/**
+ * Closing the master side simulates unplugging of the dongle.
+ * The channel is unregistered and the error handler is called.
+ */
+void SerialReactorTest::testHangup()
+{
+	string slave;
+	const int master = openMaster(slave);
+
+	SerialChannel::Ptr channel = open(slave, "");
+
+	m_masters.clear();
+	::close(master);
+
+	for (int i = 0; i < 100 && m_reactor->count() > 0; ++i)
+		Thread::sleep(10);
+
+	CPPUNIT_ASSERT_EQUAL(0, m_reactor->count());
+	CPPUNIT_ASSERT(!channel->isOpen());
+
+	FastMutex::ScopedLock guard(m_lock);
+	CPPUNIT_ASSERT_EQUAL(1, m_errors.size());
+	CPPUNIT_ASSERT_EQUAL(string(IOException().name()), m_errors[0]);
+}
+
+void SerialReactorTest::testClose()
+{
+	string slave;
+	const int master = openMaster(slave);
+
+	SerialChannel::Ptr channel = open(slave, "");
+
+	m_reactor->close(channel);
+	CPPUNIT_ASSERT_EQUAL(0, m_reactor->count());
+	CPPUNIT_ASSERT(!channel->isOpen());
+
+	writeMaster(master, "ignored\n");
+	CPPUNIT_ASSERT(!waitFrames(1));
+
+	CPPUNIT_ASSERT_THROW(
+		channel->write("data", 1 * Timespan::SECONDS),
+		IllegalStateException);
+
+	FastMutex::ScopedLock guard(m_lock);
+	CPPUNIT_ASSERT(m_errors.empty());
+}
+
+/**
+ * Closing a channel whose frame handler is running in the reactor
+ * thread must wait until the handler returns, otherwise the handler
+ * could access an already destroyed owner of the channel.
+ */
+void SerialReactorTest::testCloseWaitsForHandler()
+{
+	string slave;
+	const int master = openMaster(slave);
+
+	Event entered;
+	AtomicCounter finished;
+
+	SerialChannel::Ptr channel = m_reactor->open(
+		slave,
+		SerialChannel::Settings(57600),
+		new DelimitedSerialFraming('\n'),
+		[&](const string &) {
+			entered.set();
+			Thread::sleep(200);
+			++finished;
+		});
+
+	writeMaster(master, "slow\n");
+	CPPUNIT_ASSERT(entered.tryWait(WAIT_MS));
+
+	m_reactor->close(channel);
+	CPPUNIT_ASSERT_EQUAL(1, finished.value());
+	CPPUNIT_ASSERT_EQUAL(0, m_reactor->count());
+}
+
+/**
+ * A handler can close its own channel without blocking the reactor.
+ */
+void SerialReactorTest::testCloseFromHandler()
+{
+	string slave;
+	const int master = openMaster(slave);
+
+	SerialChannel::Ptr channel;
+
+	channel = m_reactor->open(
+		slave,
+		SerialChannel::Settings(57600),
+		new DelimitedSerialFraming('\n'),
+		[&](const string &frame) {
+			m_reactor->close(channel);
+
+			FastMutex::ScopedLock guard(m_lock);
+			m_frames.emplace_back(frame);
+			m_event.set();
+		});
+
+	writeMaster(master, "bye\n");
+	CPPUNIT_ASSERT(waitFrames(1));
+
+	CPPUNIT_ASSERT_EQUAL(0, m_reactor->count());
+	CPPUNIT_ASSERT(!channel->isOpen());
+}
+
+void SerialReactorTest::testOpenMissing()
+{
+	CPPUNIT_ASSERT_THROW(
+		open("/dev/non-existing-serial-port", ""),
+		IOException);
+
+	CPPUNIT_ASSERT_EQUAL(0, m_reactor->count());
+}
+
+void SerialReactorTest::testUnsupportedSettings()
+{
+	string slave;
+	openMaster(slave);
+
+	CPPUNIT_ASSERT_THROW(
+		SerialChannel::openPort(slave, SerialChannel::Settings(12345)),
+		InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(
+		SerialChannel::openPort(slave, SerialChannel::Settings(9600, 9)),
+		InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(
+		SerialChannel::openPort(slave, SerialChannel::Settings(
+			9600, 8, SerialChannel::PARITY_NONE, 3)),
+		InvalidArgumentException);
+}
+
+}
@@ -14,15 +14,23 @@ namespace BeeeOn {
 class JablotronGadgetTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(JablotronGadgetTest);
 	CPPUNIT_TEST(testResolve);
+	CPPUNIT_TEST(testResolveUnknown);
 	CPPUNIT_TEST(testToString);
 	CPPUNIT_TEST(testPrimary);
 	CPPUNIT_TEST(testSecondary);
+	CPPUNIT_TEST(testParseJA81M);
+	CPPUNIT_TEST(testParseRC86K);
+	CPPUNIT_TEST(testParseTP82N);
 	CPPUNIT_TEST_SUITE_END();
 public:
 	void testResolve();
+	void testResolveUnknown();
 	void testToString();
 	void testPrimary();
 	void testSecondary();
+	void testParseJA81M();
+	void testParseRC86K();
+	void testParseTP82N();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(JablotronGadgetTest);
@@ -75,6 +83,20 @@ void JablotronGadgetTest::testResolve()
 	CPPUNIT_ASSERT_EQUAL("TP-82N", JablotronGadget::Info::resolve(2490367).name());
 }
 
+void JablotronGadgetTest::testResolveUnknown()
+{
+	CPPUNIT_ASSERT(!JablotronGadget::Info::resolve(0));
+	CPPUNIT_ASSERT(!JablotronGadget::Info::resolve(1572863));
+	CPPUNIT_ASSERT(!JablotronGadget::Info::resolve(1966080));
+	CPPUNIT_ASSERT(!JablotronGadget::Info::resolve(5898240));
+	CPPUNIT_ASSERT(!JablotronGadget::Info::resolve(13565951));
+	CPPUNIT_ASSERT(!JablotronGadget::Info::resolve(13631488));
+	CPPUNIT_ASSERT(!JablotronGadget::Info::resolve(0xffffffff));
+
+	CPPUNIT_ASSERT_EQUAL(JablotronGadget::NONE, JablotronGadget::Info::resolve(0).type);
+	CPPUNIT_ASSERT(JablotronGadget::Info::resolve(0).modules.empty());
+}
+
 void JablotronGadgetTest::testToString()
 {
 	JablotronGadget ac88   = {0, 13565952, JablotronGadget::Info::resolve(13565952)};
@@ -134,4 +156,68 @@ void JablotronGadgetTest::testSecondary()
 	CPPUNIT_ASSERT_EQUAL( 9961471, JablotronGadget::Info::secondaryAddress(8912895));
 }
 
+void JablotronGadgetTest::testParseJA81M()
+{
+	const auto &info = JablotronGadget::Info::resolve(1572864);
+
+	const auto values0 = info.parse({1572864, "JA-81M", "SENSOR LB:0 ACT:1"});
+	CPPUNIT_ASSERT_EQUAL(2, values0.size());
+	CPPUNIT_ASSERT_EQUAL(0, values0[0].moduleID());
+	CPPUNIT_ASSERT_EQUAL(1.0, values0[0].value());
+	CPPUNIT_ASSERT_EQUAL(2, values0[1].moduleID());
+	CPPUNIT_ASSERT_EQUAL(100.0, values0[1].value());
+
+	const auto values1 = info.parse({1572864, "JA-81M", "TAMPER LB:1 ACT:0"});
+	CPPUNIT_ASSERT_EQUAL(2, values1.size());
+	CPPUNIT_ASSERT_EQUAL(1, values1[0].moduleID());
+	CPPUNIT_ASSERT_EQUAL(0.0, values1[0].value());
+	CPPUNIT_ASSERT_EQUAL(2, values1[1].moduleID());
+	CPPUNIT_ASSERT_EQUAL(5.0, values1[1].value());
+
+	CPPUNIT_ASSERT_THROW(
+		info.parse({1572864, "JA-81M", "SENSOR ACT:1"}),
+		NotFoundException);
+}
+
+void JablotronGadgetTest::testParseRC86K()
+{
+	const auto &info = JablotronGadget::Info::resolve(8388608);
+
+	const auto values0 = info.parse({8388608, "RC-86K", "ARM:1 LB:0"});
+	CPPUNIT_ASSERT_EQUAL(2, values0.size());
+	CPPUNIT_ASSERT_EQUAL(0, values0[0].moduleID());
+	CPPUNIT_ASSERT_EQUAL(1.0, values0[0].value());
+	CPPUNIT_ASSERT_EQUAL(3, values0[1].moduleID());
+
+	const auto values1 = info.parse({9437184, "RC-86K", "ARM:0 LB:0"});
+	CPPUNIT_ASSERT_EQUAL(2, values1.size());
+	CPPUNIT_ASSERT_EQUAL(1, values1[0].moduleID());
+	CPPUNIT_ASSERT_EQUAL(0.0, values1[0].value());
+
+	const auto values2 = info.parse({8388608, "RC-86K", "PANIC LB:1"});
+	CPPUNIT_ASSERT_EQUAL(2, values2.size());
+	CPPUNIT_ASSERT_EQUAL(2, values2[0].moduleID());
+	CPPUNIT_ASSERT_EQUAL(1.0, values2[0].value());
+	CPPUNIT_ASSERT_EQUAL(5.0, values2[1].value());
+}
+
+void JablotronGadgetTest::testParseTP82N()
+{
+	static const string C = {static_cast<char>(0xb0), 'C'};
+	const auto &info = JablotronGadget::Info::resolve(2359296);
+
+	const auto values0 = info.parse({2359296, "TP-82N", "INT:21.5" + C + " LB:0"});
+	CPPUNIT_ASSERT_EQUAL(2, values0.size());
+	CPPUNIT_ASSERT_EQUAL(0, values0[0].moduleID());
+	CPPUNIT_ASSERT_EQUAL(21.5, values0[0].value());
+	CPPUNIT_ASSERT_EQUAL(2, values0[1].moduleID());
+	CPPUNIT_ASSERT_EQUAL(100.0, values0[1].value());
+
+	const auto values1 = info.parse({2359296, "TP-82N", "SET:-05.2" + C + " LB:1"});
+	CPPUNIT_ASSERT_EQUAL(2, values1.size());
+	CPPUNIT_ASSERT_EQUAL(1, values1[0].moduleID());
+	CPPUNIT_ASSERT_EQUAL(-5.2, values1[0].value());
+	CPPUNIT_ASSERT_EQUAL(5.0, values1[1].value());
+}
+
 }
@@ -4,6 +4,7 @@
 #include <Poco/Exception.h>
 
 #include "cppunit/BetterAssert.h"
+#include "jablotron/JablotronPayload.h"
 #include "jablotron/JablotronReport.h"
 
 using namespace std;
@@ -16,12 +17,16 @@ class JablotronReportTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testAC88);
 	CPPUNIT_TEST(testJA80L);
 	CPPUNIT_TEST(testTP82N);
+	CPPUNIT_TEST(testPayload);
+	CPPUNIT_TEST(testPayloadInvalidValues);
 	CPPUNIT_TEST_SUITE_END();
 public:
 	void testInvalid();
 	void testAC88();
 	void testJA80L();
 	void testTP82N();
+	void testPayload();
+	void testPayloadInvalidValues();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(JablotronReportTest);
@@ -141,4 +146,63 @@ void JablotronReportTest::testTP82N()
 	CPPUNIT_ASSERT_EQUAL(100, report4.battery());
 }
 
+/**
+ * The tokenized payload must provide the same answers as the string
+ * based accessors of JablotronReport.
+ */
+void JablotronReportTest::testPayload()
+{
+	static const string C = {static_cast<char>(0xb0), 'C', '\0'};
+	const JablotronReport report0 = {0x580000, "JA-80L", "TAMPER BLACKOUT:1"};
+	const JablotronReport report1 = {0x180000, "JA-81M", "SENSOR LB:1 ACT:0"};
+	const JablotronReport report2 = {0x240000, "TP-82N", "INT:-14.0" + C + " LB:0"};
+	const JablotronReport report3 = {0x240000, "TP-82N", "  SET:15.8" + C + "   LB:1  "};
+
+	const auto payload0 = JablotronPayload::parse(report0.data);
+	CPPUNIT_ASSERT(!payload0.has(JablotronPayload::KEY_BUTTON));
+	CPPUNIT_ASSERT(payload0.has(JablotronPayload::KEY_TAMPER));
+	CPPUNIT_ASSERT(!payload0.has(JablotronPayload::KEY_BLACKOUT));
+	CPPUNIT_ASSERT(payload0.hasValue(JablotronPayload::KEY_BLACKOUT));
+	CPPUNIT_ASSERT_EQUAL(report0.get("BLACKOUT"), payload0.get(JablotronPayload::KEY_BLACKOUT));
+	CPPUNIT_ASSERT_THROW(payload0.battery(), NotFoundException);
+
+	const auto payload1 = JablotronPayload::parse(report1.data);
+	CPPUNIT_ASSERT(payload1.has(JablotronPayload::KEY_SENSOR));
+	CPPUNIT_ASSERT(!payload1.has(JablotronPayload::KEY_TAMPER));
+	CPPUNIT_ASSERT_EQUAL(report1.get("ACT"), payload1.get(JablotronPayload::KEY_ACT));
+	CPPUNIT_ASSERT_EQUAL(report1.battery(), payload1.battery());
+
+	const auto payload2 = JablotronPayload::parse(report2.data);
+	CPPUNIT_ASSERT(payload2.hasValue(JablotronPayload::KEY_INT));
+	CPPUNIT_ASSERT(!payload2.hasValue(JablotronPayload::KEY_SET));
+	CPPUNIT_ASSERT_EQUAL(report2.temperature("INT"), payload2.temperature(JablotronPayload::KEY_INT));
+	CPPUNIT_ASSERT_THROW(payload2.temperature(JablotronPayload::KEY_SET), NotFoundException);
+	CPPUNIT_ASSERT_EQUAL(report2.battery(), payload2.battery());
+
+	const auto payload3 = JablotronPayload::parse(report3.data);
+	CPPUNIT_ASSERT(!payload3.hasValue(JablotronPayload::KEY_INT));
+	CPPUNIT_ASSERT(payload3.hasValue(JablotronPayload::KEY_SET));
+	CPPUNIT_ASSERT_EQUAL(15.8, payload3.temperature(JablotronPayload::KEY_SET));
+	CPPUNIT_ASSERT_EQUAL(report3.battery(), payload3.battery());
+}
+
+void JablotronReportTest::testPayloadInvalidValues()
+{
+	const auto payload = JablotronPayload::parse("ACT:2 ARM:10 INT:1.5 SET:21.5C RELAY: LB:1 LB:0 XYZ");
+
+	CPPUNIT_ASSERT(payload.hasValue(JablotronPayload::KEY_ACT));
+	CPPUNIT_ASSERT_THROW(payload.get(JablotronPayload::KEY_ACT), NotFoundException);
+	CPPUNIT_ASSERT(payload.hasValue(JablotronPayload::KEY_ARM));
+	CPPUNIT_ASSERT_THROW(payload.get(JablotronPayload::KEY_ARM), NotFoundException);
+	CPPUNIT_ASSERT(payload.hasValue(JablotronPayload::KEY_INT));
+	CPPUNIT_ASSERT_THROW(payload.temperature(JablotronPayload::KEY_INT), NotFoundException);
+	CPPUNIT_ASSERT(payload.hasValue(JablotronPayload::KEY_SET));
+	CPPUNIT_ASSERT_THROW(payload.temperature(JablotronPayload::KEY_SET), NotFoundException);
+	CPPUNIT_ASSERT(payload.hasValue(JablotronPayload::KEY_RELAY));
+	CPPUNIT_ASSERT_THROW(payload.get(JablotronPayload::KEY_RELAY), NotFoundException);
+
+	// the first value wins
+	CPPUNIT_ASSERT_EQUAL(5, payload.battery());
+}
+
 }
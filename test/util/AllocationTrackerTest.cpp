@@ -0,0 +1,127 @@
+#include <sstream>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/AllocationTracker.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class AllocationTrackerTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(AllocationTrackerTest);
+	CPPUNIT_TEST(testRegisterTag);
+	CPPUNIT_TEST(testDiff);
+	CPPUNIT_TEST(testScope);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testRegisterTag();
+	void testDiff();
+	void testScope();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AllocationTrackerTest);
+
+static AllocationStats makeStats(
+		UInt64 allocations,
+		UInt64 deallocations,
+		UInt64 allocatedBytes,
+		UInt64 freedBytes)
+{
+	AllocationStats stats;
+	stats.allocations = allocations;
+	stats.deallocations = deallocations;
+	stats.allocatedBytes = allocatedBytes;
+	stats.freedBytes = freedBytes;
+	return stats;
+}
+
+void AllocationTrackerTest::testRegisterTag()
+{
+	const AllocationTag a("test-register-a");
+	const AllocationTag b("test-register-b");
+	const AllocationTag again("test-register-a");
+	const AllocationTag untagged("untagged");
+
+	CPPUNIT_ASSERT(a.index() != b.index());
+	CPPUNIT_ASSERT_EQUAL(a.index(), again.index());
+	CPPUNIT_ASSERT_EQUAL(0, untagged.index());
+	CPPUNIT_ASSERT_EQUAL("test-register-b", string(b.name()));
+
+	const AllocationSnapshot &snapshot = AllocationTracker::snapshot();
+	CPPUNIT_ASSERT(snapshot.tags().find("test-register-a") != snapshot.tags().end());
+	CPPUNIT_ASSERT(snapshot.tags().find("test-register-b") != snapshot.tags().end());
+}
+
+/**
+ * @brief The diff report lists tags ordered by growth of live bytes,
+ * tags unknown to the older snapshot are reported as new.
+ */
+void AllocationTrackerTest::testDiff()
+{
+	const AllocationSnapshot before(Timestamp(0), {
+		{"journal", makeStats(10, 5, 1000, 500)},
+		{"answers", makeStats(4, 4, 64, 64)},
+	});
+
+	const AllocationSnapshot after(Timestamp(3600 * Timespan::SECONDS), {
+		{"journal", makeStats(20, 20, 2000, 2000)},
+		{"answers", makeStats(8, 6, 128, 96)},
+		{"gws", makeStats(3, 0, 300, 0)},
+	});
+
+	CPPUNIT_ASSERT_EQUAL(332, after.liveBytes());
+	CPPUNIT_ASSERT_EQUAL(0, after.stats("unknown").liveBytes());
+
+	ostringstream out;
+	after.diff(before, out);
+
+	CPPUNIT_ASSERT_EQUAL(
+		"gws live 300 (+300) blocks 3 (+3) allocs 3\n"
+		"answers live 32 (+32) blocks 2 (+2) allocs 4\n"
+		"journal live 0 (-500) blocks 0 (-5) allocs 10\n",
+		out.str());
+}
+
+/**
+ * @brief Allocations made within a scope are attributed to its tag.
+ * The test is effective only when the suite is built with
+ * ENABLE_ALLOC_TRACKING.
+ */
+void AllocationTrackerTest::testScope()
+{
+	const AllocationTag tag("test-scope");
+
+	const AllocationSnapshot &before = AllocationTracker::snapshot();
+	vector<char> *data;
+
+	{
+		AllocationScope scope(tag);
+		data = new vector<char>(1000);
+	}
+
+	const AllocationSnapshot &allocated = AllocationTracker::snapshot();
+	delete data;
+	const AllocationSnapshot &freed = AllocationTracker::snapshot();
+
+	if (!AllocationTracker::enabled()) {
+		CPPUNIT_ASSERT_EQUAL(0, allocated.stats("test-scope").allocations);
+		return;
+	}
+
+	const Int64 live = allocated.stats("test-scope").liveBytes()
+		- before.stats("test-scope").liveBytes();
+
+	CPPUNIT_ASSERT_EQUAL(sizeof(vector<char>) + 1000, live);
+	CPPUNIT_ASSERT_EQUAL(2, allocated.stats("test-scope").liveBlocks()
+		- before.stats("test-scope").liveBlocks());
+
+	CPPUNIT_ASSERT_EQUAL(
+		before.stats("test-scope").liveBytes(),
+		freed.stats("test-scope").liveBytes());
+}
+
+}
@@ -0,0 +1,233 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/ContinuationAsyncWork.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class ContinuationAsyncWorkTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(ContinuationAsyncWorkTest);
+	CPPUNIT_TEST(testComplete);
+	CPPUNIT_TEST(testThen);
+	CPPUNIT_TEST(testFailurePropagates);
+	CPPUNIT_TEST(testCancelPropagatesUpstream);
+	CPPUNIT_TEST(testThenAsync);
+	CPPUNIT_TEST(testCancelThenAsync);
+	CPPUNIT_TEST(testCancelAfterUpstreamDestroyed);
+	CPPUNIT_TEST(testOnCompleteWhenFinished);
+	CPPUNIT_TEST(testTryJoin);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testComplete();
+	void testThen();
+	void testFailurePropagates();
+	void testCancelPropagatesUpstream();
+	void testThenAsync();
+	void testCancelThenAsync();
+	void testCancelAfterUpstreamDestroyed();
+	void testOnCompleteWhenFinished();
+	void testTryJoin();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ContinuationAsyncWorkTest);
+
+void ContinuationAsyncWorkTest::testComplete()
+{
+	ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+	int called = 0;
+
+	work->onComplete([&](ContinuationAsyncWork<int> &done) {
+		CPPUNIT_ASSERT_EQUAL(5, done.result().value());
+		called += 1;
+	});
+
+	CPPUNIT_ASSERT(!work->finished());
+	CPPUNIT_ASSERT_EQUAL(0, called);
+
+	CPPUNIT_ASSERT(work->complete(5));
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::SUCCEEDED, work->state());
+	CPPUNIT_ASSERT_EQUAL(1, called);
+
+	CPPUNIT_ASSERT(!work->complete(6));
+	CPPUNIT_ASSERT(!work->fail(IOException("too late")));
+	CPPUNIT_ASSERT_EQUAL(5, work->result().value());
+	CPPUNIT_ASSERT_EQUAL(1, called);
+	CPPUNIT_ASSERT_THROW(work->rethrow(), IllegalStateException);
+}
+
+void ContinuationAsyncWorkTest::testThen()
+{
+	ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+
+	auto doubled = work->then<double>([](const int &v) {
+		return v * 1.5;
+	});
+	auto text = doubled->then<string>([](const double &v) {
+		return to_string(static_cast<int>(v));
+	});
+
+	CPPUNIT_ASSERT(!text->finished());
+
+	work->complete(2);
+
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<string>::SUCCEEDED, text->state());
+	CPPUNIT_ASSERT_EQUAL("3", text->result().value());
+}
+
+/**
+ * @brief Exception thrown by a step fails the step and all the steps
+ * depending on it. The depending steps are not executed.
+ */
+void ContinuationAsyncWorkTest::testFailurePropagates()
+{
+	ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+	bool executed = false;
+
+	auto failing = work->then<int>([](const int &) -> int {
+		throw ProtocolException("unexpected response");
+	});
+	auto last = failing->then<int>([&](const int &v) {
+		executed = true;
+		return v;
+	});
+
+	work->complete(1);
+
+	CPPUNIT_ASSERT(!executed);
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::FAILED, failing->state());
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::FAILED, last->state());
+	CPPUNIT_ASSERT_THROW(last->rethrow(), ProtocolException);
+}
+
+/**
+ * @brief Cancelling the dependent step cancels the work it depends on
+ * and calls its cancel hook.
+ */
+void ContinuationAsyncWorkTest::testCancelPropagatesUpstream()
+{
+	ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+	bool hook = false;
+
+	work->setCancelHook([&]() {
+		hook = true;
+	});
+
+	auto next = work->then<int>([](const int &v) {
+		return v;
+	});
+
+	next->cancel();
+
+	CPPUNIT_ASSERT(hook);
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::CANCELLED, work->state());
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::CANCELLED, next->state());
+	CPPUNIT_ASSERT(!work->complete(3));
+	CPPUNIT_ASSERT(next->result().isNull());
+}
+
+void ContinuationAsyncWorkTest::testThenAsync()
+{
+	ContinuationAsyncWork<>::Ptr work = new ContinuationAsyncWork<>;
+	ContinuationAsyncWork<int>::Ptr inner;
+
+	auto next = work->thenAsync<int>([&](const Void &) {
+		inner = new ContinuationAsyncWork<int>;
+		return inner;
+	});
+
+	CPPUNIT_ASSERT(inner.isNull());
+
+	work->complete(Void());
+
+	CPPUNIT_ASSERT(!inner.isNull());
+	CPPUNIT_ASSERT(!next->finished());
+
+	inner->complete(42);
+
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::SUCCEEDED, next->state());
+	CPPUNIT_ASSERT_EQUAL(42, next->result().value());
+}
+
+/**
+ * @brief Cancelling the result of thenAsync() cancels the step that
+ * is currently running.
+ */
+void ContinuationAsyncWorkTest::testCancelThenAsync()
+{
+	ContinuationAsyncWork<>::Ptr work = new ContinuationAsyncWork<>;
+	ContinuationAsyncWork<int>::Ptr inner;
+
+	auto next = work->thenAsync<int>([&](const Void &) {
+		inner = new ContinuationAsyncWork<int>;
+		return inner;
+	});
+
+	work->complete(Void());
+	next->cancel();
+
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<>::SUCCEEDED, work->state());
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::CANCELLED, inner->state());
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::CANCELLED, next->state());
+}
+
+/**
+ * @brief Cancelling the dependent step is safe even when the work it
+ * depends on has already been destroyed.
+ */
+void ContinuationAsyncWorkTest::testCancelAfterUpstreamDestroyed()
+{
+	ContinuationAsyncWork<int>::Ptr next;
+
+	{
+		ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+		next = work->then<int>([](const int &v) {
+			return v;
+		});
+	}
+
+	next->cancel();
+
+	CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::CANCELLED, next->state());
+}
+
+void ContinuationAsyncWorkTest::testOnCompleteWhenFinished()
+{
+	ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+	int called = 0;
+
+	work->fail(TimeoutException("no response"));
+
+	work->onComplete([&](ContinuationAsyncWork<int> &done) {
+		CPPUNIT_ASSERT_EQUAL(ContinuationAsyncWork<int>::FAILED, done.state());
+		called += 1;
+	});
+
+	CPPUNIT_ASSERT_EQUAL(1, called);
+	CPPUNIT_ASSERT_THROW(work->rethrow(), TimeoutException);
+}
+
+void ContinuationAsyncWorkTest::testTryJoin()
+{
+	ContinuationAsyncWork<int>::Ptr work = new ContinuationAsyncWork<int>;
+	Thread thread;
+
+	CPPUNIT_ASSERT(!work->tryJoin(0));
+	CPPUNIT_ASSERT(!work->tryJoin(10 * Timespan::MILLISECONDS));
+
+	thread.startFunc([work]() {
+		Thread::sleep(10);
+		work->complete(7);
+	});
+
+	CPPUNIT_ASSERT(work->tryJoin(5 * Timespan::SECONDS));
+	CPPUNIT_ASSERT_EQUAL(7, work->result().value());
+
+	thread.join();
+}
+
+}
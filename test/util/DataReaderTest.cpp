@@ -1,6 +1,9 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include "cppunit/BetterAssert.h"
 
+#include <Poco/Checksum.h>
+#include <Poco/NumberFormatter.h>
+
 #include "util/DataReader.h"
 
 using namespace Poco;
@@ -14,12 +17,18 @@ class DataReaderTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testSkip);
 	CPPUNIT_TEST(testEmptyInput);
 	CPPUNIT_TEST(testInvalidChecksum);
+	CPPUNIT_TEST(testInvalidFormat);
+	CPPUNIT_TEST(testIncompleteLastLine);
+	CPPUNIT_TEST(testDataLongerThanChunk);
 	CPPUNIT_TEST_SUITE_END();
 public:
 	void testRead();
 	void testSkip();
 	void testEmptyInput();
 	void testInvalidChecksum();
+	void testInvalidFormat();
+	void testIncompleteLastLine();
+	void testDataLongerThanChunk();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DataReaderTest);
@@ -95,4 +104,58 @@ void DataReaderTest::testInvalidChecksum()
 	CPPUNIT_ASSERT_EQUAL(1, reader.dataRead());
 }
 
+void DataReaderTest::testInvalidFormat()
+{
+	stringstream testStream;
+
+	testStream << endl
+	           << "646AB87" << endl
+	           << "XY6AB873first string" << endl
+	           << "9851078cSECOND STRING" << endl;
+
+	DataReader reader(testStream);
+
+	CPPUNIT_ASSERT(reader.hasNext());
+	CPPUNIT_ASSERT_EQUAL("SECOND STRING", reader.next());
+	CPPUNIT_ASSERT(!reader.hasNext());
+}
+
+void DataReaderTest::testIncompleteLastLine()
+{
+	stringstream testStream;
+
+	testStream << "646AB873first string" << endl
+	           << "9851078CSECOND STRING";
+
+	DataReader reader(testStream);
+
+	CPPUNIT_ASSERT(reader.hasNext());
+	CPPUNIT_ASSERT_EQUAL("first string", reader.next());
+	CPPUNIT_ASSERT(!reader.hasNext());
+}
+
+/**
+ * @brief Data longer than the internal buffer of the reader
+ * must be read as a whole.
+ */
+void DataReaderTest::testDataLongerThanChunk()
+{
+	const string data(200 * 1024, 'x');
+	Checksum checksum;
+	checksum.update(data);
+
+	stringstream testStream;
+	testStream << NumberFormatter::formatHex(checksum.checksum(), 8) << data << endl
+	           << "646AB873first string" << endl;
+
+	DataReader reader(testStream);
+
+	CPPUNIT_ASSERT(reader.hasNext());
+	CPPUNIT_ASSERT(data == reader.next());
+
+	CPPUNIT_ASSERT(reader.hasNext());
+	CPPUNIT_ASSERT_EQUAL("first string", reader.next());
+	CPPUNIT_ASSERT(!reader.hasNext());
+}
+
 }
@@ -35,10 +35,12 @@ class DataWriterTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(DataWriterTest);
 	CPPUNIT_TEST(testWrite);
 	CPPUNIT_TEST(testWriteEmpty);
+	CPPUNIT_TEST(testWriteSmallBuffer);
 	CPPUNIT_TEST_SUITE_END();
 public:
 	void testWrite();
 	void testWriteEmpty();
+	void testWriteSmallBuffer();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DataWriterTest);
@@ -81,4 +83,32 @@ void DataWriterTest::testWriteEmpty()
 	CPPUNIT_ASSERT(testStream.str().empty());
 }
 
+/**
+ * @brief Records not fitting into the buffer of the writer
+ * must be written unchanged and in order.
+ */
+void DataWriterTest::testWriteSmallBuffer()
+{
+	stringstream testStream;
+	string string1("first string");
+	string string2("SECOND STRING");
+
+	DataWriter writer(testStream, 16);
+
+	deque<string> deque;
+
+	deque.emplace_back(string1);
+	deque.emplace_back(string2);
+	deque.emplace_back("");
+
+	DataWriterTestIterator itr(deque);
+
+	CPPUNIT_ASSERT_EQUAL(3, writer.write(itr));
+
+	CPPUNIT_ASSERT_EQUAL("646AB873first string\n"
+			             "9851078CSECOND STRING\n"
+			             "00000000\n",
+	                     testStream.str());
+}
+
 }
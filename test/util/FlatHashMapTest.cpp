@@ -0,0 +1,186 @@
+#include <map>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Types.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/FlatHashMap.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class FlatHashMapTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(FlatHashMapTest);
+	CPPUNIT_TEST(testEmplaceFind);
+	CPPUNIT_TEST(testGrow);
+	CPPUNIT_TEST(testCollisions);
+	CPPUNIT_TEST(testClear);
+	CPPUNIT_TEST(testEraseIf);
+	CPPUNIT_TEST(testForEach);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testEmplaceFind();
+	void testGrow();
+	void testCollisions();
+	void testClear();
+	void testEraseIf();
+	void testForEach();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FlatHashMapTest);
+
+struct IdentityHash {
+	UInt64 operator()(unsigned int key) const
+	{
+		return key;
+	}
+};
+
+/**
+ * All keys share the same hash and thus the same probe sequence.
+ */
+struct ConstantHash {
+	UInt64 operator()(unsigned int) const
+	{
+		return 42;
+	}
+};
+
+typedef FlatHashMap<unsigned int, int, IdentityHash> TestingMap;
+
+void FlatHashMapTest::testEmplaceFind()
+{
+	TestingMap map;
+
+	CPPUNIT_ASSERT_EQUAL(0, map.size());
+	CPPUNIT_ASSERT(map.find(5) == nullptr);
+
+	auto result = map.emplace(5);
+	CPPUNIT_ASSERT(result.second);
+	CPPUNIT_ASSERT_EQUAL(0, *result.first);
+	*result.first = 10;
+
+	result = map.emplace(5);
+	CPPUNIT_ASSERT(!result.second);
+	CPPUNIT_ASSERT_EQUAL(10, *result.first);
+
+	CPPUNIT_ASSERT_EQUAL(1, map.size());
+	CPPUNIT_ASSERT(map.find(5) != nullptr);
+	CPPUNIT_ASSERT_EQUAL(10, *map.find(5));
+
+	const TestingMap &constMap = map;
+	CPPUNIT_ASSERT(constMap.find(5) != nullptr);
+	CPPUNIT_ASSERT(constMap.find(6) == nullptr);
+}
+
+/**
+ * @brief Sequential keys are inserted beyond the initial capacity,
+ * all values must survive the growing of the table.
+ */
+void FlatHashMapTest::testGrow()
+{
+	TestingMap map(4);
+	CPPUNIT_ASSERT_EQUAL(4, map.capacity());
+
+	for (unsigned int i = 0; i < 1000; ++i)
+		*map.emplace(i).first = i * 2;
+
+	CPPUNIT_ASSERT_EQUAL(1000, map.size());
+	CPPUNIT_ASSERT(map.capacity() >= 1000);
+
+	for (unsigned int i = 0; i < 1000; ++i) {
+		CPPUNIT_ASSERT(map.find(i) != nullptr);
+		CPPUNIT_ASSERT_EQUAL(int(i * 2), *map.find(i));
+	}
+
+	CPPUNIT_ASSERT(map.find(1000) == nullptr);
+}
+
+void FlatHashMapTest::testCollisions()
+{
+	FlatHashMap<unsigned int, int, ConstantHash> map;
+
+	for (unsigned int i = 0; i < 100; ++i)
+		*map.emplace(i).first = i;
+
+	CPPUNIT_ASSERT_EQUAL(100, map.size());
+
+	for (unsigned int i = 0; i < 100; ++i)
+		CPPUNIT_ASSERT_EQUAL(int(i), *map.find(i));
+
+	CPPUNIT_ASSERT(map.find(100) == nullptr);
+}
+
+void FlatHashMapTest::testClear()
+{
+	TestingMap map;
+
+	for (unsigned int i = 0; i < 100; ++i)
+		*map.emplace(i).first = i;
+
+	const size_t capacity = map.capacity();
+	map.clear();
+
+	CPPUNIT_ASSERT_EQUAL(0, map.size());
+	CPPUNIT_ASSERT_EQUAL(capacity, map.capacity());
+	CPPUNIT_ASSERT(map.find(5) == nullptr);
+
+	auto result = map.emplace(5);
+	CPPUNIT_ASSERT(result.second);
+	CPPUNIT_ASSERT_EQUAL(0, *result.first);
+}
+
+/**
+ * Entries following an erased one in the same probe sequence
+ * must remain reachable.
+ */
+void FlatHashMapTest::testEraseIf()
+{
+	FlatHashMap<unsigned int, int, ConstantHash> map;
+
+	for (unsigned int i = 0; i < 100; ++i)
+		*map.emplace(i).first = i;
+
+	const size_t erased = map.eraseIf([](unsigned int key, int) {
+		return key % 2 == 0;
+	});
+
+	CPPUNIT_ASSERT_EQUAL(50, erased);
+	CPPUNIT_ASSERT_EQUAL(50, map.size());
+
+	for (unsigned int i = 0; i < 100; ++i) {
+		if (i % 2 == 0)
+			CPPUNIT_ASSERT(map.find(i) == nullptr);
+		else
+			CPPUNIT_ASSERT_EQUAL(int(i), *map.find(i));
+	}
+
+	CPPUNIT_ASSERT(map.emplace(0).second);
+	CPPUNIT_ASSERT_EQUAL(51, map.size());
+}
+
+void FlatHashMapTest::testForEach()
+{
+	TestingMap map;
+	std::map<unsigned int, int> expected;
+
+	for (unsigned int i = 0; i < 50; ++i) {
+		*map.emplace(i * 7).first = i;
+		expected[i * 7] = i;
+	}
+
+	std::map<unsigned int, int> visited;
+	map.forEach([&](unsigned int key, int &value) {
+		visited[key] = value;
+		value += 1;
+	});
+
+	CPPUNIT_ASSERT(visited == expected);
+	CPPUNIT_ASSERT_EQUAL(1, *map.find(0));
+	CPPUNIT_ASSERT_EQUAL(50, *map.find(49 * 7));
+}
+
+}
@@ -0,0 +1,183 @@
+#include <cmath>
+#include <limits>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/GorillaCodec.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class GorillaCodecTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(GorillaCodecTest);
+	CPPUNIT_TEST(testEmpty);
+	CPPUNIT_TEST(testSinglePoint);
+	CPPUNIT_TEST(testRegularSeries);
+	CPPUNIT_TEST(testIrregularSeries);
+	CPPUNIT_TEST(testSpecialValues);
+	CPPUNIT_TEST(testTruncated);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testEmpty();
+	void testSinglePoint();
+	void testRegularSeries();
+	void testIrregularSeries();
+	void testSpecialValues();
+	void testTruncated();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GorillaCodecTest);
+
+void GorillaCodecTest::testEmpty()
+{
+	GorillaEncoder encoder;
+	CPPUNIT_ASSERT_EQUAL(0, encoder.count());
+	CPPUNIT_ASSERT(encoder.data().empty());
+
+	GorillaDecoder decoder(encoder.data(), 0);
+	Int64 time;
+	double value;
+
+	CPPUNIT_ASSERT(!decoder.next(time, value));
+}
+
+/**
+ * @brief The first point is stored raw in 16 bytes.
+ */
+void GorillaCodecTest::testSinglePoint()
+{
+	GorillaEncoder encoder;
+	encoder.append(1527660187000, 21.5);
+
+	CPPUNIT_ASSERT_EQUAL(1, encoder.count());
+	CPPUNIT_ASSERT_EQUAL(16, encoder.data().size());
+
+	GorillaDecoder decoder(encoder.data(), encoder.count());
+	Int64 time;
+	double value;
+
+	CPPUNIT_ASSERT(decoder.next(time, value));
+	CPPUNIT_ASSERT_EQUAL(1527660187000, time);
+	CPPUNIT_ASSERT_EQUAL(21.5, value);
+	CPPUNIT_ASSERT(!decoder.next(time, value));
+
+	encoder.clear();
+	CPPUNIT_ASSERT_EQUAL(0, encoder.count());
+	CPPUNIT_ASSERT(encoder.data().empty());
+}
+
+/**
+ * @brief Regularly sampled series of a slowly changing value
+ * is decoded exactly and takes just a few bits per point.
+ */
+void GorillaCodecTest::testRegularSeries()
+{
+	GorillaEncoder encoder;
+
+	for (int i = 0; i < 1000; ++i)
+		encoder.append(1527660187000 + i * 300000, 20 + (i / 50) * 0.5);
+
+	CPPUNIT_ASSERT_EQUAL(1000, encoder.count());
+	CPPUNIT_ASSERT(encoder.data().size() < 300);
+
+	GorillaDecoder decoder(encoder.data(), encoder.count());
+	Int64 time;
+	double value;
+
+	for (int i = 0; i < 1000; ++i) {
+		CPPUNIT_ASSERT(decoder.next(time, value));
+		CPPUNIT_ASSERT_EQUAL(1527660187000 + i * 300000, time);
+		CPPUNIT_ASSERT_EQUAL(20 + (i / 50) * 0.5, value);
+	}
+
+	CPPUNIT_ASSERT(!decoder.next(time, value));
+}
+
+/**
+ * @brief Jitter of time and arbitrary values fall into all
+ * the encoding buckets including out of order points.
+ */
+void GorillaCodecTest::testIrregularSeries()
+{
+	const Int64 times[] = {
+		1000, 2000, 3000, 3050, 3100, 3400, 4500, 10000,
+		9000, 9000, 1000000000000, 5, 6, 7
+	};
+	const double values[] = {
+		1.0, 1.0, -1.0, 1.5, 1000.25, 1e-300, 0.1, 0.2,
+		0.30000000000000004, -0.0, 1e300, 42, 42, 43
+	};
+	const size_t count = sizeof(times) / sizeof(times[0]);
+
+	GorillaEncoder encoder;
+
+	for (size_t i = 0; i < count; ++i)
+		encoder.append(times[i], values[i]);
+
+	GorillaDecoder decoder(encoder.data(), encoder.count());
+	Int64 time;
+	double value;
+
+	for (size_t i = 0; i < count; ++i) {
+		CPPUNIT_ASSERT(decoder.next(time, value));
+		CPPUNIT_ASSERT_EQUAL(times[i], time);
+		CPPUNIT_ASSERT_EQUAL(values[i], value);
+		CPPUNIT_ASSERT_EQUAL(signbit(values[i]), signbit(value));
+	}
+
+	CPPUNIT_ASSERT(!decoder.next(time, value));
+}
+
+void GorillaCodecTest::testSpecialValues()
+{
+	GorillaEncoder encoder;
+	encoder.append(0, numeric_limits<double>::infinity());
+	encoder.append(1, NAN);
+	encoder.append(2, -numeric_limits<double>::infinity());
+	encoder.append(3, numeric_limits<double>::denorm_min());
+
+	GorillaDecoder decoder(encoder.data(), encoder.count());
+	Int64 time;
+	double value;
+
+	CPPUNIT_ASSERT(decoder.next(time, value));
+	CPPUNIT_ASSERT(isinf(value) && value > 0);
+	CPPUNIT_ASSERT(decoder.next(time, value));
+	CPPUNIT_ASSERT(std::isnan(value));
+	CPPUNIT_ASSERT(decoder.next(time, value));
+	CPPUNIT_ASSERT(isinf(value) && value < 0);
+	CPPUNIT_ASSERT(decoder.next(time, value));
+	CPPUNIT_ASSERT_EQUAL(numeric_limits<double>::denorm_min(), value);
+}
+
+/**
+ * @brief Decoding more points than encoded fails instead
+ * of reading out of the data.
+ */
+void GorillaCodecTest::testTruncated()
+{
+	GorillaEncoder encoder;
+	encoder.append(1000, 1.0);
+	encoder.append(2000, 2.0);
+
+	const string truncated = encoder.data().substr(0, 10);
+	GorillaDecoder decoder(truncated, 1);
+	Int64 time;
+	double value;
+
+	CPPUNIT_ASSERT_THROW(decoder.next(time, value), DataFormatException);
+
+	GorillaDecoder overflow(encoder.data(), 100);
+	CPPUNIT_ASSERT(overflow.next(time, value));
+	CPPUNIT_ASSERT(overflow.next(time, value));
+	CPPUNIT_ASSERT_THROW(
+		while (overflow.next(time, value)) {},
+		DataFormatException);
+}
+
+}
@@ -0,0 +1,144 @@
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/FileStream.h>
+
+#include "cppunit/BetterAssert.h"
+#include "cppunit/FileTestFixture.h"
+#include "loop/StopControl.h"
+#include "util/InputTraceReplayer.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class InputTraceReplayerTest : public FileTestFixture {
+	CPPUNIT_TEST_SUITE(InputTraceReplayerTest);
+	CPPUNIT_TEST(testReplayChannel);
+	CPPUNIT_TEST(testReplayTiming);
+	CPPUNIT_TEST(testReplayStop);
+	CPPUNIT_TEST(testInvalidSpeed);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() override;
+
+	void testReplayChannel();
+	void testReplayTiming();
+	void testReplayStop();
+	void testInvalidSpeed();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(InputTraceReplayerTest);
+
+/**
+ * The trace interleaves two channels, the zwave records are
+ * recorded at offsets 0, 200 and 400 ms.
+ */
+void InputTraceReplayerTest::setUp()
+{
+	FileTestFixture::setUp();
+
+	FileOutputStream out(testingFile().path(), ios::out | ios::binary | ios::trunc);
+	const Timestamp start;
+
+	InputTraceWriter writer(out);
+	writer.write("zwave", "first", start);
+	writer.write("ble", "other", start + 100 * Timespan::MILLISECONDS);
+	writer.write("zwave", "second", start + 200 * Timespan::MILLISECONDS);
+	writer.write("zwave", "third", start + 400 * Timespan::MILLISECONDS);
+	out.close();
+}
+
+/**
+ * Replaying as fast as possible passes only records of the requested
+ * channel to the handler and preserves their order.
+ */
+void InputTraceReplayerTest::testReplayChannel()
+{
+	InputTraceReplayer replayer;
+	replayer.setTracePath(testingFile().path());
+	replayer.setSpeed(0);
+
+	StopControl stopControl;
+	vector<string> payloads;
+
+	CPPUNIT_ASSERT_EQUAL(3, replayer.replay("zwave",
+		[&](const InputTraceRecord &record) {
+			payloads.emplace_back(record.payload());
+		},
+		stopControl));
+
+	CPPUNIT_ASSERT_EQUAL(3, payloads.size());
+	CPPUNIT_ASSERT_EQUAL("first", payloads[0]);
+	CPPUNIT_ASSERT_EQUAL("second", payloads[1]);
+	CPPUNIT_ASSERT_EQUAL("third", payloads[2]);
+
+	CPPUNIT_ASSERT_EQUAL(1, replayer.replay("ble",
+		[](const InputTraceRecord &) {}, stopControl));
+	CPPUNIT_ASSERT_EQUAL(0, replayer.replay("jablotron",
+		[](const InputTraceRecord &) {}, stopControl));
+}
+
+/**
+ * Replaying at speed 4 must never deliver a record before its
+ * scaled offset (0, 50 and 100 ms) elapses.
+ */
+void InputTraceReplayerTest::testReplayTiming()
+{
+	InputTraceReplayer replayer;
+	replayer.setTracePath(testingFile().path());
+	replayer.setSpeed(4);
+
+	StopControl stopControl;
+	vector<Timespan> delivered;
+	const Clock started;
+
+	CPPUNIT_ASSERT_EQUAL(3, replayer.replay("zwave",
+		[&](const InputTraceRecord &) {
+			delivered.emplace_back(started.elapsed());
+		},
+		stopControl));
+
+	CPPUNIT_ASSERT_EQUAL(3, delivered.size());
+	CPPUNIT_ASSERT(delivered[1] >= 50 * Timespan::MILLISECONDS);
+	CPPUNIT_ASSERT(delivered[2] >= 100 * Timespan::MILLISECONDS);
+
+	// the original timing (400 ms) must not be used
+	CPPUNIT_ASSERT(delivered[2] < 400 * Timespan::MILLISECONDS);
+}
+
+/**
+ * A stop requested while replaying ends the replay without
+ * delivering the remaining records.
+ */
+void InputTraceReplayerTest::testReplayStop()
+{
+	InputTraceReplayer replayer;
+	replayer.setTracePath(testingFile().path());
+	replayer.setSpeed(1);
+
+	StopControl stopControl;
+	const Clock started;
+
+	CPPUNIT_ASSERT_EQUAL(1, replayer.replay("zwave",
+		[&](const InputTraceRecord &) {
+			stopControl.requestStop();
+		},
+		stopControl));
+
+	CPPUNIT_ASSERT(started.elapsed() < 200 * Timespan::MILLISECONDS);
+}
+
+void InputTraceReplayerTest::testInvalidSpeed()
+{
+	InputTraceReplayer replayer;
+
+	CPPUNIT_ASSERT_THROW(replayer.setSpeed(-1), InvalidArgumentException);
+	CPPUNIT_ASSERT_NO_THROW(replayer.setSpeed(0));
+}
+
+}
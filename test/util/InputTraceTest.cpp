@@ -0,0 +1,149 @@
+#include <sstream>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/InputTrace.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class InputTraceTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(InputTraceTest);
+	CPPUNIT_TEST(testEncodeDecode);
+	CPPUNIT_TEST(testDecodeTruncated);
+	CPPUNIT_TEST(testWriteRead);
+	CPPUNIT_TEST(testReadInvalidHeader);
+	CPPUNIT_TEST(testReadTruncated);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testEncodeDecode();
+	void testDecodeTruncated();
+	void testWriteRead();
+	void testReadInvalidHeader();
+	void testReadTruncated();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(InputTraceTest);
+
+void InputTraceTest::testEncodeDecode()
+{
+	InputTraceEncoder encoder;
+
+	encoder.putUnsigned(0);
+	encoder.putUnsigned(127);
+	encoder.putUnsigned(128);
+	encoder.putUnsigned(0xffffffffffffffffULL);
+	encoder.putString("");
+	encoder.putString("[00900357] RC-86K ARM:1 LB:0");
+	encoder.putBytes({0x00, 0xff, 0x10});
+
+	// small numbers take a single byte
+	CPPUNIT_ASSERT_EQUAL(1 + 1 + 2 + 10 + 1 + 30 + 4, encoder.data().size());
+
+	InputTraceDecoder decoder(encoder.data());
+
+	CPPUNIT_ASSERT_EQUAL(0, decoder.getUnsigned());
+	CPPUNIT_ASSERT_EQUAL(127, decoder.getUnsigned());
+	CPPUNIT_ASSERT_EQUAL(128, decoder.getUnsigned());
+	CPPUNIT_ASSERT(decoder.getUnsigned() == 0xffffffffffffffffULL);
+	CPPUNIT_ASSERT_EQUAL("", decoder.getString());
+	CPPUNIT_ASSERT_EQUAL("[00900357] RC-86K ARM:1 LB:0", decoder.getString());
+
+	const vector<unsigned char> bytes = decoder.getBytes();
+	CPPUNIT_ASSERT_EQUAL(3, bytes.size());
+	CPPUNIT_ASSERT_EQUAL(0x00, bytes[0]);
+	CPPUNIT_ASSERT_EQUAL(0xff, bytes[1]);
+	CPPUNIT_ASSERT_EQUAL(0x10, bytes[2]);
+
+	CPPUNIT_ASSERT(decoder.atEnd());
+}
+
+void InputTraceTest::testDecodeTruncated()
+{
+	InputTraceEncoder encoder;
+	encoder.putString("abcdef");
+
+	const string &data = encoder.data();
+
+	InputTraceDecoder truncatedString(data.substr(0, data.size() - 1));
+	CPPUNIT_ASSERT_THROW(truncatedString.getString(), DataFormatException);
+
+	InputTraceDecoder truncatedNumber(string(1, '\x80'));
+	CPPUNIT_ASSERT_THROW(truncatedNumber.getUnsigned(), DataFormatException);
+}
+
+/**
+ * @brief Records written with timestamps must be read back with
+ * offsets relative to the first record. Timestamps going backwards
+ * must not produce negative offsets.
+ */
+void InputTraceTest::testWriteRead()
+{
+	stringstream buffer;
+	const Timestamp start;
+
+	InputTraceWriter writer(buffer);
+	writer.write("zwave", "first", start);
+	writer.write("jablotron", "second", start + 1500);
+	writer.write("ble", string("\0\1", 2), start + 1000);
+	writer.write("zwave", "fourth", start + 3 * Timespan::SECONDS);
+
+	InputTraceReader reader(buffer);
+	InputTraceRecord record;
+
+	CPPUNIT_ASSERT(reader.next(record));
+	CPPUNIT_ASSERT_EQUAL(0, record.offset().totalMicroseconds());
+	CPPUNIT_ASSERT_EQUAL("zwave", record.channel());
+	CPPUNIT_ASSERT_EQUAL("first", record.payload());
+
+	CPPUNIT_ASSERT(reader.next(record));
+	CPPUNIT_ASSERT_EQUAL(1500, record.offset().totalMicroseconds());
+	CPPUNIT_ASSERT_EQUAL("jablotron", record.channel());
+	CPPUNIT_ASSERT_EQUAL("second", record.payload());
+
+	CPPUNIT_ASSERT(reader.next(record));
+	CPPUNIT_ASSERT_EQUAL(1500, record.offset().totalMicroseconds());
+	CPPUNIT_ASSERT_EQUAL("ble", record.channel());
+	CPPUNIT_ASSERT(record.payload() == string("\0\1", 2));
+
+	CPPUNIT_ASSERT(reader.next(record));
+	CPPUNIT_ASSERT_EQUAL(3000000, record.offset().totalMicroseconds());
+	CPPUNIT_ASSERT_EQUAL("fourth", record.payload());
+
+	CPPUNIT_ASSERT(!reader.next(record));
+}
+
+void InputTraceTest::testReadInvalidHeader()
+{
+	istringstream empty("");
+	CPPUNIT_ASSERT_THROW(InputTraceReader reader(empty), DataFormatException);
+
+	istringstream magic("XTRC\1");
+	CPPUNIT_ASSERT_THROW(InputTraceReader reader(magic), DataFormatException);
+
+	istringstream version("BTRC\7");
+	CPPUNIT_ASSERT_THROW(InputTraceReader reader(version), DataFormatException);
+}
+
+void InputTraceTest::testReadTruncated()
+{
+	stringstream buffer;
+
+	InputTraceWriter writer(buffer);
+	writer.write("zwave", "payload");
+
+	const string &data = buffer.str();
+	istringstream truncated(data.substr(0, data.size() - 2));
+
+	InputTraceReader reader(truncated);
+	InputTraceRecord record;
+
+	CPPUNIT_ASSERT_THROW(reader.next(record), DataFormatException);
+}
+
+}
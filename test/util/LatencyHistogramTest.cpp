@@ -0,0 +1,171 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/SharedPtr.h>
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/LatencyHistogram.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class LatencyHistogramTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(LatencyHistogramTest);
+	CPPUNIT_TEST(testBuckets);
+	CPPUNIT_TEST(testBucketBounds);
+	CPPUNIT_TEST(testEmpty);
+	CPPUNIT_TEST(testPercentiles);
+	CPPUNIT_TEST(testClamp);
+	CPPUNIT_TEST(testReset);
+	CPPUNIT_TEST(testConcurrentRecord);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testBuckets();
+	void testBucketBounds();
+	void testEmpty();
+	void testPercentiles();
+	void testClamp();
+	void testReset();
+	void testConcurrentRecord();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LatencyHistogramTest);
+
+/**
+ * @brief Values up to 2 * SUB_BUCKETS are stored exactly, greater
+ * values share buckets of width growing with powers of two.
+ */
+void LatencyHistogramTest::testBuckets()
+{
+	CPPUNIT_ASSERT_EQUAL(0, LatencyHistogram::bucketOf(-5));
+	CPPUNIT_ASSERT_EQUAL(0, LatencyHistogram::bucketOf(0));
+	CPPUNIT_ASSERT_EQUAL(1, LatencyHistogram::bucketOf(1));
+	CPPUNIT_ASSERT_EQUAL(15, LatencyHistogram::bucketOf(15));
+	CPPUNIT_ASSERT_EQUAL(16, LatencyHistogram::bucketOf(16));
+	CPPUNIT_ASSERT_EQUAL(31, LatencyHistogram::bucketOf(31));
+	CPPUNIT_ASSERT_EQUAL(32, LatencyHistogram::bucketOf(32));
+	CPPUNIT_ASSERT_EQUAL(32, LatencyHistogram::bucketOf(33));
+	CPPUNIT_ASSERT_EQUAL(33, LatencyHistogram::bucketOf(34));
+	CPPUNIT_ASSERT_EQUAL(47, LatencyHistogram::bucketOf(63));
+	CPPUNIT_ASSERT_EQUAL(48, LatencyHistogram::bucketOf(64));
+	CPPUNIT_ASSERT_EQUAL(
+		LatencyHistogram::BUCKETS - 1,
+		LatencyHistogram::bucketOf(Int64(1) << 50));
+}
+
+/**
+ * @brief Every value must fall between the lower and upper bound
+ * of its bucket and the bucket width must be within the promised
+ * relative error.
+ */
+void LatencyHistogramTest::testBucketBounds()
+{
+	for (Int64 value = 1; value < (Int64(1) << 39); value = value * 3 / 2 + 1) {
+		const unsigned int bucket = LatencyHistogram::bucketOf(value);
+		const Int64 lower = LatencyHistogram::lowerBound(bucket);
+		const Int64 upper = LatencyHistogram::upperBound(bucket);
+
+		CPPUNIT_ASSERT(lower <= value);
+		CPPUNIT_ASSERT(value <= upper);
+		CPPUNIT_ASSERT((upper - lower) * LatencyHistogram::SUB_BUCKETS <= value);
+	}
+}
+
+void LatencyHistogramTest::testEmpty()
+{
+	LatencyHistogram histogram;
+	const auto snapshot = histogram.snapshot();
+
+	CPPUNIT_ASSERT_EQUAL(0, snapshot.count());
+	CPPUNIT_ASSERT_EQUAL(-1, snapshot.max());
+	CPPUNIT_ASSERT_EQUAL(-1, snapshot.mean());
+	CPPUNIT_ASSERT_EQUAL(-1, snapshot.percentile(0.5));
+}
+
+void LatencyHistogramTest::testPercentiles()
+{
+	LatencyHistogram histogram;
+
+	for (int i = 1; i <= 1000; ++i)
+		histogram.record(i * Timespan::MILLISECONDS);
+
+	const auto snapshot = histogram.snapshot();
+
+	CPPUNIT_ASSERT_EQUAL(1000, snapshot.count());
+	CPPUNIT_ASSERT_EQUAL(1000000, snapshot.max());
+	CPPUNIT_ASSERT_EQUAL(500500, snapshot.mean());
+
+	const Int64 p50 = snapshot.percentile(0.5);
+	CPPUNIT_ASSERT(p50 >= 500000);
+	CPPUNIT_ASSERT(p50 <= 500000 + 500000 / LatencyHistogram::SUB_BUCKETS);
+
+	const Int64 p99 = snapshot.percentile(0.99);
+	CPPUNIT_ASSERT(p99 >= 990000);
+	CPPUNIT_ASSERT(p99 <= 990000 + 990000 / LatencyHistogram::SUB_BUCKETS);
+
+	const Int64 p0 = snapshot.percentile(0);
+	CPPUNIT_ASSERT(p0 >= 1000);
+	CPPUNIT_ASSERT(p0 <= 1000 + 1000 / LatencyHistogram::SUB_BUCKETS);
+
+	CPPUNIT_ASSERT_EQUAL(1000000, snapshot.percentile(1));
+}
+
+void LatencyHistogramTest::testClamp()
+{
+	LatencyHistogram histogram;
+
+	histogram.record(-10);
+	histogram.record(Int64(1) << 50);
+
+	const auto snapshot = histogram.snapshot();
+
+	CPPUNIT_ASSERT_EQUAL(2, snapshot.count());
+	CPPUNIT_ASSERT_EQUAL(0, snapshot.percentile(0.5));
+	CPPUNIT_ASSERT_EQUAL(
+		(Int64(1) << LatencyHistogram::MAX_EXPONENT) - 1,
+		snapshot.max());
+}
+
+void LatencyHistogramTest::testReset()
+{
+	LatencyHistogram histogram;
+
+	histogram.record(100);
+	histogram.record(200);
+	CPPUNIT_ASSERT_EQUAL(2, histogram.snapshot().count());
+
+	histogram.reset();
+	CPPUNIT_ASSERT_EQUAL(0, histogram.snapshot().count());
+	CPPUNIT_ASSERT_EQUAL(-1, histogram.snapshot().max());
+}
+
+/**
+ * @brief Records of concurrent threads must not be lost.
+ */
+void LatencyHistogramTest::testConcurrentRecord()
+{
+	LatencyHistogram histogram;
+	vector<SharedPtr<Thread>> threads;
+
+	for (int i = 0; i < 8; ++i) {
+		SharedPtr<Thread> thread = new Thread;
+		thread->startFunc([&histogram, i]() {
+			for (int k = 0; k < 10000; ++k)
+				histogram.record(i * 100 + k % 100);
+		});
+
+		threads.emplace_back(thread);
+	}
+
+	for (auto thread : threads)
+		thread->join();
+
+	const auto snapshot = histogram.snapshot();
+
+	CPPUNIT_ASSERT_EQUAL(80000, snapshot.count());
+	CPPUNIT_ASSERT_EQUAL(799, snapshot.max());
+}
+
+}
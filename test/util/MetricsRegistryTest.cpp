@@ -0,0 +1,216 @@
+#include <sstream>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Exception.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/MetricsRegistry.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class MetricsRegistryTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(MetricsRegistryTest);
+	CPPUNIT_TEST(testCounter);
+	CPPUNIT_TEST(testGauge);
+	CPPUNIT_TEST(testSameInstance);
+	CPPUNIT_TEST(testValidName);
+	CPPUNIT_TEST(testTypeMismatch);
+	CPPUNIT_TEST(testFormatLabels);
+	CPPUNIT_TEST(testPrint);
+	CPPUNIT_TEST(testPrintSummary);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testCounter();
+	void testGauge();
+	void testSameInstance();
+	void testValidName();
+	void testTypeMismatch();
+	void testFormatLabels();
+	void testPrint();
+	void testPrintSummary();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MetricsRegistryTest);
+
+void MetricsRegistryTest::testCounter()
+{
+	MetricCounter counter;
+
+	CPPUNIT_ASSERT_EQUAL(0, counter.value());
+
+	counter.inc();
+	counter.inc(10);
+
+	CPPUNIT_ASSERT_EQUAL(11, counter.value());
+}
+
+void MetricsRegistryTest::testGauge()
+{
+	MetricGauge gauge;
+
+	CPPUNIT_ASSERT_EQUAL(0, gauge.value());
+
+	gauge.inc(5);
+	gauge.dec(7);
+	CPPUNIT_ASSERT_EQUAL(-2, gauge.value());
+
+	gauge.set(42);
+	CPPUNIT_ASSERT_EQUAL(42, gauge.value());
+}
+
+/**
+ * @brief Registering the same name and labels twice returns the same
+ * instance, different labels lead to a different instance.
+ */
+void MetricsRegistryTest::testSameInstance()
+{
+	MetricsRegistry registry;
+
+	MetricCounter &a = registry.counter("test_total", "help", {{"a", "1"}});
+	MetricCounter &b = registry.counter("test_total", "help", {{"a", "1"}});
+	MetricCounter &c = registry.counter("test_total", "help", {{"a", "2"}});
+
+	CPPUNIT_ASSERT(&a == &b);
+	CPPUNIT_ASSERT(&a != &c);
+
+	LatencyHistogram &h0 = registry.histogram("test_seconds", "help");
+	LatencyHistogram &h1 = registry.histogram("test_seconds", "help");
+
+	CPPUNIT_ASSERT(&h0 == &h1);
+}
+
+void MetricsRegistryTest::testValidName()
+{
+	MetricsRegistry::assureValidName("beeeon_test_total");
+	MetricsRegistry::assureValidName("beeeon:test_2");
+	MetricsRegistry::assureValidName("_x");
+
+	CPPUNIT_ASSERT_THROW(
+		MetricsRegistry::assureValidName(""),
+		InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(
+		MetricsRegistry::assureValidName("2xx"),
+		InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(
+		MetricsRegistry::assureValidName("test-total"),
+		InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(
+		MetricsRegistry::assureValidName("test total"),
+		InvalidArgumentException);
+
+	MetricsRegistry registry;
+
+	CPPUNIT_ASSERT_THROW(
+		registry.counter("test total", "help"),
+		InvalidArgumentException);
+	CPPUNIT_ASSERT_THROW(
+		registry.gauge("test", "help", {{"bad-label", "x"}}),
+		InvalidArgumentException);
+}
+
+void MetricsRegistryTest::testTypeMismatch()
+{
+	MetricsRegistry registry;
+
+	registry.counter("test", "help");
+
+	CPPUNIT_ASSERT_THROW(
+		registry.gauge("test", "help"),
+		IllegalStateException);
+	CPPUNIT_ASSERT_THROW(
+		registry.histogram("test", "help"),
+		IllegalStateException);
+}
+
+void MetricsRegistryTest::testFormatLabels()
+{
+	CPPUNIT_ASSERT_EQUAL("", MetricsRegistry::formatLabels({}));
+	CPPUNIT_ASSERT_EQUAL(
+		"{a=\"1\",b=\"x\"}",
+		MetricsRegistry::formatLabels({{"b", "x"}, {"a", "1"}}));
+	CPPUNIT_ASSERT_EQUAL(
+		"{a=\"q\\\"b\\\\s\\nn\"}",
+		MetricsRegistry::formatLabels({{"a", "q\"b\\s\nn"}}));
+}
+
+void MetricsRegistryTest::testPrint()
+{
+	MetricsRegistry registry;
+
+	registry.counter("test_total", "Test counter", {{"kind", "a"}}).inc(3);
+	registry.counter("test_total", "Test counter", {{"kind", "b"}}).inc();
+	registry.gauge("test_level", "Test gauge").set(-4);
+
+	ostringstream out;
+	registry.print(out);
+
+	CPPUNIT_ASSERT_EQUAL(
+		"# HELP test_level Test gauge\n"
+		"# TYPE test_level gauge\n"
+		"test_level -4\n"
+		"# HELP test_total Test counter\n"
+		"# TYPE test_total counter\n"
+		"test_total{kind=\"a\"} 3\n"
+		"test_total{kind=\"b\"} 1\n",
+		out.str());
+}
+
+/**
+ * @brief Histograms are exposed as summaries in seconds. An empty
+ * summary reports NaN quantiles.
+ */
+void MetricsRegistryTest::testPrintSummary()
+{
+	MetricsRegistry registry;
+
+	LatencyHistogram &histogram = registry.histogram(
+		"test_seconds", "Test latency", {{"stage", "x"}});
+
+	ostringstream empty;
+	registry.print(empty);
+
+	CPPUNIT_ASSERT_EQUAL(
+		"# HELP test_seconds Test latency\n"
+		"# TYPE test_seconds summary\n"
+		"test_seconds{quantile=\"0.5\",stage=\"x\"} NaN\n"
+		"test_seconds{quantile=\"0.9\",stage=\"x\"} NaN\n"
+		"test_seconds{quantile=\"0.99\",stage=\"x\"} NaN\n"
+		"test_seconds{quantile=\"0.999\",stage=\"x\"} NaN\n"
+		"test_seconds_sum{stage=\"x\"} 0\n"
+		"test_seconds_count{stage=\"x\"} 0\n",
+		empty.str());
+
+	// values up to 2 * SUB_BUCKETS are stored exactly
+	histogram.record(20);
+	histogram.record(20);
+
+	ostringstream out;
+	registry.print(out);
+
+	CPPUNIT_ASSERT_EQUAL(
+		"# HELP test_seconds Test latency\n"
+		"# TYPE test_seconds summary\n"
+		"test_seconds{quantile=\"0.5\",stage=\"x\"} 2e-05\n"
+		"test_seconds{quantile=\"0.9\",stage=\"x\"} 2e-05\n"
+		"test_seconds{quantile=\"0.99\",stage=\"x\"} 2e-05\n"
+		"test_seconds{quantile=\"0.999\",stage=\"x\"} 2e-05\n"
+		"test_seconds_sum{stage=\"x\"} 4e-05\n"
+		"test_seconds_count{stage=\"x\"} 2\n",
+		out.str());
+
+	// the sum is printed with full precision
+	histogram.reset();
+	histogram.record(1234567891);
+
+	ostringstream large;
+	registry.print(large);
+
+	CPPUNIT_ASSERT(large.str().find(
+		"test_seconds_sum{stage=\"x\"} 1234.567891\n") != string::npos);
+}
+
+}
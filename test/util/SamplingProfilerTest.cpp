@@ -0,0 +1,107 @@
+#include <sstream>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Clock.h>
+#include <Poco/Exception.h>
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/SamplingProfiler.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class SamplingProfilerTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(SamplingProfilerTest);
+	CPPUNIT_TEST(testEmpty);
+	CPPUNIT_TEST(testStartTwice);
+	CPPUNIT_TEST(testSampleLabelledThread);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testEmpty();
+	void testStartTwice();
+	void testSampleLabelledThread();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SamplingProfilerTest);
+
+static volatile unsigned long sink;
+
+static void burnCPU(const Timespan &duration)
+{
+	const Clock started;
+
+	while (!started.isElapsed(duration.totalMicroseconds())) {
+		for (unsigned int i = 0; i < 10000; ++i)
+			sink = sink + i;
+	}
+}
+
+void SamplingProfilerTest::testEmpty()
+{
+	SamplingProfiler profiler;
+
+	CPPUNIT_ASSERT(!profiler.running());
+	CPPUNIT_ASSERT_EQUAL(0, profiler.sampleCount());
+
+	ostringstream out;
+	profiler.dump(out);
+
+	CPPUNIT_ASSERT(out.str().empty());
+}
+
+void SamplingProfilerTest::testStartTwice()
+{
+	SamplingProfiler profiler;
+
+	profiler.start(10 * Timespan::MILLISECONDS);
+	CPPUNIT_ASSERT(profiler.running());
+
+	CPPUNIT_ASSERT_THROW(
+		profiler.start(10 * Timespan::MILLISECONDS),
+		IllegalStateException);
+
+	profiler.stop();
+	CPPUNIT_ASSERT(!profiler.running());
+
+	CPPUNIT_ASSERT_THROW(profiler.start(0), InvalidArgumentException);
+}
+
+/**
+ * @brief Samples of a busy labelled thread must be reported
+ * as folded stacks starting with the thread's label.
+ */
+void SamplingProfilerTest::testSampleLabelledThread()
+{
+	SamplingProfiler profiler;
+	Thread thread;
+
+	profiler.start(1 * Timespan::MILLISECONDS);
+
+	thread.startFunc([]() {
+		SamplingProfiler::labelThread("test-burner");
+		burnCPU(300 * Timespan::MILLISECONDS);
+	});
+	thread.join();
+
+	profiler.stop();
+
+	CPPUNIT_ASSERT(profiler.sampleCount() > 0);
+
+	ostringstream out;
+	profiler.dump(out);
+
+	CPPUNIT_ASSERT(out.str().find("test-burner;") != string::npos);
+
+	profiler.clear();
+	CPPUNIT_ASSERT_EQUAL(0, profiler.sampleCount());
+
+	ostringstream empty;
+	profiler.dump(empty);
+	CPPUNIT_ASSERT(empty.str().empty());
+}
+
+}
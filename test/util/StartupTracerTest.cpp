@@ -0,0 +1,124 @@
+#include <sstream>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/StartupTracer.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class StartupTracerTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(StartupTracerTest);
+	CPPUNIT_TEST(testScope);
+	CPPUNIT_TEST(testMarkFirstOnly);
+	CPPUNIT_TEST(testUnknownMilestone);
+	CPPUNIT_TEST(testBudget);
+	CPPUNIT_TEST(testPrint);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testScope();
+	void testMarkFirstOnly();
+	void testUnknownMilestone();
+	void testBudget();
+	void testPrint();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StartupTracerTest);
+
+void StartupTracerTest::testScope()
+{
+	StartupTracer tracer;
+
+	{
+		StartupTracer::Scope scope("sleeping", tracer);
+		Thread::sleep(20);
+	}
+
+	const auto phases = tracer.phases();
+
+	CPPUNIT_ASSERT_EQUAL(1, phases.size());
+	CPPUNIT_ASSERT_EQUAL("sleeping", phases[0].name);
+	CPPUNIT_ASSERT(phases[0].start >= 0);
+	CPPUNIT_ASSERT(phases[0].duration >= 20 * Timespan::MILLISECONDS);
+}
+
+void StartupTracerTest::testMarkFirstOnly()
+{
+	StartupTracer tracer;
+
+	tracer.mark("ready");
+	const Timespan first = tracer.milestone("ready");
+
+	Thread::sleep(20);
+	tracer.mark("ready");
+
+	CPPUNIT_ASSERT(first >= 0);
+	CPPUNIT_ASSERT_EQUAL(first.totalMicroseconds(),
+		tracer.milestone("ready").totalMicroseconds());
+}
+
+void StartupTracerTest::testUnknownMilestone()
+{
+	StartupTracer tracer;
+
+	CPPUNIT_ASSERT(tracer.milestone("unknown") < 0);
+	CPPUNIT_ASSERT(!tracer.withinBudget("unknown", 1 * Timespan::HOURS));
+}
+
+/**
+ * @brief The milestone reached after a slow phase is within
+ * a generous budget but exceeds a budget shorter than the phase.
+ */
+void StartupTracerTest::testBudget()
+{
+	StartupTracer tracer;
+
+	{
+		StartupTracer::Scope scope("slow", tracer);
+		Thread::sleep(50);
+	}
+
+	tracer.mark("started");
+
+	CPPUNIT_ASSERT(tracer.withinBudget("started", 10 * Timespan::SECONDS));
+	CPPUNIT_ASSERT(!tracer.withinBudget("started", 10 * Timespan::MILLISECONDS));
+}
+
+/**
+ * @brief Phases are printed from the longest one, milestones follow.
+ */
+void StartupTracerTest::testPrint()
+{
+	StartupTracer tracer;
+
+	{
+		StartupTracer::Scope scope("short", tracer);
+	}
+	{
+		StartupTracer::Scope scope("long", tracer);
+		Thread::sleep(20);
+	}
+
+	tracer.mark("started");
+
+	ostringstream out;
+	tracer.print(out);
+
+	const string &text = out.str();
+	const size_t longAt = text.find(" long ");
+	const size_t shortAt = text.find(" short ");
+	const size_t startedAt = text.find("milestone started");
+
+	CPPUNIT_ASSERT(longAt != string::npos);
+	CPPUNIT_ASSERT(shortAt != string::npos);
+	CPPUNIT_ASSERT(startedAt != string::npos);
+	CPPUNIT_ASSERT(longAt < shortAt);
+	CPPUNIT_ASSERT(shortAt < startedAt);
+}
+
+}
@@ -0,0 +1,159 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+
+#include "cppunit/BetterAssert.h"
+
+#include "model/DeviceID.h"
+#include "vdev/VirtualDeviceTimerWheel.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class VirtualDeviceTimerWheelTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(VirtualDeviceTimerWheelTest);
+	CPPUNIT_TEST(testExpireInOrder);
+	CPPUNIT_TEST(testExpireAfterMoreRotations);
+	CPPUNIT_TEST(testScheduleIntoPast);
+	CPPUNIT_TEST(testUntilNext);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testExpireInOrder();
+	void testExpireAfterMoreRotations();
+	void testScheduleIntoPast();
+	void testUntilNext();
+
+protected:
+	VirtualDeviceEntry createEntry(
+		uint64_t ident,
+		const Timestamp &inserted,
+		const Timespan &delay);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(VirtualDeviceTimerWheelTest);
+
+VirtualDeviceEntry VirtualDeviceTimerWheelTest::createEntry(
+		uint64_t ident,
+		const Timestamp &inserted,
+		const Timespan &delay)
+{
+	VirtualDevice::Ptr device = new VirtualDevice;
+	device->setDeviceId(DeviceID(0xa300000000000000UL | ident));
+
+	VirtualDeviceEntry entry(device);
+	entry.setInserted(inserted);
+	entry.setDelay(delay);
+
+	return entry;
+}
+
+/**
+ * @brief Test that entries planned within a single rotation of the wheel
+ * expire exactly when the wheel is advanced over their activation time.
+ */
+void VirtualDeviceTimerWheelTest::testExpireInOrder()
+{
+	const Timestamp origin(1000 * Timespan::SECONDS);
+	VirtualDeviceTimerWheel wheel(1 * Timespan::MILLISECONDS, 16, origin);
+	vector<VirtualDeviceEntry> expired;
+
+	wheel.schedule(createEntry(1, origin, 5 * Timespan::MILLISECONDS));
+	wheel.schedule(createEntry(2, origin, 3 * Timespan::MILLISECONDS));
+	wheel.schedule(createEntry(3, origin, 10 * Timespan::MILLISECONDS));
+	CPPUNIT_ASSERT_EQUAL(3, wheel.size());
+
+	wheel.advance(origin + 2 * Timespan::MILLISECONDS, expired);
+	CPPUNIT_ASSERT(expired.empty());
+
+	wheel.advance(origin + 5 * Timespan::MILLISECONDS, expired);
+	CPPUNIT_ASSERT_EQUAL(2, expired.size());
+	CPPUNIT_ASSERT_EQUAL(DeviceID(0xa300000000000002UL), expired[0].device()->deviceID());
+	CPPUNIT_ASSERT_EQUAL(DeviceID(0xa300000000000001UL), expired[1].device()->deviceID());
+	expired.clear();
+
+	wheel.advance(origin + 10 * Timespan::MILLISECONDS, expired);
+	CPPUNIT_ASSERT_EQUAL(1, expired.size());
+	CPPUNIT_ASSERT_EQUAL(DeviceID(0xa300000000000003UL), expired[0].device()->deviceID());
+	CPPUNIT_ASSERT(wheel.empty());
+}
+
+/**
+ * @brief Test that an entry planned several rotations ahead stays in
+ * the wheel until its activation time, even when the wheel is advanced
+ * over its slot multiple times or skips many ticks at once.
+ */
+void VirtualDeviceTimerWheelTest::testExpireAfterMoreRotations()
+{
+	const Timestamp origin(1000 * Timespan::SECONDS);
+	VirtualDeviceTimerWheel wheel(1 * Timespan::MILLISECONDS, 8, origin);
+	vector<VirtualDeviceEntry> expired;
+
+	wheel.schedule(createEntry(1, origin, 20 * Timespan::MILLISECONDS));
+
+	for (int i = 1; i < 20; ++i) {
+		wheel.advance(origin + i * Timespan::MILLISECONDS, expired);
+		CPPUNIT_ASSERT(expired.empty());
+	}
+
+	wheel.advance(origin + 20 * Timespan::MILLISECONDS, expired);
+	CPPUNIT_ASSERT_EQUAL(1, expired.size());
+	expired.clear();
+
+	wheel.schedule(createEntry(2, origin, 100 * Timespan::MILLISECONDS));
+	wheel.advance(origin + 1 * Timespan::SECONDS, expired);
+	CPPUNIT_ASSERT_EQUAL(1, expired.size());
+	CPPUNIT_ASSERT(wheel.empty());
+}
+
+/**
+ * @brief Test that an entry whose activation time has already passed
+ * expires by the next advance of the wheel.
+ */
+void VirtualDeviceTimerWheelTest::testScheduleIntoPast()
+{
+	const Timestamp origin(1000 * Timespan::SECONDS);
+	VirtualDeviceTimerWheel wheel(1 * Timespan::MILLISECONDS, 16, origin);
+	vector<VirtualDeviceEntry> expired;
+
+	wheel.advance(origin + 50 * Timespan::MILLISECONDS, expired);
+	CPPUNIT_ASSERT(expired.empty());
+
+	wheel.schedule(createEntry(1, origin, 10 * Timespan::MILLISECONDS));
+	wheel.advance(origin + 51 * Timespan::MILLISECONDS, expired);
+	CPPUNIT_ASSERT_EQUAL(1, expired.size());
+}
+
+/**
+ * @brief Test computation of the time remaining to the nearest activation.
+ */
+void VirtualDeviceTimerWheelTest::testUntilNext()
+{
+	const Timestamp origin(1000 * Timespan::SECONDS);
+	VirtualDeviceTimerWheel wheel(1 * Timespan::MILLISECONDS, 16, origin);
+
+	CPPUNIT_ASSERT(wheel.untilNext(origin) < 0);
+
+	wheel.schedule(createEntry(1, origin, 7 * Timespan::MILLISECONDS));
+	CPPUNIT_ASSERT_EQUAL(
+		7 * Timespan::MILLISECONDS,
+		wheel.untilNext(origin).totalMicroseconds());
+
+	wheel.schedule(createEntry(2, origin, 1 * Timespan::SECONDS));
+	CPPUNIT_ASSERT_EQUAL(
+		7 * Timespan::MILLISECONDS,
+		wheel.untilNext(origin).totalMicroseconds());
+
+	vector<VirtualDeviceEntry> expired;
+	wheel.advance(origin + 7 * Timespan::MILLISECONDS, expired);
+	CPPUNIT_ASSERT_EQUAL(1, expired.size());
+
+	// the remaining entry is more than 1 rotation ahead
+	CPPUNIT_ASSERT_EQUAL(
+		16 * Timespan::MILLISECONDS,
+		wheel.untilNext(origin + 7 * Timespan::MILLISECONDS).totalMicroseconds());
+}
+
+}
@@ -18,12 +18,14 @@ class GenericZWaveMapperRegistryTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testResolveNonQueriedNode);
 	CPPUNIT_TEST(testResolveUnsupportedNode);
 	CPPUNIT_TEST(testResolveTempSensor);
+	CPPUNIT_TEST(testResolveBuiltinMapping);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
 	void testResolveNonQueriedNode();
 	void testResolveUnsupportedNode();
 	void testResolveTempSensor();
+	void testResolveBuiltinMapping();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(GenericZWaveMapperRegistryTest);
@@ -100,4 +102,35 @@ void GenericZWaveMapperRegistryTest::testResolveTempSensor()
 	CPPUNIT_ASSERT(it == types.end());
 }
 
+/**
+ * @brief The mapping compiled from types-mapping.xml maps the sensor
+ * multilevel (temperature) before the battery as defined there.
+ */
+void GenericZWaveMapperRegistryTest::testResolveBuiltinMapping()
+{
+	GenericZWaveMapperRegistry registry;
+	registry.loadTypesMapping("");
+
+	ZWaveNode node({0x1000, 120});
+	node.add({CC::BATTERY, 0, 0});
+	node.add({CC::SENSOR_MULTILEVEL, 1, 0});
+	node.setQueried(true);
+
+	ZWaveMapperRegistry::Mapper::Ptr mapper = registry.resolve(node);
+	CPPUNIT_ASSERT(!mapper.isNull());
+
+	const auto types = mapper->types();
+	CPPUNIT_ASSERT_EQUAL(2, types.size());
+
+	auto it = types.begin();
+	CPPUNIT_ASSERT_EQUAL(
+		ModuleType::Type::TYPE_TEMPERATURE,
+		it->type().raw());
+
+	++it;
+	CPPUNIT_ASSERT_EQUAL(
+		ModuleType::Type::TYPE_BATTERY,
+		it->type().raw());
+}
+
 }
@@ -0,0 +1,137 @@
+#include <Poco/Exception.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cppunit/BetterAssert.h"
+#include "util/InputTrace.h"
+#include "zwave/ZWaveEventTrace.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+class ZWaveEventTraceTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(ZWaveEventTraceTest);
+	CPPUNIT_TEST(testNodeRoundTrip);
+	CPPUNIT_TEST(testValueRoundTrip);
+	CPPUNIT_TEST(testSimpleEvents);
+	CPPUNIT_TEST(testDecodeInvalid);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	using PollEvent = ZWaveNetwork::PollEvent;
+	using CommandClass = ZWaveNode::CommandClass;
+
+	void testNodeRoundTrip();
+	void testValueRoundTrip();
+	void testSimpleEvents();
+	void testDecodeInvalid();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ZWaveEventTraceTest);
+
+void ZWaveEventTraceTest::testNodeRoundTrip()
+{
+	ZWaveNode node({0xcafe0001, 7});
+	node.setSupport(ZWaveNode::SUPPORT_LISTENING | ZWaveNode::SUPPORT_ZWAVEPLUS);
+	node.setProductId(0x1001);
+	node.setProduct("FGWPE Wall Plug");
+	node.setProductType(0x0600);
+	node.setVendorId(0x010f);
+	node.setVendor("FIBARO System");
+	node.setQueried(true);
+	node.add(CommandClass(CommandClass::SWITCH_BINARY, 0, 1, "Switch"));
+	node.add(CommandClass(CommandClass::SENSOR_MULTILEVEL, 4, 1, "Power"));
+
+	const PollEvent &event = ZWaveEventTrace::decode(
+		ZWaveEventTrace::encode(PollEvent::createUpdateNode(node)));
+
+	CPPUNIT_ASSERT_EQUAL(PollEvent::EVENT_UPDATE_NODE, event.type());
+
+	const ZWaveNode &decoded = event.node();
+	CPPUNIT_ASSERT(decoded.id() == node.id());
+	CPPUNIT_ASSERT(!decoded.controller());
+	CPPUNIT_ASSERT_EQUAL(node.support(), decoded.support());
+	CPPUNIT_ASSERT_EQUAL(0x1001, decoded.productId());
+	CPPUNIT_ASSERT_EQUAL("FGWPE Wall Plug", decoded.product());
+	CPPUNIT_ASSERT_EQUAL(0x0600, decoded.productType());
+	CPPUNIT_ASSERT_EQUAL(0x010f, decoded.vendorId());
+	CPPUNIT_ASSERT_EQUAL("FIBARO System", decoded.vendor());
+	CPPUNIT_ASSERT(decoded.queried());
+
+	CPPUNIT_ASSERT_EQUAL(2, decoded.commandClasses().size());
+
+	auto it = decoded.commandClasses().begin();
+	CPPUNIT_ASSERT_EQUAL(CommandClass::SWITCH_BINARY, it->id());
+	CPPUNIT_ASSERT_EQUAL("Switch", it->name());
+
+	++it;
+	CPPUNIT_ASSERT_EQUAL(CommandClass::SENSOR_MULTILEVEL, it->id());
+	CPPUNIT_ASSERT_EQUAL(4, it->index());
+	CPPUNIT_ASSERT_EQUAL(1, it->instance());
+	CPPUNIT_ASSERT_EQUAL("Power", it->name());
+}
+
+void ZWaveEventTraceTest::testValueRoundTrip()
+{
+	const ZWaveNode::Value value(
+		ZWaveNode::Identity(0xcafe0001, 7),
+		CommandClass(CommandClass::SENSOR_MULTILEVEL, 4, 1, "Power"),
+		"12.5",
+		"W");
+
+	const PollEvent &event = ZWaveEventTrace::decode(
+		ZWaveEventTrace::encode(PollEvent::createValue(value)));
+
+	CPPUNIT_ASSERT_EQUAL(PollEvent::EVENT_VALUE, event.type());
+	CPPUNIT_ASSERT(event.value().node() == value.node());
+	CPPUNIT_ASSERT_EQUAL(CommandClass::SENSOR_MULTILEVEL, event.value().commandClass().id());
+	CPPUNIT_ASSERT_EQUAL(4, event.value().commandClass().index());
+	CPPUNIT_ASSERT_EQUAL("12.5", event.value().value());
+	CPPUNIT_ASSERT_EQUAL("W", event.value().unit());
+}
+
+void ZWaveEventTraceTest::testSimpleEvents()
+{
+	CPPUNIT_ASSERT(ZWaveEventTrace::decode(
+		ZWaveEventTrace::encode(PollEvent())).isNone());
+
+	CPPUNIT_ASSERT_EQUAL(PollEvent::EVENT_INCLUSION_START,
+		ZWaveEventTrace::decode(ZWaveEventTrace::encode(
+			PollEvent::createInclusionStart())).type());
+
+	CPPUNIT_ASSERT_EQUAL(PollEvent::EVENT_REMOVE_NODE_DONE,
+		ZWaveEventTrace::decode(ZWaveEventTrace::encode(
+			PollEvent::createRemoveNodeDone())).type());
+
+	CPPUNIT_ASSERT_EQUAL(PollEvent::EVENT_READY,
+		ZWaveEventTrace::decode(ZWaveEventTrace::encode(
+			PollEvent::createReady())).type());
+}
+
+/**
+ * Unknown event types and truncated payloads are reported
+ * as DataFormatException.
+ */
+void ZWaveEventTraceTest::testDecodeInvalid()
+{
+	InputTraceEncoder unknown;
+	unknown.putUnsigned(6);
+
+	CPPUNIT_ASSERT_THROW(
+		ZWaveEventTrace::decode(unknown.data()),
+		DataFormatException);
+
+	CPPUNIT_ASSERT_THROW(
+		ZWaveEventTrace::decode(""),
+		DataFormatException);
+
+	const string &payload = ZWaveEventTrace::encode(
+		PollEvent::createNewNode(ZWaveNode({1, 2})));
+
+	CPPUNIT_ASSERT_THROW(
+		ZWaveEventTrace::decode(payload.substr(0, payload.size() - 1)),
+		DataFormatException);
+}
+
+}
@@ -0,0 +1,375 @@
+#include <cstdlib>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <Poco/Clock.h>
+#include <Poco/Event.h>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+
+#include "cppunit/BetterAssert.h"
+#include "hotplug/HotplugEvent.h"
+#include "io/SerialReactor.h"
+#include "zwave/ZWaveParallelProber.h"
+
+using namespace Poco;
+using namespace std;
+
+namespace BeeeOn {
+
+/**
+ * Tests of ZWaveParallelProber probing pseudo terminals. A Z-Wave
+ * controller is simulated on the master side of a pseudo terminal.
+ */
+class ZWaveParallelProberTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(ZWaveParallelProberTest);
+	CPPUNIT_TEST(testDetect);
+	CPPUNIT_TEST(testConcurrent);
+	CPPUNIT_TEST(testReplugCached);
+	CPPUNIT_TEST(testCancel);
+	CPPUNIT_TEST(testOtherDeviceCached);
+	CPPUNIT_TEST(testReplugWhileProbing);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() override;
+	void tearDown() override;
+
+	void testDetect();
+	void testConcurrent();
+	void testReplugCached();
+	void testCancel();
+	void testOtherDeviceCached();
+	void testReplugWhileProbing();
+
+private:
+	HotplugEvent openDevice(const string &serial);
+
+	/**
+	 * @brief Wait until the NACK and the version request are received.
+	 */
+	bool receiveRequest(int master);
+
+	/**
+	 * @brief Answer the version request like a Z-Wave controller.
+	 */
+	void respond(int master);
+
+	SerialReactor::Ptr m_reactor;
+	Thread m_thread;
+	vector<int> m_masters;
+
+	FastMutex m_lock;
+	vector<string> m_detected;
+	Event m_event;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ZWaveParallelProberTest);
+
+void ZWaveParallelProberTest::setUp()
+{
+	m_detected.clear();
+	m_event.reset();
+
+	m_reactor = new SerialReactor;
+	m_thread.start(*m_reactor);
+}
+
+void ZWaveParallelProberTest::tearDown()
+{
+	m_reactor->stop();
+	m_thread.join();
+	m_reactor = nullptr;
+
+	for (const auto master : m_masters)
+		::close(master);
+
+	m_masters.clear();
+}
+
+HotplugEvent ZWaveParallelProberTest::openDevice(const string &serial)
+{
+	const int master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+	CPPUNIT_ASSERT(master >= 0);
+
+	m_masters.push_back(master);
+
+	CPPUNIT_ASSERT_EQUAL(0, ::grantpt(master));
+	CPPUNIT_ASSERT_EQUAL(0, ::unlockpt(master));
+
+	HotplugEvent event;
+	event.setSubsystem("tty");
+	event.setNode(::ptsname(master));
+	event.properties()->setString("tty.BEEEON_PROBE", "1");
+	event.properties()->setString("tty.ID_VENDOR_ID", "0658");
+	event.properties()->setString("tty.ID_MODEL_ID", "0200");
+	event.properties()->setString("tty.ID_SERIAL_SHORT", serial);
+
+	return event;
+}
+
+bool ZWaveParallelProberTest::receiveRequest(int master)
+{
+	// NACK and the version request
+	size_t expected = 1 + 5;
+	char buffer[16];
+
+	while (expected > 0) {
+		struct pollfd pfd = {master, POLLIN, 0};
+		if (::poll(&pfd, 1, 1000) <= 0)
+			return false;
+
+		const ssize_t ret = ::read(master, buffer, sizeof(buffer));
+		if (ret <= 0)
+			return false;
+
+		expected -= min<size_t>(expected, ret);
+	}
+
+	return true;
+}
+
+void ZWaveParallelProberTest::respond(int master)
+{
+	if (!receiveRequest(master))
+		return;
+
+	const string payload = string("\x01\x15Z-Wave 4.05", 13) + string(1, '\0') + "\x01";
+
+	uint8_t csum = 0xff ^ static_cast<uint8_t>(payload.size() + 1);
+	for (const auto c : payload)
+		csum ^= static_cast<uint8_t>(c);
+
+	const string answer = string("\x06\x01", 2)
+		+ static_cast<char>(payload.size() + 1)
+		+ payload
+		+ static_cast<char>(csum);
+
+	CPPUNIT_ASSERT_EQUAL(
+		ssize_t(answer.size()),
+		::write(master, answer.data(), answer.size()));
+}
+
+void ZWaveParallelProberTest::testDetect()
+{
+	ZWaveParallelProber prober;
+	prober.setSerialReactor(m_reactor);
+	prober.setTimeout(1 * Timespan::SECONDS);
+
+	const HotplugEvent event = openDevice("A1B2C3");
+	const int master = m_masters.back();
+
+	Thread responder;
+	responder.startFunc([&]() {
+		respond(master);
+	});
+
+	prober.probe(event, [&](const HotplugEvent &detected) {
+		FastMutex::ScopedLock guard(m_lock);
+		m_detected.emplace_back(detected.node());
+		m_event.set();
+	});
+
+	CPPUNIT_ASSERT(m_event.tryWait(2000));
+	responder.join();
+	prober.wait();
+
+	CPPUNIT_ASSERT_EQUAL(1, m_detected.size());
+	CPPUNIT_ASSERT_EQUAL(event.node(), m_detected[0]);
+	CPPUNIT_ASSERT(prober.cache().lookup("0658:0200:A1B2C3") == ZWaveProbeCache::ZWAVE);
+}
+
+/**
+ * Silent devices are probed concurrently, thus all of them
+ * time out at about the same time. A timeout is not a definite
+ * result, thus it is not cached.
+ */
+void ZWaveParallelProberTest::testConcurrent()
+{
+	const Timespan timeout = 300 * Timespan::MILLISECONDS;
+
+	ZWaveParallelProber prober;
+	prober.setSerialReactor(m_reactor);
+	prober.setTimeout(timeout);
+
+	const Clock started;
+
+	for (const auto &serial : {"0001", "0002", "0003", "0004"}) {
+		prober.probe(openDevice(serial), [&](const HotplugEvent &detected) {
+			FastMutex::ScopedLock guard(m_lock);
+			m_detected.emplace_back(detected.node());
+		});
+	}
+
+	CPPUNIT_ASSERT_EQUAL(4, prober.running());
+
+	prober.wait();
+
+	CPPUNIT_ASSERT(started.elapsed() < 2 * timeout.totalMicroseconds());
+	CPPUNIT_ASSERT_EQUAL(0, prober.running());
+	CPPUNIT_ASSERT(m_detected.empty());
+
+	CPPUNIT_ASSERT_EQUAL(0, prober.cache().size());
+	CPPUNIT_ASSERT(prober.cache().lookup("0658:0200:0003") == ZWaveProbeCache::UNKNOWN);
+}
+
+/**
+ * A device known from its previous appearance is resolved
+ * immediately without probing.
+ */
+void ZWaveParallelProberTest::testReplugCached()
+{
+	ZWaveParallelProber prober;
+	prober.setSerialReactor(m_reactor);
+	prober.setTimeout(1 * Timespan::SECONDS);
+
+	const HotplugEvent first = openDevice("A1B2C3");
+	const int master = m_masters.back();
+
+	Thread responder;
+	responder.startFunc([&]() {
+		respond(master);
+	});
+
+	prober.probe(first, [](const HotplugEvent &) {});
+	responder.join();
+	prober.wait();
+
+	CPPUNIT_ASSERT(prober.cache().lookup("0658:0200:A1B2C3") == ZWaveProbeCache::ZWAVE);
+
+	// replugged device appears as a different node and does not respond
+	const HotplugEvent second = openDevice("A1B2C3");
+	bool detected = false;
+
+	prober.probe(second, [&](const HotplugEvent &event) {
+		CPPUNIT_ASSERT_EQUAL(second.node(), event.node());
+		detected = true;
+	});
+
+	CPPUNIT_ASSERT(detected);
+	CPPUNIT_ASSERT_EQUAL(0, prober.running());
+}
+
+/**
+ * Result of a cancelled probing is neither reported nor cached.
+ */
+void ZWaveParallelProberTest::testCancel()
+{
+	ZWaveParallelProber prober;
+	prober.setSerialReactor(m_reactor);
+	prober.setTimeout(300 * Timespan::MILLISECONDS);
+
+	const HotplugEvent event = openDevice("A1B2C3");
+	const int master = m_masters.back();
+
+	prober.probe(event, [&](const HotplugEvent &detected) {
+		FastMutex::ScopedLock guard(m_lock);
+		m_detected.emplace_back(detected.node());
+	});
+
+	prober.cancel(event.node());
+	respond(master);
+	prober.wait();
+
+	CPPUNIT_ASSERT(m_detected.empty());
+	CPPUNIT_ASSERT_EQUAL(0, prober.cache().size());
+}
+
+/**
+ * A device answering with data not following the Z-Wave serial API
+ * is definitely not a Z-Wave controller and it is not probed again.
+ */
+void ZWaveParallelProberTest::testOtherDeviceCached()
+{
+	ZWaveParallelProber prober;
+	prober.setSerialReactor(m_reactor);
+	prober.setTimeout(300 * Timespan::MILLISECONDS);
+
+	const HotplugEvent event = openDevice("A1B2C3");
+	const int master = m_masters.back();
+
+	Thread responder;
+	responder.startFunc([&]() {
+		if (!receiveRequest(master))
+			return;
+
+		// a modem echoing commands instead of ACK
+		CPPUNIT_ASSERT_EQUAL(3, ::write(master, "AT\r", 3));
+	});
+
+	prober.probe(event, [&](const HotplugEvent &detected) {
+		FastMutex::ScopedLock guard(m_lock);
+		m_detected.emplace_back(detected.node());
+	});
+
+	responder.join();
+	prober.wait();
+
+	CPPUNIT_ASSERT(m_detected.empty());
+	CPPUNIT_ASSERT(prober.cache().lookup("0658:0200:A1B2C3") == ZWaveProbeCache::OTHER);
+}
+
+/**
+ * A device replugged while being probed appears under the same node.
+ * The probing of the unplugged device is cancelled but still running,
+ * the replugged device must be probed again.
+ */
+void ZWaveParallelProberTest::testReplugWhileProbing()
+{
+	ZWaveParallelProber prober;
+	prober.setSerialReactor(m_reactor);
+	prober.setTimeout(1 * Timespan::SECONDS);
+
+	char dir[] = "/tmp/zwave-replug.XXXXXX";
+	CPPUNIT_ASSERT(::mkdtemp(dir) != nullptr);
+	const string node = string(dir) + "/ttyACM0";
+
+	// the unplugged device never answers
+	HotplugEvent unplugged = openDevice("A1B2C3");
+	CPPUNIT_ASSERT_EQUAL(0, ::symlink(unplugged.node().c_str(), node.c_str()));
+	unplugged.setNode(node);
+
+	prober.probe(unplugged, [&](const HotplugEvent &detected) {
+		FastMutex::ScopedLock guard(m_lock);
+		m_detected.emplace_back("unplugged " + detected.node());
+	});
+
+	CPPUNIT_ASSERT_EQUAL(1, prober.running());
+	prober.cancel(node);
+
+	HotplugEvent replugged = openDevice("A1B2C3");
+	const int master = m_masters.back();
+	CPPUNIT_ASSERT_EQUAL(0, ::unlink(node.c_str()));
+	CPPUNIT_ASSERT_EQUAL(0, ::symlink(replugged.node().c_str(), node.c_str()));
+	replugged.setNode(node);
+
+	Thread responder;
+	responder.startFunc([&]() {
+		respond(master);
+	});
+
+	prober.probe(replugged, [&](const HotplugEvent &detected) {
+		FastMutex::ScopedLock guard(m_lock);
+		m_detected.emplace_back(detected.node());
+		m_event.set();
+	});
+
+	CPPUNIT_ASSERT_EQUAL(2, prober.running());
+	CPPUNIT_ASSERT(m_event.tryWait(2000));
+
+	responder.join();
+	prober.wait();
+
+	::unlink(node.c_str());
+	::rmdir(dir);
+
+	CPPUNIT_ASSERT_EQUAL(1, m_detected.size());
+	CPPUNIT_ASSERT_EQUAL(node, m_detected[0]);
+	CPPUNIT_ASSERT(prober.cache().lookup("0658:0200:A1B2C3") == ZWaveProbeCache::ZWAVE);
+}
+
+}
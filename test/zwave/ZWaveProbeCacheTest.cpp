@@ -0,0 +1,95 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cppunit/BetterAssert.h"
+#include "hotplug/HotplugEvent.h"
+#include "zwave/ZWaveProbeCache.h"
+
+using namespace std;
+
+namespace BeeeOn {
+
+class ZWaveProbeCacheTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(ZWaveProbeCacheTest);
+	CPPUNIT_TEST(testIdentify);
+	CPPUNIT_TEST(testIdentifyWithoutSerial);
+	CPPUNIT_TEST(testLookup);
+	CPPUNIT_TEST(testEmptyIdentity);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testIdentify();
+	void testIdentifyWithoutSerial();
+	void testLookup();
+	void testEmptyIdentity();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ZWaveProbeCacheTest);
+
+void ZWaveProbeCacheTest::testIdentify()
+{
+	HotplugEvent event;
+	event.setSubsystem("tty");
+	event.setNode("/dev/ttyACM0");
+	event.properties()->setString("tty.ID_VENDOR_ID", "0658");
+	event.properties()->setString("tty.ID_MODEL_ID", "0200");
+	event.properties()->setString("tty.ID_SERIAL_SHORT", "A1B2C3");
+
+	CPPUNIT_ASSERT_EQUAL("0658:0200:A1B2C3", ZWaveProbeCache::identify(event));
+
+	HotplugEvent replugged;
+	replugged.setSubsystem("tty");
+	replugged.setNode("/dev/ttyACM1");
+	replugged.properties()->setString("tty.ID_VENDOR_ID", "0658");
+	replugged.properties()->setString("tty.ID_MODEL_ID", "0200");
+	replugged.properties()->setString("tty.ID_SERIAL_SHORT", "A1B2C3");
+
+	CPPUNIT_ASSERT_EQUAL(
+		ZWaveProbeCache::identify(event),
+		ZWaveProbeCache::identify(replugged));
+}
+
+/**
+ * Devices without serial numbers cannot be distinguished from
+ * each other and thus they are not identified.
+ */
+void ZWaveProbeCacheTest::testIdentifyWithoutSerial()
+{
+	HotplugEvent event;
+	event.setSubsystem("tty");
+	event.setNode("/dev/ttyUSB0");
+	event.properties()->setString("tty.ID_VENDOR_ID", "10c4");
+	event.properties()->setString("tty.ID_MODEL_ID", "ea60");
+	event.properties()->setString("tty.ID_SERIAL", "Silicon_Labs_CP2102");
+
+	CPPUNIT_ASSERT(ZWaveProbeCache::identify(event).empty());
+}
+
+void ZWaveProbeCacheTest::testLookup()
+{
+	ZWaveProbeCache cache;
+
+	CPPUNIT_ASSERT_EQUAL(0, cache.size());
+	CPPUNIT_ASSERT(cache.lookup("0658:0200:A1B2C3") == ZWaveProbeCache::UNKNOWN);
+
+	cache.store("0658:0200:A1B2C3", true);
+	cache.store("10c4:ea60:0001", false);
+
+	CPPUNIT_ASSERT_EQUAL(2, cache.size());
+	CPPUNIT_ASSERT(cache.lookup("0658:0200:A1B2C3") == ZWaveProbeCache::ZWAVE);
+	CPPUNIT_ASSERT(cache.lookup("10c4:ea60:0001") == ZWaveProbeCache::OTHER);
+	CPPUNIT_ASSERT(cache.lookup("10c4:ea60:0002") == ZWaveProbeCache::UNKNOWN);
+
+	cache.store("10c4:ea60:0001", true);
+	CPPUNIT_ASSERT_EQUAL(2, cache.size());
+	CPPUNIT_ASSERT(cache.lookup("10c4:ea60:0001") == ZWaveProbeCache::ZWAVE);
+}
+
+void ZWaveProbeCacheTest::testEmptyIdentity()
+{
+	ZWaveProbeCache cache;
+
+	cache.store("", true);
+	CPPUNIT_ASSERT_EQUAL(0, cache.size());
+	CPPUNIT_ASSERT(cache.lookup("") == ZWaveProbeCache::UNKNOWN);
+}
+
+}
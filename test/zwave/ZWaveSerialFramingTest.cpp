@@ -0,0 +1,92 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cppunit/BetterAssert.h"
+#include "zwave/ZWaveSerialFraming.h"
+
+using namespace std;
+
+namespace BeeeOn {
+
+class ZWaveSerialFramingTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(ZWaveSerialFramingTest);
+	CPPUNIT_TEST(testControlFrames);
+	CPPUNIT_TEST(testDataFrame);
+	CPPUNIT_TEST(testIncompleteDataFrame);
+	CPPUNIT_TEST(testGarbage);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void testControlFrames();
+	void testDataFrame();
+	void testIncompleteDataFrame();
+	void testGarbage();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ZWaveSerialFramingTest);
+
+void ZWaveSerialFramingTest::testControlFrames()
+{
+	ZWaveSerialFraming framing;
+	string buffer = "\x06\x15\x18";
+	string frame;
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("\x06", frame);
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("\x15", frame);
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("\x18", frame);
+	CPPUNIT_ASSERT(!framing.extract(buffer, frame));
+}
+
+void ZWaveSerialFramingTest::testDataFrame()
+{
+	ZWaveSerialFraming framing;
+	string buffer = {0x06, 0x01, 0x03, 0x00, 0x15, (char) 0xe9, 0x06};
+	string frame;
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("\x06", frame);
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL(5, frame.size());
+	CPPUNIT_ASSERT_EQUAL(string({0x01, 0x03, 0x00, 0x15, (char) 0xe9}), frame);
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("\x06", frame);
+	CPPUNIT_ASSERT(buffer.empty());
+}
+
+void ZWaveSerialFramingTest::testIncompleteDataFrame()
+{
+	ZWaveSerialFraming framing;
+	string buffer = {0x01};
+	string frame;
+
+	CPPUNIT_ASSERT(!framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL(1, buffer.size());
+
+	buffer += string({0x03, 0x00});
+	CPPUNIT_ASSERT(!framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL(3, buffer.size());
+
+	buffer += string({0x15, (char) 0xe9});
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL(5, frame.size());
+	CPPUNIT_ASSERT(buffer.empty());
+}
+
+void ZWaveSerialFramingTest::testGarbage()
+{
+	ZWaveSerialFraming framing;
+	string buffer = {(char) 0xff, 0x00, 0x42, 0x06, 0x33};
+	string frame;
+
+	CPPUNIT_ASSERT(framing.extract(buffer, frame));
+	CPPUNIT_ASSERT_EQUAL("\x06", frame);
+
+	CPPUNIT_ASSERT(!framing.extract(buffer, frame));
+	CPPUNIT_ASSERT(buffer.empty());
+	CPPUNIT_ASSERT_EQUAL(4, framing.dropped());
+}
+
+}
@@ -0,0 +1,98 @@
+#! /usr/bin/env python3
+
+"""
+Compile the Z-Wave part of types-mapping.xml into a C++ fragment
+with initializers of ZWaveTypeMappingEntry. The fragment is included
+by ZWaveTypeMappingTable.cpp and thus the gateway does not need to
+parse the XML file during startup.
+
+The same rules as of XmlTypeMappingParserHelper apply: the element
+<beeeon /> must be a child of <map /> placed in <z-wave-mapping />
+and its previous sibling must be the <z-wave /> element. The order
+of mappings is preserved.
+
+Usage: gateway-compile-types-mapping.py <types-mapping.xml> <output>
+"""
+
+import sys
+import xml.etree.ElementTree as ET
+
+MAPPING_GROUP = "z-wave-mapping"
+TECH_NODE = "z-wave"
+
+
+def parse_byte(value, name):
+	try:
+		number = int(value.strip(), 10)
+	except ValueError:
+		raise SystemExit("invalid %s: '%s'" % (name, value))
+
+	if number < 0 or number > 255:
+		raise SystemExit("%s out of range: %d" % (name, number))
+
+	return number
+
+
+def c_string(value):
+	return '"%s"' % value.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def compile_mapping(root):
+	entries = []
+
+	for group in root.iter(MAPPING_GROUP):
+		for mapping in group.findall("map"):
+			children = list(mapping)
+
+			for i, child in enumerate(children):
+				if child.tag != "beeeon" or i == 0:
+					continue
+
+				tech = children[i - 1]
+				if tech.tag != TECH_NODE:
+					continue
+
+				cc = tech.get("command-class")
+				if cc is None:
+					raise SystemExit("missing attribute command-class on element z-wave")
+
+				index = tech.get("index", "0")
+
+				beeeon = child.get("type")
+				if beeeon is None:
+					raise SystemExit("missing attribute type on element beeeon")
+
+				entries.append((
+					parse_byte(cc, "command-class"),
+					parse_byte(index, "index"),
+					beeeon.strip(),
+					" ".join(mapping.get("comment", "").split()).rstrip("\\")))
+
+	return entries
+
+
+def main(argv):
+	if len(argv) != 3:
+		sys.stderr.write(__doc__)
+		return 1
+
+	entries = compile_mapping(ET.parse(argv[1]).getroot())
+
+	with open(argv[2], "w") as out:
+		out.write("/*\n")
+		out.write(" * Generated from types-mapping.xml, DO NOT EDIT.\n")
+		out.write(" */\n")
+
+		for cc, index, beeeon, comment in entries:
+			line = "{%d, %d, %s}," % (cc, index, c_string(beeeon))
+
+			if comment:
+				line += " // " + comment
+
+			out.write(line + "\n")
+
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main(sys.argv))